@@ -0,0 +1,19 @@
+#ifndef BACKOFF_H
+#define BACKOFF_H
+
+#include <stdint.h>
+#include "hal.h"
+
+// ==================== 带抖动的指数退避 ====================
+// 上限从 minMs 起每次失败翻倍、不超过 maxMs，实际等待在 [上限/2, 上限] 内均匀分布，
+// 避免同一网络中的多台设备在 AP/服务器恢复时同时重连。
+
+inline uint32_t jitteredBackoff(uint32_t minMs, uint32_t maxMs, uint8_t failures) {
+  uint32_t ceiling = maxMs;
+  if (failures < 16 && (minMs << failures) < maxMs) {
+    ceiling = minMs << failures;
+  }
+  return ceiling / 2 + halRandom() % (ceiling / 2 + 1);
+}
+
+#endif // BACKOFF_H
@@ -0,0 +1,65 @@
+#ifndef BALL_H
+#define BALL_H
+
+#include "hal.h"
+#include "config.h"
+#include "tasks.h"
+#include "effects.h"
+
+// ==================== 全局状态（定义于 main.cpp，leds[] 见 led_compositor.h） ====================
+extern ButtonInput buttonInput;
+extern LEDController ledController;
+extern SystemStatus systemStatus;
+
+// ==================== 调度作业 ====================
+// 渲染/网络任务各自的作业表，下标见 tasks.h 的 RenderJob / NetworkJob。
+// 单核构建（mainLoop）在同一线程里依次运行两张表。
+extern const JobSpec RENDER_JOBS[NUM_RENDER_JOBS];
+extern const JobSpec NETWORK_JOBS[NUM_NETWORK_JOBS];
+
+// ==================== 启动耗时 ====================
+// 各里程碑第一次达到时的 halMicros()，尚未达到为 BOOT_MILESTONE_PENDING
+#define BOOT_MILESTONE_PENDING UINT32_MAX
+
+struct BootTimings {
+  uint32_t firstInputMicros;     // 第一次按钮扫描
+  uint32_t firstFrameMicros;     // 第一帧灯效
+  uint32_t wifiConnectedMicros;
+  uint32_t mqttReadyMicros;      // MQTT 连接并订阅完成
+};
+
+extern BootTimings bootTimings;
+void markBootMilestone(uint32_t& milestone);
+void printBootTimings();
+
+// ==================== 函数声明 ====================
+void initializeSystem();
+void initializeButtons();
+void initializeLED();
+void initializeWiFi();
+void initializeMQTT();
+void initializeWebServer();
+
+void mainLoop();
+void updateInput();
+void updateWiFi();
+void updateButtonStates();
+void updateLEDController();
+void printButtonStatus();
+void updateMQTTClient();
+void updateMQTTConnection();
+void updateWebSocket();
+void updateWebSocketClients();
+
+void handleButtonLogic();
+void handleRemoteCommands();
+void setLEDMode(LEDMode mode);
+const Effect& currentEffect();  // LED 作业渲染的灯效：当前模式的，或 MQTT 命令设置的
+
+void sendButtonStates();
+bool webSocketUpdatePending();
+void sendMQTTEvent(uint8_t event);  // MQTTEvent
+void publishMetrics();
+void updateLog();
+
+#endif // BALL_H
@@ -0,0 +1,43 @@
+#ifndef BUTTON_EVENTS_H
+#define BUTTON_EVENTS_H
+
+#include <stdint.h>
+
+// ==================== 按钮边沿事件队列 ====================
+// BUTTON_PINS[] 上的每个电平变化由 GPIO 中断写入单生产者/单消费者环形缓冲区，
+// 带微秒时间戳；主循环中的 updateButtonStates() 是唯一的消费者。
+// 生产者：GPIO 中断（ESP32 上所有引脚中断由同一个 ISR 串行分发）
+// 消费者：主循环
+
+#define BUTTON_EVENT_QUEUE_SIZE 64  // 必须是2的幂
+
+struct ButtonEvent {
+  uint32_t timestampMicros;
+  uint8_t index;  // BUTTON_PINS[] 下标
+  uint8_t level;
+};
+
+struct ButtonEventStats {
+  uint32_t captured;   // 成功入队的边沿数
+  uint32_t dropped;    // 队列满而丢弃的边沿数
+  uint32_t overflows;  // 发生溢出后重新采样电平的次数
+  uint32_t resyncs;    // 浅睡眠醒来后重新同步的次数
+  uint16_t maxDepth;   // 消费时观察到的最大队列深度
+};
+
+// 每个边沿入队后通过 halNotifyTaskFromISR(notifyTask) 唤醒消费者
+void initializeButtonEvents(uint8_t notifyTask);
+bool hasPendingButtonEvents();
+bool popButtonEvent(ButtonEvent& event);
+// 中断关闭期间（浅睡眠，见 power.h）错过的边沿：要求消费者按输入寄存器重新同步一次
+void requestButtonResync();
+// 队列溢出或 requestButtonResync() 之后返回一次 true，消费者据此以输入寄存器为准
+bool takeButtonEventResync();
+const ButtonEventStats& buttonEventStats();
+
+// 一次读取GPIO输入寄存器，返回当前按下的按钮掩码（bit i 对应 BUTTON_PINS[i]）
+uint32_t sampleButtonMask();
+// 从输入寄存器的值（高电平 = 1）取出按下的按钮掩码
+uint32_t pressedMaskFromLevels(uint64_t levels);
+
+#endif // BUTTON_EVENTS_H
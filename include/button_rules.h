@@ -0,0 +1,87 @@
+#ifndef BUTTON_RULES_H
+#define BUTTON_RULES_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "config.h"
+
+// ==================== 按钮规则表 ====================
+// 按钮组合 → 灯效/MQTT 动作用声明式规则描述，编译成以消抖后按钮掩码为下标的查找表：
+//   - 每条规则：匹配条件（anyOf 任一按下 / allOf 全部按下）、优先级、LED 模式、亮度、进入时的 MQTT 动作
+//   - 每个掩码取匹配规则中优先级最高的一条（同优先级取靠前的），结果存为 RuleOutcome
+//   - 亮度 = base + step * popcount(按下的按钮 & countMask)，或保持当前亮度
+//   - 规则的动作在从另一条规则切换到它时触发一次；单个按钮按下/松开的动作另有边沿动作表
+// 运行时判断只有一次查表。按钮数超过 RULE_TABLE_MAX_BUTTONS 时表太大，编译期改为每次按优先级逐条比较
+// （最多 RULE_MAX 条），结果相同。规则可以从 LittleFS 的 RULES_FILE_PATH 或 MQTT 的 MQTT_TOPIC_RULES 重新加载，
+// 格式见 data/rules.json。
+
+#define RULE_TABLE_MAX_BUTTONS 8
+#define RULE_TABLE_LOOKUP (BTN_COUNT <= RULE_TABLE_MAX_BUTTONS)
+#define RULE_TABLE_SIZE (RULE_TABLE_LOOKUP ? (1u << BTN_COUNT) : 1u)
+#define RULE_MAX 8
+#define RULE_NAME_LENGTH 16
+#define RULE_NO_ACTION 0xFF  // MQTTEvent 之外的值表示不发布
+#define RULE_NONE 0xFF       // 尚未进入任何规则
+#define RULES_FILE_PATH "/rules.json"
+#define RULES_JSON_CAPACITY 2048
+
+struct ButtonRule {
+  char name[RULE_NAME_LENGTH];
+  uint32_t anyOf;       // 0 表示不要求
+  uint32_t allOf;
+  uint32_t countMask;   // 亮度按其中按下的按钮数计算
+  uint8_t priority;
+  uint8_t ledMode;      // LEDMode
+  uint8_t brightnessBase;
+  uint8_t brightnessStep;
+  bool keepBrightness;
+  uint8_t action;       // 进入规则时发布的 MQTTEvent
+};
+
+struct EdgeAction {
+  uint8_t onPress;      // MQTTEvent 或 RULE_NO_ACTION
+  uint8_t onRelease;
+};
+
+struct RuleOutcome {
+  uint8_t rule;         // 规则下标，RULE_NONE 表示没有规则匹配（保持现状）
+  uint8_t ledMode;
+  uint8_t brightness;
+  uint8_t keepBrightness;
+};
+
+struct RuleSet {
+  RuleOutcome table[RULE_TABLE_SIZE];  // 不查表时只有一项
+  ButtonRule rules[RULE_MAX];
+  EdgeAction edges[BTN_COUNT];
+  uint8_t ruleCount;
+};
+
+// 编译规则和边沿动作；规则数超过 RULE_MAX 时返回 false
+bool compileRules(RuleSet& out, const ButtonRule* rules, uint8_t count, const EdgeAction* edges);
+// 按下 pressed 时优先级最高的规则及其结果（编译查找表时逐项调用）
+RuleOutcome evaluateRules(const ButtonRule* rules, uint8_t count, uint32_t pressed);
+
+inline RuleOutcome ruleOutcome(const RuleSet& set, uint32_t pressed) {
+  if constexpr (RULE_TABLE_LOOKUP) {
+    return set.table[pressed];
+  } else {
+    return evaluateRules(set.rules, set.ruleCount, pressed);
+  }
+}
+void compileDefaultRules(RuleSet& out);
+
+// 解析 JSON 并编译，失败时 out 内容未定义，error 写出原因
+bool parseRulesJSON(RuleSet& out, const char* text, size_t length, char* error, size_t errorCapacity);
+
+// ==================== 运行时 ====================
+// 渲染任务持有当前规则表；其他任务提交的新规则先编译到暂存区，
+// 渲染任务在下一次判断前通过 takePendingRules() 取用（暂存区被取走前拒绝新的提交）。
+void initializeButtonRules();                 // 默认规则，RULES_FILE_PATH 存在时以文件为准
+const RuleSet& activeRules();
+bool submitRulesJSON(const char* text, size_t length, bool persist);  // 非渲染任务
+bool reloadRulesFile();                                               // 非渲染任务
+bool rulesPending();
+bool takePendingRules();                                              // 渲染任务
+
+#endif // BUTTON_RULES_H
@@ -0,0 +1,134 @@
+#ifndef CLIPS_H
+#define CLIPS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "hal.h"
+#include "config.h"
+#include "effects.h"
+#include "text_writer.h"
+
+// ==================== 动画片段 ====================
+// 比呼吸、追光更复杂的画面离线算好，存成固定帧率的压缩帧序列（主机工具 program --clip-build 生成），
+// 放在 flash 的 CLIP_PARTITION_LABEL 数据分区里。播放时经 halPartitionMap() 直接读映射的 flash，
+// 逐帧解码到 leds[]，片段数据不复制到 RAM。规则或 MQTT 命令用模式名 "clip:<片段名>" 选择片段。
+//
+// 分区内容（小端，偏移相对分区开头，4 字节对齐）：
+//   头部 16 字节：魔数 "BCLP"、版本、片段数、保留 2 字节、总长度、CRC-32（头部之后直到总长度的所有字节）
+//   目录：每个片段 32 字节的 ClipEntry（名称、帧数据偏移和长度、帧数、像素数、帧率、标志）
+//   帧数据：每帧 [类型 1 字节][载荷长度 2 字节][载荷]
+//     CLIP_FRAME_RLE    整帧：若干 (游程长度-1, r, g, b)，恰好覆盖全部像素
+//     CLIP_FRAME_DELTA  相对上一帧：若干 (跳过的像素数, 字面像素数 n, n × rgb)，其余像素不变；载荷为空表示与上一帧相同
+//     CLIP_FRAME_RAW    整帧：像素数 × rgb
+//   第一帧必须是整帧。编码器逐帧选最短的一种。
+//
+// 上传（POST /api/clips）：上传回调只把头部收在 RAM 里，其余字节经扇区环形缓冲区（sector_ring.h，与固件更新共用）
+// 交给 flash 写入任务（TASK_OTA），回调里不擦写 flash。写入任务先擦除第一个扇区（旧头部），进入新扇区时先擦除它，
+// 全部写完、长度和 CRC 都对上后最后写头部。写到一半断电或校验失败时分区没有有效头部，按空处理，不会播放半个包。
+// 写入期间读者（渲染任务的播放器、目录查询）不访问映射：状态切到 WRITING 后写入任务等现有读者退出再擦除。
+//
+// 播放按“模式开始后经过的毫秒数 × 帧率”选帧，与灯效一样只取决于时间；DELTA 帧依赖上一帧，
+// 目标帧在已解码帧之后时顺序解码中间的帧，回到开头（循环）时从第一帧重新解码。
+// 片段不受亮度（按钮亮度、MQTT brightness）影响，颜色按原样输出，全局亮度由合成器统一施加。
+// 像素数与灯带不同时：多出的像素丢弃，不足的部分保持黑色。
+
+#define CLIP_PARTITION_LABEL "clips"
+#define CLIP_FORMAT_VERSION 1
+#define CLIP_MAX 16               // 目录项数上限
+#define CLIP_NAME_LENGTH 16       // 含 '\0'
+#define CLIP_MODE_PREFIX "clip:"  // 模式名前缀，CLIP_MODE_MAX 见 config.h
+#define CLIP_MAX_FPS 60
+#define CLIP_FLAG_LOOP 0x01       // 否则停在最后一帧
+
+enum ClipFrameType : uint8_t {
+  CLIP_FRAME_RLE,
+  CLIP_FRAME_DELTA,
+  CLIP_FRAME_RAW,
+  NUM_CLIP_FRAME_TYPES
+};
+
+#define CLIP_FRAME_HEADER_SIZE 3
+
+struct ClipBundleHeader {
+  char magic[4];      // "BCLP"
+  uint8_t version;
+  uint8_t count;
+  uint16_t reserved;
+  uint32_t length;    // 含头部和目录
+  uint32_t crc;
+};
+
+struct ClipEntry {
+  char name[CLIP_NAME_LENGTH];
+  uint32_t offset;    // 第一帧
+  uint32_t length;    // 全部帧的字节数
+  uint16_t frames;
+  uint16_t pixels;
+  uint8_t fps;
+  uint8_t flags;      // CLIP_FLAG_*
+  uint16_t reserved;
+};
+
+static_assert(sizeof(ClipBundleHeader) == 16 && sizeof(ClipEntry) == 32, "片段格式布局");
+static_assert(sizeof(CRGB) == 3, "帧数据按 rgb 字节直接复制到 CRGB");
+
+enum ClipStoreState : uint8_t {
+  CLIP_STORE_EMPTY,    // 没有分区或没有有效的包
+  CLIP_STORE_READY,
+  CLIP_STORE_WRITING   // 正在上传
+};
+
+struct ClipStats {
+  uint32_t framesDecoded;
+  uint32_t framesSkipped;   // 追赶时解码但没有显示的帧
+  uint32_t restarts;        // 从第一帧重新解码（循环回到开头、模式切换、包被替换）
+  uint32_t errors;          // 帧数据损坏，停止播放
+  uint32_t uploads;         // 成功的上传
+  uint32_t rejected;        // 长度或 CRC 不符、目录无效、缓冲区被占用、中途断开的上传
+};
+
+// CRC-32（IEEE，与 zlib 相同）；crc 初值为 0
+uint32_t clipCRC32(uint32_t crc, const uint8_t* data, size_t length);
+
+// 解码一帧到 out：frame 指向帧头，available 为帧头之后可读的字节数（不越过片段末尾）。
+// 只写 out[0..min(pixels, count))，DELTA 帧要求 out 保持上一帧的内容。成功时返回这一帧占用的字节数，数据无效时返回 0
+size_t decodeClipFrame(const uint8_t* frame, size_t available, uint16_t pixels, CRGB* out, uint16_t count);
+
+// 校验映射中的包（头部、目录、每个片段的范围和第一帧类型；verifyCRC 时另算 CRC），返回有效的目录
+const ClipEntry* validateClipBundle(const uint8_t* data, size_t size, bool verifyCRC, uint8_t& count);
+
+// ==================== 存储 ====================
+void initializeClips();  // 映射分区并校验（含 CRC）
+ClipStoreState clipStoreState();
+ClipStats clipStats();
+void encodeClipsJSON(TextWriter& out);  // GET /api/clips：状态和目录
+
+// 上传（Web 服务器的上传回调，同一时刻只有一个上传）：begin 时给出总长度，write 按顺序给出全部字节。
+// 固件更新或另一个上传占用缓冲区时 begin 返回 false
+bool clipUploadBegin(size_t length);
+bool clipUploadWrite(const uint8_t* data, size_t length);
+bool clipUploadEnd();    // 长度对上后交给写入任务收尾：CRC 和目录通过后写头部，新包立即生效
+void clipUploadAbort();  // 连接断开等：已开始擦写时分区按空处理；已收完的上传不受影响
+const char* clipUploadError();  // 最近一次上传的失败原因，没有失败（或写入任务还在写）时为 nullptr
+
+// 写入任务（TASK_OTA）：缓冲区属于片段上传时写完已交出的块；等读者退出时返回重试的微秒数，否则 UINT32_MAX
+uint32_t runClipWriter();
+
+// ==================== 模式名（规则解析、MQTT 命令） ====================
+// "clip:<片段名>" 登记到 CLIP_MODE_MAX 项的名称表，对应 LED_CLIP_FIRST + 下标；片段名在播放时才在包里查找，
+// 规则可以先于片段上传。登记过的名字不会移除，表满时返回 false。
+bool findClipMode(const char* name, uint8_t& mode);
+const char* clipModeName(uint8_t mode);  // "clip:<片段名>"，未登记为 "?"
+bool clipModeRegistered(uint8_t mode);
+inline bool isClipMode(uint8_t mode) { return mode >= LED_CLIP_FIRST && mode < LED_CLIP_FIRST + CLIP_MODE_MAX; }
+
+// ==================== 播放（渲染任务） ====================
+// 片段模式的灯效：kind 为 EFFECT_CLIP，帧周期取片段的帧率（片段不存在时为 EFFECT_FRAME_INTERVAL）
+const Effect& clipModeEffect(uint8_t mode);
+// 渲染 elapsedMillis 时刻的一帧；片段不存在或数据损坏时输出黑色。返回 false 表示帧周期变了（包被替换），
+// 调用方按 clipModeEffect() 重新设置 LED 作业周期
+bool renderClipFrame(uint8_t mode, CRGB* out, uint16_t count, uint32_t elapsedMillis);
+// 其他灯效渲染过 out 之后调用：out 不再是片段的上一帧，下一次从第一帧重新解码
+void stopClipPlayback();
+
+#endif // CLIPS_H
@@ -1,19 +1,51 @@
 #ifndef CONFIG_H
 #define CONFIG_H
 
+#ifdef ARDUINO
 #include <Arduino.h>
+#else
+#include "native_shim.h"
+#endif
 #include <stdint.h>
+#include "debouncer.h"
 
 // ==================== 硬件配置 ====================
 #define LED_PIN 23
-#define NUM_LEDS 144
+#define NUM_LEDS 144        // 默认布局（无 /leds.json 时）的像素数，运行时长度见 led_compositor.h 的 ledCount
+#define LED_MAX_PIXELS 4096  // 布局的逻辑像素数和单个通道的像素数上限
+#define LED_MAX_SEGMENTS 16
 #define LED_BRIGHTNESS 50
 #define LED_TYPE WS2815
 #define COLOR_ORDER RGB
 
-// 按钮引脚定义
-extern const uint8_t BUTTON_PINS[];
-extern const uint8_t NUM_BUTTONS;
+// 按钮引脚：编译期列表，下标 i（掩码的 bit i）对应第 i 个引脚。
+// 输入数不同的球用同一份代码构建，只需 -DBUTTON_PIN_LIST=...（见 platformio.ini 的 native_4 / native_16）
+#ifndef BUTTON_PIN_LIST
+#define BUTTON_PIN_LIST 13, 12, 14, 27, 26, 25, 32
+#endif
+#define BUTTON_MAX_COUNT 16  // 按钮掩码、输入录制格式和 WebSocket 状态帧支持的上限
+
+constexpr uint8_t BUTTON_PINS[] = {BUTTON_PIN_LIST};
+constexpr uint8_t BTN_COUNT = sizeof(BUTTON_PINS);
+
+// 引脚在 BUTTON_PINS 中的下标，不是按钮引脚时为 BTN_COUNT
+constexpr uint8_t buttonIndexOfPin(uint32_t pin) {
+  for (uint8_t i = 0; i < BTN_COUNT; i++) {
+    if (BUTTON_PINS[i] == pin) return i;
+  }
+  return BTN_COUNT;
+}
+
+// ESP32 的 GPIO 0-39，且没有重复
+constexpr bool buttonPinsValid() {
+  for (uint8_t i = 0; i < BTN_COUNT; i++) {
+    if (BUTTON_PINS[i] >= 40 || buttonIndexOfPin(BUTTON_PINS[i]) != i) return false;
+  }
+  return true;
+}
+
+static_assert(BTN_COUNT >= 3 && BTN_COUNT <= BUTTON_MAX_COUNT, "默认规则需要故障、重置和至少一个绿色按钮");
+static_assert(buttonPinsValid(), "BUTTON_PIN_LIST 中有重复或不存在的 GPIO");
 
 // ==================== 颜色配置 ====================
 // RGB颜色定义 (R, G, B范围: 0-255)
@@ -31,10 +63,37 @@ extern const uint8_t NUM_BUTTONS;
 
 // ==================== 时间配置 ====================
 #define DEBOUNCE_DELAY 50
-#define WEBSOCKET_UPDATE_INTERVAL 100
+#define DEBOUNCE_SAMPLE_INTERVAL_US (DEBOUNCE_DELAY * 1000UL / DEBOUNCER_SAMPLES)  // 消抖器采样周期
+#define WEBSOCKET_UPDATE_INTERVAL 100     // JSON 模式的广播周期
+#define WEBSOCKET_KEYFRAME_INTERVAL 5000  // 二进制模式无变化时的关键帧周期
 #define BLINK_INTERVAL 500
-#define BREATHE_INTERVAL 30
-#define BREATHE_STEP 5
+#define BREATHE_INTERVAL 30      // 呼吸/进度条的帧周期
+#define BREATHE_PERIOD 3060      // 一次呼吸（暗 → 亮 → 暗）的时长
+#define CHASE_PERIOD 2000        // 光点跑完一圈的时长
+#define GRADIENT_PERIOD 4000     // 渐变滚动一圈的时长
+#define EFFECT_FRAME_INTERVAL 16 // 光点/渐变的帧周期（60 fps 以上）
+#define CLIP_MODE_MAX 8          // 规则和 MQTT 命令中可以引用的不同动画片段名数
+#define LED_RENDER_BUDGET_US 3000 // 每 1000 个像素的单帧渲染时间预算，见 effects.h
+#define LED_MIN_REFRESH_INTERVAL 1000  // 帧未变化时的最小刷新间隔，防止灯带上的干扰长期残留
+#define STATUS_PRINT_INTERVAL 1000
+#define INPUT_IDLE_POLL_INTERVAL 100     // 无按钮事件时核对输入寄存器的周期，兜底丢失的中断
+#define MQTT_LOOP_INTERVAL 10
+#define MQTT_CHECK_INTERVAL 1000
+#define MQTT_CONNECT_TIMEOUT 5000          // TCP 连接和等待 CONNACK 各自的上限
+#define MQTT_CONNECT_POLL_INTERVAL 100     // 连接中的兜底检查周期（正常由连接完成事件唤醒）
+#define MQTT_BACKOFF_MIN 1000
+#define MQTT_BACKOFF_MAX 60000
+#define WIFI_CONNECT_TIMEOUT 10000         // 全扫描 + DHCP
+#define WIFI_FAST_CONNECT_TIMEOUT 3000     // 缓存直连，超时后改为全扫描
+#define WIFI_BACKOFF_MIN 500               // 重连退避上限从这里开始翻倍
+#define WIFI_BACKOFF_MAX 30000
+#define WIFI_CONNECTING_POLL_INTERVAL 100  // 连接中的兜底检查周期（正常由 WiFi 事件唤醒）
+#define WIFI_CHECK_INTERVAL 1000
+
+// 作业允许的迟到时间（微秒），超过计为一次截止时间错过
+#define INPUT_JOB_TOLERANCE_US 2000
+#define LED_JOB_TOLERANCE_US 5000
+#define NETWORK_JOB_TOLERANCE_US 20000
 
 // ==================== 网络配置 ====================
 extern const char* WIFI_SSID;
@@ -47,54 +106,137 @@ extern const char* MQTT_PASSWORD;
 extern const char* MQTT_TOPIC_SUB;
 extern const char* MQTT_TOPIC_RESET;
 extern const char* MQTT_TOPIC_FIRST_TRIGGERED;
+extern const char* MQTT_TOPIC_RULES;    // 载荷为规则 JSON 时替换并保存规则，空载荷时重新加载规则文件
+extern const char* MQTT_TOPIC_METRICS;  // 各阶段延迟摘要发布到 <MQTT_TOPIC_METRICS>/<指标名>
+extern const char* MQTT_TOPIC_TRACE;    // 载荷 "start" / "stop"：开始/停止录制按钮输入，见 input_trace.h
+extern const char* MQTT_DEVICE_ID;      // 命令主题 ball/<MQTT_DEVICE_ID>/cmd/...，见 mqtt_commands.h
+extern const char* SYSLOG_SERVER;       // syslog 服务器 IP，为空时不发送
 
 #define WEB_SERVER_PORT 80
+#define MQTT_OUTBOX_SIZE 16  // 渲染任务 → 网络任务的待发消息队列，必须是2的幂
+#define MQTT_BUFFER_SIZE 2048  // 收发缓冲区，需放得下规则 JSON（见 button_rules.h）
+#define MQTT_OUTBOX_CAPACITY 32  // 网络任务侧待发事件环形缓冲区，断线期间保留，必须是2的幂
+#define MQTT_OUTBOX_BATCH 8      // 每次 MQTT 客户端作业最多发布的条数
+#define MQTT_OUTBOX_RETAIN 1     // 1：待发事件放在保留内存中，软件复位后继续重放
+#ifndef WS_MAX_CLIENTS
+#define WS_MAX_CLIENTS 8         // WebSocket 客户端上限（与 AsyncWebSocket 默认值一致），超出的连接被关闭
+#endif
+#define WS_CLIENT_QUEUE_CAP 4    // 每个客户端尚未交给传输层的帧数上限，见 ws_fanout.h
+#define WS_CLIENT_EVICT_MS 5000  // 发送队列持续非空超过该时长的客户端被断开
+#define WS_BACKLOG_INTERVAL 20   // 有客户端积压时 WebSocket 作业的重试周期
+
+// ==================== 延迟追踪 ====================
+#ifndef METRICS_ENABLED
+#define METRICS_ENABLED 1  // 0：编译掉所有追踪点
+#endif
+#define METRICS_PUBLISH_INTERVAL 60000  // 通过 MQTT 发布延迟摘要的周期
+
+// ==================== 日志 ====================
+// 级别越小越严重；低于 LOG_LEVEL 的 LOG_xxx() 调用在编译期去掉，见 log.h
+#define LOG_LEVEL_ERROR 1
+#define LOG_LEVEL_WARN 2
+#define LOG_LEVEL_INFO 3
+#define LOG_LEVEL_DEBUG 4
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_LEVEL_INFO
+#endif
+#define LOG_REMOTE_LEVEL LOG_LEVEL_INFO  // WebSocket 日志视图和 syslog 只发送该级别及以上
+#define LOG_RING_SIZE 64                 // 待输出记录的环形缓冲区，必须是2的幂
+#define LOG_RATE_WINDOW 1000             // 限流窗口（毫秒）
+#define LOG_RATE_LIMIT 10                // 每个事件每个窗口最多记录的条数
+#define LOG_DRAIN_INTERVAL 50            // 日志作业的周期；缓冲区过半时由写入方提前唤醒
+#define LOG_DRAIN_BATCH 16               // 日志作业每次最多输出的条数
+#define LOG_BACKLOG_INTERVAL 5           // 输出一批后缓冲区仍有记录（或串口已满）时的作业周期
+#define LOG_SERIAL_TX_BUFFER 1024        // 串口发送缓冲区，日志作业只写入放得下的行
+#define SYSLOG_PORT 514
+
+// ==================== 输入录制 ====================
+#define INPUT_TRACE_FLUSH_INTERVAL 1000  // 录制写文件作业的兜底周期；缓冲区写满时由渲染任务立即唤醒
+
+// ==================== 固件更新 ====================
+// 见 ota.h。清单签名的 Ed25519 公钥在构建时给出：-DOTA_PUBLIC_KEY=0x..,0x..,...（32 个字节，
+// program --ota-keygen 生成密钥对并打印这一行）；私钥留在签名的电脑上。没有给出时设备拒绝所有更新。
+#define OTA_BUFFER_COUNT 4              // 扇区缓冲区个数（每个 HAL_FLASH_SECTOR_SIZE），必须是2的幂
+#define OTA_STALL_TIMEOUT 1000          // 缓冲区全满时接收方等待写入任务的上限（毫秒），超过则放弃更新
+#define OTA_PROGRESS_INTERVAL 250       // 更新进行中 WebSocket 进度帧的周期；开始、结束时立即发送
+#define OTA_PROGRESS_IDLE_INTERVAL 60000  // 没有更新时进度作业的兜底周期
+#define OTA_REBOOT_DELAY 1000           // 切换启动分区后等 HTTP 响应和进度帧发出再重启
+
+// ==================== 低功耗 ====================
+// 见 power.h；电池供电的球在 build_flags 中加 -DPOWER_SAVE_ENABLED=1
+#ifndef POWER_SAVE_ENABLED
+#define POWER_SAVE_ENABLED 0
+#endif
+#define POWER_IDLE_AFTER 10000              // 按钮无变化多久后进入空闲（毫秒）
+#define POWER_IDLE_FRAME_INTERVAL 100       // 空闲时 LED 作业的最短帧周期（10 fps）
+#define POWER_IDLE_INPUT_POLL_INTERVAL 1000 // 空闲时输入兜底轮询的周期，按钮变化由 GPIO 唤醒
+#define POWER_IDLE_MQTT_INTERVAL 250        // 空闲时 MQTT 客户端作业（收包、保活）的周期
+#define POWER_IDLE_LOG_INTERVAL 1000        // 空闲时日志作业的周期，缓冲区过半时仍立即唤醒
+#define POWER_MAX_SLEEP 250                 // 单次浅睡眠上限（毫秒），醒来重新核对网络和输入状态
+#define POWER_MIN_SLEEP_US 2000             // 离下一个截止时间更近时只等待，不值得进出浅睡眠
+#define POWER_WAKE_MARGIN_US 500            // 提前醒来，抵消退出浅睡眠（恢复时钟和闪存）的时间
+#define POWER_STATS_PUBLISH_INTERVAL 1000   // 决策计数不变时统计快照的最长发布间隔（毫秒）
+
+// ==================== 任务配置 ====================
+#define RENDER_TASK_STACK 4096
+#define RENDER_TASK_PRIORITY 3
+#define RENDER_TASK_CORE 1
+#define NETWORK_TASK_STACK 8192
+#define NETWORK_TASK_PRIORITY 2
+#define NETWORK_TASK_CORE 0
+#define OTA_TASK_STACK 6144  // Ed25519 验证约 3 KB
+#define OTA_TASK_PRIORITY 1   // 低于渲染任务：flash 擦写不推迟 LED 帧
+#define OTA_TASK_CORE 1       // 与网络任务错开，擦写等待期间网络任务照常收发
 
 // ==================== 枚举定义 ====================
 enum LEDMode {
   LED_OFF,
   LED_BREATHE_RED,
   LED_BREATHE_GREEN,
-  LED_FLASH_YELLOW
+  LED_FLASH_YELLOW,
+  LED_PROGRESS_GREEN,  // 按绿色按钮按下数量填充的进度条
+  LED_CHASE_YELLOW,
+  LED_GRADIENT,        // 红绿渐变滚动
+  NUM_LED_MODES,
+  // 动画片段（clips.h）：LED_CLIP_FIRST + k 播放名称表中第 k 个 "clip:<片段名>"
+  LED_CLIP_FIRST = NUM_LED_MODES,
+  LED_CLIP_LAST = LED_CLIP_FIRST + CLIP_MODE_MAX - 1
 };
 
-enum ButtonIndex {
-  BTN_P13 = 0,
-  BTN_P12 = 1,
-  BTN_P14 = 2,
-  BTN_P27 = 3,
-  BTN_P26 = 4,
-  BTN_P25 = 5,
-  BTN_P32 = 6
-};
+// 按钮掩码：bit i 对应 BUTTON_PINS[i]，1 = 按下
+#define BUTTON_MASK(index) (1UL << (index))
+#define ALL_BUTTONS_MASK (BUTTON_MASK(BTN_COUNT) - 1)
+
+// 默认规则里按钮的角色按位置确定（默认引脚依次为 P13、P12 P14 P27 P26 P25、P32）：
+// 第一个是故障按钮，最后一个是重置按钮，中间的是绿色组
+#define FAULT_BUTTON 0
+#define RESET_BUTTON (BTN_COUNT - 1)
+#define GREEN_BUTTONS_MASK (ALL_BUTTONS_MASK & ~BUTTON_MASK(FAULT_BUTTON) & ~BUTTON_MASK(RESET_BUTTON))
+#define GREEN_BRIGHTNESS_STEP (255 / __builtin_popcount(GREEN_BUTTONS_MASK))  // 绿色组全部按下时亮度满
+#define FIRST_TRIGGER_BUTTONS_MASK (ALL_BUTTONS_MASK & ~BUTTON_MASK(RESET_BUTTON))  // 重置按钮以外的按钮
 
 // ==================== 数据结构 ====================
-struct ButtonState {
-  bool current;
-  bool previous;
-  unsigned long lastDebounceTime;
-  bool stateChanged;
+struct ButtonInput {
+  uint32_t pressed;        // 消抖后按下的按钮
+  uint32_t raw;            // 由边沿事件重建的原始状态
+  uint32_t pressedEdges;   // 本次更新中新按下的按钮
+  uint32_t releasedEdges;  // 本次更新中新松开的按钮
+  uint32_t edgeMicros;     // 本次确认的变化中最早的原始边沿时刻（中断时间戳）
 };
 
 // ==================== 数据结构 ====================
 struct LEDController {
   LEDMode mode;
-  unsigned long lastUpdateTime;
-  bool blinkState;
-  int breathState;
-  int breathDirection;
-  int greenBreathBrightness;  // 绿色呼吸的亮度级别 (0-255)
+  uint32_t modeStartMillis;   // 进入当前模式的时刻，动画相位由此计算
+  int greenBreathBrightness;  // 绿色呼吸的亮度级别 / 进度条填充比例 (0-255)
+  bool remote;                // 灯效由 MQTT 命令接管，按钮状态变化或 reset 命令后交还按钮规则
 };
 
 struct SystemStatus {
   bool wifiConnected;
   bool mqttConnected;
-  bool allPinsTriggered;
-  bool previousAllPinsTriggered;
-  bool previousP32Triggered;
-  bool p32Triggered;  // P32是否被触发过，触发后保持红色呼吸直到系统重置
-  bool firstTriggeredSent;  // 是否已发送过首次触发消息
-  bool initialButtonStates[6];  // 存储非P32引脚的初始状态
+  uint8_t activeRule;         // 当前生效的按钮规则（见 button_rules.h），RULE_NONE 表示尚未判断
+  uint32_t evaluatedPressed;  // 上一次规则判断时的按钮掩码，用于边沿动作
 };
 
 #endif // CONFIG_H
\ No newline at end of file
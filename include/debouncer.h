@@ -0,0 +1,42 @@
+#ifndef DEBOUNCER_H
+#define DEBOUNCER_H
+
+#include <stdint.h>
+
+// ==================== 按位并行消抖器 ====================
+// 每个 bit 是一路输入（1 = 按下），每路一个 2 位纵向计数器（cnt0/cnt1 各占一个 bit）。
+// 输入与消抖状态连续 DEBOUNCER_SAMPLES 次采样不同才翻转，期间任意一次相同则计数复位。
+// 32 路输入与 1 路输入的开销相同：每次采样只有几条按位运算，没有分支和逐引脚循环。
+// 不依赖硬件，可以在主机上直接用录制的抖动波形驱动。
+
+#define DEBOUNCER_SAMPLES 4
+
+struct Debouncer {
+  uint32_t state;     // 消抖后的状态
+  uint32_t cnt0;      // 纵向计数器低位
+  uint32_t cnt1;      // 纵向计数器高位
+  uint32_t pressed;   // 最近一次 sample() 中由 0 变 1 的输入
+  uint32_t released;  // 最近一次 sample() 中由 1 变 0 的输入
+
+  void reset(uint32_t initial) {
+    state = initial;
+    cnt0 = 0xFFFFFFFFu;
+    cnt1 = 0xFFFFFFFFu;
+    pressed = 0;
+    released = 0;
+  }
+
+  // 送入一次原始采样，返回本次翻转的输入
+  uint32_t sample(uint32_t raw) {
+    uint32_t delta = raw ^ state;
+    cnt0 = ~(cnt0 & delta);
+    cnt1 = cnt0 ^ (cnt1 & delta);
+    uint32_t toggle = delta & cnt0 & cnt1;
+    state ^= toggle;
+    pressed = toggle & state;
+    released = toggle & ~state;
+    return toggle;
+  }
+};
+
+#endif // DEBOUNCER_H
@@ -0,0 +1,32 @@
+#ifndef ED25519_H
+#define ED25519_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// ==================== Ed25519 ====================
+// 固件清单的签名（RFC 8032 的 Ed25519，见 ota.h）：设备只编译进公钥、只做验证，
+// 私钥只在签名的电脑上。验证每次更新只做一次，在 flash 写入任务里完成（见 OTA_TASK_STACK）。
+//   - ESP32：ESP-IDF 自带的 libsodium 组件
+//   - 主机：src/native/ed25519_tweetnacl.h，另外提供 program --ota-keygen / --ota-sign 用的生成密钥和签名
+
+#define ED25519_PUBLIC_KEY_SIZE 32
+#define ED25519_SEED_SIZE 32       // 私钥：32 字节随机种子
+#define ED25519_SIGNATURE_SIZE 64
+
+#ifdef ARDUINO
+#include <sodium.h>
+
+// 拒绝 s >= L 的可延展签名和小阶公钥
+inline bool ed25519Verify(const uint8_t signature[ED25519_SIGNATURE_SIZE], const uint8_t* message, size_t length,
+                          const uint8_t publicKey[ED25519_PUBLIC_KEY_SIZE]) {
+  if (sodium_init() < 0) {  // 已初始化时立即返回 1
+    return false;
+  }
+  return crypto_sign_ed25519_verify_detached(signature, message, length, publicKey) == 0;
+}
+#else
+#include "ed25519_tweetnacl.h"
+#endif
+
+#endif // ED25519_H
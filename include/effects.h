@@ -0,0 +1,60 @@
+#ifndef EFFECTS_H
+#define EFFECTS_H
+
+#include <stdint.h>
+#include "hal.h"
+#include "config.h"
+
+// ==================== 灯效引擎 ====================
+// 每帧由“模式开始后经过的毫秒数”算出动画相位，画面只取决于时间，与 LED 作业实际运行了几次无关：
+// 渲染任务卡顿时动画跳到正确的位置，而不是整体变慢。
+// 亮度曲线用编译期生成的查找表（伽马、正弦、伽马校正后的呼吸曲线），颜色缩放用 scale8 定点乘法，
+// 每帧没有除法（相位计算除外，每帧一次）。
+// renderEffect() 只写调用方给的缓冲区，不依赖全局状态，主机基准直接用任意长度的缓冲区调用。
+
+enum EffectKind : uint8_t {
+  EFFECT_SOLID,      // 纯色
+  EFFECT_BREATHE,    // 整条呼吸
+  EFFECT_BLINK,      // 前半周期亮、后半周期灭
+  EFFECT_CHASE,      // 带渐隐尾巴的光点，每周期跑完一圈
+  EFFECT_GRADIENT,   // color → color2 → color 的渐变，每周期滚动一圈
+  EFFECT_PROGRESS,   // 按 level 点亮前若干个像素（末尾像素按小数部分），点亮部分缓慢呼吸
+  NUM_EFFECT_KINDS,
+  EFFECT_CLIP = NUM_EFFECT_KINDS  // 动画片段，由 renderClipFrame() 播放（见 clips.h），不经 renderEffect()
+};
+
+struct Effect {
+  EffectKind kind;
+  CRGB color;
+  CRGB color2;                 // 渐变终点 / 进度条背景
+  uint16_t periodMillis;       // 一个动画周期
+  uint16_t framePeriodMillis;  // LED 作业周期
+  uint16_t budgetMicros;       // 每 1000 个像素的单帧渲染时间预算
+  bool levelFromButtons;       // level 取 LEDController::greenBreathBrightness，否则为 255
+};
+
+struct EffectStats {
+  uint32_t frames;
+  uint32_t overBudget;  // 渲染时间超过预算的帧数
+  uint32_t lastNanos;
+  uint32_t maxNanos;
+};
+
+// LEDMode 对应的灯效；片段模式为 clipModeEffect()
+const Effect& ledModeEffect(LEDMode mode);
+
+// 渲染 elapsedMillis 时刻的一帧到 out[0..count)；level 为亮度上限（进度条为填充比例）
+void renderEffect(const Effect& effect, CRGB* out, uint16_t count, uint32_t elapsedMillis, uint8_t level);
+
+// renderEffect() 并按周期计数器计时，计入该类灯效的统计
+void renderEffectFrame(const Effect& effect, CRGB* out, uint16_t count, uint32_t elapsedMillis, uint8_t level);
+const EffectStats& effectStats(EffectKind kind);
+const char* effectName(EffectKind kind);
+bool findEffectKind(const char* name, uint8_t& kind);
+
+// LEDMode 的名称（规则 JSON、MQTT 命令和状态回复）
+const char* ledModeName(uint8_t mode);
+bool findLEDMode(const char* name, uint8_t& mode);
+bool validLEDMode(uint8_t mode);  // 内置模式或已登记的片段模式
+
+#endif // EFFECTS_H
@@ -0,0 +1,211 @@
+#ifndef HAL_H
+#define HAL_H
+
+// ==================== 硬件抽象层 ====================
+// main.cpp 中的业务逻辑只通过这里的函数访问硬件和网络：
+//   - ESP32 目标：src/hal_esp32.cpp（Arduino / FastLED / PubSubClient / AsyncWebServer）
+//   - 主机目标：src/native/hal_native.cpp（虚拟时钟 + 模拟引脚、灯带、MQTT、WebSocket）
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#include <FastLED.h>
+#else
+#include "native_shim.h"
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+
+// ==================== 时间 ====================
+unsigned long halMillis();
+unsigned long halMicros();
+void halDelay(unsigned long ms);
+uint32_t halRandom();  // 退避抖动等非加密用途
+
+// CPU 周期计数器，用于测量同一任务内的短时段（ESP32 上每个核心各有一个，不能跨任务比较；
+// 240 MHz 时约 17 s 回绕）。主机上 1 个周期为 1 ns（steady_clock）
+uint32_t halCycleCount();
+uint32_t halCyclesToNanos(uint32_t cycles);
+
+// ==================== GPIO ====================
+void halPinModeInputPullup(uint8_t pin);
+int halDigitalRead(uint8_t pin);
+uint64_t halReadGPIOInputs();  // 一次读取全部GPIO输入电平，bit n 对应 GPIOn
+
+// 引脚电平变化中断：handler 在中断上下文中执行（ESP32 上必须是 IRAM_ATTR），
+// 参数为注册时的 index、变化后的电平和微秒时间戳
+typedef void (*HalPinChangeHandler)(uint8_t index, int level, uint32_t timestampMicros);
+void halAttachPinChange(uint8_t pin, uint8_t index, HalPinChangeHandler handler);
+
+// ==================== LED灯带 ====================
+// 每个通道是一个 GPIO 上的灯带，帧由外设在后台发送（ESP32 上每通道一个 RMT 通道，逐位时序由硬件产生），
+// 各通道同时发送，调用方不阻塞：
+// halLEDTransmit() 启动一帧（本轮要发送的所有通道）后立即返回，帧完成信号之前不得修改各通道的数据，也不得再次调用；
+// 所有通道都发送完成时设置事件标志并通知 halLEDBegin() 指定的任务（帧完成信号）。
+// 发送包含帧尾的锁存低电平，帧完成信号之后可以立即发送下一帧。
+// data 为线上字节：每像素 3 字节，已按该通道的颜色顺序排列、已乘全局亮度。
+#define HAL_LED_MAX_CHANNELS 8  // ESP32 的 RMT 通道数
+
+struct HalLEDChannel {
+  uint8_t pin;
+  uint16_t pixels;
+};
+
+struct HalLEDSpan {
+  const uint8_t* data;
+  size_t length;  // 0：本轮不发送该通道
+};
+
+void halLEDBegin(const HalLEDChannel* channels, uint8_t count, uint8_t notifyTask);
+void halLEDTransmit(const HalLEDSpan* spans, uint8_t count);  // spans[c] 为通道 c
+bool halLEDBusy();  // 任一通道仍在发送
+bool halLEDTakeEvent();
+
+// ==================== WiFi ====================
+// 连接过程在后台进行，状态变化时设置事件标志并通知 halWiFiInit() 指定的任务。
+enum HalWiFiStatus {
+  HAL_WIFI_IDLE,
+  HAL_WIFI_CONNECTING,
+  HAL_WIFI_CONNECTED,
+  HAL_WIFI_FAILED  // 找不到AP、认证失败或连接断开
+};
+
+// 上次成功连接的链路参数：指定 BSSID/信道可跳过全信道扫描，沿用 IP 租约可跳过 DHCP
+struct HalWiFiLink {
+  uint8_t bssid[6];
+  uint8_t channel;
+  uint8_t reserved;
+  uint32_t ip;
+  uint32_t gateway;
+  uint32_t subnet;
+  uint32_t dns;
+};
+
+void halWiFiInit(uint8_t notifyTask);
+void halWiFiBegin(const char* ssid, const char* password, const HalWiFiLink* link);  // link 为空时全扫描 + DHCP
+void halWiFiDisconnect();
+HalWiFiStatus halWiFiStatus();
+bool halWiFiTakeEvent();
+bool halWiFiReadLink(HalWiFiLink& link);
+bool halWiFiConnected();
+String halWiFiLocalIP();
+// 已连接时的 modem sleep：idle 时射频按 AP 的监听间隔醒来（ESP32 的 WIFI_PS_MAX_MODEM），否则每个 DTIM 醒来
+void halWiFiSetPowerSave(bool idle);
+
+// 发送一个 UDP 数据报（syslog 等），不等待、不重发；host 必须是点分十进制 IP，不做 DNS 解析
+bool halUDPSend(const char* host, uint16_t port, const uint8_t* data, size_t length);
+
+// ==================== NVS ====================
+// 掉电保存的小块数据，长度不符时视为不存在
+bool halNVSLoad(const char* key, void* data, size_t length);
+bool halNVSStore(const char* key, const void* data, size_t length);
+
+// ==================== 文件系统 ====================
+// LittleFS 上的小配置文件（pio run -t uploadfs 上传 data/ 目录）；读取返回长度，不存在或放不下时返回 -1
+int32_t halFileRead(const char* path, char* buffer, size_t capacity);
+bool halFileWrite(const char* path, const char* data, size_t length);
+bool halFileAppend(const char* path, const char* data, size_t length);  // 文件不存在时创建
+
+// ==================== 数据分区 ====================
+// flash 上按名称查找的数据分区（分区表见 partitions.csv）。整个分区只读映射到地址空间
+// （ESP32 上为 esp_partition_mmap()，经 flash 缓存读取；主机上为 mmap() 一个文件），读取不复制到 RAM。
+// 擦除/写入期间映射中被改写的部分内容不确定，调用方自行保证此时没有读者；写完后映射反映新内容。
+#define HAL_FLASH_SECTOR_SIZE 4096
+
+const uint8_t* halPartitionMap(const char* label, size_t& size);  // 分区不存在时返回 nullptr，重复调用返回同一映射
+bool halPartitionErase(const char* label, size_t offset, size_t length);  // offset/length 按扇区对齐
+bool halPartitionWrite(const char* label, size_t offset, const void* data, size_t length);
+
+// ==================== 固件更新 ====================
+// 把新固件写入空闲的 OTA 应用分区（ESP32 上为 Arduino Update），只由 OTA 写入任务调用（见 ota.h）。
+// halOTAWrite() 按顺序给出镜像，进入新扇区时先擦除再写入，调用方阻塞到写完；
+// halOTAEnd() 检查长度和镜像头后把启动分区切换到新固件，下次重启生效。之前任何一步失败或调用
+// halOTAAbort() 时启动分区不变。失败原因由 halOTAError() 给出（常量字符串）。
+bool halOTABegin(size_t size);
+bool halOTAWrite(const uint8_t* data, size_t length);
+bool halOTAEnd();
+void halOTAAbort();
+const char* halOTAError();
+void halRestart();
+
+// ==================== 保留内存 ====================
+// 软件复位（崩溃、看门狗、OTA 后重启）后内容保持不变、掉电后为随机值的一小块内存
+// （ESP32 上为 RTC 慢速内存），内容由使用者自行校验。4 字节对齐。
+#define HAL_RETAINED_SIZE 1024
+void* halRetainedMemory();
+
+// ==================== MQTT ====================
+// 连接（TCP + CONNECT/CONNACK）在后台进行，调用方不阻塞：
+// halMQTTConnectAsync() 发起，完成或失败时设置事件标志并通知 halMQTTBegin() 指定的任务。
+// 连接进行中（HAL_MQTT_CONNECT_PENDING）不得调用其他 halMQTT* 收发函数。
+typedef void (*HalMQTTCallback)(char* topic, uint8_t* payload, unsigned int length);
+
+enum HalMQTTConnectStatus {
+  HAL_MQTT_CONNECT_IDLE,
+  HAL_MQTT_CONNECT_PENDING,
+  HAL_MQTT_CONNECT_DONE,
+  HAL_MQTT_CONNECT_FAILED
+};
+
+void halMQTTBegin(const char* server, uint16_t port, HalMQTTCallback callback, uint8_t notifyTask);
+void halMQTTConnectAsync(const char* clientId);
+HalMQTTConnectStatus halMQTTConnectStatus();
+bool halMQTTTakeEvent();
+bool halMQTTConnected();
+int halMQTTState();
+bool halMQTTSubscribe(const char* topic);
+bool halMQTTPublish(const char* topic, const char* payload);
+void halMQTTLoop();
+
+// ==================== WebSocket ====================
+// 广播由 ws_fanout 逐个客户端发送，帧内容只分配一次，所有客户端引用同一块缓冲
+// （ESP32 上为 HAL 自己持有的 AsyncWebSocketMessageBuffer）。缓冲带原子引用计数：halWebSocketAllocate() 返回时
+// 调用方持有一个引用，halWebSocketSend() 期间传输层另持有一个，发出或丢弃后（可能在其他任务里）自行释放。
+// 客户端的连接/断开事件由 Web 服务器（ESP32 上为 AsyncTCP 任务）交给 wsClientConnected() 等函数。
+struct HalWsBuffer;
+
+HalWsBuffer* halWebSocketAllocate(const uint8_t* data, size_t length);  // 内存不足时返回 nullptr
+void halWebSocketRetain(HalWsBuffer* buffer);
+void halWebSocketRelease(HalWsBuffer* buffer);
+// 传输层能否再接受该客户端的一帧（ESP32 上为消息队列未满且 TCP 发送缓冲区有空间）
+bool halWebSocketCanSend(uint32_t clientId);
+bool halWebSocketSend(uint32_t clientId, HalWsBuffer* buffer, bool binary);
+void halWebSocketClose(uint32_t clientId);
+void halWebSocketCleanup();
+
+// ==================== 低功耗 ====================
+// 浅睡眠：两个核心暂停、外设时钟停止，RAM 和定时器保持。durationMicros 后由定时器唤醒，
+// 或任一 pins[i] 的电平不再等于 levels[i] 时由 GPIO 唤醒（进入时已经不等则立即返回）。
+// 睡眠期间这些引脚的电平变化中断不送达（ESP32 的 GPIO 唤醒要求把它们临时改为电平触发），
+// 调用方醒来后按输入寄存器重新同步。返回后 halMicros() 已包含睡眠时间；
+// ESP32 上 FreeRTOS 节拍在睡眠期间不前进，其他任务的阻塞超时相应推迟，需要时由调用方通知。
+enum HalWakeCause {
+  HAL_WAKE_TIMER,
+  HAL_WAKE_GPIO,
+  HAL_WAKE_OTHER
+};
+
+HalWakeCause halLightSleep(uint32_t durationMicros, const uint8_t* pins, const uint8_t* levels, uint8_t count);
+
+// ==================== 任务 ====================
+// 任务函数运行到期的工作并返回距离下一次需要运行的微秒数，任务在此期间阻塞，
+// 直到超时或被 halNotifyTask()/halNotifyTaskFromISR() 提前唤醒。
+// ESP32 上是绑定核心的 FreeRTOS 任务（任务通知），主机上是 std::thread。
+// 发给未启动任务的通知转交 HAL_MAIN_TASK，即单核构建中调用 halWaitForNotify() 的 mainLoop。
+#define HAL_MAIN_TASK 0
+#define HAL_MAX_TASKS 4
+
+typedef uint32_t (*HalTaskFunction)();
+void halStartTask(uint8_t id, const char* name, HalTaskFunction fn,
+                  uint32_t stackSize, uint8_t priority, uint8_t core);
+void halNotifyTask(uint8_t id);
+void halNotifyTaskFromISR(uint8_t id);
+void halWaitForNotify(uint32_t timeoutMicros);
+
+// 不属于 HAL 任务的调用方（AsyncTCP 的回调）等待某个 HAL 任务时用信号：二值信号量，多次给出只记一次。
+// ESP32 上是静态分配的 FreeRTOS 信号量，主机上与任务通知共用条件变量（虚拟时钟下等待即推进到超时）。
+#define HAL_MAX_SIGNALS 2
+void halSignalGive(uint8_t id);
+bool halSignalTake(uint8_t id, uint32_t timeoutMicros);  // 超时返回 false
+
+#endif // HAL_H
@@ -0,0 +1,196 @@
+#ifndef INPUT_TRACE_H
+#define INPUT_TRACE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include "config.h"
+
+// ==================== 按钮输入录制 ====================
+// 现场录制按钮引脚的原始边沿（含抖动），写入 LittleFS 的 INPUT_TRACE_PATH，
+// 主机上经 updateButtonStates() → handleButtonLogic() → updateLEDController() 在虚拟时钟下回放
+// （main_native.cpp 的 --replay），输出 MQTT 发布和每帧 leds[] 的哈希，与 golden 文件比对。
+//
+// 文件格式（小端），按钮数 N 决定头部大小和 code 的位数 B（N ≤ 7 时 B = 4，否则 B = 6）：
+//   头部：魔数 "BTRC"、版本、N、开始时的原始按下掩码（2 字节），
+//   之后 N ≤ 8 时 8 个、否则 16 个引脚号（BUTTON_PINS，多余的为 0xFF）
+//   之后每条记录一个 LEB128 变长整数：(距上一条记录的微秒数 << B) | code
+//     code 0..2N-1  按钮 code/2 的电平变为 code&1（0 = 低电平 = 按下），抖动一个边沿一条，通常 1-2 字节
+//     code 2^B-2    重新同步：后跟一个 LEB128 的原始按下掩码（中断队列溢出、丢了边沿时记录）
+//     code 2^B-1    只推进时间：间隔超过 INPUT_TRACE_MAX_GAP_US 时插入（微秒计数约 71 分钟回绕），
+//                   以及停止录制时标记结束时刻
+// 默认 7 个按钮时头部 16 字节、B = 4。
+//
+// 录制由 MQTT_TOPIC_TRACE（载荷 "start" / "stop"）控制，GET /api/trace 下载。
+// 渲染任务把记录写进两块 INPUT_TRACE_CHUNK_SIZE 字节的缓冲区之一，写满后交给网络任务追加到文件；
+// 网络任务来不及写（两块都满）或文件达到 INPUT_TRACE_MAX_BYTES 时停止录制并计为截断。
+
+#define INPUT_TRACE_PATH "/trace.bin"
+#define INPUT_TRACE_VERSION 1
+#define INPUT_TRACE_MAX_PINS BUTTON_MAX_COUNT
+#define INPUT_TRACE_CHUNK_SIZE 1024
+#define INPUT_TRACE_MAX_BYTES (256 * 1024UL)
+#define INPUT_TRACE_MAX_GAP_US (1UL << 30)  // 约 18 分钟
+#define INPUT_TRACE_MAX_RECORD 16  // 一条记录（含重新同步的掩码）最多占用的字节数
+
+constexpr uint8_t inputTraceCodeBits(uint8_t buttons) { return buttons <= 7 ? 4 : 6; }
+constexpr size_t inputTraceHeaderSize(uint8_t buttons) { return buttons <= 8 ? 16 : 24; }
+
+// 本固件写出的格式
+#define INPUT_TRACE_HEADER_SIZE inputTraceHeaderSize(BTN_COUNT)
+#define INPUT_TRACE_CODE_BITS inputTraceCodeBits(BTN_COUNT)
+#define INPUT_TRACE_CODE_RESYNC ((1u << INPUT_TRACE_CODE_BITS) - 2)
+#define INPUT_TRACE_CODE_TIME ((1u << INPUT_TRACE_CODE_BITS) - 1)
+
+enum InputTraceRecordType : uint8_t {
+  TRACE_RECORD_EDGE,
+  TRACE_RECORD_RESYNC,
+  TRACE_RECORD_TIME
+};
+
+struct InputTraceRecord {
+  uint64_t offsetMicros;  // 距录制开始
+  uint8_t type;           // InputTraceRecordType
+  uint8_t index;          // TRACE_RECORD_EDGE：按钮下标
+  uint8_t level;          // TRACE_RECORD_EDGE：新电平（LOW = 按下）
+  uint32_t pressedMask;   // TRACE_RECORD_RESYNC：原始按下掩码
+};
+
+struct InputTraceStats {
+  bool recording;
+  bool truncated;       // 最近一次录制因缓冲区或文件大小限制提前停止
+  uint32_t edges;       // 最近一次录制的边沿数
+  uint32_t resyncs;
+  uint32_t bytes;       // 最近一次录制的字节数（含头部）
+  uint32_t savedBytes;  // 已写入文件的字节数
+};
+
+// ==================== 编码（录制端与主机工具共用） ====================
+inline size_t inputTraceEncodeVarint(uint8_t* out, uint64_t value) {
+  size_t n = 0;
+  while (value >= 0x80) {
+    out[n++] = (uint8_t)(value | 0x80);
+    value >>= 7;
+  }
+  out[n++] = (uint8_t)value;
+  return n;
+}
+
+inline size_t inputTraceEncodeHeader(uint8_t* out, uint32_t pressedMask) {
+  memcpy(out, "BTRC", 4);
+  out[4] = INPUT_TRACE_VERSION;
+  out[5] = BTN_COUNT;
+  out[6] = (uint8_t)pressedMask;
+  out[7] = (uint8_t)(pressedMask >> 8);
+  for (uint8_t i = 0; i < INPUT_TRACE_HEADER_SIZE - 8; i++) {
+    out[8 + i] = i < BTN_COUNT ? BUTTON_PINS[i] : 0xFF;
+  }
+  return INPUT_TRACE_HEADER_SIZE;
+}
+
+// 一条记录：deltaMicros 不超过 INPUT_TRACE_MAX_GAP_US
+inline size_t inputTraceEncodeRecord(uint8_t* out, uint32_t deltaMicros, uint8_t code) {
+  return inputTraceEncodeVarint(out, ((uint64_t)deltaMicros << INPUT_TRACE_CODE_BITS) | code);
+}
+
+// ==================== 读取 ====================
+// 直接在调用方的缓冲区上逐条解码；格式错误或截断在中途时 ok() 为 false，
+// 末尾缺少结束标记（录制被截断）不算错误
+class InputTraceReader {
+public:
+  InputTraceReader(const uint8_t* data, size_t length) : data_(data), length_(length) {
+    if (length < 8 || memcmp(data, "BTRC", 4) != 0 || data[4] != INPUT_TRACE_VERSION ||
+        data[5] > INPUT_TRACE_MAX_PINS || length < inputTraceHeaderSize(data[5])) {
+      failed_ = true;
+      return;
+    }
+    position_ = inputTraceHeaderSize(data[5]);
+    codeBits_ = inputTraceCodeBits(data[5]);
+  }
+
+  bool ok() const { return !failed_; }
+  size_t offset() const { return position_; }
+  uint8_t buttonCount() const { return data_[5]; }
+  uint32_t initialPressedMask() const { return data_[6] | (data_[7] << 8); }
+  uint8_t pin(uint8_t index) const { return data_[8 + index]; }
+
+  // 与本固件的 BUTTON_PINS 一致才能回放
+  bool matchesPins() const {
+    if (failed_ || buttonCount() != BTN_COUNT) return false;
+    for (uint8_t i = 0; i < BTN_COUNT; i++) {
+      if (pin(i) != BUTTON_PINS[i]) return false;
+    }
+    return true;
+  }
+
+  bool next(InputTraceRecord& record) {
+    uint64_t value;
+    if (failed_ || position_ >= length_ || !varint(value)) {
+      return false;
+    }
+    offsetMicros_ += value >> codeBits_;
+    uint8_t code = value & ((1u << codeBits_) - 1);
+    uint8_t resync = (1u << codeBits_) - 2;
+    record.offsetMicros = offsetMicros_;
+    record.index = 0;
+    record.level = 0;
+    record.pressedMask = 0;
+    if (code == resync + 1) {
+      record.type = TRACE_RECORD_TIME;
+    } else if (code == resync) {
+      uint64_t mask;
+      if (!varint(mask)) return false;
+      record.type = TRACE_RECORD_RESYNC;
+      record.pressedMask = (uint32_t)mask;
+    } else {
+      record.type = TRACE_RECORD_EDGE;
+      record.index = code >> 1;
+      record.level = code & 1;
+      if (record.index >= buttonCount()) return fail();
+    }
+    return true;
+  }
+
+private:
+  bool fail() {
+    failed_ = true;
+    return false;
+  }
+
+  bool varint(uint64_t& value) {
+    value = 0;
+    for (uint8_t shift = 0; shift < 64; shift += 7) {
+      if (position_ >= length_) return fail();
+      uint8_t byte = data_[position_++];
+      value |= (uint64_t)(byte & 0x7F) << shift;
+      if (!(byte & 0x80)) return true;
+    }
+    return fail();
+  }
+
+  const uint8_t* data_;
+  size_t length_;
+  size_t position_ = 0;
+  uint64_t offsetMicros_ = 0;
+  uint8_t codeBits_ = 4;
+  bool failed_ = false;
+};
+
+// ==================== 录制 ====================
+void initializeInputTrace();
+
+// 任意任务（MQTT 回调）：请求开始/停止，渲染任务下一次运行输入作业时生效
+void requestInputTrace(bool start);
+bool inputTraceCommandPending();  // runRenderTask() 据此立即运行输入作业
+
+// 渲染任务（updateButtonStates()）：每个弹出的中断边沿一条；本轮采样之后处理开始/停止请求和重新同步
+void recordInputEdge(uint8_t index, uint8_t level, uint32_t timestampMicros);
+void updateInputTrace(uint32_t pressedMask, bool resync, uint32_t nowMicros);
+
+// 网络任务：把写满的缓冲区追加到文件
+bool inputTraceFlushPending();
+void flushInputTrace();
+
+const InputTraceStats& inputTraceStats();
+
+#endif // INPUT_TRACE_H
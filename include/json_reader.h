@@ -0,0 +1,162 @@
+#ifndef JSON_READER_H
+#define JSON_READER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+// ==================== 定长 JSON 读取器 ====================
+// 与 text_writer.h 对应：直接在调用方的缓冲区上逐个读取值，不建树、不做堆分配。
+// 只支持固件配置文件用到的子集：对象、数组、字符串（不含 \u 转义）、非负整数、true/false/null。
+// 任何一步失败后后续操作都不再读取，最后用 ok() 检查一次即可；offset() 给出出错位置。
+// 用法：
+//   reader.expect('{');
+//   while (reader.more('}')) {
+//     reader.key(name, sizeof(name));
+//     if (!strcmp(name, "x")) reader.u32(x); else reader.skip();
+//   }
+
+#define JSON_READER_MAX_DEPTH 8
+
+class JsonReader {
+public:
+  JsonReader(const char* text, size_t length) : text_(text), length_(length) {}
+
+  bool ok() const { return !failed_; }
+  size_t offset() const { return position_; }
+
+  bool expect(char c) {
+    if (peek() != c) {
+      return fail();
+    }
+    position_++;
+    return true;
+  }
+
+  // 容器内是否还有下一个元素；遇到 close 时消费它并返回 false
+  bool more(char close) {
+    char c = peek();
+    if (failed_ || c == close) {
+      if (!failed_) position_++;
+      return false;
+    }
+    if (c == ',') {
+      position_++;
+      if (peek() == close) return fail();  // 不接受末尾多余的逗号
+    }
+    return !failed_;
+  }
+
+  bool key(char* out, size_t capacity) {
+    return string(out, capacity) && expect(':');
+  }
+
+  bool string(char* out, size_t capacity) {
+    if (!expect('"')) return false;
+    size_t n = 0;
+    while (position_ < length_ && text_[position_] != '"') {
+      char c = text_[position_++];
+      if (c == '\\') {
+        if (position_ >= length_) return fail();
+        c = text_[position_++];
+        if (c == 'n') c = '\n';
+        else if (c == 't') c = '\t';
+        else if (c != '"' && c != '\\' && c != '/') return fail();
+      }
+      if (n + 1 >= capacity) return fail();
+      out[n++] = c;
+    }
+    if (position_ >= length_) return fail();
+    position_++;
+    out[n] = '\0';
+    return true;
+  }
+
+  bool u32(uint32_t& value) {
+    if (peek() < '0' || peek() > '9') return fail();
+    uint64_t v = 0;
+    while (position_ < length_ && text_[position_] >= '0' && text_[position_] <= '9') {
+      v = v * 10 + (uint32_t)(text_[position_++] - '0');
+      if (v > UINT32_MAX) return fail();
+    }
+    value = (uint32_t)v;
+    return true;
+  }
+
+  bool boolean(bool& value) {
+    if (literal("true")) { value = true; return true; }
+    if (literal("false")) { value = false; return true; }
+    return fail();
+  }
+
+  // null 时返回 true 并消费它，用于可为空的字段
+  bool null() {
+    return peek() == 'n' && literal("null");
+  }
+
+  // 跳过任意一个值（用于未知字段）
+  bool skip() {
+    return skipValue(0);
+  }
+
+private:
+  char peek() {
+    while (position_ < length_ && (text_[position_] == ' ' || text_[position_] == '\n' ||
+                                   text_[position_] == '\r' || text_[position_] == '\t')) {
+      position_++;
+    }
+    return (!failed_ && position_ < length_) ? text_[position_] : '\0';
+  }
+
+  bool literal(const char* word) {
+    size_t n = strlen(word);
+    peek();
+    if (position_ + n > length_ || memcmp(text_ + position_, word, n) != 0) {
+      return false;
+    }
+    position_ += n;
+    return true;
+  }
+
+  bool skipValue(uint8_t depth) {
+    if (depth >= JSON_READER_MAX_DEPTH) return fail();
+    char c = peek();
+    if (c == '{') {
+      position_++;
+      char name[32];
+      while (more('}')) {
+        if (!key(name, sizeof(name)) || !skipValue(depth + 1)) return false;
+      }
+      return !failed_;
+    }
+    if (c == '[') {
+      position_++;
+      while (more(']')) {
+        if (!skipValue(depth + 1)) return false;
+      }
+      return !failed_;
+    }
+    if (c == '"') {
+      char scratch[64];
+      return string(scratch, sizeof(scratch));
+    }
+    if (c >= '0' && c <= '9') {
+      uint32_t ignored;
+      return u32(ignored);
+    }
+    bool ignored;
+    return null() || boolean(ignored);
+  }
+
+  bool fail() {
+    failed_ = true;
+    return false;
+  }
+
+  const char* text_;
+  size_t length_;
+  size_t position_ = 0;
+  bool failed_ = false;
+};
+
+#endif // JSON_READER_H
@@ -0,0 +1,37 @@
+#ifndef LED_COMPOSITOR_H
+#define LED_COMPOSITOR_H
+
+#include "hal.h"
+#include "config.h"
+#include "led_layout.h"
+
+// ==================== LED帧合成器 ====================
+// 持有逻辑帧缓冲 leds[0..ledCount)，长度由启动时加载的灯带布局决定（见 led_layout.h）。
+// 灯效把整帧写入 leds[] 后调用 compositorPresent()，只有帧内容与上一次推送到灯带的帧不同
+// （FNV-1a 哈希比较），或距离上次推送超过 LED_MIN_REFRESH_INTERVAL 时才推送。
+//
+// 推送不阻塞：leds[] 按段映射、各通道的颜色顺序和 LED_BRIGHTNESS 编码进两块线上帧缓冲之一，
+// 再把各通道的部分一次交给 halLEDTransmit()，各通道并行发送，渲染任务随即可以画下一帧。
+// 正在发送的那一块在帧完成信号之前不会被改写（不撕裂）；
+// 发送期间推送的帧写入另一块并挂起，帧完成后立即发送；挂起的帧被更新的帧覆盖时计为丢帧。
+// 逻辑帧缓冲和两块线上帧缓冲在启动时一次分配为一块连续内存，每像素 9 字节。
+
+extern CRGB* leds;
+extern uint16_t ledCount;
+
+struct CompositorStats {
+  uint32_t framesRendered;   // 交给外设发送的帧数
+  uint32_t framesSkipped;    // 内容未变化而跳过的帧数
+  uint32_t framesCompleted;  // 收到帧完成信号的帧数
+  uint32_t framesDropped;    // 挂起期间被更新的帧覆盖、没有发送的帧数
+};
+
+void initializeCompositor(uint8_t notifyTask);
+bool compositorPresent();
+void compositorFrameDone();  // 帧完成信号到达时由渲染任务调用：发送挂起的帧
+bool compositorBusy();       // 有帧在发送、等待确认完成或挂起
+const CompositorStats& compositorStats();
+const LEDLayout& compositorLayout();
+size_t compositorMemoryBytes();  // 帧缓冲占用的内存
+
+#endif // LED_COMPOSITOR_H
@@ -0,0 +1,49 @@
+#ifndef LED_LAYOUT_H
+#define LED_LAYOUT_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "hal.h"
+#include "config.h"
+
+// ==================== 灯带布局 ====================
+// 灯效渲染到一块连续的逻辑帧缓冲 leds[0..pixelCount)，段映射把逻辑区间接到物理通道上：
+//   - 通道：一个 GPIO 上的一条（或串接的多条）灯带，有自己的颜色顺序，各通道并行发送
+//   - 段：逻辑区间 [start, start + count) → 某个通道，同一通道上的段按列出的顺序首尾相接，
+//     reverse 时反向排列（灯带反着装时用）；同一逻辑区间可以接到多个通道上（镜像）
+// 布局在启动时从 LittleFS 的 LED_LAYOUT_FILE_PATH 读取（格式见 data/leds.json），
+// 不存在或无效时为 LED_PIN 上 NUM_LEDS 个 COLOR_ORDER 像素的单通道。
+
+#define LED_LAYOUT_FILE_PATH "/leds.json"
+#define LED_LAYOUT_JSON_CAPACITY 1024
+
+struct LEDChannelConfig {
+  uint8_t pin;
+  uint16_t order;     // FastLED EOrder（RGB、GRB ...）
+  uint16_t pixels;    // 该通道上所有段的像素数之和，由 finalizeLEDLayout() 计算
+};
+
+struct LEDSegment {
+  uint16_t start;     // 逻辑帧缓冲中的起点
+  uint16_t count;
+  uint8_t channel;
+  bool reverse;
+  uint16_t offset;    // 在通道内的像素位置，由 finalizeLEDLayout() 计算
+};
+
+struct LEDLayout {
+  LEDChannelConfig channels[HAL_LED_MAX_CHANNELS];
+  LEDSegment segments[LED_MAX_SEGMENTS];
+  uint8_t channelCount;
+  uint8_t segmentCount;
+  uint16_t pixelCount;  // 逻辑帧缓冲长度 = 各段终点的最大值
+};
+
+void defaultLEDLayout(LEDLayout& out);
+bool parseLEDLayoutJSON(LEDLayout& out, const char* text, size_t length, char* error, size_t errorCapacity);
+bool loadLEDLayout(LEDLayout& out);  // 读取 LED_LAYOUT_FILE_PATH，失败时为默认布局并返回 false
+
+// 最长通道发送一帧的时间（各通道并行），决定帧率上限
+uint32_t ledLayoutFrameMicros(const LEDLayout& layout);
+
+#endif // LED_LAYOUT_H
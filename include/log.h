@@ -0,0 +1,226 @@
+#ifndef LOG_H
+#define LOG_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <type_traits>
+#include "hal.h"
+#include "config.h"
+#include "text_writer.h"
+#include "mpsc_queue.h"
+
+// ==================== 异步日志 ====================
+// 调用点只把一条定长记录（级别、毫秒时间戳、事件号、最多 LOG_MAX_ARGS 个参数、可选的一段复制文本）
+// 写入无锁环形缓冲区，不格式化、不碰串口；网络任务的日志作业（JOB_LOG）再按事件的格式串格式化，
+// 输出到串口（只写 availableForWrite() 放得下的行，串口慢时记录留在缓冲区，不阻塞）、
+// WebSocket 日志视图（发给打开了日志面板的客户端，见 ws_fanout.h）和 syslog（UDP，SYSLOG_SERVER 非空且 WiFi 已连接时）。
+//   - 编译期裁剪：低于 LOG_LEVEL 的 LOG_xxx() 展开为空，参数也不求值
+//   - 限流：每个事件每 LOG_RATE_WINDOW 毫秒最多记录 LOG_RATE_LIMIT 条，超出的只计数，
+//     该事件下一条输出时附带被抑制的条数
+//   - 缓冲区满时丢弃新记录并计数，日志作业输出一行丢弃条数；调用点从不等待
+// 任意任务都可以调用（AsyncTCP 回调也可以），不能在中断中调用。
+// 格式串见 log.cpp 的 LOG_FORMATS，占位符只有：
+//   %u %d %x  整数参数
+//   %s        常量字符串参数（只保存指针，必须是字符串字面量或全局常量）
+//   %t        记录里复制的文本，由 logText() 参数给出，每条记录最多一个
+//   %m        微秒数，输出为 "12.345 ms"，UINT32_MAX 输出为 "-"
+
+#define LOG_MAX_ARGS 8
+#define LOG_TEXT_CAPACITY 48  // 含结尾 '\0'，超出截断
+#define LOG_LINE_CAPACITY 256
+#define LOG_VIEW_FRAME_CAPACITY 1024  // 一次日志作业输出的行合并成一个 WebSocket 文本帧
+
+enum LogEvent : uint8_t {
+  LOG_BOOT_START,
+  LOG_BOOT_DONE,
+  LOG_BOOT_TIMINGS,
+  LOG_BUTTONS_READY,
+  LOG_LED_READY,
+  LOG_LED_LAYOUT,
+  LOG_LED_LAYOUT_INVALID,
+  LOG_WIFI_BEGIN,
+  LOG_WIFI_CONNECTED,
+  LOG_WIFI_FAST_FAILED,
+  LOG_WIFI_FAILED,
+  LOG_WIFI_LOST,
+  LOG_MQTT_READY,
+  LOG_MQTT_CONNECTING,
+  LOG_MQTT_CONNECTED,
+  LOG_MQTT_FAILED,
+  LOG_MQTT_LOST,
+  LOG_MQTT_MESSAGE,
+  LOG_COMMAND_INVALID,
+  LOG_COMMAND_DROPPED,
+  LOG_COMMAND_ROUTE_FAILED,
+  LOG_REMOTE_TAKEOVER,
+  LOG_REMOTE_RELEASED,
+  LOG_OUTBOX_RESTORED,
+  LOG_BUTTON_STATUS,
+  LOG_BUTTON_EDGE,
+  LOG_RULE_FIRED,
+  LOG_RULES_LOADED,
+  LOG_RULES_FILE_INVALID,
+  LOG_RULES_BUSY,
+  LOG_RULES_INVALID,
+  LOG_RULES_WRITE_FAILED,
+  LOG_RULES_UPDATED,
+  LOG_WEB_READY,
+  LOG_WS_CONNECT,
+  LOG_WS_DISCONNECT,
+  LOG_WS_EVICTED,
+  LOG_WS_REJECTED,
+  LOG_TRACE_STARTED,
+  LOG_TRACE_STOPPED,
+  LOG_TRACE_TRUNCATED,
+  LOG_TRACE_BUSY,
+  LOG_TRACE_SAVED,
+  LOG_TRACE_WRITE_FAILED,
+  LOG_POWER_IDLE,
+  LOG_POWER_ACTIVE,
+  LOG_CLIPS_READY,
+  LOG_CLIPS_CORRUPT,
+  LOG_CLIP_MISSING,
+  LOG_CLIP_FRAME_INVALID,
+  LOG_CLIP_MODES_FULL,
+  LOG_CLIP_UPLOAD_DONE,
+  LOG_CLIP_UPLOAD_REJECTED,
+  LOG_OTA_BEGIN,
+  LOG_OTA_DONE,
+  LOG_OTA_FAILED,
+  LOG_OTA_BUSY,
+  LOG_DROPPED,  // 日志作业自己生成：缓冲区满丢弃的条数
+  NUM_LOG_EVENTS
+};
+
+struct LogRecord {
+  uint32_t millis;
+  uint8_t level;
+  uint8_t event;      // LogEvent
+  uint8_t argCount;
+  uint8_t textLength;
+  uint8_t stringArgs;  // bit n：args[n] 是字符串指针，格式串与参数类型不符时输出 '?' 而不是解引用整数
+  uintptr_t args[LOG_MAX_ARGS];
+  char text[LOG_TEXT_CAPACITY];
+};
+
+struct LogStats {
+  uint32_t written;     // 进入缓冲区的记录
+  uint32_t suppressed;  // 被限流的记录
+  uint32_t dropped;     // 缓冲区满而丢弃的记录
+  uint32_t emitted;     // 已输出到串口的行
+  uint32_t deferred;    // 串口发送缓冲区放不下、推迟到下一次作业的次数
+  uint16_t maxDepth;
+};
+
+// 复制到记录里的文本（%t），length 超出 LOG_TEXT_CAPACITY - 1 时截断
+struct LogText {
+  const char* text;
+  size_t length;
+};
+
+inline LogText logText(const char* text) {
+  return LogText{text, strlen(text)};
+}
+
+inline LogText logText(const char* text, size_t length) {
+  return LogText{text, length};
+}
+
+// ==================== 写入 ====================
+typedef MpscQueue<LogRecord, LOG_RING_SIZE> LogQueue;
+LogQueue& logQueue();
+bool logAdmit(uint8_t event, uint32_t nowMillis);  // 限流检查，被限流时计数并返回 false
+void logPushed(bool ok);       // 计数；缓冲区过半时唤醒网络任务
+
+namespace logdetail {
+
+inline void put(LogRecord& r, const LogText& value) {
+  size_t n = value.length < LOG_TEXT_CAPACITY - 1 ? value.length : LOG_TEXT_CAPACITY - 1;
+  memcpy(r.text, value.text, n);
+  r.text[n] = '\0';
+  r.textLength = (uint8_t)n;
+}
+
+inline void put(LogRecord& r, const char* value) {
+  r.stringArgs |= (uint8_t)(1u << r.argCount);
+  r.args[r.argCount++] = (uintptr_t)value;
+}
+
+// 可写缓冲区里的字符串在输出前可能已被改写，用 logText() 复制
+void put(LogRecord& r, char* value) = delete;
+
+// 整数和枚举；有符号数按符号扩展保存，%d 取低 32 位
+template <typename T>
+inline void put(LogRecord& r, T value) {
+  static_assert(std::is_integral<T>::value || std::is_enum<T>::value,
+                "日志参数必须是整数、常量字符串或 logText()");
+  r.args[r.argCount++] = (uintptr_t)(intptr_t)value;
+}
+
+template <typename T>
+struct isText { static const int value = 0; };
+template <>
+struct isText<LogText> { static const int value = 1; };
+
+}  // namespace logdetail
+
+template <typename... Args>
+inline void logWrite(uint8_t level, uint8_t event, const Args&... args) {
+  static_assert(sizeof...(Args) <= LOG_MAX_ARGS + 1, "日志参数过多");
+  static_assert((0 + ... + logdetail::isText<Args>::value) <= 1, "每条日志最多一个 logText()");
+  uint32_t now = (uint32_t)halMillis();
+  if (!logAdmit(event, now)) {
+    return;
+  }
+  logPushed(logQueue().push([&](LogRecord& record) {
+    record.millis = now;
+    record.level = level;
+    record.event = event;
+    record.argCount = 0;
+    record.textLength = 0;
+    record.stringArgs = 0;
+    (logdetail::put(record, args), ...);
+  }));
+}
+
+#if LOG_LEVEL >= LOG_LEVEL_ERROR
+#define LOG_ERROR(event, ...) logWrite(LOG_LEVEL_ERROR, event, ##__VA_ARGS__)
+#else
+#define LOG_ERROR(event, ...) ((void)0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_WARN
+#define LOG_WARN(event, ...) logWrite(LOG_LEVEL_WARN, event, ##__VA_ARGS__)
+#else
+#define LOG_WARN(event, ...) ((void)0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_INFO
+#define LOG_INFO(event, ...) logWrite(LOG_LEVEL_INFO, event, ##__VA_ARGS__)
+#else
+#define LOG_INFO(event, ...) ((void)0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(event, ...) logWrite(LOG_LEVEL_DEBUG, event, ##__VA_ARGS__)
+#else
+#define LOG_DEBUG(event, ...) ((void)0)
+#endif
+
+// ==================== 输出（网络任务） ====================
+// 清零统计和限流窗口，缓冲区中尚未输出的记录保留（setup() 最早的日志在调度器启动前写入）
+void initializeLog();
+
+// 日志作业：输出最多 LOG_DRAIN_BATCH 条，返回缓冲区中是否还有记录
+bool drainLog();
+bool logPending();  // 缓冲区过半，runNetworkTask() 据此提前运行日志作业
+
+// 按记录格式化一行（不含换行），供日志作业和主机测试使用
+void formatLogRecord(TextWriter& out, const LogRecord& record);
+
+void setSyslogServer(const char* host, uint16_t port);  // host 为空时关闭
+
+LogStats logStats();
+
+#endif // LOG_H
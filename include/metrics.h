@@ -0,0 +1,99 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stdint.h>
+#include "hal.h"
+#include "config.h"
+#include "text_writer.h"
+
+// ==================== 按钮边沿 → 发布 延迟追踪 ====================
+// 每个阶段一个直方图，全部放在静态数组里，记录时不分配内存、不加锁：
+//   edge_to_debounce  中断时间戳 → 消抖器确认（渲染任务，us）
+//   button_logic      handleButtonLogic() 耗时（渲染任务，周期计数器，ns）
+//   outbox_wait       事件投递 → 开始发布（网络任务，us，断线期间的积压也计入）
+//   publish_call      halMQTTPublish() 耗时（网络任务，周期计数器，ns）
+//   edge_to_publish   端到端：中断时间戳 → 发布完成（us）
+//   broker_echo       发布 → 收到服务器回送的同一条消息（只有设备自己订阅的主题，us）
+//   wake_to_frame     浅睡眠醒来 → 渲染出第一帧（只统计按钮唤醒和为下一帧定时的唤醒，us，见 power.h）
+//   command_apply     MQTT 命令回调收到 → 渲染任务应用（us，见 mqtt_commands.h）
+// 同一任务内的短时段用周期计数器（traceBegin/traceEnd），跨任务的时段用 halMicros() 时间戳。
+// 每个直方图只有一个写入任务；HTTP/MQTT 导出时读到的计数可能相差正在进行的一次记录。
+// METRICS_ENABLED 为 0 时所有记录函数为空。
+
+enum MetricId {
+  METRIC_EDGE_TO_DEBOUNCE,
+  METRIC_BUTTON_LOGIC,
+  METRIC_OUTBOX_WAIT,
+  METRIC_PUBLISH_CALL,
+  METRIC_EDGE_TO_PUBLISH,
+  METRIC_BROKER_ECHO,
+  METRIC_WAKE_TO_FRAME,
+  METRIC_COMMAND_APPLY,
+  NUM_METRICS
+};
+
+// 对数刻度：桶 b 收纳 [2^(b-1), 2^b) 个单位（桶 0 为 0），最后一个桶收纳所有更大的值
+#define METRIC_BUCKETS 24
+
+struct Histogram {
+  uint32_t buckets[METRIC_BUCKETS];
+  uint32_t count;
+  uint32_t max;
+  uint64_t sum;
+};
+
+#if METRICS_ENABLED
+void recordMetric(uint8_t metric, uint32_t value);
+
+static inline uint32_t traceBegin() {
+  return halCycleCount();
+}
+
+static inline void traceEnd(uint8_t metric, uint32_t startCycles) {
+  recordMetric(metric, halCyclesToNanos(halCycleCount() - startCycles));
+}
+#else
+static inline void recordMetric(uint8_t, uint32_t) {}
+static inline uint32_t traceBegin() { return 0; }
+static inline void traceEnd(uint8_t, uint32_t) {}
+#endif
+
+// 启动时测量一次 traceBegin/traceEnd 本身的开销
+void initializeMetrics();
+uint32_t traceOverheadNanos();
+
+const Histogram& metricHistogram(uint8_t metric);
+const char* metricName(uint8_t metric);
+bool metricInNanos(uint8_t metric);  // 否则单位为微秒
+
+// 直方图的分位数估计：所在桶的上界
+uint32_t metricQuantile(const Histogram& histogram, uint32_t perMille);
+
+// Prometheus 文本格式（秒）。容量按最坏情况推出：每个计数 10 位、和 20 位，名字和说明不超过下面的上限，
+// 设备运行再久也不会截断；加指标只需保证名字/说明在上限内
+#define METRIC_NAME_MAX 20
+#define METRIC_HELP_MAX 72
+#define METRIC_COUNT_DIGITS 10    // uint32
+#define METRIC_SECONDS_DIGITS 21  // uint64 写成定点秒：20 位 + 小数点
+#define METRIC_BOUND_DIGITS 11    // 桶上界 2^22-1 ns → "0.004194303"
+#define METRIC_LINE_PREFIX (5 + METRIC_NAME_MAX + 8)  // "ball_" 名字 "_seconds"
+#define METRIC_TEXT_MAX                                                                        \
+  (7 + METRIC_LINE_PREFIX + 1 + METRIC_HELP_MAX + 1 +                            /* # HELP */  \
+   7 + METRIC_LINE_PREFIX + 11 +                                                 /* # TYPE */  \
+   (METRIC_BUCKETS - 1) * (METRIC_LINE_PREFIX + 12 + METRIC_BOUND_DIGITS + 3 + METRIC_COUNT_DIGITS + 1) + \
+   METRIC_LINE_PREFIX + 19 + METRIC_COUNT_DIGITS + 1 +                           /* +Inf */    \
+   METRIC_LINE_PREFIX + 5 + METRIC_SECONDS_DIGITS + 1 +                          /* _sum */    \
+   METRIC_LINE_PREFIX + 7 + METRIC_COUNT_DIGITS + 1)                             /* _count */
+#define METRICS_TRAILER_MAX 192  // ball_trace_overhead_seconds
+#define METRICS_TEXT_CAPACITY (NUM_METRICS * METRIC_TEXT_MAX + METRICS_TRAILER_MAX + 1)
+void encodeMetricsText(TextWriter& out);
+
+// 单个指标的 MQTT 摘要：{"unit":"ns","count":..,"p50":..,"p99":..,"max":..}
+#define METRIC_SUMMARY_CAPACITY 96
+void encodeMetricSummary(TextWriter& out, uint8_t metric);
+
+// 发布回送：发布时登记 seq，收到自己订阅主题上的同一 seq 时记录 broker_echo
+void traceMQTTPublished(uint32_t seq, uint32_t publishMicros);
+void traceMQTTReceived(const uint8_t* payload, unsigned int length);
+
+#endif // METRICS_H
@@ -0,0 +1,76 @@
+#ifndef MPSC_QUEUE_H
+#define MPSC_QUEUE_H
+
+#include <stdint.h>
+#include <atomic>
+
+// ==================== 多生产者/单消费者无锁队列 ====================
+// 用于任意任务都可能写入、只有一个任务读取的场合（例如日志记录，见 log.h）。
+// 每个槽位带一个序号：生产者用 CAS 抢占写位置，就地写入后发布序号，消费者按序号判断槽位是否写完。
+// 生产者之间不互相等待（某个生产者在写入中途被抢占时，只有消费者暂时停在那个槽位上），
+// 队列满时立即返回 false，从不阻塞。不能在中断中使用（中断可能打断同一核上正在写入的生产者）。
+
+template <typename T, uint16_t N>
+class MpscQueue {
+  static_assert((N & (N - 1)) == 0, "MpscQueue 容量必须是2的幂");
+
+public:
+  MpscQueue() {
+    for (uint16_t i = 0; i < N; i++) {
+      slots_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  // 任意生产者调用：抢占一个槽位并用 fill(T&) 就地写入；队列满时返回 false，fill 不被调用
+  template <typename F>
+  bool push(F fill) {
+    uint32_t position = head_.load(std::memory_order_relaxed);
+    Slot* slot;
+    for (;;) {
+      slot = &slots_[position & (N - 1)];
+      int32_t lag = (int32_t)(slot->sequence.load(std::memory_order_acquire) - position);
+      if (lag == 0) {
+        if (head_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (lag < 0) {
+        return false;  // 槽位还没被消费者读走：队列满
+      } else {
+        position = head_.load(std::memory_order_relaxed);
+      }
+    }
+    fill(slot->item);
+    slot->sequence.store(position + 1, std::memory_order_release);
+    return true;
+  }
+
+  // 仅消费者调用；队列空（或最早的槽位仍在写入）时返回 false
+  bool pop(T& item) {
+    uint32_t position = tail_.load(std::memory_order_relaxed);
+    Slot& slot = slots_[position & (N - 1)];
+    if (slot.sequence.load(std::memory_order_acquire) != position + 1) {
+      return false;
+    }
+    item = slot.item;
+    slot.sequence.store(position + N, std::memory_order_release);
+    tail_.store(position + 1, std::memory_order_release);
+    return true;
+  }
+
+  // 近似值：生产者已抢占但可能尚未写完的槽位也计入
+  uint16_t size() const {
+    return (uint16_t)(head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire));
+  }
+
+private:
+  struct Slot {
+    std::atomic<uint32_t> sequence;
+    T item;
+  };
+
+  Slot slots_[N];
+  std::atomic<uint32_t> head_{0};
+  std::atomic<uint32_t> tail_{0};  // 只有消费者写入
+};
+
+#endif // MPSC_QUEUE_H
@@ -0,0 +1,90 @@
+#ifndef MQTT_COMMANDS_H
+#define MQTT_COMMANDS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "hal.h"
+#include "config.h"
+#include "text_writer.h"
+
+// ==================== MQTT 命令 ====================
+// 后台通过 MQTT 控制球。<prefix> 为 ball/<MQTT_DEVICE_ID>（单个球）或 ball/all（所有球）：
+//   <prefix>/cmd/mode        {"mode":"breathe_green"}                      | B1 <LEDMode> [亮度]
+//   <prefix>/cmd/color       {"color":[255,128,0],"color2":[0,0,0]}        | B1 r g b [r2 g2 b2]
+//   <prefix>/cmd/brightness  {"level":128}                                 | B1 <亮度>
+//   <prefix>/cmd/effect      {"effect":"chase","color":[..],"color2":[..],"period":1500}
+//                                                                          | B1 <EffectKind> r g b r2 g2 b2 <周期 LE16>
+//   <prefix>/cmd/reset       任意载荷：交还按钮规则
+//   <prefix>/cmd/state       任意载荷：在 <prefix>/state 发布 {"mode":..,"brightness":..,"remote":..,"buttons":{..}}
+// JSON 对象里的 mode/effect/color/color2/level/period 可以组合（例如 mode 同时带 level）。
+// 二进制载荷以 MQTT_COMMAND_BINARY 开头（0xB1 不能作为 UTF-8 文本的第一个字节，不会与 JSON 混淆）。
+// ball/rules、ball/trace 和其余订阅主题（自己发布的事件经服务器回送）也经同一张路由表分发。
+//
+// 分发在 PubSubClient 的回调里（网络任务）完成：主题由启动时编译的前缀树匹配（见 topic_trie.h），
+// 载荷就地解析（JsonReader 直接读接收缓冲区），结果作为定长 RemoteCommand 放入 SPSC 队列并唤醒渲染任务；
+// 回调里不渲染、不发布、不等待、不读写文件。渲染任务的输入作业在按钮逻辑之前取出命令并应用（见 main.cpp），
+// 远程设置的灯效保持到按钮状态变化或收到 reset；state 的回复和 ball/rules 的文件读写由 MQTT 客户端作业
+// 在回调返回后完成。两种编码的 mode 都接受内置模式和已登记的片段模式（validLEDMode()）。
+
+#define MQTT_COMMAND_BINARY 0xB1
+#define MQTT_COMMAND_QUEUE_SIZE 8     // 网络任务 → 渲染任务，必须是2的幂
+#define MQTT_COMMAND_TOPIC_CAPACITY 48
+#define MQTT_COMMAND_MIN_PERIOD 100   // effect 的动画周期范围（毫秒）
+#define MQTT_COMMAND_MAX_PERIOD 60000
+
+enum RemoteCommandOp : uint8_t {
+  REMOTE_LED,    // fields 指定的灯效字段
+  REMOTE_RESET,
+  REMOTE_STATE,
+};
+
+// RemoteCommand::fields
+#define REMOTE_FIELD_MODE   0x01
+#define REMOTE_FIELD_EFFECT 0x02
+#define REMOTE_FIELD_COLOR  0x04
+#define REMOTE_FIELD_COLOR2 0x08
+#define REMOTE_FIELD_LEVEL  0x10
+#define REMOTE_FIELD_PERIOD 0x20
+
+struct RemoteCommand {
+  uint32_t receivedMicros;  // 回调收到消息的时刻，用于 command_apply 指标
+  uint8_t op;               // RemoteCommandOp
+  uint8_t fields;           // REMOTE_FIELD_*
+  uint8_t mode;             // LEDMode
+  uint8_t effect;           // EffectKind
+  uint8_t level;
+  CRGB color;
+  CRGB color2;
+  uint16_t periodMillis;
+};
+
+struct MqttCommandStats {
+  uint32_t received;
+  uint32_t unmatched;   // 没有路由匹配（订阅之外的主题）
+  uint32_t invalid;     // 载荷无效
+  uint32_t dropped;     // 命令队列满
+  uint32_t replies;     // 已发布的 state 回复
+};
+
+// 网络任务
+void initializeMQTTCommands();  // 按 MQTT_DEVICE_ID 编译路由表
+const char* const* mqttCommandSubscriptions(uint8_t& count);
+void dispatchMQTTMessage(char* topic, uint8_t* payload, unsigned int length);  // halMQTTBegin() 的回调
+bool mqttCommandReplyPending();
+void applyMQTTRules();             // MQTT 客户端作业在 halMQTTLoop() 之后调用
+void publishMQTTCommandReplies();  // 同上
+
+// 只解析不投递：路由下标和命令，主机基准用
+#define MQTT_ROUTE_NONE 0xFF
+uint8_t matchMQTTRoute(const char* topic, size_t length);
+bool parseRemoteCommand(uint8_t route, const uint8_t* payload, size_t length, RemoteCommand& command);
+
+// 渲染任务
+bool mqttCommandsPending();
+bool takeRemoteCommand(RemoteCommand& command);
+void requestMQTTStateReply();  // 应用 REMOTE_STATE 时调用，状态快照已包含之前的命令
+
+const MqttCommandStats& mqttCommandStats();
+const char* mqttCommandPrefix();  // ball/<MQTT_DEVICE_ID>
+
+#endif // MQTT_COMMANDS_H
@@ -0,0 +1,39 @@
+#ifndef MQTT_MANAGER_H
+#define MQTT_MANAGER_H
+
+#include <stdint.h>
+
+// ==================== MQTT 连接状态机 ====================
+// 与 wifi_manager 同样的结构：网络任务的 MQTT 连接作业推进，连接完成事件立即唤醒它。
+//   WAIT_WIFI：  WiFi 未连接
+//   CONNECTING： TCP + CONNECT/CONNACK 在 HAL 后台进行（halMQTTConnectAsync），网络任务不阻塞
+//   CONNECTED：  连上后立即订阅；之后只检查是否掉线
+//   BACKOFF：    失败或掉线后按带抖动的指数退避等待
+// 服务器不可达（丢包）时连接要等到 MQTT_CONNECT_TIMEOUT 才失败，但这段时间只在后台消耗。
+
+enum MQTTState {
+  MQTT_STATE_WAIT_WIFI,
+  MQTT_STATE_CONNECTING,
+  MQTT_STATE_CONNECTED,
+  MQTT_STATE_BACKOFF
+};
+
+struct MQTTStats {
+  uint32_t connects;
+  uint32_t failures;
+  uint32_t drops;
+  uint32_t lastConnectMillis;  // 最近一次从发起到 CONNACK 的耗时
+  uint32_t lastBackoffMillis;
+};
+
+// topics 必须指向静态存储，连上后逐个订阅
+void initializeMQTTManager(const char* clientId, const char* const* topics, uint8_t topicCount);
+
+// 推进状态机，返回距离下一次需要检查的微秒数
+uint32_t updateMQTTManager(bool wifiConnected);
+
+bool mqttManagerConnected();
+MQTTState mqttManagerState();
+const MQTTStats& mqttStats();
+
+#endif // MQTT_MANAGER_H
@@ -0,0 +1,65 @@
+#ifndef MQTT_OUTBOX_H
+#define MQTT_OUTBOX_H
+
+#include <stdint.h>
+#include "text_writer.h"
+#include "tasks.h"
+
+// ==================== MQTT 待发事件 ====================
+// 渲染任务只投递事件编号和发生时刻（经 SPSC 队列），网络任务把它们放进这里的环形缓冲区：
+//   - 每个事件分配递增序号，发布时 payload 为 {"seq":..,"ts":..,"boot":..,"n":..,"lag":..}，
+//     ts 为事件发生时刻（开机毫秒数），lag 为发生到发布的毫秒数，n 为合并的事件数
+//   - 与缓冲区最新一条同主题的连续事件合并（计数加一），不改变其余事件的先后顺序
+//   - 断线期间保留，重连后按顺序分批重放；缓冲区满时丢弃最旧的一条
+//   - MQTT_OUTBOX_RETAIN 为 1 时缓冲区位于保留内存，软件复位后继续重放；
+//     boot 为复位计数，跨复位的事件 lag 无法计算，不带 lag 字段
+// 所有函数只在网络任务中调用。
+
+enum MQTTEvent {
+  MQTT_EVENT_FIRST_TRIGGERED,  // MQTT_TOPIC_FIRST_TRIGGERED
+  MQTT_EVENT_TRIGGERED,        // MQTT_TOPIC_SUB
+  MQTT_EVENT_RESET,            // MQTT_TOPIC_RESET
+  NUM_MQTT_EVENTS
+};
+
+struct OutboxEntry {
+  uint32_t seq;
+  uint32_t eventMillis;
+  uint32_t postMicros;  // 延迟追踪用，只在同一次启动内有意义
+  uint32_t edgeMicros;
+  uint16_t boot;
+  uint8_t event;    // MQTTEvent
+  uint8_t count;    // 合并的事件数
+};
+
+struct OutboxStats {
+  uint16_t depth;
+  uint16_t maxDepth;
+  uint32_t enqueued;
+  uint32_t coalesced;
+  uint32_t dropped;       // 缓冲区满丢弃的最旧事件
+  uint32_t published;
+  uint32_t restored;      // 启动时从保留内存恢复的事件
+  uint32_t lastLagMillis;
+  uint32_t maxLagMillis;
+};
+
+#define MQTT_EVENT_PAYLOAD_CAPACITY 72  // 5 个 uint32 字段
+
+const char* mqttEventTopic(uint8_t event);
+
+// 恢复保留内存中的缓冲区（校验失败则清空），复位计数加一
+void initializeMQTTOutbox();
+void mqttOutboxAdd(const OutboundMessage& message);
+
+// 最旧一条；发布成功后调用 mqttOutboxRelease()
+bool mqttOutboxPeek(OutboxEntry& entry);
+void mqttOutboxRelease(uint32_t publishMillis);
+bool mqttOutboxCurrentBoot(const OutboxEntry& entry);
+
+// 发布用的 JSON payload
+void encodeOutboxPayload(TextWriter& out, const OutboxEntry& entry, uint32_t nowMillis);
+
+const OutboxStats& mqttOutboxStats();
+
+#endif // MQTT_OUTBOX_H
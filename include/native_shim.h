@@ -0,0 +1,116 @@
+#ifndef NATIVE_SHIM_H
+#define NATIVE_SHIM_H
+
+// ==================== 主机构建用的 Arduino / FastLED 子集 ====================
+// 仅在 [env:native] 下使用，只提供 main.cpp 用到的类型和 Serial 接口，
+// 实际的时间、引脚和外设行为由 src/native/hal_native.cpp 模拟。
+
+#ifdef ARDUINO
+#error "native_shim.h 只能用于主机构建"
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+
+#define HIGH 1
+#define LOW 0
+#define INPUT_PULLUP 0x05
+#define IRAM_ATTR
+
+typedef uint8_t byte;
+
+// ==================== String ====================
+class String {
+public:
+  String() {}
+  String(const char* s) : str_(s ? s : "") {}
+  String(const std::string& s) : str_(s) {}
+  explicit String(int value) : str_(std::to_string(value)) {}
+  explicit String(unsigned int value) : str_(std::to_string(value)) {}
+  explicit String(long value) : str_(std::to_string(value)) {}
+  explicit String(unsigned long value) : str_(std::to_string(value)) {}
+  explicit String(uint8_t value) : str_(std::to_string(value)) {}
+
+  String& operator+=(const String& other) { str_ += other.str_; return *this; }
+  String& operator+=(const char* s) { str_ += s; return *this; }
+  String& operator+=(char c) { str_ += c; return *this; }
+
+  friend String operator+(const String& a, const String& b) { return String(a.str_ + b.str_); }
+  friend String operator+(const String& a, const char* b) { return String(a.str_ + b); }
+  friend String operator+(const char* a, const String& b) { return String(a + b.str_); }
+
+  const char* c_str() const { return str_.c_str(); }
+  unsigned int length() const { return (unsigned int)str_.size(); }
+
+private:
+  std::string str_;
+};
+
+// ==================== Serial ====================
+// 输出是否真正写到 stdout 由模拟层控制，基准测试时关闭以免干扰计时
+class NativeSerial {
+public:
+  void begin(unsigned long) {}
+  size_t print(const char* s);
+  size_t print(const String& s) { return print(s.c_str()); }
+  size_t print(char c);
+  size_t print(int value);
+  size_t print(unsigned int value);
+  size_t print(long value);
+  size_t print(unsigned long value);
+  size_t println();
+  template <typename T>
+  size_t println(const T& value) { size_t n = print(value); return n + println(); }
+  size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3)));
+  size_t write(uint8_t c);
+  size_t write(const uint8_t* data, size_t length);
+  int availableForWrite();
+};
+
+extern NativeSerial Serial;
+
+// ==================== FastLED 子集 ====================
+struct CRGB {
+  uint8_t r;
+  uint8_t g;
+  uint8_t b;
+
+  enum HTMLColorCode : uint32_t {
+    Black = 0x000000,
+    Red = 0xFF0000,
+    Green = 0x008000,
+    Yellow = 0xFFFF00
+  };
+
+  CRGB() : r(0), g(0), b(0) {}
+  CRGB(uint8_t red, uint8_t green, uint8_t blue) : r(red), g(green), b(blue) {}
+  CRGB(HTMLColorCode code)
+    : r((code >> 16) & 0xFF), g((code >> 8) & 0xFF), b(code & 0xFF) {}
+
+  bool operator==(const CRGB& o) const { return r == o.r && g == o.g && b == o.b; }
+  bool operator!=(const CRGB& o) const { return !(*this == o); }
+};
+
+// 线上字节顺序：三个八进制位依次为第 0/1/2 个字节取 r/g/b 中的哪一个
+enum EOrder {
+  RGB = 0012,
+  RBG = 0021,
+  GRB = 0102,
+  GBR = 0120,
+  BRG = 0201,
+  BGR = 0210
+};
+
+// i * scale / 256（scale = 255 时保持原值）
+inline uint8_t scale8(uint8_t i, uint8_t scale) {
+  return (uint8_t)(((uint16_t)i * (1 + (uint16_t)scale)) >> 8);
+}
+
+inline void fill_solid(CRGB* leds, int count, const CRGB& color) {
+  for (int i = 0; i < count; i++) {
+    leds[i] = color;
+  }
+}
+
+#endif // NATIVE_SHIM_H
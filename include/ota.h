@@ -0,0 +1,91 @@
+#ifndef OTA_H
+#define OTA_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "hal.h"
+#include "config.h"
+#include "sha256.h"
+#include "ed25519.h"
+#include "text_writer.h"
+
+// ==================== 固件更新流水线 ====================
+// POST /update 上传的文件是 OtaManifest + 固件镜像（主机工具 program --ota-sign 生成）。
+// 接收方（AsyncTCP 的上传回调）只做复制：镜像按顺序填入扇区环形缓冲区（sector_ring.h，与动画片段上传共用），
+// 填满一块就交给 flash 写入任务（TASK_OTA）。写入任务逐块累加 SHA-256，再经 halOTAWrite() 擦除、写入 flash，
+// 于是网络接收和 flash 擦写重叠进行。写入跟不上时缓冲区全满，接收方在回调里阻塞在写入任务给出的信号上
+// （最多 OTA_STALL_TIMEOUT，远小于任务看门狗），TCP 接收窗口随之收紧，不会无限缓存。
+//
+// 校验分两步：写入任务在写第一块之前用编译进固件的公钥（OTA_PUBLIC_KEY，见 config.h）验证清单的 Ed25519 签名，
+// 不通过就不碰 flash；镜像写完后 SHA-256 与清单一致才调用 halOTAEnd() 切换启动分区，否则放弃，原固件不受影响。
+// 私钥只在签名的电脑上，固件和仓库里都只有公钥。
+// 切换后写入任务在 OTA_REBOOT_DELAY 后重启，HTTP 和 WebSocket 回调都不等待。
+// 网络任务在开始、结束时立即、进行中每 OTA_PROGRESS_INTERVAL 向 WebSocket 广播进度 {"ota":{...}}
+// （WS_CLASS_PROGRESS，客户端跟不上时新者覆盖）。
+//
+// 同一时刻只有一个上传：接收方的函数只由 Web 服务器的上传回调调用，Web 服务器负责只转发当前上传的数据；
+// 动画片段正在上传时 otaBegin() 也返回 false。
+
+#define OTA_MANIFEST_VERSION 2
+#define OTA_STATUS_JSON_CAPACITY 320  // 状态名、8 个 uint32 字段和失败原因
+
+struct OtaManifest {
+  char magic[4];                          // "BOTA"
+  uint8_t version;
+  uint8_t reserved[3];
+  uint32_t imageSize;                     // 小端，紧跟清单的镜像字节数
+  uint8_t sha256[SHA256_DIGEST_SIZE];     // 镜像的 SHA-256
+  uint8_t signature[ED25519_SIGNATURE_SIZE];  // 私钥对以上 44 字节的 Ed25519 签名
+};
+
+#define OTA_MANIFEST_SIGNED_BYTES offsetof(OtaManifest, signature)
+static_assert(sizeof(OtaManifest) == 108 && OTA_MANIFEST_SIGNED_BYTES == 44, "清单布局");
+
+enum OtaState : uint8_t {
+  OTA_IDLE,
+  OTA_RECEIVING,  // 接收和写入同时进行
+  OTA_WRITING,    // 已收完，写入任务还在写最后几块、校验
+  OTA_REBOOTING,  // 已切换启动分区，OTA_REBOOT_DELAY 后重启
+  OTA_FAILED      // 原因见 OtaStatus::error，可以重新上传
+};
+
+struct OtaStatus {
+  OtaState state;
+  const char* error;       // OTA_FAILED 时的原因（常量字符串），否则为 nullptr
+  uint32_t total;          // 镜像字节数（不含清单），清单收齐前为 0
+  uint32_t received;
+  uint32_t written;        // 已写入 flash
+  uint32_t elapsedMillis;  // 从开始上传到现在，结束后为总用时
+  uint32_t stalls;         // 缓冲区全满、接收方等待写入任务的次数
+  uint32_t stallMillis;
+  uint32_t failures;       // 启动以来失败的更新
+};
+
+void initializeOTA();  // 空闲、无失败原因、计数清零
+
+#ifndef ARDUINO
+// 主机测试：换成测试密钥对的公钥，nullptr 相当于构建时没有给出 OTA_PUBLIC_KEY。在上传开始之前调用
+void otaSetPublicKey(const uint8_t* publicKey);
+#endif
+
+// ==================== 接收（AsyncTCP 任务） ====================
+bool otaBegin(const char* filename);                // 正在更新、等待重启或缓冲区被片段上传占用时返回 false
+bool otaReceive(const uint8_t* data, size_t length);  // 按顺序给出上传的全部字节；失败后返回 false
+bool otaReceiveDone();   // 上传结束：长度不符时失败；返回 false 表示本次更新已失败
+void otaAbort();         // 连接断开等：放弃本次更新（已收完的更新不受影响）
+const char* otaUploadError();  // 本次更新失败的原因，没有失败时为 nullptr
+
+// ==================== 写入任务（TASK_OTA） ====================
+// 写完环形缓冲区中已填满的块；没有工作时等通知，等待重启时返回距重启的微秒数
+uint32_t runOTATask();
+
+// ==================== 状态（任意任务） ====================
+OtaStatus otaStatus();
+bool otaBusy();  // 接收、写入或等待重启中，低功耗不让芯片睡眠
+void encodeOTAStatusJSON(TextWriter& out);  // GET /api/ota 与 WebSocket 进度帧的 "ota" 对象
+
+// 网络任务：开始、结束、失败时需要立即广播；JOB_OTA 的作业函数
+bool otaProgressPending();
+void publishOTAProgress();
+
+#endif // OTA_H
@@ -0,0 +1,105 @@
+#ifndef POWER_H
+#define POWER_H
+
+#include <stdint.h>
+#include "config.h"
+#include "text_writer.h"
+#include "effects.h"
+
+// ==================== 低功耗空闲 ====================
+// 电池供电的球大部分时间没人碰，但默认的红色呼吸仍然每秒唤醒 CPU 上百次。开启 POWER_SAVE_ENABLED 后：
+//   - 空闲：按钮（含抖动）POWER_IDLE_AFTER 毫秒没有变化。空闲时 LED 作业的帧周期不短于 POWER_IDLE_FRAME_INTERVAL，
+//     输入兜底轮询改为 POWER_IDLE_INPUT_POLL_INTERVAL，MQTT 客户端作业和日志作业也放慢；任一按钮边沿立即退出空闲
+//   - 浅睡眠：空闲、WiFi 未连接且两个任务都没有挂起的工作时，渲染任务让芯片浅睡眠到两个调度器中较早的截止时间
+//     （即下一帧动画、下一次网络作业）之前 POWER_WAKE_MARGIN_US，最多 POWER_MAX_SLEEP 毫秒；
+//     任一按钮电平变化时由 GPIO 唤醒。睡眠期间按钮中断关闭，醒来后按输入寄存器重新同步
+//   - WiFi 已连接时不浅睡眠：手动浅睡眠关闭射频、不与 AP 协商省电，会漏掉信标被断开，MQTT 保活也会超时，
+//     反复重连比睡眠省下的更耗电。空闲时改为 modem sleep 按监听间隔醒来（halWiFiSetPowerSave()），
+//     浅睡眠只在 AP 不可用、WiFi 退避等待时进行
+//   - 保持唤醒：消抖未稳定或有未处理的按钮事件、灯带在发送、有待发的 MQTT 事件或录制数据、
+//     WiFi/MQTT 正在连接、WiFi 已连接、固件更新进行中或等待重启、有 WebSocket 客户端，或可睡的时间短于 POWER_MIN_SLEEP_US
+// 睡眠决策 decidePowerSleep() 是纯函数；主机上 --power 在虚拟时钟下运行整个系统验证它。
+//
+// 线程：空闲状态由渲染任务写；网络任务在 updateNetworkPower() 里登记自己的下一个截止时间和是否必须保持唤醒。
+// ESP32 上浅睡眠期间 FreeRTOS 节拍不前进，醒来后截止时间已到的网络任务由渲染任务通知。
+
+enum PowerWakeCause : uint8_t {
+  POWER_WAKE_TIMER,   // 下一个截止时间
+  POWER_WAKE_BUTTON,  // 按钮电平变化
+  POWER_WAKE_OTHER,   // 睡眠被拒绝等
+  NUM_POWER_WAKE_CAUSES
+};
+
+// 一次决策的结果：POWER_SLEEP 或保持唤醒的原因
+enum PowerBlocker : uint8_t {
+  POWER_SLEEP,
+  POWER_BLOCK_DISABLED,
+  POWER_BLOCK_ACTIVE,    // 尚未空闲
+  POWER_BLOCK_INPUT,     // 消抖窗口内或有未处理的按钮事件、规则更新、MQTT 命令、录制命令
+  POWER_BLOCK_LED,       // 灯带在发送或有挂起的帧
+  POWER_BLOCK_NETWORK,   // 有待发的工作，WiFi/MQTT 正在连接，或固件更新进行中
+  POWER_BLOCK_LINK,      // WiFi 已连接（改用 modem sleep）
+  POWER_BLOCK_VIEWERS,   // 有 WebSocket 客户端
+  POWER_BLOCK_SHORT,     // 离下一个截止时间太近
+  NUM_POWER_BLOCKERS
+};
+
+struct PowerInputs {
+  bool enabled;
+  bool idle;
+  bool inputBusy;
+  bool ledBusy;
+  bool networkBusy;
+  bool linkUp;
+  bool viewers;
+  uint32_t renderWaitMicros;   // 距渲染任务下一个截止时间
+  uint32_t networkWaitMicros;  // 距网络任务下一个截止时间
+};
+
+struct PowerDecision {
+  uint8_t blocker;        // PowerBlocker
+  uint32_t sleepMicros;   // POWER_SLEEP 时的睡眠时长
+};
+
+struct PowerStats {
+  uint32_t idleEntries;
+  uint32_t sleeps;
+  uint32_t wakes[NUM_POWER_WAKE_CAUSES];
+  uint32_t decisions[NUM_POWER_BLOCKERS];  // 每次 powerSleep() 的决策
+  uint64_t awakeMicros;                    // 开启后醒着的时间（含等待截止时间但没有睡眠）
+  uint64_t sleptMicros;
+};
+
+PowerDecision decidePowerSleep(const PowerInputs& in);
+
+void initializePower();
+void setPowerSaveEnabled(bool enabled);  // 任意任务；启动时为 POWER_SAVE_ENABLED
+bool powerSaveEnabled();
+bool powerIdle();
+
+// 渲染任务
+// 输入作业每次运行时调用，inputActive 为本轮有按钮边沿或消抖未稳定；进入/退出空闲时调整渲染作业周期
+void updatePowerState(bool inputActive);
+uint32_t ledFramePeriodMicros(const Effect& effect);  // 灯效的帧周期，空闲时不短于 POWER_IDLE_FRAME_INTERVAL
+void notePowerFrame();                        // LED 作业每帧调用：记录唤醒 → 第一帧的延迟
+// runRenderTask() 的最后一步：条件满足时浅睡眠并返回 0（调用方重新运行调度器），否则原样返回 waitMicros
+uint32_t powerSleep(uint32_t waitMicros, bool networkWorkPosted);
+
+// 网络任务：runNetworkTask() 的最后一步，按空闲状态调整网络作业周期并登记下一个截止时间，返回仍需等待的微秒数
+uint32_t updateNetworkPower(uint32_t waitMicros);
+
+// 任意任务：渲染任务经 Seqlock 发布的快照，读到的各字段属于同一时刻。睡眠和决策变化时立即发布，
+// 否则最多每 POWER_STATS_PUBLISH_INTERVAL 发布一次
+PowerStats powerStats();
+uint32_t powerAwakePermille();  // 醒着的时间占比，未开启时为 1000
+const char* powerBlockerName(uint8_t blocker);
+const char* powerWakeCauseName(uint8_t cause);
+
+// MQTT 摘要：{"idle":..,"awake":..(‰),"sleeps":..,"timer":..,"button":..,"other":..}
+#define POWER_SUMMARY_CAPACITY 128
+void encodePowerSummary(TextWriter& out);
+// Prometheus 文本格式的最坏情况（20 位的时间、10 位的次数），由 power.cpp 中的 static_assert 按实际文本校验
+#define POWER_TEXT_CAPACITY 640
+void encodePowerText(TextWriter& out);  // Prometheus 文本格式，接在 encodeMetricsText() 之后
+
+#endif // POWER_H
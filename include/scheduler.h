@@ -0,0 +1,66 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <stdint.h>
+
+// ==================== 截止时间协作式调度器 ====================
+// 每个任务（渲染/网络）一个调度器。周期性工作注册为作业，按截止时间保存在最小堆中；
+// runDue() 依次运行所有到期作业并返回距离下一个截止时间的微秒数，
+// 调用方据此休眠，直到截止时间或被输入事件唤醒。
+// 作业开始运行时距截止时间的延迟超过 toleranceMicros 记为一次截止时间错过。
+
+#define SCHEDULER_MAX_JOBS 12
+
+typedef void (*JobFunction)();
+
+struct JobSpec {
+  const char* name;
+  JobFunction run;
+  uint32_t periodMicros;
+  uint32_t toleranceMicros;
+};
+
+struct Job {
+  const char* name;
+  JobFunction run;
+  uint32_t periodMicros;
+  uint32_t toleranceMicros;
+  uint32_t deadlineMicros;
+  uint32_t runs;
+  uint32_t misses;
+  uint32_t maxLatenessMicros;
+  uint8_t heapIndex;
+};
+
+// 作业运行前后的观察者（基准测试和性能追踪用），finished 为 false 表示即将运行
+typedef void (*JobObserver)(const Job& job, bool finished);
+
+class Scheduler {
+public:
+  void begin(const JobSpec* specs, uint8_t count);
+
+  // 运行所有到期作业，返回距离下一个截止时间的微秒数（0 表示已有作业到期）
+  uint32_t runDue();
+  uint32_t microsUntilNext() const;
+
+  void runNow(uint8_t job);
+  void scheduleAt(uint8_t job, uint32_t deadlineMicros);
+  void setPeriod(uint8_t job, uint32_t periodMicros);
+
+  uint8_t jobCount() const { return count_; }
+  const Job& job(uint8_t index) const { return jobs_[index]; }
+
+  static void setObserver(JobObserver observer);
+
+private:
+  void siftUp(uint8_t position);
+  void siftDown(uint8_t position);
+  void swap(uint8_t a, uint8_t b);
+  bool earlier(uint8_t a, uint8_t b) const;
+
+  Job jobs_[SCHEDULER_MAX_JOBS];
+  uint8_t heap_[SCHEDULER_MAX_JOBS];  // 作业下标，按截止时间排列的最小堆
+  uint8_t count_ = 0;
+};
+
+#endif // SCHEDULER_H
@@ -0,0 +1,67 @@
+#ifndef SECTOR_RING_H
+#define SECTOR_RING_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+#include "hal.h"
+#include "config.h"
+
+// ==================== 扇区环形缓冲区 ====================
+// 上传回调（AsyncTCP 任务）→ flash 写入任务（TASK_OTA）的数据通道：OTA_BUFFER_COUNT 个扇区大小的块，
+// 固件更新（ota.h）和动画片段上传（clips.h）共用一份，同一时刻只属于一个上传（acquire 到 release）。
+// 接收方按顺序追加字节，填满一块（或 flush() 交出最后不满的一块）就通知写入任务；写入任务写完一块后 pop()，
+// 给出 SIGNAL_OTA_BLOCK。缓冲区全满时接收方在回调里阻塞在这个信号上，最多 OTA_STALL_TIMEOUT（远小于任务看门狗），
+// TCP 接收窗口随之收紧，不会无限缓存。
+// 第 k 块放在 blocks_[k % OTA_BUFFER_COUNT]；接收方只写 filled_ 之后的块，写入任务只读之前的块。
+// 接收方的函数都在 AsyncTCP 任务里调用，一个接收方阻塞时不会有别的上传 acquire。
+
+enum SectorRingOwner : uint8_t {
+  RING_FREE,
+  RING_OTA,
+  RING_CLIPS
+};
+
+enum SectorRingResult : uint8_t {
+  RING_OK,
+  RING_STOPPED,  // 写入任务已经放弃本次上传
+  RING_TIMEOUT   // 等待空块超过 OTA_STALL_TIMEOUT
+};
+
+class SectorRing {
+public:
+  // ---- 接收方 ----
+  // 开始一次上传：清空缓冲区和等待统计。被另一个上传持有时返回 false
+  bool acquire(uint8_t owner);
+  SectorRingResult append(const uint8_t* data, size_t length);
+  void flush();  // 交出正在填的块（最后一块不满一个扇区）
+  uint32_t stalls() const { return stalls_.load(std::memory_order_relaxed); }
+  uint32_t stallMillis() const { return stallMillis_.load(std::memory_order_relaxed); }
+
+  // ---- 写入任务 ----
+  bool front(const uint8_t*& data, size_t& length) const;  // 最早交出、还没写完的块
+  void pop();
+  bool empty() const;
+  void stop();     // 放弃本次上传：等待中的接收方立即返回 RING_STOPPED
+  void release();  // 不再读取任何块之后，缓冲区可以给下一个上传；启动时持有者也用它放掉上一次的上传
+
+  // ---- 任意任务 ----
+  uint8_t owner() const { return owner_.load(std::memory_order_acquire); }
+
+private:
+  bool waitForBlock(uint32_t filled);
+
+  uint8_t blocks_[OTA_BUFFER_COUNT][HAL_FLASH_SECTOR_SIZE];
+  uint16_t blockLength_[OTA_BUFFER_COUNT];
+  size_t fillLength_ = 0;                  // 仅接收方：正在填的块（filled_ 那一块）已有的字节
+  std::atomic<uint32_t> filled_{0};        // 仅接收方写（清零除外）
+  std::atomic<uint32_t> written_{0};       // 仅写入任务写（清零除外）
+  std::atomic<bool> stopped_{false};
+  std::atomic<uint8_t> owner_{RING_FREE};
+  std::atomic<uint32_t> stalls_{0};
+  std::atomic<uint32_t> stallMillis_{0};
+};
+
+extern SectorRing flashRing;
+
+#endif // SECTOR_RING_H
@@ -0,0 +1,63 @@
+#ifndef SEQLOCK_H
+#define SEQLOCK_H
+
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+#include <type_traits>
+
+// ==================== 顺序锁快照 ====================
+// 单写者、多读者。写者从不阻塞；读者在写入进行中或读取期间被改写时重试。
+// 数据按 32 位原子字保存，读写都不存在 C++ 意义上的数据竞争。
+
+template <typename T>
+class Seqlock {
+  static_assert(std::is_trivially_copyable<T>::value, "Seqlock 只能保存可平凡复制的类型");
+
+public:
+  // 仅写者调用
+  void write(const T& value) {
+    uint32_t buffer[WORDS] = {};
+    memcpy(buffer, &value, sizeof(T));
+
+    uint32_t seq = seq_.load(std::memory_order_relaxed);
+    seq_.store(seq + 1, std::memory_order_relaxed);  // 奇数：写入中
+    std::atomic_thread_fence(std::memory_order_release);
+    for (size_t i = 0; i < WORDS; i++) {
+      words_[i].store(buffer[i], std::memory_order_relaxed);
+    }
+    seq_.store(seq + 2, std::memory_order_release);
+  }
+
+  // 当前版本号，每次 write() 加 2；用于廉价地判断内容是否变化
+  uint32_t version() const {
+    return seq_.load(std::memory_order_acquire);
+  }
+
+  // 任意任务调用，返回读取时的版本号
+  uint32_t read(T& out) const {
+    uint32_t buffer[WORDS];
+    for (;;) {
+      uint32_t before = seq_.load(std::memory_order_acquire);
+      if (before & 1) {
+        continue;
+      }
+      for (size_t i = 0; i < WORDS; i++) {
+        buffer[i] = words_[i].load(std::memory_order_relaxed);
+      }
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (seq_.load(std::memory_order_relaxed) == before) {
+        memcpy(&out, buffer, sizeof(T));
+        return before;
+      }
+    }
+  }
+
+private:
+  static const size_t WORDS = (sizeof(T) + 3) / 4;
+
+  std::atomic<uint32_t> seq_{0};
+  std::atomic<uint32_t> words_[WORDS] = {};
+};
+
+#endif // SEQLOCK_H
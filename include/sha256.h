@@ -0,0 +1,69 @@
+#ifndef SHA256_H
+#define SHA256_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// ==================== SHA-256 ====================
+// 增量计算，供 OTA 流水线逐扇区累加固件摘要（见 ota.h）。
+//   - ESP32：mbedtls（ESP-IDF 里走硬件 SHA 加速）
+//   - 主机：src/native/sha256_soft.h，program --ota-sign 也用它生成清单
+
+#ifdef ARDUINO
+#include "mbedtls/sha256.h"
+#include "mbedtls/version.h"
+
+#define SHA256_DIGEST_SIZE 32
+
+class Sha256 {
+public:
+  Sha256() {
+    mbedtls_sha256_init(&ctx_);
+    reset();
+  }
+  ~Sha256() { mbedtls_sha256_free(&ctx_); }
+  Sha256(const Sha256&) = delete;
+  Sha256& operator=(const Sha256&) = delete;
+
+  void reset() {
+#if MBEDTLS_VERSION_MAJOR >= 3
+    mbedtls_sha256_starts(&ctx_, 0);
+#else
+    mbedtls_sha256_starts_ret(&ctx_, 0);
+#endif
+  }
+
+  void update(const uint8_t* data, size_t length) {
+#if MBEDTLS_VERSION_MAJOR >= 3
+    mbedtls_sha256_update(&ctx_, data, length);
+#else
+    mbedtls_sha256_update_ret(&ctx_, data, length);
+#endif
+  }
+
+  // 之后需要 reset() 才能重新使用
+  void finish(uint8_t digest[SHA256_DIGEST_SIZE]) {
+#if MBEDTLS_VERSION_MAJOR >= 3
+    mbedtls_sha256_finish(&ctx_, digest);
+#else
+    mbedtls_sha256_finish_ret(&ctx_, digest);
+#endif
+  }
+
+private:
+  mbedtls_sha256_context ctx_;
+};
+#else
+#include "sha256_soft.h"
+#endif
+
+// 比较摘要/签名，耗时与第一个不同字节的位置无关
+inline bool digestEqual(const uint8_t* a, const uint8_t* b, size_t length) {
+  uint8_t diff = 0;
+  for (size_t i = 0; i < length; i++) {
+    diff |= a[i] ^ b[i];
+  }
+  return diff == 0;
+}
+
+#endif // SHA256_H
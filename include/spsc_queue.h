@@ -0,0 +1,50 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <stdint.h>
+#include <atomic>
+
+// ==================== 单生产者/单消费者无锁队列 ====================
+// 用于任务之间传递消息（例如渲染任务 → 网络任务）。
+// 中断里使用的按钮边沿队列需要放在 IRAM，见 button_events.cpp。
+
+template <typename T, uint16_t N>
+class SpscQueue {
+  static_assert((N & (N - 1)) == 0, "SpscQueue 容量必须是2的幂");
+
+public:
+  // 仅生产者调用；队列满时返回 false
+  bool push(const T& item) {
+    uint16_t h = head_.load(std::memory_order_relaxed);
+    uint16_t t = tail_.load(std::memory_order_acquire);
+    if ((uint16_t)(h - t) >= N) {
+      return false;
+    }
+    items_[h & (N - 1)] = item;
+    head_.store((uint16_t)(h + 1), std::memory_order_release);
+    return true;
+  }
+
+  // 仅消费者调用；队列空时返回 false
+  bool pop(T& item) {
+    uint16_t t = tail_.load(std::memory_order_relaxed);
+    uint16_t h = head_.load(std::memory_order_acquire);
+    if (t == h) {
+      return false;
+    }
+    item = items_[t & (N - 1)];
+    tail_.store((uint16_t)(t + 1), std::memory_order_release);
+    return true;
+  }
+
+  uint16_t size() const {
+    return (uint16_t)(head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire));
+  }
+
+private:
+  T items_[N];
+  std::atomic<uint16_t> head_{0};
+  std::atomic<uint16_t> tail_{0};
+};
+
+#endif // SPSC_QUEUE_H
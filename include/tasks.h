@@ -0,0 +1,112 @@
+#ifndef TASKS_H
+#define TASKS_H
+
+#include <stdint.h>
+#include "scheduler.h"
+#include "hal.h"
+
+// ==================== 双核任务划分 ====================
+// 渲染任务（RENDER_TASK_CORE）：按钮采样、按钮逻辑、LED渲染
+// 网络任务（NETWORK_TASK_CORE）：MQTT、WebSocket；HTTP 请求由 AsyncTCP 自己的任务处理
+// flash 写入任务（OTA_TASK_CORE）：把上传回调收到的固件、动画片段块写入 flash，见 sector_ring.h
+// 每个任务由一个截止时间调度器驱动，休眠到下一个截止时间或被事件唤醒：
+//   渲染任务：按钮中断、按钮规则更新、MQTT 命令、输入录制开始/停止、LED 帧发送完成、低功耗开关
+//   网络任务：渲染任务投递 MQTT 消息或状态回复、状态快照变化、WiFi 事件、日志缓冲区过半、WebSocket 客户端连接/积压、输入录制写满一块、
+//             OTA 更新开始/结束、进入/退出空闲、浅睡眠醒来时截止时间已到
+// 两个任务之间不共享可写全局变量：
+//   渲染 → 网络/HTTP：状态快照（Seqlock，多读者）
+//   渲染 → 网络/HTTP：低功耗统计（Seqlock，见 power.h）
+//   渲染 → 网络：MQTT 事件（SPSC 队列，网络任务再放入 mqtt_outbox 的环形缓冲区）
+//   网络 → 渲染：MQTT 命令（SPSC 队列，见 mqtt_commands.h）
+// 空闲时渲染任务在两个任务都没有工作时让芯片浅睡眠，见 power.h。
+// 主机构建中同一套代码运行在 std::thread 上，见 main_native.cpp 的 --stress。
+
+enum TaskId {
+  TASK_RENDER = 1,   // HAL_MAIN_TASK 为 0
+  TASK_NETWORK = 2,
+  TASK_OTA = 3       // flash 写入（ota.h、clips.h），只在上传期间有工作
+};
+
+// halSignalTake() 的信号，等待方不是 HAL 任务
+enum SignalId {
+  SIGNAL_OTA_BLOCK = 0,  // 写入任务 → 上传回调：空出一块缓冲区或写入失败
+  NUM_SIGNALS
+};
+
+static_assert(NUM_SIGNALS <= HAL_MAX_SIGNALS, "信号超过 HAL_MAX_SIGNALS");
+
+// 作业下标，与 main.cpp 中 RENDER_JOBS / NETWORK_JOBS 的顺序一致
+enum RenderJob {
+  JOB_INPUT,
+  JOB_LED,
+  JOB_STATUS,
+  NUM_RENDER_JOBS
+};
+
+enum NetworkJob {
+  JOB_WIFI,
+  JOB_MQTT,
+  JOB_MQTT_CONNECT,
+  JOB_WEBSOCKET,
+  JOB_WS_CLIENTS,
+  JOB_METRICS,
+  JOB_LOG,
+  JOB_TRACE,
+  JOB_OTA,
+  NUM_NETWORK_JOBS
+};
+
+static_assert(NUM_RENDER_JOBS <= SCHEDULER_MAX_JOBS && NUM_NETWORK_JOBS <= SCHEDULER_MAX_JOBS,
+              "调度器容量不足，多出的作业会被忽略");
+
+struct BallSnapshot {
+  uint32_t pressed;         // 消抖后按下的按钮掩码
+  uint32_t updatedMillis;   // 快照生成时间
+  uint8_t ledMode;          // LEDMode
+  uint8_t greenBreathBrightness;
+  uint8_t remote;           // 灯效由 MQTT 命令接管（见 mqtt_commands.h）
+  uint8_t reserved;
+};
+
+struct OutboundMessage {
+  uint32_t eventMillis;  // 事件发生时刻
+  uint32_t postMicros;   // 投递时刻，与下一项一起用于延迟追踪（见 metrics.h）
+  uint32_t edgeMicros;   // 触发事件的按钮边沿时刻
+  uint8_t event;         // MQTTEvent，见 mqtt_outbox.h
+};
+
+struct TaskStats {
+  uint32_t snapshotsPublished;
+  uint32_t messagesPosted;
+  uint32_t messagesDropped;  // 待发队列满而丢弃
+};
+
+extern Scheduler renderScheduler;
+extern Scheduler networkScheduler;
+
+void initializeTasks();
+void startTasks();
+
+// 运行各自调度器中到期的作业，返回距离下一个截止时间的微秒数（渲染任务浅睡眠过时返回 0）
+uint32_t runRenderTask();
+uint32_t runNetworkTask();
+uint32_t runFlashTask();  // 固件更新和片段上传共用缓冲区，同一时刻只有一个有工作
+
+// 渲染侧
+// 只在按钮/LED 状态变化时写入快照并唤醒网络任务
+void publishStateSnapshot();
+bool postMQTTEvent(uint8_t event, uint32_t edgeMicros);
+
+// 网络/HTTP 侧
+uint32_t readStateSnapshot(BallSnapshot& snapshot);
+uint32_t stateSnapshotVersion();
+bool takeMQTTMessage(OutboundMessage& message);
+
+// 任意任务（AsyncTCP 回调）请求网络任务立即推送一次完整状态
+void requestStateKeyframe();
+bool takeStateKeyframeRequest();
+bool stateKeyframeRequested();
+
+const TaskStats& taskStats();
+
+#endif // TASKS_H
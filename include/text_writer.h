@@ -0,0 +1,124 @@
+#ifndef TEXT_WRITER_H
+#define TEXT_WRITER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+// ==================== 定长文本/JSON 写入器 ====================
+// 写入调用方提供的缓冲区（通常在栈上），不做任何堆分配，供所有 JSON/文本响应使用。
+// 超出容量时截断并置 overflowed()，缓冲区始终以 '\0' 结尾。
+// 各响应的容量在声明处用编译期常量给出，见 ws_protocol.h。
+
+class TextWriter {
+public:
+  TextWriter(char* buffer, size_t capacity) : buffer_(buffer), capacity_(capacity) {
+    buffer_[0] = '\0';
+  }
+
+  TextWriter& raw(const char* text) {
+    return raw(text, strlen(text));
+  }
+
+  TextWriter& raw(const char* text, size_t length) {
+    size_t room = capacity_ - 1 - length_;
+    if (length > room) {
+      length = room;
+      overflowed_ = true;
+    }
+    memcpy(buffer_ + length_, text, length);
+    length_ += length;
+    buffer_[length_] = '\0';
+    return *this;
+  }
+
+  TextWriter& put(char c) {
+    return raw(&c, 1);
+  }
+
+  TextWriter& u32(uint32_t value) {
+    return u64(value);
+  }
+
+  TextWriter& u64(uint64_t value) {
+    char digits[20];
+    size_t n = 0;
+    do {
+      digits[n++] = (char)('0' + value % 10);
+      value /= 10;
+    } while (value);
+    char text[20];
+    for (size_t i = 0; i < n; i++) {
+      text[i] = digits[n - 1 - i];
+    }
+    return raw(text, n);
+  }
+
+  // 定点小数：value / 10^fractionDigits，例如 fixed(1500, 3) 写出 "1.500"
+  TextWriter& fixed(uint64_t value, uint8_t fractionDigits) {
+    uint64_t scale = 1;
+    for (uint8_t i = 0; i < fractionDigits; i++) {
+      scale *= 10;
+    }
+    u64(value / scale);
+    if (fractionDigits == 0) {
+      return *this;
+    }
+    put('.');
+    uint64_t fraction = value % scale;
+    for (uint64_t digit = scale / 10; digit > 0; digit /= 10) {
+      put((char)('0' + (fraction / digit) % 10));
+    }
+    return *this;
+  }
+
+  TextWriter& i32(int32_t value) {
+    if (value < 0) {
+      put('-');
+      return u32(0u - (uint32_t)value);
+    }
+    return u32((uint32_t)value);
+  }
+
+  TextWriter& boolean(bool value) {
+    return value ? raw("true", 4) : raw("false", 5);
+  }
+
+  // JSON 辅助：key 不做转义，只用于固件内部的常量键名
+  TextWriter& beginObject() { first_ = true; return put('{'); }
+  TextWriter& endObject() { return put('}'); }
+
+  TextWriter& key(const char* name) {
+    if (!first_) put(',');
+    first_ = false;
+    return put('"').raw(name).raw("\":", 2);
+  }
+
+  TextWriter& field(const char* name, uint32_t value) { return key(name).u32(value); }
+  TextWriter& flag(const char* name, bool value) { return key(name).boolean(value); }
+
+  const char* c_str() const { return buffer_; }
+  size_t length() const { return length_; }
+  bool overflowed() const { return overflowed_; }
+
+private:
+  char* buffer_;
+  size_t capacity_;
+  size_t length_ = 0;
+  bool overflowed_ = false;
+  bool first_ = true;
+};
+
+// 自带存储的写入器，N 为包含 '\0' 的容量
+template <size_t N>
+class FixedTextWriter : public TextWriter {
+  static_assert(N > 0, "FixedTextWriter 容量必须大于0");
+
+public:
+  FixedTextWriter() : TextWriter(storage_, N) {}
+
+private:
+  char storage_[N];
+};
+
+#endif // TEXT_WRITER_H
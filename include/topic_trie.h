@@ -0,0 +1,184 @@
+#ifndef TOPIC_TRIE_H
+#define TOPIC_TRIE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+// ==================== MQTT 主题前缀树 ====================
+// 启动时把主题过滤器编译成定长节点表，收到消息时直接在客户端接收缓冲区里逐层匹配主题：
+// 不复制主题、不分配内存，每一层只比较同一父节点下的子节点（先比长度再 memcmp）。
+// 过滤器语法与 MQTT 订阅相同：层级以 '/' 分隔，'+' 匹配恰好一层，末尾的 '#' 匹配剩余的零层或多层。
+// 多个过滤器都匹配时取最具体的：同一层字面值优先于 '+'，'+' 优先于 '#'，较具体的分支匹配失败时回溯。
+// 递归深度不超过树的深度（由插入的过滤器决定），与收到的主题有多少层无关。
+// 容量是模板参数；插入失败（容量不足、格式错误、同一过滤器重复）时返回 false，树保持插入前的匹配结果。
+
+#define TOPIC_TRIE_NONE 0xFF
+
+template <uint8_t MaxNodes, uint16_t TextCapacity>
+class TopicTrie {
+  static_assert(MaxNodes >= 2 && MaxNodes < TOPIC_TRIE_NONE, "TopicTrie 节点数");
+
+public:
+  TopicTrie() { clear(); }
+
+  void clear() {
+    nodes_[0] = Node{0, 0, 0, 0, 0, TOPIC_TRIE_NONE, TOPIC_TRIE_NONE};
+    nodeCount_ = 1;
+    textLength_ = 0;
+  }
+
+  // value 不能是 TOPIC_TRIE_NONE
+  bool insert(const char* filter, uint8_t value) {
+    if (value == TOPIC_TRIE_NONE) {
+      return false;
+    }
+    uint8_t node = 0;
+    const char* level = filter;
+    for (;;) {
+      const char* slash = strchr(level, '/');
+      size_t n = slash ? (size_t)(slash - level) : strlen(level);
+      if (n == 1 && level[0] == '#') {
+        if (slash || nodes_[node].hashValue != TOPIC_TRIE_NONE) {
+          return false;  // '#' 只能是最后一层
+        }
+        nodes_[node].hashValue = value;
+        return true;
+      }
+      if (memchr(level, '+', n) && n != 1) {
+        return false;  // '+' 必须独占一层
+      }
+      uint8_t next = (n == 1 && level[0] == '+') ? plusChild(node) : literalChild(node, level, n);
+      if (next == 0) {
+        return false;
+      }
+      node = next;
+      if (!slash) {
+        break;
+      }
+      level = slash + 1;
+    }
+    if (nodes_[node].value != TOPIC_TRIE_NONE) {
+      return false;
+    }
+    nodes_[node].value = value;
+    return true;
+  }
+
+  // 主题不需要 '\0' 结尾；没有匹配时返回 TOPIC_TRIE_NONE
+  uint8_t match(const char* topic, size_t length) const {
+    return matchFrom(0, topic, topic + length);
+  }
+
+  uint8_t nodeCount() const { return nodeCount_; }
+  uint16_t textLength() const { return textLength_; }
+
+private:
+  struct Node {
+    uint16_t text;       // 本层文本在 text_ 中的偏移
+    uint8_t length;
+    uint8_t child;       // 第一个字面子节点，0 表示没有（根节点不会是子节点）
+    uint8_t sibling;     // 同一父节点的下一个字面子节点
+    uint8_t plus;        // '+' 子节点
+    uint8_t hashValue;   // 以本节点 + '#' 结尾的过滤器
+    uint8_t value;       // 在本节点结束的过滤器
+  };
+
+  uint8_t newNode() {
+    if (nodeCount_ >= MaxNodes) {
+      return 0;
+    }
+    nodes_[nodeCount_] = Node{0, 0, 0, 0, 0, TOPIC_TRIE_NONE, TOPIC_TRIE_NONE};
+    return nodeCount_++;
+  }
+
+  uint8_t plusChild(uint8_t node) {
+    if (!nodes_[node].plus) {
+      nodes_[node].plus = newNode();
+    }
+    return nodes_[node].plus;
+  }
+
+  uint8_t literalChild(uint8_t node, const char* level, size_t n) {
+    uint8_t* link = &nodes_[node].child;
+    for (; *link; link = &nodes_[*link].sibling) {
+      const Node& c = nodes_[*link];
+      if (c.length == n && !memcmp(text_ + c.text, level, n)) {
+        return *link;
+      }
+    }
+    if (n > UINT8_MAX || textLength_ + n > TextCapacity) {
+      return 0;
+    }
+    uint8_t created = newNode();
+    if (created) {
+      memcpy(text_ + textLength_, level, n);
+      nodes_[created].text = textLength_;
+      nodes_[created].length = (uint8_t)n;
+      textLength_ += (uint16_t)n;
+      *link = created;  // 挂在兄弟链表末尾，先插入的过滤器先比较
+    }
+    return created;
+  }
+
+  // 主题在本节点结束：本节点的过滤器，或 "本节点/#"（'#' 也匹配零层）
+  uint8_t terminal(uint8_t node) const {
+    return nodes_[node].value != TOPIC_TRIE_NONE ? nodes_[node].value : nodes_[node].hashValue;
+  }
+
+  uint8_t matchFrom(uint8_t node, const char* level, const char* end) const {
+    const char* slash = (const char*)memchr(level, '/', end - level);
+    size_t n = (slash ? slash : end) - level;
+    const Node& parent = nodes_[node];
+    for (uint8_t c = parent.child; c; c = nodes_[c].sibling) {
+      if (nodes_[c].length == n && !memcmp(text_ + nodes_[c].text, level, n)) {
+        uint8_t found = slash ? matchFrom(c, slash + 1, end) : terminal(c);
+        if (found != TOPIC_TRIE_NONE) {
+          return found;
+        }
+        break;
+      }
+    }
+    if (parent.plus) {
+      uint8_t found = slash ? matchFrom(parent.plus, slash + 1, end) : terminal(parent.plus);
+      if (found != TOPIC_TRIE_NONE) {
+        return found;
+      }
+    }
+    return parent.hashValue;
+  }
+
+  Node nodes_[MaxNodes];
+  char text_[TextCapacity];
+  uint8_t nodeCount_;
+  uint16_t textLength_;
+};
+
+// 单个过滤器与主题逐字比较（同样的语法），用于模拟服务器的订阅匹配和主机上的对照
+inline bool topicMatchesFilter(const char* filter, const char* topic, size_t length) {
+  const char* end = topic + length;
+  for (;;) {
+    if (filter[0] == '#' && filter[1] == '\0') {
+      return true;
+    }
+    const char* slash = (const char*)memchr(topic, '/', end - topic);
+    const char* levelEnd = slash ? slash : end;
+    const char* filterSlash = strchr(filter, '/');
+    size_t filterLength = filterSlash ? (size_t)(filterSlash - filter) : strlen(filter);
+    if (!(filterLength == 1 && filter[0] == '+') &&
+        (filterLength != (size_t)(levelEnd - topic) || memcmp(filter, topic, filterLength) != 0)) {
+      return false;
+    }
+    if (!slash) {
+      // 主题结束：过滤器也必须结束，或只剩 "/#"
+      return !filterSlash || !strcmp(filterSlash, "/#");
+    }
+    if (!filterSlash) {
+      return false;
+    }
+    filter = filterSlash + 1;
+    topic = slash + 1;
+  }
+}
+
+#endif // TOPIC_TRIE_H
@@ -0,0 +1,182 @@
+#ifndef WEB_UI_H
+#define WEB_UI_H
+
+// 由 tools/build_web_assets.py 从 web/index.html 生成，请勿手工修改
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define WEB_UI_ETAG "\"72d387413d6d80af\""
+
+static const size_t WEB_UI_GZ_LEN = 2669;
+static const uint8_t WEB_UI_GZ[] PROGMEM = {
+  0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0x95, 0x58, 0x7b, 0x6f, 0x13, 0xd9,
+  0x15, 0xff, 0xdf, 0x9f, 0xe2, 0x62, 0x54, 0x66, 0x46, 0x8d, 0xc7, 0x8f, 0x04, 0x08, 0x63, 0xc7,
+  0x2b, 0x02, 0xa1, 0x4b, 0x1b, 0x48, 0xa4, 0x64, 0xfb, 0x10, 0x45, 0xab, 0x6b, 0xcf, 0x1d, 0x7b,
+  0xc8, 0x78, 0x66, 0x34, 0x73, 0x6d, 0x63, 0x85, 0x48, 0xb4, 0x5a, 0xca, 0x42, 0x59, 0x16, 0xba,
+  0xd5, 0x42, 0x05, 0x2c, 0x8f, 0x42, 0xbb, 0x5d, 0x69, 0xd9, 0xed, 0xee, 0x8a, 0x45, 0x10, 0x36,
+  0x5f, 0x86, 0x71, 0x92, 0xbf, 0xda, 0x8f, 0xd0, 0x73, 0x1f, 0x33, 0x9e, 0x49, 0x9c, 0x88, 0x0a,
+  0x11, 0xfb, 0xde, 0x7b, 0xde, 0xf7, 0x9c, 0xdf, 0x39, 0xd7, 0xb5, 0x03, 0x27, 0x17, 0x4e, 0x2c,
+  0xff, 0x6e, 0x71, 0x0e, 0xb5, 0x69, 0xc7, 0xa9, 0xe7, 0x6a, 0xf1, 0x07, 0xc1, 0x26, 0x7c, 0x74,
+  0x08, 0xc5, 0xa8, 0xd9, 0xc6, 0x41, 0x48, 0xe8, 0x4c, 0xbe, 0x4b, 0xad, 0xc2, 0x74, 0x1e, 0xb6,
+  0xa9, 0x4d, 0x1d, 0x52, 0x9f, 0x5b, 0x5a, 0x9c, 0xac, 0xa0, 0x59, 0xec, 0x38, 0x68, 0x78, 0xf3,
+  0x9f, 0xd1, 0xc7, 0x2f, 0xb6, 0x1f, 0x3c, 0x19, 0x3e, 0xd8, 0xa8, 0x15, 0xc5, 0xb1, 0xe4, 0x76,
+  0x71, 0x87, 0xcc, 0xe4, 0x7b, 0x36, 0xe9, 0xfb, 0x5e, 0x40, 0xf3, 0xa8, 0xe9, 0xb9, 0x94, 0xb8,
+  0x20, 0xad, 0x6f, 0x9b, 0xb4, 0x3d, 0x63, 0x92, 0x9e, 0xdd, 0x24, 0x05, 0xbe, 0x98, 0x40, 0xb6,
+  0x6b, 0x53, 0x1b, 0x3b, 0x85, 0xb0, 0x89, 0x1d, 0x32, 0x53, 0x66, 0xba, 0x42, 0x3a, 0x60, 0xc2,
+  0x1a, 0x9e, 0x39, 0x58, 0xb5, 0x80, 0xb7, 0x60, 0xe1, 0x8e, 0xed, 0x0c, 0x8c, 0xe3, 0x01, 0x10,
+  0x4e, 0x84, 0xd8, 0x0d, 0x0b, 0x21, 0x09, 0x6c, 0xab, 0xda, 0xc1, 0x41, 0xcb, 0x76, 0x8d, 0x4a,
+  0xc9, 0xbf, 0x58, 0x6d, 0xe0, 0xe6, 0x4a, 0x2b, 0xf0, 0xba, 0xae, 0x69, 0x1c, 0xb4, 0x4a, 0xec,
+  0xdf, 0x5a, 0x4e, 0x67, 0x9a, 0xb1, 0xed, 0x92, 0x60, 0xb5, 0x83, 0x2f, 0x0a, 0x8d, 0xc6, 0x74,
+  0x89, 0x91, 0x4b, 0xd6, 0x12, 0xc2, 0x5d, 0xea, 0xa5, 0x99, 0xfb, 0x6d, 0x9b, 0x92, 0xaa, 0x8f,
+  0x4d, 0xd3, 0x76, 0x5b, 0x52, 0xb4, 0x17, 0x98, 0x24, 0x28, 0x04, 0xd8, 0xb4, 0xbb, 0xa1, 0x51,
+  0x16, 0x5b, 0x17, 0x0b, 0x61, 0x1b, 0x9b, 0x5e, 0x1f, 0x44, 0x54, 0xfc, 0x8b, 0x88, 0xed, 0xa2,
+  0xa0, 0xd5, 0xc0, 0x6a, 0x69, 0x82, 0xff, 0xd3, 0xcb, 0xda, 0x5a, 0xae, 0x5d, 0x5e, 0xa5, 0xe4,
+  0x22, 0x2d, 0x60, 0xc7, 0x6e, 0xb9, 0x46, 0x13, 0x82, 0x40, 0x82, 0x6a, 0xd3, 0x73, 0xbc, 0xc0,
+  0x38, 0x38, 0x39, 0x39, 0x09, 0x16, 0x86, 0xa4, 0x49, 0x6d, 0xcf, 0x5d, 0x4d, 0xb9, 0x82, 0x4a,
+  0x89, 0xfa, 0xf2, 0xe1, 0x44, 0xbd, 0x51, 0x86, 0x93, 0xd0, 0x73, 0x6c, 0x13, 0x1d, 0x34, 0x4d,
+  0x73, 0x87, 0x51, 0x40, 0x07, 0xc2, 0x1a, 0x5d, 0x4a, 0x3d, 0xb7, 0xd0, 0x0a, 0x6c, 0x73, 0xd5,
+  0xb4, 0x43, 0xdf, 0xc1, 0x03, 0x83, 0x2d, 0xaa, 0xec, 0x4f, 0x81, 0x92, 0x0e, 0xec, 0x50, 0x52,
+  0x00, 0x03, 0xba, 0x1d, 0x37, 0x34, 0x02, 0xe2, 0x13, 0x4c, 0x55, 0x16, 0x81, 0x82, 0x65, 0xd3,
+  0x89, 0x8e, 0xed, 0x42, 0x98, 0xd4, 0xf2, 0x61, 0x30, 0x62, 0xa2, 0x6c, 0x05, 0x9a, 0x56, 0x6d,
+  0x61, 0x9f, 0x3b, 0x3c, 0x12, 0x1e, 0x52, 0x4c, 0xbb, 0xe1, 0x6a, 0x62, 0x21, 0x8b, 0xc6, 0x6e,
+  0x1f, 0x77, 0x59, 0x57, 0xe5, 0x17, 0xd9, 0x27, 0x76, 0xab, 0x4d, 0x8d, 0x86, 0xe7, 0x98, 0x55,
+  0x1a, 0xc0, 0x45, 0xda, 0xcc, 0x79, 0x83, 0xe5, 0x53, 0x49, 0x9f, 0x0c, 0x47, 0x5a, 0x20, 0x22,
+  0xe9, 0x0b, 0x9d, 0x3a, 0x71, 0xfc, 0xd4, 0xe1, 0x92, 0x8c, 0x9c, 0xb8, 0x21, 0xce, 0x6e, 0x79,
+  0x41, 0xc7, 0xe0, 0x99, 0xa3, 0x96, 0xf5, 0xd2, 0x61, 0x2d, 0x25, 0xc0, 0xb2, 0x32, 0x12, 0xac,
+  0xa9, 0xa9, 0xc9, 0xc9, 0x23, 0x69, 0x09, 0x40, 0xeb, 0x51, 0x5c, 0x88, 0x2f, 0x60, 0x97, 0x0f,
+  0x70, 0xde, 0xf5, 0x1d, 0x0f, 0x9b, 0x85, 0x06, 0xcd, 0x5a, 0x53, 0x29, 0x1f, 0x3b, 0x72, 0x6a,
+  0x32, 0x63, 0x4d, 0x3a, 0x1c, 0x28, 0x95, 0x34, 0x86, 0xeb, 0xb9, 0x64, 0x4c, 0x34, 0x9a, 0xdd,
+  0x20, 0x04, 0x66, 0xdf, 0xb3, 0x79, 0xb8, 0xe4, 0xed, 0x97, 0xc5, 0xed, 0xa7, 0x22, 0x33, 0x52,
+  0x1b, 0x07, 0x68, 0x64, 0x93, 0xd1, 0xf6, 0x7a, 0x90, 0xd9, 0x69, 0xcb, 0xca, 0xc7, 0x8e, 0x1e,
+  0x39, 0x59, 0x61, 0x69, 0x25, 0x6e, 0x29, 0x2b, 0x37, 0x73, 0x67, 0xe3, 0xf2, 0x27, 0xec, 0x36,
+  0x9b, 0x24, 0x0c, 0x33, 0x22, 0x4d, 0xcb, 0x2a, 0x99, 0xd3, 0x49, 0xd2, 0x36, 0x8f, 0x1e, 0x99,
+  0x34, 0x81, 0x94, 0x04, 0x81, 0x97, 0xd5, 0x6d, 0x55, 0x4c, 0x62, 0x92, 0x98, 0x10, 0x1f, 0x9b,
+  0x9a, 0x9a, 0x62, 0x96, 0xd8, 0xae, 0xe5, 0x65, 0x05, 0x1e, 0x23, 0xa6, 0x75, 0x34, 0x11, 0x58,
+  0x3e, 0x5a, 0x9a, 0xb6, 0x80, 0xce, 0xf1, 0x5a, 0xab, 0x6d, 0x91, 0x1e, 0x15, 0x5e, 0xa1, 0xcc,
+  0x39, 0xcb, 0xf1, 0xfa, 0x85, 0x81, 0xb1, 0xb3, 0x46, 0x0f, 0x56, 0x2a, 0x95, 0x58, 0x00, 0xab,
+  0x05, 0x96, 0x5b, 0x46, 0x99, 0x95, 0x61, 0xc7, 0x73, 0xbd, 0xd0, 0xc7, 0xcd, 0xd1, 0x8d, 0x4c,
+  0x83, 0x28, 0x7e, 0x47, 0x05, 0xbe, 0x6f, 0xf8, 0x01, 0x40, 0x4f, 0x80, 0xfd, 0x04, 0x01, 0xd6,
+  0x72, 0xb5, 0xa2, 0x44, 0x9c, 0x5a, 0x51, 0x82, 0x20, 0x83, 0x1e, 0xf8, 0x30, 0xed, 0x1e, 0x6a,
+  0x3a, 0x38, 0x0c, 0x67, 0xf2, 0x09, 0x92, 0x30, 0x80, 0x6a, 0x97, 0xeb, 0xff, 0x7d, 0x78, 0xf3,
+  0x39, 0xda, 0x13, 0x0e, 0x81, 0x20, 0xc3, 0x2d, 0x93, 0x8c, 0xf3, 0x56, 0x80, 0xf7, 0xb3, 0xeb,
+  0x68, 0xf3, 0xfb, 0xd7, 0x9b, 0xaf, 0x1f, 0x6e, 0x5e, 0x7f, 0x31, 0xbc, 0xfc, 0x07, 0x60, 0xa8,
+  0x48, 0x06, 0xdb, 0x04, 0xea, 0x41, 0x08, 0xb5, 0x2a, 0x2b, 0x2d, 0x9f, 0xc8, 0xe0, 0x4b, 0xc4,
+  0xe2, 0x99, 0xaf, 0x0f, 0xbf, 0xfe, 0x7b, 0x74, 0xff, 0xcb, 0xe8, 0xfa, 0xa3, 0xad, 0x37, 0x6f,
+  0x74, 0x5d, 0xaf, 0x15, 0x81, 0x37, 0x25, 0xc1, 0x21, 0x66, 0xa1, 0xe3, 0x99, 0x64, 0x3c, 0xf3,
+  0xfc, 0xdc, 0xc9, 0xe1, 0x97, 0x8f, 0xa3, 0xf5, 0x4f, 0x0d, 0x54, 0x88, 0x39, 0x53, 0x02, 0xf6,
+  0xb0, 0xf9, 0xaf, 0x77, 0xd1, 0xf0, 0xc6, 0xb5, 0xed, 0xbf, 0x3c, 0x17, 0x36, 0x6f, 0xde, 0xbb,
+  0x0d, 0x3e, 0xef, 0xb0, 0x5c, 0x14, 0xdf, 0xc8, 0xe6, 0x14, 0x20, 0xe5, 0xeb, 0xef, 0xae, 0xea,
+  0xb3, 0xfb, 0x68, 0xeb, 0xf9, 0x4f, 0xd1, 0xd3, 0xab, 0xc3, 0x3b, 0xcf, 0xa2, 0x8d, 0x3b, 0x52,
+  0x89, 0x83, 0x1b, 0xc4, 0xa9, 0xd7, 0x6c, 0xd7, 0xef, 0x52, 0x44, 0x07, 0x3e, 0xf4, 0x98, 0x66,
+  0x9b, 0x34, 0x57, 0x00, 0x8b, 0xf3, 0xc2, 0x6b, 0xaf, 0x55, 0x20, 0x2e, 0x6e, 0x80, 0xf7, 0x79,
+  0xe4, 0xb9, 0xd0, 0xc4, 0xdc, 0x16, 0x61, 0xd2, 0xe9, 0xbc, 0xd7, 0xfa, 0x35, 0xb4, 0x23, 0x95,
+  0xb6, 0xed, 0x50, 0xe7, 0x4c, 0xc4, 0xd4, 0xf2, 0x75, 0x14, 0x3d, 0xff, 0x62, 0x78, 0xe7, 0xc5,
+  0xf0, 0xee, 0x4f, 0x9b, 0x4f, 0x5f, 0xd5, 0x8a, 0x42, 0x41, 0xae, 0x06, 0x29, 0x12, 0xcb, 0x4b,
+  0x3c, 0x61, 0xdf, 0xc1, 0x03, 0x38, 0xda, 0xcf, 0x03, 0x94, 0x42, 0x94, 0x51, 0xe0, 0x3e, 0x42,
+  0x0b, 0xcb, 0xc7, 0x51, 0x74, 0xef, 0xd5, 0xdb, 0xd7, 0x2f, 0xa2, 0x4f, 0xae, 0x6e, 0xbe, 0x8a,
+  0xc3, 0x96, 0x76, 0xc5, 0xb2, 0x1d, 0x22, 0xdc, 0xb0, 0xec, 0xa0, 0xd3, 0xc7, 0x01, 0xac, 0x30,
+  0x94, 0xa3, 0x0f, 0x7d, 0x93, 0x01, 0x55, 0x1e, 0xf1, 0x24, 0x9d, 0xc9, 0x67, 0x6a, 0x9a, 0x29,
+  0x69, 0x04, 0xf5, 0x9a, 0x08, 0x74, 0x6c, 0xcd, 0x08, 0x23, 0x78, 0x1c, 0x1c, 0xbb, 0xb9, 0x12,
+  0x6f, 0x9e, 0x92, 0xc2, 0x55, 0x70, 0x1f, 0x02, 0xfd, 0x14, 0xbd, 0x7d, 0x79, 0xfd, 0xed, 0xfa,
+  0x23, 0x61, 0x5c, 0xad, 0x28, 0xe4, 0xa4, 0x73, 0x51, 0x24, 0x61, 0x72, 0x79, 0x7e, 0xe0, 0xb5,
+  0x02, 0xc0, 0x08, 0x7e, 0xc8, 0xbc, 0x8d, 0x37, 0xf2, 0x08, 0x7a, 0xc7, 0x4c, 0xbe, 0x9c, 0x47,
+  0x3d, 0xec, 0x74, 0xc1, 0xce, 0x52, 0x62, 0xb1, 0xe8, 0xbb, 0xe5, 0x52, 0xe9, 0x67, 0xd5, 0xb8,
+  0x2b, 0x31, 0x58, 0x14, 0xf1, 0x14, 0xdc, 0xa3, 0xa0, 0xca, 0x8f, 0xb0, 0x19, 0xd8, 0x3e, 0xad,
+  0xe7, 0xa0, 0xee, 0x42, 0x8a, 0xce, 0x2c, 0x9c, 0x9c, 0x5b, 0x42, 0x33, 0xe8, 0x9c, 0x12, 0x5d,
+  0xf9, 0x7e, 0xfb, 0xce, 0xd7, 0xca, 0x04, 0x52, 0x36, 0x5f, 0x3d, 0xd9, 0xba, 0xf6, 0x5d, 0x74,
+  0x7b, 0x3d, 0xba, 0xf5, 0x92, 0xaf, 0x5f, 0x6f, 0x64, 0xd6, 0xdb, 0xaf, 0x3f, 0x82, 0xf5, 0xf6,
+  0x93, 0xdb, 0xdb, 0x77, 0xbe, 0x1a, 0x9d, 0x6f, 0x6d, 0xdc, 0x8b, 0x5e, 0xfd, 0x63, 0xf8, 0xe0,
+  0xf1, 0x88, 0x64, 0x6b, 0xe3, 0x4d, 0x74, 0xe5, 0x9a, 0x14, 0x09, 0x54, 0xc3, 0x97, 0xb7, 0xa2,
+  0x4f, 0xef, 0x2a, 0xe7, 0xab, 0x39, 0x87, 0x50, 0xb4, 0x78, 0xfa, 0x2c, 0xd7, 0x2c, 0x97, 0xa1,
+  0x07, 0xb9, 0x43, 0x61, 0xc3, 0xed, 0x3a, 0x4e, 0x55, 0x9a, 0x37, 0xbf, 0xf0, 0x8b, 0x0f, 0xcf,
+  0x1c, 0xff, 0xed, 0x87, 0xf3, 0xa7, 0xcf, 0x72, 0x33, 0x0f, 0x97, 0x4a, 0xd5, 0x9c, 0xd5, 0x75,
+  0x45, 0x4e, 0x34, 0xba, 0xb6, 0x63, 0xce, 0x8a, 0xca, 0x50, 0x7d, 0xdb, 0x0d, 0x35, 0xb4, 0x9a,
+  0x93, 0x62, 0xd9, 0x32, 0x96, 0xc2, 0xaa, 0x04, 0xb6, 0x4c, 0xaf, 0xd9, 0xed, 0x40, 0x07, 0xd2,
+  0x5b, 0x84, 0xce, 0x39, 0x84, 0x7d, 0x9d, 0x1d, 0x9c, 0x36, 0x55, 0x45, 0x16, 0x97, 0xa2, 0x55,
+  0x73, 0x8c, 0x14, 0x90, 0x15, 0xe0, 0xe8, 0xfd, 0xe5, 0x33, 0xf3, 0xc0, 0xa4, 0x28, 0x55, 0x2e,
+  0x52, 0x87, 0x8e, 0x38, 0x87, 0x9b, 0x6d, 0xd5, 0x47, 0x33, 0x75, 0x50, 0x23, 0x24, 0x13, 0x27,
+  0x2d, 0xb7, 0x19, 0x40, 0xd7, 0x27, 0x52, 0xb4, 0xaa, 0x40, 0xbc, 0x99, 0x48, 0xe2, 0xe8, 0x5c,
+  0xbd, 0xe2, 0x2b, 0xe8, 0xe7, 0xc8, 0x97, 0x3a, 0xb0, 0xef, 0x13, 0xd7, 0x3c, 0xd1, 0x06, 0x0f,
+  0x54, 0xe2, 0x00, 0x59, 0xd7, 0x37, 0x81, 0x59, 0x78, 0xa3, 0x72, 0x9e, 0x09, 0x64, 0x61, 0x27,
+  0x24, 0x70, 0xb6, 0xc6, 0xfe, 0x8f, 0xfc, 0x06, 0xdd, 0x2e, 0x94, 0xc2, 0x6f, 0x48, 0x63, 0x89,
+  0x07, 0x4d, 0xd5, 0x12, 0x83, 0xfa, 0x21, 0x8b, 0x20, 0xe9, 0xa3, 0xd1, 0xa1, 0xd2, 0x0f, 0x8d,
+  0x62, 0x91, 0xe9, 0xee, 0xdb, 0x2e, 0xcc, 0x55, 0xd0, 0x10, 0x9a, 0x98, 0xc9, 0xd1, 0xdb, 0x5e,
+  0x48, 0xd9, 0x48, 0x09, 0x47, 0x4a, 0xb1, 0xcf, 0xfd, 0xef, 0x87, 0x7a, 0xc3, 0x76, 0x71, 0x30,
+  0x58, 0x86, 0xda, 0x61, 0x46, 0xe3, 0x20, 0xc0, 0x83, 0x46, 0xd7, 0xb2, 0x48, 0x00, 0x91, 0x48,
+  0x2e, 0xa9, 0x1f, 0x72, 0x5a, 0x68, 0x0a, 0xe0, 0x06, 0xac, 0x63, 0xdb, 0xb8, 0x29, 0xb6, 0x85,
+  0xd4, 0x3d, 0x83, 0x9d, 0xc2, 0x12, 0x45, 0x4b, 0x20, 0x03, 0x04, 0xc2, 0xc4, 0xe6, 0x8a, 0x73,
+  0xa3, 0xcc, 0x4c, 0x59, 0x93, 0x1a, 0x3a, 0x90, 0xc5, 0xb8, 0x45, 0xd2, 0x4a, 0x48, 0xac, 0x85,
+  0x55, 0xb8, 0x67, 0x21, 0xa2, 0x43, 0xec, 0x30, 0x9a, 0x99, 0x01, 0x83, 0x43, 0x1a, 0x40, 0x77,
+  0x52, 0xd0, 0xa1, 0x43, 0x72, 0xfb, 0x5c, 0xe9, 0x3c, 0x3a, 0xc0, 0x4e, 0x56, 0x15, 0xc6, 0x26,
+  0x02, 0x0f, 0xb8, 0xa5, 0x8a, 0x63, 0xd0, 0x14, 0x10, 0xda, 0x0d, 0x5c, 0x16, 0xe2, 0xfd, 0x65,
+  0x8e, 0xc2, 0x2c, 0x8e, 0xd0, 0x2f, 0x97, 0x16, 0xce, 0xea, 0x3e, 0x9b, 0xe8, 0x47, 0xc2, 0xb8,
+  0xf3, 0xf0, 0x95, 0x41, 0x0b, 0x30, 0xa0, 0xb0, 0xed, 0xf5, 0x01, 0xa5, 0x16, 0x65, 0x3d, 0x8e,
+  0xce, 0xaa, 0x48, 0xea, 0x45, 0x6b, 0x63, 0x32, 0x2c, 0x93, 0x0e, 0x32, 0x75, 0x26, 0xb8, 0xde,
+  0x73, 0x72, 0x75, 0x5e, 0xcb, 0x98, 0x2e, 0x0c, 0xeb, 0xc9, 0xeb, 0x3f, 0x09, 0x84, 0x1c, 0x98,
+  0x13, 0xbb, 0xc4, 0x79, 0x07, 0x87, 0x2b, 0x40, 0xd2, 0x63, 0xd7, 0xf2, 0x01, 0x8c, 0x48, 0xd3,
+  0x6a, 0x59, 0x43, 0x97, 0x90, 0xda, 0xd3, 0x1b, 0x03, 0x4a, 0xe6, 0x89, 0xdb, 0xa2, 0x6d, 0x54,
+  0x47, 0xe5, 0x0a, 0x7a, 0x2f, 0x43, 0x54, 0xd1, 0x50, 0xad, 0x86, 0xa6, 0x91, 0x81, 0x4a, 0xda,
+  0x04, 0x62, 0x1d, 0x30, 0x2b, 0xa5, 0xa2, 0xed, 0x28, 0x13, 0x15, 0xac, 0xb5, 0xb5, 0xbd, 0x3d,
+  0x51, 0xb9, 0x25, 0xf5, 0x3a, 0x23, 0x3a, 0x84, 0xca, 0xcc, 0x97, 0xbd, 0x53, 0x46, 0x36, 0x5d,
+  0xc8, 0x17, 0x36, 0x4c, 0x9e, 0x10, 0xaf, 0x1e, 0x96, 0x9d, 0xa9, 0x86, 0xcb, 0xe4, 0xaa, 0x1c,
+  0xce, 0xce, 0x31, 0xda, 0xf3, 0xe8, 0xd2, 0x25, 0x6e, 0xa7, 0xc8, 0xa4, 0x54, 0xf5, 0xa4, 0xba,
+  0x96, 0xcc, 0xc3, 0x38, 0x9b, 0x64, 0x76, 0x43, 0xe6, 0x88, 0x6f, 0x3a, 0xd4, 0xb3, 0x39, 0x58,
+  0x02, 0xa0, 0x26, 0x3c, 0x0f, 0x92, 0x9a, 0xd2, 0x17, 0x16, 0xe7, 0xce, 0x6a, 0x31, 0x15, 0xcf,
+  0x5b, 0x29, 0x0a, 0xc2, 0x26, 0x33, 0x18, 0x42, 0xc5, 0xbf, 0x95, 0x94, 0x6c, 0xf1, 0x8e, 0xf2,
+  0x8f, 0xf9, 0xa2, 0xed, 0x01, 0x25, 0x63, 0xaa, 0x46, 0x49, 0x2e, 0x11, 0xd3, 0x59, 0x0f, 0xa2,
+  0xd9, 0x01, 0x06, 0x00, 0x0a, 0x00, 0x74, 0xcf, 0x71, 0x96, 0x3d, 0x1f, 0x02, 0x00, 0x4b, 0x68,
+  0x4a, 0xc0, 0xf5, 0x3e, 0x1f, 0xf8, 0x50, 0x3d, 0x45, 0x21, 0xb7, 0x0a, 0x68, 0x2a, 0x96, 0xe3,
+  0xc0, 0xd8, 0xc5, 0xf0, 0x82, 0xc1, 0x4d, 0x3a, 0xb0, 0xef, 0xa1, 0x1d, 0x1b, 0x80, 0x0f, 0xbf,
+  0x77, 0x59, 0x80, 0xd9, 0x26, 0x38, 0xc6, 0x2d, 0xd7, 0xa1, 0xe1, 0xd8, 0x00, 0x2f, 0x70, 0x22,
+  0x50, 0x2e, 0x7b, 0x37, 0x5c, 0xb8, 0x1e, 0x42, 0x8b, 0x24, 0x6a, 0x21, 0x83, 0xe3, 0x9a, 0x7e,
+  0x01, 0xa6, 0xf3, 0x98, 0x91, 0x05, 0x3e, 0x76, 0x48, 0xcb, 0xfa, 0xb3, 0xcb, 0xf8, 0x4c, 0x20,
+  0x33, 0x79, 0xc5, 0xd0, 0x92, 0x75, 0x54, 0xf2, 0x8e, 0x01, 0xb5, 0x4d, 0xa9, 0xfa, 0x00, 0x80,
+  0x6f, 0x5c, 0x88, 0x22, 0x09, 0x62, 0x29, 0x3c, 0x96, 0xd0, 0xf5, 0xcf, 0x32, 0x84, 0x84, 0x5c,
+  0xcb, 0x3c, 0xd3, 0x50, 0xf2, 0x9c, 0x52, 0xc6, 0xf8, 0x0e, 0xf8, 0x4e, 0xbd, 0x0f, 0xe0, 0xa2,
+  0x83, 0x13, 0x18, 0xb0, 0x41, 0x63, 0x01, 0x34, 0x50, 0xb4, 0x7e, 0x39, 0xba, 0xf5, 0x0d, 0xd0,
+  0xaf, 0x81, 0x6d, 0x21, 0x79, 0x67, 0x15, 0x96, 0xf5, 0x7f, 0xe8, 0x10, 0x5d, 0x9c, 0x05, 0x2a,
+  0x13, 0xaa, 0xec, 0x84, 0x92, 0xc4, 0x88, 0xcd, 0x46, 0xfb, 0xa5, 0x5d, 0x3c, 0x31, 0x41, 0xe5,
+  0x31, 0xd2, 0x10, 0xb0, 0x54, 0x86, 0x8d, 0x2d, 0x63, 0x78, 0x5b, 0xe2, 0xf6, 0xaa, 0xca, 0xd6,
+  0x37, 0x3f, 0x6e, 0x5f, 0xbe, 0x36, 0xfc, 0xf3, 0xbf, 0xc4, 0xd0, 0x33, 0xfc, 0xfc, 0x2a, 0xfc,
+  0x65, 0xed, 0x9f, 0xbf, 0x69, 0x94, 0x0c, 0xe2, 0x49, 0xfd, 0xa6, 0xc4, 0xab, 0x53, 0xf0, 0xde,
+  0x64, 0x98, 0xa5, 0xc2, 0xb5, 0x58, 0x71, 0x77, 0x4c, 0xe9, 0x9f, 0xe0, 0xa6, 0xc2, 0x61, 0x5a,
+  0x9f, 0x98, 0xd5, 0xd3, 0x73, 0x16, 0x4c, 0xec, 0x4c, 0x1f, 0x9b, 0xc6, 0x59, 0x6e, 0x59, 0x84,
+  0x02, 0x14, 0x29, 0x45, 0x91, 0x2a, 0x70, 0xb2, 0xda, 0x21, 0xb4, 0xed, 0x99, 0x50, 0x9a, 0x8b,
+  0x0b, 0x4b, 0xcb, 0xb0, 0xc1, 0xde, 0x23, 0x06, 0x98, 0xb1, 0xa6, 0xe5, 0x74, 0xda, 0x26, 0xae,
+  0x1a, 0x30, 0xc8, 0x0a, 0x78, 0xac, 0x55, 0x4d, 0x6c, 0x99, 0x6c, 0x2b, 0xa5, 0x17, 0x52, 0x2d,
+  0xd0, 0xbd, 0x15, 0x56, 0xea, 0x5c, 0x11, 0xab, 0x74, 0xe9, 0xa1, 0x06, 0x62, 0xa0, 0xb9, 0x82,
+  0x52, 0xb2, 0x83, 0x49, 0x91, 0x66, 0x3e, 0xfd, 0xf7, 0xd6, 0x0f, 0xcf, 0x04, 0x5a, 0x91, 0x51,
+  0x64, 0xb2, 0x10, 0xb1, 0xb3, 0x65, 0x88, 0x4e, 0x22, 0x43, 0xd6, 0xc0, 0xc1, 0x7e, 0x37, 0x96,
+  0x9e, 0x1c, 0x59, 0x08, 0x80, 0x5c, 0xe7, 0xd3, 0xa2, 0x2e, 0x27, 0x44, 0x60, 0x06, 0x1a, 0xfe,
+  0x8e, 0x15, 0xa8, 0xa6, 0xd8, 0xa6, 0x43, 0x14, 0xe6, 0x0d, 0x9b, 0x1d, 0xb9, 0x37, 0x8a, 0xe0,
+  0x83, 0xb9, 0x53, 0x52, 0x53, 0xf8, 0xe3, 0x30, 0x44, 0x2d, 0x8b, 0x13, 0x3e, 0x89, 0xca, 0xb3,
+  0x7e, 0x60, 0x53, 0xc8, 0x49, 0x91, 0x17, 0x3b, 0x44, 0x07, 0xa4, 0x49, 0xec, 0x1e, 0xef, 0xc7,
+  0xc0, 0xbc, 0xe3, 0x90, 0x31, 0xc6, 0x6d, 0x35, 0x1d, 0xa9, 0xe8, 0xc7, 0xef, 0xa2, 0x3f, 0xfd,
+  0x2d, 0xba, 0xf2, 0x8c, 0x47, 0xe9, 0x0c, 0xa6, 0x6d, 0x9d, 0xbf, 0x4e, 0xd5, 0x94, 0x36, 0x54,
+  0x44, 0xe5, 0x52, 0x65, 0x8a, 0x67, 0x3d, 0x7c, 0x1f, 0x43, 0x28, 0x4c, 0x4e, 0x93, 0xfd, 0x6a,
+  0xf6, 0x3f, 0xeb, 0x37, 0x80, 0x32, 0xc7, 0x8e, 0x57, 0x66, 0xfd, 0x50, 0xee, 0x16, 0xc3, 0x74,
+  0xce, 0xc8, 0xe2, 0x1c, 0xeb, 0x4c, 0xc3, 0xf3, 0xc6, 0x5a, 0x3c, 0xbc, 0xf7, 0xc3, 0xf0, 0xf3,
+  0x6f, 0x87, 0x1f, 0xdf, 0x8a, 0xae, 0x3f, 0x04, 0x1d, 0xf2, 0x89, 0xc5, 0xb3, 0x73, 0xfb, 0xea,
+  0x27, 0x50, 0xf4, 0x32, 0x2f, 0xe5, 0xcf, 0x00, 0x4c, 0x0d, 0x74, 0xa1, 0x65, 0xbb, 0x43, 0xbc,
+  0x2e, 0x55, 0x55, 0xde, 0x26, 0x93, 0xa9, 0x2c, 0x20, 0xac, 0x58, 0x55, 0x68, 0xb3, 0x30, 0xed,
+  0x96, 0xf6, 0xb5, 0xc8, 0xc2, 0x36, 0x1f, 0xa3, 0xc6, 0x9a, 0x93, 0x4e, 0x35, 0xce, 0xc8, 0x73,
+  0x8d, 0xdd, 0x83, 0x32, 0xbc, 0xff, 0xd5, 0xe6, 0xc3, 0x67, 0xd1, 0xcd, 0x87, 0xd1, 0xbd, 0x47,
+  0x8a, 0x96, 0x2a, 0xd0, 0x2c, 0x6c, 0xa4, 0x64, 0x76, 0xc2, 0xd6, 0x04, 0x7f, 0x4f, 0xbd, 0x6b,
+  0xc3, 0x12, 0x18, 0x36, 0xb6, 0x33, 0x80, 0xac, 0xea, 0x2e, 0xe8, 0x93, 0x98, 0xc7, 0x9b, 0x0c,
+  0xa8, 0x19, 0x83, 0xf4, 0x4b, 0xfc, 0xf1, 0x2e, 0xed, 0x19, 0x99, 0x21, 0x19, 0xf7, 0x33, 0x25,
+  0xfd, 0xea, 0x4f, 0xc3, 0x02, 0xf6, 0xed, 0x62, 0x32, 0xfb, 0x67, 0xca, 0xff, 0x42, 0xc8, 0x46,
+  0xd9, 0x74, 0xfd, 0xc7, 0xea, 0x3c, 0x97, 0x35, 0x36, 0x50, 0xb7, 0xd0, 0xb8, 0x00, 0x33, 0xb8,
+  0xa8, 0x04, 0xc0, 0x04, 0x68, 0x87, 0x5e, 0x87, 0xa8, 0x3d, 0x46, 0xdb, 0xe3, 0xb7, 0x43, 0x03,
+  0x28, 0x11, 0x88, 0xb6, 0x58, 0xc5, 0xa3, 0xbc, 0xb0, 0x62, 0x47, 0x44, 0xa4, 0x50, 0x28, 0x41,
+  0xf1, 0xe3, 0xc5, 0xd6, 0xc6, 0xad, 0xad, 0xc7, 0x37, 0x58, 0x02, 0xbd, 0x7c, 0xc9, 0x0b, 0x72,
+  0x6b, 0xe3, 0x8b, 0xe1, 0xcd, 0x67, 0xd1, 0xfa, 0x1f, 0xd9, 0x46, 0x22, 0x64, 0xaf, 0x00, 0xaa,
+  0x23, 0x79, 0x71, 0xc6, 0xa5, 0x30, 0x8a, 0x3d, 0x27, 0x24, 0x48, 0x89, 0xcc, 0x5b, 0x1d, 0x6f,
+  0x54, 0xac, 0x94, 0xa7, 0xd1, 0xfe, 0x4a, 0x85, 0xe4, 0xe4, 0x9d, 0x92, 0x0e, 0x2f, 0x54, 0x0c,
+  0x4c, 0xcf, 0xd8, 0x7f, 0x87, 0x00, 0x67, 0x9e, 0x73, 0xa6, 0xce, 0x1f, 0x74, 0x7c, 0x54, 0xd9,
+  0xf1, 0xd8, 0x11, 0x7a, 0xa0, 0x80, 0x4e, 0xb3, 0x9f, 0xf8, 0xe0, 0x02, 0xd4, 0xdd, 0x09, 0x92,
+  0x14, 0xcf, 0xb8, 0xdc, 0xa9, 0xb2, 0x1f, 0xa6, 0xe4, 0x33, 0x18, 0x5e, 0xe6, 0xe2, 0x27, 0xa9,
+  0x22, 0xff, 0xb5, 0xfe, 0x7f, 0x20, 0xe3, 0x2b, 0xe4, 0xc4, 0x17, 0x00, 0x00,
+};
+
+#endif // WEB_UI_H
@@ -0,0 +1,40 @@
+#ifndef WIFI_MANAGER_H
+#define WIFI_MANAGER_H
+
+#include <stdint.h>
+
+// ==================== WiFi 状态机 ====================
+// 启动时只发起连接，不等待结果；之后由网络任务的 WiFi 作业推进（WiFi 事件会立即唤醒它）。
+//   CONNECTING_CACHED：用 NVS 中上次的 BSSID/信道/IP 租约直连，跳过扫描和 DHCP
+//   CONNECTING：       全信道扫描 + DHCP（无缓存或缓存直连失败）
+//   CONNECTED：        成功后链路参数有变化才写 NVS
+//   BACKOFF：          失败或掉线后按带抖动的指数退避等待下一次尝试
+// 缓存的 IP 租约可能已被路由器回收，直连失败时立即清除缓存并改走全扫描，不计入退避。
+
+enum WiFiState {
+  WIFI_STATE_IDLE,
+  WIFI_STATE_CONNECTING_CACHED,
+  WIFI_STATE_CONNECTING,
+  WIFI_STATE_CONNECTED,
+  WIFI_STATE_BACKOFF
+};
+
+struct WiFiStats {
+  uint32_t connects;
+  uint32_t fastConnects;       // 通过缓存直连成功的次数
+  uint32_t failures;           // 全扫描连接失败次数
+  uint32_t drops;              // 连接后掉线次数
+  uint32_t lastConnectMillis;  // 最近一次从发起到连上的耗时
+  uint32_t lastBackoffMillis;  // 最近一次退避等待时间
+};
+
+void initializeWiFiManager(uint8_t notifyTask);
+
+// 推进状态机，返回距离下一次需要检查的微秒数
+uint32_t updateWiFiManager();
+
+bool wifiManagerConnected();
+WiFiState wifiManagerState();
+const WiFiStats& wifiStats();
+
+#endif // WIFI_MANAGER_H
@@ -0,0 +1,64 @@
+#ifndef WS_FANOUT_H
+#define WS_FANOUT_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "hal.h"
+#include "config.h"
+
+// ==================== WebSocket 广播扇出 ====================
+// 每个广播帧只分配一次共享缓冲（HalWsBuffer，引用计数），所有客户端的发送队列引用同一块内存，
+// 而不是像 textAll() 那样给每个客户端复制一份、在 AsyncTCP 里无上限地排队。
+// 每个客户端一个最多 WS_CLIENT_QUEUE_CAP 帧的队列，传输层有空位（halWebSocketCanSend）时交出队首：
+//   - 状态帧新者覆盖：队列里尚未交出的状态帧直接换成最新一帧（每个状态帧都是完整状态）；
+//     固件更新进度帧同样按类别覆盖，每类在队列里最多一帧
+//   - 日志帧按顺序排队，只发给打开了日志面板的客户端；队列满时丢弃最旧的一帧日志并计数
+//   - 发送队列持续非空超过 WS_CLIENT_EVICT_MS 的客户端被断开，释放它引用的缓冲
+// 连接、断开、日志面板开关可以在任意任务中调用（经 MPSC 队列交给网络任务），其余只在网络任务中调用。
+
+enum WsFrameClass : uint8_t {
+  WS_CLASS_STATE,     // 状态帧（二进制状态帧或 JSON 状态），新者覆盖
+  WS_CLASS_LOG,       // 日志视图文本
+  WS_CLASS_PROGRESS   // 固件更新进度（JSON，见 ota.h），新者覆盖
+};
+
+struct WsClientStats {
+  uint32_t id;
+  uint8_t depth;      // 尚未交给传输层的帧数
+  uint8_t maxDepth;
+  bool logView;
+  uint32_t frames;    // 已交给传输层的帧数
+  uint32_t bytes;
+  uint32_t replaced;  // 被同类更新的帧覆盖（状态帧、进度帧）
+  uint32_t dropped;   // 队列满而丢弃的日志帧
+};
+
+struct WsFanoutStats {
+  uint32_t broadcasts;     // 分配了共享缓冲的广播帧
+  uint32_t broadcastBytes;
+  uint32_t allocFailures;
+  uint32_t evictions;
+  uint32_t rejected;       // 客户端已满或事件队列满时拒绝的连接
+  uint8_t clients;
+};
+
+void initializeWebSocketFanout();
+
+// 任意任务（Web 服务器的连接事件、客户端发来的 "log:1" / "log:0"）
+void wsClientConnected(uint32_t id);
+void wsClientDisconnected(uint32_t id);
+void wsSetLogView(uint32_t id, bool enabled);
+
+// 网络任务
+// 分配一次共享缓冲并放入每个接收者的队列，能立即交出的直接交出；没有接收者或内存不足时返回 false
+bool wsBroadcast(const uint8_t* data, size_t length, bool binary, WsFrameClass frameClass);
+// 处理连接事件，向有空位的客户端交出队首，断开长期落后的客户端；返回是否还有客户端积压
+bool pumpWebSocket();
+bool wsFanoutPending();  // 有连接事件或新的积压，runNetworkTask() 据此立即运行 pumpWebSocket()
+uint8_t wsLogViewers();  // 先处理挂起的连接事件
+
+const WsFanoutStats& wsFanoutStats();
+// 复制已连接客户端的统计（Web 服务器读取，各字段可能不是同一时刻的），返回个数
+uint8_t wsClientStats(WsClientStats* out, uint8_t capacity);
+
+#endif // WS_FANOUT_H
@@ -0,0 +1,41 @@
+#ifndef WS_PROTOCOL_H
+#define WS_PROTOCOL_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "hal.h"
+#include "tasks.h"
+#include "text_writer.h"
+#include "config.h"
+
+// ==================== WebSocket 状态协议 ====================
+// 二进制模式（默认）：状态变化时推送一帧，安静时每 WEBSOCKET_KEYFRAME_INTERVAL 推送一次关键帧，
+// 客户端连接或发送 "sync" 时立即推送关键帧。帧格式（小端，12 字节，按钮多于 8 个时 13 字节）：
+//   [0]     帧类型 WS_FRAME_DELTA / WS_FRAME_KEYFRAME
+//   [1]     按钮掩码的低 8 位，bit i 对应 BUTTON_PINS[i]
+//   [2]     LED 模式（LEDMode）
+//   [3]     绿色呼吸亮度
+//   [4..7]  帧序号，每帧加 1；慢速客户端的队列里状态帧新者覆盖（见 ws_fanout.h），序号可能跳跃
+//   [8..11] 状态变化时刻（毫秒）
+//   [12]    按钮掩码的高 8 位，只在按钮多于 8 个时存在
+// JSON 模式：与旧版本一致，每 WEBSOCKET_UPDATE_INTERVAL 广播一次 {"p13":true,...}
+// （同一 JSON 也是 /api/buttons 的响应）
+
+#define WS_PROTOCOL_BINARY 0
+#define WS_PROTOCOL_JSON 1
+
+#ifndef WEBSOCKET_PROTOCOL
+#define WEBSOCKET_PROTOCOL WS_PROTOCOL_BINARY
+#endif
+
+#define WS_FRAME_DELTA 0x01
+#define WS_FRAME_KEYFRAME 0x02
+#define WS_STATE_FRAME_SIZE (BTN_COUNT > 8 ? 13 : 12)
+
+// 每个按钮最多 12 字节（"p32":false,），加花括号和结尾 '\0'
+#define STATE_JSON_CAPACITY (BTN_COUNT * 12 + 3)
+
+size_t encodeStateFrame(uint8_t* out, const BallSnapshot& state, uint32_t sequence, uint8_t type);
+void encodeStateJSON(TextWriter& out, const BallSnapshot& state);
+
+#endif // WS_PROTOCOL_H
@@ -0,0 +1,103 @@
+#include <atomic>
+#include <utility>
+#include "button_events.h"
+#include "hal.h"
+#include "config.h"
+
+// ==================== SPSC 环形缓冲区 ====================
+static ButtonEvent queue[BUTTON_EVENT_QUEUE_SIZE];
+static std::atomic<uint16_t> head(0);  // 仅中断写
+static std::atomic<uint16_t> tail(0);  // 仅主循环写
+static std::atomic<bool> overflowPending(false);
+static std::atomic<bool> resyncPending(false);
+static ButtonEventStats stats;
+static uint8_t consumerTask = HAL_MAIN_TASK;
+
+static void IRAM_ATTR onButtonEdge(uint8_t index, int level, uint32_t timestampMicros) {
+  uint16_t h = head.load(std::memory_order_relaxed);
+  uint16_t t = tail.load(std::memory_order_acquire);
+
+  if ((uint16_t)(h - t) >= BUTTON_EVENT_QUEUE_SIZE) {
+    stats.dropped++;
+    overflowPending.store(true, std::memory_order_release);
+    return;
+  }
+
+  ButtonEvent& event = queue[h & (BUTTON_EVENT_QUEUE_SIZE - 1)];
+  event.timestampMicros = timestampMicros;
+  event.index = index;
+  event.level = (uint8_t)level;
+  head.store((uint16_t)(h + 1), std::memory_order_release);
+  stats.captured++;
+  halNotifyTaskFromISR(consumerTask);
+}
+
+void initializeButtonEvents(uint8_t notifyTask) {
+  consumerTask = notifyTask;
+  head.store(0);
+  tail.store(0);
+  overflowPending.store(false);
+  resyncPending.store(false);
+  stats = ButtonEventStats();
+
+  for (uint8_t i = 0; i < BTN_COUNT; i++) {
+    halAttachPinChange(BUTTON_PINS[i], i, onButtonEdge);
+  }
+}
+
+bool hasPendingButtonEvents() {
+  return head.load(std::memory_order_acquire) != tail.load(std::memory_order_relaxed) ||
+         overflowPending.load(std::memory_order_acquire) || resyncPending.load(std::memory_order_acquire);
+}
+
+bool popButtonEvent(ButtonEvent& event) {
+  uint16_t t = tail.load(std::memory_order_relaxed);
+  uint16_t h = head.load(std::memory_order_acquire);
+  if (t == h) {
+    return false;
+  }
+
+  uint16_t depth = (uint16_t)(h - t);
+  if (depth > stats.maxDepth) {
+    stats.maxDepth = depth;
+  }
+
+  event = queue[t & (BUTTON_EVENT_QUEUE_SIZE - 1)];
+  tail.store((uint16_t)(t + 1), std::memory_order_release);
+  return true;
+}
+
+void requestButtonResync() {
+  resyncPending.store(true, std::memory_order_release);
+}
+
+bool takeButtonEventResync() {
+  bool resync = false;
+  if (resyncPending.exchange(false, std::memory_order_acq_rel)) {
+    stats.resyncs++;
+    resync = true;
+  }
+  if (overflowPending.exchange(false, std::memory_order_acq_rel)) {
+    stats.overflows++;
+    resync = true;
+  }
+  return resync;
+}
+
+// 引脚号是编译期常量：每个按钮展开成一次移位、取位，没有循环和引脚表读取
+template <size_t... I>
+static inline uint32_t gatherPressed(uint64_t lowLevels, std::index_sequence<I...>) {
+  return (0u | ... | (uint32_t)(((lowLevels >> BUTTON_PINS[I]) & 1) << I));
+}
+
+uint32_t pressedMaskFromLevels(uint64_t levels) {
+  return gatherPressed(~levels, std::make_index_sequence<BTN_COUNT>());  // 低电平 = 按下
+}
+
+uint32_t sampleButtonMask() {
+  return pressedMaskFromLevels(halReadGPIOInputs());
+}
+
+const ButtonEventStats& buttonEventStats() {
+  return stats;
+}
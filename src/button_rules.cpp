@@ -0,0 +1,318 @@
+#include <stdio.h>
+#include <string.h>
+#include <atomic>
+#include "button_rules.h"
+#include "effects.h"
+#include "json_reader.h"
+#include "mqtt_outbox.h"
+#include "tasks.h"
+#include "hal.h"
+#include "log.h"
+
+// ==================== 默认规则 ====================
+// 与 data/rules.json 相同；优先级 故障（P13）> 重置（P32）> 绿色组全部按下 > 绿色组 > 默认，按钮角色见 config.h
+static const ButtonRule DEFAULT_RULES[] = {
+  // name         anyOf                       allOf               countMask           prio  ledMode            base step                   keep   action
+  {"fault",       BUTTON_MASK(FAULT_BUTTON),  0,                  0,                  40,   LED_FLASH_YELLOW,  0,   0,                     true,  RULE_NO_ACTION},
+  {"reset",       BUTTON_MASK(RESET_BUTTON),  0,                  0,                  30,   LED_BREATHE_RED,   0,   0,                     true,  MQTT_EVENT_RESET},
+  {"all_green",   0,                          GREEN_BUTTONS_MASK, GREEN_BUTTONS_MASK, 25,   LED_BREATHE_GREEN, 0,   GREEN_BRIGHTNESS_STEP, false, MQTT_EVENT_TRIGGERED},
+  {"green",       GREEN_BUTTONS_MASK,         0,                  GREEN_BUTTONS_MASK, 20,   LED_BREATHE_GREEN, 0,   GREEN_BRIGHTNESS_STEP, false, RULE_NO_ACTION},
+  {"idle",        0,                          0,                  0,                  0,    LED_BREATHE_RED,   0,   0,                     false, RULE_NO_ACTION},
+};
+
+// 重置按钮以外的按钮每次按下、松开都发布 firstTriggered
+struct EdgeTable {
+  EdgeAction v[BTN_COUNT];
+};
+
+static constexpr EdgeTable makeDefaultEdges() {
+  EdgeTable table{};
+  for (uint8_t i = 0; i < BTN_COUNT; i++) {
+    uint8_t action = (FIRST_TRIGGER_BUTTONS_MASK & BUTTON_MASK(i)) ? MQTT_EVENT_FIRST_TRIGGERED : RULE_NO_ACTION;
+    table.v[i] = EdgeAction{action, action};
+  }
+  return table;
+}
+
+static constexpr EdgeTable DEFAULT_EDGES = makeDefaultEdges();
+
+// ==================== 编译 ====================
+static bool ruleMatches(const ButtonRule& rule, uint32_t pressed) {
+  return (rule.anyOf == 0 || (pressed & rule.anyOf)) && (pressed & rule.allOf) == rule.allOf;
+}
+
+RuleOutcome evaluateRules(const ButtonRule* rules, uint8_t count, uint32_t pressed) {
+  uint8_t best = RULE_NONE;
+  for (uint8_t r = 0; r < count; r++) {
+    if (ruleMatches(rules[r], pressed) &&
+        (best == RULE_NONE || rules[r].priority > rules[best].priority)) {
+      best = r;
+    }
+  }
+
+  RuleOutcome outcome;
+  outcome.rule = best;
+  if (best == RULE_NONE) {
+    outcome.ledMode = 0;
+    outcome.brightness = 0;
+    outcome.keepBrightness = true;
+    return outcome;
+  }
+  const ButtonRule& rule = rules[best];
+  uint32_t level = rule.brightnessBase +
+                   (uint32_t)rule.brightnessStep * __builtin_popcount(pressed & rule.countMask);
+  outcome.ledMode = rule.ledMode;
+  outcome.brightness = level > 255 ? 255 : (uint8_t)level;
+  outcome.keepBrightness = rule.keepBrightness;
+  return outcome;
+}
+
+bool compileRules(RuleSet& out, const ButtonRule* rules, uint8_t count, const EdgeAction* edges) {
+  if (count > RULE_MAX) {
+    return false;
+  }
+  memcpy(out.rules, rules, count * sizeof(ButtonRule));
+  memcpy(out.edges, edges, sizeof(out.edges));
+  out.ruleCount = count;
+  for (uint32_t pressed = 0; pressed < RULE_TABLE_SIZE; pressed++) {
+    out.table[pressed] = evaluateRules(rules, count, pressed);
+  }
+  return true;
+}
+
+void compileDefaultRules(RuleSet& out) {
+  compileRules(out, DEFAULT_RULES, sizeof(DEFAULT_RULES) / sizeof(DEFAULT_RULES[0]), DEFAULT_EDGES.v);
+}
+
+// ==================== JSON ====================
+static const char* const ACTION_NAMES[NUM_MQTT_EVENTS] = {"firstTriggered", "triggered", "reset"};
+
+static bool lookupName(const char* name, const char* const* names, uint8_t count, uint8_t& index) {
+  for (uint8_t i = 0; i < count; i++) {
+    if (!strcmp(name, names[i])) {
+      index = i;
+      return true;
+    }
+  }
+  return false;
+}
+
+// 引脚号列表 → 按钮掩码
+static bool readPins(JsonReader& reader, uint32_t& mask) {
+  mask = 0;
+  reader.expect('[');
+  while (reader.more(']')) {
+    uint32_t pin;
+    if (!reader.u32(pin)) return false;
+    uint8_t i = buttonIndexOfPin(pin);
+    if (i == BTN_COUNT) return false;
+    mask |= BUTTON_MASK(i);
+  }
+  return reader.ok();
+}
+
+static bool readAction(JsonReader& reader, uint8_t& action) {
+  if (reader.null()) {
+    action = RULE_NO_ACTION;
+    return true;
+  }
+  char name[24];
+  return reader.string(name, sizeof(name)) && lookupName(name, ACTION_NAMES, NUM_MQTT_EVENTS, action);
+}
+
+static bool readByte(JsonReader& reader, uint8_t& value) {
+  uint32_t v;
+  if (!reader.u32(v) || v > 255) return false;
+  value = (uint8_t)v;
+  return true;
+}
+
+static bool readRule(JsonReader& reader, ButtonRule& rule) {
+  memset(&rule, 0, sizeof(rule));
+  rule.action = RULE_NO_ACTION;
+  rule.ledMode = 0xFF;
+
+  char key[16];
+  reader.expect('{');
+  while (reader.more('}')) {
+    if (!reader.key(key, sizeof(key))) return false;
+    bool ok;
+    if (!strcmp(key, "name")) {
+      ok = reader.string(rule.name, sizeof(rule.name));
+    } else if (!strcmp(key, "any")) {
+      ok = readPins(reader, rule.anyOf);
+    } else if (!strcmp(key, "all")) {
+      ok = readPins(reader, rule.allOf);
+    } else if (!strcmp(key, "count")) {
+      ok = readPins(reader, rule.countMask);
+    } else if (!strcmp(key, "priority")) {
+      ok = readByte(reader, rule.priority);
+    } else if (!strcmp(key, "base")) {
+      ok = readByte(reader, rule.brightnessBase);
+    } else if (!strcmp(key, "step")) {
+      ok = readByte(reader, rule.brightnessStep);
+    } else if (!strcmp(key, "keep")) {
+      ok = reader.boolean(rule.keepBrightness);
+    } else if (!strcmp(key, "action")) {
+      ok = readAction(reader, rule.action);
+    } else if (!strcmp(key, "mode")) {
+      char name[24];
+      ok = reader.string(name, sizeof(name)) && findLEDMode(name, rule.ledMode);
+    } else {
+      ok = reader.skip();
+    }
+    if (!ok) return false;
+  }
+  return reader.ok() && rule.ledMode != 0xFF;
+}
+
+// {"pins":[...],"press":"...","release":"..."}：给一组按钮设置同样的边沿动作
+static bool readEdges(JsonReader& reader, EdgeAction* edges) {
+  uint32_t mask = 0;
+  EdgeAction action = {RULE_NO_ACTION, RULE_NO_ACTION};
+  char key[16];
+  reader.expect('{');
+  while (reader.more('}')) {
+    if (!reader.key(key, sizeof(key))) return false;
+    bool ok;
+    if (!strcmp(key, "pins")) {
+      ok = readPins(reader, mask);
+    } else if (!strcmp(key, "press")) {
+      ok = readAction(reader, action.onPress);
+    } else if (!strcmp(key, "release")) {
+      ok = readAction(reader, action.onRelease);
+    } else {
+      ok = reader.skip();
+    }
+    if (!ok) return false;
+  }
+  for (uint8_t i = 0; i < BTN_COUNT; i++) {
+    if (mask & BUTTON_MASK(i)) {
+      edges[i] = action;
+    }
+  }
+  return reader.ok();
+}
+
+static bool parseFailed(const JsonReader& reader, const char* what, char* error, size_t capacity) {
+  snprintf(error, capacity, "%s（位置 %u）", what, (unsigned)reader.offset());
+  return false;
+}
+
+bool parseRulesJSON(RuleSet& out, const char* text, size_t length, char* error, size_t errorCapacity) {
+  ButtonRule rules[RULE_MAX];
+  uint8_t count = 0;
+  EdgeAction edges[BTN_COUNT];
+  for (EdgeAction& edge : edges) {
+    edge = EdgeAction{RULE_NO_ACTION, RULE_NO_ACTION};
+  }
+
+  JsonReader reader(text, length);
+  char key[16];
+  reader.expect('{');
+  while (reader.more('}')) {
+    if (!reader.key(key, sizeof(key))) {
+      return parseFailed(reader, "语法错误", error, errorCapacity);
+    }
+    if (!strcmp(key, "rules")) {
+      reader.expect('[');
+      while (reader.more(']')) {
+        if (count == RULE_MAX) {
+          return parseFailed(reader, "规则过多", error, errorCapacity);
+        }
+        if (!readRule(reader, rules[count++])) {
+          return parseFailed(reader, "规则无效", error, errorCapacity);
+        }
+      }
+    } else if (!strcmp(key, "edges")) {
+      reader.expect('[');
+      while (reader.more(']')) {
+        if (!readEdges(reader, edges)) {
+          return parseFailed(reader, "边沿动作无效", error, errorCapacity);
+        }
+      }
+    } else if (!reader.skip()) {
+      return parseFailed(reader, "语法错误", error, errorCapacity);
+    }
+  }
+  if (!reader.ok()) {
+    return parseFailed(reader, "语法错误", error, errorCapacity);
+  }
+  if (count == 0) {
+    return parseFailed(reader, "没有规则", error, errorCapacity);
+  }
+  return compileRules(out, rules, count, edges);
+}
+
+// ==================== 运行时 ====================
+static RuleSet active;
+static RuleSet staging;
+static std::atomic<bool> stagingReady(false);
+
+static bool loadRulesFile(RuleSet& out) {
+  static char text[RULES_JSON_CAPACITY];
+  int32_t length = halFileRead(RULES_FILE_PATH, text, sizeof(text));
+  if (length < 0) {
+    return false;
+  }
+  char error[48];
+  if (!parseRulesJSON(out, text, (size_t)length, error, sizeof(error))) {
+    LOG_WARN(LOG_RULES_FILE_INVALID, RULES_FILE_PATH, logText(error));
+    return false;
+  }
+  return true;
+}
+
+void initializeButtonRules() {
+  stagingReady = false;
+  if (loadRulesFile(active)) {
+    LOG_INFO(LOG_RULES_LOADED, RULES_FILE_PATH, active.ruleCount);
+  } else {
+    compileDefaultRules(active);
+  }
+}
+
+const RuleSet& activeRules() {
+  return active;
+}
+
+bool submitRulesJSON(const char* text, size_t length, bool persist) {
+  if (stagingReady.load(std::memory_order_acquire)) {
+    LOG_WARN(LOG_RULES_BUSY);
+    return false;
+  }
+  char error[48];
+  if (!parseRulesJSON(staging, text, length, error, sizeof(error))) {
+    LOG_WARN(LOG_RULES_INVALID, logText(error));
+    return false;
+  }
+  if (persist && !halFileWrite(RULES_FILE_PATH, text, length)) {
+    LOG_ERROR(LOG_RULES_WRITE_FAILED);
+  }
+  stagingReady.store(true, std::memory_order_release);
+  halNotifyTask(TASK_RENDER);
+  return true;
+}
+
+bool reloadRulesFile() {
+  if (stagingReady.load(std::memory_order_acquire) || !loadRulesFile(staging)) {
+    return false;
+  }
+  stagingReady.store(true, std::memory_order_release);
+  halNotifyTask(TASK_RENDER);
+  return true;
+}
+
+bool rulesPending() {
+  return stagingReady.load(std::memory_order_acquire);
+}
+
+bool takePendingRules() {
+  if (!stagingReady.load(std::memory_order_acquire)) {
+    return false;
+  }
+  active = staging;
+  stagingReady.store(false, std::memory_order_release);
+  LOG_INFO(LOG_RULES_UPDATED, active.ruleCount);
+  return true;
+}
@@ -0,0 +1,635 @@
+#include <string.h>
+#include <atomic>
+#include "clips.h"
+#include "log.h"
+#include "tasks.h"
+#include "sector_ring.h"
+
+static_assert(LED_MAX_PIXELS * 4 <= UINT16_MAX, "整帧 RLE 载荷长度必须放得下 16 位");
+
+// ==================== CRC-32 ====================
+struct Crc32Table {
+  uint32_t entries[256];
+};
+
+static constexpr Crc32Table makeCrc32Table() {
+  Crc32Table table = {};
+  for (uint32_t i = 0; i < 256; i++) {
+    uint32_t c = i;
+    for (uint8_t bit = 0; bit < 8; bit++) {
+      c = (c & 1) ? (0xEDB88320UL ^ (c >> 1)) : (c >> 1);
+    }
+    table.entries[i] = c;
+  }
+  return table;
+}
+
+static constexpr Crc32Table CRC32_TABLE = makeCrc32Table();
+
+uint32_t clipCRC32(uint32_t crc, const uint8_t* data, size_t length) {
+  crc = ~crc;
+  for (size_t i = 0; i < length; i++) {
+    crc = CRC32_TABLE.entries[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+  }
+  return ~crc;
+}
+
+// ==================== 解码 ====================
+size_t decodeClipFrame(const uint8_t* frame, size_t available, uint16_t pixels, CRGB* out, uint16_t count) {
+  if (available < CLIP_FRAME_HEADER_SIZE) {
+    return 0;
+  }
+  size_t length = frame[1] | (frame[2] << 8);
+  if (length > available - CLIP_FRAME_HEADER_SIZE) {
+    return 0;
+  }
+  const uint8_t* p = frame + CLIP_FRAME_HEADER_SIZE;
+  const uint8_t* end = p + length;
+  uint32_t visible = pixels < count ? pixels : count;
+  uint32_t at = 0;
+
+  switch (frame[0]) {
+    case CLIP_FRAME_RAW:
+      if (length != pixels * 3u) {
+        return 0;
+      }
+      memcpy(out, p, visible * 3);
+      break;
+
+    case CLIP_FRAME_RLE:
+      for (; end - p >= 4; p += 4) {
+        uint32_t run = p[0] + 1u;
+        if (at + run > pixels) {
+          return 0;
+        }
+        CRGB color(p[1], p[2], p[3]);
+        uint32_t stop = at + run < visible ? at + run : visible;
+        for (uint32_t i = at; i < stop; i++) {
+          out[i] = color;
+        }
+        at += run;
+      }
+      if (p != end || at != pixels) {
+        return 0;
+      }
+      break;
+
+    case CLIP_FRAME_DELTA:
+      while (end - p >= 2) {
+        at += p[0];
+        uint32_t n = p[1];
+        p += 2;
+        if (at + n > pixels || (size_t)(end - p) < n * 3) {
+          return 0;
+        }
+        if (at < visible) {
+          memcpy(out + at, p, ((at + n < visible ? at + n : visible) - at) * 3);
+        }
+        at += n;
+        p += n * 3;
+      }
+      if (p != end) {
+        return 0;
+      }
+      break;
+
+    default:
+      return 0;
+  }
+  return CLIP_FRAME_HEADER_SIZE + length;
+}
+
+const ClipEntry* validateClipBundle(const uint8_t* data, size_t size, bool verifyCRC, uint8_t& count) {
+  count = 0;
+  if (!data || size < sizeof(ClipBundleHeader)) {
+    return nullptr;
+  }
+  const ClipBundleHeader& header = *(const ClipBundleHeader*)data;
+  size_t directoryEnd = sizeof(ClipBundleHeader) + header.count * sizeof(ClipEntry);
+  if (memcmp(header.magic, "BCLP", 4) != 0 || header.version != CLIP_FORMAT_VERSION ||
+      header.count > CLIP_MAX || header.length > size || header.length < directoryEnd) {
+    return nullptr;
+  }
+  if (verifyCRC &&
+      clipCRC32(0, data + sizeof(ClipBundleHeader), header.length - sizeof(ClipBundleHeader)) != header.crc) {
+    return nullptr;
+  }
+  const ClipEntry* entries = (const ClipEntry*)(data + sizeof(ClipBundleHeader));
+  for (uint8_t i = 0; i < header.count; i++) {
+    const ClipEntry& e = entries[i];
+    if (e.name[0] == '\0' || !memchr(e.name, '\0', CLIP_NAME_LENGTH) ||
+        e.offset < directoryEnd || e.offset > header.length || e.length > header.length - e.offset ||
+        e.length < CLIP_FRAME_HEADER_SIZE || e.frames == 0 || e.pixels == 0 || e.pixels > LED_MAX_PIXELS ||
+        e.fps == 0 || e.fps > CLIP_MAX_FPS || data[e.offset] == CLIP_FRAME_DELTA) {
+      return nullptr;
+    }
+  }
+  count = header.count;
+  return entries;
+}
+
+// ==================== 存储 ====================
+// 读者（渲染任务的播放器、网络任务的目录查询）先登记再检查状态；上传把状态切到 WRITING，写入任务等登记数归零
+// 后才擦写，此后新的读者看到 WRITING 直接放弃，擦写期间没有人读映射。
+#define CLIP_READER_WAIT_US 1000  // 写入任务等读者退出时的重试间隔：渲染任务最多还在解码一帧
+
+static const uint8_t* partition = nullptr;
+static size_t partitionSize = 0;
+static std::atomic<uint8_t> storeState(CLIP_STORE_EMPTY);
+static std::atomic<uint8_t> readers(0);
+static std::atomic<uint32_t> generation(0);  // 每次包生效加一，播放器据此重新查找片段
+static const ClipEntry* directory = nullptr;  // 只在没有读者时改写
+static uint8_t directoryCount = 0;
+static ClipStats stats;  // 播放计数，仅渲染任务写
+static std::atomic<uint32_t> uploadCount(0);  // 仅写入任务写
+static std::atomic<uint32_t> rejectCount(0);  // 上传回调和写入任务都会拒绝
+
+// 上传：接收方（AsyncTCP 的上传回调）把头部收在 RAM 里，其余字节经 flashRing（sector_ring.h，与固件更新共用）
+// 交给 flash 写入任务；回调里不擦写 flash，也不等读者
+struct ClipUpload {
+  size_t length;
+  size_t received;
+  uint8_t header[sizeof(ClipBundleHeader)];  // receivedAll 之后写入任务才读
+};
+
+struct ClipWriter {
+  bool started;     // 已清空目录、擦除旧头部
+  size_t written;   // 下一块的写入偏移
+  size_t erasedTo;  // 已擦除到的偏移（扇区边界）
+  uint32_t crc;     // 头部之后的字节
+};
+
+static ClipUpload upload;     // 仅接收方
+static bool receiving = false;  // 仅接收方
+static ClipWriter writer;     // 仅写入任务
+static std::atomic<bool> receivedAll(false);     // 接收方收齐、通过长度检查
+static std::atomic<bool> abortRequested(false);  // 接收方失败或连接断开，写入任务放弃后清除
+static std::atomic<const char*> failReason(nullptr);  // 本次上传第一个失败原因
+
+static bool beginRead() {
+  readers.fetch_add(1);
+  if (storeState.load() == CLIP_STORE_READY) {
+    return true;
+  }
+  readers.fetch_sub(1, std::memory_order_release);
+  return false;
+}
+
+static void endRead() {
+  readers.fetch_sub(1, std::memory_order_release);
+}
+
+static size_t bundleLength() {
+  return ((const ClipBundleHeader*)partition)->length;
+}
+
+void initializeClips() {
+  if (flashRing.owner() == RING_CLIPS) {
+    flashRing.release();  // 主机上同一进程里多次启动：放掉上一次没有完成的上传
+  }
+  receiving = false;
+  writer.started = false;
+  receivedAll.store(false);
+  abortRequested.store(false);
+  partition = halPartitionMap(CLIP_PARTITION_LABEL, partitionSize);
+  directory = validateClipBundle(partition, partitionSize, true, directoryCount);
+  if (directory) {
+    generation.fetch_add(1);
+    storeState.store(CLIP_STORE_READY);
+    LOG_INFO(LOG_CLIPS_READY, directoryCount, bundleLength());
+  } else {
+    storeState.store(CLIP_STORE_EMPTY);
+    if (partition && partition[0] != 0xFF) {
+      LOG_WARN(LOG_CLIPS_CORRUPT);  // 擦除过的分区全是 0xFF，不算损坏
+    }
+  }
+}
+
+ClipStoreState clipStoreState() {
+  return (ClipStoreState)storeState.load(std::memory_order_acquire);
+}
+
+ClipStats clipStats() {
+  ClipStats s = stats;
+  s.uploads = uploadCount.load(std::memory_order_relaxed);
+  s.rejected = rejectCount.load(std::memory_order_relaxed);
+  return s;
+}
+
+void encodeClipsJSON(TextWriter& out) {
+  static const char* const STATE_NAMES[] = {"empty", "ready", "writing"};
+  out.beginObject();
+  out.key("state").put('"').raw(STATE_NAMES[clipStoreState()]).put('"');
+  out.field("capacity", partitionSize)
+     .field("uploads", uploadCount.load(std::memory_order_relaxed))
+     .field("rejected", rejectCount.load(std::memory_order_relaxed));
+  const char* error = failReason.load(std::memory_order_acquire);
+  if (error) {
+    out.key("error").put('"').raw(error).put('"');  // 最近一次上传的失败原因
+  }
+  bool reading = beginRead();
+  out.field("bytes", reading ? bundleLength() : 0);
+  out.key("clips").put('[');
+  for (uint8_t i = 0; reading && i < directoryCount; i++) {
+    const ClipEntry& e = directory[i];
+    if (i) {
+      out.put(',');
+    }
+    out.beginObject();
+    out.key("name").put('"').raw(e.name).put('"');
+    out.field("frames", e.frames)
+       .field("fps", e.fps)
+       .field("pixels", e.pixels)
+       .field("bytes", e.length)
+       .flag("loop", (e.flags & CLIP_FLAG_LOOP) != 0)
+       .endObject();
+  }
+  if (reading) {
+    endRead();
+  }
+  out.put(']').endObject();
+}
+
+// ==================== 上传 ====================
+// 开始之前的拒绝（没有分区、长度不对、缓冲区被占用）不影响现有的包，也不影响正在进行的上传
+static bool rejectUpload(const char* reason) {
+  rejectCount.fetch_add(1, std::memory_order_relaxed);
+  LOG_WARN(LOG_CLIP_UPLOAD_REJECTED, reason);
+  return false;
+}
+
+bool clipUploadBegin(size_t length) {
+  if (!partition) {
+    return rejectUpload("no partition");
+  }
+  if (length < sizeof(ClipBundleHeader) || length > partitionSize) {
+    return rejectUpload("size");
+  }
+  if (!flashRing.acquire(RING_CLIPS)) {
+    return rejectUpload("busy");  // 固件更新或另一个片段上传
+  }
+  receiving = true;
+  upload.length = length;
+  upload.received = 0;
+  failReason.store(nullptr, std::memory_order_relaxed);
+  storeState.store(CLIP_STORE_WRITING);  // 新的读者放弃；现有读者退出后写入任务才擦除
+  halNotifyTask(TASK_OTA);
+  return true;
+}
+
+// 接收方的失败交给写入任务：它放弃写入、恢复状态后才释放缓冲区
+static void failReceive(const char* reason) {
+  receiving = false;
+  const char* none = nullptr;
+  failReason.compare_exchange_strong(none, reason, std::memory_order_acq_rel);
+  abortRequested.store(true, std::memory_order_release);
+  halNotifyTask(TASK_OTA);
+}
+
+bool clipUploadWrite(const uint8_t* data, size_t length) {
+  if (!receiving) {
+    return false;
+  }
+  if (length > upload.length - upload.received) {
+    failReceive("size");
+    return false;
+  }
+  // 头部最后写：先收在 RAM 里
+  while (length > 0 && upload.received < sizeof(ClipBundleHeader)) {
+    upload.header[upload.received++] = *data++;
+    length--;
+  }
+  SectorRingResult result = flashRing.append(data, length);
+  if (result == RING_STOPPED) {
+    receiving = false;  // 写入任务已经失败
+    return false;
+  }
+  if (result == RING_TIMEOUT) {
+    failReceive("flash write timeout");
+    return false;
+  }
+  upload.received += length;
+  if (upload.received == upload.length) {
+    flashRing.flush();
+  }
+  return true;
+}
+
+bool clipUploadEnd() {
+  if (!receiving) {
+    return false;
+  }
+  const ClipBundleHeader& header = *(const ClipBundleHeader*)upload.header;
+  if (upload.received != upload.length || header.length != upload.length) {
+    failReceive("size");
+    return false;
+  }
+  receiving = false;
+  receivedAll.store(true, std::memory_order_release);
+  halNotifyTask(TASK_OTA);
+  return true;
+}
+
+void clipUploadAbort() {
+  if (receiving) {
+    failReceive("aborted");
+  }
+}
+
+const char* clipUploadError() {
+  return failReason.load(std::memory_order_acquire);
+}
+
+// ==================== 写入任务 ====================
+// 结束本次上传并释放缓冲区。失败时还没开始擦写的话原来的包仍然有效，否则分区没有有效头部，按空处理
+static void finishUpload(const char* reason) {
+  if (reason) {
+    const char* none = nullptr;
+    failReason.compare_exchange_strong(none, reason, std::memory_order_acq_rel);
+    rejectCount.fetch_add(1, std::memory_order_relaxed);
+    LOG_WARN(LOG_CLIP_UPLOAD_REJECTED, failReason.load(std::memory_order_acquire));
+    storeState.store(directory ? CLIP_STORE_READY : CLIP_STORE_EMPTY);
+    flashRing.stop();  // 阻塞中的接收方立即返回
+  }
+  writer.started = false;
+  receivedAll.store(false, std::memory_order_relaxed);
+  abortRequested.store(false, std::memory_order_relaxed);
+  flashRing.release();
+}
+
+// 全部字节已写入：CRC 对上后写头部，新包立即生效
+static void finishBundle() {
+  const ClipBundleHeader& header = *(const ClipBundleHeader*)upload.header;
+  if (header.crc != writer.crc) {
+    finishUpload("crc");
+    return;
+  }
+  if (!halPartitionWrite(CLIP_PARTITION_LABEL, 0, upload.header, sizeof(upload.header))) {
+    finishUpload("write");
+    return;
+  }
+  // 内容已在 flash 里，CRC 也对上了，只检查目录结构
+  uint8_t count = 0;
+  const ClipEntry* entries = validateClipBundle(partition, partitionSize, false, count);
+  if (!entries) {
+    halPartitionErase(CLIP_PARTITION_LABEL, 0, HAL_FLASH_SECTOR_SIZE);  // 去掉头部，重启后也按空处理
+    finishUpload("directory");
+    return;
+  }
+  directory = entries;
+  directoryCount = count;
+  generation.fetch_add(1);
+  storeState.store(CLIP_STORE_READY);
+  uploadCount.fetch_add(1, std::memory_order_relaxed);
+  LOG_INFO(LOG_CLIP_UPLOAD_DONE, count, upload.length);
+  finishUpload(nullptr);
+}
+
+uint32_t runClipWriter() {
+  if (flashRing.owner() != RING_CLIPS) {
+    return UINT32_MAX;
+  }
+  if (abortRequested.load(std::memory_order_acquire)) {
+    finishUpload("aborted");
+    return UINT32_MAX;
+  }
+  if (!writer.started) {
+    if (storeState.load() != CLIP_STORE_WRITING || readers.load() != 0) {
+      return CLIP_READER_WAIT_US;
+    }
+    directory = nullptr;
+    directoryCount = 0;
+    // 先擦掉旧头部：之后无论在哪一步中断，分区里都没有有效的包
+    if (!halPartitionErase(CLIP_PARTITION_LABEL, 0, HAL_FLASH_SECTOR_SIZE)) {
+      finishUpload("erase");
+      return UINT32_MAX;
+    }
+    writer.started = true;
+    writer.written = sizeof(ClipBundleHeader);
+    writer.erasedTo = HAL_FLASH_SECTOR_SIZE;
+    writer.crc = 0;
+  }
+
+  const uint8_t* block;
+  size_t length;
+  while (!abortRequested.load(std::memory_order_acquire) && flashRing.front(block, length)) {
+    size_t end = writer.written + length;
+    while (writer.erasedTo < end) {
+      if (!halPartitionErase(CLIP_PARTITION_LABEL, writer.erasedTo, HAL_FLASH_SECTOR_SIZE)) {
+        finishUpload("erase");
+        return UINT32_MAX;
+      }
+      writer.erasedTo += HAL_FLASH_SECTOR_SIZE;
+    }
+    if (!halPartitionWrite(CLIP_PARTITION_LABEL, writer.written, block, length)) {
+      finishUpload("write");
+      return UINT32_MAX;
+    }
+    writer.crc = clipCRC32(writer.crc, block, length);
+    writer.written = end;
+    flashRing.pop();
+  }
+  if (abortRequested.load(std::memory_order_acquire)) {
+    finishUpload("aborted");
+  } else if (receivedAll.load(std::memory_order_acquire) && flashRing.empty()) {
+    finishBundle();
+  }
+  return UINT32_MAX;
+}
+
+// ==================== 模式名 ====================
+#define CLIP_MODE_PREFIX_LENGTH (sizeof(CLIP_MODE_PREFIX) - 1)
+
+static char modeNames[CLIP_MODE_MAX][CLIP_MODE_PREFIX_LENGTH + CLIP_NAME_LENGTH];
+static std::atomic<uint8_t> modeCount(0);  // 名称先写好再发布
+static std::atomic_flag registering = ATOMIC_FLAG_INIT;  // Web 上传和 MQTT 可能同时解析规则，登记逐个进行
+
+static bool findRegisteredClipMode(const char* name, uint8_t count, uint8_t& mode) {
+  for (uint8_t i = 0; i < count; i++) {
+    if (strcmp(modeNames[i], name) == 0) {
+      mode = LED_CLIP_FIRST + i;
+      return true;
+    }
+  }
+  return false;
+}
+
+bool findClipMode(const char* name, uint8_t& mode) {
+  if (strncmp(name, CLIP_MODE_PREFIX, CLIP_MODE_PREFIX_LENGTH) != 0) {
+    return false;
+  }
+  size_t length = strlen(name + CLIP_MODE_PREFIX_LENGTH);
+  if (length == 0 || length >= CLIP_NAME_LENGTH) {
+    return false;
+  }
+  if (findRegisteredClipMode(name, modeCount.load(std::memory_order_acquire), mode)) {
+    return true;
+  }
+  while (registering.test_and_set(std::memory_order_acquire)) {
+  }
+  uint8_t count = modeCount.load(std::memory_order_relaxed);
+  bool found = findRegisteredClipMode(name, count, mode);
+  if (!found && count < CLIP_MODE_MAX) {
+    memcpy(modeNames[count], name, CLIP_MODE_PREFIX_LENGTH + length + 1);
+    modeCount.store(count + 1, std::memory_order_release);
+    mode = LED_CLIP_FIRST + count;
+    found = true;
+  }
+  registering.clear(std::memory_order_release);
+  if (!found) {
+    LOG_WARN(LOG_CLIP_MODES_FULL, logText(name));
+  }
+  return found;
+}
+
+bool clipModeRegistered(uint8_t mode) {
+  return isClipMode(mode) && mode - LED_CLIP_FIRST < modeCount.load(std::memory_order_acquire);
+}
+
+const char* clipModeName(uint8_t mode) {
+  return clipModeRegistered(mode) ? modeNames[mode - LED_CLIP_FIRST] : "?";
+}
+
+// ==================== 播放（渲染任务） ====================
+static const Effect CLIP_EFFECT = {EFFECT_CLIP, CRGB(0, 0, 0), CRGB(0, 0, 0), 0, EFFECT_FRAME_INTERVAL, LED_RENDER_BUDGET_US, false};
+
+// 名称表每一项在当前包里对应的片段，包生效（generation 变化）后重新查找
+struct ClipSlot {
+  uint32_t generation;  // 0：未查找
+  const ClipEntry* entry;
+  Effect effect;
+};
+
+struct ClipPlayer {
+  uint8_t mode;           // 0：没有在播放
+  uint16_t count;
+  uint32_t generation;
+  const ClipEntry* entry;
+  const uint8_t* next;    // 下一帧的帧头
+  uint32_t nextFrame;
+  uint32_t lastElapsed;
+  bool failed;            // 数据损坏，保持黑色直到重新开始
+};
+
+static ClipSlot slots[CLIP_MODE_MAX];
+static ClipPlayer player;
+
+// 在 beginRead() 之内调用
+static ClipSlot& resolveSlot(uint8_t slotIndex, uint32_t current) {
+  ClipSlot& slot = slots[slotIndex];
+  if (slot.generation == current) {
+    return slot;
+  }
+  const char* clipName = modeNames[slotIndex] + CLIP_MODE_PREFIX_LENGTH;
+  slot.generation = current;
+  slot.entry = nullptr;
+  slot.effect = CLIP_EFFECT;
+  for (uint8_t i = 0; i < directoryCount; i++) {
+    if (strncmp(directory[i].name, clipName, CLIP_NAME_LENGTH) == 0) {
+      slot.entry = &directory[i];
+      slot.effect.framePeriodMillis = 1000 / directory[i].fps;
+      break;
+    }
+  }
+  if (!slot.entry) {
+    LOG_WARN(LOG_CLIP_MISSING, logText(clipName));
+  }
+  return slot;
+}
+
+static void unresolveSlot(uint8_t slotIndex) {
+  slots[slotIndex].generation = 0;
+  slots[slotIndex].entry = nullptr;
+  slots[slotIndex].effect = CLIP_EFFECT;
+}
+
+const Effect& clipModeEffect(uint8_t mode) {
+  if (!clipModeRegistered(mode)) {
+    return CLIP_EFFECT;
+  }
+  uint8_t slotIndex = mode - LED_CLIP_FIRST;
+  if (beginRead()) {
+    resolveSlot(slotIndex, generation.load());
+    endRead();
+  } else {
+    unresolveSlot(slotIndex);
+  }
+  return slots[slotIndex].effect;
+}
+
+void stopClipPlayback() {
+  player.mode = 0;
+}
+
+bool renderClipFrame(uint8_t mode, CRGB* out, uint16_t count, uint32_t elapsedMillis) {
+  if (!clipModeRegistered(mode)) {
+    fill_solid(out, count, CRGB::Black);
+    player.mode = 0;
+    return true;
+  }
+  uint8_t slotIndex = mode - LED_CLIP_FIRST;
+  uint16_t period = slots[slotIndex].effect.framePeriodMillis;
+  bool reading = beginRead();
+  const ClipEntry* entry = nullptr;
+  uint32_t current = 0;
+  if (reading) {
+    current = generation.load();
+    entry = resolveSlot(slotIndex, current).entry;
+  } else {
+    unresolveSlot(slotIndex);
+  }
+
+  // out 里必须是这个片段的上一帧，DELTA 帧才能叠加上去
+  if (mode != player.mode || count != player.count || current != player.generation ||
+      entry != player.entry || elapsedMillis < player.lastElapsed) {
+    player.mode = mode;
+    player.count = count;
+    player.generation = current;
+    player.entry = entry;
+    player.next = entry ? partition + entry->offset : nullptr;
+    player.nextFrame = 0;
+    player.failed = false;
+    fill_solid(out, count, CRGB::Black);
+    if (entry) {
+      stats.restarts++;
+    }
+  }
+  player.lastElapsed = elapsedMillis;
+
+  if (entry && !player.failed) {
+    uint32_t target = (uint32_t)((uint64_t)elapsedMillis * entry->fps / 1000);
+    if (entry->flags & CLIP_FLAG_LOOP) {
+      target %= entry->frames;
+    } else if (target >= entry->frames) {
+      target = entry->frames - 1;
+    }
+    if (target + 1 < player.nextFrame) {
+      player.next = partition + entry->offset;  // 循环回到开头
+      player.nextFrame = 0;
+      stats.restarts++;
+    }
+    const uint8_t* clipEnd = partition + entry->offset + entry->length;
+    while (player.nextFrame <= target) {
+      size_t used = decodeClipFrame(player.next, clipEnd - player.next, entry->pixels, out, count);
+      if (used == 0) {
+        player.failed = true;
+        stats.errors++;
+        fill_solid(out, count, CRGB::Black);
+        LOG_ERROR(LOG_CLIP_FRAME_INVALID, logText(entry->name), player.nextFrame);
+        break;
+      }
+      player.next += used;
+      player.nextFrame++;
+      stats.framesDecoded++;
+      if (player.nextFrame <= target) {
+        stats.framesSkipped++;
+      }
+    }
+  } else if (!entry) {
+    fill_solid(out, count, CRGB::Black);
+  }
+  if (reading) {
+    endRead();
+  }
+  return slots[slotIndex].effect.framePeriodMillis == period;
+}
@@ -1,9 +1,5 @@
 #include "config.h"
 
-// 按钮引脚定义
-const uint8_t BUTTON_PINS[] = {13, 12, 14, 27, 26, 25, 32};
-const uint8_t NUM_BUTTONS = sizeof(BUTTON_PINS) / sizeof(BUTTON_PINS[0]);
-
 // WiFi 配置
 const char* WIFI_SSID = "LC_01";
 const char* WIFI_PASSWORD = "12345678";
@@ -16,3 +12,10 @@ const char* MQTT_PASSWORD = "";
 const char* MQTT_TOPIC_SUB = "ball/triggered";
 const char* MQTT_TOPIC_RESET = "btn/resetAll";
 const char* MQTT_TOPIC_FIRST_TRIGGERED = "ball/firstTriggered";
+const char* MQTT_TOPIC_RULES = "ball/rules";
+const char* MQTT_TOPIC_METRICS = "ball/metrics";
+const char* MQTT_TOPIC_TRACE = "ball/trace";
+const char* MQTT_DEVICE_ID = "ball1";
+
+// 日志配置
+const char* SYSLOG_SERVER = "";
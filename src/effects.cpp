@@ -0,0 +1,245 @@
+#include "effects.h"
+#include "clips.h"
+
+#include <string.h>
+
+// ==================== 编译期查找表 ====================
+// 主机和 ESP32 都在编译期算好，放在只读数据段（ESP32 上在 flash），运行时不做浮点运算。
+struct Lut8 {
+  uint8_t v[256];
+  constexpr uint8_t operator[](uint8_t i) const { return v[i]; }
+};
+
+static constexpr double PI_D = 3.14159265358979323846;
+
+static constexpr double constSqrt(double x) {
+  double r = x > 1.0 ? x : 1.0;
+  for (int i = 0; i < 64; i++) {
+    r = 0.5 * (r + x / r);
+  }
+  return x > 0.0 ? r : 0.0;
+}
+
+// 泰勒展开，x ∈ [-π, π]
+static constexpr double constSin(double x) {
+  double term = x;
+  double sum = x;
+  for (int n = 1; n < 12; n++) {
+    term = -term * x * x / ((2 * n) * (2 * n + 1));
+    sum += term;
+  }
+  return sum;
+}
+
+static constexpr uint8_t round8(double x) {
+  return (uint8_t)(x < 0.0 ? 0 : x > 255.0 ? 255 : x + 0.5);
+}
+
+// 伽马 2.25：t^2 · t^(1/4)
+static constexpr uint8_t gammaOf(uint8_t i) {
+  double t = i / 255.0;
+  return round8(255.0 * t * t * constSqrt(constSqrt(t)));
+}
+
+static constexpr Lut8 makeGamma() {
+  Lut8 lut{};
+  for (int i = 0; i < 256; i++) {
+    lut.v[i] = gammaOf((uint8_t)i);
+  }
+  return lut;
+}
+
+// 一个周期的正弦，0-255：sin8(0) = 128，sin8(64) = 255，sin8(192) = 0
+static constexpr Lut8 makeSine() {
+  Lut8 lut{};
+  for (int i = 0; i < 256; i++) {
+    double x = 2.0 * PI_D * (i < 128 ? i : i - 256) / 256.0;
+    lut.v[i] = round8(127.5 + 127.5 * constSin(x));
+  }
+  return lut;
+}
+
+// 呼吸曲线：从 0 升到 255 再回到 0 的升余弦，再经伽马校正，让暗处的变化看起来和亮处一样均匀
+static constexpr Lut8 makeBreath() {
+  Lut8 sine = makeSine();
+  Lut8 lut{};
+  for (int i = 0; i < 256; i++) {
+    lut.v[i] = gammaOf(sine[(uint8_t)(i + 192)]);
+  }
+  return lut;
+}
+
+static constexpr Lut8 GAMMA8 = makeGamma();
+static constexpr Lut8 SIN8 = makeSine();
+static constexpr Lut8 BREATH8 = makeBreath();
+
+static_assert(GAMMA8[0] == 0 && GAMMA8[255] == 255 && GAMMA8[128] < 64, "伽马表");
+static_assert(SIN8[0] == 128 && SIN8[64] == 255 && SIN8[192] == 0, "正弦表");
+static_assert(BREATH8[0] == 0 && BREATH8[128] == 255, "呼吸表");
+
+// ==================== 灯效表 ====================
+// 下标为 LEDMode；周期和颜色见 config.h
+static const Effect LED_MODE_EFFECTS[NUM_LED_MODES] = {
+  // kind            color                                                                  color2              period                    frame                    budget                level
+  {EFFECT_SOLID,    CRGB(0, 0, 0),                                                          CRGB(0, 0, 0),      LED_MIN_REFRESH_INTERVAL, LED_MIN_REFRESH_INTERVAL, LED_RENDER_BUDGET_US, false},  // LED_OFF
+  {EFFECT_BREATHE,  CRGB(COLOR_BREATHE_RED_R, COLOR_BREATHE_RED_G, COLOR_BREATHE_RED_B),       CRGB(0, 0, 0),      BREATHE_PERIOD,           BREATHE_INTERVAL,         LED_RENDER_BUDGET_US, false},  // LED_BREATHE_RED
+  {EFFECT_BREATHE,  CRGB(COLOR_BREATHE_GREEN_R, COLOR_BREATHE_GREEN_G, COLOR_BREATHE_GREEN_B), CRGB(0, 0, 0),      BREATHE_PERIOD,           BREATHE_INTERVAL,         LED_RENDER_BUDGET_US, true},   // LED_BREATHE_GREEN
+  {EFFECT_BLINK,    CRGB(COLOR_FLASH_YELLOW_R, COLOR_FLASH_YELLOW_G, COLOR_FLASH_YELLOW_B),    CRGB(0, 0, 0),      BLINK_INTERVAL * 2,       BLINK_INTERVAL,           LED_RENDER_BUDGET_US, false},  // LED_FLASH_YELLOW
+  {EFFECT_PROGRESS, CRGB(COLOR_BREATHE_GREEN_R, COLOR_BREATHE_GREEN_G, COLOR_BREATHE_GREEN_B), CRGB(0, 0, 0),      BREATHE_PERIOD,           BREATHE_INTERVAL,         LED_RENDER_BUDGET_US, true},   // LED_PROGRESS_GREEN
+  {EFFECT_CHASE,    CRGB(COLOR_FLASH_YELLOW_R, COLOR_FLASH_YELLOW_G, COLOR_FLASH_YELLOW_B),    CRGB(0, 0, 0),      CHASE_PERIOD,             EFFECT_FRAME_INTERVAL,    LED_RENDER_BUDGET_US, false},  // LED_CHASE_YELLOW
+  {EFFECT_GRADIENT, CRGB(COLOR_BREATHE_RED_R, COLOR_BREATHE_RED_G, COLOR_BREATHE_RED_B),       CRGB(COLOR_BREATHE_GREEN_R, COLOR_BREATHE_GREEN_G, COLOR_BREATHE_GREEN_B),
+                    GRADIENT_PERIOD,          EFFECT_FRAME_INTERVAL,    LED_RENDER_BUDGET_US, false},  // LED_GRADIENT
+};
+
+static const char* const EFFECT_NAMES[NUM_EFFECT_KINDS] = {
+  "solid", "breathe", "blink", "chase", "gradient", "progress"
+};
+
+// 规则 JSON 和 MQTT 命令中的名称，下标为 LEDMode
+static const char* const LED_MODE_NAMES[NUM_LED_MODES] = {
+  "off", "breathe_red", "breathe_green", "flash_yellow", "progress_green", "chase_yellow", "gradient"
+};
+
+static EffectStats stats[NUM_EFFECT_KINDS];
+
+const Effect& ledModeEffect(LEDMode mode) {
+  if (isClipMode(mode)) {
+    return clipModeEffect(mode);
+  }
+  return LED_MODE_EFFECTS[(unsigned)mode < NUM_LED_MODES ? mode : LED_OFF];
+}
+
+const EffectStats& effectStats(EffectKind kind) {
+  return stats[kind];
+}
+
+const char* effectName(EffectKind kind) {
+  return EFFECT_NAMES[kind];
+}
+
+static bool findName(const char* name, const char* const* names, uint8_t count, uint8_t& index) {
+  for (uint8_t i = 0; i < count; i++) {
+    if (!strcmp(name, names[i])) {
+      index = i;
+      return true;
+    }
+  }
+  return false;
+}
+
+bool findEffectKind(const char* name, uint8_t& kind) {
+  return findName(name, EFFECT_NAMES, NUM_EFFECT_KINDS, kind);
+}
+
+const char* ledModeName(uint8_t mode) {
+  return mode < NUM_LED_MODES ? LED_MODE_NAMES[mode] : clipModeName(mode);
+}
+
+bool findLEDMode(const char* name, uint8_t& mode) {
+  return findName(name, LED_MODE_NAMES, NUM_LED_MODES, mode) || findClipMode(name, mode);
+}
+
+bool validLEDMode(uint8_t mode) {
+  return mode < NUM_LED_MODES || clipModeRegistered(mode);
+}
+
+// ==================== 渲染 ====================
+static inline CRGB scaleColor(const CRGB& color, uint8_t scale) {
+  return CRGB(scale8(color.r, scale), scale8(color.g, scale), scale8(color.b, scale));
+}
+
+// 周期内的位置，0-65535
+static inline uint16_t phase16(uint32_t elapsedMillis, uint16_t periodMillis) {
+  return (uint16_t)(((elapsedMillis % periodMillis) << 16) / periodMillis);
+}
+
+static void renderChase(const Effect& effect, CRGB* out, uint16_t count, uint16_t phase, uint8_t level) {
+  memset((void*)out, 0, count * sizeof(CRGB));
+  CRGB color = scaleColor(effect.color, level);
+
+  // 光点位置为 8.8 定点像素，尾巴长度为灯带的 1/8，亮度按与光点的距离线性递减再做伽马
+  uint32_t head88 = ((uint32_t)phase * count) >> 8;
+  uint16_t head = head88 >> 8;
+  uint16_t tail = count / 8 > 0 ? count / 8 : 1;
+  uint32_t fade88 = (255u << 8) / tail;  // 每像素递减的亮度，8.8 定点
+  uint32_t distance88 = head88 & 0xFF;
+  uint16_t index = head;
+  for (uint16_t k = 0; k <= tail; k++, distance88 += 256) {
+    uint32_t drop = (distance88 * fade88) >> 16;
+    if (drop >= 255) break;
+    out[index] = scaleColor(color, GAMMA8[(uint8_t)(255 - drop)]);
+    index = index > 0 ? index - 1 : count - 1;
+  }
+}
+
+static void renderGradient(const Effect& effect, CRGB* out, uint16_t count, uint16_t phase, uint8_t level) {
+  CRGB from = scaleColor(effect.color, level);
+  CRGB to = scaleColor(effect.color2, level);
+
+  // 每个像素在正弦表上前进 256/count 格（8.8 定点），整条灯带正好一个周期
+  uint16_t step = (uint16_t)((256u << 8) / count);
+  uint16_t position = phase;
+  for (uint16_t i = 0; i < count; i++, position += step) {
+    uint8_t mix = SIN8[(uint8_t)(position >> 8)];
+    uint8_t keep = 255 - mix;
+    out[i] = CRGB(scale8(from.r, keep) + scale8(to.r, mix),
+                  scale8(from.g, keep) + scale8(to.g, mix),
+                  scale8(from.b, keep) + scale8(to.b, mix));
+  }
+}
+
+static void renderProgress(const Effect& effect, CRGB* out, uint16_t count, uint16_t phase, uint8_t level) {
+  // 填充长度为 level/255 条灯带（8.8 定点像素），点亮部分在 60%-100% 之间呼吸
+  uint32_t lit88 = ((uint32_t)level * count * 257) >> 8;
+  uint16_t full = lit88 >> 8;
+  uint8_t envelope = 160 + scale8(BREATH8[(uint8_t)(phase >> 8)], 95);
+  CRGB lit = scaleColor(effect.color, envelope);
+
+  fill_solid(out, full, lit);
+  if (full < count) {
+    out[full] = scaleColor(lit, GAMMA8[(uint8_t)lit88]);
+    fill_solid(out + full + 1, count - full - 1, effect.color2);
+  }
+}
+
+void renderEffect(const Effect& effect, CRGB* out, uint16_t count, uint32_t elapsedMillis, uint8_t level) {
+  if (count == 0) return;
+  uint16_t phase = phase16(elapsedMillis, effect.periodMillis);
+
+  switch (effect.kind) {
+    case EFFECT_BREATHE:
+      fill_solid(out, count, scaleColor(effect.color, scale8(BREATH8[(uint8_t)(phase >> 8)], level)));
+      break;
+    case EFFECT_BLINK:
+      fill_solid(out, count, phase < 0x8000 ? scaleColor(effect.color, level) : CRGB(0, 0, 0));
+      break;
+    case EFFECT_CHASE:
+      renderChase(effect, out, count, phase, level);
+      break;
+    case EFFECT_GRADIENT:
+      renderGradient(effect, out, count, phase, level);
+      break;
+    case EFFECT_PROGRESS:
+      renderProgress(effect, out, count, phase, level);
+      break;
+    case EFFECT_SOLID:
+    default:
+      fill_solid(out, count, scaleColor(effect.color, level));
+      break;
+  }
+}
+
+void renderEffectFrame(const Effect& effect, CRGB* out, uint16_t count, uint32_t elapsedMillis, uint8_t level) {
+  uint32_t start = halCycleCount();
+  renderEffect(effect, out, count, elapsedMillis, level);
+  uint32_t nanos = halCyclesToNanos(halCycleCount() - start);
+
+  EffectStats& s = stats[effect.kind];
+  s.frames++;
+  s.lastNanos = nanos;
+  if (nanos > s.maxNanos) s.maxNanos = nanos;
+  if (nanos > (uint32_t)effect.budgetMicros * count) {
+    // 超出预算的帧仍然推送（画面按时间计算，下一帧自然追上），只计数
+    s.overBudget++;
+  }
+}
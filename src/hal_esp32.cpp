@@ -0,0 +1,714 @@
+// ==================== ESP32 硬件抽象层实现 ====================
+// 只在 [env:esp32dev] 中编译（见 platformio.ini 的 build_src_filter）
+#include <WiFi.h>
+#include <WiFiUdp.h>
+#include <PubSubClient.h>
+#include <ESPAsyncWebServer.h>
+#include <Preferences.h>
+#include <LittleFS.h>
+#include <esp_random.h>
+#include <soc/gpio_reg.h>
+#include <driver/rmt.h>
+#include <driver/gpio.h>
+#include <esp_sleep.h>
+#include <esp_wifi.h>
+#include <esp_partition.h>
+#include <Update.h>
+#include <atomic>
+#include <new>
+#include "hal.h"
+#include "config.h"
+
+WiFiClient wifiClient;
+PubSubClient mqttClient(wifiClient);
+AsyncWebSocket webSocket("/ws");
+static WiFiUDP udp;
+
+#define HAL_GPIO_COUNT 40
+
+// ==================== 时间 ====================
+unsigned long halMillis() {
+  return millis();
+}
+
+unsigned long halMicros() {
+  return micros();
+}
+
+void halDelay(unsigned long ms) {
+  delay(ms);
+}
+
+uint32_t halCycleCount() {
+  return ESP.getCycleCount();
+}
+
+uint32_t halCyclesToNanos(uint32_t cycles) {
+  static const uint32_t cpuMHz = getCpuFrequencyMhz();
+  return (uint32_t)((uint64_t)cycles * 1000 / cpuMHz);
+}
+
+uint32_t halRandom() {
+  return esp_random();
+}
+
+// ==================== GPIO ====================
+void halPinModeInputPullup(uint8_t pin) {
+  pinMode(pin, INPUT_PULLUP);
+}
+
+int halDigitalRead(uint8_t pin) {
+  return digitalRead(pin);
+}
+
+uint64_t halReadGPIOInputs() {
+  // GPIO0~31 和 GPIO32~39 分别在两个输入寄存器中
+  return ((uint64_t)(REG_READ(GPIO_IN1_REG) & 0xFF) << 32) | REG_READ(GPIO_IN_REG);
+}
+
+struct PinChangeSlot {
+  uint8_t pin;
+  uint8_t index;
+  HalPinChangeHandler handler;
+};
+
+static PinChangeSlot pinChangeSlots[HAL_GPIO_COUNT];
+
+static void IRAM_ATTR pinChangeTrampoline(void* arg) {
+  PinChangeSlot* slot = (PinChangeSlot*)arg;
+  slot->handler(slot->index, digitalRead(slot->pin), micros());
+}
+
+void halAttachPinChange(uint8_t pin, uint8_t index, HalPinChangeHandler handler) {
+  PinChangeSlot* slot = &pinChangeSlots[pin];
+  slot->pin = pin;
+  slot->index = index;
+  slot->handler = handler;
+  attachInterruptArg(digitalPinToInterrupt(pin), pinChangeTrampoline, slot, CHANGE);
+}
+
+// ==================== LED灯带 ====================
+// 每个通道一个 RMT 通道，按 WS281x 时序发送：rmt_write_sample() 先填满通道 RAM 后返回，
+// 其余字节由 RMT 中断里的 ledTranslate() 按阈值分批转换，发送期间 CPU 只处理这些短中断。
+// 帧尾的锁存低电平也作为一个 RMT 条目由外设发出，发送完成中断在锁存结束后才到，之后可以立即发送下一帧，
+// 不需要在发送前等待。
+// 8 个 RMT 通道共用 8 块 64 条目的 RAM，通道少时每个通道分到更多块，中断更少。
+#define LED_RMT_CLOCK_DIV 2       // 80 MHz / 2：每个计数 25 ns
+#define LED_T0H_TICKS 12          // 300 ns
+#define LED_T0L_TICKS 36          // 900 ns
+#define LED_T1H_TICKS 36
+#define LED_T1L_TICKS 12
+#define LED_RESET_TICKS 12000     // 300 us：帧尾的锁存低电平，分成一个条目的两半（每半最多 32767）
+
+static uint8_t ledNotifyTask = HAL_MAIN_TASK;
+static uint8_t ledChannelCount = 0;
+static uint8_t ledBlocksPerChannel = 1;  // 第 i 个通道使用 RMT 通道 i * ledBlocksPerChannel
+static std::atomic<uint32_t> ledBusyMask(0);
+static std::atomic<bool> ledEvent(false);
+
+static void IRAM_ATTR ledTranslate(const void* src, rmt_item32_t* dest, size_t srcSize,
+                                   size_t wantedNum, size_t* translatedSize, size_t* itemNum) {
+  static const rmt_item32_t bit0 = {{{LED_T0H_TICKS, 1, LED_T0L_TICKS, 0}}};
+  static const rmt_item32_t bit1 = {{{LED_T1H_TICKS, 1, LED_T1L_TICKS, 0}}};
+  static const rmt_item32_t latch = {{{LED_RESET_TICKS / 2, 0, LED_RESET_TICKS / 2, 0}}};
+  const uint8_t* bytes = (const uint8_t*)src;
+  size_t size = 0;
+  size_t num = 0;
+  while (size < srcSize) {
+    bool last = size + 1 == srcSize;
+    if (num + 8 + (last ? 1 : 0) > wantedNum) {
+      break;  // 最后一个字节和锁存条目放在同一批
+    }
+    for (uint8_t mask = 0x80; mask; mask >>= 1) {
+      dest[num++] = (bytes[size] & mask) ? bit1 : bit0;
+    }
+    size++;
+    if (last) {
+      dest[num++] = latch;
+    }
+  }
+  *translatedSize = size;
+  *itemNum = num;
+}
+
+static void IRAM_ATTR ledTransmitDone(rmt_channel_t channel, void* arg) {
+  (void)arg;
+  uint8_t index = (uint8_t)channel / ledBlocksPerChannel;
+  if (index >= ledChannelCount) return;
+  uint32_t bit = 1u << index;
+  if (ledBusyMask.fetch_and(~bit) == bit) {
+    ledEvent.store(true);
+    halNotifyTaskFromISR(ledNotifyTask);
+  }
+}
+
+void halLEDBegin(const HalLEDChannel* channels, uint8_t count, uint8_t notifyTask) {
+  ledNotifyTask = notifyTask;
+  ledChannelCount = count < HAL_LED_MAX_CHANNELS ? count : HAL_LED_MAX_CHANNELS;
+  ledBlocksPerChannel = ledChannelCount <= 2 ? 4 : ledChannelCount <= 4 ? 2 : 1;
+  for (uint8_t i = 0; i < ledChannelCount; i++) {
+    // RMT 通道 n 使用从 RAM 块 n 开始的 mem_block_num 块，所以通道号按块数间隔分配
+    rmt_channel_t channel = (rmt_channel_t)(i * ledBlocksPerChannel);
+    rmt_config_t config = RMT_DEFAULT_CONFIG_TX((gpio_num_t)channels[i].pin, channel);
+    config.clk_div = LED_RMT_CLOCK_DIV;
+    config.mem_block_num = ledBlocksPerChannel;
+    rmt_config(&config);
+    rmt_driver_install(channel, 0, 0);
+    rmt_translator_init(channel, ledTranslate);
+  }
+  rmt_register_tx_end_callback(ledTransmitDone, nullptr);
+}
+
+void halLEDTransmit(const HalLEDSpan* spans, uint8_t count) {
+  uint32_t mask = 0;
+  for (uint8_t c = 0; c < count && c < ledChannelCount; c++) {
+    if (spans[c].length > 0) {
+      mask |= 1u << c;
+    }
+  }
+  if (mask == 0) {
+    return;
+  }
+  // 先置好整帧的掩码再启动：先启动的通道在其余通道启动前完成，也不会提前给出帧完成信号
+  ledBusyMask.store(mask);
+  for (uint8_t c = 0; c < count && c < ledChannelCount; c++) {
+    if (spans[c].length > 0) {
+      rmt_write_sample((rmt_channel_t)(c * ledBlocksPerChannel), spans[c].data, spans[c].length, false);
+    }
+  }
+}
+
+bool halLEDBusy() {
+  return ledBusyMask.load() != 0;
+}
+
+bool halLEDTakeEvent() {
+  return ledEvent.exchange(false);
+}
+
+// ==================== WiFi ====================
+static uint8_t wifiNotifyTask = HAL_MAIN_TASK;
+static std::atomic<bool> wifiEvent(false);
+
+void halWiFiInit(uint8_t notifyTask) {
+  wifiNotifyTask = notifyTask;
+  WiFi.mode(WIFI_STA);
+  WiFi.persistent(false);        // 链路参数由调用方保存在 NVS
+  WiFi.setAutoReconnect(false);  // 重连节奏由调用方的退避控制
+  // 在 WiFi 事件任务中执行
+  WiFi.onEvent([](WiFiEvent_t event) {
+    (void)event;
+    wifiEvent.store(true);
+    halNotifyTask(wifiNotifyTask);
+  });
+}
+
+void halWiFiBegin(const char* ssid, const char* password, const HalWiFiLink* link) {
+  if (link) {
+    WiFi.config(IPAddress(link->ip), IPAddress(link->gateway), IPAddress(link->subnet),
+                IPAddress(link->dns));
+    WiFi.begin(ssid, password, link->channel, link->bssid);
+  } else {
+    WiFi.config(INADDR_NONE, INADDR_NONE, INADDR_NONE);  // 恢复 DHCP
+    WiFi.begin(ssid, password);
+  }
+}
+
+void halWiFiDisconnect() {
+  WiFi.disconnect(false);
+}
+
+HalWiFiStatus halWiFiStatus() {
+  switch (WiFi.status()) {
+    case WL_CONNECTED:
+      return HAL_WIFI_CONNECTED;
+    case WL_NO_SSID_AVAIL:
+    case WL_CONNECT_FAILED:
+    case WL_CONNECTION_LOST:
+      return HAL_WIFI_FAILED;
+    case WL_IDLE_STATUS:
+    case WL_DISCONNECTED:  // 连接过程中也是这个状态
+    default:
+      return HAL_WIFI_CONNECTING;
+  }
+}
+
+bool halWiFiTakeEvent() {
+  return wifiEvent.exchange(false);
+}
+
+bool halWiFiReadLink(HalWiFiLink& link) {
+  if (WiFi.status() != WL_CONNECTED) {
+    return false;
+  }
+  memcpy(link.bssid, WiFi.BSSID(), sizeof(link.bssid));
+  link.channel = (uint8_t)WiFi.channel();
+  link.reserved = 0;
+  link.ip = (uint32_t)WiFi.localIP();
+  link.gateway = (uint32_t)WiFi.gatewayIP();
+  link.subnet = (uint32_t)WiFi.subnetMask();
+  link.dns = (uint32_t)WiFi.dnsIP();
+  return true;
+}
+
+bool halWiFiConnected() {
+  return WiFi.status() == WL_CONNECTED;
+}
+
+String halWiFiLocalIP() {
+  return WiFi.localIP().toString();
+}
+
+// 监听间隔取 wifi_config_t 的默认值（3 个信标间隔），AP 在此期间为本机缓存帧
+void halWiFiSetPowerSave(bool idle) {
+  esp_wifi_set_ps(idle ? WIFI_PS_MAX_MODEM : WIFI_PS_MIN_MODEM);
+}
+
+bool halUDPSend(const char* host, uint16_t port, const uint8_t* data, size_t length) {
+  IPAddress address;
+  if (!address.fromString(host) || !udp.beginPacket(address, port)) {
+    return false;
+  }
+  udp.write(data, length);
+  return udp.endPacket() == 1;
+}
+
+// ==================== NVS ====================
+static Preferences preferences;
+static bool preferencesOpen = false;
+
+static Preferences& nvs() {
+  if (!preferencesOpen) {
+    preferences.begin("ball", false);
+    preferencesOpen = true;
+  }
+  return preferences;
+}
+
+bool halNVSLoad(const char* key, void* data, size_t length) {
+  if (nvs().getBytesLength(key) != length) {
+    return false;
+  }
+  return nvs().getBytes(key, data, length) == length;
+}
+
+bool halNVSStore(const char* key, const void* data, size_t length) {
+  return nvs().putBytes(key, data, length) == length;
+}
+
+// ==================== 文件系统 ====================
+static bool fsMounted = false;
+
+static bool mountFS() {
+  if (!fsMounted) {
+    fsMounted = LittleFS.begin(true);  // 首次使用时格式化
+  }
+  return fsMounted;
+}
+
+int32_t halFileRead(const char* path, char* buffer, size_t capacity) {
+  if (!mountFS() || !LittleFS.exists(path)) {
+    return -1;
+  }
+  File file = LittleFS.open(path, "r");
+  if (!file || file.size() > capacity) {
+    return -1;
+  }
+  int32_t length = (int32_t)file.read((uint8_t*)buffer, file.size());
+  file.close();
+  return length;
+}
+
+bool halFileWrite(const char* path, const char* data, size_t length) {
+  if (!mountFS()) {
+    return false;
+  }
+  File file = LittleFS.open(path, "w");
+  if (!file) {
+    return false;
+  }
+  bool ok = file.write((const uint8_t*)data, length) == length;
+  file.close();
+  return ok;
+}
+
+bool halFileAppend(const char* path, const char* data, size_t length) {
+  if (!mountFS()) {
+    return false;
+  }
+  File file = LittleFS.open(path, "a");
+  if (!file) {
+    return false;
+  }
+  bool ok = file.write((const uint8_t*)data, length) == length;
+  file.close();
+  return ok;
+}
+
+// ==================== 数据分区 ====================
+// 每个分区只映射一次，之后一直保持（ESP32 的 flash 写入会刷新映射区域的缓存）
+#define HAL_MAX_PARTITIONS 2
+
+struct MappedPartition {
+  const esp_partition_t* partition;
+  const void* data;
+  spi_flash_mmap_handle_t handle;
+};
+
+static MappedPartition mappedPartitions[HAL_MAX_PARTITIONS];
+
+static const esp_partition_t* findPartition(const char* label) {
+  return esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, label);
+}
+
+const uint8_t* halPartitionMap(const char* label, size_t& size) {
+  const esp_partition_t* partition = findPartition(label);
+  if (!partition) {
+    return nullptr;
+  }
+  for (MappedPartition& m : mappedPartitions) {
+    if (m.partition == partition) {
+      size = partition->size;
+      return (const uint8_t*)m.data;
+    }
+    if (!m.partition) {
+      if (esp_partition_mmap(partition, 0, partition->size, SPI_FLASH_MMAP_DATA, &m.data, &m.handle) != ESP_OK) {
+        return nullptr;
+      }
+      m.partition = partition;
+      size = partition->size;
+      return (const uint8_t*)m.data;
+    }
+  }
+  return nullptr;
+}
+
+bool halPartitionErase(const char* label, size_t offset, size_t length) {
+  const esp_partition_t* partition = findPartition(label);
+  return partition && esp_partition_erase_range(partition, offset, length) == ESP_OK;
+}
+
+bool halPartitionWrite(const char* label, size_t offset, const void* data, size_t length) {
+  const esp_partition_t* partition = findPartition(label);
+  return partition && esp_partition_write(partition, offset, data, length) == ESP_OK;
+}
+
+// ==================== 固件更新 ====================
+// Update 自己按扇区擦除并缓冲不足一个扇区的尾部；end(true) 不再检查 MD5，镜像摘要由 ota.cpp 校验
+bool halOTABegin(size_t size) {
+  return Update.begin(size, U_FLASH);
+}
+
+bool halOTAWrite(const uint8_t* data, size_t length) {
+  return Update.write((uint8_t*)data, length) == length;
+}
+
+bool halOTAEnd() {
+  return Update.end(true);
+}
+
+void halOTAAbort() {
+  Update.abort();
+}
+
+const char* halOTAError() {
+  return Update.errorString();
+}
+
+void halRestart() {
+  ESP.restart();
+}
+
+// ==================== 保留内存 ====================
+// RTC_NOINIT_ATTR：启动代码不清零，软件复位后保留
+RTC_NOINIT_ATTR static uint32_t retainedMemory[HAL_RETAINED_SIZE / sizeof(uint32_t)];
+
+void* halRetainedMemory() {
+  return retainedMemory;
+}
+
+// ==================== MQTT ====================
+// PubSubClient::connect() 会阻塞在 TCP 连接和等待 CONNACK 上，放到单独的低优先级任务中执行，
+// 网络任务在此期间照常运行（调用方保证连接期间不使用 mqttClient）。
+static TaskHandle_t mqttConnectTask = nullptr;
+static const char* mqttConnectClientId = nullptr;
+static std::atomic<int> mqttConnectStatus(HAL_MQTT_CONNECT_IDLE);
+static std::atomic<bool> mqttEvent(false);
+static uint8_t mqttNotifyTask = HAL_MAIN_TASK;
+
+static void mqttConnectWorker(void* arg) {
+  (void)arg;
+  for (;;) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    bool connected = mqttClient.connect(mqttConnectClientId);
+    mqttConnectStatus.store(connected ? HAL_MQTT_CONNECT_DONE : HAL_MQTT_CONNECT_FAILED);
+    mqttEvent.store(true);
+    halNotifyTask(mqttNotifyTask);
+  }
+}
+
+void halMQTTBegin(const char* server, uint16_t port, HalMQTTCallback callback, uint8_t notifyTask) {
+  mqttClient.setServer(server, port);
+  mqttClient.setCallback(callback);
+  mqttClient.setBufferSize(MQTT_BUFFER_SIZE);  // 规则 JSON 等较大的消息
+  mqttClient.setSocketTimeout(MQTT_CONNECT_TIMEOUT / 1000);  // 等待 CONNACK 的上限（秒）
+  wifiClient.setTimeout(MQTT_CONNECT_TIMEOUT / 1000);
+  mqttNotifyTask = notifyTask;
+  if (!mqttConnectTask) {
+    xTaskCreatePinnedToCore(mqttConnectWorker, "mqttConnect", 4096, nullptr, 1,
+                            &mqttConnectTask, NETWORK_TASK_CORE);
+  }
+}
+
+void halMQTTConnectAsync(const char* clientId) {
+  if (mqttConnectStatus.load() == HAL_MQTT_CONNECT_PENDING) {
+    return;
+  }
+  mqttConnectClientId = clientId;
+  mqttConnectStatus.store(HAL_MQTT_CONNECT_PENDING);
+  xTaskNotifyGive(mqttConnectTask);
+}
+
+HalMQTTConnectStatus halMQTTConnectStatus() {
+  return (HalMQTTConnectStatus)mqttConnectStatus.load();
+}
+
+bool halMQTTTakeEvent() {
+  return mqttEvent.exchange(false);
+}
+
+bool halMQTTConnected() {
+  return mqttClient.connected();
+}
+
+int halMQTTState() {
+  return mqttClient.state();
+}
+
+bool halMQTTSubscribe(const char* topic) {
+  return mqttClient.subscribe(topic);
+}
+
+bool halMQTTPublish(const char* topic, const char* payload) {
+  return mqttClient.publish(topic, payload);
+}
+
+void halMQTTLoop() {
+  mqttClient.loop();
+}
+
+// ==================== WebSocket ====================
+// 库的 AsyncWebSocketMessageBuffer 不是引用计数：lock()/unlock() 只是一个标志，_count 由排队的
+// AsyncWebSocketMultiMessage 在网络任务里加、在 AsyncTCP 任务里减，都不是原子操作。这里的缓冲由 HAL 自己持有：
+// 不经 makeBuffer() 放进库的 _buffers 链表、也不调用 _cleanBuffers()，生命周期只看 refs。
+// 每次发送包一层 HalWsMessage，它持有一个引用，库删除消息（发完或客户端断开，AsyncTCP 任务）时
+// 先删掉内层消息再释放引用，因此最后一个引用释放时库里已没有指向这块缓冲的消息。
+struct HalWsBuffer {
+  std::atomic<uint32_t> refs;
+  AsyncWebSocketMessageBuffer* message;
+};
+
+HalWsBuffer* halWebSocketAllocate(const uint8_t* data, size_t length) {
+  AsyncWebSocketMessageBuffer* message = new (std::nothrow) AsyncWebSocketMessageBuffer((uint8_t*)data, length);
+  if (!message || !message->get()) {
+    delete message;
+    return nullptr;
+  }
+  HalWsBuffer* buffer = new (std::nothrow) HalWsBuffer;
+  if (!buffer) {
+    delete message;
+    return nullptr;
+  }
+  buffer->refs.store(1, std::memory_order_relaxed);
+  buffer->message = message;
+  message->lock();  // 引用计数大于 0 期间保持，库不会把它当作可删除
+  return buffer;
+}
+
+void halWebSocketRetain(HalWsBuffer* buffer) {
+  buffer->refs.fetch_add(1, std::memory_order_relaxed);
+}
+
+void halWebSocketRelease(HalWsBuffer* buffer) {
+  if (buffer->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+    buffer->message->unlock();
+    delete buffer->message;
+    delete buffer;
+  }
+}
+
+// 转发给库的多客户端消息（负责分帧和确认），析构时释放传输层持有的引用
+class HalWsMessage : public AsyncWebSocketMessage {
+ public:
+  HalWsMessage(HalWsBuffer* buffer, uint8_t opcode)
+      : buffer_(buffer), inner_(new AsyncWebSocketMultiMessage(buffer->message, opcode)) {
+    halWebSocketRetain(buffer_);
+  }
+  ~HalWsMessage() override {
+    delete inner_;
+    halWebSocketRelease(buffer_);
+  }
+  void ack(size_t len, uint32_t time) override { inner_->ack(len, time); }
+  size_t send(AsyncClient* client) override { return inner_->send(client); }
+  bool finished() override { return inner_->finished(); }
+  bool betweenFrames() const override { return inner_->betweenFrames(); }
+
+ private:
+  HalWsBuffer* buffer_;
+  AsyncWebSocketMultiMessage* inner_;
+};
+
+bool halWebSocketCanSend(uint32_t clientId) {
+  AsyncWebSocketClient* client = webSocket.client(clientId);
+  return client && client->status() == WS_CONNECTED && client->canSend() &&
+         client->client()->canSend();
+}
+
+bool halWebSocketSend(uint32_t clientId, HalWsBuffer* buffer, bool binary) {
+  AsyncWebSocketClient* client = webSocket.client(clientId);
+  if (!client || client->status() != WS_CONNECTED) {
+    return false;
+  }
+  client->message(new HalWsMessage(buffer, binary ? WS_BINARY : WS_TEXT));
+  return true;
+}
+
+void halWebSocketClose(uint32_t clientId) {
+  AsyncWebSocketClient* client = webSocket.client(clientId);
+  if (client) {
+    client->close();
+  }
+}
+
+void halWebSocketCleanup() {
+  webSocket.cleanupClients(WS_MAX_CLIENTS);
+}
+
+// ==================== 低功耗 ====================
+// GPIO 唤醒使用引脚的中断类型寄存器：睡眠期间先关闭这些引脚的中断再改为电平触发，
+// 否则醒来后按住的按钮会不停触发电平中断；醒来后恢复为双边沿（attachInterrupt 的 CHANGE）。
+// WiFi：esp_light_sleep_start() 直接关闭射频，不与 AP 协商省电（不发 PS-Poll、不按 DTIM 醒来），
+// 连续漏掉信标时 AP 或驱动会断开连接，MQTT 保活也会超时。Arduino 核心没有开启 CONFIG_PM_ENABLE 和
+// tickless idle，不能用 esp_pm_configure() 的自动浅睡眠配合 modem sleep 保持连接，所以 power.cpp 只在
+// WiFi 未连接（AP 不可用、退避等待）时调用这里；已连接的空闲球改用 halWiFiSetPowerSave() 的 modem sleep。
+HalWakeCause halLightSleep(uint32_t durationMicros, const uint8_t* pins, const uint8_t* levels, uint8_t count) {
+  for (uint8_t i = 0; i < count; i++) {
+    gpio_num_t pin = (gpio_num_t)pins[i];
+    gpio_intr_disable(pin);
+    gpio_wakeup_enable(pin, levels[i] == LOW ? GPIO_INTR_HIGH_LEVEL : GPIO_INTR_LOW_LEVEL);
+  }
+  esp_sleep_enable_gpio_wakeup();
+  esp_sleep_enable_timer_wakeup(durationMicros);
+  esp_err_t result = esp_light_sleep_start();
+  esp_sleep_wakeup_cause_t cause = esp_sleep_get_wakeup_cause();
+  esp_sleep_disable_wakeup_source(ESP_SLEEP_WAKEUP_ALL);
+
+  for (uint8_t i = 0; i < count; i++) {
+    gpio_num_t pin = (gpio_num_t)pins[i];
+    gpio_wakeup_disable(pin);
+    gpio_set_intr_type(pin, GPIO_INTR_ANYEDGE);
+    gpio_intr_enable(pin);
+  }
+  if (result != ESP_OK) {
+    return HAL_WAKE_OTHER;  // 进入前已有唤醒源触发等
+  }
+  switch (cause) {
+    case ESP_SLEEP_WAKEUP_TIMER:
+      return HAL_WAKE_TIMER;
+    case ESP_SLEEP_WAKEUP_GPIO:
+      return HAL_WAKE_GPIO;
+    default:
+      return HAL_WAKE_OTHER;
+  }
+}
+
+// ==================== 任务 ====================
+struct TaskSlot {
+  HalTaskFunction fn;
+  TaskHandle_t handle;
+};
+
+static TaskSlot taskSlots[HAL_MAX_TASKS];
+
+static TickType_t microsToTicks(uint32_t timeoutMicros) {
+  if (timeoutMicros == UINT32_MAX) {
+    return portMAX_DELAY;
+  }
+  return pdMS_TO_TICKS((timeoutMicros + 999) / 1000);  // 向上取整，不提前醒来
+}
+
+static void taskEntry(void* arg) {
+  TaskSlot* slot = (TaskSlot*)arg;
+  for (;;) {
+    uint32_t waitMicros = slot->fn();
+    if (waitMicros > 0) {
+      ulTaskNotifyTake(pdTRUE, microsToTicks(waitMicros));
+    }
+  }
+}
+
+static TaskHandle_t IRAM_ATTR taskHandleFor(uint8_t id) {
+  if (id < HAL_MAX_TASKS && taskSlots[id].handle) {
+    return taskSlots[id].handle;
+  }
+  return taskSlots[HAL_MAIN_TASK].handle;
+}
+
+void halStartTask(uint8_t id, const char* name, HalTaskFunction fn,
+                  uint32_t stackSize, uint8_t priority, uint8_t core) {
+  if (id == HAL_MAIN_TASK || id >= HAL_MAX_TASKS) {
+    return;
+  }
+  taskSlots[id].fn = fn;
+  xTaskCreatePinnedToCore(taskEntry, name, stackSize, &taskSlots[id], priority,
+                          &taskSlots[id].handle, core);
+}
+
+void halNotifyTask(uint8_t id) {
+  TaskHandle_t handle = taskHandleFor(id);
+  if (handle) {
+    xTaskNotifyGive(handle);
+  }
+}
+
+void IRAM_ATTR halNotifyTaskFromISR(uint8_t id) {
+  TaskHandle_t handle = taskHandleFor(id);
+  if (handle) {
+    BaseType_t woken = pdFALSE;
+    vTaskNotifyGiveFromISR(handle, &woken);
+    if (woken) {
+      portYIELD_FROM_ISR();
+    }
+  }
+}
+
+void halWaitForNotify(uint32_t timeoutMicros) {
+  taskSlots[HAL_MAIN_TASK].handle = xTaskGetCurrentTaskHandle();
+  if (timeoutMicros > 0) {
+    ulTaskNotifyTake(pdTRUE, microsToTicks(timeoutMicros));
+  }
+}
+
+// 第一次使用时静态创建（C++ 局部静态变量的初始化是线程安全的），之后给出方和等待方拿到同一组句柄
+struct SignalSlots {
+  StaticSemaphore_t storage[HAL_MAX_SIGNALS];
+  SemaphoreHandle_t handles[HAL_MAX_SIGNALS];
+  SignalSlots() {
+    for (uint8_t i = 0; i < HAL_MAX_SIGNALS; i++) {
+      handles[i] = xSemaphoreCreateBinaryStatic(&storage[i]);
+    }
+  }
+};
+
+static SemaphoreHandle_t signalHandle(uint8_t id) {
+  static SignalSlots slots;
+  return slots.handles[id];
+}
+
+void halSignalGive(uint8_t id) {
+  xSemaphoreGive(signalHandle(id));  // 已经给出时失败，相当于只记一次
+}
+
+bool halSignalTake(uint8_t id, uint32_t timeoutMicros) {
+  return xSemaphoreTake(signalHandle(id), microsToTicks(timeoutMicros)) == pdTRUE;
+}
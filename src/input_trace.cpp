@@ -0,0 +1,199 @@
+#include <atomic>
+#include "input_trace.h"
+#include "hal.h"
+#include "tasks.h"
+#include "log.h"
+
+enum TraceCommand : uint8_t {
+  TRACE_COMMAND_NONE,
+  TRACE_COMMAND_START,
+  TRACE_COMMAND_STOP
+};
+
+// ==================== 缓冲区 ====================
+// 第 k 次交出的是 chunks[k & 1]；渲染任务正在写的一块始终是 chunks[handedOff & 1]
+static uint8_t chunks[2][INPUT_TRACE_CHUNK_SIZE];
+static uint16_t chunkLength[2];
+static bool chunkStartsFile[2];
+static bool chunkEndsTrace[2];
+static std::atomic<uint32_t> handedOff(0);  // 仅渲染任务写
+static std::atomic<uint32_t> flushed(0);    // 仅网络任务写
+static std::atomic<uint8_t> command(TRACE_COMMAND_NONE);
+
+// 渲染任务
+static uint16_t fill = 0;
+static bool activeStartsFile = false;
+static uint32_t lastMicros = 0;
+static InputTraceStats stats;
+
+void initializeInputTrace() {
+  handedOff.store(0);
+  flushed.store(0);
+  command.store(TRACE_COMMAND_NONE);
+  fill = 0;
+  activeStartsFile = false;
+  lastMicros = 0;
+  stats = InputTraceStats();
+}
+
+void requestInputTrace(bool start) {
+  command.store(start ? TRACE_COMMAND_START : TRACE_COMMAND_STOP, std::memory_order_release);
+  halNotifyTask(TASK_RENDER);
+}
+
+bool inputTraceCommandPending() {
+  return command.load(std::memory_order_acquire) != TRACE_COMMAND_NONE;
+}
+
+// ==================== 录制（渲染任务） ====================
+static uint32_t chunksPending() {
+  return handedOff.load(std::memory_order_relaxed) - flushed.load(std::memory_order_acquire);
+}
+
+static void handOff(bool endsTrace) {
+  uint8_t c = handedOff.load(std::memory_order_relaxed) & 1;
+  chunkLength[c] = fill;
+  chunkStartsFile[c] = activeStartsFile;
+  chunkEndsTrace[c] = endsTrace;
+  handedOff.fetch_add(1, std::memory_order_release);
+  halNotifyTask(TASK_NETWORK);
+  fill = 0;
+  activeStartsFile = false;
+}
+
+// 当前块放不下时交出它换另一块；另一块还没写完或文件到达上限时返回 false
+static bool append(const uint8_t* data, size_t length) {
+  if (stats.bytes + length > INPUT_TRACE_MAX_BYTES) {
+    return false;
+  }
+  if (fill + length > INPUT_TRACE_CHUNK_SIZE) {
+    if (chunksPending() > 0) {
+      return false;
+    }
+    handOff(false);
+  }
+  memcpy(chunks[handedOff.load(std::memory_order_relaxed) & 1] + fill, data, length);
+  fill += length;
+  stats.bytes += length;
+  return true;
+}
+
+static void stopRecording(uint32_t nowMicros, const char* truncatedReason) {
+  if (!truncatedReason) {
+    uint8_t record[INPUT_TRACE_MAX_RECORD];
+    int32_t delta = (int32_t)(nowMicros - lastMicros);
+    size_t n = inputTraceEncodeRecord(record, delta > 0 ? (uint32_t)delta : 0, INPUT_TRACE_CODE_TIME);
+    if (!append(record, n)) {
+      truncatedReason = "结束标记";
+    }
+  }
+  handOff(true);
+  stats.recording = false;
+  stats.truncated = truncatedReason != nullptr;
+  if (truncatedReason) {
+    LOG_WARN(LOG_TRACE_TRUNCATED, stats.edges, stats.bytes, truncatedReason);
+  } else {
+    LOG_INFO(LOG_TRACE_STOPPED, stats.edges, stats.bytes);
+  }
+}
+
+static bool appendRecord(uint32_t deltaMicros, uint8_t code, uint32_t nowMicros) {
+  uint8_t record[INPUT_TRACE_MAX_RECORD];
+  size_t n = inputTraceEncodeRecord(record, deltaMicros, code);
+  if (!append(record, n)) {
+    stopRecording(nowMicros, stats.bytes + n > INPUT_TRACE_MAX_BYTES ? "文件大小上限" : "写入跟不上");
+    return false;
+  }
+  return true;
+}
+
+void recordInputEdge(uint8_t index, uint8_t level, uint32_t timestampMicros) {
+  if (!stats.recording) {
+    return;
+  }
+  // 开始录制时的采样晚于队列里残留的边沿：这些边沿记为时间 0，电平已包含在起始掩码里
+  int32_t delta = (int32_t)(timestampMicros - lastMicros);
+  if (delta < 0) {
+    delta = 0;
+  } else {
+    lastMicros = timestampMicros;
+  }
+  if (appendRecord((uint32_t)delta, (uint8_t)(index * 2 + (level ? 1 : 0)), timestampMicros)) {
+    stats.edges++;
+  }
+}
+
+void updateInputTrace(uint32_t pressedMask, bool resync, uint32_t nowMicros) {
+  uint8_t c = command.exchange(TRACE_COMMAND_NONE, std::memory_order_acq_rel);
+  if (c == TRACE_COMMAND_STOP && stats.recording) {
+    stopRecording(nowMicros, nullptr);
+  } else if (c == TRACE_COMMAND_START && !stats.recording) {
+    if (chunksPending() > 1) {
+      LOG_WARN(LOG_TRACE_BUSY);
+      return;
+    }
+    stats.recording = true;  // savedBytes 属于网络任务，由第一块写入时清零
+    stats.truncated = false;
+    stats.edges = 0;
+    stats.resyncs = 0;
+    stats.bytes = 0;
+    fill = 0;
+    activeStartsFile = true;
+    lastMicros = nowMicros;
+    uint8_t header[INPUT_TRACE_HEADER_SIZE];
+    append(header, inputTraceEncodeHeader(header, pressedMask));
+    LOG_INFO(LOG_TRACE_STARTED, pressedMask);
+    return;  // 起始掩码已经包含本轮的状态
+  }
+  if (!stats.recording) {
+    return;
+  }
+
+  int32_t sinceLast = (int32_t)(nowMicros - lastMicros);
+  uint32_t delta = sinceLast > 0 ? (uint32_t)sinceLast : 0;
+  if (resync) {
+    uint8_t record[INPUT_TRACE_MAX_RECORD];
+    size_t n = inputTraceEncodeRecord(record, delta, INPUT_TRACE_CODE_RESYNC);
+    n += inputTraceEncodeVarint(record + n, pressedMask);
+    if (!append(record, n)) {
+      stopRecording(nowMicros, stats.bytes + n > INPUT_TRACE_MAX_BYTES ? "文件大小上限" : "写入跟不上");
+      return;
+    }
+    lastMicros += delta;
+    stats.resyncs++;
+  } else if (delta >= INPUT_TRACE_MAX_GAP_US / 2) {
+    // 输入作业至少每 INPUT_IDLE_POLL_INTERVAL 运行一次，间隔远不会到 INPUT_TRACE_MAX_GAP_US
+    if (appendRecord(delta, INPUT_TRACE_CODE_TIME, nowMicros)) {
+      lastMicros += delta;
+    }
+  }
+}
+
+// ==================== 写文件（网络任务） ====================
+bool inputTraceFlushPending() {
+  return flushed.load(std::memory_order_relaxed) != handedOff.load(std::memory_order_acquire);
+}
+
+void flushInputTrace() {
+  uint32_t f = flushed.load(std::memory_order_relaxed);
+  uint32_t h = handedOff.load(std::memory_order_acquire);
+  for (; f != h; f++) {
+    uint8_t c = f & 1;
+    const char* data = (const char*)chunks[c];
+    bool ok = chunkStartsFile[c] ? halFileWrite(INPUT_TRACE_PATH, data, chunkLength[c])
+                                 : halFileAppend(INPUT_TRACE_PATH, data, chunkLength[c]);
+    if (!ok) {
+      LOG_WARN(LOG_TRACE_WRITE_FAILED, INPUT_TRACE_PATH);
+    } else {
+      stats.savedBytes = (chunkStartsFile[c] ? 0 : stats.savedBytes) + chunkLength[c];
+    }
+    if (chunkEndsTrace[c]) {
+      LOG_INFO(LOG_TRACE_SAVED, INPUT_TRACE_PATH, stats.savedBytes);
+    }
+    flushed.store(f + 1, std::memory_order_release);
+  }
+}
+
+const InputTraceStats& inputTraceStats() {
+  return stats;
+}
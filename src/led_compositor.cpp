@@ -0,0 +1,200 @@
+#include "led_compositor.h"
+#include "log.h"
+
+#include <stdlib.h>
+
+// ==================== 帧缓冲 ====================
+CRGB* leds = nullptr;
+uint16_t ledCount = 0;
+
+// COLOR_ORDER 为 FastLED 的 EOrder：三个八进制位依次为线上第 0/1/2 个字节取 CRGB 的哪个分量
+#define WIRE_CHANNEL(order, position) ((((order) >> (3 * (2 - (position)))) & 0x3))
+
+// 段 → 线上帧缓冲中的位置，启动时由布局算出
+struct SegmentPlan {
+  uint16_t start;
+  uint16_t count;
+  uint32_t wireOffset;  // 段第一个像素在线上帧中的字节位置
+  int8_t wireStep;      // 相邻逻辑像素在线上帧中的字节间隔（反向为 -3）
+  uint8_t channel[3];   // 线上第 0/1/2 个字节取 CRGB 的哪个分量
+};
+
+static LEDLayout layout;
+static SegmentPlan plans[LED_MAX_SEGMENTS];
+static uint32_t channelOffsets[HAL_LED_MAX_CHANNELS];  // 各通道在线上帧中的起始字节
+static uint32_t wireFrameBytes = 0;
+static uint8_t* frameMemory = nullptr;
+static size_t frameMemoryBytes = 0;
+static uint8_t* wireFrames[2];
+static uint8_t sendingFrame = 0;     // 外设正在发送（或最近发送）的一块
+static bool framePending = false;    // 另一块中有等待发送的帧
+static bool frameInFlight = false;   // sendingFrame 已交给外设、尚未确认完成
+static uint32_t lastFrameHash = 0;
+static unsigned long lastShowTime = 0;
+static CompositorStats stats;
+
+static uint32_t hashFrame(const CRGB* frame, uint16_t count) {
+  const uint8_t* bytes = (const uint8_t*)frame;
+  uint32_t hash = 2166136261u;  // FNV-1a
+  for (uint32_t i = 0; i < (uint32_t)count * sizeof(CRGB); i++) {
+    hash ^= bytes[i];
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+// 各通道在线上帧中依次排列，段在通道内按 offset 排列
+static void planSegments() {
+  uint32_t offset = 0;
+  for (uint8_t c = 0; c < layout.channelCount; c++) {
+    channelOffsets[c] = offset;
+    offset += (uint32_t)layout.channels[c].pixels * 3;
+  }
+  wireFrameBytes = offset;
+
+  for (uint8_t s = 0; s < layout.segmentCount; s++) {
+    const LEDSegment& segment = layout.segments[s];
+    uint16_t order = layout.channels[segment.channel].order;
+    SegmentPlan& plan = plans[s];
+    plan.start = segment.start;
+    plan.count = segment.count;
+    uint32_t first = segment.reverse ? segment.offset + segment.count - 1 : segment.offset;
+    plan.wireOffset = channelOffsets[segment.channel] + first * 3;
+    plan.wireStep = segment.reverse ? -3 : 3;
+    for (uint8_t i = 0; i < 3; i++) {
+      plan.channel[i] = WIRE_CHANNEL(order, i);
+    }
+  }
+}
+
+// 逻辑帧缓冲和两块线上帧缓冲放在一块内存里，只在布局长度变化时重新分配
+static bool allocateFrames() {
+  size_t bytes = (size_t)ledCount * sizeof(CRGB) + 2 * (size_t)wireFrameBytes;
+  if (bytes != frameMemoryBytes) {
+    free(frameMemory);
+    frameMemory = (uint8_t*)malloc(bytes);
+    frameMemoryBytes = frameMemory ? bytes : 0;
+  }
+  if (!frameMemory) {
+    return false;
+  }
+  leds = (CRGB*)frameMemory;
+  wireFrames[0] = frameMemory + (size_t)ledCount * sizeof(CRGB);
+  wireFrames[1] = wireFrames[0] + wireFrameBytes;
+  return true;
+}
+
+// 按段映射写入线上顺序并乘全局亮度（原先由 FastLED.show() 完成）
+static void encodeFrame(uint8_t* out) {
+  for (uint8_t s = 0; s < layout.segmentCount; s++) {
+    const SegmentPlan& plan = plans[s];
+    const uint8_t* pixel = (const uint8_t*)&leds[plan.start];
+    uint8_t* wire = out + plan.wireOffset;
+    for (uint16_t i = 0; i < plan.count; i++, pixel += sizeof(CRGB), wire += plan.wireStep) {
+      wire[0] = scale8(pixel[plan.channel[0]], LED_BRIGHTNESS);
+      wire[1] = scale8(pixel[plan.channel[1]], LED_BRIGHTNESS);
+      wire[2] = scale8(pixel[plan.channel[2]], LED_BRIGHTNESS);
+    }
+  }
+}
+
+static void transmitPending() {
+  if (halLEDBusy()) {
+    return;
+  }
+  if (frameInFlight) {
+    frameInFlight = false;
+    stats.framesCompleted++;
+  }
+  if (!framePending) {
+    return;
+  }
+  sendingFrame ^= 1;
+  framePending = false;
+  frameInFlight = true;
+  HalLEDSpan spans[HAL_LED_MAX_CHANNELS];
+  for (uint8_t c = 0; c < layout.channelCount; c++) {
+    spans[c] = HalLEDSpan{wireFrames[sendingFrame] + channelOffsets[c], (size_t)layout.channels[c].pixels * 3};
+  }
+  halLEDTransmit(spans, layout.channelCount);
+  stats.framesRendered++;
+}
+
+void initializeCompositor(uint8_t notifyTask) {
+  loadLEDLayout(layout);
+  ledCount = layout.pixelCount;
+  planSegments();
+  if (!allocateFrames()) {
+    // 配置的布局放不下时退回默认布局
+    defaultLEDLayout(layout);
+    ledCount = layout.pixelCount;
+    planSegments();
+    allocateFrames();
+  }
+
+  HalLEDChannel channels[HAL_LED_MAX_CHANNELS];
+  for (uint8_t c = 0; c < layout.channelCount; c++) {
+    channels[c] = HalLEDChannel{layout.channels[c].pin, layout.channels[c].pixels};
+  }
+  halLEDBegin(channels, layout.channelCount, notifyTask);
+
+  fill_solid(leds, ledCount, CRGB::Black);
+  sendingFrame = 0;
+  framePending = false;
+  frameInFlight = false;
+  stats = CompositorStats();
+
+  // 上电先清空灯带
+  encodeFrame(wireFrames[1]);
+  framePending = true;
+  transmitPending();
+  lastFrameHash = hashFrame(leds, ledCount);
+  lastShowTime = halMillis();
+
+  uint32_t tenthsPerPixel = (uint32_t)(frameMemoryBytes * 10 / ledCount);
+  LOG_INFO(LOG_LED_LAYOUT, layout.channelCount, layout.segmentCount, ledCount, (uint32_t)frameMemoryBytes,
+           tenthsPerPixel / 10, tenthsPerPixel % 10, ledLayoutFrameMicros(layout));
+}
+
+bool compositorPresent() {
+  uint32_t hash = hashFrame(leds, ledCount);
+  unsigned long currentTime = halMillis();
+
+  // 帧未变化且未到最小刷新间隔：跳过
+  if (hash == lastFrameHash &&
+      currentTime - lastShowTime < LED_MIN_REFRESH_INTERVAL) {
+    stats.framesSkipped++;
+    return false;
+  }
+
+  // 只写不在发送中的那一块；其中已有挂起的帧时，它被这一帧取代
+  if (framePending) {
+    stats.framesDropped++;
+  }
+  encodeFrame(wireFrames[sendingFrame ^ 1]);
+  framePending = true;
+  lastFrameHash = hash;
+  lastShowTime = currentTime;
+  transmitPending();
+  return true;
+}
+
+void compositorFrameDone() {
+  transmitPending();
+}
+
+bool compositorBusy() {
+  return framePending || frameInFlight || halLEDBusy();
+}
+
+const CompositorStats& compositorStats() {
+  return stats;
+}
+
+const LEDLayout& compositorLayout() {
+  return layout;
+}
+
+size_t compositorMemoryBytes() {
+  return frameMemoryBytes;
+}
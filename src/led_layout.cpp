@@ -0,0 +1,182 @@
+#include "led_layout.h"
+
+#include <stdio.h>
+#include <string.h>
+#include "json_reader.h"
+#include "log.h"
+
+// WS281x：每像素 24 位 × 1.25 us，帧末 280 us 以上的锁存低电平
+#define LED_MICROS_PER_PIXEL 30
+#define LED_LATCH_MICROS 300
+
+static const struct {
+  const char* name;
+  uint16_t order;
+} ORDER_NAMES[] = {
+  {"rgb", RGB}, {"rbg", RBG}, {"grb", GRB}, {"gbr", GBR}, {"brg", BRG}, {"bgr", BGR}
+};
+
+// 计算每个通道的像素数和每个段在通道内的位置
+static bool finalizeLEDLayout(LEDLayout& layout) {
+  layout.pixelCount = 0;
+  for (uint8_t c = 0; c < layout.channelCount; c++) {
+    layout.channels[c].pixels = 0;
+  }
+  for (uint8_t s = 0; s < layout.segmentCount; s++) {
+    LEDSegment& segment = layout.segments[s];
+    if (segment.channel >= layout.channelCount || segment.count == 0 ||
+        (uint32_t)segment.start + segment.count > LED_MAX_PIXELS) {
+      return false;
+    }
+    LEDChannelConfig& channel = layout.channels[segment.channel];
+    if ((uint32_t)channel.pixels + segment.count > LED_MAX_PIXELS) {
+      return false;
+    }
+    segment.offset = channel.pixels;
+    channel.pixels += segment.count;
+    if (segment.start + segment.count > layout.pixelCount) {
+      layout.pixelCount = segment.start + segment.count;
+    }
+  }
+  return layout.pixelCount > 0;
+}
+
+void defaultLEDLayout(LEDLayout& out) {
+  memset(&out, 0, sizeof(out));
+  out.channels[0].pin = LED_PIN;
+  out.channels[0].order = COLOR_ORDER;
+  out.channelCount = 1;
+  out.segments[0].start = 0;
+  out.segments[0].count = NUM_LEDS;
+  out.segments[0].channel = 0;
+  out.segmentCount = 1;
+  finalizeLEDLayout(out);
+}
+
+// ==================== JSON ====================
+static bool readU16(JsonReader& reader, uint16_t& value) {
+  uint32_t v;
+  if (!reader.u32(v) || v > UINT16_MAX) return false;
+  value = (uint16_t)v;
+  return true;
+}
+
+static bool readChannel(JsonReader& reader, LEDChannelConfig& channel) {
+  uint32_t pin = UINT32_MAX;
+  channel.order = COLOR_ORDER;
+  char key[16];
+  reader.expect('{');
+  while (reader.more('}')) {
+    if (!reader.key(key, sizeof(key))) return false;
+    bool ok;
+    if (!strcmp(key, "pin")) {
+      ok = reader.u32(pin) && pin < 40;
+    } else if (!strcmp(key, "order")) {
+      char name[8];
+      ok = reader.string(name, sizeof(name));
+      uint8_t i = 0;
+      while (ok && i < sizeof(ORDER_NAMES) / sizeof(ORDER_NAMES[0]) && strcmp(name, ORDER_NAMES[i].name)) i++;
+      ok = ok && i < sizeof(ORDER_NAMES) / sizeof(ORDER_NAMES[0]);
+      if (ok) channel.order = ORDER_NAMES[i].order;
+    } else {
+      ok = reader.skip();
+    }
+    if (!ok) return false;
+  }
+  channel.pin = (uint8_t)pin;
+  return reader.ok() && pin != UINT32_MAX;
+}
+
+static bool readSegment(JsonReader& reader, LEDSegment& segment) {
+  memset(&segment, 0, sizeof(segment));
+  uint32_t channel = 0;
+  char key[16];
+  reader.expect('{');
+  while (reader.more('}')) {
+    if (!reader.key(key, sizeof(key))) return false;
+    bool ok;
+    if (!strcmp(key, "channel")) {
+      ok = reader.u32(channel) && channel < HAL_LED_MAX_CHANNELS;
+    } else if (!strcmp(key, "start")) {
+      ok = readU16(reader, segment.start);
+    } else if (!strcmp(key, "count")) {
+      ok = readU16(reader, segment.count);
+    } else if (!strcmp(key, "reverse")) {
+      ok = reader.boolean(segment.reverse);
+    } else {
+      ok = reader.skip();
+    }
+    if (!ok) return false;
+  }
+  segment.channel = (uint8_t)channel;
+  return reader.ok();
+}
+
+static bool parseFailed(const JsonReader& reader, const char* what, char* error, size_t capacity) {
+  snprintf(error, capacity, "%s（位置 %u）", what, (unsigned)reader.offset());
+  return false;
+}
+
+bool parseLEDLayoutJSON(LEDLayout& out, const char* text, size_t length, char* error, size_t errorCapacity) {
+  memset(&out, 0, sizeof(out));
+  JsonReader reader(text, length);
+  char key[16];
+  reader.expect('{');
+  while (reader.more('}')) {
+    if (!reader.key(key, sizeof(key))) {
+      return parseFailed(reader, "语法错误", error, errorCapacity);
+    }
+    if (!strcmp(key, "channels")) {
+      reader.expect('[');
+      while (reader.more(']')) {
+        if (out.channelCount == HAL_LED_MAX_CHANNELS) {
+          return parseFailed(reader, "通道过多", error, errorCapacity);
+        }
+        if (!readChannel(reader, out.channels[out.channelCount++])) {
+          return parseFailed(reader, "通道无效", error, errorCapacity);
+        }
+      }
+    } else if (!strcmp(key, "segments")) {
+      reader.expect('[');
+      while (reader.more(']')) {
+        if (out.segmentCount == LED_MAX_SEGMENTS) {
+          return parseFailed(reader, "段过多", error, errorCapacity);
+        }
+        if (!readSegment(reader, out.segments[out.segmentCount++])) {
+          return parseFailed(reader, "段无效", error, errorCapacity);
+        }
+      }
+    } else if (!reader.skip()) {
+      return parseFailed(reader, "语法错误", error, errorCapacity);
+    }
+  }
+  if (!reader.ok()) {
+    return parseFailed(reader, "语法错误", error, errorCapacity);
+  }
+  if (!finalizeLEDLayout(out)) {
+    return parseFailed(reader, "段超出范围或引用了不存在的通道", error, errorCapacity);
+  }
+  return true;
+}
+
+bool loadLEDLayout(LEDLayout& out) {
+  static char text[LED_LAYOUT_JSON_CAPACITY];
+  int32_t length = halFileRead(LED_LAYOUT_FILE_PATH, text, sizeof(text));
+  if (length >= 0) {
+    char error[64];
+    if (parseLEDLayoutJSON(out, text, (size_t)length, error, sizeof(error))) {
+      return true;
+    }
+    LOG_WARN(LOG_LED_LAYOUT_INVALID, LED_LAYOUT_FILE_PATH, logText(error));
+  }
+  defaultLEDLayout(out);
+  return false;
+}
+
+uint32_t ledLayoutFrameMicros(const LEDLayout& layout) {
+  uint16_t longest = 0;
+  for (uint8_t c = 0; c < layout.channelCount; c++) {
+    if (layout.channels[c].pixels > longest) longest = layout.channels[c].pixels;
+  }
+  return (uint32_t)longest * LED_MICROS_PER_PIXEL + LED_LATCH_MICROS;
+}
@@ -0,0 +1,320 @@
+#include <atomic>
+#include "log.h"
+#include "tasks.h"
+#include "ws_fanout.h"
+
+static_assert(LOG_LINE_CAPACITY < LOG_SERIAL_TX_BUFFER, "一行日志必须放得下串口发送缓冲区");
+static_assert(LOG_LINE_CAPACITY < LOG_VIEW_FRAME_CAPACITY, "一行日志必须放得下 WebSocket 文本帧");
+
+// ==================== 事件表 ====================
+// 下标为 LogEvent，占位符见 log.h
+static const char* const LOG_FORMATS[NUM_LOG_EVENTS] = {
+  "ESP32 Ball 系统启动中...",                                    // LOG_BOOT_START
+  "系统初始化完成",                                              // LOG_BOOT_DONE
+  "启动耗时: 首次按钮扫描 %m，首帧 %m，WiFi %m，MQTT就绪 %m",     // LOG_BOOT_TIMINGS
+  "按钮初始化完成",                                              // LOG_BUTTONS_READY
+  "LED灯带初始化完成",                                           // LOG_LED_READY
+  "灯带布局: %u 个通道，%u 个段，%u 个像素，帧缓冲 %u 字节（每像素 %u.%u 字节），单帧发送 %u us",  // LOG_LED_LAYOUT
+  "灯带布局 %s 无效：%t",                                        // LOG_LED_LAYOUT_INVALID
+  "后台连接WiFi: %s",                                            // LOG_WIFI_BEGIN
+  "WiFi连接成功（%s，%u ms），IP地址: %t",                        // LOG_WIFI_CONNECTED
+  "WiFi缓存直连失败，改为全扫描",                                 // LOG_WIFI_FAST_FAILED
+  "WiFi连接失败，%u ms 后重试",                                   // LOG_WIFI_FAILED
+  "WiFi连接断开，%u ms 后重连",                                   // LOG_WIFI_LOST
+  "MQTT客户端初始化完成",                                        // LOG_MQTT_READY
+  "尝试连接MQTT服务器...",                                        // LOG_MQTT_CONNECTING
+  "MQTT连接成功（%u ms）",                                        // LOG_MQTT_CONNECTED
+  "MQTT连接失败，状态码: %d，%u ms 后重试",                       // LOG_MQTT_FAILED
+  "MQTT连接断开，%u ms 后重连",                                   // LOG_MQTT_LOST
+  "收到MQTT消息 %t",                                             // LOG_MQTT_MESSAGE
+  "MQTT命令无效：%t",                                            // LOG_COMMAND_INVALID
+  "MQTT命令队列满，丢弃 %t",                                      // LOG_COMMAND_DROPPED
+  "MQTT命令路由 %t 无法加入路由表",                               // LOG_COMMAND_ROUTE_FAILED
+  "MQTT命令接管灯效",                                             // LOG_REMOTE_TAKEOVER
+  "灯效交还按钮规则（%s）",                                       // LOG_REMOTE_RELEASED
+  "MQTT待发缓冲区恢复 %u 条事件",                                 // LOG_OUTBOX_RESTORED
+  "引脚状态（%u 个按钮）: 按下 %t",  // LOG_BUTTON_STATUS
+  "按钮P%u状态改变：发送 %s",                                     // LOG_BUTTON_EDGE
+  "规则 %t 触发：发送 %s",                                        // LOG_RULE_FIRED
+  "按钮规则：从 %s 加载 %u 条",                                   // LOG_RULES_LOADED
+  "规则文件 %s 无效：%t",                                         // LOG_RULES_FILE_INVALID
+  "按钮规则：上一次更新尚未生效，忽略",                            // LOG_RULES_BUSY
+  "按钮规则无效：%t",                                             // LOG_RULES_INVALID
+  "按钮规则：写入文件失败，仅本次运行有效",                        // LOG_RULES_WRITE_FAILED
+  "按钮规则已更新：%u 条",                                        // LOG_RULES_UPDATED
+  "Web服务器启动完成",                                           // LOG_WEB_READY
+  "WebSocket客户端 #%u 连接",                                     // LOG_WS_CONNECT
+  "WebSocket客户端 #%u 断开连接",                                 // LOG_WS_DISCONNECT
+  "WebSocket客户端 #%u 落后 %u ms（积压 %u 帧），断开",            // LOG_WS_EVICTED
+  "WebSocket客户端 #%u 被拒绝：已有 %u 个客户端",                 // LOG_WS_REJECTED
+  "输入录制开始：按下掩码 0x%x",                                  // LOG_TRACE_STARTED
+  "输入录制停止：%u 个边沿，%u 字节",                              // LOG_TRACE_STOPPED
+  "输入录制截断：%u 个边沿，%u 字节（%s）",                        // LOG_TRACE_TRUNCATED
+  "输入录制：上一次录制尚未写完，忽略开始请求",                    // LOG_TRACE_BUSY
+  "输入录制已保存到 %s：%u 字节",                                  // LOG_TRACE_SAVED
+  "输入录制：写入 %s 失败",                                        // LOG_TRACE_WRITE_FAILED
+  "进入空闲：帧周期 %u ms，允许浅睡眠",                            // LOG_POWER_IDLE
+  "退出空闲：累计浅睡眠 %u 次，醒着的时间 %u.%u%%",                // LOG_POWER_ACTIVE
+  "动画片段：%u 个，%u bytes",                                    // LOG_CLIPS_READY
+  "动画片段分区无效，按空处理",                                   // LOG_CLIPS_CORRUPT
+  "动画片段 %t 不存在，输出黑色",                                 // LOG_CLIP_MISSING
+  "动画片段 %t 第 %u 帧数据无效，停止播放",                        // LOG_CLIP_FRAME_INVALID
+  "片段模式表已满，忽略 %t",                                      // LOG_CLIP_MODES_FULL
+  "动画片段上传完成：%u 个片段，%u bytes",                         // LOG_CLIP_UPLOAD_DONE
+  "动画片段上传被拒绝：%s",                                       // LOG_CLIP_UPLOAD_REJECTED
+  "开始OTA更新: %t",                                             // LOG_OTA_BEGIN
+  "OTA更新成功: %u bytes，%u ms，SHA-256 一致，%u ms 后重启",      // LOG_OTA_DONE
+  "OTA更新失败: %s（已接收 %u bytes，已写入 %u bytes）",           // LOG_OTA_FAILED
+  "OTA更新进行中，拒绝上传 %t",                                   // LOG_OTA_BUSY
+  "日志缓冲区满，丢弃 %u 条",                                     // LOG_DROPPED
+};
+
+static const char LEVEL_TAGS[] = {'?', 'E', 'W', 'I', 'D'};
+
+// syslog 严重级别（RFC 5424），设施为 local0
+static const uint8_t SYSLOG_SEVERITY[] = {7, 3, 4, 6, 7};
+#define SYSLOG_FACILITY 16
+
+// ==================== 写入侧（任意任务） ====================
+struct RateWindow {
+  std::atomic<uint32_t> window;
+  std::atomic<uint32_t> count;
+  std::atomic<uint32_t> suppressed;  // 自该事件上一次输出以来被限流的条数
+};
+
+static LogQueue queue;
+static RateWindow rates[NUM_LOG_EVENTS];
+static std::atomic<uint32_t> written(0);
+static std::atomic<uint32_t> suppressed(0);
+static std::atomic<uint32_t> dropped(0);
+static std::atomic<uint16_t> maxDepth(0);
+
+LogQueue& logQueue() {
+  return queue;
+}
+
+// 窗口切换时多个写入方可能同时清零计数，限流是近似的
+bool logAdmit(uint8_t event, uint32_t nowMillis) {
+  RateWindow& rate = rates[event];
+  uint32_t window = nowMillis / LOG_RATE_WINDOW;
+  if (rate.window.load(std::memory_order_relaxed) != window) {
+    rate.window.store(window, std::memory_order_relaxed);
+    rate.count.store(0, std::memory_order_relaxed);
+  }
+  if (rate.count.fetch_add(1, std::memory_order_relaxed) < LOG_RATE_LIMIT) {
+    return true;
+  }
+  rate.suppressed.fetch_add(1, std::memory_order_relaxed);
+  suppressed.fetch_add(1, std::memory_order_relaxed);
+  return false;
+}
+
+void logPushed(bool ok) {
+  if (!ok) {
+    dropped.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  written.fetch_add(1, std::memory_order_relaxed);
+  uint16_t depth = queue.size();
+  uint16_t seen = maxDepth.load(std::memory_order_relaxed);
+  while (depth > seen && !maxDepth.compare_exchange_weak(seen, depth, std::memory_order_relaxed)) {
+  }
+  if (depth == LOG_RING_SIZE / 2) {
+    halNotifyTask(TASK_NETWORK);
+  }
+}
+
+// ==================== 格式化 ====================
+static void writeHex(TextWriter& out, uint32_t value) {
+  char text[8];
+  size_t n = 0;
+  do {
+    text[7 - n++] = "0123456789abcdef"[value & 0xF];
+    value >>= 4;
+  } while (value);
+  out.raw(text + 8 - n, n);
+}
+
+static void formatMessage(TextWriter& out, const LogRecord& record) {
+  const char* format = LOG_FORMATS[record.event < NUM_LOG_EVENTS ? record.event : (uint8_t)LOG_DROPPED];
+  uint8_t next = 0;
+  for (const char* p = format; *p; p++) {
+    const char* start = p;
+    while (*p && *p != '%') p++;
+    out.raw(start, p - start);
+    if (!*p) break;
+
+    char spec = *++p;
+    if (spec == '%') {
+      out.put('%');
+      continue;
+    }
+    if (spec == 't') {
+      out.raw(record.text, record.textLength);
+      continue;
+    }
+    if (spec == '\0' || next >= record.argCount) {
+      out.put('?');  // 参数少于占位符
+      if (spec == '\0') break;
+      continue;
+    }
+    bool isString = record.stringArgs & (1u << next);
+    uintptr_t arg = record.args[next++];
+    if (isString != (spec == 's')) {
+      out.put('?');
+      continue;
+    }
+    switch (spec) {
+      case 'u': out.u32((uint32_t)arg); break;
+      case 'd': out.i32((int32_t)arg); break;
+      case 'x': writeHex(out, (uint32_t)arg); break;
+      case 's': out.raw(arg ? (const char*)arg : "(null)"); break;
+      case 'm':
+        if ((uint32_t)arg == UINT32_MAX) {
+          out.put('-');
+        } else {
+          out.fixed((uint32_t)arg, 3).raw(" ms");
+        }
+        break;
+      default: out.put('?'); break;
+    }
+  }
+}
+
+// [12.345] I 消息
+void formatLogRecord(TextWriter& out, const LogRecord& record) {
+  out.put('[').fixed(record.millis, 3).raw("] ");
+  out.put(LEVEL_TAGS[record.level < sizeof(LEVEL_TAGS) ? record.level : 0]).put(' ');
+  formatMessage(out, record);
+}
+
+// ==================== 输出侧（网络任务） ====================
+// 串口放不下时格式化好的一行留在这里，下一次作业先输出它
+static char line[LOG_LINE_CAPACITY];
+static size_t lineLength = 0;
+static bool linePending = false;
+
+static uint32_t emitted = 0;
+static uint32_t deferred = 0;
+static uint32_t reportedDrops = 0;
+static const char* syslogHost = "";
+static uint16_t syslogPort = SYSLOG_PORT;
+
+void initializeLog() {
+  for (RateWindow& rate : rates) {
+    rate.window.store(0, std::memory_order_relaxed);
+    rate.count.store(0, std::memory_order_relaxed);
+    rate.suppressed.store(0, std::memory_order_relaxed);
+  }
+  written.store(0, std::memory_order_relaxed);
+  suppressed.store(0, std::memory_order_relaxed);
+  dropped.store(0, std::memory_order_relaxed);
+  maxDepth.store(0, std::memory_order_relaxed);
+  emitted = 0;
+  deferred = 0;
+  reportedDrops = 0;
+  setSyslogServer(SYSLOG_SERVER, SYSLOG_PORT);
+}
+
+void setSyslogServer(const char* host, uint16_t port) {
+  syslogHost = host ? host : "";
+  syslogPort = port;
+}
+
+static void sendSyslog(const LogRecord& record) {
+  if (!syslogHost[0] || !halWiFiConnected()) {
+    return;
+  }
+  // RFC 3164：<PRI>TAG: MSG，时间戳由服务器补上
+  FixedTextWriter<LOG_LINE_CAPACITY> packet;
+  uint8_t severity = SYSLOG_SEVERITY[record.level < sizeof(SYSLOG_SEVERITY) ? record.level : 0];
+  packet.put('<').u32(SYSLOG_FACILITY * 8 + severity).raw(">ball: ");
+  formatMessage(packet, record);
+  halUDPSend(syslogHost, syslogPort, (const uint8_t*)packet.c_str(), packet.length());
+}
+
+// WebSocket 日志视图：一次作业输出的行用 '\n' 连接成一帧
+static char viewFrame[LOG_VIEW_FRAME_CAPACITY];
+static size_t viewLength = 0;
+
+static void flushView() {
+  if (viewLength > 0) {
+    wsBroadcast((const uint8_t*)viewFrame, viewLength, false, WS_CLASS_LOG);
+    viewLength = 0;
+  }
+}
+
+static void appendView(const char* text, size_t length) {
+  if (viewLength + length + 1 > sizeof(viewFrame)) {
+    flushView();
+  }
+  if (viewLength > 0) {
+    viewFrame[viewLength++] = '\n';
+  }
+  memcpy(viewFrame + viewLength, text, length);
+  viewLength += length;
+}
+
+// 格式化一条记录到 line，并立即发给不会阻塞的远程输出
+static void takeRecord(const LogRecord& record) {
+  TextWriter out(line, sizeof(line));
+  formatLogRecord(out, record);
+  uint32_t skipped = rates[record.event].suppressed.exchange(0, std::memory_order_relaxed);
+  if (skipped) {
+    out.raw("（同类日志另有 ").u32(skipped).raw(" 条被限流）");
+  }
+  lineLength = out.length();
+  linePending = true;
+
+  if (record.level > LOG_REMOTE_LEVEL) {
+    return;
+  }
+  sendSyslog(record);
+  if (wsLogViewers() > 0) {
+    appendView(line, lineLength);
+  }
+}
+
+bool drainLog() {
+  for (uint8_t n = 0; n < LOG_DRAIN_BATCH; n++) {
+    if (!linePending) {
+      LogRecord record;
+      uint32_t lost = dropped.load(std::memory_order_relaxed);
+      if (lost != reportedDrops) {
+        record = LogRecord{(uint32_t)halMillis(), LOG_LEVEL_WARN, LOG_DROPPED, 1, 0, 0, {lost - reportedDrops}, {0}};
+        reportedDrops = lost;
+      } else if (!queue.pop(record)) {
+        break;
+      }
+      takeRecord(record);
+    }
+
+    // 只写发送缓冲区放得下的整行，串口慢时留到下一次作业，作业本身从不阻塞
+    if ((size_t)Serial.availableForWrite() < lineLength + 1) {
+      deferred++;
+      break;
+    }
+    Serial.write((const uint8_t*)line, lineLength);
+    Serial.write((uint8_t)'\n');
+    emitted++;
+    linePending = false;
+  }
+
+  flushView();
+  return linePending || queue.size() > 0;
+}
+
+bool logPending() {
+  return queue.size() >= LOG_RING_SIZE / 2;
+}
+
+LogStats logStats() {
+  LogStats stats;
+  stats.written = written.load(std::memory_order_relaxed);
+  stats.suppressed = suppressed.load(std::memory_order_relaxed);
+  stats.dropped = dropped.load(std::memory_order_relaxed);
+  stats.emitted = emitted;
+  stats.deferred = deferred;
+  stats.maxDepth = maxDepth.load(std::memory_order_relaxed);
+  return stats;
+}
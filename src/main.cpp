@@ -1,669 +1,592 @@
-#include <Arduino.h>
-#include <FastLED.h>
-#include <WiFi.h>
-#include <PubSubClient.h>
-#include <ESPAsyncWebServer.h>
-#include <AsyncTCP.h>
-#include <Update.h>
-#include "config.h"
-
-// ==================== 全局对象 ====================
-CRGB leds[NUM_LEDS];
-WiFiClient wifiClient;
-PubSubClient mqttClient(wifiClient);
-AsyncWebServer webServer(WEB_SERVER_PORT);
-AsyncWebSocket webSocket("/ws");
+#include "ball.h"
+#include "led_compositor.h"
+#include "effects.h"
+#include "clips.h"
+#include "button_events.h"
+#include "ws_protocol.h"
+#include "wifi_manager.h"
+#include "mqtt_manager.h"
+#include "mqtt_outbox.h"
+#include "metrics.h"
+#include "button_rules.h"
+#include "log.h"
+#include "ws_fanout.h"
+#include "input_trace.h"
+#include "power.h"
+#include "mqtt_commands.h"
+#include "ota.h"
 
 // 全局状态
-ButtonState buttonStates[7];  // 固定7个按钮
+ButtonInput buttonInput;
 LEDController ledController;
 SystemStatus systemStatus;
+BootTimings bootTimings;
 
-// ==================== 函数声明 ====================
-void initializeSystem();
-void initializeButtons();
-void initializeLED();
-void initializeWiFi();
-void initializeMQTT();
-void initializeWebServer();
-
-void mainLoop();
-void updateButtonStates();
-void updateLEDController();
-void updateMQTTConnection();
-void updateWebSocket();
-
-void handleButtonLogic();
-void setLEDMode(LEDMode mode);
-void processLEDBreatheRed();
-void processLEDBreatheGreen();
-void processLEDFlashYellow();
-void turnOffLEDs();
-
-void onMQTTMessage(char* topic, byte* payload, unsigned int length);
-void onWebSocketEvent(AsyncWebSocket *server, AsyncWebSocketClient *client, 
-                      AwsEventType type, void *arg, uint8_t *data, size_t len);
-
-bool connectToWiFi();
-bool connectToMQTT();
-void sendButtonStates();
-void sendMQTTMessage(const char* topic, const char* message);
-
-String getHTMLContent();
-void handleOTAUpload(AsyncWebServerRequest *request, String filename, 
-                     size_t index, uint8_t *data, size_t len, bool final);
+static Debouncer debouncer;
+static Effect remoteEffect;   // ledController.remote 时渲染的灯效
+static uint8_t remoteLevel;   // 及其亮度上限
+static LEDMode ruleMode;      // 接管前按钮规则选择的模式，交还时恢复
+static uint32_t nextSampleMicros = 0;  // 下一次消抖采样的时间点
+static uint32_t edgeStartMicros[BTN_COUNT];  // 原始状态偏离消抖状态的边沿时刻
 
 // ==================== Arduino 主函数 ====================
+// 主机构建的入口在 src/native/main_native.cpp
+#ifdef ARDUINO
 void setup() {
+  Serial.setTxBufferSize(LOG_SERIAL_TX_BUFFER);  // 日志作业按 availableForWrite() 写入，见 log.h
   Serial.begin(115200);
-  Serial.println("ESP32 Ball 系统启动中...");
+  LOG_INFO(LOG_BOOT_START);
   
   initializeSystem();
-  Serial.println("系统初始化完成");
+  startTasks();
+  LOG_INFO(LOG_BOOT_DONE);
 }
 
 void loop() {
-  mainLoop();
+  // 所有工作都在 startTasks() 创建的渲染/网络任务中完成
+  vTaskDelete(NULL);
 }
+#endif // ARDUINO
 
 // ==================== 系统初始化 ====================
+// 不等待任何网络连接：按钮和灯效在第一次调度时就开始工作，WiFi/MQTT 在网络任务中后台完成
 void initializeSystem() {
+  bootTimings.firstInputMicros = BOOT_MILESTONE_PENDING;
+  bootTimings.firstFrameMicros = BOOT_MILESTONE_PENDING;
+  bootTimings.wifiConnectedMicros = BOOT_MILESTONE_PENDING;
+  bootTimings.mqttReadyMicros = BOOT_MILESTONE_PENDING;
+
+  initializeLog();
+  initializeWebSocketFanout();
+  initializeInputTrace();
+  initializeMetrics();
+  initializeButtonRules();
   initializeButtons();
   initializeLED();
+  initializeClips();
+  initializeOTA();
   initializeWiFi();
   initializeMQTT();
+#ifdef ARDUINO
   initializeWebServer();
+#endif
   
   // 初始化系统状态
   systemStatus.wifiConnected = false;
   systemStatus.mqttConnected = false;
-  systemStatus.allPinsTriggered = false;
-  systemStatus.previousAllPinsTriggered = false;
-  systemStatus.previousP32Triggered = false;
-  systemStatus.p32Triggered = false;
-  systemStatus.firstTriggeredSent = false;  // 初始化首次触发标志为false
-  
-  // 初始化初始按钮状态数组
-  for (int i = 0; i < 6; i++) {
-    systemStatus.initialButtonStates[i] = HIGH;  // 默认初始状态为HIGH（未按下）
-  }
+  systemStatus.activeRule = RULE_NONE;
+  systemStatus.evaluatedPressed = 0;  // 默认初始状态为未按下
   
   // 初始化LED控制器
   ledController.mode = LED_BREATHE_RED;  // 默认红色呼吸
-  ledController.lastUpdateTime = 0;
-  ledController.blinkState = false;
-  ledController.breathState = 0;
-  ledController.breathDirection = 1;
+  ledController.modeStartMillis = halMillis();
   ledController.greenBreathBrightness = 0;  // 初始亮度为0
+  ledController.remote = false;
+
+  initializeTasks();
+  initializePower();
+  publishStateSnapshot();
 }
 
 void initializeButtons() {
-  for (uint8_t i = 0; i < 7; i++) {
-    pinMode(BUTTON_PINS[i], INPUT_PULLUP);
-    buttonStates[i].current = HIGH;
-    buttonStates[i].previous = HIGH;
-    buttonStates[i].lastDebounceTime = 0;
-    buttonStates[i].stateChanged = false;
+  for (uint8_t i = 0; i < BTN_COUNT; i++) {
+    halPinModeInputPullup(BUTTON_PINS[i]);
   }
-  Serial.println("按钮初始化完成");
+  initializeButtonEvents(TASK_RENDER);
+
+  buttonInput.pressed = 0;
+  buttonInput.raw = sampleButtonMask();
+  buttonInput.pressedEdges = 0;
+  buttonInput.releasedEdges = 0;
+  debouncer.reset(0);
+  nextSampleMicros = halMicros();
+  LOG_INFO(LOG_BUTTONS_READY);
 }
 
 void initializeLED() {
-  FastLED.addLeds<LED_TYPE, LED_PIN, COLOR_ORDER>(leds, NUM_LEDS);
-  FastLED.setBrightness(LED_BRIGHTNESS);
-  FastLED.clear();
-  FastLED.show();
-  Serial.println("LED灯带初始化完成");
+  initializeCompositor(TASK_RENDER);
+  LOG_INFO(LOG_LED_READY);
 }
 
 void initializeWiFi() {
-  Serial.print("连接WiFi: ");
-  Serial.println(WIFI_SSID);
-  
-  WiFi.begin(WIFI_SSID, WIFI_PASSWORD);
-  
-  uint8_t attempts = 0;
-  while (WiFi.status() != WL_CONNECTED && attempts < 20) {
-    delay(500);
-    Serial.print(".");
-    attempts++;
-  }
-  
-  if (WiFi.status() == WL_CONNECTED) {
-    systemStatus.wifiConnected = true;
-    Serial.println("\nWiFi连接成功");
-    Serial.print("IP地址: ");
-    Serial.println(WiFi.localIP());
-    Serial.print("WebUI地址: http://");
-    Serial.println(WiFi.localIP());
-  } else {
-    Serial.println("\nWiFi连接失败");
-  }
+  LOG_INFO(LOG_WIFI_BEGIN, WIFI_SSID);
+  initializeWiFiManager(TASK_NETWORK);
 }
 
+// 收到的消息经 mqtt_commands.cpp 的路由表分发，连上后订阅路由表需要的主题
 void initializeMQTT() {
-  mqttClient.setServer(MQTT_SERVER, MQTT_PORT);
-  mqttClient.setCallback(onMQTTMessage);
-  Serial.println("MQTT客户端初始化完成");
-}
-
-void initializeWebServer() {
-  webSocket.onEvent(onWebSocketEvent);
-  webServer.addHandler(&webSocket);
-  
-  webServer.on("/", HTTP_GET, [](AsyncWebServerRequest *request) {
-    request->send(200, "text/html", getHTMLContent());
-  });
-  
-  webServer.on("/api/buttons", HTTP_GET, [](AsyncWebServerRequest *request) {
-    String json = "{";
-    for (uint8_t i = 0; i < 7; i++) {
-      json += "\"p" + String(BUTTON_PINS[i]) + "\":" + 
-              String(buttonStates[i].current == LOW ? "true" : "false");
-      if (i < 6) json += ",";
-    }
-    json += "}";
-    request->send(200, "application/json", json);
-  });
-  
-  webServer.on("/update", HTTP_POST, 
-    [](AsyncWebServerRequest *request) {
-      if (Update.hasError()) {
-        request->send(500, "text/plain", "更新失败");
-      } else {
-        request->send(200, "text/plain", "更新成功，设备正在重启...");
-        delay(1000);
-        ESP.restart();
-      }
-    }, 
-    handleOTAUpload
-  );
-  
-  webServer.begin();
-  Serial.println("Web服务器启动完成");
+  initializeMQTTCommands();
+  halMQTTBegin(MQTT_SERVER, MQTT_PORT, dispatchMQTTMessage, TASK_NETWORK);
+  initializeMQTTOutbox();
+  uint8_t topicCount;
+  const char* const* topics = mqttCommandSubscriptions(topicCount);
+  initializeMQTTManager(MQTT_USER, topics, topicCount);
+  LOG_INFO(LOG_MQTT_READY);
 }
 
 // ==================== 主循环 ====================
+// 作业按截止时间运行，周期见 config.h；LED 作业的周期随灯效模式变化（见 setLEDMode）
+const JobSpec RENDER_JOBS[NUM_RENDER_JOBS] = {
+  {"updateInput", updateInput, INPUT_IDLE_POLL_INTERVAL * 1000UL, INPUT_JOB_TOLERANCE_US},
+  {"updateLEDController", updateLEDController, BREATHE_INTERVAL * 1000UL, LED_JOB_TOLERANCE_US},
+  {"printButtonStatus", printButtonStatus, STATUS_PRINT_INTERVAL * 1000UL, NETWORK_JOB_TOLERANCE_US}
+};
+
+const JobSpec NETWORK_JOBS[NUM_NETWORK_JOBS] = {
+  {"updateWiFi", updateWiFi, WIFI_CHECK_INTERVAL * 1000UL, NETWORK_JOB_TOLERANCE_US},
+  {"updateMQTTClient", updateMQTTClient, MQTT_LOOP_INTERVAL * 1000UL, NETWORK_JOB_TOLERANCE_US},
+  {"updateMQTTConnection", updateMQTTConnection, MQTT_CHECK_INTERVAL * 1000UL, NETWORK_JOB_TOLERANCE_US},
+#if WEBSOCKET_PROTOCOL == WS_PROTOCOL_JSON
+  {"updateWebSocket", updateWebSocket, WEBSOCKET_UPDATE_INTERVAL * 1000UL, NETWORK_JOB_TOLERANCE_US},
+#else
+  {"updateWebSocket", updateWebSocket, WEBSOCKET_KEYFRAME_INTERVAL * 1000UL, NETWORK_JOB_TOLERANCE_US},
+#endif
+  {"updateWebSocketClients", updateWebSocketClients, WS_CLIENT_EVICT_MS * 1000UL, NETWORK_JOB_TOLERANCE_US},
+  {"publishMetrics", publishMetrics, METRICS_PUBLISH_INTERVAL * 1000UL, NETWORK_JOB_TOLERANCE_US},
+  {"updateLog", updateLog, LOG_DRAIN_INTERVAL * 1000UL, NETWORK_JOB_TOLERANCE_US},
+  {"flushInputTrace", flushInputTrace, INPUT_TRACE_FLUSH_INTERVAL * 1000UL, NETWORK_JOB_TOLERANCE_US},
+  {"publishOTAProgress", publishOTAProgress, OTA_PROGRESS_IDLE_INTERVAL * 1000UL, NETWORK_JOB_TOLERANCE_US}
+};
+
+// 单核构建：两个调度器和 flash 写入共用一个线程，休眠到较早的截止时间或按钮中断/消息投递
 void mainLoop() {
+  uint32_t renderWait = runRenderTask();
+  uint32_t networkWait = runNetworkTask();
+  uint32_t otaWait = runFlashTask();
+  uint32_t wait = renderWait < networkWait ? renderWait : networkWait;
+  halWaitForNotify(otaWait < wait ? otaWait : wait);
+}
+
+// ==================== 输入作业 ====================
+// 由按钮中断唤醒，或每 INPUT_IDLE_POLL_INTERVAL 兜底运行一次。
+// 原始状态与消抖状态不一致时按消抖采样周期继续运行，直到消抖器稳定。
+void updateInput() {
+  bool edges = hasPendingButtonEvents();
   updateButtonStates();
-  updateLEDController();
-  updateMQTTConnection();
-  updateWebSocket();
+  markBootMilestone(bootTimings.firstInputMicros);
+  handleRemoteCommands();
+  uint32_t span = traceBegin();
   handleButtonLogic();
-  
-  delay(10); // 小延迟以稳定系统
+  if (buttonInput.pressedEdges | buttonInput.releasedEdges) {
+    traceEnd(METRIC_BUTTON_LOGIC, span);  // 只统计处理按钮变化的调用
+  }
+  publishStateSnapshot();
+  updatePowerState(edges || buttonInput.raw != debouncer.state);
+
+  if (buttonInput.raw != debouncer.state) {
+    renderScheduler.scheduleAt(JOB_INPUT, nextSampleMicros);
+  }
 }
 
 // ==================== 按钮状态更新 ====================
+// 按固定采样周期推进消抖器直到 untilMicros，期间原始状态为 buttonInput.raw。
+// 主循环卡顿时补采样；连续 DEBOUNCER_SAMPLES 次之后再采样结果不变，多余的直接跳过。
+static void clockDebouncer(uint32_t untilMicros) {
+  uint8_t samples = 0;
+  while ((int32_t)(untilMicros - nextSampleMicros) >= 0) {
+    if (samples < DEBOUNCER_SAMPLES) {
+      debouncer.sample(buttonInput.raw);
+      buttonInput.pressedEdges |= debouncer.pressed;
+      buttonInput.releasedEdges |= debouncer.released;
+      samples++;
+      nextSampleMicros += DEBOUNCE_SAMPLE_INTERVAL_US;
+    } else {
+      uint32_t skipped = (untilMicros - nextSampleMicros) / DEBOUNCE_SAMPLE_INTERVAL_US + 1;
+      nextSampleMicros += skipped * DEBOUNCE_SAMPLE_INTERVAL_US;
+    }
+  }
+}
+
 void updateButtonStates() {
-  for (uint8_t i = 0; i < 7; i++) {
-    bool reading = digitalRead(BUTTON_PINS[i]);
-    
-    if (reading != buttonStates[i].previous) {
-      buttonStates[i].lastDebounceTime = millis();
+  buttonInput.pressedEdges = 0;
+  buttonInput.releasedEdges = 0;
+
+  // 按时间顺序回放中断采集的边沿事件，每个事件之前的采样点使用事件之前的原始状态
+  ButtonEvent event;
+  while (popButtonEvent(event)) {
+    recordInputEdge(event.index, event.level, event.timestampMicros);
+    clockDebouncer(event.timestampMicros);
+    uint32_t mask = BUTTON_MASK(event.index);
+    bool wasSettled = !((buttonInput.raw ^ debouncer.state) & mask);
+    buttonInput.raw = (event.level == LOW) ? (buttonInput.raw | mask) : (buttonInput.raw & ~mask);
+    if (wasSettled && ((buttonInput.raw ^ debouncer.state) & mask)) {
+      edgeStartMicros[event.index] = event.timestampMicros;
     }
-    
-    if ((millis() - buttonStates[i].lastDebounceTime) > DEBOUNCE_DELAY) {
-      if (reading != buttonStates[i].current) {
-        buttonStates[i].current = reading;
-        buttonStates[i].stateChanged = true;
+  }
+  uint32_t now = halMicros();
+  clockDebouncer(now);
+
+  // 以输入寄存器为准校正原始状态：队列溢出、中断丢失或浅睡眠期间的变化不会卡在错误电平；
+  // 错过边沿的按钮从现在起算消抖
+  bool resync = takeButtonEventResync();
+  uint32_t sampled = sampleButtonMask();
+  uint32_t missed = (sampled ^ buttonInput.raw) & ~(buttonInput.raw ^ debouncer.state);
+  for (uint8_t i = 0; missed; i++, missed >>= 1) {
+    if (missed & 1) {
+      edgeStartMicros[i] = now;
+    }
+  }
+  buttonInput.raw = sampled;
+  buttonInput.pressed = debouncer.state;
+  updateInputTrace(buttonInput.raw, resync, now);  // 丢了边沿时录制一次重新同步
+
+  // 边沿 → 消抖确认：从最近一次偏离消抖状态的边沿算起
+  uint32_t changed = buttonInput.pressedEdges | buttonInput.releasedEdges;
+  buttonInput.edgeMicros = now;
+  for (uint8_t i = 0; changed; i++, changed >>= 1) {
+    if (changed & 1) {
+      recordMetric(METRIC_EDGE_TO_DEBOUNCE, now - edgeStartMicros[i]);
+      if ((int32_t)(edgeStartMicros[i] - buttonInput.edgeMicros) < 0) {
+        buttonInput.edgeMicros = edgeStartMicros[i];
       }
     }
-    
-    buttonStates[i].previous = reading;
   }
 }
 
 // ==================== LED控制器 ====================
+// 画面只取决于进入当前模式后经过的时间（见 effects.h），作业周期只决定帧率
 void updateLEDController() {
-  switch (ledController.mode) {
-    case LED_BREATHE_RED:
-      processLEDBreatheRed();
-      break;
-    case LED_BREATHE_GREEN:
-      processLEDBreatheGreen();
-      break;
-    case LED_FLASH_YELLOW:
-      processLEDFlashYellow();
-      break;
-    case LED_OFF:
-    default:
-      turnOffLEDs();
-      break;
-  }
-}
-
-void processLEDFlash() {
-  unsigned long currentTime = millis();
-  if (currentTime - ledController.lastUpdateTime >= BLINK_INTERVAL) {
-    ledController.lastUpdateTime = currentTime;
-    
-    CRGB color = ledController.blinkState ? 
-                 CRGB::Red :    // 红色
-                 CRGB(255, 165, 0);   // 黄色
-    
-    fill_solid(leds, NUM_LEDS, color);
-    FastLED.show();
-    
-    ledController.blinkState = !ledController.blinkState;
-  }
-}
-
-void processLEDBreathe() {
-  unsigned long currentTime = millis();
-  if (currentTime - ledController.lastUpdateTime >= BREATHE_INTERVAL) {
-    ledController.lastUpdateTime = currentTime;
-    
-    ledController.breathState += ledController.breathDirection * BREATHE_STEP;
-    
-    if (ledController.breathState >= 255) {
-      ledController.breathState = 255;
-      ledController.breathDirection = -1;
-    } else if (ledController.breathState <= 0) {
-      ledController.breathState = 0;
-      ledController.breathDirection = 1;
+  const Effect& effect = currentEffect();
+  uint8_t level = ledController.remote ? remoteLevel :
+                  effect.levelFromButtons ? (uint8_t)ledController.greenBreathBrightness : 255;
+  uint32_t elapsed = halMillis() - ledController.modeStartMillis;
+  if (effect.kind == EFFECT_CLIP) {
+    if (!renderClipFrame(ledController.mode, leds, ledCount, elapsed)) {
+      // 片段包被替换，帧率跟着新片段走
+      const Effect& clip = clipModeEffect(ledController.mode);
+      if (ledController.remote) {
+        remoteEffect.framePeriodMillis = clip.framePeriodMillis;
+      }
+      renderScheduler.setPeriod(JOB_LED, ledFramePeriodMicros(clip));
     }
-    
-    fill_solid(leds, NUM_LEDS, CRGB(0, ledController.breathState, 0));
-    FastLED.show();
+  } else {
+    renderEffectFrame(effect, leds, ledCount, elapsed, level);
+    stopClipPlayback();
   }
+  compositorPresent();
+  notePowerFrame();
+  markBootMilestone(bootTimings.firstFrameMicros);
 }
 
-void turnOffLEDs() {
-  fill_solid(leds, NUM_LEDS, CRGB::Black);
-  FastLED.show();
-}
-
-// ==================== LED灯效函数 ====================
-void processLEDBreatheRed() {
-  unsigned long currentTime = millis();
-  if (currentTime - ledController.lastUpdateTime >= BREATHE_INTERVAL) {
-    ledController.lastUpdateTime = currentTime;
-
-    ledController.breathState += ledController.breathDirection * BREATHE_STEP;
-
-    if (ledController.breathState >= 255) {
-      ledController.breathState = 255;
-      ledController.breathDirection = -1;
-    } else if (ledController.breathState <= 0) {
-      ledController.breathState = 0;
-      ledController.breathDirection = 1;
-    }
-
-    // 使用配置的RGB颜色，根据呼吸状态调整亮度
-    uint8_t brightness = ledController.breathState;
-    uint8_t r = (COLOR_BREATHE_RED_R * brightness) / 255;
-    uint8_t g = (COLOR_BREATHE_RED_G * brightness) / 255;
-    uint8_t b = (COLOR_BREATHE_RED_B * brightness) / 255;
+void setLEDMode(LEDMode mode) {
+  if (ledController.mode != mode) {
+    ledController.mode = mode;
+    ledController.modeStartMillis = halMillis();  // 新模式从动画起点开始
 
-    fill_solid(leds, NUM_LEDS, CRGB(r, g, b));
-    FastLED.show();
+    // 新模式的第一帧立即渲染，之后按该模式的帧周期运行（空闲时降帧，见 power.h）
+    renderScheduler.setPeriod(JOB_LED, ledFramePeriodMicros(currentEffect()));
+    renderScheduler.runNow(JOB_LED);
   }
 }
 
-void processLEDBreatheGreen() {
-  unsigned long currentTime = millis();
-  if (currentTime - ledController.lastUpdateTime >= BREATHE_INTERVAL) {
-    ledController.lastUpdateTime = currentTime;
-
-    ledController.breathState += ledController.breathDirection * BREATHE_STEP;
-
-    if (ledController.breathState >= ledController.greenBreathBrightness) {
-      ledController.breathState = ledController.greenBreathBrightness;
-      ledController.breathDirection = -1;
-    } else if (ledController.breathState <= 0) {
-      ledController.breathState = 0;
-      ledController.breathDirection = 1;
-    }
-
-    // 使用配置的RGB颜色，根据呼吸状态调整亮度
-    uint8_t brightness = ledController.breathState;
-    uint8_t r = (COLOR_BREATHE_GREEN_R * brightness) / 255;
-    uint8_t g = (COLOR_BREATHE_GREEN_G * brightness) / 255;
-    uint8_t b = (COLOR_BREATHE_GREEN_B * brightness) / 255;
-
-    fill_solid(leds, NUM_LEDS, CRGB(r, g, b));
-    FastLED.show();
-  }
+const Effect& currentEffect() {
+  return ledController.remote ? remoteEffect : ledModeEffect(ledController.mode);
 }
 
-void processLEDFlashYellow() {
-  unsigned long currentTime = millis();
-  if (currentTime - ledController.lastUpdateTime >= BLINK_INTERVAL) {
-    ledController.lastUpdateTime = currentTime;
-
-    // 使用配置的RGB颜色
-    CRGB color = ledController.blinkState ?
-                 CRGB(COLOR_FLASH_YELLOW_R, COLOR_FLASH_YELLOW_G, COLOR_FLASH_YELLOW_B) :
-                 CRGB::Black;
+// ==================== 远程命令 ====================
+// MQTT 命令（见 mqtt_commands.h）在按钮逻辑之前按到达顺序应用。第一条灯效命令从当前画面接管：
+// 复制当前模式的灯效，之后的命令在它上面修改模式、颜色、周期或亮度
+static void restartRemoteEffect() {
+  ledController.modeStartMillis = halMillis();
+  renderScheduler.setPeriod(JOB_LED, ledFramePeriodMicros(remoteEffect));
+  renderScheduler.runNow(JOB_LED);
+}
 
-    fill_solid(leds, NUM_LEDS, color);
-    FastLED.show();
+static void releaseRemoteControl(const char* reason) {
+  ledController.remote = false;
+  ledController.mode = ruleMode;
+  ledController.modeStartMillis = halMillis();
+  renderScheduler.setPeriod(JOB_LED, ledFramePeriodMicros(currentEffect()));
+  renderScheduler.runNow(JOB_LED);
+  LOG_INFO(LOG_REMOTE_RELEASED, reason);
+}
 
-    ledController.blinkState = !ledController.blinkState;
+static void applyRemoteLED(const RemoteCommand& command) {
+  if (!ledController.remote) {
+    remoteEffect = ledModeEffect(ledController.mode);
+    remoteLevel = 255;
+    ruleMode = ledController.mode;
+    ledController.remote = true;
+    LOG_INFO(LOG_REMOTE_TAKEOVER);
+  }
+  bool restart = false;
+  if (command.fields & REMOTE_FIELD_MODE) {
+    ledController.mode = (LEDMode)command.mode;
+    remoteEffect = ledModeEffect(ledController.mode);
+    restart = true;
+  }
+  if (command.fields & REMOTE_FIELD_EFFECT) {
+    remoteEffect.kind = (EffectKind)command.effect;
+    remoteEffect.framePeriodMillis = EFFECT_FRAME_INTERVAL;
+    remoteEffect.levelFromButtons = false;
+    restart = true;
+  }
+  if (command.fields & REMOTE_FIELD_COLOR) {
+    remoteEffect.color = command.color;
+  }
+  if (command.fields & REMOTE_FIELD_COLOR2) {
+    remoteEffect.color2 = command.color2;
+  }
+  if (command.fields & REMOTE_FIELD_PERIOD) {
+    remoteEffect.periodMillis = command.periodMillis;
+  }
+  if (command.fields & REMOTE_FIELD_LEVEL) {
+    remoteLevel = command.level;
+  }
+  if (restart) {
+    restartRemoteEffect();
+  } else {
+    renderScheduler.runNow(JOB_LED);  // 颜色、亮度从下一帧起生效，动画相位不变
   }
 }
 
-void setLEDMode(LEDMode mode) {
-  if (ledController.mode != mode) {
-    ledController.mode = mode;
-    ledController.lastUpdateTime = millis();
-    ledController.breathState = 0;  // 重置呼吸状态
-    ledController.breathDirection = 1;
-    
-    if (mode == LED_OFF) {
-      turnOffLEDs();
+void handleRemoteCommands() {
+  RemoteCommand command;
+  while (takeRemoteCommand(command)) {
+    switch (command.op) {
+      case REMOTE_LED:
+        applyRemoteLED(command);
+        break;
+      case REMOTE_RESET:
+        if (ledController.remote) {
+          releaseRemoteControl("reset");
+        }
+        break;
+      case REMOTE_STATE:
+        publishStateSnapshot();  // 回复包含之前的命令
+        requestMQTTStateReply();
+        break;
     }
+    recordMetric(METRIC_COMMAND_APPLY, halMicros() - command.receivedMicros);
   }
 }
 
 // ==================== 按钮逻辑处理 ====================
-void handleButtonLogic() {
-  // 检查非P32按钮状态是否有变化，并对每个变化的按钮发送消息
-  for (int i = 0; i < 6; i++) { // 检查前6个按钮（非P32）
-    // 如果当前按钮状态与初始状态不同，则发送消息
-    if (buttonStates[i].current != systemStatus.initialButtonStates[i]) {
-      sendMQTTMessage(MQTT_TOPIC_FIRST_TRIGGERED, "");
-      Serial.printf("按钮P%d状态改变：发送 ball/firstTriggered 消息\n", BUTTON_PINS[i]);
-      
-      // 更新初始状态为当前状态，以便下一次状态变化时触发
-      systemStatus.initialButtonStates[i] = buttonStates[i].current;
+// 按下（低电平）的引脚列表；16 个两位数引脚也放得进 LOG_TEXT_CAPACITY
+void printButtonStatus() {
+  FixedTextWriter<LOG_TEXT_CAPACITY> pins;
+  for (uint8_t i = 0; i < BTN_COUNT; i++) {
+    if (buttonInput.pressed & BUTTON_MASK(i)) {
+      if (pins.length()) pins.put(' ');
+      pins.u32(BUTTON_PINS[i]);
     }
   }
+  LOG_INFO(LOG_BUTTON_STATUS, BTN_COUNT, logText(pins.length() ? pins.c_str() : "-"));
+}
 
-  // 打印所有引脚状态信息
-  static unsigned long lastPrintTime = 0;
-  unsigned long currentTime = millis();
-  if (currentTime - lastPrintTime >= 1000) { // 每秒打印一次
-    lastPrintTime = currentTime;
-    Serial.print("引脚状态: P13=");
-    Serial.print(buttonStates[BTN_P13].current == LOW ? "LOW" : "HIGH");
-    Serial.print(", P32=");
-    Serial.print(buttonStates[BTN_P32].current == LOW ? "LOW" : "HIGH");
-    Serial.print(", P12=");
-    Serial.print(buttonStates[BTN_P12].current == LOW ? "LOW" : "HIGH");
-    Serial.print(", P14=");
-    Serial.print(buttonStates[BTN_P14].current == LOW ? "LOW" : "HIGH");
-    Serial.print(", P25=");
-    Serial.print(buttonStates[BTN_P25].current == LOW ? "LOW" : "HIGH");
-    Serial.print(", P26=");
-    Serial.print(buttonStates[BTN_P26].current == LOW ? "LOW" : "HIGH");
-    Serial.print(", P27=");
-    Serial.println(buttonStates[BTN_P27].current == LOW ? "LOW" : "HIGH");
-  }
-  
-  // 1. 统计当前绿色灯效组按下的按键数量
-  int greenPressedCount = 0;
-  if (buttonStates[BTN_P12].current == LOW) greenPressedCount++;
-  if (buttonStates[BTN_P14].current == LOW) greenPressedCount++;
-  if (buttonStates[BTN_P25].current == LOW) greenPressedCount++;
-  if (buttonStates[BTN_P26].current == LOW) greenPressedCount++;
-  if (buttonStates[BTN_P27].current == LOW) greenPressedCount++;
-
-  // 2. 核心逻辑判断（严格执行优先级）
-
-  // --- 优先级 1: P13 黄色频闪 (最高优先级，错误/警告) ---
-  if (buttonStates[BTN_P13].current == LOW) {
-    setLEDMode(LED_FLASH_YELLOW);
-    systemStatus.previousAllPinsTriggered = false;
-    systemStatus.previousP32Triggered = false;
+// 规则见 button_rules.cpp 的 DEFAULT_RULES / data/rules.json：一次查表得到 LED 模式和亮度，
+// 切换到新规则时发布该规则的动作，单个按钮的按下/松开按边沿动作表发布
+void handleButtonLogic() {
+  takePendingRules();
+  const RuleSet& rules = activeRules();
+  uint32_t pressed = buttonInput.pressed & ALL_BUTTONS_MASK;
+
+  uint32_t changed = pressed ^ systemStatus.evaluatedPressed;
+  if (ledController.remote) {
+    if (!changed) {
+      return;  // 远程设置的灯效保持到按钮状态变化
+    }
+    releaseRemoteControl("按钮");
   }
-  
-  // --- 优先级 2: P32 红色呼吸 (它必须排在绿色之前) ---
-  // 逻辑：如果 P32 被按下，直接强制进入红色模式，忽略任何绿色按钮的状态
-  else if (buttonStates[BTN_P32].current == LOW) {
-    setLEDMode(LED_BREATHE_RED);
-    
-    // 发送 MQTT 重置消息（仅在按下瞬间发送一次）
-    if (!systemStatus.previousP32Triggered) {
-      sendMQTTMessage(MQTT_TOPIC_RESET, "");
-      Serial.println("P32 触发：强制红色呼吸并发送 RESET");
-      
-      // 重置首次触发标志，允许下次非P32按钮触发时发送ball/firstTriggered消息
-      systemStatus.firstTriggeredSent = false;
-      Serial.println("P32 触发：重置首次触发标志");
-      
-      // 记录当前非P32按钮的初始状态
-      for (int i = 0; i < 6; i++) { // 记录前6个按钮（非P32）的初始状态
-        systemStatus.initialButtonStates[i] = buttonStates[i].current;
+  for (uint8_t i = 0; changed; i++, changed >>= 1) {
+    if (changed & 1) {
+      const EdgeAction& edge = rules.edges[i];
+      uint8_t action = (pressed & BUTTON_MASK(i)) ? edge.onPress : edge.onRelease;
+      if (action != RULE_NO_ACTION) {
+        sendMQTTEvent(action);
+        LOG_INFO(LOG_BUTTON_EDGE, BUTTON_PINS[i], mqttEventTopic(action));
       }
-      Serial.println("P32 触发：记录当前按钮状态为初始状态");
-      
-      systemStatus.previousP32Triggered = true;
     }
-    systemStatus.previousAllPinsTriggered = false;
   }
-  
-  // --- 优先级 3: 绿色组触发 (只有在 P13 和 P32 都没按时才生效) ---
-  else if (greenPressedCount > 0) {
-    // 设置亮度：按下的个数 * 51
-    ledController.greenBreathBrightness = greenPressedCount * 51;
-    setLEDMode(LED_BREATHE_GREEN);
-    
-    // 检查是否全亮
-    bool allGreen = (greenPressedCount == 5);
-    if (allGreen && !systemStatus.previousAllPinsTriggered) {
-      sendMQTTMessage(MQTT_TOPIC_SUB, ""); 
-      Serial.println("全部绿色引脚触发：发送 TRIGGERED");
-    }
-    systemStatus.previousAllPinsTriggered = allGreen;
-    systemStatus.previousP32Triggered = false; 
+  systemStatus.evaluatedPressed = pressed;
+
+  const RuleOutcome outcome = ruleOutcome(rules, pressed);
+  if (outcome.rule == RULE_NONE) {
+    systemStatus.activeRule = RULE_NONE;
+    return;
   }
-  
-  // --- 优先级 4: 默认状态（无任何引脚触发）- 红色呼吸 ---
-  else {
-    setLEDMode(LED_BREATHE_RED);
-    ledController.greenBreathBrightness = 0;
-    systemStatus.previousAllPinsTriggered = false;
-    systemStatus.previousP32Triggered = false;
+  if (!outcome.keepBrightness) {
+    ledController.greenBreathBrightness = outcome.brightness;
+  }
+  setLEDMode((LEDMode)outcome.ledMode);
+
+  if (outcome.rule != systemStatus.activeRule) {
+    systemStatus.activeRule = outcome.rule;
+    const ButtonRule& rule = rules.rules[outcome.rule];
+    if (rule.action != RULE_NO_ACTION) {
+      sendMQTTEvent(rule.action);
+      LOG_INFO(LOG_RULE_FIRED, logText(rule.name), mqttEventTopic(rule.action));
+    }
   }
 }
 
-
+// ==================== WiFi管理 ====================
+// 状态机在 wifi_manager.cpp，这里负责调度：按状态机要求的时间再次运行，连上后立即尝试 MQTT
+void updateWiFi() {
+  bool wasConnected = systemStatus.wifiConnected;
+  uint32_t waitMicros = updateWiFiManager();
+  networkScheduler.scheduleAt(JOB_WIFI, halMicros() + waitMicros);
+
+  systemStatus.wifiConnected = wifiManagerConnected();
+  if (systemStatus.wifiConnected && !wasConnected) {
+    markBootMilestone(bootTimings.wifiConnectedMicros);
+    networkScheduler.runNow(JOB_MQTT_CONNECT);
+  }
+}
 
 // ==================== MQTT连接管理 ====================
-void updateMQTTConnection() {
-  if (!mqttClient.connected()) {
-    systemStatus.mqttConnected = false;
-    connectToMQTT();
-  } else {
-    systemStatus.mqttConnected = true;
+// 客户端作业：处理收发，把渲染任务投递的事件移入待发缓冲区（见 mqtt_outbox.h），
+// 连接时按顺序每次最多发布 MQTT_OUTBOX_BATCH 条；有事件投递时被立即唤醒
+void updateMQTTClient() {
+  OutboundMessage message;
+  while (takeMQTTMessage(message)) {
+    mqttOutboxAdd(message);
+  }
+
+  // 后台连接进行中不能碰客户端
+  if (!mqttManagerConnected() || !halMQTTConnected()) {
+    return;
+  }
+  halMQTTLoop();
+  applyMQTTRules();
+  publishMQTTCommandReplies();
+
+  OutboxEntry entry;
+  for (uint8_t i = 0; i < MQTT_OUTBOX_BATCH && mqttOutboxPeek(entry); i++) {
+    uint32_t now = halMillis();
+    uint32_t startMicros = halMicros();
+    FixedTextWriter<MQTT_EVENT_PAYLOAD_CAPACITY> payload;
+    encodeOutboxPayload(payload, entry, now);
+
+    uint32_t span = traceBegin();
+    if (!halMQTTPublish(mqttEventTopic(entry.event), payload.c_str())) {
+      break;  // 留在缓冲区，掉线由连接作业发现后重连再重放
+    }
+    traceEnd(METRIC_PUBLISH_CALL, span);
+
+    // 复位前的事件时间戳属于上一次启动，不计入延迟
+    if (mqttOutboxCurrentBoot(entry)) {
+      uint32_t doneMicros = halMicros();
+      recordMetric(METRIC_OUTBOX_WAIT, startMicros - entry.postMicros);
+      recordMetric(METRIC_EDGE_TO_PUBLISH, doneMicros - entry.edgeMicros);
+      traceMQTTPublished(entry.seq, doneMicros);
+    }
+    mqttOutboxRelease(now);
   }
-  mqttClient.loop();
 }
 
-bool connectToMQTT() {
-  static unsigned long lastAttempt = 0;
-  unsigned long currentTime = millis();
-  
-  if (currentTime - lastAttempt < 2000) {
-    return false; // 避免频繁重连
+// 连接作业：状态机在 mqtt_manager.cpp，这里按它要求的时间再次运行；
+// 后台连接结束时 runNetworkTask() 收到事件会立即运行本作业
+void updateMQTTConnection() {
+  uint32_t waitMicros = updateMQTTManager(systemStatus.wifiConnected);
+  networkScheduler.scheduleAt(JOB_MQTT_CONNECT, halMicros() + waitMicros);
+
+  bool wasConnected = systemStatus.mqttConnected;
+  systemStatus.mqttConnected = mqttManagerConnected();
+  if (systemStatus.mqttConnected && !wasConnected) {
+    networkScheduler.runNow(JOB_MQTT);  // 立即重放断线期间积累的事件
   }
-  
-  lastAttempt = currentTime;
-  Serial.print("尝试连接MQTT服务器...");
-  
-  if (mqttClient.connect(MQTT_USER)) {
-    Serial.println("连接成功");
-    mqttClient.subscribe(MQTT_TOPIC_SUB);
-    mqttClient.subscribe(MQTT_TOPIC_FIRST_TRIGGERED);  // 添加对ball/firstTriggered的订阅
-    systemStatus.mqttConnected = true;
-    return true;
-  } else {
-    Serial.print("连接失败，状态码: ");
-    Serial.println(mqttClient.state());
-    systemStatus.mqttConnected = false;
-    return false;
+  if (systemStatus.mqttConnected && bootTimings.mqttReadyMicros == BOOT_MILESTONE_PENDING) {
+    markBootMilestone(bootTimings.mqttReadyMicros);
+    printBootTimings();
   }
 }
 
-void sendMQTTMessage(const char* topic, const char* message) {
-  if (systemStatus.mqttConnected) {
-    mqttClient.publish(topic, message);
+// 在渲染任务中调用，只投递到网络任务；未连接时由待发缓冲区保留
+void sendMQTTEvent(uint8_t event) {
+  postMQTTEvent(event, buttonInput.edgeMicros);
+}
+
+// 指标作业：每 METRICS_PUBLISH_INTERVAL 把各阶段延迟摘要发布到 <MQTT_TOPIC_METRICS>/<指标名>，
+// 低功耗统计发布到 <MQTT_TOPIC_METRICS>/power
+void publishMetrics() {
+  if (!mqttManagerConnected() || !halMQTTConnected()) {
+    return;
   }
+  for (uint8_t m = 0; m < NUM_METRICS; m++) {
+    FixedTextWriter<48> topic;
+    topic.raw(MQTT_TOPIC_METRICS).put('/').raw(metricName(m));
+    FixedTextWriter<METRIC_SUMMARY_CAPACITY> summary;
+    encodeMetricSummary(summary, m);
+    halMQTTPublish(topic.c_str(), summary.c_str());
+  }
+  FixedTextWriter<48> topic;
+  topic.raw(MQTT_TOPIC_METRICS).raw("/power");
+  FixedTextWriter<POWER_SUMMARY_CAPACITY> summary;
+  encodePowerSummary(summary);
+  halMQTTPublish(topic.c_str(), summary.c_str());
 }
 
-void onMQTTMessage(char* topic, byte* payload, unsigned int length) {
-  Serial.print("收到MQTT消息 [");
-  Serial.print(topic);
-  Serial.print("]: ");
-  
-  for (unsigned int i = 0; i < length; i++) {
-    Serial.print((char)payload[i]);
+// ==================== 日志 ====================
+// 输出一批日志（见 log.h）；还有剩余或串口发送缓冲区已满时按 LOG_BACKLOG_INTERVAL 再次运行
+void updateLog() {
+  if (drainLog()) {
+    networkScheduler.scheduleAt(JOB_LOG, halMicros() + LOG_BACKLOG_INTERVAL * 1000UL);
   }
-  Serial.println();
 }
 
 // ==================== WebSocket管理 ====================
+// 二进制模式下快照变化或收到关键帧请求时由 runNetworkTask() 立即触发，协议见 ws_protocol.h
+static uint32_t sentSnapshotVersion = 0;
+static uint32_t frameSequence = 0;
+static unsigned long lastKeyframeTime = 0;
+
+bool webSocketUpdatePending() {
+#if WEBSOCKET_PROTOCOL == WS_PROTOCOL_JSON
+  return false;
+#else
+  return stateSnapshotVersion() != sentSnapshotVersion || stateKeyframeRequested();
+#endif
+}
+
 void updateWebSocket() {
-  static unsigned long lastUpdate = 0;
-  unsigned long currentTime = millis();
-  
-  if (currentTime - lastUpdate >= WEBSOCKET_UPDATE_INTERVAL) {
-    lastUpdate = currentTime;
-    sendButtonStates();
-  }
-  
-  webSocket.cleanupClients();
+  sendButtonStates();
+  halWebSocketCleanup();
 }
 
-void onWebSocketEvent(AsyncWebSocket *server, AsyncWebSocketClient *client, 
-                      AwsEventType type, void *arg, uint8_t *data, size_t len) {
-  switch (type) {
-    case WS_EVT_CONNECT:
-      Serial.printf("WebSocket客户端 #%u 连接\n", client->id());
-      break;
-    case WS_EVT_DISCONNECT:
-      Serial.printf("WebSocket客户端 #%u 断开连接\n", client->id());
-      break;
-    case WS_EVT_DATA:
-      // 处理接收到的WebSocket消息
-      break;
-    case WS_EVT_PONG:
-    case WS_EVT_ERROR:
-      break;
+// 连接事件和客户端积压（见 ws_fanout.h）；有积压时按 WS_BACKLOG_INTERVAL 重试，传输层腾出空位不会通知
+void updateWebSocketClients() {
+  if (pumpWebSocket()) {
+    networkScheduler.scheduleAt(JOB_WS_CLIENTS, halMicros() + WS_BACKLOG_INTERVAL * 1000UL);
   }
 }
 
 void sendButtonStates() {
-  String json = "{";
-  for (uint8_t i = 0; i < 7; i++) {
-    json += "\"p" + String(BUTTON_PINS[i]) + "\":" + 
-            String(buttonStates[i].current == LOW ? "true" : "false");
-    if (i < 6) json += ",";
-  }
-  json += "}";
-  webSocket.textAll(json);
-}
-
-// ==================== OTA升级处理 ====================
-void handleOTAUpload(AsyncWebServerRequest *request, String filename, 
-                     size_t index, uint8_t *data, size_t len, bool final) {
-  if (!index) {
-    Serial.printf("开始OTA更新: %s\n", filename.c_str());
-    if (!Update.begin(request->contentLength())) {
-      Update.printError(Serial);
-    }
+  BallSnapshot state;
+  uint32_t version = readStateSnapshot(state);
+
+#if WEBSOCKET_PROTOCOL == WS_PROTOCOL_JSON
+  (void)version;
+  FixedTextWriter<STATE_JSON_CAPACITY> json;
+  encodeStateJSON(json, state);
+  wsBroadcast((const uint8_t*)json.c_str(), json.length(), false, WS_CLASS_STATE);
+#else
+  unsigned long currentTime = halMillis();
+  bool keyframe = takeStateKeyframeRequest() ||
+                  currentTime - lastKeyframeTime >= WEBSOCKET_KEYFRAME_INTERVAL;
+  if (!keyframe && version == sentSnapshotVersion) {
+    return;
   }
-  
-  if (Update.write(data, len) != len) {
-    Update.printError(Serial);
+
+  uint8_t frame[WS_STATE_FRAME_SIZE];
+  size_t length = encodeStateFrame(frame, state, ++frameSequence,
+                                   keyframe ? WS_FRAME_KEYFRAME : WS_FRAME_DELTA);
+  wsBroadcast(frame, length, true, WS_CLASS_STATE);
+  sentSnapshotVersion = version;
+  if (keyframe) {
+    lastKeyframeTime = currentTime;
   }
-  
-  if (final) {
-    if (Update.end(true)) {
-      Serial.printf("OTA更新成功: %u bytes\n", index + len);
-    } else {
-      Update.printError(Serial);
-    }
+#endif
+}
+
+// ==================== 启动耗时 ====================
+void markBootMilestone(uint32_t& milestone) {
+  if (milestone == BOOT_MILESTONE_PENDING) {
+    milestone = halMicros();
   }
 }
 
-// ==================== HTML内容生成 ====================
-String getHTMLContent() {
-  String html = "<!DOCTYPE html><html><head>";
-  html += "<title>ESP32 Ball 控制面板</title>";
-  html += "<meta name=\"viewport\" content=\"width=device-width, initial-scale=1\">";
-  html += "<style>";
-  html += "body{font-family:Arial,sans-serif;margin:20px;background:#f0f0f0}";
-  html += ".container{max-width:800px;margin:0 auto;background:white;padding:20px;border-radius:10px;box-shadow:0 2px 10px rgba(0,0,0,0.1)}";
-  html += "h1{text-align:center;color:#333}";
-  html += ".section{margin:20px 0;padding:15px;border:1px solid #ddd;border-radius:5px}";
-  html += ".button-grid{display:grid;grid-template-columns:repeat(auto-fit,minmax(150px,1fr));gap:10px}";
-  html += ".button-status{padding:10px;text-align:center;border-radius:5px;font-weight:bold;transition:all 0.3s}";
-  html += ".button-on{background:#4CAF50;color:white;transform:scale(1.05)}";
-  html += ".button-off{background:#f44336;color:white}";
-  html += ".ota-section{text-align:center}";
-  html += ".upload-btn{background:#2196F3;color:white;padding:10px 20px;border:none;border-radius:5px;cursor:pointer;margin:10px 0;transition:background 0.3s}";
-  html += ".upload-btn:hover{background:#1976D2}";
-  html += ".status{margin:10px 0;padding:10px;border-radius:5px}";
-  html += ".success{background:#dff0d8;color:#3c763d}";
-  html += ".error{background:#f2dede;color:#a94442}";
-  html += ".info{background:#d9edf7;color:#31708f}";
-  html += "</style></head><body>";
-  html += "<div class=\"container\">";
-  html += "<h1>🎮 ESP32 Ball 控制面板</h1>";
-  
-  // 系统状态
-  html += "<div class=\"section\">";
-  html += "<h2>📊 系统状态</h2>";
-  html += "<div id=\"system-status\" class=\"status info\">正在加载...</div>";
-  html += "</div>";
-  
-  // 按钮状态
-  html += "<div class=\"section\">";
-  html += "<h2>🔘 按钮状态监控</h2>";
-  html += "<div class=\"button-grid\">";
-  for (uint8_t i = 0; i < 7; i++) {
-    html += "<div id=\"p" + String(BUTTON_PINS[i]) + "\" class=\"button-status button-off\">";
-    html += "P" + String(BUTTON_PINS[i]) + ": 关闭</div>";
-  }
-  html += "</div></div>";
-  
-  // OTA升级
-  html += "<div class=\"section ota-section\">";
-  html += "<h2>🔄 OTA 固件升级</h2>";
-  html += "<input type=\"file\" id=\"firmware\" accept=\".bin\" style=\"margin:10px 0\">";
-  html += "<br><button class=\"upload-btn\" onclick=\"uploadFirmware()\">📤 上传固件</button>";
-  html += "<div id=\"status\"></div>";
-  html += "</div></div>";
-  
-  // JavaScript
-  html += "<script>";
-  html += "const ws=new WebSocket('ws://'+window.location.hostname+'/ws');";
-  html += "ws.onmessage=function(e){";
-  html += "const data=JSON.parse(e.data);";
-  for (uint8_t i = 0; i < 7; i++) {
-    html += "updateButton('p" + String(BUTTON_PINS[i]) + "',data.p" + String(BUTTON_PINS[i]) + ");";
-  }
-  html += "};";
-  html += "function updateButton(id,state){";
-  html += "const el=document.getElementById(id);";
-  html += "if(state){el.className='button-status button-on';el.textContent=id.toUpperCase()+': 开启';}";
-  html += "else{el.className='button-status button-off';el.textContent=id.toUpperCase()+': 关闭';}";
-  html += "}";
-  html += "function uploadFirmware(){";
-  html += "const file=document.getElementById('firmware').files[0];";
-  html += "if(!file){showStatus('请选择固件文件','error');return;}";
-  html += "const fd=new FormData();fd.append('firmware',file);";
-  html += "showStatus('正在上传固件...','info');";
-  html += "fetch('/update',{method:'POST',body:fd})";
-  html += ".then(r=>r.text()).then(d=>{showStatus(d,'success');if(d.includes('成功'))setTimeout(()=>location.reload(),3000);})";
-  html += ".catch(e=>showStatus('上传失败: '+e,'error'));";
-  html += "}";
-  html += "function showStatus(msg,type){";
-  html += "const el=document.getElementById('status');el.textContent=msg;el.className='status '+type;";
-  html += "}";
-  html += "function updateSystemStatus(){";
-  html += "fetch('/api/buttons').then(r=>r.json()).then(d=>{";
-  html += "const online=Object.values(d).some(v=>v===true||v===false);";
-  html += "const status=document.getElementById('system-status');";
-  html += "status.textContent=online?'系统运行正常':'连接异常';";
-  html += "status.className='status '+(online?'success':'error');";
-  html += "}).catch(()=>{document.getElementById('system-status').textContent='连接失败';document.getElementById('system-status').className='status error';});";
-  html += "}";
-  html += "setInterval(updateSystemStatus,5000);updateSystemStatus();";
-  html += "</script></body></html>";
-  
-  return html;
-}
\ No newline at end of file
+void printBootTimings() {
+  LOG_INFO(LOG_BOOT_TIMINGS, bootTimings.firstInputMicros, bootTimings.firstFrameMicros,
+           bootTimings.wifiConnectedMicros, bootTimings.mqttReadyMicros);
+}
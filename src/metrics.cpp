@@ -0,0 +1,210 @@
+#include <string.h>
+#include "metrics.h"
+
+struct MetricInfo {
+  const char* name;
+  const char* help;
+  bool nanos;
+};
+
+static constexpr MetricInfo METRICS[NUM_METRICS] = {
+  {"edge_to_debounce", "Button edge interrupt to debounced state change", false},
+  {"button_logic", "handleButtonLogic() execution time", true},
+  {"outbox_wait", "MQTT event posted to publish start, including offline backlog", false},
+  {"publish_call", "MQTT publish call execution time", true},
+  {"edge_to_publish", "Button edge interrupt to MQTT publish completed", false},
+  {"broker_echo", "MQTT publish to echo received from the broker", false},
+  {"wake_to_frame", "Light-sleep wakeup to the first LED frame rendered after it", false},
+  {"command_apply", "MQTT command received to applied by the render task", false},
+};
+
+// METRICS_TEXT_CAPACITY 按 NUM_METRICS 个最长的指标推出：每个指标都要登记（漏掉的项名字为空），名字和说明不超过上限
+static constexpr bool metricTextFits() {
+  for (const MetricInfo& info : METRICS) {
+    if (!info.name || !info.help) {
+      return false;
+    }
+    size_t name = 0, help = 0;
+    while (info.name[name]) name++;
+    while (info.help[help]) help++;
+    if (name > METRIC_NAME_MAX || help > METRIC_HELP_MAX) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static_assert(metricTextFits(), "指标名字或说明超出 METRIC_NAME_MAX / METRIC_HELP_MAX，或 METRICS 缺项");
+static_assert(METRICS_TEXT_CAPACITY >= NUM_METRICS * METRIC_TEXT_MAX + METRICS_TRAILER_MAX + 1,
+              "/api/metrics 容量必须覆盖全部 NUM_METRICS 个指标的最坏情况");
+
+static Histogram histograms[NUM_METRICS];
+static uint32_t overheadNanos = 0;
+
+// 等待回送的发布：只需覆盖几个 MQTT 循环周期内的消息
+#define ECHO_SLOTS 8
+
+struct PendingEcho {
+  uint32_t seq;
+  uint32_t publishMicros;
+  bool pending;
+};
+
+static PendingEcho echoes[ECHO_SLOTS];
+static uint8_t nextEcho = 0;
+
+static void addSample(Histogram& histogram, uint32_t value) {
+  uint8_t bucket = value ? 32 - __builtin_clz(value) : 0;
+  if (bucket >= METRIC_BUCKETS) {
+    bucket = METRIC_BUCKETS - 1;
+  }
+  histogram.buckets[bucket]++;
+  histogram.count++;
+  histogram.sum += value;
+  if (value > histogram.max) {
+    histogram.max = value;
+  }
+}
+
+#if METRICS_ENABLED
+void recordMetric(uint8_t metric, uint32_t value) {
+  if (metric < NUM_METRICS) {
+    addSample(histograms[metric], value);
+  }
+}
+#endif
+
+void initializeMetrics() {
+  memset(histograms, 0, sizeof(histograms));
+  memset(echoes, 0, sizeof(echoes));
+
+  // 测量空追踪点（周期计数器读两次 + 写入一个直方图）的开销
+  static Histogram scratch;
+  const uint16_t rounds = 256;
+  uint32_t start = halCycleCount();
+  for (uint16_t i = 0; i < rounds; i++) {
+    uint32_t spanStart = halCycleCount();
+    addSample(scratch, halCyclesToNanos(halCycleCount() - spanStart));
+  }
+  overheadNanos = halCyclesToNanos(halCycleCount() - start) / rounds;
+}
+
+uint32_t traceOverheadNanos() {
+  return overheadNanos;
+}
+
+const Histogram& metricHistogram(uint8_t metric) {
+  return histograms[metric];
+}
+
+const char* metricName(uint8_t metric) {
+  return METRICS[metric].name;
+}
+
+bool metricInNanos(uint8_t metric) {
+  return METRICS[metric].nanos;
+}
+
+static uint64_t bucketUpperBound(uint8_t bucket) {
+  return bucket == 0 ? 0 : (1ULL << bucket) - 1;
+}
+
+uint32_t metricQuantile(const Histogram& histogram, uint32_t perMille) {
+  if (histogram.count == 0) {
+    return 0;
+  }
+  uint64_t rank = ((uint64_t)histogram.count * perMille + 999) / 1000;
+  uint32_t seen = 0;
+  for (uint8_t b = 0; b < METRIC_BUCKETS - 1; b++) {
+    seen += histogram.buckets[b];
+    if (seen >= rank) {
+      uint64_t bound = bucketUpperBound(b);
+      return bound < histogram.max ? (uint32_t)bound : histogram.max;
+    }
+  }
+  return histogram.max;
+}
+
+// ==================== 导出 ====================
+static void writeSeconds(TextWriter& out, uint64_t value, bool nanos) {
+  out.fixed(value, nanos ? 9 : 6);
+}
+
+static void writeMetricHeader(TextWriter& out, const char* name, const char* suffix) {
+  out.raw("ball_").raw(name).raw(suffix);
+}
+
+static const char TRACE_OVERHEAD_TEXT[] =
+  "# HELP ball_trace_overhead_seconds Cost of one trace span, measured at boot\n"
+  "# TYPE ball_trace_overhead_seconds gauge\n"
+  "ball_trace_overhead_seconds ";
+
+static_assert(sizeof(TRACE_OVERHEAD_TEXT) - 1 + METRIC_SECONDS_DIGITS + 1 <= METRICS_TRAILER_MAX,
+              "METRICS_TRAILER_MAX 不足");
+
+void encodeMetricsText(TextWriter& out) {
+  for (uint8_t m = 0; m < NUM_METRICS; m++) {
+    const MetricInfo& info = METRICS[m];
+    const Histogram& h = histograms[m];
+
+    out.raw("# HELP ");
+    writeMetricHeader(out, info.name, "_seconds ");
+    out.raw(info.help).put('\n').raw("# TYPE ");
+    writeMetricHeader(out, info.name, "_seconds histogram\n");
+
+    uint32_t cumulative = 0;
+    for (uint8_t b = 0; b < METRIC_BUCKETS - 1; b++) {
+      cumulative += h.buckets[b];
+      writeMetricHeader(out, info.name, "_seconds_bucket{le=\"");
+      writeSeconds(out, bucketUpperBound(b), info.nanos);
+      out.raw("\"} ").u32(cumulative).put('\n');
+    }
+    writeMetricHeader(out, info.name, "_seconds_bucket{le=\"+Inf\"} ");
+    out.u32(h.count).put('\n');
+    writeMetricHeader(out, info.name, "_seconds_sum ");
+    writeSeconds(out, h.sum, info.nanos);
+    out.put('\n');
+    writeMetricHeader(out, info.name, "_seconds_count ");
+    out.u32(h.count).put('\n');
+  }
+
+  out.raw(TRACE_OVERHEAD_TEXT);
+  writeSeconds(out, overheadNanos, true);
+  out.put('\n');
+}
+
+void encodeMetricSummary(TextWriter& out, uint8_t metric) {
+  const Histogram& h = histograms[metric];
+  out.beginObject()
+     .key("unit").raw(METRICS[metric].nanos ? "\"ns\"" : "\"us\"")
+     .field("count", h.count)
+     .field("p50", metricQuantile(h, 500))
+     .field("p99", metricQuantile(h, 990))
+     .field("max", h.max)
+     .endObject();
+}
+
+// ==================== 服务器回送 ====================
+void traceMQTTPublished(uint32_t seq, uint32_t publishMicros) {
+  echoes[nextEcho] = PendingEcho{seq, publishMicros, true};
+  nextEcho = (nextEcho + 1) % ECHO_SLOTS;
+}
+
+void traceMQTTReceived(const uint8_t* payload, unsigned int length) {
+  static const char key[] = "{\"seq\":";
+  const unsigned int keyLength = sizeof(key) - 1;
+  if (length <= keyLength || memcmp(payload, key, keyLength) != 0) {
+    return;
+  }
+  uint32_t seq = 0;
+  for (unsigned int i = keyLength; i < length && payload[i] >= '0' && payload[i] <= '9'; i++) {
+    seq = seq * 10 + (payload[i] - '0');
+  }
+  for (PendingEcho& echo : echoes) {
+    if (echo.pending && echo.seq == seq) {
+      echo.pending = false;
+      recordMetric(METRIC_BROKER_ECHO, halMicros() - echo.publishMicros);
+      return;
+    }
+  }
+}
@@ -0,0 +1,381 @@
+#include <string.h>
+#include <atomic>
+#include "mqtt_commands.h"
+#include "topic_trie.h"
+#include "json_reader.h"
+#include "spsc_queue.h"
+#include "effects.h"
+#include "button_rules.h"
+#include "input_trace.h"
+#include "ws_protocol.h"
+#include "metrics.h"
+#include "tasks.h"
+#include "log.h"
+
+#define MQTT_COMMAND_ROOT "ball"
+#define MQTT_COMMAND_GROUP "all"
+#define MQTT_COMMAND_TRIE_NODES 40
+#define MQTT_COMMAND_TRIE_TEXT 256
+#define MQTT_STATE_REPLY_CAPACITY (STATE_JSON_CAPACITY + 96)
+
+// ==================== 路由表 ====================
+enum MqttRouteId : uint8_t {
+  ROUTE_MODE,
+  ROUTE_COLOR,
+  ROUTE_BRIGHTNESS,
+  ROUTE_EFFECT,
+  ROUTE_RESET,
+  ROUTE_STATE,
+  ROUTE_UNKNOWN_COMMAND,
+  ROUTE_RULES,
+  ROUTE_TRACE,
+  ROUTE_ECHO_TRIGGERED,
+  ROUTE_ECHO_FIRST_TRIGGERED,
+  NUM_MQTT_ROUTES
+};
+
+typedef void (*RouteHandler)(uint8_t route, const char* topic, const uint8_t* payload, size_t length);
+
+struct MqttRoute {
+  const char* const* topic;  // device 为 false 时的完整主题（config.cpp 中的全局常量）
+  const char* filter;        // device 为 true 时 <prefix>/ 之后的部分
+  bool device;               // 同时挂在 ball/<MQTT_DEVICE_ID> 和 ball/all 下
+  uint8_t op;                // RemoteCommandOp
+  uint8_t required;          // 载荷必须给出的 REMOTE_FIELD_*
+  RouteHandler handle;
+};
+
+static void handleCommand(uint8_t route, const char* topic, const uint8_t* payload, size_t length);
+static void handleUnknownCommand(uint8_t route, const char* topic, const uint8_t* payload, size_t length);
+static void handleRules(uint8_t route, const char* topic, const uint8_t* payload, size_t length);
+static void handleTrace(uint8_t route, const char* topic, const uint8_t* payload, size_t length);
+static void handleEcho(uint8_t route, const char* topic, const uint8_t* payload, size_t length);
+
+// 下标为 MqttRouteId；同一层字面主题优先于 cmd/#
+static const MqttRoute ROUTES[NUM_MQTT_ROUTES] = {
+  // topic                        filter            device  op            required             handle
+  {nullptr,                       "cmd/mode",       true,   REMOTE_LED,   REMOTE_FIELD_MODE,   handleCommand},
+  {nullptr,                       "cmd/color",      true,   REMOTE_LED,   REMOTE_FIELD_COLOR,  handleCommand},
+  {nullptr,                       "cmd/brightness", true,   REMOTE_LED,   REMOTE_FIELD_LEVEL,  handleCommand},
+  {nullptr,                       "cmd/effect",     true,   REMOTE_LED,   REMOTE_FIELD_EFFECT, handleCommand},
+  {nullptr,                       "cmd/reset",      true,   REMOTE_RESET, 0,                   handleCommand},
+  {nullptr,                       "cmd/state",      true,   REMOTE_STATE, 0,                   handleCommand},
+  {nullptr,                       "cmd/#",          true,   0,            0,                   handleUnknownCommand},
+  {&MQTT_TOPIC_RULES,             nullptr,          false,  0,            0,                   handleRules},
+  {&MQTT_TOPIC_TRACE,             nullptr,          false,  0,            0,                   handleTrace},
+  {&MQTT_TOPIC_SUB,               nullptr,          false,  0,            0,                   handleEcho},
+  {&MQTT_TOPIC_FIRST_TRIGGERED,   nullptr,          false,  0,            0,                   handleEcho},
+};
+
+static TopicTrie<MQTT_COMMAND_TRIE_NODES, MQTT_COMMAND_TRIE_TEXT> trie;
+static char devicePrefix[MQTT_COMMAND_TOPIC_CAPACITY];
+static char deviceFilter[MQTT_COMMAND_TOPIC_CAPACITY];
+static char groupFilter[MQTT_COMMAND_TOPIC_CAPACITY];
+static char replyTopic[MQTT_COMMAND_TOPIC_CAPACITY];
+static const char* subscriptions[] = {nullptr, nullptr, nullptr, nullptr, deviceFilter, groupFilter};
+
+static SpscQueue<RemoteCommand, MQTT_COMMAND_QUEUE_SIZE> queue;
+static std::atomic<bool> replyRequested(false);
+// ball/rules 的载荷在回调里复制到这里，文件读写留给 MQTT 客户端作业（都在网络任务，不需要同步）
+static char rulesText[RULES_JSON_CAPACITY];
+static size_t rulesLength;
+static bool rulesRequested;
+static MqttCommandStats stats;
+
+static void insertRoute(const char* prefix, const char* filter, uint8_t route) {
+  FixedTextWriter<MQTT_COMMAND_TOPIC_CAPACITY> text;
+  if (prefix) {
+    text.raw(prefix).put('/');
+  }
+  text.raw(filter);
+  if (text.overflowed() || !trie.insert(text.c_str(), route)) {
+    LOG_ERROR(LOG_COMMAND_ROUTE_FAILED, logText(text.c_str(), text.length()));
+  }
+}
+
+static void copyTopic(char* out, const char* a, const char* b) {
+  TextWriter text(out, MQTT_COMMAND_TOPIC_CAPACITY);
+  text.raw(a).raw(b);
+}
+
+void initializeMQTTCommands() {
+  copyTopic(devicePrefix, MQTT_COMMAND_ROOT "/", MQTT_DEVICE_ID);
+  copyTopic(deviceFilter, devicePrefix, "/cmd/#");
+  copyTopic(groupFilter, MQTT_COMMAND_ROOT "/" MQTT_COMMAND_GROUP, "/cmd/#");
+  copyTopic(replyTopic, devicePrefix, "/state");
+  subscriptions[0] = MQTT_TOPIC_SUB;
+  subscriptions[1] = MQTT_TOPIC_FIRST_TRIGGERED;
+  subscriptions[2] = MQTT_TOPIC_RULES;
+  subscriptions[3] = MQTT_TOPIC_TRACE;
+
+  trie.clear();
+  for (uint8_t r = 0; r < NUM_MQTT_ROUTES; r++) {
+    if (ROUTES[r].device) {
+      insertRoute(devicePrefix, ROUTES[r].filter, r);
+      insertRoute(MQTT_COMMAND_ROOT "/" MQTT_COMMAND_GROUP, ROUTES[r].filter, r);
+    } else {
+      insertRoute(nullptr, *ROUTES[r].topic, r);
+    }
+  }
+  RemoteCommand stale;
+  while (queue.pop(stale)) {
+  }
+  replyRequested.store(false);
+  rulesRequested = false;
+  stats = MqttCommandStats();
+}
+
+const char* const* mqttCommandSubscriptions(uint8_t& count) {
+  count = sizeof(subscriptions) / sizeof(subscriptions[0]);
+  return subscriptions;
+}
+
+const char* mqttCommandPrefix() {
+  return devicePrefix;
+}
+
+// ==================== 载荷解析 ====================
+// 都直接读接收缓冲区；只有名称字符串复制到栈上的小缓冲区里比较
+static bool readByte(JsonReader& reader, uint8_t& out) {
+  uint32_t value;
+  if (!reader.u32(value) || value > 255) return false;
+  out = (uint8_t)value;
+  return true;
+}
+
+static bool readColor(JsonReader& reader, CRGB& color) {
+  uint8_t c[3];
+  uint8_t n = 0;
+  reader.expect('[');
+  while (reader.more(']')) {
+    if (n == 3 || !readByte(reader, c[n])) return false;
+    n++;
+  }
+  if (!reader.ok() || n != 3) return false;
+  color = CRGB(c[0], c[1], c[2]);
+  return true;
+}
+
+static bool parseCommandJSON(const uint8_t* payload, size_t length, RemoteCommand& command) {
+  JsonReader reader((const char*)payload, length);
+  reader.expect('{');
+  while (reader.more('}')) {
+    char key[16];
+    if (!reader.key(key, sizeof(key))) return false;
+    bool ok;
+    if (!strcmp(key, "mode")) {
+      char name[24];
+      ok = reader.string(name, sizeof(name)) && findLEDMode(name, command.mode);
+      command.fields |= REMOTE_FIELD_MODE;
+    } else if (!strcmp(key, "effect")) {
+      char name[24];
+      ok = reader.string(name, sizeof(name)) && findEffectKind(name, command.effect);
+      command.fields |= REMOTE_FIELD_EFFECT;
+    } else if (!strcmp(key, "color")) {
+      ok = readColor(reader, command.color);
+      command.fields |= REMOTE_FIELD_COLOR;
+    } else if (!strcmp(key, "color2")) {
+      ok = readColor(reader, command.color2);
+      command.fields |= REMOTE_FIELD_COLOR2;
+    } else if (!strcmp(key, "level")) {
+      ok = readByte(reader, command.level);
+      command.fields |= REMOTE_FIELD_LEVEL;
+    } else if (!strcmp(key, "period")) {
+      uint32_t period = 0;
+      ok = reader.u32(period) && period >= MQTT_COMMAND_MIN_PERIOD && period <= MQTT_COMMAND_MAX_PERIOD;
+      command.periodMillis = (uint16_t)period;
+      command.fields |= REMOTE_FIELD_PERIOD;
+    } else {
+      ok = reader.skip();
+    }
+    if (!ok) return false;
+  }
+  return reader.ok();
+}
+
+// 定长二进制布局，第 0 字节为 MQTT_COMMAND_BINARY（见 mqtt_commands.h）
+static bool parseCommandBinary(uint8_t route, const uint8_t* p, size_t length, RemoteCommand& command) {
+  switch (route) {
+    case ROUTE_MODE:
+      if (length != 2 && length != 3) return false;
+      command.mode = p[1];
+      command.fields = REMOTE_FIELD_MODE;
+      if (length == 3) {
+        command.level = p[2];
+        command.fields |= REMOTE_FIELD_LEVEL;
+      }
+      return true;
+    case ROUTE_COLOR:
+      if (length != 4 && length != 7) return false;
+      command.color = CRGB(p[1], p[2], p[3]);
+      command.fields = REMOTE_FIELD_COLOR;
+      if (length == 7) {
+        command.color2 = CRGB(p[4], p[5], p[6]);
+        command.fields |= REMOTE_FIELD_COLOR2;
+      }
+      return true;
+    case ROUTE_BRIGHTNESS:
+      if (length != 2) return false;
+      command.level = p[1];
+      command.fields = REMOTE_FIELD_LEVEL;
+      return true;
+    case ROUTE_EFFECT: {
+      if (length != 10 || p[1] >= NUM_EFFECT_KINDS) return false;
+      uint16_t period = (uint16_t)(p[8] | (p[9] << 8));
+      if (period < MQTT_COMMAND_MIN_PERIOD || period > MQTT_COMMAND_MAX_PERIOD) return false;
+      command.effect = p[1];
+      command.color = CRGB(p[2], p[3], p[4]);
+      command.color2 = CRGB(p[5], p[6], p[7]);
+      command.periodMillis = period;
+      command.fields = REMOTE_FIELD_EFFECT | REMOTE_FIELD_COLOR | REMOTE_FIELD_COLOR2 | REMOTE_FIELD_PERIOD;
+      return true;
+    }
+    default:
+      return false;
+  }
+}
+
+uint8_t matchMQTTRoute(const char* topic, size_t length) {
+  uint8_t route = trie.match(topic, length);
+  return route == TOPIC_TRIE_NONE ? MQTT_ROUTE_NONE : route;
+}
+
+bool parseRemoteCommand(uint8_t route, const uint8_t* payload, size_t length, RemoteCommand& command) {
+  if (route >= NUM_MQTT_ROUTES || ROUTES[route].handle != handleCommand) {
+    return false;
+  }
+  const MqttRoute& spec = ROUTES[route];
+  command = RemoteCommand();
+  command.op = spec.op;
+  if (spec.op != REMOTE_LED) {
+    return true;  // reset / state 不看载荷
+  }
+  bool ok = length > 0 && payload[0] == MQTT_COMMAND_BINARY ? parseCommandBinary(route, payload, length, command)
+                                                            : parseCommandJSON(payload, length, command);
+  const uint8_t exclusive = REMOTE_FIELD_MODE | REMOTE_FIELD_EFFECT;
+  if (!ok || (command.fields & spec.required) != spec.required || (command.fields & exclusive) == exclusive) {
+    return false;
+  }
+  // 两种编码同一套模式校验：二进制给出的下标也可以是已登记的片段模式
+  return !(command.fields & REMOTE_FIELD_MODE) || validLEDMode(command.mode);
+}
+
+// ==================== 分发（网络任务，PubSubClient 回调） ====================
+static void handleCommand(uint8_t route, const char* topic, const uint8_t* payload, size_t length) {
+  RemoteCommand command;
+  if (!parseRemoteCommand(route, payload, length, command)) {
+    stats.invalid++;
+    LOG_WARN(LOG_COMMAND_INVALID, logText(topic));
+    return;
+  }
+  command.receivedMicros = halMicros();
+  if (!queue.push(command)) {
+    stats.dropped++;
+    LOG_WARN(LOG_COMMAND_DROPPED, logText(topic));
+    return;
+  }
+  halNotifyTask(TASK_RENDER);
+}
+
+static void handleUnknownCommand(uint8_t route, const char* topic, const uint8_t* payload, size_t length) {
+  (void)route;
+  (void)payload;
+  (void)length;
+  stats.invalid++;
+  LOG_WARN(LOG_COMMAND_INVALID, logText(topic));
+}
+
+// 空载荷重新读取规则文件，否则解析并写入文件；回调里只复制载荷，后到的消息覆盖尚未处理的
+static void handleRules(uint8_t route, const char* topic, const uint8_t* payload, size_t length) {
+  (void)route;
+  if (length > sizeof(rulesText)) {
+    stats.invalid++;
+    LOG_WARN(LOG_COMMAND_INVALID, logText(topic));
+    return;
+  }
+  memcpy(rulesText, payload, length);
+  rulesLength = length;
+  rulesRequested = true;
+}
+
+static void handleTrace(uint8_t route, const char* topic, const uint8_t* payload, size_t length) {
+  (void)route;
+  (void)topic;
+  requestInputTrace(length == 5 && !memcmp(payload, "start", 5));  // 其他载荷都视为停止
+}
+
+// 自己发布的事件经服务器回送
+static void handleEcho(uint8_t route, const char* topic, const uint8_t* payload, size_t length) {
+  (void)route;
+  traceMQTTReceived(payload, length);
+
+  // 主题和载荷都在客户端的接收缓冲区里，复制进日志记录（超长截断）
+  FixedTextWriter<LOG_TEXT_CAPACITY> text;
+  text.put('[').raw(topic).raw("]: ").raw((const char*)payload, length);
+  LOG_INFO(LOG_MQTT_MESSAGE, logText(text.c_str(), text.length()));
+}
+
+void dispatchMQTTMessage(char* topic, uint8_t* payload, unsigned int length) {
+  stats.received++;
+  uint8_t route = trie.match(topic, strlen(topic));
+  if (route == TOPIC_TRIE_NONE) {
+    stats.unmatched++;
+    return;
+  }
+  ROUTES[route].handle(route, topic, payload, length);
+}
+
+// ==================== 回调之后（MQTT 客户端作业） ====================
+void applyMQTTRules() {
+  if (!rulesRequested) {
+    return;
+  }
+  rulesRequested = false;
+  if (rulesLength == 0) {
+    reloadRulesFile();
+  } else {
+    submitRulesJSON(rulesText, rulesLength, true);
+  }
+}
+
+// ==================== 状态回复 ====================
+bool mqttCommandReplyPending() {
+  return replyRequested.load(std::memory_order_acquire);
+}
+
+void publishMQTTCommandReplies() {
+  if (!replyRequested.exchange(false, std::memory_order_acq_rel)) {
+    return;
+  }
+  BallSnapshot state;
+  readStateSnapshot(state);
+  FixedTextWriter<MQTT_STATE_REPLY_CAPACITY> reply;
+  reply.beginObject()
+       .key("mode").put('"').raw(ledModeName(state.ledMode)).put('"');
+  reply.field("brightness", state.greenBreathBrightness)
+       .flag("remote", state.remote)
+       .key("buttons");
+  encodeStateJSON(reply, state);
+  reply.endObject();
+  if (halMQTTPublish(replyTopic, reply.c_str())) {
+    stats.replies++;
+  }
+}
+
+// ==================== 渲染任务 ====================
+bool mqttCommandsPending() {
+  return queue.size() > 0;
+}
+
+bool takeRemoteCommand(RemoteCommand& command) {
+  return queue.pop(command);
+}
+
+void requestMQTTStateReply() {
+  replyRequested.store(true, std::memory_order_release);
+  halNotifyTask(TASK_NETWORK);
+}
+
+const MqttCommandStats& mqttCommandStats() {
+  return stats;
+}
@@ -0,0 +1,122 @@
+#include <string.h>
+#include "mqtt_manager.h"
+#include "hal.h"
+#include "config.h"
+#include "backoff.h"
+#include "log.h"
+
+static MQTTState state = MQTT_STATE_WAIT_WIFI;
+static const char* clientId = nullptr;
+static const char* const* topics = nullptr;
+static uint8_t topicCount = 0;
+static unsigned long attemptStart = 0;
+static unsigned long backoffUntil = 0;
+static uint8_t consecutiveFailures = 0;
+static MQTTStats stats;
+
+static void startConnect() {
+  attemptStart = halMillis();
+  state = MQTT_STATE_CONNECTING;
+  LOG_INFO(LOG_MQTT_CONNECTING);
+  halMQTTConnectAsync(clientId);
+}
+
+static void enterBackoff() {
+  uint32_t wait = jitteredBackoff(MQTT_BACKOFF_MIN, MQTT_BACKOFF_MAX, consecutiveFailures);
+  if (consecutiveFailures < 255) {
+    consecutiveFailures++;
+  }
+  stats.lastBackoffMillis = wait;
+  backoffUntil = halMillis() + wait;
+  state = MQTT_STATE_BACKOFF;
+}
+
+static void onConnected() {
+  for (uint8_t i = 0; i < topicCount; i++) {
+    halMQTTSubscribe(topics[i]);
+  }
+  state = MQTT_STATE_CONNECTED;
+  consecutiveFailures = 0;
+  stats.connects++;
+  stats.lastConnectMillis = halMillis() - attemptStart;
+  LOG_INFO(LOG_MQTT_CONNECTED, stats.lastConnectMillis);
+}
+
+void initializeMQTTManager(const char* id, const char* const* subscribeTopics, uint8_t count) {
+  clientId = id;
+  topics = subscribeTopics;
+  topicCount = count;
+  state = MQTT_STATE_WAIT_WIFI;
+  consecutiveFailures = 0;
+  memset(&stats, 0, sizeof(stats));
+}
+
+uint32_t updateMQTTManager(bool wifiConnected) {
+  // 后台连接一旦发起就要等它结束，期间即使 WiFi 断开也留在 CONNECTING
+  if (!wifiConnected && state != MQTT_STATE_CONNECTING) {
+    state = MQTT_STATE_WAIT_WIFI;
+  }
+
+  switch (state) {
+    case MQTT_STATE_WAIT_WIFI:
+      if (wifiConnected) {
+        startConnect();
+      }
+      break;
+
+    case MQTT_STATE_CONNECTING:
+      switch (halMQTTConnectStatus()) {
+        case HAL_MQTT_CONNECT_DONE:
+          onConnected();
+          break;
+        case HAL_MQTT_CONNECT_FAILED:
+          stats.failures++;
+          enterBackoff();
+          LOG_WARN(LOG_MQTT_FAILED, halMQTTState(), stats.lastBackoffMillis);
+          break;
+        default:
+          break;
+      }
+      break;
+
+    case MQTT_STATE_CONNECTED:
+      if (!halMQTTConnected()) {
+        stats.drops++;
+        consecutiveFailures = 0;
+        enterBackoff();
+        LOG_WARN(LOG_MQTT_LOST, stats.lastBackoffMillis);
+      }
+      break;
+
+    case MQTT_STATE_BACKOFF:
+      if ((long)(halMillis() - backoffUntil) >= 0) {
+        startConnect();
+      }
+      break;
+  }
+
+  switch (state) {
+    case MQTT_STATE_CONNECTING:
+      return MQTT_CONNECT_POLL_INTERVAL * 1000UL;
+    case MQTT_STATE_BACKOFF: {
+      long remaining = (long)(backoffUntil - halMillis());
+      return remaining > 0 ? (uint32_t)remaining * 1000UL : 0;
+    }
+    case MQTT_STATE_CONNECTED:
+    case MQTT_STATE_WAIT_WIFI:
+    default:
+      return MQTT_CHECK_INTERVAL * 1000UL;
+  }
+}
+
+bool mqttManagerConnected() {
+  return state == MQTT_STATE_CONNECTED;
+}
+
+MQTTState mqttManagerState() {
+  return state;
+}
+
+const MQTTStats& mqttStats() {
+  return stats;
+}
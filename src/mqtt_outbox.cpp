@@ -0,0 +1,157 @@
+#include <string.h>
+#include "mqtt_outbox.h"
+#include "hal.h"
+#include "config.h"
+#include "log.h"
+
+#define OUTBOX_MAGIC 0x4d514f32u  // "MQO2"，结构变化时修改
+
+static_assert((MQTT_OUTBOX_CAPACITY & (MQTT_OUTBOX_CAPACITY - 1)) == 0,
+              "MQTT_OUTBOX_CAPACITY 必须是2的幂");
+
+struct OutboxRing {
+  uint32_t magic;
+  uint32_t nextSeq;
+  uint16_t boot;
+  uint16_t head;   // 最旧一条的下标
+  uint16_t depth;
+  uint16_t reserved;
+  OutboxEntry entries[MQTT_OUTBOX_CAPACITY];
+};
+
+#if MQTT_OUTBOX_RETAIN
+static_assert(sizeof(OutboxRing) <= HAL_RETAINED_SIZE, "保留内存放不下 MQTT 待发缓冲区");
+static OutboxRing* ring = nullptr;
+#else
+static OutboxRing ringStorage;
+static OutboxRing* ring = &ringStorage;
+#endif
+static OutboxStats stats;
+
+const char* mqttEventTopic(uint8_t event) {
+  switch (event) {
+    case MQTT_EVENT_FIRST_TRIGGERED: return MQTT_TOPIC_FIRST_TRIGGERED;
+    case MQTT_EVENT_TRIGGERED:       return MQTT_TOPIC_SUB;
+    case MQTT_EVENT_RESET:           return MQTT_TOPIC_RESET;
+    default:                         return nullptr;
+  }
+}
+
+static OutboxEntry& entryAt(uint16_t offset) {
+  return ring->entries[(ring->head + offset) & (MQTT_OUTBOX_CAPACITY - 1)];
+}
+
+// 复位可能发生在写到一半时，逐条检查，任何一处不合法就整体丢弃
+static bool ringValid() {
+  if (ring->magic != OUTBOX_MAGIC || ring->head >= MQTT_OUTBOX_CAPACITY ||
+      ring->depth > MQTT_OUTBOX_CAPACITY) {
+    return false;
+  }
+  for (uint16_t i = 0; i < ring->depth; i++) {
+    if (entryAt(i).event >= NUM_MQTT_EVENTS || entryAt(i).count == 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void initializeMQTTOutbox() {
+#if MQTT_OUTBOX_RETAIN
+  ring = (OutboxRing*)halRetainedMemory();
+#endif
+  memset(&stats, 0, sizeof(stats));
+  if (ringValid()) {
+    ring->boot++;
+    stats.restored = ring->depth;
+    stats.depth = ring->depth;
+    stats.maxDepth = ring->depth;
+    if (ring->depth > 0) {
+      LOG_INFO(LOG_OUTBOX_RESTORED, ring->depth);
+    }
+  } else {
+    memset(ring, 0, sizeof(OutboxRing));
+    ring->magic = OUTBOX_MAGIC;
+  }
+}
+
+void mqttOutboxAdd(const OutboundMessage& message) {
+  stats.enqueued++;
+  ring->nextSeq++;
+
+  if (ring->depth > 0) {
+    OutboxEntry& newest = entryAt(ring->depth - 1);
+    if (newest.event == message.event && newest.boot == ring->boot && newest.count < UINT8_MAX) {
+      // 沿用最早一次的时刻，lag 反映这组事件中等待最久的一个
+      newest.seq = ring->nextSeq;
+      newest.count++;
+      stats.coalesced++;
+      return;
+    }
+  }
+
+  if (ring->depth == MQTT_OUTBOX_CAPACITY) {
+    ring->head = (ring->head + 1) & (MQTT_OUTBOX_CAPACITY - 1);
+    ring->depth--;
+    stats.dropped++;
+  }
+
+  OutboxEntry& entry = entryAt(ring->depth);
+  entry.seq = ring->nextSeq;
+  entry.eventMillis = message.eventMillis;
+  entry.postMicros = message.postMicros;
+  entry.edgeMicros = message.edgeMicros;
+  entry.boot = ring->boot;
+  entry.event = message.event;
+  entry.count = 1;
+  ring->depth++;
+
+  stats.depth = ring->depth;
+  if (ring->depth > stats.maxDepth) {
+    stats.maxDepth = ring->depth;
+  }
+}
+
+bool mqttOutboxPeek(OutboxEntry& entry) {
+  if (ring->depth == 0) {
+    return false;
+  }
+  entry = entryAt(0);
+  return true;
+}
+
+void mqttOutboxRelease(uint32_t publishMillis) {
+  if (ring->depth == 0) {
+    return;
+  }
+  const OutboxEntry& entry = entryAt(0);
+  if (entry.boot == ring->boot) {
+    stats.lastLagMillis = publishMillis - entry.eventMillis;
+    if (stats.lastLagMillis > stats.maxLagMillis) {
+      stats.maxLagMillis = stats.lastLagMillis;
+    }
+  }
+  stats.published++;
+  ring->head = (ring->head + 1) & (MQTT_OUTBOX_CAPACITY - 1);
+  ring->depth--;
+  stats.depth = ring->depth;
+}
+
+bool mqttOutboxCurrentBoot(const OutboxEntry& entry) {
+  return entry.boot == ring->boot;
+}
+
+void encodeOutboxPayload(TextWriter& out, const OutboxEntry& entry, uint32_t nowMillis) {
+  out.beginObject()
+     .field("seq", entry.seq)
+     .field("ts", entry.eventMillis)
+     .field("boot", entry.boot)
+     .field("n", entry.count);
+  if (entry.boot == ring->boot) {
+    out.field("lag", nowMillis - entry.eventMillis);
+  }
+  out.endObject();
+}
+
+const OutboxStats& mqttOutboxStats() {
+  return stats;
+}
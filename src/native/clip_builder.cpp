@@ -0,0 +1,216 @@
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <random>
+#include "clip_builder.h"
+
+static bool sameColor(const CRGB& a, const CRGB& b) {
+  return a.r == b.r && a.g == b.g && a.b == b.b;
+}
+
+static void putColor(std::vector<uint8_t>& out, const CRGB& c) {
+  out.push_back(c.r);
+  out.push_back(c.g);
+  out.push_back(c.b);
+}
+
+static void encodeRLE(const CRGB* frame, uint16_t pixels, std::vector<uint8_t>& out) {
+  for (uint32_t i = 0; i < pixels;) {
+    uint32_t run = 1;
+    while (i + run < pixels && run < 256 && sameColor(frame[i + run], frame[i])) {
+      run++;
+    }
+    out.push_back((uint8_t)(run - 1));
+    putColor(out, frame[i]);
+    i += run;
+  }
+}
+
+static void encodeDelta(const CRGB* frame, const CRGB* previous, uint16_t pixels, std::vector<uint8_t>& out) {
+  for (uint32_t i = 0; i < pixels;) {
+    uint32_t skip = 0;
+    while (i + skip < pixels && sameColor(frame[i + skip], previous[i + skip])) {
+      skip++;
+    }
+    if (i + skip == pixels) {
+      break;  // 末尾不变的像素不用写
+    }
+    for (; skip > 255; skip -= 255) {
+      out.push_back(255);
+      out.push_back(0);
+      i += 255;
+    }
+    i += skip;
+    uint32_t n = 0;
+    while (i + n < pixels && n < 255 && !sameColor(frame[i + n], previous[i + n])) {
+      n++;
+    }
+    out.push_back((uint8_t)skip);
+    out.push_back((uint8_t)n);
+    for (uint32_t k = 0; k < n; k++) {
+      putColor(out, frame[i + k]);
+    }
+    i += n;
+  }
+}
+
+ClipFrameType encodeClipFrame(const CRGB* frame, const CRGB* previous, uint16_t pixels, std::vector<uint8_t>& out) {
+  std::vector<uint8_t> candidates[NUM_CLIP_FRAME_TYPES];
+  encodeRLE(frame, pixels, candidates[CLIP_FRAME_RLE]);
+  for (uint32_t i = 0; i < pixels; i++) {
+    putColor(candidates[CLIP_FRAME_RAW], frame[i]);
+  }
+  ClipFrameType best = candidates[CLIP_FRAME_RLE].size() <= candidates[CLIP_FRAME_RAW].size() ? CLIP_FRAME_RLE : CLIP_FRAME_RAW;
+  if (previous) {
+    encodeDelta(frame, previous, pixels, candidates[CLIP_FRAME_DELTA]);
+    if (candidates[CLIP_FRAME_DELTA].size() < candidates[best].size()) {
+      best = CLIP_FRAME_DELTA;
+    }
+  }
+  const std::vector<uint8_t>& payload = candidates[best];
+  out.push_back(best);
+  out.push_back((uint8_t)(payload.size() & 0xFF));
+  out.push_back((uint8_t)(payload.size() >> 8));
+  out.insert(out.end(), payload.begin(), payload.end());
+  return best;
+}
+
+template <typename T>
+static void putStruct(std::vector<uint8_t>& out, size_t offset, const T& value) {
+  memcpy(out.data() + offset, &value, sizeof(T));
+}
+
+bool buildClipBundle(const std::vector<ClipSource>& clips, std::vector<uint8_t>& bundle, ClipEncodeStats& stats,
+                     std::string& error) {
+  stats = ClipEncodeStats();
+  if (clips.size() > CLIP_MAX) {
+    error = "片段数超过 CLIP_MAX";
+    return false;
+  }
+  bundle.assign(sizeof(ClipBundleHeader) + clips.size() * sizeof(ClipEntry), 0);
+  for (size_t c = 0; c < clips.size(); c++) {
+    const ClipSource& clip = clips[c];
+    uint32_t frames = clip.pixels ? (uint32_t)(clip.frames.size() / clip.pixels) : 0;
+    if (clip.name.empty() || clip.name.size() >= CLIP_NAME_LENGTH) {
+      error = "片段名长度无效: " + clip.name;
+      return false;
+    }
+    if (clip.pixels == 0 || clip.pixels > LED_MAX_PIXELS || frames == 0 || frames > UINT16_MAX ||
+        frames * clip.pixels != clip.frames.size()) {
+      error = "像素数或帧数无效: " + clip.name;
+      return false;
+    }
+    if (clip.fps == 0 || clip.fps > CLIP_MAX_FPS) {
+      error = "帧率无效: " + clip.name;
+      return false;
+    }
+    while (bundle.size() % 4) {
+      bundle.push_back(0);
+    }
+    ClipEntry entry = {};
+    memcpy(entry.name, clip.name.c_str(), clip.name.size());
+    entry.offset = (uint32_t)bundle.size();
+    entry.frames = (uint16_t)frames;
+    entry.pixels = clip.pixels;
+    entry.fps = clip.fps;
+    entry.flags = clip.loop ? CLIP_FLAG_LOOP : 0;
+    for (uint32_t f = 0; f < frames; f++) {
+      const CRGB* frame = &clip.frames[f * clip.pixels];
+      stats.frames[encodeClipFrame(frame, f ? frame - clip.pixels : nullptr, clip.pixels, bundle)]++;
+    }
+    entry.length = (uint32_t)(bundle.size() - entry.offset);
+    stats.frameBytes += entry.length;
+    putStruct(bundle, sizeof(ClipBundleHeader) + c * sizeof(ClipEntry), entry);
+  }
+
+  ClipBundleHeader header = {};
+  memcpy(header.magic, "BCLP", 4);
+  header.version = CLIP_FORMAT_VERSION;
+  header.count = (uint8_t)clips.size();
+  header.length = (uint32_t)bundle.size();
+  header.crc = clipCRC32(0, bundle.data() + sizeof(header), bundle.size() - sizeof(header));
+  putStruct(bundle, 0, header);
+  return true;
+}
+
+// ==================== 演示片段 ====================
+static CRGB colorWheel(uint8_t position) {
+  if (position < 85) {
+    return CRGB(255 - position * 3, position * 3, 0);
+  }
+  if (position < 170) {
+    position -= 85;
+    return CRGB(0, 255 - position * 3, position * 3);
+  }
+  position -= 170;
+  return CRGB(position * 3, 0, 255 - position * 3);
+}
+
+bool makeDemoClip(const char* kind, const char* name, uint16_t pixels, ClipSource& clip) {
+  clip.name = name;
+  clip.pixels = pixels;
+  clip.loop = true;
+  clip.frames.clear();
+  if (!strcmp(kind, "rainbow")) {
+    const uint32_t frames = 60;
+    clip.fps = 30;
+    for (uint32_t f = 0; f < frames; f++) {
+      for (uint32_t i = 0; i < pixels; i++) {
+        clip.frames.push_back(colorWheel((uint8_t)(i * 256 / pixels + f * 256 / frames)));
+      }
+    }
+  } else if (!strcmp(kind, "sparkle")) {
+    // 每帧点亮两个随机像素，亮度每帧衰减到 3/4
+    const uint32_t frames = 90;
+    std::mt19937 rng(7);
+    std::vector<uint8_t> level(pixels, 0);
+    clip.fps = 30;
+    for (uint32_t f = 0; f < frames; f++) {
+      for (uint8_t& l : level) {
+        l = l * 3 / 4;
+      }
+      level[rng() % pixels] = 255;
+      level[rng() % pixels] = 255;
+      for (uint32_t i = 0; i < pixels; i++) {
+        clip.frames.push_back(CRGB(level[i], level[i], level[i] / 2 + 8));
+      }
+    }
+  } else if (!strcmp(kind, "wipe")) {
+    // 每帧点亮 4 个像素直到全亮，再每帧熄灭 4 个
+    const uint32_t step = 4;
+    const uint32_t half = (pixels + step - 1) / step;
+    clip.fps = 30;
+    for (uint32_t f = 0; f < half * 2; f++) {
+      uint32_t changed = std::min((f % half + 1) * step, (uint32_t)pixels);
+      uint32_t lit = f < half ? changed : pixels - changed;
+      for (uint32_t i = 0; i < pixels; i++) {
+        clip.frames.push_back(i < lit ? CRGB(255, 96, 0) : CRGB(0, 0, 0));
+      }
+    }
+  } else if (!strcmp(kind, "still")) {
+    clip.fps = 1;
+    clip.loop = false;
+    clip.frames.assign(pixels, CRGB(0, 40, 120));
+  } else {
+    return false;
+  }
+  return true;
+}
+
+bool loadRawClip(const char* path, const char* name, uint16_t pixels, uint8_t fps, ClipSource& clip) {
+  FILE* f = fopen(path, "rb");
+  if (!f) {
+    return false;
+  }
+  clip.name = name;
+  clip.pixels = pixels;
+  clip.fps = fps;
+  clip.loop = true;
+  clip.frames.clear();
+  uint8_t rgb[3];
+  while (fread(rgb, 1, 3, f) == 3) {
+    clip.frames.push_back(CRGB(rgb[0], rgb[1], rgb[2]));
+  }
+  fclose(f);
+  return pixels > 0 && !clip.frames.empty() && clip.frames.size() % pixels == 0;
+}
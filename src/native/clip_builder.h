@@ -0,0 +1,40 @@
+#ifndef CLIP_BUILDER_H
+#define CLIP_BUILDER_H
+
+// ==================== 动画片段编码（主机工具） ====================
+// 把逐帧的 rgb 像素编码成片段包（格式见 clips.h），由 program --clip-build 写成文件，
+// 再经 POST /api/clips 上传到设备。每帧在 RLE / DELTA / RAW 中选载荷最短的一种（第一帧不用 DELTA）。
+// 另有几段程序生成的演示片段，--clips 校验和基准也用它们。
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+#include <vector>
+#include "clips.h"
+
+struct ClipSource {
+  std::string name;
+  uint16_t pixels;
+  uint8_t fps;
+  bool loop;
+  std::vector<CRGB> frames;  // 帧数 × pixels
+};
+
+struct ClipEncodeStats {
+  uint32_t frames[NUM_CLIP_FRAME_TYPES];  // 各类型的帧数
+  size_t frameBytes;                      // 全部帧（含帧头）
+};
+
+// 追加一帧到 out；previous 为 nullptr 时只用整帧类型。返回所选的类型
+ClipFrameType encodeClipFrame(const CRGB* frame, const CRGB* previous, uint16_t pixels, std::vector<uint8_t>& out);
+
+bool buildClipBundle(const std::vector<ClipSource>& clips, std::vector<uint8_t>& bundle, ClipEncodeStats& stats,
+                     std::string& error);
+
+// 演示片段：rainbow（彩虹流动）、sparkle（暗背景上的闪烁点）、wipe（逐个点亮再熄灭）、still（单色静止）
+bool makeDemoClip(const char* kind, const char* name, uint16_t pixels, ClipSource& clip);
+
+// 原始 rgb 文件：每帧 pixels × 3 字节
+bool loadRawClip(const char* path, const char* name, uint16_t pixels, uint8_t fps, ClipSource& clip);
+
+#endif // CLIP_BUILDER_H
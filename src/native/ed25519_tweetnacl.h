@@ -0,0 +1,511 @@
+#ifndef ED25519_TWEETNACL_H
+#define ED25519_TWEETNACL_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+// ==================== SHA-512 / Ed25519（主机） ====================
+// RFC 8032 的 Ed25519 的 TweetNaCl 移植，只在主机构建中使用（经 ed25519.h 引入）：program --ota-keygen /
+// --ota-sign 生成密钥和签名，模拟后端和测试用它验证。固件里的验证用 libsodium（见 ed25519.h）。
+// 域运算沿用 TweetNaCl 的写法（GF(2^255-19) 的元素为 16 个 16 位分量，存放在 int64_t 里），
+// 代码短、不分配内存、与私钥相关的分支和下标都与数据无关。
+
+#define SHA512_DIGEST_SIZE 64
+#define SHA512_BLOCK_SIZE 128
+
+class Sha512 {
+public:
+  Sha512() { reset(); }
+
+  void reset() {
+    static constexpr uint64_t INIT[8] = {
+      0x6a09e667f3bcc908ULL, 0xbb67ae8584caa73bULL, 0x3c6ef372fe94f82bULL, 0xa54ff53a5f1d36f1ULL,
+      0x510e527fade682d1ULL, 0x9b05688c2b3e6c1fULL, 0x1f83d9abfb41bd6bULL, 0x5be0cd19137e2179ULL
+    };
+    memcpy(state_, INIT, sizeof(state_));
+    bytes_ = 0;
+    buffered_ = 0;
+  }
+
+  void update(const uint8_t* data, size_t length) {
+    if (length == 0) {
+      return;
+    }
+    bytes_ += length;
+    if (buffered_) {
+      size_t n = SHA512_BLOCK_SIZE - buffered_ < length ? SHA512_BLOCK_SIZE - buffered_ : length;
+      memcpy(block_ + buffered_, data, n);
+      buffered_ += n;
+      data += n;
+      length -= n;
+      if (buffered_ < SHA512_BLOCK_SIZE) {
+        return;
+      }
+      compress(block_);
+      buffered_ = 0;
+    }
+    for (; length >= SHA512_BLOCK_SIZE; data += SHA512_BLOCK_SIZE, length -= SHA512_BLOCK_SIZE) {
+      compress(data);
+    }
+    memcpy(block_, data, length);
+    buffered_ = length;
+  }
+
+  // 之后需要 reset() 才能重新使用；消息长度不超过 2^61 字节，长度字段的高 64 位总是 0
+  void finish(uint8_t digest[SHA512_DIGEST_SIZE]) {
+    uint64_t bits = bytes_ * 8;
+    uint8_t pad[SHA512_BLOCK_SIZE + 16] = {0x80};
+    size_t padLength = (buffered_ < 112 ? 112 : 240) - buffered_;
+    for (int i = 0; i < 8; i++) {
+      pad[padLength + 8 + i] = (uint8_t)(bits >> (56 - 8 * i));
+    }
+    update(pad, padLength + 16);
+    for (int i = 0; i < 8; i++) {
+      for (int j = 0; j < 8; j++) {
+        digest[8 * i + j] = (uint8_t)(state_[i] >> (56 - 8 * j));
+      }
+    }
+  }
+
+private:
+  static uint64_t rotr(uint64_t x, int n) { return (x >> n) | (x << (64 - n)); }
+
+  void compress(const uint8_t* block) {
+    static constexpr uint64_t K[80] = {
+      0x428a2f98d728ae22ULL, 0x7137449123ef65cdULL, 0xb5c0fbcfec4d3b2fULL, 0xe9b5dba58189dbbcULL,
+      0x3956c25bf348b538ULL, 0x59f111f1b605d019ULL, 0x923f82a4af194f9bULL, 0xab1c5ed5da6d8118ULL,
+      0xd807aa98a3030242ULL, 0x12835b0145706fbeULL, 0x243185be4ee4b28cULL, 0x550c7dc3d5ffb4e2ULL,
+      0x72be5d74f27b896fULL, 0x80deb1fe3b1696b1ULL, 0x9bdc06a725c71235ULL, 0xc19bf174cf692694ULL,
+      0xe49b69c19ef14ad2ULL, 0xefbe4786384f25e3ULL, 0x0fc19dc68b8cd5b5ULL, 0x240ca1cc77ac9c65ULL,
+      0x2de92c6f592b0275ULL, 0x4a7484aa6ea6e483ULL, 0x5cb0a9dcbd41fbd4ULL, 0x76f988da831153b5ULL,
+      0x983e5152ee66dfabULL, 0xa831c66d2db43210ULL, 0xb00327c898fb213fULL, 0xbf597fc7beef0ee4ULL,
+      0xc6e00bf33da88fc2ULL, 0xd5a79147930aa725ULL, 0x06ca6351e003826fULL, 0x142929670a0e6e70ULL,
+      0x27b70a8546d22ffcULL, 0x2e1b21385c26c926ULL, 0x4d2c6dfc5ac42aedULL, 0x53380d139d95b3dfULL,
+      0x650a73548baf63deULL, 0x766a0abb3c77b2a8ULL, 0x81c2c92e47edaee6ULL, 0x92722c851482353bULL,
+      0xa2bfe8a14cf10364ULL, 0xa81a664bbc423001ULL, 0xc24b8b70d0f89791ULL, 0xc76c51a30654be30ULL,
+      0xd192e819d6ef5218ULL, 0xd69906245565a910ULL, 0xf40e35855771202aULL, 0x106aa07032bbd1b8ULL,
+      0x19a4c116b8d2d0c8ULL, 0x1e376c085141ab53ULL, 0x2748774cdf8eeb99ULL, 0x34b0bcb5e19b48a8ULL,
+      0x391c0cb3c5c95a63ULL, 0x4ed8aa4ae3418acbULL, 0x5b9cca4f7763e373ULL, 0x682e6ff3d6b2b8a3ULL,
+      0x748f82ee5defb2fcULL, 0x78a5636f43172f60ULL, 0x84c87814a1f0ab72ULL, 0x8cc702081a6439ecULL,
+      0x90befffa23631e28ULL, 0xa4506cebde82bde9ULL, 0xbef9a3f7b2c67915ULL, 0xc67178f2e372532bULL,
+      0xca273eceea26619cULL, 0xd186b8c721c0c207ULL, 0xeada7dd6cde0eb1eULL, 0xf57d4f7fee6ed178ULL,
+      0x06f067aa72176fbaULL, 0x0a637dc5a2c898a6ULL, 0x113f9804bef90daeULL, 0x1b710b35131c471bULL,
+      0x28db77f523047d84ULL, 0x32caab7b40c72493ULL, 0x3c9ebe0a15c9bebcULL, 0x431d67c49c100d4cULL,
+      0x4cc5d4becb3e42b6ULL, 0x597f299cfc657e2aULL, 0x5fcb6fab3ad6faecULL, 0x6c44198c4a475817ULL
+    };
+    uint64_t w[80];
+    for (int i = 0; i < 16; i++) {
+      w[i] = 0;
+      for (int j = 0; j < 8; j++) {
+        w[i] = (w[i] << 8) | block[8 * i + j];
+      }
+    }
+    for (int i = 16; i < 80; i++) {
+      uint64_t s0 = rotr(w[i - 15], 1) ^ rotr(w[i - 15], 8) ^ (w[i - 15] >> 7);
+      uint64_t s1 = rotr(w[i - 2], 19) ^ rotr(w[i - 2], 61) ^ (w[i - 2] >> 6);
+      w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+    uint64_t a = state_[0], b = state_[1], c = state_[2], d = state_[3];
+    uint64_t e = state_[4], f = state_[5], g = state_[6], h = state_[7];
+    for (int i = 0; i < 80; i++) {
+      uint64_t t1 = h + (rotr(e, 14) ^ rotr(e, 18) ^ rotr(e, 41)) + ((e & f) ^ (~e & g)) + K[i] + w[i];
+      uint64_t t2 = (rotr(a, 28) ^ rotr(a, 34) ^ rotr(a, 39)) + ((a & b) ^ (a & c) ^ (b & c));
+      h = g;
+      g = f;
+      f = e;
+      e = d + t1;
+      d = c;
+      c = b;
+      b = a;
+      a = t1 + t2;
+    }
+    state_[0] += a;
+    state_[1] += b;
+    state_[2] += c;
+    state_[3] += d;
+    state_[4] += e;
+    state_[5] += f;
+    state_[6] += g;
+    state_[7] += h;
+  }
+
+  uint64_t state_[8];
+  uint64_t bytes_;
+  uint8_t block_[SHA512_BLOCK_SIZE];
+  size_t buffered_;
+};
+
+namespace ed25519 {
+
+typedef int64_t Fe[16];  // 域元素：sum(v[i] * 2^(16 i))，运算中间结果不一定规约
+
+static constexpr Fe FE_ZERO = {0};
+static constexpr Fe FE_ONE = {1};
+static constexpr Fe CURVE_D = {0x78a3, 0x1359, 0x4dca, 0x75eb, 0xd8ab, 0x4141, 0x0a4d, 0x0070,
+                               0xe898, 0x7779, 0x4079, 0x8cc7, 0xfe73, 0x2b6f, 0x6cee, 0x5203};
+static constexpr Fe CURVE_D2 = {0xf159, 0x26b2, 0x9b94, 0xebd6, 0xb156, 0x8283, 0x149a, 0x00e0,
+                                0xd130, 0xeef3, 0x80f2, 0x198e, 0xfce7, 0x56df, 0xd9dc, 0x2406};
+static constexpr Fe BASE_X = {0xd51a, 0x8f25, 0x2d60, 0xc956, 0xa7b2, 0x9525, 0xc760, 0x692c,
+                              0xdc5c, 0xfdd6, 0xe231, 0xc0a4, 0x53fe, 0xcd6e, 0x36d3, 0x2169};
+static constexpr Fe BASE_Y = {0x6658, 0x6666, 0x6666, 0x6666, 0x6666, 0x6666, 0x6666, 0x6666,
+                              0x6666, 0x6666, 0x6666, 0x6666, 0x6666, 0x6666, 0x6666, 0x6666};
+static constexpr Fe SQRT_M1 = {0xa0b0, 0x4a0e, 0x1b27, 0xc4ee, 0xe478, 0xad2f, 0x1806, 0x2f43,
+                               0xd7a7, 0x3dfb, 0x0099, 0x2b4d, 0xdf0b, 0x4fc1, 0x2480, 0x2b83};
+// 基点的阶 L = 2^252 + 27742317777372353535851937790883648493，小端
+static constexpr int64_t ORDER[32] = {0xed, 0xd3, 0xf5, 0x5c, 0x1a, 0x63, 0x12, 0x58, 0xd6, 0x9c, 0xf7,
+                                      0xa2, 0xde, 0xf9, 0xde, 0x14, 0,    0,    0,    0,    0,    0,
+                                      0,    0,    0,    0,    0,    0,    0,    0,    0,    0x10};
+
+inline void copy(Fe out, const Fe a) {
+  for (int i = 0; i < 16; i++) out[i] = a[i];
+}
+
+// 每个分量进位到 16 位，最高位的进位乘 38（2^256 = 38 mod p）绕回最低位
+inline void carry(Fe o) {
+  for (int i = 0; i < 16; i++) {
+    o[i] += 1LL << 16;
+    int64_t c = o[i] >> 16;
+    if (i < 15) {
+      o[i + 1] += c - 1;
+    } else {
+      o[0] += 38 * (c - 1);
+    }
+    o[i] -= c * 65536;
+  }
+}
+
+// b 为 1 时交换，与 b 无关的访问模式
+inline void select(Fe p, Fe q, int b) {
+  int64_t mask = ~((int64_t)b - 1);
+  for (int i = 0; i < 16; i++) {
+    int64_t t = mask & (p[i] ^ q[i]);
+    p[i] ^= t;
+    q[i] ^= t;
+  }
+}
+
+inline void pack(uint8_t out[32], const Fe n) {
+  Fe m;
+  Fe t;
+  copy(t, n);
+  carry(t);
+  carry(t);
+  carry(t);
+  for (int j = 0; j < 2; j++) {
+    m[0] = t[0] - 0xffed;
+    for (int i = 1; i < 15; i++) {
+      m[i] = t[i] - 0xffff - ((m[i - 1] >> 16) & 1);
+      m[i - 1] &= 0xffff;
+    }
+    m[15] = t[15] - 0x7fff - ((m[14] >> 16) & 1);
+    int b = (int)((m[15] >> 16) & 1);
+    m[14] &= 0xffff;
+    select(t, m, 1 - b);
+  }
+  for (int i = 0; i < 16; i++) {
+    out[2 * i] = (uint8_t)(t[i] & 0xff);
+    out[2 * i + 1] = (uint8_t)(t[i] >> 8);
+  }
+}
+
+inline void unpack(Fe o, const uint8_t n[32]) {
+  for (int i = 0; i < 16; i++) {
+    o[i] = n[2 * i] + ((int64_t)n[2 * i + 1] << 8);
+  }
+  o[15] &= 0x7fff;
+}
+
+inline bool bytesEqual(const uint8_t* a, const uint8_t* b, size_t length) {
+  uint8_t diff = 0;
+  for (size_t i = 0; i < length; i++) {
+    diff |= a[i] ^ b[i];
+  }
+  return diff == 0;
+}
+
+inline bool equal(const Fe a, const Fe b) {
+  uint8_t c[32];
+  uint8_t d[32];
+  pack(c, a);
+  pack(d, b);
+  return bytesEqual(c, d, 32);
+}
+
+inline uint8_t parity(const Fe a) {
+  uint8_t d[32];
+  pack(d, a);
+  return d[0] & 1;
+}
+
+inline void add(Fe o, const Fe a, const Fe b) {
+  for (int i = 0; i < 16; i++) o[i] = a[i] + b[i];
+}
+
+inline void sub(Fe o, const Fe a, const Fe b) {
+  for (int i = 0; i < 16; i++) o[i] = a[i] - b[i];
+}
+
+inline void mul(Fe o, const Fe a, const Fe b) {
+  int64_t t[31] = {0};
+  for (int i = 0; i < 16; i++) {
+    for (int j = 0; j < 16; j++) {
+      t[i + j] += a[i] * b[j];
+    }
+  }
+  for (int i = 0; i < 15; i++) {
+    t[i] += 38 * t[i + 16];
+  }
+  for (int i = 0; i < 16; i++) {
+    o[i] = t[i];
+  }
+  carry(o);
+  carry(o);
+}
+
+inline void square(Fe o, const Fe a) {
+  mul(o, a, a);
+}
+
+// a^(p-2)
+inline void invert(Fe o, const Fe a) {
+  Fe c;
+  copy(c, a);
+  for (int i = 253; i >= 0; i--) {
+    square(c, c);
+    if (i != 2 && i != 4) mul(c, c, a);
+  }
+  copy(o, c);
+}
+
+// a^((p-5)/8)，解压缩点时开平方用
+inline void pow2523(Fe o, const Fe a) {
+  Fe c;
+  copy(c, a);
+  for (int i = 250; i >= 0; i--) {
+    square(c, c);
+    if (i != 1) mul(c, c, a);
+  }
+  copy(o, c);
+}
+
+// 扩展坐标 (X, Y, Z, T) 的点：p += q
+inline void addPoint(Fe p[4], Fe q[4]) {
+  Fe a, b, c, d, t, e, f, g, h;
+  sub(a, p[1], p[0]);
+  sub(t, q[1], q[0]);
+  mul(a, a, t);
+  add(b, p[0], p[1]);
+  add(t, q[0], q[1]);
+  mul(b, b, t);
+  mul(c, p[3], q[3]);
+  mul(c, c, CURVE_D2);
+  mul(d, p[2], q[2]);
+  add(d, d, d);
+  sub(e, b, a);
+  sub(f, d, c);
+  add(g, d, c);
+  add(h, b, a);
+  mul(p[0], e, f);
+  mul(p[1], h, g);
+  mul(p[2], g, f);
+  mul(p[3], e, h);
+}
+
+inline void swapPoints(Fe p[4], Fe q[4], int b) {
+  for (int i = 0; i < 4; i++) {
+    select(p[i], q[i], b);
+  }
+}
+
+inline void packPoint(uint8_t out[32], Fe p[4]) {
+  Fe zi, tx, ty;
+  invert(zi, p[2]);
+  mul(tx, p[0], zi);
+  mul(ty, p[1], zi);
+  pack(out, ty);
+  out[31] ^= parity(tx) << 7;
+}
+
+// p = s * q（Montgomery 阶梯，每一位都做一次加和一次倍点）；q 被改写
+inline void scalarMul(Fe p[4], Fe q[4], const uint8_t s[32]) {
+  copy(p[0], FE_ZERO);
+  copy(p[1], FE_ONE);
+  copy(p[2], FE_ONE);
+  copy(p[3], FE_ZERO);
+  for (int i = 255; i >= 0; i--) {
+    int b = (s[i / 8] >> (i & 7)) & 1;
+    swapPoints(p, q, b);
+    addPoint(q, p);
+    addPoint(p, p);
+    swapPoints(p, q, b);
+  }
+}
+
+inline void scalarBase(Fe p[4], const uint8_t s[32]) {
+  Fe q[4];
+  copy(q[0], BASE_X);
+  copy(q[1], BASE_Y);
+  copy(q[2], FE_ONE);
+  mul(q[3], BASE_X, BASE_Y);
+  scalarMul(p, q, s);
+}
+
+// r = x mod L，x 为 64 个字节值（可以超过 255，来自乘法的中间结果）
+inline void reduceScalar(uint8_t r[32], int64_t x[64]) {
+  int64_t c;
+  for (int i = 63; i >= 32; i--) {
+    c = 0;
+    int j;
+    for (j = i - 32; j < i - 12; j++) {
+      x[j] += c - 16 * x[i] * ORDER[j - (i - 32)];
+      c = (x[j] + 128) >> 8;
+      x[j] -= c * 256;
+    }
+    x[j] += c;
+    x[i] = 0;
+  }
+  c = 0;
+  for (int j = 0; j < 32; j++) {
+    x[j] += c - (x[31] >> 4) * ORDER[j];
+    c = x[j] >> 8;
+    x[j] &= 255;
+  }
+  for (int j = 0; j < 32; j++) {
+    x[j] -= c * ORDER[j];
+  }
+  for (int i = 0; i < 32; i++) {
+    x[i + 1] += x[i] >> 8;
+    r[i] = (uint8_t)(x[i] & 255);
+  }
+}
+
+inline void reduceDigest(uint8_t out[32], const uint8_t digest[SHA512_DIGEST_SIZE]) {
+  int64_t x[64];
+  for (int i = 0; i < 64; i++) {
+    x[i] = digest[i];
+  }
+  reduceScalar(out, x);
+}
+
+// 解压缩公钥并取负（验证时计算 s*B - h*A）；不在曲线上时返回 false
+inline bool unpackNegative(Fe r[4], const uint8_t p[32]) {
+  Fe t, chk, num, den, den2, den4, den6;
+  copy(r[2], FE_ONE);
+  unpack(r[1], p);
+  square(num, r[1]);
+  mul(den, num, CURVE_D);
+  sub(num, num, r[2]);
+  add(den, r[2], den);
+  square(den2, den);
+  square(den4, den2);
+  mul(den6, den4, den2);
+  mul(t, den6, num);
+  mul(t, t, den);
+  pow2523(t, t);
+  mul(t, t, num);
+  mul(t, t, den);
+  mul(t, t, den);
+  mul(r[0], t, den);
+  square(chk, r[0]);
+  mul(chk, chk, den);
+  if (!equal(chk, num)) mul(r[0], r[0], SQRT_M1);
+  square(chk, r[0]);
+  mul(chk, chk, den);
+  if (!equal(chk, num)) return false;
+  if (parity(r[0]) == (p[31] >> 7)) sub(r[0], FE_ZERO, r[0]);
+  mul(r[3], r[0], r[1]);
+  return true;
+}
+
+// s < L：拒绝可延展的签名（同一消息的另一个合法签名）
+inline bool scalarCanonical(const uint8_t s[32]) {
+  for (int i = 31; i >= 0; i--) {
+    if (s[i] != ORDER[i]) return s[i] < ORDER[i];
+  }
+  return false;
+}
+
+inline void expandSeed(uint8_t expanded[SHA512_DIGEST_SIZE], const uint8_t seed[ED25519_SEED_SIZE]) {
+  Sha512 sha;
+  sha.update(seed, ED25519_SEED_SIZE);
+  sha.finish(expanded);
+  expanded[0] &= 248;
+  expanded[31] &= 127;
+  expanded[31] |= 64;
+}
+
+// h = SHA-512(R || A || message) mod L
+inline void challenge(uint8_t h[32], const uint8_t r[32], const uint8_t publicKey[32], const uint8_t* message,
+                      size_t length) {
+  uint8_t digest[SHA512_DIGEST_SIZE];
+  Sha512 sha;
+  sha.update(r, 32);
+  sha.update(publicKey, 32);
+  sha.update(message, length);
+  sha.finish(digest);
+  reduceDigest(h, digest);
+}
+
+}  // namespace ed25519
+
+// ==================== 密钥与签名（主机工具） ====================
+inline void ed25519PublicKey(uint8_t publicKey[ED25519_PUBLIC_KEY_SIZE], const uint8_t seed[ED25519_SEED_SIZE]) {
+  uint8_t expanded[SHA512_DIGEST_SIZE];
+  ed25519::expandSeed(expanded, seed);
+  ed25519::Fe p[4];
+  ed25519::scalarBase(p, expanded);
+  ed25519::packPoint(publicKey, p);
+}
+
+inline void ed25519Sign(uint8_t signature[ED25519_SIGNATURE_SIZE], const uint8_t* message, size_t length,
+                        const uint8_t seed[ED25519_SEED_SIZE]) {
+  uint8_t expanded[SHA512_DIGEST_SIZE];
+  uint8_t publicKey[ED25519_PUBLIC_KEY_SIZE];
+  ed25519::expandSeed(expanded, seed);
+  ed25519PublicKey(publicKey, seed);
+
+  uint8_t digest[SHA512_DIGEST_SIZE];
+  uint8_t r[32];
+  Sha512 sha;
+  sha.update(expanded + 32, 32);
+  sha.update(message, length);
+  sha.finish(digest);
+  ed25519::reduceDigest(r, digest);
+  ed25519::Fe p[4];
+  ed25519::scalarBase(p, r);
+  ed25519::packPoint(signature, p);
+
+  uint8_t h[32];
+  ed25519::challenge(h, signature, publicKey, message, length);
+  int64_t x[64] = {0};
+  for (int i = 0; i < 32; i++) {
+    x[i] = r[i];
+  }
+  for (int i = 0; i < 32; i++) {
+    for (int j = 0; j < 32; j++) {
+      x[i + j] += h[i] * (int64_t)expanded[j];
+    }
+  }
+  ed25519::reduceScalar(signature + 32, x);
+}
+
+// ==================== 验证 ====================
+inline bool ed25519Verify(const uint8_t signature[ED25519_SIGNATURE_SIZE], const uint8_t* message, size_t length,
+                          const uint8_t publicKey[ED25519_PUBLIC_KEY_SIZE]) {
+  ed25519::Fe p[4];
+  ed25519::Fe q[4];
+  if (!ed25519::scalarCanonical(signature + 32) || !ed25519::unpackNegative(q, publicKey)) {
+    return false;
+  }
+  uint8_t h[32];
+  ed25519::challenge(h, signature, publicKey, message, length);
+  ed25519::scalarMul(p, q, h);
+  ed25519::scalarBase(q, signature + 32);
+  ed25519::addPoint(p, q);
+  uint8_t r[32];
+  ed25519::packPoint(r, p);
+  return ed25519::bytesEqual(r, signature, 32);
+}
+
+#endif // ED25519_TWEETNACL_H
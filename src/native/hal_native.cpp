@@ -0,0 +1,1349 @@
+// ==================== 主机模拟硬件抽象层 ====================
+// 只在 [env:native] 中编译，所有时间均为虚拟时间，由 hal_sim.h 控制
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <functional>
+#include <mutex>
+#include <new>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include "hal.h"
+#include "hal_sim.h"
+#include "config.h"
+#include "topic_trie.h"
+
+#define SIM_NUM_PINS 40
+#define SIM_LED_MICROS_PER_PIXEL 30
+#define SIM_LED_RESET_MICROS 280
+#define SIM_MQTT_MAX_SUBSCRIPTIONS 8
+
+NativeSerial Serial;
+
+static std::atomic<uint64_t> simMicros(0);
+static bool realTime = false;
+static std::chrono::steady_clock::time_point realTimeEpoch;
+static std::mutex serialMutex;
+static std::atomic<bool> tasksRunning(false);
+static std::thread taskThreads[HAL_MAX_TASKS];
+static bool taskStarted[HAL_MAX_TASKS];
+static bool taskNotified[HAL_MAX_TASKS];
+static bool signalGiven[HAL_MAX_SIGNALS];
+static std::mutex notifyMutex;
+static std::condition_variable notifyCondition;
+static thread_local uint8_t currentTask = HAL_MAIN_TASK;
+
+// 预定的模拟事件（引脚变化、WiFi 连接完成等，虚拟时钟模式），推进时间时按时间顺序触发
+static std::multimap<uint64_t, std::function<void()> > scheduledEvents;
+static std::mt19937 randomEngine;
+static std::atomic<int> pinLevels[SIM_NUM_PINS];  // 模拟输入寄存器，压力测试时跨线程读写
+static HalPinChangeHandler pinHandlers[SIM_NUM_PINS];
+static uint8_t pinHandlerIndex[SIM_NUM_PINS];
+static bool lightSleeping = false;  // 浅睡眠期间引脚中断不送达
+static bool ledWireTiming = true;
+static uint8_t ledNotifyTask = HAL_MAIN_TASK;
+static uint8_t ledChannelCount = 0;
+static std::atomic<bool> ledEvent(false);
+
+struct SimLEDChannel {
+  bool sending;
+  uint64_t doneAt;
+  const uint8_t* frame;                // 正在“发送”的帧，发送完成前调用方不得修改
+  std::vector<uint8_t> frameAtStart;   // 开始发送时的内容
+  std::vector<uint8_t> displayed;      // 最近一次发送完成的帧，即灯带上显示的内容
+};
+static SimLEDChannel ledChannels[HAL_LED_MAX_CHANNELS];
+static bool serialEcho = false;
+static uint32_t serialBaud = 0;
+static uint64_t serialBusyUntil = 0;     // 已写入的字节全部发出的时刻（ns）
+static uint64_t serialBlockedUntil = 0;  // 已计入 serialBlockedMicros 的阻塞区间的终点（ns）
+static SimTextHook webSocketTextHook = nullptr;
+static SimTextHook udpHook = nullptr;
+
+static SimBrokerState brokerState = SIM_BROKER_UP;
+static uint32_t mqttConnectTimeoutMs = 3000;
+static uint32_t mqttConnectLatencyMs = 40;  // TCP 握手 + CONNECT/CONNACK 往返
+static uint8_t mqttNotifyTask = HAL_MAIN_TASK;
+static std::atomic<int> mqttConnectStatus(HAL_MQTT_CONNECT_IDLE);
+static std::atomic<bool> mqttEvent(false);
+static uint64_t mqttResolveAt = 0;
+static bool mqttResolveOK = false;
+static std::atomic<bool> mqttConnected(false);  // 压力测试中主线程会轮询
+static int mqttState = -1;  // 与 PubSubClient 一致：-1 = MQTT_DISCONNECTED
+static HalMQTTCallback mqttCallback = nullptr;
+static bool inMQTTCallback = false;
+static std::string mqttSubscriptions[SIM_MQTT_MAX_SUBSCRIPTIONS];
+
+// 发布到自己订阅的主题时，服务器在 mqttEchoLatencyMs 后回送，halMQTTLoop() 中分发（与 PubSubClient 一致）
+struct SimInbound {
+  uint64_t deliverAt;
+  std::string topic;
+  std::string payload;
+};
+static std::deque<SimInbound> mqttInbound;
+static uint32_t mqttEchoLatencyMs = 3;
+static uint8_t mqttSubscriptionCount = 0;
+static SimPublishHook publishHook = nullptr;
+static SimWebSocketHook webSocketHook = nullptr;
+
+// 共享缓冲：引用计数归零时释放；live/peak 字节用于比较每客户端复制与共享的内存占用
+struct HalWsBuffer {
+  std::atomic<int> refs;
+  size_t length;
+  uint8_t data[1];
+};
+
+// 传输层中的帧按客户端带宽依次收完，收完时释放传输层的引用
+struct SimWsInFlight {
+  HalWsBuffer* buffer;
+  bool binary;
+  uint64_t doneAt;
+};
+
+struct SimWsClient {
+  uint32_t bytesPerSecond;
+  size_t queuedBytes;
+  uint64_t busyUntil;  // 已交给传输层的帧全部收完的时刻
+  std::deque<SimWsInFlight> inFlight;
+  SimWsClientStats stats;
+};
+static std::map<uint32_t, SimWsClient> wsClients;
+static uint32_t nextWsClientId = 1;
+static uint32_t wsLiveBuffers = 0;  // 不随 simReset() 清零：上一次运行留在队列里的缓冲之后才释放
+static uint64_t wsLiveBytes = 0;
+
+static void updateWebSocketMemory();
+static void closeWebSocketClient(SimWsClient& client);
+
+static bool wifiAvailable = true;
+static SimWiFiTiming wifiTiming = {2500, 500, 300};
+static const HalWiFiLink SIM_AP_LINK = {
+  {0x02, 0x00, 0x00, 0x00, 0x00, 0x01}, 6, 0,
+  0x0A01A8C0, 0x0101A8C0, 0x00FFFFFF, 0x0101A8C0  // 192.168.1.10/24，网关/DNS 192.168.1.1
+};
+static uint8_t wifiNotifyTask = HAL_MAIN_TASK;
+static std::atomic<int> wifiStatus(HAL_WIFI_IDLE);
+static std::atomic<bool> wifiEvent(false);
+static bool wifiPending = false;
+static bool wifiPowerSaveIdle = false;
+static uint64_t wifiResolveAt = 0;
+static HalWiFiStatus wifiResolveTo = HAL_WIFI_IDLE;
+
+// NVS 模拟 flash：simReset() 不清除，用于模拟重启后的快速重连
+static std::map<std::string, std::vector<uint8_t> > nvsStore;
+
+// 模拟 Update：只由 OTA 写入任务调用，--ota 的主线程在会话之间（写入任务空闲时）读取结果、注入故障
+static SimOTATiming otaTiming = {0, 0};
+static SimOTAFault otaFault = SIM_OTA_FAULT_NONE;
+static size_t otaFaultOffset = 0;
+static bool otaActive = false;
+static size_t otaExpected = 0;
+static std::vector<uint8_t> otaImage;     // 正在写入的分区内容
+static std::vector<uint8_t> otaBooted;    // 已切换为启动分区的镜像
+static const char* otaError = "No Error";
+
+static SimCounters counters;
+
+// ==================== 虚拟时钟 ====================
+uint64_t simNowMicros() {
+  if (realTime) {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now() - realTimeEpoch).count();
+  }
+  return simMicros.load();
+}
+
+static bool takeNotification(uint8_t task) {
+  std::lock_guard<std::mutex> lock(notifyMutex);
+  bool notified = taskNotified[task];
+  taskNotified[task] = false;
+  return notified;
+}
+
+// 把虚拟时钟推进到 target，途中按时间顺序触发预定的引脚变化；
+// stopOnNotify 时一旦当前任务被通知就停在那个时刻
+static void advanceVirtual(uint64_t target, bool stopOnNotify) {
+  while (!scheduledEvents.empty() && scheduledEvents.begin()->first <= target) {
+    auto next = scheduledEvents.begin();
+    uint64_t at = next->first;
+    std::function<void()> fire = next->second;
+    scheduledEvents.erase(next);
+
+    if (at > simMicros) {
+      simMicros = at;
+    }
+    fire();
+    if (stopOnNotify && takeNotification(currentTask)) {
+      return;
+    }
+  }
+  if (target > simMicros) {
+    simMicros = target;
+  }
+}
+
+void simAdvanceMicros(uint64_t us) {
+  if (realTime) {
+    std::this_thread::sleep_for(std::chrono::microseconds(us));
+  } else {
+    advanceVirtual(simMicros + us, false);
+  }
+}
+
+static void scheduleEvent(uint64_t atMicros, std::function<void()> fire) {
+  if (!realTime) {
+    scheduledEvents.emplace(atMicros, fire);
+  }
+}
+
+void simSchedulePin(uint8_t pin, int level, uint64_t atMicros) {
+  scheduleEvent(atMicros, [pin, level]() { simSetPinAt(pin, level, simMicros); });
+}
+
+void simSetRealTime(bool enabled) {
+  realTime = enabled;
+  realTimeEpoch = std::chrono::steady_clock::now();
+}
+
+void simReset() {
+  simMicros = 0;
+  scheduledEvents.clear();
+  randomEngine.seed(1);
+  for (int i = 0; i < HAL_MAX_TASKS; i++) {
+    taskNotified[i] = false;
+  }
+  for (int i = 0; i < HAL_MAX_SIGNALS; i++) {
+    signalGiven[i] = false;
+  }
+  for (int i = 0; i < SIM_NUM_PINS; i++) {
+    pinLevels[i] = HIGH;  // 上拉输入，默认未按下
+    pinHandlers[i] = nullptr;
+  }
+  wifiAvailable = true;
+  wifiStatus = HAL_WIFI_IDLE;
+  wifiEvent = false;
+  wifiPending = false;
+  wifiPowerSaveIdle = false;
+  brokerState = SIM_BROKER_UP;
+  mqttConnected = false;
+  mqttConnectStatus = HAL_MQTT_CONNECT_IDLE;
+  mqttEvent = false;
+  mqttState = -1;
+  mqttSubscriptionCount = 0;
+  mqttInbound.clear();
+  publishHook = nullptr;
+  webSocketHook = nullptr;
+  webSocketTextHook = nullptr;
+  udpHook = nullptr;
+  for (auto& entry : wsClients) {
+    closeWebSocketClient(entry.second);
+  }
+  wsClients.clear();
+  nextWsClientId = 1;
+  serialBaud = 0;
+  serialBusyUntil = 0;
+  serialBlockedUntil = 0;
+  ledEvent = false;
+  lightSleeping = false;
+  for (SimLEDChannel& channel : ledChannels) {
+    channel.sending = false;
+    channel.frame = nullptr;
+    channel.displayed.clear();
+  }
+  otaFault = SIM_OTA_FAULT_NONE;
+  otaActive = false;
+  otaImage.clear();
+  otaBooted.clear();
+  memset(&counters, 0, sizeof(counters));
+  updateWebSocketMemory();
+}
+
+unsigned long halMillis() {
+  return (unsigned long)(simNowMicros() / 1000);
+}
+
+unsigned long halMicros() {
+  return (unsigned long)simNowMicros();
+}
+
+void halDelay(unsigned long ms) {
+  simAdvanceMicros((uint64_t)ms * 1000);
+}
+
+// 周期计数器总是取真实时间：虚拟时钟在代码运行期间不走，测不出逻辑本身的耗时
+uint32_t halCycleCount() {
+  return (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+uint32_t halCyclesToNanos(uint32_t cycles) {
+  return cycles;
+}
+
+uint32_t halRandom() {
+  return randomEngine();
+}
+
+// ==================== GPIO ====================
+void simSetPin(uint8_t pin, int level) {
+  simSetPinAt(pin, level, simNowMicros());
+}
+
+void simSetPinAt(uint8_t pin, int level, uint64_t atMicros) {
+  if (pin >= SIM_NUM_PINS || pinLevels[pin] == level) {
+    return;
+  }
+  pinLevels[pin] = level;
+  if (pinHandlers[pin] && !lightSleeping) {
+    pinHandlers[pin](pinHandlerIndex[pin], level, (uint32_t)atMicros);
+  }
+}
+
+int simGetPin(uint8_t pin) {
+  return pin < SIM_NUM_PINS ? pinLevels[pin].load() : HIGH;
+}
+
+void halPinModeInputPullup(uint8_t pin) {
+  if (pin < SIM_NUM_PINS) {
+    pinLevels[pin] = HIGH;
+  }
+}
+
+int halDigitalRead(uint8_t pin) {
+  return simGetPin(pin);
+}
+
+uint64_t halReadGPIOInputs() {
+  uint64_t levels = 0;
+  for (int i = 0; i < SIM_NUM_PINS; i++) {
+    if (pinLevels[i] != LOW) {
+      levels |= 1ULL << i;
+    }
+  }
+  return levels;
+}
+
+void halAttachPinChange(uint8_t pin, uint8_t index, HalPinChangeHandler handler) {
+  if (pin < SIM_NUM_PINS) {
+    pinHandlers[pin] = handler;
+    pinHandlerIndex[pin] = index;
+  }
+}
+
+// ==================== LED灯带 ====================
+void simSetLEDWireTiming(bool enabled) {
+  ledWireTiming = enabled;
+}
+
+// 各通道独立地在 doneAt 完成（与 WiFi 相同：实时模式惰性结算，虚拟时钟模式另预定事件唤醒任务），
+// 最后一个发送中的通道完成时发出帧完成信号。
+// 完成时把帧缓冲与开始发送时的内容比较：调用方在发送期间改写了它就是一次撕裂。
+static void resolveLED() {
+  bool finished = false;
+  bool sending = false;
+  for (uint8_t c = 0; c < ledChannelCount; c++) {
+    SimLEDChannel& channel = ledChannels[c];
+    if (channel.sending && simNowMicros() >= channel.doneAt) {
+      channel.sending = false;
+      if (memcmp(channel.frame, channel.frameAtStart.data(), channel.frameAtStart.size()) != 0) {
+        counters.ledTornFrames++;
+      }
+      channel.displayed = channel.frameAtStart;
+      finished = true;
+    }
+    sending |= channel.sending;
+  }
+  if (finished && !sending) {
+    ledEvent = true;
+    halNotifyTask(ledNotifyTask);
+  }
+}
+
+void halLEDBegin(const HalLEDChannel* channels, uint8_t count, uint8_t notifyTask) {
+  (void)channels;
+  ledChannelCount = count;
+  ledNotifyTask = notifyTask;
+}
+
+// 先把本轮的所有通道标记为发送中，再预定完成事件：先启动的通道不会在其余通道启动前单独给出帧完成信号
+void halLEDTransmit(const HalLEDSpan* spans, uint8_t count) {
+  uint64_t now = simNowMicros();
+  for (uint8_t c = 0; c < count && c < ledChannelCount; c++) {
+    if (spans[c].length == 0) {
+      continue;
+    }
+    SimLEDChannel& channel = ledChannels[c];
+    if (channel.sending) {
+      counters.ledOverlaps++;  // 调用方没有等 halLEDBusy() 变为 false：真机上会打断上一帧
+    }
+    counters.ledShows++;
+    uint64_t wire = (uint64_t)(spans[c].length / 3) * SIM_LED_MICROS_PER_PIXEL + SIM_LED_RESET_MICROS;
+    counters.ledWireMicros += wire;
+
+    channel.frame = spans[c].data;
+    channel.frameAtStart.assign(spans[c].data, spans[c].data + spans[c].length);
+    channel.sending = true;
+    channel.doneAt = now + (ledWireTiming ? wire : 0);
+  }
+  for (uint8_t c = 0; c < count && c < ledChannelCount; c++) {
+    if (spans[c].length > 0) {
+      scheduleEvent(ledChannels[c].doneAt, resolveLED);
+    }
+  }
+}
+
+bool halLEDBusy() {
+  resolveLED();
+  for (uint8_t c = 0; c < ledChannelCount; c++) {
+    if (ledChannels[c].sending) return true;
+  }
+  return false;
+}
+
+bool halLEDTakeEvent() {
+  resolveLED();
+  return ledEvent.exchange(false);
+}
+
+const uint8_t* simLEDDisplayed(uint8_t channel) {
+  return ledChannels[channel].displayed.empty() ? nullptr : ledChannels[channel].displayed.data();
+}
+
+// ==================== WiFi ====================
+// 连接在 wifiResolveAt 时刻完成：halWiFiStatus() 按时钟惰性结算（实时模式），
+// 虚拟时钟模式下另外预定一个事件，在那一刻唤醒等待的任务
+static void setWiFiStatus(HalWiFiStatus status) {
+  wifiStatus = status;
+  wifiEvent = true;
+  halNotifyTask(wifiNotifyTask);
+}
+
+static void resolveWiFi() {
+  if (wifiPending && simNowMicros() >= wifiResolveAt) {
+    wifiPending = false;
+    setWiFiStatus(wifiResolveTo);
+  }
+}
+
+void simSetWiFiAvailable(bool available) {
+  wifiAvailable = available;
+}
+
+void simSetWiFiTiming(const SimWiFiTiming& timing) {
+  wifiTiming = timing;
+}
+
+void simDropWiFi() {
+  wifiPending = false;
+  if (wifiStatus == HAL_WIFI_CONNECTED) {
+    mqttConnected = false;
+    mqttState = -3;  // MQTT_CONNECTION_LOST
+    setWiFiStatus(HAL_WIFI_FAILED);
+  }
+}
+
+bool simWiFiPowerSaveIdle() {
+  return wifiPowerSaveIdle;
+}
+
+void halWiFiInit(uint8_t notifyTask) {
+  wifiNotifyTask = notifyTask;
+}
+
+void halWiFiBegin(const char* ssid, const char* password, const HalWiFiLink* link) {
+  (void)ssid;
+  (void)password;
+  counters.wifiConnectAttempts++;
+
+  uint32_t delayMs;
+  if (!wifiAvailable) {
+    delayMs = wifiTiming.scanMs;
+    wifiResolveTo = HAL_WIFI_FAILED;
+  } else if (link) {
+    // 缓存的链路参数与 AP 一致才能直连；否则像真机一样在指定信道上找不到 AP 而失败
+    bool match = memcmp(link->bssid, SIM_AP_LINK.bssid, sizeof(link->bssid)) == 0 &&
+                 link->channel == SIM_AP_LINK.channel && link->ip == SIM_AP_LINK.ip;
+    delayMs = wifiTiming.cachedMs;
+    wifiResolveTo = match ? HAL_WIFI_CONNECTED : HAL_WIFI_FAILED;
+  } else {
+    delayMs = wifiTiming.scanMs + wifiTiming.dhcpMs;
+    wifiResolveTo = HAL_WIFI_CONNECTED;
+  }
+
+  wifiStatus = HAL_WIFI_CONNECTING;
+  wifiPending = true;
+  wifiResolveAt = simNowMicros() + (uint64_t)delayMs * 1000;
+  scheduleEvent(wifiResolveAt, resolveWiFi);
+}
+
+void halWiFiDisconnect() {
+  wifiPending = false;
+  wifiStatus = HAL_WIFI_IDLE;
+}
+
+HalWiFiStatus halWiFiStatus() {
+  resolveWiFi();
+  return (HalWiFiStatus)wifiStatus.load();
+}
+
+bool halWiFiTakeEvent() {
+  return wifiEvent.exchange(false);
+}
+
+bool halWiFiReadLink(HalWiFiLink& link) {
+  if (halWiFiStatus() != HAL_WIFI_CONNECTED) {
+    return false;
+  }
+  link = SIM_AP_LINK;
+  return true;
+}
+
+bool halWiFiConnected() {
+  return halWiFiStatus() == HAL_WIFI_CONNECTED;
+}
+
+String halWiFiLocalIP() {
+  return String("127.0.0.1");
+}
+
+void halWiFiSetPowerSave(bool idle) {
+  wifiPowerSaveIdle = idle;
+}
+
+// ==================== NVS ====================
+void simNVSClear() {
+  nvsStore.clear();
+}
+
+bool halNVSLoad(const char* key, void* data, size_t length) {
+  auto it = nvsStore.find(key);
+  if (it == nvsStore.end() || it->second.size() != length) {
+    return false;
+  }
+  memcpy(data, it->second.data(), length);
+  return true;
+}
+
+bool halNVSStore(const char* key, const void* data, size_t length) {
+  const uint8_t* bytes = (const uint8_t*)data;
+  nvsStore[key].assign(bytes, bytes + length);
+  counters.nvsWrites++;
+  return true;
+}
+
+// ==================== 文件系统 ====================
+// 与 NVS 一样不随 simReset() 清除
+static std::map<std::string, std::string> files;
+
+void simWriteFile(const char* path, const char* text) {
+  if (text) {
+    files[path] = text;
+  } else {
+    files.erase(path);
+  }
+}
+
+static void countFileOp() {
+  if (inMQTTCallback) {
+    counters.fileOpsInMQTTCallback++;
+  }
+}
+
+int32_t halFileRead(const char* path, char* buffer, size_t capacity) {
+  countFileOp();
+  auto it = files.find(path);
+  if (it == files.end() || it->second.size() > capacity) {
+    return -1;
+  }
+  memcpy(buffer, it->second.data(), it->second.size());
+  return (int32_t)it->second.size();
+}
+
+bool halFileWrite(const char* path, const char* data, size_t length) {
+  countFileOp();
+  files[path].assign(data, length);
+  return true;
+}
+
+bool halFileAppend(const char* path, const char* data, size_t length) {
+  countFileOp();
+  files[path].append(data, length);
+  return true;
+}
+
+// ==================== 数据分区 ====================
+// simSetPartitionFile() 把分区绑定到一个文件：整个文件 mmap(MAP_SHARED) 只读映射，擦除/写入用 pwrite()，
+// 经同一页缓存立即反映在映射中。写入按 NOR flash 的规则只能把 1 清成 0（没有先擦除的字节写坏而不是覆盖）。
+// 与 NVS 一样不随 simReset() 清除
+struct SimPartition {
+  std::string label;
+  int fd;
+  size_t size;
+  const uint8_t* data;
+};
+
+static std::vector<SimPartition> partitions;
+
+static SimPartition* findPartition(const char* label) {
+  for (SimPartition& p : partitions) {
+    if (p.label == label) {
+      return &p;
+    }
+  }
+  return nullptr;
+}
+
+bool simSetPartitionFile(const char* label, const char* path, size_t size) {
+  SimPartition* old = findPartition(label);
+  if (old) {
+    munmap((void*)old->data, old->size);
+    close(old->fd);
+    partitions.erase(partitions.begin() + (old - partitions.data()));
+  }
+  if (!path) {
+    return true;
+  }
+  int fd = open(path, O_RDWR | O_CREAT, 0644);
+  struct stat st;
+  if (fd < 0 || fstat(fd, &st) != 0) {
+    return false;
+  }
+  // 文件不足分区大小的部分为擦除状态
+  std::vector<uint8_t> erased(HAL_FLASH_SECTOR_SIZE, 0xFF);
+  for (size_t at = (size_t)st.st_size; at < size; at += erased.size()) {
+    size_t n = std::min(erased.size(), size - at);
+    if (pwrite(fd, erased.data(), n, (off_t)at) != (ssize_t)n) {
+      close(fd);
+      return false;
+    }
+  }
+  void* data = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+  if (data == MAP_FAILED) {
+    close(fd);
+    return false;
+  }
+  partitions.push_back(SimPartition{label, fd, size, (const uint8_t*)data});
+  return true;
+}
+
+const uint8_t* halPartitionMap(const char* label, size_t& size) {
+  SimPartition* p = findPartition(label);
+  if (!p) {
+    return nullptr;
+  }
+  size = p->size;
+  return p->data;
+}
+
+bool halPartitionErase(const char* label, size_t offset, size_t length) {
+  SimPartition* p = findPartition(label);
+  if (!p || offset % HAL_FLASH_SECTOR_SIZE || length % HAL_FLASH_SECTOR_SIZE || offset + length > p->size) {
+    return false;
+  }
+  std::vector<uint8_t> erased(length, 0xFF);
+  counters.partitionErasedBytes += length;
+  return pwrite(p->fd, erased.data(), length, (off_t)offset) == (ssize_t)length;
+}
+
+bool halPartitionWrite(const char* label, size_t offset, const void* data, size_t length) {
+  SimPartition* p = findPartition(label);
+  if (!p || offset + length > p->size) {
+    return false;
+  }
+  std::vector<uint8_t> bits(p->data + offset, p->data + offset + length);
+  const uint8_t* in = (const uint8_t*)data;
+  for (size_t i = 0; i < length; i++) {
+    bits[i] &= in[i];
+  }
+  counters.partitionWrittenBytes += length;
+  return pwrite(p->fd, bits.data(), length, (off_t)offset) == (ssize_t)length;
+}
+
+// ==================== 固件更新 ====================
+void simSetOTATiming(const SimOTATiming& timing) {
+  otaTiming = timing;
+}
+
+void simInjectOTAFault(SimOTAFault fault, size_t offset) {
+  otaFault = fault;
+  otaFaultOffset = offset;
+}
+
+const uint8_t* simOTAImage(size_t& length) {
+  length = otaBooted.size();
+  return otaBooted.empty() ? nullptr : otaBooted.data();
+}
+
+static bool takeOTAFault(SimOTAFault fault) {
+  if (otaFault != fault) {
+    return false;
+  }
+  otaFault = SIM_OTA_FAULT_NONE;
+  return true;
+}
+
+// 错误文本与 Arduino Update 的 errorString() 相同
+static bool failOTA(const char* error) {
+  otaError = error;
+  otaActive = false;
+  otaImage.clear();
+  return false;
+}
+
+bool halOTABegin(size_t size) {
+  if (otaActive) {
+    return failOTA("Already Running");
+  }
+  if (size == 0 || size > SIM_OTA_PARTITION_SIZE) {
+    return failOTA("Not Enough Space");
+  }
+  if (takeOTAFault(SIM_OTA_FAULT_BEGIN)) {
+    return failOTA("Flash Erase Failed");
+  }
+  otaActive = true;
+  otaExpected = size;
+  otaImage.clear();
+  otaImage.reserve(size);
+  otaError = "No Error";
+  return true;
+}
+
+bool halOTAWrite(const uint8_t* data, size_t length) {
+  if (!otaActive) {
+    return false;
+  }
+  size_t offset = otaImage.size();
+  if (offset + length > otaExpected) {
+    return failOTA("Bad Size Given");
+  }
+  if (offset == 0 && length > 0 && data[0] != 0xE9) {
+    return failOTA("Magic byte is wrong, not 0xE9");
+  }
+  if (otaFault == SIM_OTA_FAULT_WRITE && otaFaultOffset < offset + length && takeOTAFault(SIM_OTA_FAULT_WRITE)) {
+    return failOTA("Flash Write Failed");
+  }
+  uint32_t sectors = (uint32_t)((offset + length + HAL_FLASH_SECTOR_SIZE - 1) / HAL_FLASH_SECTOR_SIZE -
+                                (offset + HAL_FLASH_SECTOR_SIZE - 1) / HAL_FLASH_SECTOR_SIZE);
+  uint64_t busy = (uint64_t)sectors * otaTiming.eraseMicros + (uint64_t)length * otaTiming.writeMicrosPerKB / 1024;
+  if (busy > 0) {
+    simAdvanceMicros(busy);
+  }
+  otaImage.insert(otaImage.end(), data, data + length);
+  counters.otaSectorsErased += sectors;
+  counters.otaBytesWritten += length;
+  counters.otaFlashMicros += busy;
+  return true;
+}
+
+bool halOTAEnd() {
+  if (!otaActive) {
+    return false;
+  }
+  if (otaImage.size() != otaExpected) {
+    return failOTA("Premature end of image");
+  }
+  if (takeOTAFault(SIM_OTA_FAULT_END)) {
+    return failOTA("Could Not Activate The Firmware");
+  }
+  otaBooted.swap(otaImage);
+  otaImage.clear();
+  otaActive = false;
+  counters.otaBootSwitches++;
+  return true;
+}
+
+void halOTAAbort() {
+  if (otaActive) {
+    counters.otaAborts++;
+  }
+  otaActive = false;
+  otaImage.clear();
+  otaError = "Aborted";
+}
+
+const char* halOTAError() {
+  return otaError;
+}
+
+void halRestart() {
+  counters.restarts++;
+  counters.lastRestartMicros = simNowMicros();
+}
+
+// ==================== 保留内存 ====================
+// 与 NVS 一样不随 simReset() 清除，simPowerCycle() 模拟掉电后的随机内容
+static uint32_t retainedMemory[HAL_RETAINED_SIZE / sizeof(uint32_t)];
+
+void simPowerCycle() {
+  for (uint32_t& word : retainedMemory) {
+    word = (uint32_t)randomEngine();
+  }
+}
+
+void* halRetainedMemory() {
+  return retainedMemory;
+}
+
+// ==================== MQTT ====================
+void simSetMQTTBroker(SimBrokerState state) {
+  brokerState = state;
+  if (state != SIM_BROKER_UP) {
+    mqttConnected = false;
+    mqttState = -3;  // MQTT_CONNECTION_LOST
+  }
+}
+
+void simSetMQTTConnectTimeout(uint32_t ms) {
+  mqttConnectTimeoutMs = ms;
+}
+
+void simSetPublishHook(SimPublishHook hook) {
+  publishHook = hook;
+}
+
+void simSetWebSocketTextHook(SimTextHook hook) {
+  webSocketTextHook = hook;
+}
+
+void simSetUDPHook(SimTextHook hook) {
+  udpHook = hook;
+}
+
+void simSetWebSocketHook(SimWebSocketHook hook) {
+  webSocketHook = hook;
+}
+
+void simMQTTDeliver(const char* topic, const uint8_t* payload, unsigned int length) {
+  if (!mqttConnected || !mqttCallback) {
+    return;
+  }
+  for (uint8_t i = 0; i < mqttSubscriptionCount; i++) {
+    if (topicMatchesFilter(mqttSubscriptions[i].c_str(), topic, strlen(topic))) {
+      char topicCopy[128];
+      uint8_t payloadCopy[MQTT_BUFFER_SIZE];
+      snprintf(topicCopy, sizeof(topicCopy), "%s", topic);
+      unsigned int n = length < sizeof(payloadCopy) ? length : sizeof(payloadCopy);
+      memcpy(payloadCopy, payload, n);
+      inMQTTCallback = true;
+      mqttCallback(topicCopy, payloadCopy, n);
+      inMQTTCallback = false;
+      return;
+    }
+  }
+}
+
+void halMQTTBegin(const char* server, uint16_t port, HalMQTTCallback callback, uint8_t notifyTask) {
+  (void)server;
+  (void)port;
+  mqttCallback = callback;
+  mqttNotifyTask = notifyTask;
+}
+
+// 连接结果在 mqttResolveAt 时刻给出，结算方式与 WiFi 相同；连接过程不推进时钟
+static void resolveMQTTConnect() {
+  if (mqttConnectStatus != HAL_MQTT_CONNECT_PENDING || simNowMicros() < mqttResolveAt) {
+    return;
+  }
+  if (mqttResolveOK && brokerState == SIM_BROKER_UP && wifiStatus == HAL_WIFI_CONNECTED) {
+    mqttConnected = true;
+    mqttState = 0;  // MQTT_CONNECTED
+    mqttSubscriptionCount = 0;
+    mqttConnectStatus = HAL_MQTT_CONNECT_DONE;
+  } else {
+    mqttState = -2;  // MQTT_CONNECT_FAILED
+    mqttConnectStatus = HAL_MQTT_CONNECT_FAILED;
+  }
+  mqttEvent = true;
+  halNotifyTask(mqttNotifyTask);
+}
+
+void halMQTTConnectAsync(const char* clientId) {
+  (void)clientId;
+  if (mqttConnectStatus == HAL_MQTT_CONNECT_PENDING) {
+    return;
+  }
+  counters.mqttConnectAttempts++;
+
+  uint32_t delayMs;
+  switch (brokerState) {
+    case SIM_BROKER_UP:
+      delayMs = mqttConnectLatencyMs;
+      mqttResolveOK = true;
+      break;
+    case SIM_BROKER_BLACKHOLE:
+      delayMs = mqttConnectTimeoutMs;  // SYN 无响应，等到超时
+      mqttResolveOK = false;
+      break;
+    case SIM_BROKER_REFUSED:
+    default:
+      delayMs = mqttConnectLatencyMs / 2;  // RST
+      mqttResolveOK = false;
+      break;
+  }
+  mqttConnectStatus = HAL_MQTT_CONNECT_PENDING;
+  mqttResolveAt = simNowMicros() + (uint64_t)delayMs * 1000;
+  scheduleEvent(mqttResolveAt, resolveMQTTConnect);
+}
+
+HalMQTTConnectStatus halMQTTConnectStatus() {
+  resolveMQTTConnect();
+  return (HalMQTTConnectStatus)mqttConnectStatus.load();
+}
+
+bool halMQTTTakeEvent() {
+  return mqttEvent.exchange(false);
+}
+
+bool halMQTTConnected() {
+  return mqttConnected;
+}
+
+int halMQTTState() {
+  return mqttState;
+}
+
+bool halMQTTSubscribe(const char* topic) {
+  if (!mqttConnected || mqttSubscriptionCount >= SIM_MQTT_MAX_SUBSCRIPTIONS) {
+    return false;
+  }
+  mqttSubscriptions[mqttSubscriptionCount++] = topic;
+  return true;
+}
+
+bool halMQTTPublish(const char* topic, const char* payload) {
+  if (!mqttConnected) {
+    return false;
+  }
+  counters.mqttPublishes++;
+  if (publishHook) {
+    publishHook(topic, payload, simNowMicros());
+  }
+  for (uint8_t i = 0; i < mqttSubscriptionCount; i++) {
+    if (topicMatchesFilter(mqttSubscriptions[i].c_str(), topic, strlen(topic))) {
+      mqttInbound.push_back(SimInbound{simNowMicros() + mqttEchoLatencyMs * 1000ULL, topic, payload});
+      break;
+    }
+  }
+  return true;
+}
+
+void halMQTTLoop() {
+  while (!mqttInbound.empty() && mqttInbound.front().deliverAt <= simNowMicros()) {
+    SimInbound message = mqttInbound.front();
+    mqttInbound.pop_front();
+    simMQTTDeliver(message.topic.c_str(), (const uint8_t*)message.payload.data(),
+                   (unsigned int)message.payload.size());
+  }
+}
+
+// ==================== UDP ====================
+bool halUDPSend(const char* host, uint16_t port, const uint8_t* data, size_t length) {
+  (void)host;
+  (void)port;
+  if (!halWiFiConnected()) {
+    return false;
+  }
+  counters.udpPackets++;
+  counters.udpBytes += length;
+  if (udpHook) {
+    udpHook((const char*)data, length);
+  }
+  return true;
+}
+
+// ==================== WebSocket ====================
+static void updateWebSocketMemory() {
+  counters.wsBuffersLive = wsLiveBuffers;
+  counters.wsBufferBytes = wsLiveBytes;
+  if (wsLiveBytes > counters.wsBufferBytesPeak) {
+    counters.wsBufferBytesPeak = wsLiveBytes;
+  }
+}
+
+HalWsBuffer* halWebSocketAllocate(const uint8_t* data, size_t length) {
+  HalWsBuffer* buffer = (HalWsBuffer*)malloc(sizeof(HalWsBuffer) + length);
+  if (!buffer) {
+    return nullptr;
+  }
+  new (&buffer->refs) std::atomic<int>(1);
+  buffer->length = length;
+  memcpy(buffer->data, data, length);
+  counters.wsBuffers++;
+  wsLiveBuffers++;
+  wsLiveBytes += length;
+  updateWebSocketMemory();
+  return buffer;
+}
+
+void halWebSocketRetain(HalWsBuffer* buffer) {
+  buffer->refs.fetch_add(1, std::memory_order_relaxed);
+}
+
+void halWebSocketRelease(HalWsBuffer* buffer) {
+  if (buffer->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+    wsLiveBuffers--;
+    wsLiveBytes -= buffer->length;
+    updateWebSocketMemory();
+    free(buffer);
+  }
+}
+
+static void resolveWebSocketClient(SimWsClient& client) {
+  while (!client.inFlight.empty() && client.inFlight.front().doneAt <= simNowMicros()) {
+    SimWsInFlight frame = client.inFlight.front();
+    client.inFlight.pop_front();
+    HalWsBuffer* buffer = frame.buffer;
+    client.queuedBytes -= buffer->length;
+    client.stats.frames++;
+    client.stats.bytes += buffer->length;
+    counters.wsFrames++;
+    counters.wsBytes += buffer->length;
+    if (frame.binary) {
+      size_t n = buffer->length < sizeof(client.stats.lastBinary) ? buffer->length
+                                                                    : sizeof(client.stats.lastBinary);
+      memcpy(client.stats.lastBinary, buffer->data, n);
+      client.stats.lastBinaryLength = (uint8_t)n;
+      if (webSocketHook) {
+        webSocketHook(buffer->data, buffer->length, frame.doneAt);
+      }
+    } else if (webSocketTextHook) {
+      webSocketTextHook((const char*)buffer->data, buffer->length);
+    }
+    halWebSocketRelease(buffer);
+  }
+}
+
+static void resolveWebSocket() {
+  for (auto& entry : wsClients) {
+    resolveWebSocketClient(entry.second);
+  }
+}
+
+static void closeWebSocketClient(SimWsClient& client) {
+  for (SimWsInFlight& frame : client.inFlight) {
+    halWebSocketRelease(frame.buffer);  // 连接关闭，未发完的消息随之释放
+  }
+  client.inFlight.clear();
+  client.queuedBytes = 0;
+  if (client.stats.open) {
+    client.stats.open = false;
+    client.stats.closedAtMicros = simNowMicros();
+  }
+}
+
+uint32_t simWebSocketConnect(uint32_t bytesPerSecond) {
+  uint32_t id = nextWsClientId++;
+  SimWsClient& client = wsClients[id];
+  client.bytesPerSecond = bytesPerSecond;
+  client.queuedBytes = 0;
+  client.busyUntil = 0;
+  memset(&client.stats, 0, sizeof(client.stats));
+  client.stats.open = true;
+  return id;
+}
+
+void simWebSocketDisconnect(uint32_t id) {
+  auto it = wsClients.find(id);
+  if (it != wsClients.end()) {
+    resolveWebSocketClient(it->second);
+    closeWebSocketClient(it->second);
+  }
+}
+
+SimWsClientStats simWebSocketClient(uint32_t id) {
+  auto it = wsClients.find(id);
+  if (it == wsClients.end()) {
+    SimWsClientStats none;
+    memset(&none, 0, sizeof(none));
+    return none;
+  }
+  resolveWebSocketClient(it->second);
+  return it->second.stats;
+}
+
+bool halWebSocketCanSend(uint32_t clientId) {
+  auto it = wsClients.find(clientId);
+  if (it == wsClients.end() || !it->second.stats.open) {
+    return false;
+  }
+  resolveWebSocketClient(it->second);
+  return it->second.queuedBytes < SIM_WS_SEND_WINDOW && it->second.inFlight.size() < SIM_WS_MAX_QUEUED;
+}
+
+bool halWebSocketSend(uint32_t clientId, HalWsBuffer* buffer, bool binary) {
+  auto it = wsClients.find(clientId);
+  if (it == wsClients.end() || !it->second.stats.open) {
+    return false;
+  }
+  SimWsClient& client = it->second;
+  uint64_t start = std::max(simNowMicros(), client.busyUntil);
+  uint64_t wire = client.bytesPerSecond ? (uint64_t)buffer->length * 1000000 / client.bytesPerSecond : 0;
+  client.busyUntil = start + wire;
+  halWebSocketRetain(buffer);
+  client.inFlight.push_back(SimWsInFlight{buffer, binary, client.busyUntil});
+  client.queuedBytes += buffer->length;
+  if (wire == 0) {
+    resolveWebSocketClient(client);
+  } else {
+    scheduleEvent(client.busyUntil, resolveWebSocket);
+  }
+  return true;
+}
+
+void halWebSocketClose(uint32_t clientId) {
+  auto it = wsClients.find(clientId);
+  if (it != wsClients.end()) {
+    closeWebSocketClient(it->second);
+  }
+}
+
+void halWebSocketCleanup() {
+}
+
+// ==================== 低功耗 ====================
+// 虚拟时钟推进到 durationMicros 之后，途中按时间顺序触发预定的事件；唤醒引脚的电平一变就停在那个时刻。
+// 其他事件（LED 发送完成、WebSocket 客户端收完等）照常发生，它们的通知留到醒来后处理
+HalWakeCause halLightSleep(uint32_t durationMicros, const uint8_t* pins, const uint8_t* levels, uint8_t count) {
+  auto levelChanged = [pins, levels, count]() {
+    for (uint8_t i = 0; i < count; i++) {
+      if (simGetPin(pins[i]) != levels[i]) return true;
+    }
+    return false;
+  };
+  uint64_t start = simNowMicros();
+  HalWakeCause cause = HAL_WAKE_TIMER;
+  if (wifiPending) {
+    counters.lightSleepsConnecting++;
+  }
+  if (wifiStatus == HAL_WIFI_CONNECTED) {
+    counters.lightSleepsAssociated++;  // 真机上射频关闭、漏掉信标，会被 AP 断开
+  }
+  if (levelChanged()) {
+    cause = HAL_WAKE_GPIO;
+  } else if (realTime) {
+    std::this_thread::sleep_for(std::chrono::microseconds(durationMicros));
+  } else {
+    uint64_t target = simMicros + durationMicros;
+    lightSleeping = true;
+    while (!scheduledEvents.empty() && scheduledEvents.begin()->first <= target) {
+      auto next = scheduledEvents.begin();
+      std::function<void()> fire = next->second;
+      if (next->first > simMicros) {
+        simMicros = next->first;
+      }
+      scheduledEvents.erase(next);
+      fire();
+      if (levelChanged()) {
+        cause = HAL_WAKE_GPIO;
+        break;
+      }
+    }
+    lightSleeping = false;
+    if (cause == HAL_WAKE_TIMER && target > simMicros) {
+      simMicros = target;
+    }
+  }
+  counters.lightSleeps++;
+  counters.lightSleepMicros += simNowMicros() - start;
+  return cause;
+}
+
+// ==================== 任务 ====================
+static uint8_t resolveTask(uint8_t id) {
+  return (id < HAL_MAX_TASKS && taskStarted[id]) ? id : HAL_MAIN_TASK;
+}
+
+static void waitForNotify(uint8_t task, uint32_t timeoutMicros) {
+  if (!realTime) {
+    if (!takeNotification(task)) {
+      advanceVirtual(simMicros + timeoutMicros, true);
+    }
+    return;
+  }
+  std::unique_lock<std::mutex> lock(notifyMutex);
+  notifyCondition.wait_for(lock, std::chrono::microseconds(timeoutMicros), [task]() {
+    return taskNotified[task] || (task != HAL_MAIN_TASK && !tasksRunning);
+  });
+  taskNotified[task] = false;
+}
+
+void halStartTask(uint8_t id, const char* name, HalTaskFunction fn,
+                  uint32_t stackSize, uint8_t priority, uint8_t core) {
+  (void)name;
+  (void)stackSize;
+  (void)priority;
+  (void)core;
+  if (id == HAL_MAIN_TASK || id >= HAL_MAX_TASKS) {
+    return;
+  }
+  tasksRunning = true;
+  taskStarted[id] = true;
+  taskThreads[id] = std::thread([id, fn]() {
+    currentTask = id;
+    while (tasksRunning) {
+      uint32_t waitMicros = fn();
+      if (waitMicros > 0) {
+        waitForNotify(id, waitMicros);
+      }
+    }
+  });
+}
+
+void halNotifyTask(uint8_t id) {
+  std::lock_guard<std::mutex> lock(notifyMutex);
+  taskNotified[resolveTask(id)] = true;
+  notifyCondition.notify_all();
+}
+
+void halNotifyTaskFromISR(uint8_t id) {
+  halNotifyTask(id);
+}
+
+void halWaitForNotify(uint32_t timeoutMicros) {
+  waitForNotify(currentTask, timeoutMicros);
+}
+
+void halSignalGive(uint8_t id) {
+  std::lock_guard<std::mutex> lock(notifyMutex);
+  signalGiven[id] = true;
+  notifyCondition.notify_all();
+}
+
+static bool takeSignal(uint8_t id) {
+  std::lock_guard<std::mutex> lock(notifyMutex);
+  bool given = signalGiven[id];
+  signalGiven[id] = false;
+  return given;
+}
+
+bool halSignalTake(uint8_t id, uint32_t timeoutMicros) {
+  if (!realTime) {
+    if (takeSignal(id)) {
+      return true;
+    }
+    advanceVirtual(simMicros + timeoutMicros, false);  // 单线程：等待期间只有预定事件能给出信号
+    return takeSignal(id);
+  }
+  std::unique_lock<std::mutex> lock(notifyMutex);
+  bool given = notifyCondition.wait_for(lock, std::chrono::microseconds(timeoutMicros), [id]() { return signalGiven[id]; });
+  signalGiven[id] = false;
+  return given;
+}
+
+void simStopTasks() {
+  {
+    std::lock_guard<std::mutex> lock(notifyMutex);
+    tasksRunning = false;
+    notifyCondition.notify_all();
+  }
+  for (int i = 0; i < HAL_MAX_TASKS; i++) {
+    if (taskThreads[i].joinable()) {
+      taskThreads[i].join();
+    }
+    taskStarted[i] = false;
+  }
+}
+
+// ==================== 计数器 / Serial ====================
+const SimCounters& simCounters() {
+  return counters;
+}
+
+void simSetSerialEcho(bool enabled) {
+  serialEcho = enabled;
+}
+
+void simSetSerialBaud(uint32_t baud) {
+  std::lock_guard<std::mutex> lock(serialMutex);
+  serialBaud = baud;
+  serialBusyUntil = 0;
+  serialBlockedUntil = 0;
+}
+
+size_t NativeSerial::write(const uint8_t* data, size_t length) {
+  std::lock_guard<std::mutex> lock(serialMutex);
+  counters.serialBytes += length;
+  if (serialBaud > 0) {
+    // 线上按字节排队；调用方要等到剩余字节放得下发送缓冲区才返回。
+    // 虚拟时钟在调用期间不前进，重叠的阻塞区间只计一次
+    uint64_t now = simNowMicros() * 1000;
+    uint64_t byteNanos = 10000000000ULL / serialBaud;
+    serialBusyUntil = std::max(serialBusyUntil, now) + length * byteNanos;
+    uint64_t releaseAt = serialBusyUntil - std::min<uint64_t>(serialBusyUntil, SIM_SERIAL_TX_BUFFER * byteNanos);
+    uint64_t from = std::max(now, serialBlockedUntil);
+    if (releaseAt > from) {
+      counters.serialBlockedMicros += (releaseAt - from) / 1000;
+      serialBlockedUntil = releaseAt;
+    }
+  }
+  if (serialEcho) {
+    fwrite(data, 1, length, stdout);
+  }
+  return length;
+}
+
+size_t NativeSerial::write(uint8_t c) {
+  return write(&c, 1);
+}
+
+int NativeSerial::availableForWrite() {
+  std::lock_guard<std::mutex> lock(serialMutex);
+  uint64_t now = simNowMicros() * 1000;
+  if (serialBaud == 0 || serialBusyUntil <= now) {
+    return SIM_SERIAL_TX_BUFFER;
+  }
+  uint64_t byteNanos = 10000000000ULL / serialBaud;
+  uint64_t pending = (serialBusyUntil - now + byteNanos - 1) / byteNanos;
+  return pending < SIM_SERIAL_TX_BUFFER ? (int)(SIM_SERIAL_TX_BUFFER - pending) : 0;
+}
+
+size_t NativeSerial::print(const char* s) {
+  return write((const uint8_t*)s, strlen(s));
+}
+
+size_t NativeSerial::print(char c) {
+  char s[2] = {c, '\0'};
+  return print(s);
+}
+
+size_t NativeSerial::print(int value) {
+  return print(std::to_string(value).c_str());
+}
+
+size_t NativeSerial::print(unsigned int value) {
+  return print(std::to_string(value).c_str());
+}
+
+size_t NativeSerial::print(long value) {
+  return print(std::to_string(value).c_str());
+}
+
+size_t NativeSerial::print(unsigned long value) {
+  return print(std::to_string(value).c_str());
+}
+
+size_t NativeSerial::println() {
+  return print("\n");
+}
+
+size_t NativeSerial::printf(const char* format, ...) {
+  char buffer[256];
+  va_list args;
+  va_start(args, format);
+  vsnprintf(buffer, sizeof(buffer), format, args);
+  va_end(args);
+  return print(buffer);
+}
@@ -0,0 +1,159 @@
+#ifndef HAL_SIM_H
+#define HAL_SIM_H
+
+// ==================== 主机模拟后端控制接口 ====================
+// hal.h 的主机实现（hal_native.cpp）之上的控制面：
+// 驱动虚拟时钟、设置引脚电平、模拟 MQTT 服务器状态，并读取外设计数器。
+
+#include <stdint.h>
+#include <stddef.h>
+#include "config.h"
+
+enum SimBrokerState {
+  SIM_BROKER_UP,         // 连接立即成功
+  SIM_BROKER_REFUSED,    // 连接立即失败
+  SIM_BROKER_BLACKHOLE   // 连接阻塞到超时后失败
+};
+
+// 模拟 WiFi 连接耗时：无缓存时全信道扫描 + DHCP，有缓存（BSSID/信道/IP 租约）时直连
+struct SimWiFiTiming {
+  uint32_t scanMs;
+  uint32_t dhcpMs;
+  uint32_t cachedMs;
+};
+
+struct SimCounters {
+  uint32_t ledShows;          // 各通道的发送次数之和
+  uint64_t ledWireMicros;     // 各通道数据线上累计占用的虚拟时间之和
+  uint32_t ledTornFrames;     // 发送期间帧缓冲被改写的次数（应为 0）
+  uint32_t ledOverlaps;       // 上一帧未发完就开始下一帧的次数（应为 0）
+  uint32_t wifiConnectAttempts;
+  uint32_t nvsWrites;
+  uint32_t mqttConnectAttempts;
+  uint32_t mqttPublishes;
+  uint32_t wsFrames;           // 各客户端收完的帧数之和
+  uint64_t wsBytes;
+  uint32_t wsBuffers;          // 分配的共享缓冲（每个广播帧一次）
+  uint32_t wsBuffersLive;      // 尚未释放的共享缓冲
+  uint64_t wsBufferBytes;      // 尚未释放的共享缓冲字节数
+  uint64_t wsBufferBytesPeak;
+  uint32_t serialBytes;
+  uint64_t serialBlockedMicros;  // 发送缓冲区满时调用方被阻塞的时间（模拟波特率时）
+  uint32_t udpPackets;
+  uint64_t udpBytes;
+  uint32_t lightSleeps;
+  uint64_t lightSleepMicros;
+  uint32_t lightSleepsConnecting;  // WiFi 连接尝试进行中时进入的浅睡眠（应为 0）
+  uint32_t lightSleepsAssociated;  // WiFi 已连接时进入的浅睡眠（应为 0）
+  uint32_t fileOpsInMQTTCallback;  // MQTT 回调里的 halFileRead/Write/Append（应为 0）
+  uint64_t partitionErasedBytes;
+  uint64_t partitionWrittenBytes;
+  uint32_t otaSectorsErased;
+  uint64_t otaBytesWritten;
+  uint64_t otaFlashMicros;     // halOTAWrite() 按 simSetOTATiming() 阻塞调用方的时间
+  uint32_t otaBootSwitches;    // halOTAEnd() 成功
+  uint32_t otaAborts;
+  uint32_t restarts;           // halRestart()
+  uint64_t lastRestartMicros;
+};
+
+typedef void (*SimPublishHook)(const char* topic, const char* payload, uint64_t atMicros);
+typedef void (*SimWebSocketHook)(const uint8_t* data, size_t length, uint64_t atMicros);  // 二进制帧，客户端收完时调用
+typedef void (*SimTextHook)(const char* text, size_t length);
+
+// ==================== 虚拟时钟 ====================
+uint64_t simNowMicros();
+void simAdvanceMicros(uint64_t us);
+void simReset();
+// 实时模式：时间取自 steady_clock，halDelay() 真正休眠，用于多线程任务的压力测试。
+// halStartTask() 创建的线程只应在实时模式下使用。
+void simSetRealTime(bool enabled);
+
+// ==================== 引脚 ====================
+// 电平变化时同步调用 halAttachPinChange() 注册的处理函数，模拟 GPIO 中断
+void simSetPin(uint8_t pin, int level);
+void simSetPinAt(uint8_t pin, int level, uint64_t atMicros);
+// 虚拟时钟模式：预定在 atMicros 改变引脚电平，时间推进到该时刻时触发（会唤醒 halWaitForNotify()）
+void simSchedulePin(uint8_t pin, int level, uint64_t atMicros);
+int simGetPin(uint8_t pin);
+
+// ==================== 外设模型 ====================
+void simSetWiFiAvailable(bool available);  // 关闭后连接尝试在扫描超时后失败
+void simSetWiFiTiming(const SimWiFiTiming& timing);
+void simDropWiFi();                         // 模拟 AP 掉线
+bool simWiFiPowerSaveIdle();                // halWiFiSetPowerSave() 最近一次的参数
+void simNVSClear();                         // NVS 不随 simReset() 清除，模拟擦除 flash
+void simWriteFile(const char* path, const char* text);  // text 为 nullptr 时删除
+void simPowerCycle();                       // 保留内存同样不随 simReset() 清除，掉电后为随机值
+// 把数据分区绑定到文件（不存在时创建，不足 size 的部分填充为擦除状态 0xFF），path 为 nullptr 时解绑；
+// 未绑定的分区 halPartitionMap() 返回 nullptr。同样不随 simReset() 清除
+bool simSetPartitionFile(const char* label, const char* path, size_t size);
+
+// 模拟 Update：halOTAWrite() 写入内存中的应用分区（SIM_OTA_PARTITION_SIZE，与 partitions.csv 的 app 分区相同），
+// 镜像第一个字节必须是 ESP32 镜像魔数 0xE9，halOTAEnd() 要求写满 halOTABegin() 给出的长度。
+// 擦写耗时：每进入一个新扇区 eraseMicros，每 KB writeMicrosPerKB，调用方阻塞这么久
+// （实时模式下真的休眠，供 --ota 测流水线吞吐量）；默认为 0。
+// 故障注入：下一次会话中 begin 失败、写到 offset 所在的那次 halOTAWrite() 失败或 end 失败，只触发一次
+#define SIM_OTA_PARTITION_SIZE 0x140000
+
+struct SimOTATiming {
+  uint32_t eraseMicros;
+  uint32_t writeMicrosPerKB;
+};
+
+enum SimOTAFault {
+  SIM_OTA_FAULT_NONE,
+  SIM_OTA_FAULT_BEGIN,
+  SIM_OTA_FAULT_WRITE,
+  SIM_OTA_FAULT_END
+};
+
+void simSetOTATiming(const SimOTATiming& timing);
+void simInjectOTAFault(SimOTAFault fault, size_t offset);
+const uint8_t* simOTAImage(size_t& length);  // 最近一次切换启动分区的镜像，没有时返回 nullptr
+
+// 开启后 halLEDTransmit() 的发送按 WS281x 时序（30us/像素 + 280us 复位）持续，关闭时立即完成；
+// 两种情况下调用方都不阻塞，各通道同时发送
+void simSetLEDWireTiming(bool enabled);
+const uint8_t* simLEDDisplayed(uint8_t channel);  // 该通道最近一次发送完成的线上字节，尚未发送过为 nullptr
+void simSetMQTTBroker(SimBrokerState state);
+void simSetMQTTConnectTimeout(uint32_t ms);
+void simSetPublishHook(SimPublishHook hook);
+void simSetWebSocketHook(SimWebSocketHook hook);
+// 直接调用消息回调；发布到已订阅主题的消息另由模拟服务器 3 ms 后在 halMQTTLoop() 中回送
+void simMQTTDeliver(const char* topic, const uint8_t* payload, unsigned int length);
+void simSetSerialEcho(bool enabled);
+// 按波特率模拟串口：发送缓冲区 SIM_SERIAL_TX_BUFFER 字节按 baud/10 字节每秒排空，
+// 写入超出缓冲区时计入 serialBlockedMicros（真实 UART 上调用方会阻塞这么久）；0 表示不限速（默认）
+#define SIM_SERIAL_TX_BUFFER LOG_SERIAL_TX_BUFFER
+void simSetSerialBaud(uint32_t baud);
+void simSetWebSocketTextHook(SimTextHook hook);
+void simSetUDPHook(SimTextHook hook);
+
+// ==================== WebSocket 客户端 ====================
+// 模拟客户端按 bytesPerSecond 接收（0 为不限速），传输层最多缓存 SIM_WS_SEND_WINDOW 字节
+// （ESP32 lwIP 的 TCP 发送缓冲区）、SIM_WS_MAX_QUEUED 帧，缓存满时 halWebSocketCanSend() 返回 false，收完一帧时调用
+// simSetWebSocketHook / simSetWebSocketTextHook 的钩子。返回的 id 需交给 wsClientConnected()
+// （真机上由 Web 服务器的连接事件调用）。服务器端 halWebSocketClose() 后客户端不再接收。
+#define SIM_WS_SEND_WINDOW 5744
+#define SIM_WS_MAX_QUEUED 32  // AsyncWebSocket 每个客户端的消息队列上限（WS_MAX_QUEUED_MESSAGES）
+
+struct SimWsClientStats {
+  bool open;
+  uint32_t frames;
+  uint64_t bytes;
+  uint64_t closedAtMicros;
+  uint8_t lastBinary[16];  // 最近收完的二进制帧（前 16 字节）
+  uint8_t lastBinaryLength;
+};
+
+uint32_t simWebSocketConnect(uint32_t bytesPerSecond);
+void simWebSocketDisconnect(uint32_t id);  // 客户端主动断开，同样需交给 wsClientDisconnected()
+SimWsClientStats simWebSocketClient(uint32_t id);
+
+// 停止并回收 halStartTask() 创建的所有线程
+void simStopTasks();
+
+const SimCounters& simCounters();
+
+#endif // HAL_SIM_H
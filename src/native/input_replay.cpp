@@ -0,0 +1,189 @@
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include "input_replay.h"
+#include "input_trace.h"
+#include "ball.h"
+#include "led_compositor.h"
+#include "tasks.h"
+#include "hal_sim.h"
+
+// ==================== 输出收集 ====================
+// 模拟后端的钩子和调度器观察者都是函数指针，回放期间的状态放在文件级变量里
+static ReplayResult* current = nullptr;
+static uint64_t startMicros = 0;
+static uint32_t lastFrameHash = 0;
+static bool haveFrame = false;
+
+static uint32_t hashLEDs() {
+  uint32_t hash = 2166136261u;
+  const uint8_t* bytes = (const uint8_t*)leds;
+  for (size_t i = 0; i < (size_t)ledCount * sizeof(CRGB); i++) {
+    hash = (hash ^ bytes[i]) * 16777619u;
+  }
+  return hash;
+}
+
+static void observeJob(const Job& job, bool finished) {
+  if (!finished || job.run != updateLEDController) {
+    return;
+  }
+  current->frames++;
+  uint32_t hash = hashLEDs();
+  if (haveFrame && hash == lastFrameHash) {
+    return;
+  }
+  haveFrame = true;
+  lastFrameHash = hash;
+  char line[48];
+  snprintf(line, sizeof(line), "%llu frame %08x",
+           (unsigned long long)(simNowMicros() - startMicros), hash);
+  current->lines.push_back(line);
+}
+
+static void observePublish(const char* topic, const char* payload, uint64_t atMicros) {
+  size_t prefix = strlen(MQTT_TOPIC_METRICS);
+  if (!strncmp(topic, MQTT_TOPIC_METRICS, prefix) && topic[prefix] == '/') {
+    return;
+  }
+  current->publishes++;
+  current->lines.push_back(std::to_string(atMicros - startMicros) + " mqtt " + topic + " " + payload);
+}
+
+// ==================== 回放 ====================
+static void schedulePressedMask(uint32_t pressedMask, uint64_t atMicros) {
+  for (uint8_t i = 0; i < BTN_COUNT; i++) {
+    simSchedulePin(BUTTON_PINS[i], (pressedMask & BUTTON_MASK(i)) ? LOW : HIGH, atMicros);
+  }
+}
+
+bool replayInputTrace(const uint8_t* data, size_t length, ReplayResult& result) {
+  result = ReplayResult();
+  InputTraceReader reader(data, length);
+  if (!reader.ok()) {
+    result.error = "不是输入录制文件（头部无效）";
+    return false;
+  }
+  if (!reader.matchesPins()) {
+    result.error = "录制时的按钮引脚与本固件的 BUTTON_PINS 不同";
+    return false;
+  }
+
+  // 每次回放都从同样的冷启动开始：NVS 里没有缓存的 WiFi 链路，保留内存里没有上一次的待发事件
+  auto wallStart = std::chrono::steady_clock::now();
+  simNVSClear();
+  simReset();
+  simPowerCycle();
+  initializeSystem();
+  for (uint8_t i = 0; i < BTN_COUNT; i++) {
+    if (reader.initialPressedMask() & BUTTON_MASK(i)) {
+      simSetPin(BUTTON_PINS[i], LOW);
+    }
+  }
+  while (bootTimings.mqttReadyMicros == BOOT_MILESTONE_PENDING && simNowMicros() < 30000000ULL) {
+    mainLoop();
+  }
+
+  current = &result;
+  startMicros = simNowMicros();
+  haveFrame = false;
+  simSetPublishHook(observePublish);
+  Scheduler::setObserver(observeJob);
+
+  // 引脚变化提前预定在原时间戳上，由虚拟时钟按时间顺序触发，中断拿到的时间戳与录制时的间隔一致
+  InputTraceRecord record;
+  bool more = reader.next(record);
+  uint64_t endMicros = startMicros;
+  while (more) {
+    uint64_t horizon = simNowMicros() + REPLAY_LOOKAHEAD_MICROS;
+    while (more && startMicros + record.offsetMicros <= horizon) {
+      uint64_t at = startMicros + record.offsetMicros;
+      if (record.type == TRACE_RECORD_EDGE) {
+        simSchedulePin(BUTTON_PINS[record.index], record.level, at);
+        result.edges++;
+      } else if (record.type == TRACE_RECORD_RESYNC) {
+        schedulePressedMask(record.pressedMask, at);
+        result.resyncs++;
+      }
+      endMicros = at;
+      more = reader.next(record);
+    }
+    mainLoop();
+  }
+  result.traceMicros = endMicros - startMicros;
+  while (simNowMicros() < endMicros + REPLAY_TAIL_MICROS) {
+    mainLoop();
+  }
+
+  Scheduler::setObserver(nullptr);
+  simSetPublishHook(nullptr);
+  current = nullptr;
+  result.wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+  if (!reader.ok()) {
+    result.error = "录制文件在第 " + std::to_string(reader.offset()) + " 字节处损坏";
+    return false;
+  }
+  result.ok = true;
+  return true;
+}
+
+// ==================== golden 文件 ====================
+size_t compareReplayLines(const std::vector<std::string>& actual, const std::vector<std::string>& golden) {
+  size_t n = actual.size() < golden.size() ? actual.size() : golden.size();
+  for (size_t i = 0; i < n; i++) {
+    if (actual[i] != golden[i]) {
+      return i + 1;
+    }
+  }
+  return actual.size() == golden.size() ? 0 : n + 1;
+}
+
+bool loadReplayLines(const char* path, std::vector<std::string>& lines) {
+  FILE* file = fopen(path, "rb");
+  if (!file) {
+    return false;
+  }
+  lines.clear();
+  std::string line;
+  int c;
+  while ((c = fgetc(file)) != EOF) {
+    if (c == '\n') {
+      lines.push_back(line);
+      line.clear();
+    } else {
+      line += (char)c;
+    }
+  }
+  if (!line.empty()) {
+    lines.push_back(line);
+  }
+  fclose(file);
+  return true;
+}
+
+bool saveReplayLines(const char* path, const std::vector<std::string>& lines) {
+  FILE* file = fopen(path, "wb");
+  if (!file) {
+    return false;
+  }
+  for (const std::string& line : lines) {
+    fputs(line.c_str(), file);
+    fputc('\n', file);
+  }
+  return fclose(file) == 0;
+}
+
+bool loadTraceFile(const char* path, std::vector<uint8_t>& data) {
+  FILE* file = fopen(path, "rb");
+  if (!file) {
+    return false;
+  }
+  data.clear();
+  uint8_t buffer[4096];
+  size_t n;
+  while ((n = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+    data.insert(data.end(), buffer, buffer + n);
+  }
+  fclose(file);
+  return true;
+}
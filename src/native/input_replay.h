@@ -0,0 +1,41 @@
+#ifndef INPUT_REPLAY_H
+#define INPUT_REPLAY_H
+
+// ==================== 按钮输入回放 ====================
+// 在虚拟时钟下把录制的按钮边沿（格式见 input_trace.h）按原时间戳注入模拟引脚中断，
+// 经完整的 mainLoop()（消抖、规则、灯效、MQTT）运行，输出可与 golden 文件逐行比对的事件：
+//   <微秒> frame <哈希>             LED 作业渲染的一帧 leds[]（FNV-1a），与上一帧相同时不输出
+//   <微秒> mqtt <主题> <载荷>       MQTT 发布；延迟摘要（MQTT_TOPIC_METRICS）含主机测得的耗时，不输出
+// 时间从录制开始算起。每次回放都从冷启动（NVS、保留内存清空）运行到 MQTT 就绪后开始，
+// 录制开始时按下的按钮在启动时就已按下。
+// 同一份录制、同一份固件逻辑，输出逐字节相同。
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+#include <vector>
+
+#define REPLAY_TAIL_MICROS 2000000ULL       // 最后一条记录之后继续运行的时间，等消抖、发布和灯效收尾
+#define REPLAY_LOOKAHEAD_MICROS 5000000ULL  // 提前预定的引脚变化，一次 mainLoop() 推进的时间不会超过它
+
+struct ReplayResult {
+  bool ok;
+  std::string error;
+  uint32_t edges;
+  uint32_t resyncs;
+  uint32_t frames;      // LED 作业渲染的帧数（含与上一帧相同、未输出的）
+  uint32_t publishes;   // 输出的 MQTT 发布
+  uint64_t traceMicros; // 录制时长
+  double wallSeconds;   // 回放的主机耗时
+  std::vector<std::string> lines;
+};
+
+bool replayInputTrace(const uint8_t* data, size_t length, ReplayResult& result);
+
+// golden 文件每行一个事件；第一处不同的行号（从 1 起），完全一致时返回 0
+size_t compareReplayLines(const std::vector<std::string>& actual, const std::vector<std::string>& golden);
+bool loadReplayLines(const char* path, std::vector<std::string>& lines);
+bool saveReplayLines(const char* path, const std::vector<std::string>& lines);
+bool loadTraceFile(const char* path, std::vector<uint8_t>& data);
+
+#endif // INPUT_REPLAY_H
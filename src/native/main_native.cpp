@@ -0,0 +1,1325 @@
+// ==================== 主机构建入口：mainLoop 延迟基准 ====================
+// 在虚拟时钟下运行 mainLoop()，通过调度器观察者逐作业统计：
+//   - host ns：逻辑本身在主机上的耗时
+//   - virt us：作业消耗的虚拟时间（LED 数据线占用等；网络作业应始终为 0）
+//   - 截止时间错过次数和最大迟到时间
+// 以及唤醒次数和空闲比例。--iterations 为 mainLoop 唤醒次数。
+// 其余模式只打印耗时和统计；行为检查在 test/ 下的 Unity 用例里（pio test -e native），两者共用 sim_scenarios。
+// 用法：pio run -e native && .pio/build/native/program [--iterations N]
+//       [--broker up|refused|blackhole] [--no-wire-timing] [--verbose]
+//       [--stress SECONDS]   渲染/网络任务跑在两个线程上：快照读取次数、消息投递/合并/丢弃
+//       [--serializer N]     JSON/二进制响应序列化：每次调用的耗时和堆分配次数
+//       [--boot]             冷启动/热启动（NVS 缓存直连）耗时和 WiFi 掉线重连
+//       [--outbox]           MQTT 服务器中断期间事件的保留、合并、重放和软件复位后的恢复
+//       [--trace N]          追踪点开销和 /api/metrics 文本生成耗时
+//       [--rules N]          规则判断耗时：旧版 if 链与规则表
+//       [--buttons N]        本构建的按钮引脚列表：采样、规则判断、状态编码的耗时，与逐位循环/查表对照
+//       [--effects N]        每种灯效在 144 / 1000 个像素上的单帧渲染耗时
+//       [--leds N]           以快于灯带发送的速度推送 N 帧：渲染/跳过/丢帧计数和推送阻塞时间
+//       [--layout]           2000 像素分 1/4/8 个通道时的帧率和每像素内存
+//       [--log N]            日志调用点开销、限流、突发时与同步串口输出的阻塞对比
+//       [--ws SECONDS]       32 个不同带宽的 WebSocket 客户端：各组收发、覆盖、断开和内存占用
+//       [--replay-bench SECONDS]  录制合成按键：每个边沿的字节数，回放速度
+//       [--replay TRACE [--golden FILE [--update-golden]]]  回放现场录制，与 golden 逐行比对或更新 golden
+//       [--commands N]       MQTT 命令分发吞吐量：前缀树 + 原地解析与 String 复制 + strcmp 链对照
+//       [--power SECONDS]    同一段按键在关闭/开启省电时的唤醒次数、帧率和 MQTT 发布，唤醒到渲染的延迟
+//       [--clips N]          动画片段：每个片段的解码吞吐量和每帧字节数
+//       [--clip-build OUT name=@demo|name=file.rgb[@fps] ...]  生成片段包，经 POST /api/clips 上传
+//       [--ota KB]           固件更新：流水线与同步写入的吞吐量对比、签名验证耗时
+//       [--ota-keygen KEYFILE]  生成 Ed25519 密钥对：私钥写入 KEYFILE（仓库之外），打印构建固件用的公钥参数
+//       [--ota-sign IN OUT KEYFILE]  用 KEYFILE 里的私钥给固件镜像加签名清单，经 POST /update 上传
+#ifndef PIO_UNIT_TESTING  // pio test 把 src/ 一起链接进各个用例，用例有自己的 main()
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include "ball.h"
+#include "led_compositor.h"
+#include "button_events.h"
+#include "tasks.h"
+#include "ws_protocol.h"
+#include "wifi_manager.h"
+#include "mqtt_manager.h"
+#include "mqtt_outbox.h"
+#include "metrics.h"
+#include "button_rules.h"
+#include "effects.h"
+#include "log.h"
+#include "ws_fanout.h"
+#include "input_trace.h"
+#include "power.h"
+#include "mqtt_commands.h"
+#include "topic_trie.h"
+#include "clips.h"
+#include "ota.h"
+#include "sha256.h"
+#include "hal_sim.h"
+#include "input_replay.h"
+#include "clip_builder.h"
+#include "sim_scenarios.h"
+
+// ==================== 统计 ====================
+struct Samples {
+  std::vector<uint64_t> values;
+
+  uint64_t percentile(double p) {
+    if (values.empty()) return 0;
+    std::sort(values.begin(), values.end());
+    size_t index = (size_t)(p * (values.size() - 1) + 0.5);
+    return values[index];
+  }
+  uint64_t max() {
+    return values.empty() ? 0 : *std::max_element(values.begin(), values.end());
+  }
+};
+
+static void printRow(const char* name, Samples& host, Samples& virt) {
+  printf("%-22s %10llu %10llu %10llu %10llu %10llu", name,
+         (unsigned long long)host.percentile(0.50),
+         (unsigned long long)host.percentile(0.99),
+         (unsigned long long)virt.percentile(0.50),
+         (unsigned long long)virt.percentile(0.99),
+         (unsigned long long)virt.max());
+}
+
+template <typename F>
+static double nanosPerCall(uint32_t iterations, F call) {
+  uint64_t start = hostNanos();
+  for (uint32_t i = 0; i < iterations; i++) {
+    call(i);
+  }
+  return (double)(hostNanos() - start) / iterations;
+}
+
+// ==================== 作业计时 ====================
+struct JobSamples {
+  const char* name;
+  Samples host;
+  Samples virt;
+  uint64_t startHost;
+  uint64_t startVirt;
+};
+
+static std::vector<JobSamples> jobSamples;
+
+static JobSamples& samplesFor(const Job& job) {
+  for (JobSamples& samples : jobSamples) {
+    if (samples.name == job.name) return samples;
+  }
+  jobSamples.push_back(JobSamples{job.name, Samples(), Samples(), 0, 0});
+  return jobSamples.back();
+}
+
+static void observeJob(const Job& job, bool finished) {
+  JobSamples& samples = samplesFor(job);
+  if (!finished) {
+    samples.startVirt = simNowMicros();
+    samples.startHost = hostNanos();
+  } else {
+    samples.host.values.push_back(hostNanos() - samples.startHost);
+    samples.virt.values.push_back(simNowMicros() - samples.startVirt);
+  }
+}
+
+static void printJobRows(const Scheduler& scheduler) {
+  for (uint8_t i = 0; i < scheduler.jobCount(); i++) {
+    const Job& job = scheduler.job(i);
+    JobSamples& samples = samplesFor(job);
+    printRow(job.name, samples.host, samples.virt);
+    printf(" %8u %6u %10u\n", job.runs, job.misses, job.maxLatenessMicros);
+  }
+}
+
+// ==================== WebSocket 推送延迟 ====================
+// 二进制帧携带状态变化时刻，帧发出时刻减去它即为状态变化到推送的延迟
+static Samples webSocketLatency;
+static uint32_t webSocketKeyframes = 0;
+
+static void observeWebSocketFrame(const uint8_t* data, size_t length, uint64_t atMicros) {
+  if (length != WS_STATE_FRAME_SIZE) return;
+  if (data[0] == WS_FRAME_KEYFRAME) {
+    webSocketKeyframes++;
+    return;
+  }
+  uint32_t changedMillis = data[8] | (data[9] << 8) | (data[10] << 16) | ((uint32_t)data[11] << 24);
+  webSocketLatency.values.push_back((uint32_t)(atMicros / 1000) - changedMillis);
+}
+
+// ==================== 并发压力 ====================
+static int runStress(uint32_t seconds, bool wireTiming) {
+  StressRun run = runStressTasks(seconds, wireTiming);
+
+  const TaskStats& stats = taskStats();
+  const SimCounters& c = simCounters();
+  printf("并发压力测试：%u s\n", seconds);
+  printf("快照: 发布 %u，读取 %llu，不一致 %llu\n", stats.snapshotsPublished,
+         (unsigned long long)run.reads, (unsigned long long)run.violations);
+  const OutboxStats& outbox = mqttOutboxStats();
+  printf("MQTT 待发队列: 投递 %u，丢弃 %u，合并 %u，缓冲区满丢弃 %u，实际发布 %u\n",
+         stats.messagesPosted, stats.messagesDropped, outbox.coalesced, outbox.dropped,
+         c.mqttPublishes);
+  printf("按钮事件: 捕获 %u，丢弃 %u\n", buttonEventStats().captured, buttonEventStats().dropped);
+  printf("帧合成器: 推送 %u 帧，跳过 %u 帧\n",
+         compositorStats().framesRendered, compositorStats().framesSkipped);
+  return 0;
+}
+
+// ==================== 序列化基准 ====================
+// 旧实现：String 逐段拼接，作为对照
+static String legacyStateJSON(const BallSnapshot& state) {
+  String json = "{";
+  for (uint8_t i = 0; i < BTN_COUNT; i++) {
+    json += "\"p" + String(BUTTON_PINS[i]) + "\":" +
+            String((state.pressed & BUTTON_MASK(i)) ? "true" : "false");
+    if (i < BTN_COUNT - 1) json += ",";
+  }
+  json += "}";
+  return json;
+}
+
+template <typename F>
+static void benchSerializer(const char* name, uint32_t iterations, F serialize) {
+  size_t bytes = 0;
+  uint64_t allocations0 = heapAllocationCount();
+  uint64_t h0 = hostNanos();
+  for (uint32_t i = 0; i < iterations; i++) {
+    BallSnapshot state = {(uint32_t)(i & ALL_BUTTONS_MASK), i, (uint8_t)(i & 3), (uint8_t)i, 0, 0};
+    bytes += serialize(state, i);
+  }
+  uint64_t elapsed = hostNanos() - h0;
+  uint64_t allocations = heapAllocationCount() - allocations0;
+  printf("%-28s %10.1f %12.2f %8.1f\n", name, (double)elapsed / iterations,
+         (double)allocations / iterations, (double)bytes / iterations);
+}
+
+static int runSerializerBench(uint32_t iterations) {
+  printf("序列化基准：%u 次调用\n\n", iterations);
+  printf("%-28s %10s %12s %8s\n", "serializer", "ns/call", "allocs/call", "bytes");
+
+  benchSerializer("state JSON (String, legacy)", iterations, [](const BallSnapshot& state, uint32_t) {
+    return (size_t)legacyStateJSON(state).length();
+  });
+  benchSerializer("state JSON (TextWriter)", iterations, [](const BallSnapshot& state, uint32_t) {
+    FixedTextWriter<STATE_JSON_CAPACITY> json;
+    encodeStateJSON(json, state);
+    return json.overflowed() ? 0 : json.length();
+  });
+  benchSerializer("state frame (binary)", iterations, [](const BallSnapshot& state, uint32_t i) {
+    uint8_t frame[WS_STATE_FRAME_SIZE];
+    return encodeStateFrame(frame, state, i, WS_FRAME_DELTA);
+  });
+  benchSerializer("input stats JSON (TextWriter)", iterations, [](const BallSnapshot&, uint32_t i) {
+    FixedTextWriter<96> json;
+    json.beginObject()
+        .field("captured", i)
+        .field("dropped", i >> 8)
+        .field("overflows", i >> 16)
+        .field("maxDepth", i & 63)
+        .endObject();
+    return json.length();
+  });
+  return 0;
+}
+
+// ==================== 按钮规则 ====================
+// 判断耗时：旧版 if 链与规则表（两者输出一致由 test/test_button_rules 检查）
+static int runRulesBench(uint32_t rounds) {
+  simReset();
+  initializeSystem();
+  LegacyLogic legacy = {false, false, 0, LED_BREATHE_RED, 0};
+  volatile uint32_t sink = 0;
+  double legacyNanos = nanosPerCall(rounds, [&](uint32_t i) {
+    sink = sink + legacyEvaluate(legacy, (i * 37) & ALL_BUTTONS_MASK);
+  });
+  const RuleSet& rules = activeRules();
+  double tableNanos = nanosPerCall(rounds, [&](uint32_t i) {
+    const RuleOutcome outcome = ruleOutcome(rules, (i * 37) & ALL_BUTTONS_MASK);
+    sink = sink + outcome.ledMode + outcome.brightness;
+  });
+  printf("判断耗时（%u 次）: if 链 %.2f ns，%s %.2f ns（规则表 %zu 字节）\n", rounds, legacyNanos,
+         RULE_TABLE_LOOKUP ? "查表" : "逐条比较", tableNanos, sizeof(RuleSet));
+  return 0;
+}
+
+// ==================== 按钮引脚列表 ====================
+// 本构建的按钮引脚列表（-DBUTTON_PIN_LIST）：采样、规则判断、状态编码的耗时，与逐位/逐条的写法对照
+static int runButtonsBench(uint32_t iterations) {
+  simReset();
+  initializeSystem();
+
+  printf("按钮: %u 个（", BTN_COUNT);
+  for (uint8_t i = 0; i < BTN_COUNT; i++) printf(i ? " %u" : "%u", BUTTON_PINS[i]);
+  printf("），规则判断: %s（RuleSet %zu 字节），状态帧 %u 字节，录制头部 %u 字节、code %u 位\n\n",
+         RULE_TABLE_LOOKUP ? "查表" : "逐条比较", sizeof(RuleSet), (unsigned)WS_STATE_FRAME_SIZE,
+         (unsigned)INPUT_TRACE_HEADER_SIZE, (unsigned)INPUT_TRACE_CODE_BITS);
+
+  const RuleSet& rules = activeRules();
+  volatile uint32_t sink = 0;
+  BallSnapshot state = {ALL_BUTTONS_MASK & 0x5555, 0, LED_BREATHE_GREEN, 0, 0, 0};
+  printf("%-28s %10s\n", "operation", "ns/call");
+  // 取位单独计时：主机上读模拟输入寄存器本身比取位慢得多
+  printf("%-28s %10.2f\n", "取位（编译期展开）", nanosPerCall(iterations, [&](uint32_t i) {
+    sink = sink + pressedMaskFromLevels(i * 0x9E3779B97F4A7C15ULL);
+  }));
+  printf("%-28s %10.2f\n", "取位（逐位循环）", nanosPerCall(iterations, [&](uint32_t i) {
+    sink = sink + loopPressedMask(i * 0x9E3779B97F4A7C15ULL);
+  }));
+  if (RULE_TABLE_LOOKUP) {
+    printf("%-28s %10.2f\n", "规则判断（查表）", nanosPerCall(iterations, [&](uint32_t i) {
+      RuleOutcome outcome = ruleOutcome(rules, (i * 37) & ALL_BUTTONS_MASK);
+      sink = sink + outcome.ledMode + outcome.brightness;
+    }));
+  }
+  printf("%-28s %10.2f\n", "规则判断（逐条比较）", nanosPerCall(iterations, [&](uint32_t i) {
+    RuleOutcome outcome = evaluateRules(rules.rules, rules.ruleCount, (i * 37) & ALL_BUTTONS_MASK);
+    sink = sink + outcome.ledMode + outcome.brightness;
+  }));
+  printf("%-28s %10.2f\n", "状态 JSON（编译期键）", nanosPerCall(iterations, [&](uint32_t i) {
+    state.pressed = i & ALL_BUTTONS_MASK;
+    FixedTextWriter<STATE_JSON_CAPACITY> json;
+    encodeStateJSON(json, state);
+    sink = sink + json.length();
+  }));
+  printf("%-28s %10.2f\n", "状态 JSON（格式化引脚号）", nanosPerCall(iterations, [&](uint32_t i) {
+    state.pressed = i & ALL_BUTTONS_MASK;
+    FixedTextWriter<STATE_JSON_CAPACITY> json;
+    loopStateJSON(json, state);
+    sink = sink + json.length();
+  }));
+  printf("%-28s %10.2f\n", "状态帧（二进制）", nanosPerCall(iterations, [&](uint32_t i) {
+    state.pressed = i & ALL_BUTTONS_MASK;
+    uint8_t frame[WS_STATE_FRAME_SIZE];
+    sink = sink + encodeStateFrame(frame, state, i, WS_FRAME_DELTA);
+  }));
+  return 0;
+}
+
+// ==================== 灯效基准 ====================
+static const char* const LED_MODE_LABELS[NUM_LED_MODES] = {
+  "off", "breathe_red", "breathe_green", "flash_yellow", "progress_green", "chase_yellow", "gradient"
+};
+
+static int runEffectsBench(uint32_t frames) {
+  static CRGB buffer[1000];
+  const uint16_t sizes[] = {NUM_LEDS, 1000};
+
+  printf("%-16s %-9s %12s %12s %14s\n", "mode", "effect", "144 ns/帧", "1000 ns/帧", "预算 us/1000");
+  for (uint8_t mode = 0; mode < NUM_LED_MODES; mode++) {
+    const Effect& effect = ledModeEffect((LEDMode)mode);
+    double nanosPerFrame[2];
+    for (uint8_t s = 0; s < 2; s++) {
+      // 每帧推进 7 ms，覆盖整个周期内的各个相位
+      nanosPerFrame[s] = nanosPerCall(frames, [&](uint32_t f) {
+        renderEffect(effect, buffer, sizes[s], f * 7, 153);
+      });
+    }
+    printf("%-16s %-9s %12.0f %12.0f %14u\n", LED_MODE_LABELS[mode], effectName(effect.kind),
+           nanosPerFrame[0], nanosPerFrame[1], effect.budgetMicros);
+  }
+  return 0;
+}
+
+// ==================== LED 双缓冲 ====================
+static int runLEDBench(uint32_t frames) {
+  LedPushRun run = pushFramesFasterThanWire(frames);
+  const SimCounters& c = simCounters();
+  printf("推送 %u 帧：发送 %u，丢弃 %u，完成信号 %u\n", run.frames, run.rendered, run.dropped, run.completed);
+  printf("撕裂 %u 次（发送中改写 %u，发送重叠 %u），显示混合帧 %u 次\n",
+         c.ledTornFrames + run.mixedFrames, c.ledTornFrames, c.ledOverlaps, run.mixedFrames);
+  printf("compositorPresent(): 平均 %.0f ns，阻塞虚拟时间 %llu us（发送一帧需 %u us）\n",
+         (double)run.presentHostNanos / run.frames, (unsigned long long)run.presentVirtualMicros, run.wireMicros);
+  return 0;
+}
+
+// ==================== 灯带布局 ====================
+static int runLayoutBench() {
+  printf("%-10s %8s %10s %10s %12s %12s\n", "通道", "像素", "发送 us", "fps", "present ns", "字节/像素");
+  const uint8_t channelCounts[] = {1, 4, 8};
+  for (uint8_t channels : channelCounts) {
+    LayoutRun run = runSplitLayout(2000, channels);
+    printf("%-10u %8u %10u %10.1f %12.0f %12.1f\n", channels, run.pixels, run.frameMicros, run.fps,
+           run.presentNanos, run.bytesPerPixel);
+  }
+  return 0;
+}
+
+// ==================== 启动耗时 ====================
+static double millisOf(uint32_t micros) {
+  return micros == BOOT_MILESTONE_PENDING ? -1.0 : micros / 1000.0;
+}
+
+static void printBootRow(const char* name) {
+  const WiFiStats& wifi = wifiStats();
+  printf("%-26s %12.1f %12.1f %12.1f %12.1f %6u %6u\n", name,
+         millisOf(bootTimings.firstInputMicros), millisOf(bootTimings.firstFrameMicros),
+         millisOf(bootTimings.wifiConnectedMicros), millisOf(bootTimings.mqttReadyMicros),
+         simCounters().wifiConnectAttempts, wifi.fastConnects);
+}
+
+static int runBootBench() {
+  printf("启动耗时（ms，虚拟时钟，-1 表示未达到）\n\n");
+  printf("%-26s %12s %12s %12s %12s %6s %6s\n", "scenario",
+         "first input", "first frame", "wifi", "mqtt ready", "wifi#", "fast#");
+
+  // 冷启动：NVS 为空，全扫描 + DHCP
+  simNVSClear();
+  simReset();
+  initializeSystem();
+  runUntil(30000000ULL, true);
+  printBootRow("cold boot (empty NVS)");
+
+  // 热启动：NVS 中有上次的 BSSID/信道/IP，直连
+  simReset();
+  initializeSystem();
+  runUntil(30000000ULL, true);
+  printBootRow("warm boot (cached link)");
+
+  // 启动时 AP 不可用：缓存直连和全扫描都失败，退避重试直到 AP 恢复
+  simReset();
+  simSetWiFiAvailable(false);
+  initializeSystem();
+  runUntil(8000000ULL, false);
+  simSetWiFiAvailable(true);
+  runUntil(60000000ULL, true);
+  printBootRow("AP down for 8 s at boot");
+
+  // 运行中掉线：AP 消失 20 秒，观察退避重连
+  uint64_t dropAt = simNowMicros();
+  simSetWiFiAvailable(false);
+  simDropWiFi();
+  runUntil(dropAt + 20000000ULL, false);
+  uint32_t attemptsWhileDown = simCounters().wifiConnectAttempts;
+  simSetWiFiAvailable(true);
+  uint64_t restoredAt = simNowMicros();
+  while (!wifiManagerConnected() && simNowMicros() < restoredAt + 60000000ULL) {
+    mainLoop();
+  }
+  const WiFiStats& wifi = wifiStats();
+  printf("\nAP 掉线 20 s：期间 %u 次连接尝试（带抖动指数退避），恢复后 %.1f ms 重新连上，最近一次退避 %u ms\n",
+         attemptsWhileDown, (simNowMicros() - restoredAt) / 1000.0, wifi.lastBackoffMillis);
+  return 0;
+}
+
+// ==================== MQTT 待发缓冲区 ====================
+static void printOutboxRow(const char* name) {
+  const OutboxStats& o = mqttOutboxStats();
+  printf("%-30s %7u %7u %7u %7u %7u %8u %9u %6u\n", name, o.enqueued, o.coalesced, o.dropped, o.maxDepth, o.restored,
+         o.published, o.maxLagMillis, publishLog().outOfOrder);
+}
+
+static int runOutboxBench() {
+  printf("MQTT 待发缓冲区（虚拟时钟，容量 %u，按钮场景周期 %u s）\n\n",
+         MQTT_OUTBOX_CAPACITY, SCENARIO_PERIOD_MS / 1000);
+  printf("%-30s %7s %7s %7s %7s %7s %8s %9s %6s\n", "scenario", "queued",
+         "merged", "dropped", "maxdep", "restore", "publish", "maxlag ms", "order");
+
+  runBrokerOutage();
+  printOutboxRow("broker down 30 s");
+  uint16_t pending = runSoftResetWhileOffline();
+  printOutboxRow("soft reset while offline");
+  runPowerCycleWhileOffline();
+  printOutboxRow("power cycle while offline");
+
+  const PublishLog& log = publishLog();
+  printf("\n发布 %u 条（代表 %u 个事件），最大 lag %u ms，缓冲区中断前已有 %u 条\n",
+         log.messages, log.events, log.maxLag, pending);
+  return 0;
+}
+
+// ==================== 延迟追踪 ====================
+// 各阶段直方图的分位数是所在对数桶的上界
+static void printMetricRows() {
+  printf("%-18s %6s %8s %10s %10s %10s\n", "stage", "unit", "count", "p50", "p99", "max");
+  for (uint8_t m = 0; m < NUM_METRICS; m++) {
+    const Histogram& h = metricHistogram(m);
+    printf("%-18s %6s %8u %10u %10u %10u\n", metricName(m), metricInNanos(m) ? "ns" : "us",
+           h.count, metricQuantile(h, 500), metricQuantile(h, 990), h.max);
+  }
+}
+
+static int runTraceBench(uint32_t iterations) {
+  simReset();
+  initializeMetrics();
+  printf("追踪开销：%u 次\n\n", iterations);
+
+  uint64_t allocations0 = heapAllocationCount();
+  double spanNanos = nanosPerCall(iterations, [](uint32_t) {
+    uint32_t span = traceBegin();
+    traceEnd(METRIC_BUTTON_LOGIC, span);
+  });
+  double recordNanos = nanosPerCall(iterations, [](uint32_t i) {
+    recordMetric(METRIC_EDGE_TO_PUBLISH, i);
+  });
+  uint64_t allocations = heapAllocationCount() - allocations0;
+
+  static char text[METRICS_TEXT_CAPACITY + POWER_TEXT_CAPACITY];  // 与 /api/metrics 相同
+  size_t length = 0;
+  double renderNanos = nanosPerCall(1000, [&](uint32_t) {
+    TextWriter writer(text, sizeof(text));
+    encodeMetricsText(writer);
+    encodePowerText(writer);
+    length = writer.length();
+  });
+  saturateMetricHistograms();
+  TextWriter worst(text, sizeof(text));
+  encodeMetricsText(worst);
+  encodePowerText(worst);
+  initializeMetrics();
+
+  printf("traceBegin + traceEnd:  %.1f ns/次（启动时自测 %u ns）\n", spanNanos, traceOverheadNanos());
+  printf("recordMetric:           %.1f ns/次\n", recordNanos);
+  printf("堆分配:                 %llu 次\n", (unsigned long long)allocations);
+  printf("/api/metrics 文本:      %zu 字节，最坏情况 %zu 字节（容量 %zu），%.1f us/次\n", length,
+         worst.length(), sizeof(text), renderNanos / 1000.0);
+  printf("直方图静态内存:         %zu 字节\n", sizeof(Histogram) * NUM_METRICS);
+  return 0;
+}
+
+// ==================== 异步日志 ====================
+static int runLogBench(uint32_t iterations) {
+  printf("异步日志：%u 次\n\n", iterations);
+
+  LogCallRun calls = runLogCallSites(iterations);
+  printf("LOG_INFO（2 个参数）:      %.1f ns/次\n", (double)calls.writeNanos / calls.writes);
+  printf("LOG_INFO（复制文本）:      %.1f ns/次\n", (double)calls.textNanos / LOG_RATE_LIMIT);
+  printf("LOG_INFO（被限流）:        %.1f ns/次\n", (double)calls.suppressedNanos / iterations);
+  printf("堆分配:                    %llu 次\n", (unsigned long long)calls.allocations);
+  printf("写入 %u，限流 %u，丢弃 %u，输出 %u 行\n", calls.stats.written, calls.stats.suppressed,
+         calls.stats.dropped, calls.stats.emitted);
+
+  // 突发：渲染任务 100 ms 内记录 200 次按钮边沿，串口 115200 波特
+  const uint32_t burst = 200;
+  uint64_t legacyBlocked = runLegacyLogBurst(burst);
+  LogBurstRun run = runLogBurst(burst);
+  printf("\n突发 %u 条 / 100 ms，串口 115200 波特：\n", burst);
+  printf("  同步 Serial.printf:      调用方累计阻塞 %.1f ms\n", legacyBlocked / 1000.0);
+  printf("  异步日志:                调用方平均 %.0f ns，串口阻塞 %.1f ms；写入 %u，限流 %u，丢弃 %u，"
+         "推迟 %u 次，%.0f ms 后输出完毕\n",
+         (double)run.callerNanos / burst, run.blockedMicros / 1000.0, run.stats.written, run.stats.suppressed,
+         run.stats.dropped, run.stats.deferred, run.drainMicros / 1000.0);
+
+  // 缓冲区满：串口跟不上时日志作业推迟而不是阻塞
+  LogBurstRun full = runLogRingFull();
+  printf("  缓冲区满:                写入 %u 条（容量 %u），丢弃 %u，最大深度 %u，输出 %u 行，"
+         "推迟 %u 次，串口阻塞 %.1f ms，%.0f ms 后输出完毕\n",
+         full.attempts, LOG_RING_SIZE, full.stats.dropped, full.stats.maxDepth, full.stats.emitted,
+         full.stats.deferred, full.blockedMicros / 1000.0, full.drainMicros / 1000.0);
+  return 0;
+}
+
+// ==================== WebSocket 扇出负载 ====================
+static int runWebSocketLoadBench(uint32_t seconds) {
+  static WsLoadRun run;
+  if (!runWebSocketLoad(seconds, run)) {
+    printf("WS_MAX_CLIENTS 为 %u，负载测试需要 %u（[env:native] 的 build_flags 已设置）\n",
+           WS_MAX_CLIENTS, WS_LOAD_CLIENTS);
+    return 1;
+  }
+  if (run.seconds != seconds) {
+    printf("时长不足以触发断开，按 %u s 运行\n", run.seconds);
+  }
+
+  printf("WebSocket 扇出：%u 个客户端，%u s（虚拟时钟），每客户端队列 %u 帧，落后 %u ms 断开\n\n",
+         WS_LOAD_CLIENTS, run.seconds, WS_CLIENT_QUEUE_CAP, WS_CLIENT_EVICT_MS);
+  printf("%-18s %4s %8s %10s %8s %8s %8s %6s %10s\n", "group", "n", "frames", "KB", "replaced",
+         "dropped", "maxDepth", "evict", "evict@ s");
+  for (uint8_t g = 0; g < WS_LOAD_GROUP_COUNT; g++) {
+    const WsLoadGroup& group = WS_LOAD_GROUPS[g];
+    const WsLoadGroupResult& r = run.groups[g];
+    printf("%-18s %4u %8u %10.1f %8u %8u %8u %6u", group.name, group.clients, r.frames, r.bytes / 1000.0,
+           r.replaced, r.dropped, r.maxDepth, r.evicted);
+    if (r.evicted) printf(" %10.1f", r.lastEvictMicros / 1e6);
+    printf("\n");
+  }
+
+  const WsFanoutStats& stats = run.stats;
+  printf("\n广播 %u 帧（%.1f KB），分配共享缓冲 %u 次，交给传输层 %u 帧（每个缓冲平均 %.1f 个客户端）\n",
+         stats.broadcasts, stats.broadcastBytes / 1000.0, run.buffers, run.transportFrames,
+         (double)run.transportFrames / std::max(1u, run.buffers));
+  printf("共享缓冲峰值 %.1f KB；旧版 textAll 按每客户端复制、无上限排队，结束时积压约 %.1f KB 且仍在增长\n",
+         run.bufferBytesPeak / 1000.0, run.legacyBacklogBytes / 1000.0);
+  printf("断开 %u 个落后客户端，拒绝 %u 个连接，分配失败 %u 次\n", stats.evictions, stats.rejected,
+         stats.allocFailures);
+  printf("全部断开后未释放的缓冲: %u\n", run.buffersLive);
+  return 0;
+}
+
+// ==================== 输入录制与回放 ====================
+static void printReplaySummary(const char* name, const ReplayResult& r) {
+  printf("%-22s 边沿 %u，重新同步 %u，录制时长 %.1f s，渲染 %u 帧，输出 %zu 行（发布 %u），"
+         "主机 %.3f s（%.0f 倍实时）\n",
+         name, r.edges, r.resyncs, r.traceMicros / 1e6, r.frames, r.lines.size(), r.publishes,
+         r.wallSeconds, r.traceMicros / 1e6 / r.wallSeconds);
+}
+
+static void printLineMismatch(size_t line, const std::vector<std::string>& actual,
+                              const std::vector<std::string>& golden) {
+  printf("  第 %zu 行不同\n    golden: %s\n    实际:   %s\n", line,
+         line <= golden.size() ? golden[line - 1].c_str() : "（文件结束）",
+         line <= actual.size() ? actual[line - 1].c_str() : "（输出结束）");
+}
+
+// 录制 seconds 秒合成按键（含抖动、一次中断队列溢出和一段 20 分钟的空闲）：每个边沿的字节数，回放速度
+static int runReplayBench(uint32_t seconds) {
+  TraceRecording recording;
+  recordSyntheticTrace(seconds, recording);
+  const InputTraceStats& trace = recording.trace;
+  printf("录制: 驱动 %u 个边沿（中断队列丢弃 %u），记录 %u 个边沿、%u 次重新同步，%u 字节（%.2f 字节/边沿），"
+         "文件 %d 字节，%s\n",
+         recording.driven, recording.lost, trace.edges, trace.resyncs, trace.bytes,
+         (double)(trace.bytes - INPUT_TRACE_HEADER_SIZE) / std::max(1u, trace.edges), recording.fileLength,
+         trace.truncated ? "截断" : "完整");
+  if (recording.fileLength < 0) {
+    return 1;
+  }
+  ReplayResult result;
+  if (!replayInputTrace(recording.file.data(), recording.file.size(), result)) {
+    printf("回放失败: %s\n", result.error.c_str());
+    return 1;
+  }
+  printReplaySummary("回放", result);
+  return 0;
+}
+
+// 回放现场录制（GET /api/trace 下载），与 golden 文件逐行比对或更新 golden
+static int runReplay(const char* tracePath, const char* goldenPath, bool updateGolden) {
+  std::vector<uint8_t> data;
+  if (!loadTraceFile(tracePath, data)) {
+    fprintf(stderr, "无法读取 %s\n", tracePath);
+    return 2;
+  }
+  ReplayResult result;
+  if (!replayInputTrace(data.data(), data.size(), result)) {
+    fprintf(stderr, "%s: %s\n", tracePath, result.error.c_str());
+    return 2;
+  }
+  printReplaySummary(tracePath, result);
+  if (!goldenPath) {
+    return 0;
+  }
+  if (updateGolden) {
+    if (!saveReplayLines(goldenPath, result.lines)) {
+      fprintf(stderr, "无法写入 %s\n", goldenPath);
+      return 2;
+    }
+    printf("已写入 golden: %s（%zu 行）\n", goldenPath, result.lines.size());
+    return 0;
+  }
+  std::vector<std::string> golden;
+  if (!loadReplayLines(goldenPath, golden)) {
+    fprintf(stderr, "无法读取 %s\n", goldenPath);
+    return 2;
+  }
+  size_t diff = compareReplayLines(result.lines, golden);
+  if (diff) {
+    printLineMismatch(diff, result.lines, golden);
+  }
+  printf("golden %s: %s\n", goldenPath, diff ? "不同" : "一致");
+  return diff ? 1 : 0;
+}
+
+// ==================== 低功耗空闲 ====================
+static void printPowerPhase(const char* name, const PowerPhase& phase) {
+  double seconds = phase.micros / 1e6;
+  printf("  %-6s 唤醒 %6.1f 次/s，渲染 %5.1f 帧/s，浅睡眠 %5.1f%%\n", name, phase.wakes / seconds,
+         phase.frames / seconds, phase.sleptMicros * 100.0 / phase.micros);
+}
+
+static void printPowerStats(const PowerStats& stats) {
+  printf("  浅睡眠 %u 次，进入空闲 %u 次\n", stats.sleeps, stats.idleEntries);
+  printf("  唤醒原因:");
+  for (uint8_t c = 0; c < NUM_POWER_WAKE_CAUSES; c++) {
+    printf(" %s %u", powerWakeCauseName(c), stats.wakes[c]);
+  }
+  printf("\n  保持唤醒:");
+  for (uint8_t b = 0; b < NUM_POWER_BLOCKERS; b++) {
+    printf(" %s %u", powerBlockerName(b), stats.decisions[b]);
+  }
+  printf("\n");
+}
+
+// 已连接时同一段输入在关闭/开启省电时的唤醒次数和帧率；AP 不可用时的浅睡眠统计和唤醒到渲染的延迟
+static int runPowerBench(uint32_t seconds) {
+  PowerScenario off;
+  PowerScenario on;
+  PowerScenario outage;
+  runPowerScenario(false, false, seconds, off);
+  runPowerScenario(true, false, seconds, on);
+  PowerStats onStats = powerStats();
+  runPowerScenario(true, true, seconds, outage);
+  PowerStats outageStats = powerStats();
+  const Histogram& wake = metricHistogram(METRIC_WAKE_TO_FRAME);
+
+  printf("关闭省电:\n");
+  printPowerPhase("空闲", off.idle);
+  printPowerPhase("按键", off.presses);
+  printf("开启省电（已连接，modem sleep）:\n");
+  printPowerPhase("空闲", on.idle);
+  printPowerPhase("按键", on.presses);
+  printPowerStats(onStats);
+  printf("开启省电（AP 不可用）:\n");
+  printPowerPhase("空闲", outage.idle);
+  printPowerPhase("按键", outage.presses);
+  printPowerStats(outageStats);
+  printf("  开启后醒着 %u.%u%%；唤醒 → 渲染: %u 次，p50 %u us，p99 %u us，最大 %u us\n", powerAwakePermille() / 10,
+         powerAwakePermille() % 10, wake.count, metricQuantile(wake, 500), metricQuantile(wake, 990), wake.max);
+  printf("\n驱动 %u 个边沿；MQTT 发布: 关闭省电 %zu 条，开启省电 %zu 条，AP 恢复后补发 %zu 条\n", on.edges,
+         off.topics.size(), on.topics.size(), outage.topics.size());
+  return 0;
+}
+
+// ==================== MQTT 命令 ====================
+// 旧实现：主题和载荷各复制成 String，再与完整主题逐个 strcmp
+struct LegacyRoute {
+  std::string topic;
+  uint8_t route;
+};
+
+static std::vector<LegacyRoute> legacyRoutes;
+
+static bool legacyDispatch(const char* topic, const uint8_t* payload, unsigned int length, RemoteCommand& command) {
+  String topicStr = topic;
+  String message;
+  for (unsigned int i = 0; i < length; i++) {
+    message += (char)payload[i];
+  }
+  for (const LegacyRoute& r : legacyRoutes) {
+    if (!strcmp(topicStr.c_str(), r.topic.c_str())) {
+      return parseRemoteCommand(r.route, (const uint8_t*)message.c_str(), message.length(), command);
+    }
+  }
+  return false;
+}
+
+struct CommandSample {
+  std::string topic;
+  std::string payload;
+};
+
+// 分发吞吐量：前缀树 + 就地解析 + 入队，与 String 复制 + strcmp 链对照
+static int runCommandsBench(uint32_t iterations) {
+  printf("MQTT 命令：%u 次\n", iterations);
+  simReset();
+  initializeMQTTCommands();
+
+  const char* prefix = mqttCommandPrefix();
+  static const char* const NAMES[] = {"mode", "color", "brightness", "effect", "reset", "state"};
+  legacyRoutes.clear();
+  for (const char* name : NAMES) {
+    for (const char* root : {prefix, "ball/all"}) {
+      std::string topic = commandTopic(root, name);
+      legacyRoutes.push_back(LegacyRoute{topic, matchMQTTRoute(topic.data(), topic.size())});
+    }
+  }
+  const CommandSample SAMPLES[] = {
+    {commandTopic(prefix, "mode"), "{\"mode\":\"breathe_green\",\"level\":200}"},
+    {commandTopic("ball/all", "color"), std::string("\xB1\xFF\x80\x00\x00\x00\x40", 7)},
+    {commandTopic(prefix, "brightness"), "{\"level\":128}"},
+    {commandTopic("ball/all", "effect"), "{\"effect\":\"chase\",\"color\":[255,200,0],\"color2\":[0,0,0],\"period\":1500}"},
+    {commandTopic(prefix, "brightness"), std::string("\xB1\x40", 2)},
+    {commandTopic(prefix, "effect"), std::string("\xB1\x04\xFF\x00\x00\x00\xFF\x00\xDC\x05", 10)},
+  };
+  const size_t sampleCount = sizeof(SAMPLES) / sizeof(SAMPLES[0]);
+
+  // 回调收到的是客户端接收缓冲区，这里预先复制一次
+  std::vector<std::vector<char>> topics;
+  std::vector<std::vector<uint8_t>> payloads;
+  for (const CommandSample& s : SAMPLES) {
+    topics.emplace_back(s.topic.begin(), s.topic.end());
+    topics.back().push_back('\0');
+    payloads.emplace_back(s.payload.begin(), s.payload.end());
+  }
+
+  Samples dispatchNanos;
+  Samples legacyNanos;
+  dispatchNanos.values.reserve(iterations);
+  legacyNanos.values.reserve(iterations);
+  RemoteCommand command;
+  while (takeRemoteCommand(command)) {
+  }
+  uint64_t allocations0 = heapAllocationCount();
+  uint64_t h0 = hostNanos();
+  for (uint32_t i = 0; i < iterations; i++) {
+    size_t s = i % sampleCount;
+    uint64_t t0 = hostNanos();
+    dispatchMQTTMessage(topics[s].data(), payloads[s].data(), (unsigned int)payloads[s].size());
+    dispatchNanos.values.push_back(hostNanos() - t0);
+    takeRemoteCommand(command);
+  }
+  uint64_t dispatchTotal = hostNanos() - h0;
+  uint64_t allocations = heapAllocationCount() - allocations0;
+
+  allocations0 = heapAllocationCount();
+  h0 = hostNanos();
+  for (uint32_t i = 0; i < iterations; i++) {
+    size_t s = i % sampleCount;
+    uint64_t t0 = hostNanos();
+    legacyDispatch(topics[s].data(), payloads[s].data(), (unsigned int)payloads[s].size(), command);
+    legacyNanos.values.push_back(hostNanos() - t0);
+  }
+  uint64_t legacyTotal = hostNanos() - h0;
+  uint64_t legacyAllocations = heapAllocationCount() - allocations0;
+
+  printf("\n%-34s %12s %8s %8s %12s\n", "dispatch", "msg/s", "p50 ns", "p99 ns", "allocs/msg");
+  printf("%-34s %12.0f %8llu %8llu %12.2f\n", "String 复制 + strcmp 链（旧）", iterations * 1e9 / legacyTotal,
+         (unsigned long long)legacyNanos.percentile(0.50), (unsigned long long)legacyNanos.percentile(0.99),
+         (double)legacyAllocations / iterations);
+  printf("%-34s %12.0f %8llu %8llu %12.2f\n", "前缀树 + 就地解析 + 入队", iterations * 1e9 / dispatchTotal,
+         (unsigned long long)dispatchNanos.percentile(0.50), (unsigned long long)dispatchNanos.percentile(0.99),
+         (double)allocations / iterations);
+  return 0;
+}
+
+// ==================== 动画片段 ====================
+static void printClipRow(const char* name, uint32_t frames, size_t bytes, const uint32_t* types, double nanos) {
+  printf("%-22s %7u %12.1f %7.1f%% %5u %5u %5u %10.0f %12.0f\n", name, frames, (double)bytes / frames,
+         100.0 * bytes / frames / (NUM_LEDS * 3), types[CLIP_FRAME_RLE], types[CLIP_FRAME_DELTA],
+         types[CLIP_FRAME_RAW], nanos, 1e9 / nanos);
+}
+
+// 演示片段上传到模拟分区后，直接从映射解码：每个片段的压缩率和解码速度，以及 renderClipFrame() 的播放开销
+static int runClipsBench(uint32_t frames) {
+  printf("动画片段：%u 帧\n\n", frames);
+  std::mt19937 rng(24);
+  std::vector<ClipSource> clips;
+  std::vector<uint8_t> bundle;
+  ClipEncodeStats total;
+  std::string path = clipPartitionPath();
+  unlink(path.c_str());
+  simReset();
+  if (!buildDemoClips(clips, bundle, total) ||
+      !simSetPartitionFile(CLIP_PARTITION_LABEL, path.c_str(), CLIP_TEST_PARTITION_SIZE)) {
+    printf("无法准备片段分区\n");
+    return 1;
+  }
+  initializeClips();
+  bool uploaded = uploadClips(bundle, rng, bundle.size());
+  const SimCounters& c = simCounters();
+  printf("分区：擦除 %llu bytes，写入 %llu bytes（包 %zu bytes）\n", (unsigned long long)c.partitionErasedBytes,
+         (unsigned long long)c.partitionWrittenBytes, bundle.size());
+
+  size_t size = 0;
+  uint8_t count = 0;
+  const uint8_t* mapped = halPartitionMap(CLIP_PARTITION_LABEL, size);
+  const ClipEntry* entries = uploaded ? validateClipBundle(mapped, size, false, count) : nullptr;
+  printf("\n%-22s %7s %12s %8s %5s %5s %5s %10s %12s\n", "clip", "frames", "bytes/frame", "of raw", "RLE", "DELTA",
+         "RAW", "ns/frame", "frames/s");
+  std::vector<ClipEncodeStats> perClip(count);
+  for (uint8_t i = 0; entries && i < count; i++) {
+    std::vector<uint8_t> single;
+    std::string error;
+    buildClipBundle(std::vector<ClipSource>(1, clips[i]), single, perClip[i], error);
+  }
+  // 每个片段循环解码 frames / 片段数 帧
+  std::vector<CRGB> out(NUM_LEDS);
+  uint64_t allocations0 = heapAllocationCount();
+  for (uint8_t i = 0; entries && i < count; i++) {
+    const ClipEntry& e = entries[i];
+    uint32_t n = std::max<uint32_t>(frames / count, 1);
+    const uint8_t* end = mapped + e.offset + e.length;
+    const uint8_t* p = end;
+    uint64_t h0 = hostNanos();
+    for (uint32_t k = 0; k < n; k++) {
+      if (p == end) {
+        p = mapped + e.offset;
+      }
+      size_t used = decodeClipFrame(p, end - p, e.pixels, out.data(), NUM_LEDS);
+      p += used ? used : end - p;
+    }
+    printClipRow(e.name, e.frames, e.length, perClip[i].frames, (double)(hostNanos() - h0) / n);
+  }
+
+  // 播放路径：经 renderClipFrame() 按帧周期推进（含查找片段、按时间选帧）
+  uint8_t mode = 0;
+  if (entries && findClipMode("clip:sparkle", mode)) {
+    uint32_t decodedBefore = clipStats().framesDecoded;
+    uint64_t h0 = hostNanos();
+    for (uint32_t k = 0; k < frames; k++) {
+      renderClipFrame(mode, out.data(), NUM_LEDS, k * 1000 / 30 + 1);  // 每次恰好前进一帧
+    }
+    double playNanos = (double)(hostNanos() - h0) / frames;
+    printf("%-22s %7u %12s %8s %5s %5s %5s %10.0f %12.0f\n", "renderClipFrame",
+           clipStats().framesDecoded - decodedBefore, "", "", "", "", "", playNanos, 1e9 / playNanos);
+  }
+  uint64_t allocations = heapAllocationCount() - allocations0;
+  uint32_t totalFrames = total.frames[CLIP_FRAME_RLE] + total.frames[CLIP_FRAME_DELTA] + total.frames[CLIP_FRAME_RAW];
+  printf("\n全部 %zu 个片段：%u 帧，%zu bytes（整帧 rgb %zu bytes），解码和播放的堆分配 %llu 次\n", clips.size(),
+         totalFrames, bundle.size(), totalFrames * (size_t)NUM_LEDS * 3, (unsigned long long)allocations);
+
+  simSetPartitionFile(CLIP_PARTITION_LABEL, nullptr, 0);
+  initializeClips();
+  unlink(path.c_str());
+  return entries ? 0 : 1;
+}
+
+// program --clip-build OUT name=@rainbow name=file.rgb@fps ...：原始 rgb 文件每帧 NUM_LEDS 个像素，默认 30 fps
+static int runClipBuild(const char* outPath, const std::vector<const char*>& specs) {
+  std::vector<ClipSource> clips;
+  for (const char* spec : specs) {
+    const char* eq = strchr(spec, '=');
+    if (!eq) {
+      fprintf(stderr, "片段参数应为 name=@demo 或 name=file.rgb[@fps]: %s\n", spec);
+      return 2;
+    }
+    std::string name(spec, eq - spec);
+    std::string source = eq + 1;
+    clips.emplace_back();
+    bool loaded;
+    if (source[0] == '@') {
+      loaded = makeDemoClip(source.c_str() + 1, name.c_str(), NUM_LEDS, clips.back());
+    } else {
+      size_t at = source.rfind('@');
+      uint8_t fps = at == std::string::npos ? 30 : (uint8_t)strtoul(source.c_str() + at + 1, nullptr, 10);
+      loaded = loadRawClip(source.substr(0, at).c_str(), name.c_str(), NUM_LEDS, fps, clips.back());
+    }
+    if (!loaded) {
+      fprintf(stderr, "无法读取片段: %s\n", spec);
+      return 2;
+    }
+  }
+  std::vector<uint8_t> bundle;
+  ClipEncodeStats stats;
+  std::string error;
+  if (!buildClipBundle(clips, bundle, stats, error)) {
+    fprintf(stderr, "%s\n", error.c_str());
+    return 1;
+  }
+  FILE* f = fopen(outPath, "wb");
+  if (!f || fwrite(bundle.data(), 1, bundle.size(), f) != bundle.size()) {
+    fprintf(stderr, "无法写入 %s\n", outPath);
+    if (f) fclose(f);
+    return 1;
+  }
+  fclose(f);
+  printf("%s: %zu 个片段，%zu bytes（RLE %u 帧，DELTA %u 帧，RAW %u 帧）\n", outPath, clips.size(), bundle.size(),
+         stats.frames[CLIP_FRAME_RLE], stats.frames[CLIP_FRAME_DELTA], stats.frames[CLIP_FRAME_RAW]);
+  return 0;
+}
+
+// ==================== 固件更新 ====================
+// 同一网络速率和 flash 擦写时间下，旧的同步写入与写入任务流水线的吞吐量对照
+static int runOTABench(uint32_t imageKB) {
+  printf("固件更新：镜像 %u KB，网络 %u KB/s，每扇区擦除 %.1f ms，写入 %.1f ms/KB，%u 个扇区缓冲\n\n", imageKB,
+         OTA_TEST_NETWORK_RATE / 1024, OTA_TEST_FLASH.eraseMicros / 1000.0, OTA_TEST_FLASH.writeMicrosPerKB / 1000.0,
+         OTA_BUFFER_COUNT);
+
+  // 测试密钥对：设备只拿到公钥
+  std::mt19937 rng(25);
+  uint8_t seed[ED25519_SEED_SIZE];
+  for (uint8_t& b : seed) {
+    b = (uint8_t)rng();
+  }
+  static uint8_t publicKey[ED25519_PUBLIC_KEY_SIZE];
+  ed25519PublicKey(publicKey, seed);
+  otaSetPublicKey(publicKey);
+  std::vector<uint8_t> image = randomFirmware(rng, (size_t)imageKB * 1024);
+  std::vector<uint8_t> file = buildOTAFile(image, seed);
+  const OtaManifest* signedManifest = (const OtaManifest*)file.data();
+  uint64_t v0 = hostNanos();
+  bool verified = ed25519Verify(signedManifest->signature, file.data(), OTA_MANIFEST_SIGNED_BYTES, publicKey);
+  uint64_t verifyNanos = hostNanos() - v0;
+
+  // 对照：同步写入（写入任务尚未启动，主线程直接调用 HAL）
+  startOTASystem();
+  uint64_t t0 = simNowMicros();
+  bool synced = uploadSynchronously(image);
+  uint64_t syncMicros = simNowMicros() - t0;
+  startTasks();
+  OtaPipelineRun run = runPipelinedUpload(file);
+  std::this_thread::sleep_for(std::chrono::milliseconds(OTA_REBOOT_DELAY + 200));
+  simStopTasks();
+  const SimCounters& counters = simCounters();
+  int64_t rebootAfter = (int64_t)counters.lastRestartMicros - (int64_t)run.receivedAtMicros;
+  simSetOTATiming(SimOTATiming{0, 0});
+  simSetRealTime(false);
+  if (!verified || !synced || !run.accepted || !run.finished || run.status.state != OTA_REBOOTING) {
+    printf("更新失败（状态 %u，原因 %s）\n", run.status.state, run.status.error ? run.status.error : "-");
+    return 1;
+  }
+
+  double syncRate = image.size() / 1024.0 / (syncMicros / 1e6);
+  double pipelineRate = file.size() / 1024.0 / (run.micros / 1e6);
+  double flashRate = 1e6 / (OTA_TEST_FLASH.eraseMicros / 4.0 + OTA_TEST_FLASH.writeMicrosPerKB);
+  printf("%-20s %10s %10s %14s\n", "方式", "用时 ms", "KB/s", "接收等待");
+  printf("%-20s %10.0f %10.1f %14s\n", "同步写入（旧）", syncMicros / 1000.0, syncRate, "-");
+  printf("%-20s %10.0f %10.1f %8u 次 %3u ms\n", "流水线", run.micros / 1000.0, pipelineRate, run.status.stalls,
+         run.status.stallMillis);
+  printf("网络上限 %.0f KB/s，flash 上限 %.0f KB/s；otaReceiveDone() %.1f us，收完后 %.0f ms 重启，进度帧 %u 个\n",
+         OTA_TEST_NETWORK_RATE / 1024.0, flashRate, run.doneNanos / 1000.0, rebootAfter / 1000.0, run.progressFrames);
+  printf("清单签名验证（写入任务，主机）%.2f ms\n", verifyNanos / 1e6);
+  return 0;
+}
+
+// 私钥文件：32 字节种子的十六进制文本，只给所有者读写
+static void printPublicKeyFlag(const uint8_t seed[ED25519_SEED_SIZE]) {
+  uint8_t publicKey[ED25519_PUBLIC_KEY_SIZE];
+  ed25519PublicKey(publicKey, seed);
+  printf("-DOTA_PUBLIC_KEY=");
+  for (size_t i = 0; i < sizeof(publicKey); i++) {
+    printf("%s0x%02x", i ? "," : "", publicKey[i]);
+  }
+  printf("\n");
+}
+
+static bool readKeyFile(const char* path, uint8_t seed[ED25519_SEED_SIZE]) {
+  FILE* in = fopen(path, "r");
+  if (!in) {
+    fprintf(stderr, "无法读取私钥 %s\n", path);
+    return false;
+  }
+  char text[2 * ED25519_SEED_SIZE + 2] = {0};
+  bool ok = fgets(text, sizeof(text), in) && strspn(text, "0123456789abcdefABCDEF") == 2 * ED25519_SEED_SIZE &&
+            parseHex(text, seed, ED25519_SEED_SIZE);
+  fclose(in);
+  if (!ok) {
+    fprintf(stderr, "%s 不是 program --ota-keygen 生成的私钥\n", path);
+  }
+  return ok;
+}
+
+// program --ota-keygen ~/.ball-ota.key：已存在时不覆盖（换密钥后旧固件不再接受新签名的更新）
+static int runOTAKeygen(const char* keyPath) {
+  uint8_t seed[ED25519_SEED_SIZE];
+  FILE* random = fopen("/dev/urandom", "rb");
+  bool ok = random && fread(seed, 1, sizeof(seed), random) == sizeof(seed);
+  if (random) fclose(random);
+  if (!ok) {
+    fprintf(stderr, "无法读取 /dev/urandom\n");
+    return 1;
+  }
+  int fd = open(keyPath, O_WRONLY | O_CREAT | O_EXCL, 0600);
+  if (fd < 0) {
+    fprintf(stderr, "无法创建 %s（已存在时不覆盖）\n", keyPath);
+    return 1;
+  }
+  std::string text = hexText(seed, sizeof(seed)) + "\n";
+  ok = write(fd, text.data(), text.size()) == (ssize_t)text.size();
+  ok = close(fd) == 0 && ok;
+  if (!ok) {
+    fprintf(stderr, "无法写入 %s\n", keyPath);
+    return 1;
+  }
+  printf("私钥已写入 %s，不要放进仓库。构建固件时加上（例如 PLATFORMIO_BUILD_FLAGS）：\n", keyPath);
+  printPublicKeyFlag(seed);
+  return 0;
+}
+
+// program --ota-sign firmware.bin out.ota KEYFILE：清单 + 镜像，经 Web 页面或 POST /update 上传
+static int runOTASign(const char* inPath, const char* outPath, const char* keyPath) {
+  uint8_t seed[ED25519_SEED_SIZE];
+  if (!readKeyFile(keyPath, seed)) {
+    return 2;
+  }
+  FILE* in = fopen(inPath, "rb");
+  if (!in) {
+    fprintf(stderr, "无法读取 %s\n", inPath);
+    return 2;
+  }
+  std::vector<uint8_t> image;
+  uint8_t buffer[4096];
+  size_t n;
+  while ((n = fread(buffer, 1, sizeof(buffer), in)) > 0) {
+    image.insert(image.end(), buffer, buffer + n);
+  }
+  fclose(in);
+  if (image.empty() || image[0] != 0xE9) {
+    fprintf(stderr, "%s 不是 ESP32 固件镜像\n", inPath);
+    return 1;
+  }
+  std::vector<uint8_t> file = buildOTAFile(image, seed);
+  FILE* out = fopen(outPath, "wb");
+  if (!out || fwrite(file.data(), 1, file.size(), out) != file.size()) {
+    fprintf(stderr, "无法写入 %s\n", outPath);
+    if (out) fclose(out);
+    return 1;
+  }
+  fclose(out);
+  const OtaManifest* manifest = (const OtaManifest*)file.data();
+  printf("%s: 镜像 %zu bytes，SHA-256 ", outPath, image.size());
+  for (uint8_t b : manifest->sha256) {
+    printf("%02x", b);
+  }
+  printf("\n设备固件须以对应的公钥构建：");
+  printPublicKeyFlag(seed);
+  return 0;
+}
+
+// ==================== 入口 ====================
+int main(int argc, char** argv) {
+  uint32_t iterations = 20000;
+  SimBrokerState broker = SIM_BROKER_UP;
+  bool wireTiming = true;
+  bool verbose = false;
+  uint32_t stressSeconds = 0;
+  uint32_t serializerIterations = 0;
+  bool bootBench = false;
+  bool outboxBench = false;
+  uint32_t traceIterations = 0;
+  uint32_t ruleRounds = 0;
+  uint32_t effectFrames = 0;
+  uint32_t ledFrames = 0;
+  bool layoutBench = false;
+  uint32_t logIterations = 0;
+  uint32_t wsSeconds = 0;
+  uint32_t replayBenchSeconds = 0;
+  const char* replayPath = nullptr;
+  const char* goldenPath = nullptr;
+  bool updateGolden = false;
+  uint32_t powerSeconds = 0;
+  uint32_t buttonIterations = 0;
+  uint32_t commandIterations = 0;
+  uint32_t clipFrames = 0;
+  const char* clipBuildPath = nullptr;
+  std::vector<const char*> clipSpecs;
+  uint32_t otaKB = 0;
+  const char* otaSignIn = nullptr;
+  const char* otaSignOut = nullptr;
+  const char* otaSignKey = nullptr;
+  const char* otaKeygenPath = nullptr;
+
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--iterations") && i + 1 < argc) {
+      iterations = (uint32_t)strtoul(argv[++i], nullptr, 10);
+    } else if (!strcmp(argv[i], "--broker") && i + 1 < argc) {
+      const char* mode = argv[++i];
+      broker = !strcmp(mode, "refused") ? SIM_BROKER_REFUSED :
+               !strcmp(mode, "blackhole") ? SIM_BROKER_BLACKHOLE : SIM_BROKER_UP;
+    } else if (!strcmp(argv[i], "--no-wire-timing")) {
+      wireTiming = false;
+    } else if (!strcmp(argv[i], "--stress") && i + 1 < argc) {
+      stressSeconds = (uint32_t)strtoul(argv[++i], nullptr, 10);
+    } else if (!strcmp(argv[i], "--serializer") && i + 1 < argc) {
+      serializerIterations = (uint32_t)strtoul(argv[++i], nullptr, 10);
+    } else if (!strcmp(argv[i], "--boot")) {
+      bootBench = true;
+    } else if (!strcmp(argv[i], "--outbox")) {
+      outboxBench = true;
+    } else if (!strcmp(argv[i], "--log") && i + 1 < argc) {
+      logIterations = (uint32_t)strtoul(argv[++i], nullptr, 10);
+    } else if (!strcmp(argv[i], "--ws") && i + 1 < argc) {
+      wsSeconds = (uint32_t)strtoul(argv[++i], nullptr, 10);
+    } else if (!strcmp(argv[i], "--replay-bench") && i + 1 < argc) {
+      replayBenchSeconds = (uint32_t)strtoul(argv[++i], nullptr, 10);
+    } else if (!strcmp(argv[i], "--buttons") && i + 1 < argc) {
+      buttonIterations = (uint32_t)strtoul(argv[++i], nullptr, 10);
+    } else if (!strcmp(argv[i], "--commands") && i + 1 < argc) {
+      commandIterations = (uint32_t)strtoul(argv[++i], nullptr, 10);
+    } else if (!strcmp(argv[i], "--clips") && i + 1 < argc) {
+      clipFrames = (uint32_t)strtoul(argv[++i], nullptr, 10);
+    } else if (!strcmp(argv[i], "--clip-build") && i + 1 < argc) {
+      clipBuildPath = argv[++i];
+      while (i + 1 < argc && strncmp(argv[i + 1], "--", 2) != 0) {
+        clipSpecs.push_back(argv[++i]);
+      }
+    } else if (!strcmp(argv[i], "--ota") && i + 1 < argc) {
+      otaKB = (uint32_t)strtoul(argv[++i], nullptr, 10);
+    } else if (!strcmp(argv[i], "--ota-sign") && i + 3 < argc) {
+      otaSignIn = argv[++i];
+      otaSignOut = argv[++i];
+      otaSignKey = argv[++i];
+    } else if (!strcmp(argv[i], "--ota-keygen") && i + 1 < argc) {
+      otaKeygenPath = argv[++i];
+    } else if (!strcmp(argv[i], "--power") && i + 1 < argc) {
+      powerSeconds = (uint32_t)strtoul(argv[++i], nullptr, 10);
+    } else if (!strcmp(argv[i], "--replay") && i + 1 < argc) {
+      replayPath = argv[++i];
+    } else if (!strcmp(argv[i], "--golden") && i + 1 < argc) {
+      goldenPath = argv[++i];
+    } else if (!strcmp(argv[i], "--update-golden")) {
+      updateGolden = true;
+    } else if (!strcmp(argv[i], "--layout")) {
+      layoutBench = true;
+    } else if (!strcmp(argv[i], "--leds") && i + 1 < argc) {
+      ledFrames = (uint32_t)strtoul(argv[++i], nullptr, 10);
+    } else if (!strcmp(argv[i], "--effects") && i + 1 < argc) {
+      effectFrames = (uint32_t)strtoul(argv[++i], nullptr, 10);
+    } else if (!strcmp(argv[i], "--rules") && i + 1 < argc) {
+      ruleRounds = (uint32_t)strtoul(argv[++i], nullptr, 10);
+    } else if (!strcmp(argv[i], "--trace") && i + 1 < argc) {
+      traceIterations = (uint32_t)strtoul(argv[++i], nullptr, 10);
+    } else if (!strcmp(argv[i], "--verbose")) {
+      verbose = true;
+    } else {
+      fprintf(stderr, "未知参数: %s\n", argv[i]);
+      return 2;
+    }
+  }
+
+  if (bootBench) {
+    simSetSerialEcho(verbose);
+    return runBootBench();
+  }
+
+  if (logIterations > 0) {
+    return runLogBench(logIterations);
+  }
+
+  if (wsSeconds > 0) {
+    return runWebSocketLoadBench(wsSeconds);
+  }
+
+  if (replayBenchSeconds > 0) {
+    return runReplayBench(replayBenchSeconds);
+  }
+
+  if (powerSeconds > 0) {
+    return runPowerBench(powerSeconds);
+  }
+
+  if (commandIterations > 0) {
+    return runCommandsBench(commandIterations);
+  }
+
+  if (clipFrames > 0) {
+    return runClipsBench(clipFrames);
+  }
+
+  if (clipBuildPath) {
+    return runClipBuild(clipBuildPath, clipSpecs);
+  }
+
+  if (otaKB > 0) {
+    return runOTABench(otaKB);
+  }
+
+  if (otaKeygenPath) {
+    return runOTAKeygen(otaKeygenPath);
+  }
+  if (otaSignIn) {
+    return runOTASign(otaSignIn, otaSignOut, otaSignKey);
+  }
+
+  if (replayPath) {
+    return runReplay(replayPath, goldenPath, updateGolden);
+  }
+
+  if (layoutBench) {
+    return runLayoutBench();
+  }
+
+  if (ledFrames > 0) {
+    return runLEDBench(ledFrames);
+  }
+
+  if (effectFrames > 0) {
+    return runEffectsBench(effectFrames);
+  }
+
+  if (ruleRounds > 0) {
+    return runRulesBench(ruleRounds);
+  }
+
+  if (buttonIterations > 0) {
+    return runButtonsBench(buttonIterations);
+  }
+
+  if (traceIterations > 0) {
+    return runTraceBench(traceIterations);
+  }
+
+  if (outboxBench) {
+    simSetSerialEcho(verbose);
+    return runOutboxBench();
+  }
+
+  if (serializerIterations > 0) {
+    return runSerializerBench(serializerIterations);
+  }
+
+  if (stressSeconds > 0) {
+    simSetSerialEcho(verbose);
+    return runStress(stressSeconds, wireTiming);
+  }
+
+  simReset();
+  simSetSerialEcho(verbose);
+  simSetLEDWireTiming(wireTiming);
+  simSetMQTTBroker(broker);
+  initializeSystem();
+
+  Scheduler::setObserver(observeJob);
+  simSetWebSocketHook(observeWebSocketFrame);
+  wsClientConnected(simWebSocketConnect(0));  // 一个不限速的页面
+
+  Samples wakeHost;
+  Samples wakeVirt;
+  wakeHost.values.reserve(iterations);
+  wakeVirt.values.reserve(iterations);
+
+  uint64_t startMicros = simNowMicros();
+  uint64_t scheduledUntil = startMicros;
+  for (uint32_t n = 0; n < iterations; n++) {
+    uint64_t wakeMicros = simNowMicros();
+    if (wakeMicros + SCENARIO_PERIOD_MS * 1000ULL > scheduledUntil) {
+      scheduleScenario(scheduledUntil, scheduledUntil + SCENARIO_PERIOD_MS * 1000ULL);
+      scheduledUntil += SCENARIO_PERIOD_MS * 1000ULL;
+    }
+
+    uint64_t wakeStartHost = hostNanos();
+    mainLoop();
+    wakeHost.values.push_back(hostNanos() - wakeStartHost);
+    wakeVirt.values.push_back(simNowMicros() - wakeMicros);
+  }
+
+  const SimCounters& c = simCounters();
+  uint64_t elapsedMicros = simNowMicros() - startMicros;
+  double virtualSeconds = elapsedMicros / 1e6;
+  uint64_t busyMicros = 0;
+  for (JobSamples& samples : jobSamples) {
+    for (uint64_t v : samples.virt.values) busyMicros += v;
+  }
+
+  printf("mainLoop 基准：%u 次唤醒，虚拟时长 %.1f s\n\n", iterations, virtualSeconds);
+  printf("%-22s %10s %10s %10s %10s %10s %8s %6s %10s\n", "job",
+         "host p50ns", "host p99ns", "virt p50us", "virt p99us", "virt maxus",
+         "runs", "misses", "late maxus");
+  printJobRows(renderScheduler);
+  printJobRows(networkScheduler);
+  printRow("mainLoop (wakeup)", wakeHost, wakeVirt);
+  printf("\n\n唤醒: %.1f 次/s，空闲 %.1f%%（作业占用虚拟时间 %.1f%%）\n",
+         iterations / virtualSeconds,
+         100.0 - 100.0 * busyMicros / elapsedMicros, 100.0 * busyMicros / elapsedMicros);
+  printf("灯带发送: %u 帧 (%.1f/s)，数据线占用 %.1f%%（后台发送，不计入作业耗时）\n", c.ledShows,
+         c.ledShows / virtualSeconds, 100.0 * c.ledWireMicros / (virtualSeconds * 1e6));
+  printf("帧合成器: 推送 %u 帧，跳过 %u 帧\n",
+         compositorStats().framesRendered, compositorStats().framesSkipped);
+  printf("按钮事件: 捕获 %u，丢弃 %u，溢出 %u，最大队列深度 %u\n",
+         buttonEventStats().captured, buttonEventStats().dropped,
+         buttonEventStats().overflows, buttonEventStats().maxDepth);
+  uint64_t networkStall = 0;
+  for (uint8_t i = 0; i < networkScheduler.jobCount(); i++) {
+    networkStall = std::max(networkStall, samplesFor(networkScheduler.job(i)).virt.max());
+  }
+  const MQTTStats& mqtt = mqttStats();
+  printf("MQTT: %u 次连接尝试（成功 %u，失败 %u，掉线 %u，最近退避 %u ms），%u 条发布\n",
+         c.mqttConnectAttempts, mqtt.connects, mqtt.failures, mqtt.drops,
+         mqtt.lastBackoffMillis, c.mqttPublishes);
+  printf("网络作业最大阻塞: %llu us\n", (unsigned long long)networkStall);
+  const OutboxStats& outbox = mqttOutboxStats();
+  printf("MQTT 待发缓冲区: 入队 %u，合并 %u，丢弃 %u，积压 %u（最大 %u），最大 lag %u ms\n",
+         outbox.enqueued, outbox.coalesced, outbox.dropped, outbox.depth, outbox.maxDepth,
+         outbox.maxLagMillis);
+  printf("WebSocket: %u 帧（%.1f/s，关键帧 %u），%llu 字节",
+         c.wsFrames, c.wsFrames / virtualSeconds, webSocketKeyframes, (unsigned long long)c.wsBytes);
+  if (!webSocketLatency.values.empty()) {
+    printf("，状态变化→推送延迟 p50 %llu ms，max %llu ms",
+           (unsigned long long)webSocketLatency.percentile(0.50),
+           (unsigned long long)webSocketLatency.max());
+  }
+  printf("\n");
+  printf("Serial: %u 字节\n\n", c.serialBytes);
+  printMetricRows();
+  printf("\n");
+  printf("启动耗时: 首次按钮扫描 %.1f ms，首帧 %.1f ms，WiFi %.1f ms，MQTT就绪 %.1f ms\n",
+         millisOf(bootTimings.firstInputMicros), millisOf(bootTimings.firstFrameMicros),
+         millisOf(bootTimings.wifiConnectedMicros), millisOf(bootTimings.mqttReadyMicros));
+  return 0;
+}
+#endif // PIO_UNIT_TESTING
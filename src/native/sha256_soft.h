@@ -0,0 +1,124 @@
+#ifndef SHA256_SOFT_H
+#define SHA256_SOFT_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+// ==================== SHA-256（主机） ====================
+// 纯软件的增量 SHA-256，只在主机构建中使用（经 sha256.h 引入）：模拟后端的 OTA 流水线和 program --ota-sign
+// 生成清单。固件里用 mbedtls（见 sha256.h）。不分配内存。
+
+#define SHA256_DIGEST_SIZE 32
+#define SHA256_BLOCK_SIZE 64
+
+class Sha256 {
+public:
+  Sha256() { reset(); }
+
+  void reset() {
+    static constexpr uint32_t INIT[8] = {
+      0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+    };
+    memcpy(state_, INIT, sizeof(state_));
+    bytes_ = 0;
+    buffered_ = 0;
+  }
+
+  void update(const uint8_t* data, size_t length) {
+    bytes_ += length;
+    if (buffered_) {
+      size_t n = SHA256_BLOCK_SIZE - buffered_ < length ? SHA256_BLOCK_SIZE - buffered_ : length;
+      memcpy(block_ + buffered_, data, n);
+      buffered_ += n;
+      data += n;
+      length -= n;
+      if (buffered_ < SHA256_BLOCK_SIZE) {
+        return;
+      }
+      compress(block_);
+      buffered_ = 0;
+    }
+    for (; length >= SHA256_BLOCK_SIZE; data += SHA256_BLOCK_SIZE, length -= SHA256_BLOCK_SIZE) {
+      compress(data);
+    }
+    memcpy(block_, data, length);
+    buffered_ = length;
+  }
+
+  // 之后需要 reset() 才能重新使用
+  void finish(uint8_t digest[SHA256_DIGEST_SIZE]) {
+    uint64_t bits = bytes_ * 8;
+    uint8_t pad[SHA256_BLOCK_SIZE + 8] = {0x80};
+    size_t padLength = (buffered_ < 56 ? 56 : 120) - buffered_;
+    for (int i = 0; i < 8; i++) {
+      pad[padLength + i] = (uint8_t)(bits >> (56 - 8 * i));
+    }
+    update(pad, padLength + 8);
+    for (int i = 0; i < 8; i++) {
+      putWord(digest + 4 * i, state_[i]);
+    }
+  }
+
+private:
+  static uint32_t rotr(uint32_t x, int n) { return (x >> n) | (x << (32 - n)); }
+
+  static void putWord(uint8_t* out, uint32_t w) {
+    out[0] = (uint8_t)(w >> 24);
+    out[1] = (uint8_t)(w >> 16);
+    out[2] = (uint8_t)(w >> 8);
+    out[3] = (uint8_t)w;
+  }
+
+  void compress(const uint8_t* block) {
+    static constexpr uint32_t K[64] = {
+      0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+      0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+      0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+      0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+      0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+      0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+      0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+      0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+    };
+    uint32_t w[64];
+    for (int i = 0; i < 16; i++) {
+      w[i] = (uint32_t)block[4 * i] << 24 | (uint32_t)block[4 * i + 1] << 16 |
+             (uint32_t)block[4 * i + 2] << 8 | block[4 * i + 3];
+    }
+    for (int i = 16; i < 64; i++) {
+      uint32_t s0 = rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+      uint32_t s1 = rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+      w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+    uint32_t a = state_[0], b = state_[1], c = state_[2], d = state_[3];
+    uint32_t e = state_[4], f = state_[5], g = state_[6], h = state_[7];
+    for (int i = 0; i < 64; i++) {
+      uint32_t t1 = h + (rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25)) + ((e & f) ^ (~e & g)) + K[i] + w[i];
+      uint32_t t2 = (rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+      h = g;
+      g = f;
+      f = e;
+      e = d + t1;
+      d = c;
+      c = b;
+      b = a;
+      a = t1 + t2;
+    }
+    state_[0] += a;
+    state_[1] += b;
+    state_[2] += c;
+    state_[3] += d;
+    state_[4] += e;
+    state_[5] += f;
+    state_[6] += g;
+    state_[7] += h;
+  }
+
+  uint32_t state_[8];
+  uint64_t bytes_;
+  uint8_t block_[SHA256_BLOCK_SIZE];
+  size_t buffered_;
+};
+
+#endif // SHA256_SOFT_H
@@ -0,0 +1,1089 @@
+// ==================== 模拟场景 ====================
+// 见 sim_scenarios.h。从 main_native.cpp 的各个 --mode 中提出来，test/ 下的用例和 program 共用
+#include "sim_scenarios.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <new>
+#include <thread>
+#include "led_compositor.h"
+#include "button_events.h"
+#include "tasks.h"
+#include "ws_protocol.h"
+#include "wifi_manager.h"
+#include "mqtt_manager.h"
+#include "mqtt_outbox.h"
+#include "metrics.h"
+#include "button_rules.h"
+#include "effects.h"
+#include "power.h"
+#include "mqtt_commands.h"
+#include "clips.h"
+#include "sector_ring.h"
+#include "sha256.h"
+
+// ==================== 堆分配计数 ====================
+// 替换全局 operator new，统计整个进程的堆分配次数
+static std::atomic<uint64_t> heapAllocations(0);
+
+void* operator new(size_t size) {
+  heapAllocations.fetch_add(1, std::memory_order_relaxed);
+  void* p = malloc(size ? size : 1);
+  if (!p) throw std::bad_alloc();
+  return p;
+}
+
+void operator delete(void* p) noexcept {
+  free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+  free(p);
+}
+
+uint64_t heapAllocationCount() {
+  return heapAllocations.load();
+}
+
+uint64_t hostNanos() {
+  return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// ==================== 运行 ====================
+void runUntil(uint64_t untilMicros, bool stopWhenMQTTReady) {
+  while (simNowMicros() < untilMicros) {
+    if (stopWhenMQTTReady && bootTimings.mqttReadyMicros != BOOT_MILESTONE_PENDING) {
+      return;
+    }
+    mainLoop();
+  }
+}
+
+void runForMillis(uint32_t ms) {
+  runUntil(simNowMicros() + ms * 1000ULL, false);
+}
+
+void bootUntilMQTTReady() {
+  simReset();
+  initializeSystem();
+  runUntil(30000000ULL, true);
+}
+
+// ==================== 按钮场景 ====================
+struct ScenarioStep {
+  uint32_t atMs;
+  uint8_t pin;
+  int level;
+};
+
+static const ScenarioStep SCENARIO[] = {
+  {1000, 12, LOW}, {1400, 14, LOW}, {1800, 25, LOW}, {2200, 26, LOW}, {2600, 27, LOW},
+  {4000, 12, HIGH}, {4000, 14, HIGH}, {4000, 25, HIGH}, {4000, 26, HIGH}, {4000, 27, HIGH},
+  {5000, 13, LOW}, {5001, 13, HIGH}, {5002, 13, LOW}, {5004, 13, HIGH}, {5005, 13, LOW},
+  {6000, 13, HIGH},
+  {7000, 32, LOW}, {7500, 32, HIGH}
+};
+static const size_t SCENARIO_LENGTH = sizeof(SCENARIO) / sizeof(SCENARIO[0]);
+
+void scheduleScenario(uint64_t fromMicros, uint64_t toMicros) {
+  for (uint64_t base = (fromMicros / 1000 / SCENARIO_PERIOD_MS) * SCENARIO_PERIOD_MS;
+       base * 1000 <= toMicros; base += SCENARIO_PERIOD_MS) {
+    for (size_t i = 0; i < SCENARIO_LENGTH; i++) {
+      uint64_t at = (base + SCENARIO[i].atMs) * 1000;
+      if (at > fromMicros && at <= toMicros) {
+        simSchedulePin(SCENARIO[i].pin, SCENARIO[i].level, at);
+      }
+    }
+  }
+}
+
+uint32_t scheduleBouncyEdge(std::mt19937& rng, uint8_t pin, int level, uint64_t atMicros) {
+  uint32_t bounces = 2 + rng() % 5;
+  uint32_t edges = 0;
+  for (uint32_t b = 0; b < bounces; b++, edges += 2) {
+    simSchedulePin(pin, level, atMicros);
+    atMicros += 50 + rng() % 350;
+    simSchedulePin(pin, !level, atMicros);
+    atMicros += 50 + rng() % 350;
+  }
+  simSchedulePin(pin, level, atMicros);
+  return edges + 1;
+}
+
+uint32_t scheduleSyntheticPresses(std::mt19937& rng, uint64_t fromMicros, uint64_t toMicros) {
+  uint32_t edges = 0;
+  uint64_t at = fromMicros;
+  while (true) {
+    at += (50 + rng() % 1450) * 1000ULL;
+    uint64_t hold = (80 + rng() % 520) * 1000ULL;
+    if (at + hold + 10000 > toMicros) {
+      return edges;
+    }
+    uint8_t pin = BUTTON_PINS[rng() % BTN_COUNT];
+    edges += scheduleBouncyEdge(rng, pin, LOW, at);
+    if (rng() % 4 == 0) {
+      uint8_t other = BUTTON_PINS[rng() % BTN_COUNT];
+      if (other != pin) {
+        edges += scheduleBouncyEdge(rng, other, LOW, at + hold / 3);
+        edges += scheduleBouncyEdge(rng, other, HIGH, at + hold * 2 / 3);
+      }
+    }
+    at += hold;
+    edges += scheduleBouncyEdge(rng, pin, HIGH, at);
+  }
+}
+
+// ==================== MQTT ====================
+std::string commandTopic(const char* prefix, const char* name) {
+  return std::string(prefix) + "/cmd/" + name;
+}
+
+void deliverCommand(const std::string& topic, const std::string& payload) {
+  simMQTTDeliver(topic.c_str(), (const uint8_t*)payload.data(), (unsigned int)payload.size());
+}
+
+static std::vector<std::string> recordedTopics;
+
+static void observeRecordedPublish(const char* topic, const char*, uint64_t) {
+  if (strncmp(topic, MQTT_TOPIC_METRICS, strlen(MQTT_TOPIC_METRICS)) != 0) {
+    recordedTopics.push_back(topic);
+  }
+}
+
+void beginTopicRecording() {
+  recordedTopics.clear();
+  simSetPublishHook(observeRecordedPublish);
+}
+
+std::vector<std::string> endTopicRecording() {
+  simSetPublishHook(nullptr);
+  std::vector<std::string> topics;
+  topics.swap(recordedTopics);
+  return topics;
+}
+
+// ==================== 旧版按钮逻辑 ====================
+uint32_t legacyEvaluate(LegacyLogic& s, uint32_t pressed) {
+  uint32_t events = 0;
+  uint32_t changed = (pressed ^ s.initialPressedMask) & FIRST_TRIGGER_BUTTONS_MASK;
+  for (uint8_t i = 0; changed; i++, changed >>= 1) {
+    if (changed & 1) events = events * 4 + 1 + MQTT_EVENT_FIRST_TRIGGERED;
+  }
+  s.initialPressedMask = pressed & FIRST_TRIGGER_BUTTONS_MASK;
+
+  int greenPressedCount = __builtin_popcount(pressed & GREEN_BUTTONS_MASK);
+  if (pressed & BUTTON_MASK(FAULT_BUTTON)) {
+    s.ledMode = LED_FLASH_YELLOW;
+    s.previousAllPinsTriggered = false;
+    s.previousP32Triggered = false;
+  } else if (pressed & BUTTON_MASK(RESET_BUTTON)) {
+    s.ledMode = LED_BREATHE_RED;
+    if (!s.previousP32Triggered) {
+      events = events * 4 + 1 + MQTT_EVENT_RESET;
+      s.previousP32Triggered = true;
+    }
+    s.previousAllPinsTriggered = false;
+  } else if (greenPressedCount > 0) {
+    s.brightness = greenPressedCount * GREEN_BRIGHTNESS_STEP;
+    s.ledMode = LED_BREATHE_GREEN;
+    bool allGreen = (pressed & GREEN_BUTTONS_MASK) == GREEN_BUTTONS_MASK;
+    if (allGreen && !s.previousAllPinsTriggered) {
+      events = events * 4 + 1 + MQTT_EVENT_TRIGGERED;
+    }
+    s.previousAllPinsTriggered = allGreen;
+    s.previousP32Triggered = false;
+  } else {
+    s.ledMode = LED_BREATHE_RED;
+    s.brightness = 0;
+    s.previousAllPinsTriggered = false;
+    s.previousP32Triggered = false;
+  }
+  return events;
+}
+
+uint32_t ruleEvaluate(uint32_t pressed) {
+  buttonInput.pressed = pressed;
+  handleButtonLogic();
+  uint32_t events = 0;
+  OutboundMessage message;
+  while (takeMQTTMessage(message)) {
+    events = events * 4 + 1 + message.event;
+  }
+  return events;
+}
+
+bool sameOutput(const LegacyLogic& legacy, uint32_t legacyEvents, uint32_t ruleEvents) {
+  return legacy.ledMode == ledController.mode && legacy.brightness == ledController.greenBreathBrightness &&
+         legacyEvents == ruleEvents;
+}
+
+bool defaultButtonPins() {
+  static const uint8_t DEFAULT_PINS[] = {13, 12, 14, 27, 26, 25, 32};
+  return BTN_COUNT == sizeof(DEFAULT_PINS) && !memcmp(BUTTON_PINS, DEFAULT_PINS, BTN_COUNT);
+}
+
+static const uint8_t* volatile runtimePins = BUTTON_PINS;
+static volatile uint8_t runtimeButtonCount = BTN_COUNT;
+
+uint32_t loopPressedMask(uint64_t levels) {
+  const uint8_t* pins = runtimePins;
+  uint8_t count = runtimeButtonCount;
+  uint32_t mask = 0;
+  for (uint8_t i = 0; i < count; i++) {
+    if (!((levels >> pins[i]) & 1)) mask |= BUTTON_MASK(i);
+  }
+  return mask;
+}
+
+void loopStateJSON(TextWriter& out, const BallSnapshot& state) {
+  const uint8_t* pins = runtimePins;
+  uint8_t count = runtimeButtonCount;
+  out.put('{');
+  for (uint8_t i = 0; i < count; i++) {
+    out.raw(i ? ",\"p" : "\"p").u32(pins[i]).raw("\":").boolean(state.pressed & BUTTON_MASK(i));
+  }
+  out.put('}');
+}
+
+// ==================== 延迟追踪 ====================
+void saturateMetricHistograms() {
+  for (uint8_t m = 0; m < NUM_METRICS; m++) {
+    Histogram& h = const_cast<Histogram&>(metricHistogram(m));
+    for (uint8_t b = 0; b < METRIC_BUCKETS; b++) {
+      h.buckets[b] = UINT32_MAX / METRIC_BUCKETS;
+    }
+    h.count = UINT32_MAX;
+    h.max = UINT32_MAX;
+    h.sum = UINT64_MAX;
+  }
+}
+
+// ==================== 并发压力 ====================
+static bool snapshotConsistent(const BallSnapshot& state) {
+  if (state.pressed & ~ALL_BUTTONS_MASK) return false;
+  if (state.ledMode >= NUM_LED_MODES) return false;
+  if (state.ledMode == LED_BREATHE_GREEN) {
+    // 绿色呼吸时亮度必须与同一时刻的按钮掩码一致，撕裂读会破坏这个关系
+    if (state.pressed & (BUTTON_MASK(FAULT_BUTTON) | BUTTON_MASK(RESET_BUTTON))) return false;
+    if (state.greenBreathBrightness !=
+        __builtin_popcount(state.pressed & GREEN_BUTTONS_MASK) * GREEN_BRIGHTNESS_STEP) {
+      return false;
+    }
+  }
+  return true;
+}
+
+StressRun runStressTasks(uint32_t seconds, bool wireTiming) {
+  simReset();
+  simSetRealTime(true);
+  simSetLEDWireTiming(wireTiming);
+  simSetWiFiTiming(SimWiFiTiming{50, 10, 5});  // 压力测试不关心连接耗时
+  initializeSystem();
+  startTasks();
+
+  // 等连上后再开始翻转引脚
+  while (!halMQTTConnected()) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+
+  std::atomic<bool> stimulating(true);
+  std::thread stimulus([&stimulating]() {
+    std::mt19937 rng(12345);
+    while (stimulating) {
+      uint8_t index = rng() % BTN_COUNT;
+      simSetPin(BUTTON_PINS[index], simGetPin(BUTTON_PINS[index]) == LOW ? HIGH : LOW);
+      std::this_thread::sleep_for(std::chrono::microseconds(rng() % 20000));
+    }
+  });
+
+  StressRun run = {0, 0};
+  uint32_t lastMillis = 0;
+  uint64_t endMicros = simNowMicros() + (uint64_t)seconds * 1000000;
+  while (simNowMicros() < endMicros) {
+    BallSnapshot state;
+    readStateSnapshot(state);
+    if (!snapshotConsistent(state) || state.updatedMillis < lastMillis) {
+      run.violations++;
+    }
+    lastMillis = state.updatedMillis;
+    run.reads++;
+  }
+
+  stimulating = false;
+  stimulus.join();
+  simStopTasks();
+  do {
+    updateMQTTClient();  // 发送停止时仍在队列中的消息
+  } while (mqttOutboxStats().depth > 0);
+  simSetRealTime(false);
+  return run;
+}
+
+// ==================== LED 双缓冲 ====================
+// 第 f 帧整条灯带为同一颜色，分量取 6 的倍数，乘 LED_BRIGHTNESS 后仍互不相同
+static CRGB checkFrameColor(uint32_t f) {
+  return CRGB(6 * (f % 43), 6 * ((f / 43) % 43), 6);
+}
+
+LedPushRun pushFramesFasterThanWire(uint32_t frames) {
+  simReset();
+  simSetLEDWireTiming(true);
+  initializeSystem();
+  const CompositorStats base = compositorStats();
+  LedPushRun run = {};
+  run.frames = frames;
+  run.wireMicros = ledLayoutFrameMicros(compositorLayout());
+
+  std::mt19937 rng(3);
+  for (uint32_t f = 0; f < frames; f++) {
+    fill_solid(leds, ledCount, checkFrameColor(f));
+    uint64_t v0 = simNowMicros();
+    uint64_t h0 = hostNanos();
+    compositorPresent();
+    run.presentHostNanos += hostNanos() - h0;
+    run.presentVirtualMicros += simNowMicros() - v0;
+
+    // 下一帧在 0.2-2 倍发送时间后到来：大部分时候上一帧还没发完
+    simAdvanceMicros(run.wireMicros / 5 + rng() % (run.wireMicros * 2));
+    if (halLEDTakeEvent()) {
+      compositorFrameDone();
+    }
+
+    // 灯带上显示的帧必须整条来自同一次推送
+    const uint8_t* shown = simLEDDisplayed(0);
+    if (shown) {
+      for (uint16_t i = 1; i < ledCount; i++) {
+        if (memcmp(shown, shown + 3 * i, 3) != 0) {
+          run.mixedFrames++;
+          break;
+        }
+      }
+    }
+  }
+  // 最后可能还有一帧挂起：完成信号启动它，再等它发完
+  for (int i = 0; i < 2; i++) {
+    simAdvanceMicros(run.wireMicros * 2);
+    if (halLEDTakeEvent()) {
+      compositorFrameDone();
+    }
+  }
+
+  const CompositorStats& s = compositorStats();
+  run.rendered = s.framesRendered - base.framesRendered;
+  run.dropped = s.framesDropped - base.framesDropped;
+  run.completed = s.framesCompleted - base.framesCompleted;
+  return run;
+}
+
+// ==================== 灯带布局 ====================
+std::string splitLayoutJSON(uint16_t pixels, uint8_t channels) {
+  std::string json = "{\"channels\": [";
+  for (uint8_t c = 0; c < channels; c++) {
+    json += std::string(c ? ", " : "") + "{\"pin\": " + std::to_string(16 + c) + ", \"order\": \"grb\"}";
+  }
+  json += "], \"segments\": [";
+  uint16_t per = pixels / channels;
+  for (uint8_t c = 0; c < channels; c++) {
+    json += std::string(c ? ", " : "") + "{\"channel\": " + std::to_string(c) + ", \"start\": " +
+            std::to_string(c * per) + ", \"count\": " + std::to_string(per) +
+            ", \"reverse\": " + (c % 2 ? "true" : "false") + "}";
+  }
+  return json + "]}";
+}
+
+bool wireMatches(uint8_t channel, uint16_t position, uint16_t i, uint16_t order) {
+  const uint8_t* shown = simLEDDisplayed(channel);
+  const uint8_t* pixel = (const uint8_t*)&leds[i];
+  for (uint8_t k = 0; k < 3; k++) {
+    if (!shown || shown[position * 3 + k] != scale8(pixel[(order >> (3 * (2 - k))) & 0x3], LED_BRIGHTNESS)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void waitForFrame() {
+  while (!halLEDTakeEvent()) {
+    simAdvanceMicros(50);
+  }
+  compositorFrameDone();
+}
+
+LayoutRun runSplitLayout(uint16_t pixels, uint8_t channels) {
+  simReset();
+  simWriteFile(LED_LAYOUT_FILE_PATH, splitLayoutJSON(pixels, channels).c_str());
+  initializeSystem();
+  simWriteFile(LED_LAYOUT_FILE_PATH, nullptr);
+  waitForFrame();
+
+  const Effect& effect = ledModeEffect(LED_GRADIENT);
+  uint32_t frames = 0;
+  uint64_t presentNanos = 0;
+  uint64_t start = simNowMicros();
+  while (simNowMicros() - start < 1000000) {
+    renderEffect(effect, leds, ledCount, (uint32_t)(simNowMicros() / 1000), 255);
+    uint64_t h0 = hostNanos();
+    compositorPresent();
+    presentNanos += hostNanos() - h0;
+    waitForFrame();
+    frames++;
+  }
+  LayoutRun run;
+  run.pixels = ledCount;
+  run.frameMicros = ledLayoutFrameMicros(compositorLayout());
+  run.fps = frames * 1e6 / (simNowMicros() - start);
+  run.presentNanos = (double)presentNanos / frames;
+  run.bytesPerPixel = (double)compositorMemoryBytes() / ledCount;
+  return run;
+}
+
+// ==================== MQTT 待发缓冲区 ====================
+static PublishLog publishes;
+
+const PublishLog& publishLog() {
+  return publishes;
+}
+
+static uint32_t payloadField(const char* payload, const char* name) {
+  const char* at = strstr(payload, name);
+  return at ? (uint32_t)strtoul(at + strlen(name), nullptr, 10) : 0;
+}
+
+static void observePublish(const char*, const char* payload, uint64_t) {
+  if (strncmp(payload, "{\"seq\":", 7) != 0) {
+    return;  // 延迟摘要等非事件消息
+  }
+  uint32_t seq = payloadField(payload, "\"seq\":");
+  if (publishes.messages > 0 && seq <= publishes.lastSeq) {
+    publishes.outOfOrder++;
+  }
+  publishes.lastSeq = seq;
+  publishes.messages++;
+  publishes.events += payloadField(payload, "\"n\":");
+  publishes.maxLag = std::max(publishes.maxLag, payloadField(payload, "\"lag\":"));
+}
+
+static void runScenarioUntil(uint64_t untilMicros) {
+  scheduleScenario(simNowMicros(), untilMicros);
+  runUntil(untilMicros, false);
+}
+
+void runBrokerOutage() {
+  publishes = PublishLog();
+  simPowerCycle();
+  simReset();
+  simSetPublishHook(observePublish);
+  initializeSystem();
+  runUntil(5000000ULL, true);
+  simSetMQTTBroker(SIM_BROKER_REFUSED);
+  runScenarioUntil(35000000ULL);
+  simSetMQTTBroker(SIM_BROKER_UP);
+  runScenarioUntil(100000000ULL);
+}
+
+uint16_t runSoftResetWhileOffline() {
+  simSetMQTTBroker(SIM_BROKER_REFUSED);
+  runScenarioUntil(simNowMicros() + 20000000ULL);
+  uint16_t pending = mqttOutboxStats().depth;
+  simReset();
+  simSetPublishHook(observePublish);
+  simSetMQTTBroker(SIM_BROKER_UP);
+  initializeSystem();
+  runUntil(60000000ULL, false);
+  return pending;
+}
+
+void runPowerCycleWhileOffline() {
+  simSetMQTTBroker(SIM_BROKER_REFUSED);
+  runScenarioUntil(simNowMicros() + 20000000ULL);
+  simPowerCycle();
+  simReset();
+  simSetPublishHook(observePublish);
+  simSetMQTTBroker(SIM_BROKER_UP);
+  initializeSystem();
+  runUntil(10000000ULL, false);
+}
+
+// ==================== 异步日志 ====================
+LogCallRun runLogCallSites(uint32_t iterations) {
+  simReset();
+  initializeLog();
+  LogCallRun run = {};
+  uint64_t allocations0 = heapAllocations.load();
+  while (run.writes < iterations) {
+    uint64_t h0 = hostNanos();
+    for (uint32_t i = 0; i < LOG_RATE_LIMIT; i++) {
+      LOG_INFO(LOG_BUTTON_EDGE, BUTTON_PINS[i % BTN_COUNT], mqttEventTopic(MQTT_EVENT_TRIGGERED));
+    }
+    run.writeNanos += hostNanos() - h0;
+    run.writes += LOG_RATE_LIMIT;
+    while (drainLog()) {
+    }
+    simAdvanceMicros(LOG_RATE_WINDOW * 1000ULL);
+  }
+  for (uint32_t i = 0; i < LOG_RATE_LIMIT; i++) {
+    LOG_INFO(LOG_BUTTON_EDGE, BUTTON_PINS[0], mqttEventTopic(MQTT_EVENT_TRIGGERED));  // 占满本窗口
+  }
+  uint64_t h0 = hostNanos();
+  for (uint32_t i = 0; i < iterations; i++) {
+    LOG_INFO(LOG_BUTTON_EDGE, BUTTON_PINS[0], mqttEventTopic(MQTT_EVENT_TRIGGERED));  // 只计数
+  }
+  run.suppressedNanos = hostNanos() - h0;
+  char rule[] = "多按钮组合规则";
+  h0 = hostNanos();
+  for (uint32_t i = 0; i < LOG_RATE_LIMIT; i++) {
+    LOG_INFO(LOG_RULE_FIRED, logText(rule), mqttEventTopic(MQTT_EVENT_RESET));
+  }
+  run.textNanos = hostNanos() - h0;
+  while (drainLog()) {
+  }
+  run.allocations = heapAllocations.load() - allocations0;
+  run.stats = logStats();
+  return run;
+}
+
+// 日志中的按钮边沿行（约 50 字节），旧实现在调用点直接 Serial.printf
+static void legacyLogEdge(uint8_t pin, const char* topic) {
+  Serial.printf("按钮P%d状态改变：发送 %s\n", pin, topic);
+}
+
+uint64_t runLegacyLogBurst(uint32_t burst) {
+  simReset();
+  simSetSerialBaud(115200);
+  for (uint32_t i = 0; i < burst; i++) {
+    legacyLogEdge(BUTTON_PINS[i % BTN_COUNT], mqttEventTopic(MQTT_EVENT_TRIGGERED));
+    simAdvanceMicros(500);
+  }
+  return simCounters().serialBlockedMicros;
+}
+
+// 日志作业积压时按 LOG_BACKLOG_INTERVAL 重新运行，直到输出完毕
+static uint64_t drainLogBacklog() {
+  uint64_t start = simNowMicros();
+  while (drainLog()) {
+    simAdvanceMicros(LOG_BACKLOG_INTERVAL * 1000ULL);
+  }
+  return simNowMicros() - start;
+}
+
+LogBurstRun runLogBurst(uint32_t burst) {
+  simReset();
+  simSetSerialBaud(115200);
+  initializeLog();
+  LogBurstRun run = {};
+  run.attempts = burst;
+  uint64_t nextDrain = 0;
+  for (uint32_t i = 0; i < burst; i++) {
+    uint64_t t0 = hostNanos();
+    logWrite(LOG_LEVEL_INFO, LOG_BUTTON_EDGE, BUTTON_PINS[i % BTN_COUNT], mqttEventTopic(MQTT_EVENT_TRIGGERED));
+    run.callerNanos += hostNanos() - t0;
+    simAdvanceMicros(500);
+    if (simNowMicros() >= nextDrain) {
+      drainLog();
+      nextDrain = simNowMicros() + LOG_DRAIN_INTERVAL * 1000ULL;
+    }
+  }
+  run.drainMicros = drainLogBacklog();
+  run.stats = logStats();
+  run.blockedMicros = simCounters().serialBlockedMicros;
+  return run;
+}
+
+LogBurstRun runLogRingFull() {
+  simReset();
+  simSetSerialBaud(115200);
+  initializeLog();
+  LogBurstRun run = {};
+  for (uint8_t e = 0; e < LOG_DROPPED; e++) {
+    for (uint32_t i = 0; i < LOG_RATE_LIMIT; i++, run.attempts++) {
+      logWrite(LOG_LEVEL_INFO, e, i, i, i, i);
+    }
+  }
+  run.drainMicros = drainLogBacklog();
+  run.stats = logStats();
+  run.blockedMicros = simCounters().serialBlockedMicros;
+  return run;
+}
+
+// ==================== WebSocket 扇出 ====================
+const WsLoadGroup WS_LOAD_GROUPS[WS_LOAD_GROUP_COUNT] = {
+  {"unlimited + log", 8, 0, true, WS_KEEPS_UP},
+  {"100 KB/s + log", 8, 100000, true, WS_KEEPS_UP},
+  {"20 KB/s + log", 6, 20000, true, WS_KEEPS_UP},
+  {"5 KB/s + log", 4, 5000, true, WS_CATCHES_UP},
+  {"1 KB/s state only", 2, 1000, false, WS_KEEPS_UP},
+  {"1 KB/s + log", 2, 1000, true, WS_EVICTED},
+  {"stalled 1 B/s", 2, 1, false, WS_EVICTED},
+};
+
+bool runWebSocketLoad(uint32_t seconds, WsLoadRun& run) {
+#if WS_MAX_CLIENTS < WS_LOAD_CLIENTS
+  (void)seconds;
+  (void)run;
+  return false;
+#else
+  run = WsLoadRun();
+  run.seconds = std::max<uint32_t>(seconds, WS_LOAD_MIN_SECONDS);
+  bootUntilMQTTReady();
+
+  uint32_t ids[WS_LOAD_CLIENTS];
+  uint8_t groupOf[WS_LOAD_CLIENTS];
+  uint8_t n = 0;
+  for (uint8_t g = 0; g < WS_LOAD_GROUP_COUNT; g++) {
+    for (uint8_t i = 0; i < WS_LOAD_GROUPS[g].clients; i++, n++) {
+      ids[n] = simWebSocketConnect(WS_LOAD_GROUPS[g].bytesPerSecond);
+      groupOf[n] = g;
+      wsClientConnected(ids[n]);
+      wsSetLogView(ids[n], WS_LOAD_GROUPS[g].logView);
+      runUntil(simNowMicros() + 1000, false);  // 连接陆续到达
+    }
+  }
+
+  uint64_t start = simNowMicros();
+  uint64_t end = start + (uint64_t)run.seconds * 1000000;
+  int level = LOW;
+  for (uint64_t at = start; at < end; at += WS_LOAD_TOGGLE_INTERVAL_MS * 1000ULL) {
+    simSchedulePin(BUTTON_PINS[FAULT_BUTTON + 1], level, at);  // 绿色组的第一个按钮
+    level = level == LOW ? HIGH : LOW;
+  }
+  uint8_t logFrame[WS_LOAD_LOG_FRAME];
+  memset(logFrame, 'x', sizeof(logFrame));
+  uint64_t nextLog = start;
+  while (simNowMicros() < end) {
+    mainLoop();
+    while (simNowMicros() >= nextLog) {
+      if ((nextLog - start) / 1000 % WS_LOAD_BURST_PERIOD_MS < WS_LOAD_BURST_MS) {
+        wsBroadcast(logFrame, sizeof(logFrame), false, WS_CLASS_LOG);
+      }
+      nextLog += WS_LOAD_LOG_INTERVAL_MS * 1000ULL;
+    }
+  }
+  runUntil(end + WS_LOAD_QUIET_MS * 1000ULL, false);
+
+  WsClientStats fanout[WS_MAX_CLIENTS];
+  uint8_t connected = wsClientStats(fanout, WS_MAX_CLIENTS);
+  SimWsClientStats reference = simWebSocketClient(ids[0]);  // 不限速的客户端收到了每一帧
+  for (uint8_t g = 0; g < WS_LOAD_GROUP_COUNT; g++) {
+    WsLoadGroupResult& result = run.groups[g];
+    result.latestState = true;
+    for (uint8_t c = 0; c < WS_LOAD_CLIENTS; c++) {
+      if (groupOf[c] != g) continue;
+      SimWsClientStats client = simWebSocketClient(ids[c]);
+      result.frames += client.frames;
+      result.bytes += client.bytes;
+      if (!client.open) {
+        result.evicted++;
+        result.lastEvictMicros = std::max(result.lastEvictMicros, client.closedAtMicros - start);
+      } else {
+        result.latestState &= client.lastBinaryLength == reference.lastBinaryLength &&
+                              memcmp(client.lastBinary, reference.lastBinary, reference.lastBinaryLength) == 0;
+      }
+      for (uint8_t i = 0; i < connected; i++) {
+        if (fanout[i].id != ids[c]) continue;
+        result.replaced += fanout[i].replaced;
+        result.dropped += fanout[i].dropped;
+        result.maxDepth = std::max(result.maxDepth, fanout[i].maxDepth);
+      }
+    }
+  }
+
+  run.stats = wsFanoutStats();
+  const SimCounters& c = simCounters();
+  run.buffers = c.wsBuffers;
+  run.transportFrames = c.wsFrames;
+  run.bufferBytesPeak = c.wsBufferBytesPeak;
+  double elapsed = (simNowMicros() - start) / 1e6;
+  for (uint8_t i = 0; i < WS_LOAD_CLIENTS; i++) {
+    uint32_t rate = WS_LOAD_GROUPS[groupOf[i]].bytesPerSecond;
+    if (rate) run.legacyBacklogBytes += std::max(0.0, run.stats.broadcastBytes - rate * elapsed);
+  }
+
+  for (uint8_t i = 0; i < WS_LOAD_CLIENTS; i++) {
+    simWebSocketDisconnect(ids[i]);
+    wsClientDisconnected(ids[i]);
+  }
+  runUntil(simNowMicros() + 100000, false);
+  run.buffersLive = simCounters().wsBuffersLive;
+  run.clientsLeft = wsFanoutStats().clients;
+  return true;
+#endif
+}
+
+// ==================== 输入录制 ====================
+void recordSyntheticTrace(uint32_t seconds, TraceRecording& recording) {
+  bootUntilMQTTReady();
+  beginTopicRecording();
+  requestInputTrace(true);
+  mainLoop();
+
+  std::mt19937 rng(11);
+  uint64_t start = simNowMicros();
+  uint64_t half = start + seconds * 500000ULL;
+  recording.driven = scheduleSyntheticPresses(rng, start, half);
+  runUntil(half, false);
+
+  // 中断队列溢出：一次写入超过 BUTTON_EVENT_QUEUE_SIZE 个边沿，最后停在按下
+  uint8_t burstPin = BUTTON_PINS[FAULT_BUTTON + 1];
+  uint64_t burstAt = simNowMicros();
+  for (uint32_t i = 0; i <= 2 * BUTTON_EVENT_QUEUE_SIZE; i++, recording.driven++) {
+    simSetPinAt(burstPin, (i % 2) ? HIGH : LOW, burstAt + i);
+  }
+  simAdvanceMicros(2 * BUTTON_EVENT_QUEUE_SIZE + 1);  // 中断时间戳不晚于输入作业看到的当前时间
+  recording.driven += scheduleBouncyEdge(rng, burstPin, HIGH, burstAt + 400000);
+
+  // 空闲超过 INPUT_TRACE_MAX_GAP_US / 2：录制插入只推进时间的记录
+  uint64_t idleEnd = burstAt + 1000000ULL + 20 * 60 * 1000000ULL;
+  runUntil(idleEnd, false);
+  uint64_t end = idleEnd + seconds * 500000ULL;
+  recording.driven += scheduleSyntheticPresses(rng, idleEnd, end);
+  runUntil(end, false);
+  recording.micros = end - start;
+
+  requestInputTrace(false);
+  while (inputTraceStats().recording || inputTraceFlushPending()) {
+    mainLoop();
+  }
+  runUntil(simNowMicros() + REPLAY_TAIL_MICROS, false);
+  recording.topics = endTopicRecording();
+
+  recording.trace = inputTraceStats();  // 回放会重新初始化录制模块
+  recording.lost = buttonEventStats().dropped;
+  recording.file.resize(INPUT_TRACE_MAX_BYTES);
+  recording.fileLength = halFileRead(INPUT_TRACE_PATH, (char*)recording.file.data(), recording.file.size());
+  recording.file.resize(std::max<int32_t>(recording.fileLength, 0));
+}
+
+std::vector<std::string> replayTopics(const ReplayResult& result) {
+  std::vector<std::string> topics;
+  for (const std::string& line : result.lines) {
+    size_t at = line.find(" mqtt ");
+    if (at != std::string::npos) {
+      size_t end = line.find(' ', at + 6);
+      topics.push_back(line.substr(at + 6, end - at - 6));
+    }
+  }
+  return topics;
+}
+
+std::string changedStepRules() {
+  auto pinList = [](uint32_t mask) {
+    std::string list;
+    for (uint8_t i = 0; i < BTN_COUNT; i++) {
+      if (mask & BUTTON_MASK(i)) list += (list.empty() ? "" : ", ") + std::to_string(BUTTON_PINS[i]);
+    }
+    return "[" + list + "]";
+  };
+  std::string green = pinList(GREEN_BUTTONS_MASK);
+  return "{\"rules\": ["
+         "{\"name\": \"fault\", \"any\": " + pinList(BUTTON_MASK(FAULT_BUTTON)) +
+         ", \"priority\": 40, \"mode\": \"flash_yellow\", \"keep\": true},"
+         "{\"name\": \"reset\", \"any\": " + pinList(BUTTON_MASK(RESET_BUTTON)) +
+         ", \"priority\": 30, \"mode\": \"breathe_red\", \"keep\": true, \"action\": \"reset\"},"
+         "{\"name\": \"all_green\", \"all\": " + green + ", \"priority\": 25, \"mode\": \"breathe_green\","
+         " \"count\": " + green + ", \"step\": " + std::to_string(GREEN_BRIGHTNESS_STEP) + ", \"action\": \"triggered\"},"
+         "{\"name\": \"green\", \"any\": " + green + ", \"priority\": 20, \"mode\": \"breathe_green\","
+         " \"count\": " + green + ", \"step\": 40},"
+         "{\"name\": \"idle\", \"priority\": 0, \"mode\": \"breathe_red\", \"base\": 0}],"
+         "\"edges\": [{\"pins\": " + pinList(FIRST_TRIGGER_BUTTONS_MASK) +
+         ", \"press\": \"firstTriggered\", \"release\": \"firstTriggered\"}]}";
+}
+
+// ==================== 低功耗空闲 ====================
+static uint32_t powerFrames = 0;
+
+static void observePowerFrame(const Job& job, bool finished) {
+  if (finished && job.run == updateLEDController) {
+    powerFrames++;
+  }
+}
+
+static PowerPhase runPowerPhase(uint64_t untilMicros) {
+  PowerPhase phase = {0, 0, 0, 0};
+  uint64_t start = simNowMicros();
+  uint32_t frames = powerFrames;
+  uint64_t slept = powerStats().sleptMicros;
+  while (simNowMicros() < untilMicros) {
+    uint64_t before = simNowMicros();
+    mainLoop();
+    if (simNowMicros() != before) {
+      phase.wakes++;
+    }
+  }
+  phase.frames = powerFrames - frames;
+  phase.micros = simNowMicros() - start;
+  phase.sleptMicros = powerStats().sleptMicros - slept;
+  return phase;
+}
+
+void runPowerScenario(bool powerSave, bool apOutage, uint32_t seconds, PowerScenario& scenario) {
+  simNVSClear();
+  simReset();
+  simPowerCycle();
+  initializeSystem();
+  setPowerSaveEnabled(powerSave);
+  runUntil(30000000ULL, true);
+  powerFrames = 0;
+  Scheduler::setObserver(observePowerFrame);
+  beginTopicRecording();
+
+  uint64_t settled = simNowMicros() + (POWER_IDLE_AFTER + 1000) * 1000ULL;
+  runUntil(settled, false);
+  if (apOutage) {
+    simSetWiFiAvailable(false);
+    simDropWiFi();
+  }
+  scenario.idle = runPowerPhase(settled + seconds * 1000000ULL);
+  scenario.modemSleepIdle = simWiFiPowerSaveIdle();
+
+  std::mt19937 rng(21);
+  uint64_t from = simNowMicros();
+  uint64_t to = from + seconds * 1000000ULL;
+  scenario.edges = scheduleSyntheticPresses(rng, from, to);
+  scenario.presses = runPowerPhase(to);
+  if (apOutage) {
+    // AP 恢复后等到退避结束、重新连上并补发完积压的事件
+    simSetWiFiAvailable(true);
+    uint64_t limit = simNowMicros() + 90000000ULL;
+    while ((!wifiManagerConnected() || mqttManagerState() != MQTT_STATE_CONNECTED || mqttOutboxStats().depth > 0) &&
+           simNowMicros() < limit) {
+      mainLoop();
+    }
+  }
+  runUntil(simNowMicros() + (POWER_IDLE_AFTER + 2000) * 1000ULL, false);
+
+  Scheduler::setObserver(nullptr);
+  scenario.topics = endTopicRecording();
+  scenario.finalMode = ledController.mode;
+  scenario.wifiDrops = wifiStats().drops;
+  scenario.sleepsConnecting = simCounters().lightSleepsConnecting;
+  scenario.sleepsAssociated = simCounters().lightSleepsAssociated;
+  scenario.reconnected = wifiManagerState() == WIFI_STATE_CONNECTED && mqttManagerState() == MQTT_STATE_CONNECTED;
+}
+
+// ==================== 动画片段 ====================
+static const char* const DEMO_CLIP_KINDS[] = {"rainbow", "sparkle", "wipe", "still"};
+
+bool buildDemoClips(std::vector<ClipSource>& clips, std::vector<uint8_t>& bundle, ClipEncodeStats& stats) {
+  clips.clear();
+  for (const char* kind : DEMO_CLIP_KINDS) {
+    clips.emplace_back();
+    makeDemoClip(kind, kind, NUM_LEDS, clips.back());
+  }
+  std::string error;
+  return buildClipBundle(clips, bundle, stats, error);
+}
+
+static uint64_t callbackFlashBytes = 0;
+
+uint64_t clipCallbackFlashBytes() {
+  return callbackFlashBytes;
+}
+
+// 上传回调的一次调用；随后 flash 写入任务写完已交出的块
+template <typename Callback>
+static bool clipCallback(Callback callback) {
+  uint64_t before = simCounters().partitionErasedBytes + simCounters().partitionWrittenBytes;
+  bool accepted = callback();
+  callbackFlashBytes += simCounters().partitionErasedBytes + simCounters().partitionWrittenBytes - before;
+  runFlashTask();
+  return accepted;
+}
+
+// 写入任务放下缓冲区（完成或放弃）
+static void finishClipWriter() {
+  for (int i = 0; i < 1000 && flashRing.owner() == RING_CLIPS; i++) {
+    runFlashTask();
+  }
+}
+
+bool uploadClips(const std::vector<uint8_t>& bundle, std::mt19937& rng, size_t length) {
+  callbackFlashBytes = 0;
+  if (!clipCallback([&]() { return clipUploadBegin(bundle.size()); })) {
+    return false;
+  }
+  bool accepted = true;
+  for (size_t at = 0; accepted && at < length;) {
+    size_t n = std::min<size_t>(1 + rng() % 1460, length - at);
+    accepted = clipCallback([&]() { return clipUploadWrite(bundle.data() + at, n); });
+    at += n;
+  }
+  if (accepted && length == bundle.size()) {
+    accepted = clipCallback([]() { return clipUploadEnd(); });
+  } else {
+    clipCallback([]() { clipUploadAbort(); return false; });
+  }
+  finishClipWriter();
+  return accepted && clipUploadError() == nullptr;
+}
+
+std::string clipPartitionPath() {
+  return "/tmp/ball_clips_" + std::to_string(getpid()) + ".bin";
+}
+
+// ==================== 固件更新 ====================
+const SimOTATiming OTA_TEST_FLASH = {20000, 2500};
+
+std::vector<uint8_t> buildOTAFile(const std::vector<uint8_t>& image, const uint8_t seed[ED25519_SEED_SIZE]) {
+  OtaManifest manifest = {};
+  memcpy(manifest.magic, "BOTA", 4);
+  manifest.version = OTA_MANIFEST_VERSION;
+  manifest.imageSize = (uint32_t)image.size();
+  Sha256 sha;
+  sha.update(image.data(), image.size());
+  sha.finish(manifest.sha256);
+  ed25519Sign(manifest.signature, (const uint8_t*)&manifest, OTA_MANIFEST_SIGNED_BYTES, seed);
+  std::vector<uint8_t> file(sizeof(manifest) + image.size());
+  memcpy(file.data(), &manifest, sizeof(manifest));
+  memcpy(file.data() + sizeof(manifest), image.data(), image.size());
+  return file;
+}
+
+std::vector<uint8_t> randomFirmware(std::mt19937& rng, size_t size) {
+  std::vector<uint8_t> image(size);
+  for (uint8_t& b : image) {
+    b = (uint8_t)rng();
+  }
+  image[0] = 0xE9;  // ESP32 镜像魔数
+  return image;
+}
+
+std::string hexText(const uint8_t* data, size_t length) {
+  std::string text;
+  char digits[3];
+  for (size_t i = 0; i < length; i++) {
+    snprintf(digits, sizeof(digits), "%02x", data[i]);
+    text += digits;
+  }
+  return text;
+}
+
+bool parseHex(const char* text, uint8_t* out, size_t length) {
+  for (size_t i = 0; i < length; i++) {
+    unsigned value;
+    if (sscanf(text + 2 * i, "%2x", &value) != 1) {
+      return false;
+    }
+    out[i] = (uint8_t)value;
+  }
+  return true;
+}
+
+// 按网络速率逐段交给 deliver；deliver 阻塞期间（flash 擦写、缓冲区满）不收数据，相当于接收窗口关闭
+template <typename F>
+static bool streamSegments(const uint8_t* data, size_t length, F deliver) {
+  uint64_t due = simNowMicros();
+  for (size_t offset = 0; offset < length; offset += OTA_TEST_SEGMENT) {
+    size_t n = std::min<size_t>(OTA_TEST_SEGMENT, length - offset);
+    due = std::max(due, simNowMicros()) + (uint64_t)n * 1000000 / OTA_TEST_NETWORK_RATE;
+    uint64_t now = simNowMicros();
+    if (due > now) {
+      std::this_thread::sleep_for(std::chrono::microseconds(due - now));
+    }
+    if (!deliver(data + offset, n)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static std::mutex otaFramesMutex;
+static std::vector<std::string> otaFrames;
+
+static void observeOTAFrame(const char* text, size_t length) {
+  std::lock_guard<std::mutex> lock(otaFramesMutex);
+  otaFrames.emplace_back(text, length);
+}
+
+uint32_t countOTAFrames(const char* state) {
+  std::lock_guard<std::mutex> lock(otaFramesMutex);
+  std::string pattern = std::string("{\"ota\":{\"state\":\"") + state + "\"";
+  uint32_t n = 0;
+  for (const std::string& frame : otaFrames) {
+    n += frame.compare(0, pattern.size(), pattern) == 0;
+  }
+  return n;
+}
+
+void startOTASystem() {
+  simReset();
+  simSetRealTime(true);
+  simSetWiFiTiming(SimWiFiTiming{50, 10, 5});
+  simSetOTATiming(OTA_TEST_FLASH);
+  initializeSystem();
+  {
+    std::lock_guard<std::mutex> lock(otaFramesMutex);
+    otaFrames.clear();
+  }
+  simSetWebSocketTextHook(observeOTAFrame);
+  wsClientConnected(simWebSocketConnect(0));
+}
+
+bool uploadSynchronously(const std::vector<uint8_t>& image) {
+  bool ok = halOTABegin(image.size());
+  ok = ok && streamSegments(image.data(), image.size(), [](const uint8_t* p, size_t n) { return halOTAWrite(p, n); });
+  return ok && halOTAEnd();
+}
+
+static uint64_t longestReceiveMicros = 0;
+
+uint64_t longestOTAReceiveMicros() {
+  return longestReceiveMicros;
+}
+
+bool uploadOTA(const std::vector<uint8_t>& file, size_t length, OtaUploadEnd end) {
+  if (!otaBegin("firmware.ota")) {
+    return false;
+  }
+  longestReceiveMicros = 0;
+  if (!streamSegments(file.data(), length, [](const uint8_t* p, size_t n) {
+        uint64_t start = simNowMicros();
+        bool accepted = otaReceive(p, n);
+        longestReceiveMicros = std::max(longestReceiveMicros, simNowMicros() - start);
+        return accepted;
+      })) {
+    return false;
+  }
+  if (end == OTA_UPLOAD_DISCONNECT) {
+    otaAbort();
+    return false;
+  }
+  return otaReceiveDone();
+}
+
+bool waitForOTA(uint32_t timeoutMillis) {
+  uint64_t until = simNowMicros() + timeoutMillis * 1000ULL;
+  while (simNowMicros() < until) {
+    OtaState state = otaStatus().state;
+    if (state != OTA_RECEIVING && state != OTA_WRITING) {
+      return true;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  return false;
+}
+
+OtaPipelineRun runPipelinedUpload(const std::vector<uint8_t>& file) {
+  OtaPipelineRun run = {};
+  uint32_t receivingFrames = countOTAFrames("receiving");
+  uint64_t t0 = simNowMicros();
+  run.accepted = otaBegin("firmware.ota");
+  run.rejectedSecond = !otaBegin("second.ota");  // 同时只有一个更新
+  run.accepted &= streamSegments(file.data(), file.size(), [](const uint8_t* p, size_t n) {
+    return otaReceive(p, n);
+  });
+  uint64_t d0 = hostNanos();
+  run.accepted &= otaReceiveDone();
+  run.doneNanos = hostNanos() - d0;
+  run.receivedAtMicros = simNowMicros();
+  run.finished = waitForOTA(10000);
+  run.micros = simNowMicros() - t0;
+  run.status = otaStatus();
+  run.progressFrames = countOTAFrames("receiving") - receivingFrames;
+  return run;
+}
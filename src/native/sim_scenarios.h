@@ -0,0 +1,329 @@
+#ifndef SIM_SCENARIOS_H
+#define SIM_SCENARIOS_H
+
+// ==================== 模拟场景 ====================
+// test/ 下的 Unity 用例和 program 的基准共用的驱动：在虚拟时钟上运行 mainLoop()、预定带抖动的按键、
+// 经模拟服务器投递命令、上传片段包和签名固件，以及几段完整的负载场景。
+// 场景只运行并返回统计，用例对结果做断言，program 打印耗时和统计。
+
+#include <stdint.h>
+#include <stddef.h>
+#include <random>
+#include <string>
+#include <vector>
+#include "ball.h"
+#include "text_writer.h"
+#include "log.h"
+#include "input_trace.h"
+#include "ws_fanout.h"
+#include "ota.h"
+#include "ed25519.h"
+#include "clip_builder.h"
+#include "input_replay.h"
+#include "hal_sim.h"
+
+// ==================== 主机计时 / 堆分配 ====================
+uint64_t hostNanos();
+uint64_t heapAllocationCount();  // 全局 operator new 的调用次数（整个进程）
+
+// ==================== 运行 ====================
+// 运行 mainLoop() 直到虚拟时钟到达 untilMicros；stopWhenMQTTReady 时 MQTT 就绪即返回
+void runUntil(uint64_t untilMicros, bool stopWhenMQTTReady);
+void runForMillis(uint32_t ms);
+// simReset() 后启动并运行到 MQTT 就绪（NVS 和保留内存保持原样）
+void bootUntilMQTTReady();
+
+// ==================== 按钮场景 ====================
+// 一个 10 秒周期的按钮脚本：绿色组逐个按下到全亮、P13 频闪（带抖动）、P32 重置
+#define SCENARIO_PERIOD_MS 10000
+// 在虚拟时钟上预定 (fromMicros, toMicros] 内的引脚变化，到点时触发中断并唤醒 mainLoop
+void scheduleScenario(uint64_t fromMicros, uint64_t toMicros);
+
+// 一次带抖动的按下或松开：先在两个电平之间来回跳 2-6 次（间隔 50-400 us），最后停在 level；返回边沿数
+uint32_t scheduleBouncyEdge(std::mt19937& rng, uint8_t pin, int level, uint64_t atMicros);
+// 随机按钮（偶尔两个同时按住）按下 80-600 ms，间隔 50-1500 ms；返回预定的边沿数
+uint32_t scheduleSyntheticPresses(std::mt19937& rng, uint64_t fromMicros, uint64_t toMicros);
+
+// ==================== MQTT ====================
+std::string commandTopic(const char* prefix, const char* name);
+void deliverCommand(const std::string& topic, const std::string& payload);
+// 记录发布的主题（延迟摘要除外），end 时取出并停止记录
+void beginTopicRecording();
+std::vector<std::string> endTopicRecording();
+
+// ==================== 旧版按钮逻辑 ====================
+// 旧版 handleButtonLogic() 的 if 链，改为纯函数作为对照
+struct LegacyLogic {
+  bool previousAllPinsTriggered;
+  bool previousP32Triggered;
+  uint32_t initialPressedMask;
+  uint8_t ledMode;
+  uint8_t brightness;
+};
+
+// 事件按发布顺序编码为 4 进制数字，便于比较
+uint32_t legacyEvaluate(LegacyLogic& s, uint32_t pressed);
+// 通过真实的 handleButtonLogic()（规则表）判断一次，收集投递的 MQTT 事件，编码同上
+uint32_t ruleEvaluate(uint32_t pressed);
+bool sameOutput(const LegacyLogic& legacy, uint32_t legacyEvents, uint32_t ruleEvents);
+bool defaultButtonPins();  // data/rules.json 按默认引脚编写
+
+// 引脚表和按钮数在另一个编译单元里（改为编译期列表之前的写法），编译器无法展开循环
+uint32_t loopPressedMask(uint64_t levels);
+void loopStateJSON(TextWriter& out, const BallSnapshot& state);
+
+// ==================== 延迟追踪 ====================
+// 最坏情况：设备长期运行后每个桶的累计计数都是 10 位、和是 20 位（initializeMetrics() 清零）
+void saturateMetricHistograms();
+
+// ==================== 并发压力 ====================
+// 渲染、网络任务各占一个线程（实时时钟，按截止时间休眠、被引脚中断唤醒），
+// 另一个线程随机翻转按钮引脚（模拟中断），调用线程作为额外的快照读者（相当于 AsyncTCP）
+// 校验每次读到的快照是否自洽。返回时任务已停止、待发队列已发完
+struct StressRun {
+  uint64_t reads;
+  uint64_t violations;
+};
+
+StressRun runStressTasks(uint32_t seconds, bool wireTiming);
+
+// ==================== LED 双缓冲 ====================
+// 以 0.2-2 倍发送时间的间隔推送 frames 帧（每帧整条同色），大部分时候上一帧还没发完
+struct LedPushRun {
+  uint32_t frames;
+  uint32_t rendered;
+  uint32_t dropped;
+  uint32_t completed;
+  uint32_t mixedFrames;          // 灯带上显示的帧不是整条来自同一次推送
+  uint64_t presentHostNanos;
+  uint64_t presentVirtualMicros; // compositorPresent() 阻塞的虚拟时间
+  uint32_t wireMicros;           // 发送一帧的时间
+};
+
+LedPushRun pushFramesFasterThanWire(uint32_t frames);
+
+// ==================== 灯带布局 ====================
+// n 个通道平分 pixels 个像素，奇数通道反向安装
+std::string splitLayoutJSON(uint16_t pixels, uint8_t channels);
+// 逻辑像素 i 在通道 channel 的第 position 个位置上，按 order 排列、乘亮度后应为的线上字节
+bool wireMatches(uint8_t channel, uint16_t position, uint16_t i, uint16_t order);
+void waitForFrame();
+
+struct LayoutRun {
+  uint16_t pixels;
+  uint32_t frameMicros;
+  double fps;
+  double presentNanos;
+  double bytesPerPixel;
+};
+
+// 以 splitLayoutJSON() 启动，连续渲染 1 s 虚拟时间的渐变；各通道并行发送，帧率取决于最长的通道
+LayoutRun runSplitLayout(uint16_t pixels, uint8_t channels);
+
+// ==================== MQTT 待发缓冲区 ====================
+// 解析每条发布的 payload，检查序号递增并累计事件数和延迟
+struct PublishLog {
+  uint32_t messages;
+  uint32_t events;       // n 之和
+  uint32_t outOfOrder;
+  uint32_t lastSeq;
+  uint32_t maxLag;
+};
+
+const PublishLog& publishLog();
+// 冷启动后服务器中断 30 s：期间事件留在缓冲区，恢复后按顺序重放（清空 publishLog）
+void runBrokerOutage();
+// 断线 20 s 后软件复位，重启后服务器恢复；返回复位前缓冲区里的条数
+uint16_t runSoftResetWhileOffline();
+// 断线 20 s 后掉电，保留内存内容随机
+void runPowerCycleWhileOffline();
+
+// ==================== 异步日志 ====================
+// 调用点：每个限流窗口写 LOG_RATE_LIMIT 条、窗口之间清空缓冲区，共 iterations 条；
+// 再写 iterations 条被限流的和 LOG_RATE_LIMIT 条复制文本的
+struct LogCallRun {
+  uint32_t writes;
+  uint64_t writeNanos;
+  uint64_t suppressedNanos;
+  uint64_t textNanos;
+  uint64_t allocations;
+  LogStats stats;
+};
+
+LogCallRun runLogCallSites(uint32_t iterations);
+
+// 渲染任务 100 ms 内记录 burst 次按钮边沿，串口 115200 波特
+struct LogBurstRun {
+  uint32_t attempts;
+  uint64_t callerNanos;
+  uint64_t blockedMicros;  // 串口发送缓冲区满时调用方被阻塞的时间
+  uint64_t drainMicros;    // 写完后到全部输出的时间
+  LogStats stats;
+};
+
+// 旧实现：调用点直接写串口；返回 blockedMicros
+uint64_t runLegacyLogBurst(uint32_t burst);
+// 新实现：调用点只写记录，日志作业按 LOG_DRAIN_INTERVAL 运行
+LogBurstRun runLogBurst(uint32_t burst);
+// 缓冲区满：限流之内的不同事件一次写入超过容量
+LogBurstRun runLogRingFull();
+
+// ==================== WebSocket 扇出 ====================
+// 32 个模拟客户端按不同带宽接收。按钮每 120 ms 变化一次（状态帧）；打开日志面板的客户端
+// 另收突发的日志：每 4 s 中的 1 s 每 25 ms 一帧 400 字节（突发 16 KB/s，平均 4 KB/s）。
+// 跑完后安静 3 秒让仍连接的客户端追上，最后全部断开
+#define WS_LOAD_CLIENTS 32
+#define WS_LOAD_LOG_FRAME 400
+#define WS_LOAD_LOG_INTERVAL_MS 25
+#define WS_LOAD_BURST_MS 1000
+#define WS_LOAD_BURST_PERIOD_MS 4000
+#define WS_LOAD_TOGGLE_INTERVAL_MS 120
+#define WS_LOAD_QUIET_MS 3000
+// 1 KB/s 的日志客户端从第一次突发开始落后，负载还要再持续 WS_CLIENT_EVICT_MS 它才会被断开；
+// 更短的运行断开与否只取决于突发的相位
+#define WS_LOAD_MIN_SECONDS ((WS_LOAD_BURST_MS + WS_CLIENT_EVICT_MS) / 1000 + 1)
+
+enum WsLoadExpect {
+  WS_KEEPS_UP,     // 不丢、不覆盖
+  WS_CATCHES_UP,   // 突发时丢日志/覆盖状态帧，之后追上
+  WS_EVICTED
+};
+
+struct WsLoadGroup {
+  const char* name;
+  uint8_t clients;
+  uint32_t bytesPerSecond;  // 0 为不限速
+  bool logView;
+  WsLoadExpect expect;
+};
+
+#define WS_LOAD_GROUP_COUNT 7
+extern const WsLoadGroup WS_LOAD_GROUPS[WS_LOAD_GROUP_COUNT];
+
+struct WsLoadGroupResult {
+  uint32_t frames;
+  uint64_t bytes;
+  uint32_t replaced;
+  uint32_t dropped;
+  uint8_t maxDepth;
+  uint32_t evicted;
+  uint64_t lastEvictMicros;  // 从负载开始算起
+  bool latestState;          // 仍连接的客户端最后收到的都是最新状态帧
+};
+
+struct WsLoadRun {
+  uint32_t seconds;  // 短于 WS_LOAD_MIN_SECONDS 时按它运行
+  WsLoadGroupResult groups[WS_LOAD_GROUP_COUNT];
+  WsFanoutStats stats;
+  uint32_t buffers;            // 分配的共享缓冲
+  uint32_t transportFrames;    // 交给传输层的帧
+  uint64_t bufferBytesPeak;
+  double legacyBacklogBytes;   // 旧版 textAll() 每客户端一份拷贝、无上限排队时结束时的积压
+  uint32_t buffersLive;        // 全部断开后未释放的缓冲
+  uint8_t clientsLeft;         // 全部断开后 ws_fanout 仍登记的客户端
+};
+
+// WS_MAX_CLIENTS 小于 WS_LOAD_CLIENTS 时返回 false
+bool runWebSocketLoad(uint32_t seconds, WsLoadRun& run);
+
+// ==================== 输入录制 ====================
+// 在模拟引脚上录制 seconds 秒合成按键（含抖动、一次中断队列溢出和一段 20 分钟的空闲）
+struct TraceRecording {
+  uint32_t driven;         // 驱动的边沿
+  uint32_t lost;           // 中断队列丢弃的边沿
+  InputTraceStats trace;
+  std::vector<uint8_t> file;
+  int32_t fileLength;      // halFileRead() 的结果
+  uint64_t micros;         // 第一次到最后一次按键
+  std::vector<std::string> topics;  // 录制期间的 MQTT 发布
+};
+
+void recordSyntheticTrace(uint32_t seconds, TraceRecording& recording);
+// 回放输出里 MQTT 发布的主题
+std::vector<std::string> replayTopics(const ReplayResult& result);
+// 与默认规则（data/rules.json）相同，只把 green 规则每个按钮的亮度步长改为 40。
+// 引脚取自 BUTTON_PINS，其他按钮数的构建也适用
+std::string changedStepRules();
+
+// ==================== 低功耗空闲 ====================
+struct PowerPhase {
+  uint32_t wakes;    // 虚拟时间前进过的 mainLoop() 次数，即 CPU 被唤醒的次数
+  uint32_t frames;   // LED 作业渲染的帧数
+  uint64_t micros;
+  uint64_t sleptMicros;
+};
+
+struct PowerScenario {
+  PowerPhase idle;
+  PowerPhase presses;
+  std::vector<std::string> topics;
+  uint8_t finalMode;
+  uint32_t edges;
+  uint32_t wifiDrops;
+  uint32_t sleepsConnecting;  // WiFi 连接尝试进行中时的浅睡眠
+  uint32_t sleepsAssociated;  // WiFi 已连接时的浅睡眠
+  bool modemSleepIdle;        // 空闲段结束时 WiFi 处于空闲的 modem sleep
+  bool reconnected;           // 结束时 WiFi 和 MQTT 都已连上
+};
+
+// 冷启动到 MQTT 就绪后：等待进入空闲，测量 seconds 秒空闲，再按固定种子驱动 seconds 秒带抖动的按键，
+// 最后空闲到再次进入空闲状态。apOutage：空闲段和按键段期间 AP 不可用（WiFi 退避等待，可以浅睡眠），
+// 按键段结束后恢复，等到重新连上并补发完积压的事件
+void runPowerScenario(bool powerSave, bool apOutage, uint32_t seconds, PowerScenario& scenario);
+
+// ==================== 动画片段 ====================
+#define CLIP_TEST_PARTITION_SIZE 0x100000  // 与 partitions.csv 的 clips 分区相同
+
+// rainbow / sparkle / wipe / still 四个演示片段
+bool buildDemoClips(std::vector<ClipSource>& clips, std::vector<uint8_t>& bundle, ClipEncodeStats& stats);
+// 按随机大小分块上传，模拟请求体分段到达；上传回调和 flash 写入任务在调用线程上交替运行，返回前等写入任务收尾。
+// length 小于包的长度时只发 length 字节后连接断开
+bool uploadClips(const std::vector<uint8_t>& bundle, std::mt19937& rng, size_t length);
+uint64_t clipCallbackFlashBytes();  // 最近一次 uploadClips() 中上传回调自己擦写的 flash 字节数
+std::string clipPartitionPath();  // 模拟分区绑定的临时文件
+
+// ==================== 固件更新 ====================
+// 调用线程扮演 AsyncTCP 的上传回调：按 TCP 段大小和网络速率交出签名固件文件，渲染/网络/OTA 写入任务各占一个线程
+// （实时时钟），模拟 Update 按 flash 擦写时间阻塞写入任务。
+#define OTA_TEST_SEGMENT 1436              // TCP MSS
+#define OTA_TEST_NETWORK_RATE (200 * 1024) // bytes/s
+#define OTA_TEST_FAILURE_IMAGE (48 * 1024)
+extern const SimOTATiming OTA_TEST_FLASH;  // 每扇区擦除 20 ms，写入 2.5 ms/KB
+
+std::vector<uint8_t> buildOTAFile(const std::vector<uint8_t>& image, const uint8_t seed[ED25519_SEED_SIZE]);
+std::vector<uint8_t> randomFirmware(std::mt19937& rng, size_t size);
+std::string hexText(const uint8_t* data, size_t length);
+bool parseHex(const char* text, uint8_t* out, size_t length);
+
+// 实时模式启动、只有一个不限速的 WebSocket 客户端（收集 OTA 进度帧）；任务尚未启动
+void startOTASystem();
+// 旧实现：上传回调里直接 Update.write()，擦写期间不接收（写入任务启动前调用）
+bool uploadSynchronously(const std::vector<uint8_t>& image);
+
+enum OtaUploadEnd {
+  OTA_UPLOAD_COMPLETE,   // 全部发完后结束请求
+  OTA_UPLOAD_TRUNCATED,  // 只发 length 字节就结束请求
+  OTA_UPLOAD_DISCONNECT  // 只发 length 字节后连接断开
+};
+
+// 返回 otaReceiveDone() 的结果（HTTP 响应 202 还是 400）
+bool uploadOTA(const std::vector<uint8_t>& file, size_t length, OtaUploadEnd end);
+uint64_t longestOTAReceiveMicros();  // 最近一次 uploadOTA() 中上传回调单次调用的最长阻塞
+bool waitForOTA(uint32_t timeoutMillis);  // 等到不再接收/写入
+uint32_t countOTAFrames(const char* state);
+
+struct OtaPipelineRun {
+  bool accepted;        // HTTP 202
+  bool rejectedSecond;  // 更新进行中拒绝第二个上传
+  uint64_t doneNanos;   // otaReceiveDone() 的主机耗时
+  uint64_t receivedAtMicros;
+  uint64_t micros;      // 开始上传到写入任务结束
+  uint32_t progressFrames;
+  bool finished;
+  OtaStatus status;
+};
+
+// 写入任务已启动时上传一次
+OtaPipelineRun runPipelinedUpload(const std::vector<uint8_t>& file);
+
+#endif // SIM_SCENARIOS_H
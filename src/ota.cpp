@@ -0,0 +1,372 @@
+#include <atomic>
+#include <string.h>
+#include "ota.h"
+#include "tasks.h"
+#include "log.h"
+#include "ws_fanout.h"
+#include "sector_ring.h"
+
+// 镜像经 flashRing（sector_ring.h）交给写入任务；更新开始时 acquire，写入任务放弃更新后 release，
+// 成功时一直持有到重启
+static OtaManifest signedManifest;  // 清单收齐后、第一块交出前写入，写入任务据此验证签名和摘要
+
+// 状态只由写入任务设为 WRITING 之后的终态；接收方的失败经 abortRequested 交给写入任务，
+// 由它放弃 flash 写入后再置 FAILED，所以 FAILED 时写入任务一定已经空闲
+static std::atomic<uint8_t> state(OTA_IDLE);
+static std::atomic<bool> abortRequested(false);
+static std::atomic<const char*> failReason(nullptr);  // 第一个失败原因
+static std::atomic<uint32_t> session(0);
+static std::atomic<uint32_t> totalBytes(0);
+static std::atomic<uint32_t> receivedBytes(0);
+static std::atomic<uint32_t> writtenBytes(0);
+static std::atomic<uint32_t> startMillis(0);
+static std::atomic<uint32_t> endMillis(0);
+static std::atomic<uint32_t> stallCount(0);
+static std::atomic<uint32_t> stallMillis(0);
+static std::atomic<uint32_t> failureCount(0);
+static std::atomic<uint32_t> changes(0);  // 开始、清单收齐、收完、结束时加一，网络任务据此立即广播
+
+// 接收方
+static bool receiving = false;
+static OtaManifest manifest;
+static size_t manifestLength = 0;
+
+// 写入任务
+static uint32_t writerSession = 0;
+static bool flashOpen = false;
+static Sha256 imageHash;
+static bool restartIssued = false;
+
+static void markChanged() {
+  changes.fetch_add(1, std::memory_order_release);
+  halNotifyTask(TASK_NETWORK);
+}
+
+// ==================== 初始化 ====================
+// 启动时的状态；主机上同一进程里多次启动时清掉上一次的更新（等待重启、失败原因、计数）
+void initializeOTA() {
+  receiving = false;
+  flashOpen = false;
+  restartIssued = false;
+  writerSession = session.load(std::memory_order_relaxed);
+  if (flashRing.owner() == RING_OTA) {
+    flashRing.release();
+  }
+  totalBytes.store(0, std::memory_order_relaxed);
+  receivedBytes.store(0, std::memory_order_relaxed);
+  writtenBytes.store(0, std::memory_order_relaxed);
+  startMillis.store(0, std::memory_order_relaxed);
+  endMillis.store(0, std::memory_order_relaxed);
+  stallCount.store(0, std::memory_order_relaxed);
+  stallMillis.store(0, std::memory_order_relaxed);
+  failureCount.store(0, std::memory_order_relaxed);
+  failReason.store(nullptr, std::memory_order_relaxed);
+  abortRequested.store(false, std::memory_order_relaxed);
+  state.store(OTA_IDLE, std::memory_order_release);
+}
+
+// ==================== 公钥 ====================
+#ifdef OTA_PUBLIC_KEY
+static constexpr uint8_t BUILD_PUBLIC_KEY[] = {OTA_PUBLIC_KEY};
+static_assert(sizeof(BUILD_PUBLIC_KEY) == ED25519_PUBLIC_KEY_SIZE, "OTA_PUBLIC_KEY 必须是 32 个字节");
+static const uint8_t* publicKey = BUILD_PUBLIC_KEY;
+#else
+static const uint8_t* publicKey = nullptr;  // 构建时没有给出公钥：拒绝所有更新
+#endif
+
+#ifndef ARDUINO
+void otaSetPublicKey(const uint8_t* key) {
+  publicKey = key;
+}
+#endif
+
+// ==================== 接收 ====================
+static void failUpload(const char* reason) {
+  receiving = false;
+  const char* none = nullptr;
+  failReason.compare_exchange_strong(none, reason, std::memory_order_acq_rel);
+  abortRequested.store(true, std::memory_order_release);
+  halNotifyTask(TASK_OTA);
+}
+
+static const char* checkManifest(const OtaManifest& m) {
+  if (memcmp(m.magic, "BOTA", 4) != 0 || m.version != OTA_MANIFEST_VERSION) {
+    return "not a signed firmware file";
+  }
+  if (!publicKey) {
+    return "no signing key provisioned";
+  }
+  if (m.imageSize == 0) {
+    return "empty image";
+  }
+  return nullptr;
+}
+
+bool otaBegin(const char* filename) {
+  uint8_t current = state.load(std::memory_order_acquire);
+  if ((current != OTA_IDLE && current != OTA_FAILED) || !flashRing.acquire(RING_OTA)) {
+    LOG_WARN(LOG_OTA_BUSY, logText(filename));  // 另一个更新或动画片段上传正在使用缓冲区
+    return false;
+  }
+  receiving = true;
+  manifestLength = 0;
+  totalBytes.store(0, std::memory_order_relaxed);
+  receivedBytes.store(0, std::memory_order_relaxed);
+  writtenBytes.store(0, std::memory_order_relaxed);
+  stallCount.store(0, std::memory_order_relaxed);
+  stallMillis.store(0, std::memory_order_relaxed);
+  failReason.store(nullptr, std::memory_order_relaxed);
+  abortRequested.store(false, std::memory_order_relaxed);
+  startMillis.store((uint32_t)halMillis(), std::memory_order_relaxed);
+  endMillis.store(0, std::memory_order_relaxed);
+  session.fetch_add(1, std::memory_order_relaxed);
+  state.store(OTA_RECEIVING, std::memory_order_release);
+  LOG_INFO(LOG_OTA_BEGIN, logText(filename));
+  markChanged();
+  return true;
+}
+
+bool otaReceive(const uint8_t* data, size_t length) {
+  if (!receiving) {
+    return false;
+  }
+  if (state.load(std::memory_order_acquire) != OTA_RECEIVING) {
+    receiving = false;
+    return false;
+  }
+  if (manifestLength < sizeof(OtaManifest)) {
+    size_t n = sizeof(OtaManifest) - manifestLength < length ? sizeof(OtaManifest) - manifestLength : length;
+    memcpy((uint8_t*)&manifest + manifestLength, data, n);
+    manifestLength += n;
+    data += n;
+    length -= n;
+    if (manifestLength < sizeof(OtaManifest)) {
+      return true;
+    }
+    const char* error = checkManifest(manifest);
+    if (error) {
+      failUpload(error);
+      return false;
+    }
+    signedManifest = manifest;
+    totalBytes.store(manifest.imageSize, std::memory_order_release);
+    markChanged();
+  }
+
+  uint32_t total = manifest.imageSize;
+  uint32_t received = receivedBytes.load(std::memory_order_relaxed);
+  if (length > total - received) {
+    failUpload("image longer than manifest");
+    return false;
+  }
+  SectorRingResult result = flashRing.append(data, length);
+  stallCount.store(flashRing.stalls(), std::memory_order_relaxed);
+  stallMillis.store(flashRing.stallMillis(), std::memory_order_relaxed);
+  if (result == RING_STOPPED) {
+    receiving = false;  // 写入任务已经失败
+    return false;
+  }
+  if (result == RING_TIMEOUT) {
+    failUpload("flash write timeout");
+    return false;
+  }
+  received += length;
+  if (received == total) {
+    flashRing.flush();
+  }
+  receivedBytes.store(received, std::memory_order_relaxed);
+  return true;
+}
+
+bool otaReceiveDone() {
+  if (!receiving) {
+    return false;
+  }
+  if (manifestLength < sizeof(OtaManifest) || receivedBytes.load(std::memory_order_relaxed) != manifest.imageSize) {
+    failUpload("upload truncated");
+    return false;
+  }
+  receiving = false;
+  uint8_t expected = OTA_RECEIVING;
+  state.compare_exchange_strong(expected, OTA_WRITING, std::memory_order_acq_rel);
+  markChanged();
+  uint8_t current = state.load(std::memory_order_acquire);
+  return current == OTA_WRITING || current == OTA_REBOOTING;
+}
+
+void otaAbort() {
+  if (receiving) {
+    failUpload("connection closed");
+  }
+}
+
+const char* otaUploadError() {
+  return failReason.load(std::memory_order_acquire);
+}
+
+// ==================== 写入任务 ====================
+static void finishFailed(const char* reason) {
+  if (flashOpen) {
+    halOTAAbort();
+    flashOpen = false;
+  }
+  if (reason) {
+    const char* none = nullptr;
+    failReason.compare_exchange_strong(none, reason, std::memory_order_acq_rel);
+  }
+  abortRequested.store(false, std::memory_order_relaxed);
+  endMillis.store((uint32_t)halMillis(), std::memory_order_relaxed);
+  failureCount.fetch_add(1, std::memory_order_relaxed);
+  flashRing.stop();
+  state.store(OTA_FAILED, std::memory_order_release);
+  flashRing.release();
+  LOG_ERROR(LOG_OTA_FAILED, failReason.load(std::memory_order_acquire),
+            receivedBytes.load(std::memory_order_relaxed), writtenBytes.load(std::memory_order_relaxed));
+  markChanged();
+}
+
+// 镜像全部写入后：摘要一致才切换启动分区
+static uint32_t finishImage(uint32_t total) {
+  uint8_t digest[SHA256_DIGEST_SIZE];
+  imageHash.finish(digest);
+  if (!digestEqual(digest, signedManifest.sha256, SHA256_DIGEST_SIZE)) {
+    finishFailed("SHA-256 mismatch");
+    return UINT32_MAX;
+  }
+  flashOpen = false;  // end 失败时 Update 自己放弃
+  if (!halOTAEnd()) {
+    finishFailed(halOTAError());
+    return UINT32_MAX;
+  }
+  uint32_t now = (uint32_t)halMillis();
+  endMillis.store(now, std::memory_order_relaxed);
+  restartIssued = false;
+  state.store(OTA_REBOOTING, std::memory_order_release);
+  LOG_INFO(LOG_OTA_DONE, total, now - startMillis.load(std::memory_order_relaxed), (uint32_t)OTA_REBOOT_DELAY);
+  markChanged();
+  return OTA_REBOOT_DELAY * 1000UL;
+}
+
+uint32_t runOTATask() {
+  uint8_t current = state.load(std::memory_order_acquire);
+  if (current == OTA_REBOOTING) {
+    uint32_t elapsed = (uint32_t)halMillis() - endMillis.load(std::memory_order_relaxed);
+    if (elapsed < OTA_REBOOT_DELAY) {
+      return (OTA_REBOOT_DELAY - elapsed) * 1000UL;
+    }
+    if (!restartIssued) {
+      restartIssued = true;
+      halRestart();  // ESP32 上不返回
+    }
+    return UINT32_MAX;
+  }
+  if (current != OTA_RECEIVING && current != OTA_WRITING) {
+    return UINT32_MAX;
+  }
+  uint32_t currentSession = session.load(std::memory_order_relaxed);
+  if (currentSession != writerSession) {
+    writerSession = currentSession;
+    imageHash.reset();
+  }
+
+  const uint8_t* block;
+  size_t blockLength;
+  while (!abortRequested.load(std::memory_order_acquire) && flashRing.front(block, blockLength)) {
+    uint32_t total = totalBytes.load(std::memory_order_acquire);
+    if (!flashOpen) {
+      // 签名验证是一次完整的椭圆曲线运算，放在写入任务里而不是 AsyncTCP 回调里
+      if (!ed25519Verify(signedManifest.signature, (const uint8_t*)&signedManifest, OTA_MANIFEST_SIGNED_BYTES,
+                         publicKey)) {
+        finishFailed("bad manifest signature");
+        return UINT32_MAX;
+      }
+      if (!halOTABegin(total)) {
+        finishFailed(halOTAError());
+        return UINT32_MAX;
+      }
+      flashOpen = true;
+    }
+    imageHash.update(block, blockLength);
+    if (!halOTAWrite(block, blockLength)) {
+      finishFailed(halOTAError());
+      return UINT32_MAX;
+    }
+    uint32_t bytes = writtenBytes.load(std::memory_order_relaxed) + blockLength;
+    writtenBytes.store(bytes, std::memory_order_relaxed);
+    flashRing.pop();
+    if (bytes == total) {
+      return finishImage(total);
+    }
+  }
+  if (abortRequested.load(std::memory_order_acquire)) {
+    finishFailed(nullptr);
+  }
+  return UINT32_MAX;
+}
+
+// ==================== 状态 ====================
+OtaStatus otaStatus() {
+  OtaStatus status;
+  status.state = (OtaState)state.load(std::memory_order_acquire);
+  status.error = status.state == OTA_FAILED ? failReason.load(std::memory_order_acquire) : nullptr;
+  status.total = totalBytes.load(std::memory_order_relaxed);
+  status.received = receivedBytes.load(std::memory_order_relaxed);
+  status.written = writtenBytes.load(std::memory_order_relaxed);
+  uint32_t end = status.state == OTA_RECEIVING || status.state == OTA_WRITING
+                     ? (uint32_t)halMillis() : endMillis.load(std::memory_order_relaxed);
+  status.elapsedMillis = status.state == OTA_IDLE ? 0 : end - startMillis.load(std::memory_order_relaxed);
+  status.stalls = stallCount.load(std::memory_order_relaxed);
+  status.stallMillis = stallMillis.load(std::memory_order_relaxed);
+  status.failures = failureCount.load(std::memory_order_relaxed);
+  return status;
+}
+
+bool otaBusy() {
+  uint8_t current = state.load(std::memory_order_acquire);
+  return current == OTA_RECEIVING || current == OTA_WRITING || current == OTA_REBOOTING;
+}
+
+static const char* const STATE_NAMES[] = {"idle", "receiving", "writing", "rebooting", "failed"};
+
+void encodeOTAStatusJSON(TextWriter& out) {
+  OtaStatus status = otaStatus();
+  out.beginObject()
+      .key("state").put('"').raw(STATE_NAMES[status.state]).put('"')
+      .field("total", status.total)
+      .field("received", status.received)
+      .field("written", status.written)
+      .field("ms", status.elapsedMillis)
+      .field("kBps", status.elapsedMillis ? (uint32_t)((uint64_t)status.written * 1000 / 1024 / status.elapsedMillis) : 0)
+      .field("stalls", status.stalls)
+      .field("stallMs", status.stallMillis)
+      .field("failures", status.failures);
+  if (status.error) {
+    out.key("error").put('"').raw(status.error).put('"');
+  }
+  out.endObject();
+}
+
+// ==================== 进度广播（网络任务） ====================
+static uint32_t publishedChanges = 0;
+
+bool otaProgressPending() {
+  return changes.load(std::memory_order_acquire) != publishedChanges;
+}
+
+void publishOTAProgress() {
+  uint32_t latest = changes.load(std::memory_order_acquire);
+  uint8_t current = state.load(std::memory_order_acquire);
+  bool active = current == OTA_RECEIVING || current == OTA_WRITING;
+  if (latest == publishedChanges && !active) {
+    return;
+  }
+  publishedChanges = latest;
+  FixedTextWriter<OTA_STATUS_JSON_CAPACITY + 16> json;
+  json.beginObject().key("ota");
+  encodeOTAStatusJSON(json);
+  json.endObject();
+  wsBroadcast((const uint8_t*)json.c_str(), json.length(), false, WS_CLASS_PROGRESS);
+  if (active) {
+    networkScheduler.scheduleAt(JOB_OTA, halMicros() + OTA_PROGRESS_INTERVAL * 1000UL);
+  }
+}
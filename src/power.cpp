@@ -0,0 +1,331 @@
+#include <atomic>
+#include "power.h"
+#include "seqlock.h"
+#include "ball.h"
+#include "effects.h"
+#include "button_events.h"
+#include "button_rules.h"
+#include "input_trace.h"
+#include "led_compositor.h"
+#include "metrics.h"
+#include "log.h"
+#include "ws_fanout.h"
+#include "wifi_manager.h"
+#include "mqtt_manager.h"
+#include "mqtt_commands.h"
+#include "ota.h"
+
+static const char* const BLOCKER_NAMES[NUM_POWER_BLOCKERS] = {
+  "sleep", "disabled", "active", "input", "led", "network", "link", "viewers", "short"
+};
+
+static constexpr const char* WAKE_CAUSE_NAMES[NUM_POWER_WAKE_CAUSES] = {
+  "timer", "button", "other"
+};
+
+static std::atomic<bool> enabled(POWER_SAVE_ENABLED != 0);
+static std::atomic<bool> idle(false);                 // 仅渲染任务写
+static std::atomic<uint32_t> networkWakeMicros(0);    // 仅网络任务写
+static std::atomic<bool> networkHold(false);          // 仅网络任务写：WiFi/MQTT 正在连接
+static std::atomic<bool> linkUp(false);               // 仅网络任务写：WiFi 已连接
+static std::atomic<bool> networkViewers(false);       // 仅网络任务写：有 WebSocket 客户端
+
+// 渲染任务
+static uint32_t lastActivityMillis = 0;
+static uint32_t accountedMicros = 0;   // 上一次计入 awake/slept 的时刻
+static uint32_t wakeMicros = 0;
+static bool awaitingFrame = false;     // 醒来后还没有渲染过帧
+static PowerStats stats;               // 工作副本
+static Seqlock<PowerStats> published;  // 网络任务（MQTT 摘要）、HTTP（/api/metrics）读取
+static uint32_t publishedMillis = 0;
+static uint8_t lastBlocker = POWER_SLEEP;
+
+static void publishStats() {
+  published.write(stats);
+  publishedMillis = halMillis();
+}
+
+// 每次 runRenderTask() 都会决策一次：只在结果变化或距上次发布超过间隔时发布，不在每帧写 Seqlock
+static void countDecision(uint8_t blocker) {
+  stats.decisions[blocker]++;
+  if (blocker != lastBlocker || halMillis() - publishedMillis >= POWER_STATS_PUBLISH_INTERVAL) {
+    lastBlocker = blocker;
+    publishStats();
+  }
+}
+
+static uint32_t awakePermille(const PowerStats& s) {
+  uint64_t total = s.awakeMicros + s.sleptMicros;
+  return total ? (uint32_t)(s.awakeMicros * 1000 / total) : 1000;
+}
+
+// 网络任务
+static bool networkIdleApplied = false;
+
+// ==================== 睡眠决策 ====================
+PowerDecision decidePowerSleep(const PowerInputs& in) {
+  PowerDecision decision = {POWER_SLEEP, 0};
+  if (!in.enabled) {
+    decision.blocker = POWER_BLOCK_DISABLED;
+  } else if (!in.idle) {
+    decision.blocker = POWER_BLOCK_ACTIVE;
+  } else if (in.inputBusy) {
+    decision.blocker = POWER_BLOCK_INPUT;
+  } else if (in.ledBusy) {
+    decision.blocker = POWER_BLOCK_LED;
+  } else if (in.networkBusy) {
+    decision.blocker = POWER_BLOCK_NETWORK;
+  } else if (in.linkUp) {
+    decision.blocker = POWER_BLOCK_LINK;
+  } else if (in.viewers) {
+    decision.blocker = POWER_BLOCK_VIEWERS;
+  } else {
+    uint32_t window = in.renderWaitMicros < in.networkWaitMicros ? in.renderWaitMicros : in.networkWaitMicros;
+    if (window > POWER_MAX_SLEEP * 1000UL) {
+      window = POWER_MAX_SLEEP * 1000UL;
+    }
+    if (window < POWER_MIN_SLEEP_US) {
+      decision.blocker = POWER_BLOCK_SHORT;
+    } else {
+      decision.sleepMicros = window - POWER_WAKE_MARGIN_US;
+    }
+  }
+  return decision;
+}
+
+// ==================== 状态 ====================
+void initializePower() {
+  idle.store(false);
+  networkWakeMicros.store(halMicros());
+  networkHold.store(false);
+  linkUp.store(false);
+  networkViewers.store(false);
+  lastActivityMillis = halMillis();
+  accountedMicros = halMicros();
+  awaitingFrame = false;
+  networkIdleApplied = false;
+  stats = PowerStats();
+  lastBlocker = POWER_SLEEP;
+  publishStats();
+}
+
+void setPowerSaveEnabled(bool on) {
+  enabled.store(on, std::memory_order_release);
+  halNotifyTask(TASK_RENDER);
+}
+
+bool powerSaveEnabled() {
+  return enabled.load(std::memory_order_acquire);
+}
+
+bool powerIdle() {
+  return idle.load(std::memory_order_acquire);
+}
+
+uint32_t ledFramePeriodMicros(const Effect& effect) {
+  uint32_t period = effect.framePeriodMillis;
+  if (powerIdle() && period < POWER_IDLE_FRAME_INTERVAL) {
+    period = POWER_IDLE_FRAME_INTERVAL;
+  }
+  return period * 1000UL;
+}
+
+void updatePowerState(bool inputActive) {
+  uint32_t now = halMillis();
+  if (inputActive) {
+    lastActivityMillis = now;
+  }
+  bool wasIdle = powerIdle();
+  // 进入空闲后只有按钮活动或关闭省电才退出，毫秒计数回绕不会让它来回切换
+  bool nextIdle = powerSaveEnabled() && !inputActive &&
+                  (wasIdle || now - lastActivityMillis >= POWER_IDLE_AFTER);
+  if (nextIdle == wasIdle) {
+    return;
+  }
+
+  idle.store(nextIdle, std::memory_order_release);
+  renderScheduler.setPeriod(JOB_LED, ledFramePeriodMicros(currentEffect()));
+  uint32_t pollMicros = nextIdle ? POWER_IDLE_INPUT_POLL_INTERVAL * 1000UL : RENDER_JOBS[JOB_INPUT].periodMicros;
+  renderScheduler.setPeriod(JOB_INPUT, pollMicros);
+  if (nextIdle) {
+    stats.idleEntries++;
+    publishStats();
+    LOG_INFO(LOG_POWER_IDLE, ledFramePeriodMicros(currentEffect()) / 1000);
+  } else {
+    // 恢复正常帧率和轮询周期，下一帧立即渲染
+    renderScheduler.runNow(JOB_LED);
+    renderScheduler.scheduleAt(JOB_INPUT, halMicros() + pollMicros);
+    LOG_INFO(LOG_POWER_ACTIVE, stats.sleeps, awakePermille(stats) / 10, awakePermille(stats) % 10);
+  }
+  halNotifyTask(TASK_NETWORK);  // 网络任务调整自己的作业周期
+}
+
+void notePowerFrame() {
+  if (awaitingFrame) {
+    awaitingFrame = false;
+    recordMetric(METRIC_WAKE_TO_FRAME, halMicros() - wakeMicros);
+  }
+}
+
+// ==================== 浅睡眠（渲染任务） ====================
+static void accountAwake(uint32_t now) {
+  stats.awakeMicros += now - accountedMicros;
+  accountedMicros = now;
+}
+
+uint32_t powerSleep(uint32_t waitMicros, bool networkWorkPosted) {
+  if (!powerSaveEnabled()) {
+    countDecision(POWER_BLOCK_DISABLED);
+    return waitMicros;
+  }
+  uint32_t now = halMicros();
+  accountAwake(now);
+
+  int32_t untilNetwork = (int32_t)(networkWakeMicros.load(std::memory_order_acquire) - now);
+  PowerInputs in;
+  in.enabled = true;
+  in.idle = powerIdle();
+  in.inputBusy = hasPendingButtonEvents() || rulesPending() || inputTraceCommandPending() || mqttCommandsPending() ||
+                 buttonInput.raw != buttonInput.pressed;
+  in.ledBusy = compositorBusy();
+  in.networkBusy = networkWorkPosted || networkHold.load(std::memory_order_acquire) || otaBusy();
+  in.linkUp = linkUp.load(std::memory_order_acquire);
+  in.viewers = networkViewers.load(std::memory_order_acquire);
+  in.renderWaitMicros = waitMicros;
+  in.networkWaitMicros = untilNetwork > 0 ? (uint32_t)untilNetwork : 0;
+  PowerDecision decision = decidePowerSleep(in);
+  if (decision.blocker != POWER_SLEEP) {
+    countDecision(decision.blocker);
+    return waitMicros;
+  }
+  stats.decisions[POWER_SLEEP]++;
+  lastBlocker = POWER_SLEEP;
+
+  // 以重建的原始状态为准：睡眠前已经发生、尚未处理的变化会让芯片立即醒来
+  uint8_t levels[BTN_COUNT];
+  for (uint8_t i = 0; i < BTN_COUNT; i++) {
+    levels[i] = (buttonInput.raw & BUTTON_MASK(i)) ? LOW : HIGH;
+  }
+  HalWakeCause cause = halLightSleep(decision.sleepMicros, BUTTON_PINS, levels, BTN_COUNT);
+  uint32_t woke = halMicros();
+  stats.sleptMicros += woke - now;
+  accountedMicros = woke;
+  stats.sleeps++;
+  stats.wakes[cause == HAL_WAKE_TIMER ? POWER_WAKE_TIMER :
+              cause == HAL_WAKE_GPIO ? POWER_WAKE_BUTTON : POWER_WAKE_OTHER]++;
+  publishStats();
+  wakeMicros = woke;
+  // 只统计为渲染下一帧而醒来（或按钮唤醒）的延迟，为网络作业醒来时帧还要过一段时间才到期
+  awaitingFrame = cause != HAL_WAKE_TIMER ||
+                  (int32_t)(renderScheduler.job(JOB_LED).deadlineMicros - woke) <= (int32_t)POWER_WAKE_MARGIN_US;
+
+  if (cause != HAL_WAKE_TIMER) {
+    requestButtonResync();  // 睡眠期间的边沿没有进入队列
+  }
+  if ((int32_t)(networkWakeMicros.load(std::memory_order_acquire) - woke) <= (int32_t)POWER_WAKE_MARGIN_US) {
+    halNotifyTask(TASK_NETWORK);
+  }
+  return 0;
+}
+
+// ==================== 网络任务 ====================
+uint32_t updateNetworkPower(uint32_t waitMicros) {
+  bool nowIdle = powerIdle();
+  if (nowIdle != networkIdleApplied) {
+    networkIdleApplied = nowIdle;
+    networkScheduler.setPeriod(JOB_MQTT, nowIdle ? POWER_IDLE_MQTT_INTERVAL * 1000UL : NETWORK_JOBS[JOB_MQTT].periodMicros);
+    networkScheduler.setPeriod(JOB_LOG, nowIdle ? POWER_IDLE_LOG_INTERVAL * 1000UL : NETWORK_JOBS[JOB_LOG].periodMicros);
+    halWiFiSetPowerSave(nowIdle);
+    if (!nowIdle) {
+      networkScheduler.runNow(JOB_MQTT);  // 恢复原来的收包节奏
+      waitMicros = 0;
+    }
+  }
+
+  WiFiState wifi = wifiManagerState();
+  networkHold.store(wifi == WIFI_STATE_CONNECTING_CACHED || wifi == WIFI_STATE_CONNECTING ||
+                    mqttManagerState() == MQTT_STATE_CONNECTING, std::memory_order_relaxed);
+  // 关联着 AP 时浅睡眠会漏掉信标被断开：只在 WiFi 断开、退避等待时睡
+  linkUp.store(wifi == WIFI_STATE_CONNECTED, std::memory_order_relaxed);
+  networkViewers.store(wsFanoutStats().clients > 0, std::memory_order_relaxed);
+  // 渲染任务可能刚因为旧的截止时间已到而放弃睡眠，登记新的截止时间后让它重新决定
+  uint32_t now = halMicros();
+  bool wasDue = (int32_t)(networkWakeMicros.load(std::memory_order_relaxed) - now) <= 0;
+  networkWakeMicros.store(now + waitMicros, std::memory_order_release);
+  if (nowIdle && wasDue && waitMicros > 0) {
+    halNotifyTask(TASK_RENDER);
+  }
+  return waitMicros;
+}
+
+// ==================== 统计 ====================
+PowerStats powerStats() {
+  PowerStats snapshot;
+  published.read(snapshot);
+  return snapshot;
+}
+
+uint32_t powerAwakePermille() {
+  return awakePermille(powerStats());
+}
+
+const char* powerBlockerName(uint8_t blocker) {
+  return blocker < NUM_POWER_BLOCKERS ? BLOCKER_NAMES[blocker] : "?";
+}
+
+const char* powerWakeCauseName(uint8_t cause) {
+  return cause < NUM_POWER_WAKE_CAUSES ? WAKE_CAUSE_NAMES[cause] : "?";
+}
+
+void encodePowerSummary(TextWriter& out) {
+  PowerStats snapshot = powerStats();
+  out.beginObject()
+     .flag("idle", powerIdle())
+     .field("awake", awakePermille(snapshot))
+     .field("sleeps", snapshot.sleeps);
+  for (uint8_t c = 0; c < NUM_POWER_WAKE_CAUSES; c++) {
+    out.field(WAKE_CAUSE_NAMES[c], snapshot.wakes[c]);
+  }
+  out.endObject();
+}
+
+static const char AWAKE_RATIO_TEXT[] =
+  "# HELP ball_power_awake_ratio Share of time awake since power saving was enabled\n"
+  "# TYPE ball_power_awake_ratio gauge\n"
+  "ball_power_awake_ratio ";
+static const char SLEEP_SECONDS_TEXT[] =
+  "# HELP ball_power_sleep_seconds_total Time spent in light sleep\n"
+  "# TYPE ball_power_sleep_seconds_total counter\n"
+  "ball_power_sleep_seconds_total ";
+static const char WAKES_TEXT[] =
+  "# HELP ball_power_wakes_total Light-sleep wakeups by cause\n"
+  "# TYPE ball_power_wakes_total counter\n";
+static const char WAKE_LINE_TEXT[] = "ball_power_wakes_total{cause=\"\"} ";
+#define POWER_CAUSE_NAME_MAX 8
+
+static constexpr bool causeNamesFit() {
+  for (const char* name : WAKE_CAUSE_NAMES) {
+    size_t length = 0;
+    while (name[length]) length++;
+    if (length > POWER_CAUSE_NAME_MAX) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static_assert(causeNamesFit(), "唤醒原因名超出 POWER_CAUSE_NAME_MAX");
+
+static_assert(sizeof(AWAKE_RATIO_TEXT) + 5 + sizeof(SLEEP_SECONDS_TEXT) + 21 + sizeof(WAKES_TEXT) +
+              NUM_POWER_WAKE_CAUSES * (sizeof(WAKE_LINE_TEXT) + POWER_CAUSE_NAME_MAX + 10) <= POWER_TEXT_CAPACITY,
+              "POWER_TEXT_CAPACITY 不足");  // 每个 sizeof 多出的 1 字节留给换行
+
+void encodePowerText(TextWriter& out) {
+  PowerStats snapshot = powerStats();
+  out.raw(AWAKE_RATIO_TEXT).fixed(awakePermille(snapshot), 3).put('\n');  // 最多 "1.000"
+  out.raw(SLEEP_SECONDS_TEXT).fixed(snapshot.sleptMicros, 6).put('\n');
+  out.raw(WAKES_TEXT);
+  for (uint8_t c = 0; c < NUM_POWER_WAKE_CAUSES; c++) {
+    out.raw("ball_power_wakes_total{cause=\"").raw(WAKE_CAUSE_NAMES[c]).raw("\"} ").u32(snapshot.wakes[c]).put('\n');
+  }
+}
@@ -0,0 +1,134 @@
+#include "scheduler.h"
+#include "hal.h"
+
+static JobObserver jobObserver = nullptr;
+
+// 截止时间按 32 位微秒回绕比较，要求周期小于 35 分钟
+static inline bool before(uint32_t a, uint32_t b) {
+  return (int32_t)(a - b) < 0;
+}
+
+void Scheduler::setObserver(JobObserver observer) {
+  jobObserver = observer;
+}
+
+void Scheduler::begin(const JobSpec* specs, uint8_t count) {
+  uint32_t now = halMicros();
+  count_ = count < SCHEDULER_MAX_JOBS ? count : SCHEDULER_MAX_JOBS;
+  for (uint8_t i = 0; i < count_; i++) {
+    Job& job = jobs_[i];
+    job.name = specs[i].name;
+    job.run = specs[i].run;
+    job.periodMicros = specs[i].periodMicros > 0 ? specs[i].periodMicros : 1;
+    job.toleranceMicros = specs[i].toleranceMicros;
+    job.deadlineMicros = now;  // 启动后立即运行一次
+    job.runs = 0;
+    job.misses = 0;
+    job.maxLatenessMicros = 0;
+    job.heapIndex = i;
+    heap_[i] = i;
+  }
+}
+
+uint32_t Scheduler::runDue() {
+  // 每次最多运行 2 * count_ 个作业，避免某个作业落后太多时饿死调用方
+  for (uint8_t budget = count_ * 2; count_ > 0 && budget > 0; budget--) {
+    Job& job = jobs_[heap_[0]];
+    uint32_t now = halMicros();
+    if (before(now, job.deadlineMicros)) {
+      break;
+    }
+
+    uint32_t lateness = now - job.deadlineMicros;
+    if (lateness > job.maxLatenessMicros) {
+      job.maxLatenessMicros = lateness;
+    }
+    if (lateness > job.toleranceMicros) {
+      job.misses++;
+    }
+
+    // 保持相位；落后超过一个周期时不补跑，直接从现在开始计
+    job.deadlineMicros += job.periodMicros;
+    if (!before(now, job.deadlineMicros)) {
+      job.deadlineMicros = now + job.periodMicros;
+    }
+    siftDown(0);
+
+    if (jobObserver) jobObserver(job, false);
+    job.run();
+    job.runs++;
+    if (jobObserver) jobObserver(job, true);
+  }
+  return microsUntilNext();
+}
+
+uint32_t Scheduler::microsUntilNext() const {
+  if (count_ == 0) {
+    return UINT32_MAX;
+  }
+  uint32_t now = halMicros();
+  uint32_t deadline = jobs_[heap_[0]].deadlineMicros;
+  return before(now, deadline) ? deadline - now : 0;
+}
+
+void Scheduler::runNow(uint8_t job) {
+  scheduleAt(job, halMicros());
+}
+
+void Scheduler::scheduleAt(uint8_t job, uint32_t deadlineMicros) {
+  if (job >= count_) {
+    return;
+  }
+  uint32_t previous = jobs_[job].deadlineMicros;
+  jobs_[job].deadlineMicros = deadlineMicros;
+  if (before(deadlineMicros, previous)) {
+    siftUp(jobs_[job].heapIndex);
+  } else {
+    siftDown(jobs_[job].heapIndex);
+  }
+}
+
+void Scheduler::setPeriod(uint8_t job, uint32_t periodMicros) {
+  if (job < count_) {
+    jobs_[job].periodMicros = periodMicros > 0 ? periodMicros : 1;
+  }
+}
+
+// ==================== 最小堆 ====================
+bool Scheduler::earlier(uint8_t a, uint8_t b) const {
+  return before(jobs_[heap_[a]].deadlineMicros, jobs_[heap_[b]].deadlineMicros);
+}
+
+void Scheduler::swap(uint8_t a, uint8_t b) {
+  uint8_t t = heap_[a];
+  heap_[a] = heap_[b];
+  heap_[b] = t;
+  jobs_[heap_[a]].heapIndex = a;
+  jobs_[heap_[b]].heapIndex = b;
+}
+
+void Scheduler::siftUp(uint8_t position) {
+  while (position > 0) {
+    uint8_t parent = (position - 1) / 2;
+    if (!earlier(position, parent)) {
+      break;
+    }
+    swap(position, parent);
+    position = parent;
+  }
+}
+
+void Scheduler::siftDown(uint8_t position) {
+  for (;;) {
+    uint8_t smallest = position;
+    uint8_t left = 2 * position + 1;
+    uint8_t right = left + 1;
+    if (left < count_ && earlier(left, smallest)) smallest = left;
+    if (right < count_ && earlier(right, smallest)) smallest = right;
+    if (smallest == position) {
+      break;
+    }
+    swap(position, smallest);
+    position = smallest;
+  }
+}
@@ -0,0 +1,109 @@
+#include <string.h>
+#include "sector_ring.h"
+#include "tasks.h"
+
+static_assert(OTA_BUFFER_COUNT >= 2 && (OTA_BUFFER_COUNT & (OTA_BUFFER_COUNT - 1)) == 0,
+              "OTA_BUFFER_COUNT 必须是2的幂且至少为2，接收和写入才能重叠");
+static_assert(HAL_FLASH_SECTOR_SIZE <= UINT16_MAX, "块长度用 uint16_t 保存");
+static_assert(OTA_STALL_TIMEOUT <= 1000, "接收方在 AsyncTCP 任务里阻塞，等待上限要远小于任务看门狗（5 s）");
+
+SectorRing flashRing;
+
+// ==================== 接收方 ====================
+// 上一次上传的写入任务 release() 之后才能成功，所以清零时没有人在读块
+bool SectorRing::acquire(uint8_t owner) {
+  uint8_t expected = RING_FREE;
+  if (!owner_.compare_exchange_strong(expected, owner, std::memory_order_acq_rel)) {
+    return false;
+  }
+  fillLength_ = 0;
+  filled_.store(0, std::memory_order_relaxed);
+  written_.store(0, std::memory_order_relaxed);
+  stopped_.store(false, std::memory_order_relaxed);
+  stalls_.store(0, std::memory_order_relaxed);
+  stallMillis_.store(0, std::memory_order_relaxed);
+  return true;
+}
+
+// 等 filled 这一块空出来（写入任务写完 filled - OTA_BUFFER_COUNT 那一块）。阻塞在 SIGNAL_OTA_BLOCK 上，
+// 写入任务每写完一块或放弃时给出；之前留下的信号只多检查一次条件
+bool SectorRing::waitForBlock(uint32_t filled) {
+  if (filled - written_.load(std::memory_order_acquire) < OTA_BUFFER_COUNT) {
+    return true;
+  }
+  uint32_t start = (uint32_t)halMillis();
+  stalls_.fetch_add(1, std::memory_order_relaxed);
+  while (filled - written_.load(std::memory_order_acquire) >= OTA_BUFFER_COUNT) {
+    uint32_t waited = (uint32_t)halMillis() - start;
+    if (stopped_.load(std::memory_order_acquire) || waited >= OTA_STALL_TIMEOUT) {
+      stallMillis_.fetch_add(waited, std::memory_order_relaxed);
+      return false;
+    }
+    halSignalTake(SIGNAL_OTA_BLOCK, (OTA_STALL_TIMEOUT - waited) * 1000UL);
+  }
+  stallMillis_.fetch_add((uint32_t)halMillis() - start, std::memory_order_relaxed);
+  return true;
+}
+
+SectorRingResult SectorRing::append(const uint8_t* data, size_t length) {
+  while (length > 0) {
+    if (stopped_.load(std::memory_order_acquire)) {
+      return RING_STOPPED;
+    }
+    uint32_t filled = filled_.load(std::memory_order_relaxed);
+    if (fillLength_ == 0 && !waitForBlock(filled)) {
+      return stopped_.load(std::memory_order_acquire) ? RING_STOPPED : RING_TIMEOUT;
+    }
+    uint8_t slot = filled % OTA_BUFFER_COUNT;
+    size_t n = HAL_FLASH_SECTOR_SIZE - fillLength_ < length ? HAL_FLASH_SECTOR_SIZE - fillLength_ : length;
+    memcpy(blocks_[slot] + fillLength_, data, n);
+    fillLength_ += n;
+    data += n;
+    length -= n;
+    if (fillLength_ == HAL_FLASH_SECTOR_SIZE) {
+      flush();
+    }
+  }
+  return RING_OK;
+}
+
+void SectorRing::flush() {
+  if (fillLength_ == 0) {
+    return;
+  }
+  uint32_t filled = filled_.load(std::memory_order_relaxed);
+  blockLength_[filled % OTA_BUFFER_COUNT] = (uint16_t)fillLength_;
+  fillLength_ = 0;
+  filled_.store(filled + 1, std::memory_order_release);
+  halNotifyTask(TASK_OTA);
+}
+
+// ==================== 写入任务 ====================
+bool SectorRing::front(const uint8_t*& data, size_t& length) const {
+  uint32_t written = written_.load(std::memory_order_relaxed);
+  if (written == filled_.load(std::memory_order_acquire)) {
+    return false;
+  }
+  uint8_t slot = written % OTA_BUFFER_COUNT;
+  data = blocks_[slot];
+  length = blockLength_[slot];
+  return true;
+}
+
+void SectorRing::pop() {
+  written_.store(written_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+  halSignalGive(SIGNAL_OTA_BLOCK);
+}
+
+bool SectorRing::empty() const {
+  return written_.load(std::memory_order_relaxed) == filled_.load(std::memory_order_acquire);
+}
+
+void SectorRing::stop() {
+  stopped_.store(true, std::memory_order_release);
+  halSignalGive(SIGNAL_OTA_BLOCK);
+}
+
+void SectorRing::release() {
+  owner_.store(RING_FREE, std::memory_order_release);
+}
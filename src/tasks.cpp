@@ -0,0 +1,151 @@
+#include <atomic>
+#include "tasks.h"
+#include "ball.h"
+#include "seqlock.h"
+#include "spsc_queue.h"
+#include "button_events.h"
+#include "button_rules.h"
+#include "led_compositor.h"
+#include "log.h"
+#include "ws_fanout.h"
+#include "input_trace.h"
+#include "power.h"
+#include "mqtt_commands.h"
+#include "ota.h"
+#include "clips.h"
+
+// ==================== 任务间通道 ====================
+static Seqlock<BallSnapshot> snapshot;
+static SpscQueue<OutboundMessage, MQTT_OUTBOX_SIZE> outbox;
+static TaskStats stats;
+static std::atomic<bool> keyframeRequested(false);
+
+Scheduler renderScheduler;
+Scheduler networkScheduler;
+
+void initializeTasks() {
+  stats = TaskStats{0, 0, 0};
+  renderScheduler.begin(RENDER_JOBS, NUM_RENDER_JOBS);
+  networkScheduler.begin(NETWORK_JOBS, NUM_NETWORK_JOBS);
+}
+
+uint32_t runRenderTask() {
+  if (hasPendingButtonEvents() || rulesPending() || inputTraceCommandPending() || mqttCommandsPending()) {
+    renderScheduler.runNow(JOB_INPUT);
+  }
+  if (halLEDTakeEvent()) {
+    compositorFrameDone();  // 不是作业：只是把挂起的帧交给外设
+  }
+  uint32_t wait = renderScheduler.runDue();
+  // 渲染任务交给网络任务、网络任务还没取走的工作
+  bool posted = outbox.size() > 0 || inputTraceFlushPending() || mqttCommandReplyPending();
+  return powerSleep(wait, posted);
+}
+
+uint32_t runNetworkTask() {
+  if (halWiFiTakeEvent()) {
+    networkScheduler.runNow(JOB_WIFI);
+  }
+  if (halMQTTTakeEvent()) {
+    networkScheduler.runNow(JOB_MQTT_CONNECT);
+  }
+  if (outbox.size() > 0 || mqttCommandReplyPending()) {
+    networkScheduler.runNow(JOB_MQTT);
+  }
+  if (webSocketUpdatePending()) {
+    networkScheduler.runNow(JOB_WEBSOCKET);
+  }
+  if (wsFanoutPending()) {
+    networkScheduler.runNow(JOB_WS_CLIENTS);
+  }
+  if (logPending()) {
+    networkScheduler.runNow(JOB_LOG);
+  }
+  if (inputTraceFlushPending()) {
+    networkScheduler.runNow(JOB_TRACE);
+  }
+  if (otaProgressPending()) {
+    networkScheduler.runNow(JOB_OTA);
+  }
+  return updateNetworkPower(networkScheduler.runDue());
+}
+
+uint32_t runFlashTask() {
+  uint32_t otaWait = runOTATask();
+  uint32_t clipWait = runClipWriter();
+  return otaWait < clipWait ? otaWait : clipWait;
+}
+
+void startTasks() {
+  halStartTask(TASK_RENDER, "render", runRenderTask,
+               RENDER_TASK_STACK, RENDER_TASK_PRIORITY, RENDER_TASK_CORE);
+  halStartTask(TASK_NETWORK, "network", runNetworkTask,
+               NETWORK_TASK_STACK, NETWORK_TASK_PRIORITY, NETWORK_TASK_CORE);
+  halStartTask(TASK_OTA, "flash", runFlashTask,
+               OTA_TASK_STACK, OTA_TASK_PRIORITY, OTA_TASK_CORE);
+}
+
+// ==================== 渲染侧 ====================
+void publishStateSnapshot() {
+  static BallSnapshot published;
+  static bool valid = false;
+
+  BallSnapshot next;
+  next.pressed = buttonInput.pressed;
+  next.ledMode = (uint8_t)ledController.mode;
+  next.greenBreathBrightness = (uint8_t)ledController.greenBreathBrightness;
+  next.remote = ledController.remote;
+  next.reserved = 0;
+  if (valid && next.pressed == published.pressed && next.ledMode == published.ledMode &&
+      next.greenBreathBrightness == published.greenBreathBrightness && next.remote == published.remote) {
+    return;
+  }
+
+  next.updatedMillis = halMillis();
+  snapshot.write(next);
+  published = next;
+  valid = true;
+  stats.snapshotsPublished++;
+  halNotifyTask(TASK_NETWORK);
+}
+
+bool postMQTTEvent(uint8_t event, uint32_t edgeMicros) {
+  OutboundMessage message = {(uint32_t)halMillis(), (uint32_t)halMicros(), edgeMicros, event};
+  if (!outbox.push(message)) {
+    stats.messagesDropped++;
+    return false;
+  }
+  stats.messagesPosted++;
+  halNotifyTask(TASK_NETWORK);
+  return true;
+}
+
+// ==================== 网络/HTTP 侧 ====================
+uint32_t readStateSnapshot(BallSnapshot& out) {
+  return snapshot.read(out);
+}
+
+uint32_t stateSnapshotVersion() {
+  return snapshot.version();
+}
+
+void requestStateKeyframe() {
+  keyframeRequested.store(true, std::memory_order_release);
+  halNotifyTask(TASK_NETWORK);
+}
+
+bool takeStateKeyframeRequest() {
+  return keyframeRequested.exchange(false, std::memory_order_acq_rel);
+}
+
+bool stateKeyframeRequested() {
+  return keyframeRequested.load(std::memory_order_acquire);
+}
+
+bool takeMQTTMessage(OutboundMessage& message) {
+  return outbox.pop(message);
+}
+
+const TaskStats& taskStats() {
+  return stats;
+}
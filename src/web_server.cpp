@@ -0,0 +1,353 @@
+#include <ESPAsyncWebServer.h>
+#include <AsyncTCP.h>
+#include <LittleFS.h>
+#include "ball.h"
+#include "button_events.h"
+#include "ws_protocol.h"
+#include "web_ui.h"
+#include "mqtt_outbox.h"
+#include "metrics.h"
+#include "power.h"
+#include "log.h"
+#include "ws_fanout.h"
+#include "input_trace.h"
+#include "clips.h"
+#include "ota.h"
+
+// ==================== Web服务器 / OTA（仅ESP32构建） ====================
+AsyncWebServer webServer(WEB_SERVER_PORT);
+extern AsyncWebSocket webSocket;  // 定义于 hal_esp32.cpp
+
+// JSON 响应写在栈上的定长缓冲区里（见 text_writer.h），AsyncWebServer 复制一次后异步发送
+#define INPUT_STATS_JSON_CAPACITY 96  // 4 个 uint32 字段
+#define MQTT_STATS_JSON_CAPACITY 192  // 9 个 uint32 字段
+#define BOOTSTRAP_JSON_CAPACITY (BTN_COUNT * 4 + 40)  // 引脚列表 + 协议名
+#define WS_CLIENT_JSON_CAPACITY 140  // 每个客户端：7 个 uint32 字段 + 布尔
+#define WS_STATS_JSON_CAPACITY (WS_MAX_CLIENTS * WS_CLIENT_JSON_CAPACITY + 112)
+#define CLIP_JSON_CAPACITY 112  // 每个片段：名称 + 5 个字段
+#define CLIPS_JSON_CAPACITY (CLIP_MAX * CLIP_JSON_CAPACITY + 128)
+
+// /api/metrics 的文本约 11 KB，不放在 AsyncTCP 任务栈上也不复制到堆：
+// 生成到静态缓冲区后分段发送。最后一段复制进响应的发送缓冲区（或连接提前断开）之前拒绝新的请求；
+// 只认当前持有缓冲区的请求，旧请求迟到的断开回调不会放掉新请求的缓冲区
+static char metricsText[METRICS_TEXT_CAPACITY + POWER_TEXT_CAPACITY];
+static size_t metricsLength = 0;
+static AsyncWebServerRequest *metricsRequest = nullptr;
+
+// /api/ws 的客户端数组较大，同样写在静态缓冲区里（只在 AsyncTCP 任务中使用，send() 立即复制）
+static char wsStatsText[WS_STATS_JSON_CAPACITY];
+static char clipsText[CLIPS_JSON_CAPACITY];
+
+// 正在上传固件、动画片段的请求（只在 AsyncTCP 任务中使用）
+static AsyncWebServerRequest *otaRequest = nullptr;
+static AsyncWebServerRequest *clipRequest = nullptr;
+
+void serveMetrics(AsyncWebServerRequest *request);
+void onWebSocketEvent(AsyncWebSocket *server, AsyncWebSocketClient *client, 
+                      AwsEventType type, void *arg, uint8_t *data, size_t len);
+void serveWebUI(AsyncWebServerRequest *request);
+void handleOTAUpload(AsyncWebServerRequest *request, String filename, 
+                     size_t index, uint8_t *data, size_t len, bool final);
+void handleClipUpload(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total);
+
+void initializeWebServer() {
+  webSocket.onEvent(onWebSocketEvent);
+  webServer.addHandler(&webSocket);
+  
+  webServer.on("/", HTTP_GET, serveWebUI);
+
+  // 页面里与设备相关的数据：按钮引脚列表和 WebSocket 协议
+  webServer.on("/api/bootstrap", HTTP_GET, [](AsyncWebServerRequest *request) {
+    FixedTextWriter<BOOTSTRAP_JSON_CAPACITY> json;
+    json.beginObject().key("pins").put('[');
+    for (uint8_t i = 0; i < BTN_COUNT; i++) {
+      if (i) json.put(',');
+      json.u32(BUTTON_PINS[i]);
+    }
+    json.put(']');
+    json.key("protocol").raw(WEBSOCKET_PROTOCOL == WS_PROTOCOL_JSON ? "\"json\"" : "\"binary\"");
+    json.endObject();
+    request->send(200, "application/json", json.c_str());
+  });
+  
+  webServer.on("/api/buttons", HTTP_GET, [](AsyncWebServerRequest *request) {
+    BallSnapshot state;
+    readStateSnapshot(state);
+    FixedTextWriter<STATE_JSON_CAPACITY> json;
+    encodeStateJSON(json, state);
+    request->send(200, "application/json", json.c_str());
+  });
+  
+  webServer.on("/api/input", HTTP_GET, [](AsyncWebServerRequest *request) {
+    const ButtonEventStats& stats = buttonEventStats();
+    FixedTextWriter<INPUT_STATS_JSON_CAPACITY> json;
+    json.beginObject()
+        .field("captured", stats.captured)
+        .field("dropped", stats.dropped)
+        .field("overflows", stats.overflows)
+        .field("maxDepth", stats.maxDepth)
+        .endObject();
+    request->send(200, "application/json", json.c_str());
+  });
+  
+  // 统计由网络任务更新，这里读到的各字段可能不是同一时刻的
+  webServer.on("/api/mqtt", HTTP_GET, [](AsyncWebServerRequest *request) {
+    const OutboxStats& stats = mqttOutboxStats();
+    FixedTextWriter<MQTT_STATS_JSON_CAPACITY> json;
+    json.beginObject()
+        .field("depth", stats.depth)
+        .field("maxDepth", stats.maxDepth)
+        .field("enqueued", stats.enqueued)
+        .field("coalesced", stats.coalesced)
+        .field("dropped", stats.dropped + taskStats().messagesDropped)
+        .field("published", stats.published)
+        .field("restored", stats.restored)
+        .field("lastLagMs", stats.lastLagMillis)
+        .field("maxLagMs", stats.maxLagMillis)
+        .endObject();
+    request->send(200, "application/json", json.c_str());
+  });
+  
+  // 每个客户端的发送队列深度、已发送字节和丢弃/覆盖计数，见 ws_fanout.h
+  webServer.on("/api/ws", HTTP_GET, [](AsyncWebServerRequest *request) {
+    WsClientStats clients[WS_MAX_CLIENTS];
+    uint8_t count = wsClientStats(clients, WS_MAX_CLIENTS);
+    const WsFanoutStats& stats = wsFanoutStats();
+    TextWriter json(wsStatsText, sizeof(wsStatsText));
+    json.beginObject()
+        .field("broadcasts", stats.broadcasts)
+        .field("allocFailures", stats.allocFailures)
+        .field("evictions", stats.evictions)
+        .field("rejected", stats.rejected)
+        .key("clients").put('[');
+    for (uint8_t i = 0; i < count; i++) {
+      if (i) json.put(',');
+      json.beginObject()
+          .field("id", clients[i].id)
+          .field("depth", clients[i].depth)
+          .field("maxDepth", clients[i].maxDepth)
+          .flag("log", clients[i].logView)
+          .field("frames", clients[i].frames)
+          .field("bytes", clients[i].bytes)
+          .field("replaced", clients[i].replaced)
+          .field("dropped", clients[i].dropped)
+          .endObject();
+    }
+    json.put(']').endObject();
+    request->send(200, "application/json", json.c_str());
+  });
+  
+  webServer.on("/api/metrics", HTTP_GET, serveMetrics);
+
+  // 录制的按钮输入（格式见 input_trace.h），在主机上用 program --replay 回放；录制中或尚未写完时返回 409
+  webServer.on("/api/trace", HTTP_GET, [](AsyncWebServerRequest *request) {
+    if (inputTraceStats().recording || inputTraceFlushPending()) {
+      request->send(409, "text/plain", "recording");
+      return;
+    }
+    if (!LittleFS.begin(true) || !LittleFS.exists(INPUT_TRACE_PATH)) {
+      request->send(404, "text/plain", "no trace");
+      return;
+    }
+    request->send(LittleFS, INPUT_TRACE_PATH, "application/octet-stream", true);
+  });
+  
+  // 动画片段包（格式见 clips.h）：GET 返回目录，POST 以原始请求体上传整个包。请求结束时写入任务可能还在写
+  // 最后几块，结果（state 变为 ready，或 error 给出失败原因）在 GET /api/clips 里看，这里不等待
+  webServer.on("/api/clips", HTTP_GET, [](AsyncWebServerRequest *request) {
+    TextWriter json(clipsText, sizeof(clipsText));
+    encodeClipsJSON(json);
+    request->send(200, "application/json", json.c_str());
+  });
+
+  webServer.on("/api/clips", HTTP_POST,
+    [](AsyncWebServerRequest *request) {
+      if (request != clipRequest) {
+        if (clipRequest || clipStoreState() == CLIP_STORE_WRITING || otaBusy()) {
+          request->send(409, "text/plain", "another upload in progress");
+        } else {
+          request->send(400, "text/plain", "rejected");
+        }
+        return;
+      }
+      clipRequest = nullptr;
+      clipUploadAbort();  // 请求体不完整时放弃；已收完的上传不受影响
+      const char* error = clipUploadError();
+      if (error) {
+        request->send(400, "text/plain", error);
+      } else {
+        request->send(202, "text/plain", "accepted");
+      }
+    },
+    nullptr,
+    handleClipUpload
+  );
+  
+  // 固件更新状态，进行中的进度也经 WebSocket 推送（见 ota.h）
+  webServer.on("/api/ota", HTTP_GET, [](AsyncWebServerRequest *request) {
+    FixedTextWriter<OTA_STATUS_JSON_CAPACITY> json;
+    encodeOTAStatusJSON(json);
+    request->send(200, "application/json", json.c_str());
+  });
+
+  // 上传 program --ota-sign 生成的签名固件；请求结束时写入任务可能还在写最后几块，
+  // 结果（切换启动分区后自动重启，或失败原因）经 WebSocket 进度帧和 /api/ota 给出，这里不等待
+  webServer.on("/update", HTTP_POST, 
+    [](AsyncWebServerRequest *request) {
+      if (request != otaRequest) {
+        if (otaBusy() || clipStoreState() == CLIP_STORE_WRITING) {
+          request->send(409, "text/plain", "另一个更新正在进行");
+        } else {
+          request->send(400, "text/plain", "没有收到固件文件");
+        }
+        return;
+      }
+      otaRequest = nullptr;
+      const char* error = otaUploadError();
+      if (error) {
+        request->send(400, "text/plain", error);
+      } else {
+        request->send(202, "text/plain", "上传完成，校验通过后设备自动重启");
+      }
+    }, 
+    handleOTAUpload
+  );
+  
+  webServer.begin();
+  LOG_INFO(LOG_WEB_READY);
+}
+
+// ==================== WebSocket事件 ====================
+void onWebSocketEvent(AsyncWebSocket *server, AsyncWebSocketClient *client, 
+                      AwsEventType type, void *arg, uint8_t *data, size_t len) {
+  switch (type) {
+    case WS_EVT_CONNECT:
+      LOG_INFO(LOG_WS_CONNECT, client->id());
+      wsClientConnected(client->id());
+      requestStateKeyframe();  // 新客户端立即收到完整状态
+      break;
+    case WS_EVT_DISCONNECT:
+      LOG_INFO(LOG_WS_DISCONNECT, client->id());
+      wsClientDisconnected(client->id());
+      break;
+    case WS_EVT_DATA: {
+      // 客户端发现帧序号不连续时发送 "sync" 请求关键帧；打开/关闭日志面板时发送 "log:1" / "log:0"
+      AwsFrameInfo *info = (AwsFrameInfo*)arg;
+      if (!info->final || info->index != 0 || info->opcode != WS_TEXT) {
+        break;
+      }
+      if (len == 4 && memcmp(data, "sync", 4) == 0) {
+        requestStateKeyframe();
+      } else if (len == 5 && memcmp(data, "log:", 4) == 0) {
+        wsSetLogView(client->id(), data[4] == '1');
+      }
+      break;
+    }
+    case WS_EVT_PONG:
+    case WS_EVT_ERROR:
+      break;
+  }
+}
+
+// ==================== OTA升级处理 ====================
+// 上传回调只把数据交给 ota.cpp 的环形缓冲区，flash 擦写在 OTA 写入任务中进行。
+// 同时只接受一个上传：其他请求的数据直接丢弃，请求结束时回 409
+void handleOTAUpload(AsyncWebServerRequest *request, String filename, 
+                     size_t index, uint8_t *data, size_t len, bool final) {
+  if (index == 0) {
+    if (otaRequest || !otaBegin(filename.c_str())) {
+      return;
+    }
+    otaRequest = request;
+    request->onDisconnect([request]() {
+      if (otaRequest == request) {
+        otaRequest = nullptr;
+        otaAbort();
+      }
+    });
+  }
+  if (request != otaRequest) {
+    return;
+  }
+  if (otaReceive(data, len) && final) {
+    otaReceiveDone();
+  }
+}
+
+// ==================== 动画片段上传 ====================
+// 请求体按顺序分块到达（AsyncTCP 任务），经扇区环形缓冲区交给 flash 写入任务；连接中途断开时分区按空处理。
+// 与固件更新一样同时只接受一个上传：其他请求的数据直接丢弃，请求结束时回 409
+void handleClipUpload(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
+  if (index == 0) {
+    if (clipRequest || !clipUploadBegin(total)) {
+      return;
+    }
+    clipRequest = request;
+    request->onDisconnect([request]() {
+      if (clipRequest == request) {
+        clipRequest = nullptr;
+        clipUploadAbort();
+      }
+    });
+  }
+  if (request != clipRequest) {
+    return;
+  }
+  if (clipUploadWrite(data, len) && index + len == total) {
+    clipUploadEnd();
+  }
+}
+
+// ==================== Prometheus 指标 ====================
+void serveMetrics(AsyncWebServerRequest *request) {
+  if (metricsRequest) {
+    request->send(503, "text/plain", "busy");
+    return;
+  }
+  TextWriter text(metricsText, sizeof(metricsText));
+  encodeMetricsText(text);
+  encodePowerText(text);
+  if (text.overflowed()) {
+    request->send(500, "text/plain", "metrics text overflow");  // 截断的文本 Prometheus 会整体拒绝
+    return;
+  }
+  metricsLength = text.length();
+  metricsRequest = request;
+  request->onDisconnect([request]() {
+    if (metricsRequest == request) {
+      metricsRequest = nullptr;
+    }
+  });
+
+  AsyncWebServerResponse *response = request->beginResponse(
+    "text/plain; version=0.0.4", metricsLength,
+    [request](uint8_t *buffer, size_t maxLen, size_t index) -> size_t {
+      size_t n = metricsLength - index < maxLen ? metricsLength - index : maxLen;
+      memcpy(buffer, metricsText + index, n);
+      if (index + n >= metricsLength) {
+        metricsRequest = nullptr;  // 全部文本已在响应自己的缓冲区里，静态缓冲区可以给下一个请求
+      }
+      return n;
+    });
+  request->send(response);
+}
+
+// ==================== Web UI ====================
+// 页面是构建时生成的 gzip 字节数组（web/index.html → include/web_ui.h），直接从 flash 发送。
+// Cache-Control: no-cache 让浏览器每次带 If-None-Match 验证，页面未变化时只回 304。
+void serveWebUI(AsyncWebServerRequest *request) {
+  AsyncWebHeader *ifNoneMatch = request->getHeader("If-None-Match");
+  if (ifNoneMatch && ifNoneMatch->value() == WEB_UI_ETAG) {
+    AsyncWebServerResponse *response = request->beginResponse(304);
+    response->addHeader("ETag", WEB_UI_ETAG);
+    request->send(response);
+    return;
+  }
+
+  AsyncWebServerResponse *response =
+      request->beginResponse_P(200, "text/html", WEB_UI_GZ, WEB_UI_GZ_LEN);
+  response->addHeader("Content-Encoding", "gzip");
+  response->addHeader("ETag", WEB_UI_ETAG);
+  response->addHeader("Cache-Control", "no-cache");
+  request->send(response);
+}
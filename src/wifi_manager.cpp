@@ -0,0 +1,171 @@
+#include <string.h>
+#include "wifi_manager.h"
+#include "hal.h"
+#include "config.h"
+#include "backoff.h"
+#include "log.h"
+
+#define WIFI_CACHE_KEY "wifi"
+#define WIFI_CACHE_MAGIC 0x57494631u  // "WIF1"，结构变化时修改
+
+struct WiFiCacheRecord {
+  uint32_t magic;
+  uint32_t ssidHash;  // SSID 变化后旧缓存作废
+  HalWiFiLink link;
+};
+
+static WiFiState state = WIFI_STATE_IDLE;
+static WiFiCacheRecord cache;
+static bool cacheValid = false;
+static unsigned long stateSince = 0;    // 进入当前状态的时间
+static unsigned long attemptStart = 0;  // 本轮连接（含缓存直连失败后的全扫描）的开始时间
+static unsigned long backoffUntil = 0;
+static uint8_t consecutiveFailures = 0;
+static WiFiStats stats;
+
+static uint32_t hashSSID(const char* ssid) {
+  uint32_t hash = 2166136261u;
+  for (; *ssid; ssid++) {
+    hash = (hash ^ (uint8_t)*ssid) * 16777619u;
+  }
+  return hash;
+}
+
+static void enterState(WiFiState next) {
+  state = next;
+  stateSince = halMillis();
+}
+
+static void beginConnect() {
+  if (cacheValid) {
+    enterState(WIFI_STATE_CONNECTING_CACHED);
+    halWiFiBegin(WIFI_SSID, WIFI_PASSWORD, &cache.link);
+  } else {
+    enterState(WIFI_STATE_CONNECTING);
+    halWiFiBegin(WIFI_SSID, WIFI_PASSWORD, nullptr);
+  }
+}
+
+static void startAttempt() {
+  attemptStart = halMillis();
+  beginConnect();
+}
+
+static void enterBackoff() {
+  uint32_t wait = jitteredBackoff(WIFI_BACKOFF_MIN, WIFI_BACKOFF_MAX, consecutiveFailures);
+  if (consecutiveFailures < 255) {
+    consecutiveFailures++;
+  }
+
+  halWiFiDisconnect();
+  stats.lastBackoffMillis = wait;
+  backoffUntil = halMillis() + wait;
+  enterState(WIFI_STATE_BACKOFF);
+}
+
+static void onConnected(bool fast) {
+  enterState(WIFI_STATE_CONNECTED);
+  consecutiveFailures = 0;
+  stats.connects++;
+  if (fast) {
+    stats.fastConnects++;
+  }
+  stats.lastConnectMillis = halMillis() - attemptStart;
+
+  String ip = halWiFiLocalIP();
+  LOG_INFO(LOG_WIFI_CONNECTED, fast ? "缓存直连" : "全扫描", stats.lastConnectMillis, logText(ip.c_str()));
+
+  // 链路参数有变化才写 NVS，减少 flash 磨损
+  WiFiCacheRecord next;
+  memset(&next, 0, sizeof(next));
+  next.magic = WIFI_CACHE_MAGIC;
+  next.ssidHash = hashSSID(WIFI_SSID);
+  if (halWiFiReadLink(next.link) && (!cacheValid || memcmp(&next, &cache, sizeof(next)) != 0)) {
+    cache = next;
+    cacheValid = true;
+    halNVSStore(WIFI_CACHE_KEY, &cache, sizeof(cache));
+  }
+}
+
+void initializeWiFiManager(uint8_t notifyTask) {
+  memset(&stats, 0, sizeof(stats));
+  consecutiveFailures = 0;
+  cacheValid = halNVSLoad(WIFI_CACHE_KEY, &cache, sizeof(cache)) &&
+               cache.magic == WIFI_CACHE_MAGIC && cache.ssidHash == hashSSID(WIFI_SSID);
+
+  halWiFiInit(notifyTask);
+  startAttempt();
+}
+
+uint32_t updateWiFiManager() {
+  HalWiFiStatus status = halWiFiStatus();
+  unsigned long now = halMillis();
+
+  switch (state) {
+    case WIFI_STATE_CONNECTING_CACHED:
+      if (status == HAL_WIFI_CONNECTED) {
+        onConnected(true);
+      } else if (status == HAL_WIFI_FAILED || now - stateSince >= WIFI_FAST_CONNECT_TIMEOUT) {
+        LOG_INFO(LOG_WIFI_FAST_FAILED);
+        cacheValid = false;
+        halWiFiDisconnect();
+        beginConnect();
+      }
+      break;
+
+    case WIFI_STATE_CONNECTING:
+      if (status == HAL_WIFI_CONNECTED) {
+        onConnected(false);
+      } else if (status == HAL_WIFI_FAILED || now - stateSince >= WIFI_CONNECT_TIMEOUT) {
+        stats.failures++;
+        enterBackoff();
+        LOG_WARN(LOG_WIFI_FAILED, stats.lastBackoffMillis);
+      }
+      break;
+
+    case WIFI_STATE_CONNECTED:
+      if (status != HAL_WIFI_CONNECTED) {
+        stats.drops++;
+        consecutiveFailures = 0;
+        enterBackoff();
+        LOG_WARN(LOG_WIFI_LOST, stats.lastBackoffMillis);
+      }
+      break;
+
+    case WIFI_STATE_BACKOFF:
+      if ((long)(now - backoffUntil) >= 0) {
+        startAttempt();
+      }
+      break;
+
+    case WIFI_STATE_IDLE:
+    default:
+      break;
+  }
+
+  switch (state) {
+    case WIFI_STATE_CONNECTING_CACHED:
+    case WIFI_STATE_CONNECTING:
+      return WIFI_CONNECTING_POLL_INTERVAL * 1000UL;  // 事件丢失时的兜底
+    case WIFI_STATE_BACKOFF: {
+      long remaining = (long)(backoffUntil - halMillis());
+      return remaining > 0 ? (uint32_t)remaining * 1000UL : 0;
+    }
+    case WIFI_STATE_CONNECTED:
+    case WIFI_STATE_IDLE:
+    default:
+      return WIFI_CHECK_INTERVAL * 1000UL;
+  }
+}
+
+bool wifiManagerConnected() {
+  return state == WIFI_STATE_CONNECTED;
+}
+
+WiFiState wifiManagerState() {
+  return state;
+}
+
+const WiFiStats& wifiStats() {
+  return stats;
+}
@@ -0,0 +1,287 @@
+#include <string.h>
+#include <atomic>
+#include "ws_fanout.h"
+#include "mpsc_queue.h"
+#include "tasks.h"
+#include "log.h"
+
+static_assert(WS_CLIENT_QUEUE_CAP >= 3, "队列满时要留出状态帧、进度帧和至少一帧日志");
+static_assert(WS_CLIENT_QUEUE_CAP <= 255, "队列深度用 uint8_t 计数");
+
+#define WS_EVENT_QUEUE_SIZE 32  // 连接事件队列，必须是2的幂
+
+enum WsEventType : uint8_t {
+  WS_EVENT_CONNECT,
+  WS_EVENT_DISCONNECT,
+  WS_EVENT_LOG_ON,
+  WS_EVENT_LOG_OFF
+};
+
+struct WsEvent {
+  uint32_t id;
+  uint8_t type;
+};
+
+struct WsQueued {
+  HalWsBuffer* buffer;
+  uint16_t length;
+  uint8_t frameClass;
+  bool binary;
+};
+
+struct WsClient {
+  bool active;
+  uint8_t count;
+  uint32_t behindSince;  // 队列由空变为非空的时刻（毫秒）
+  WsQueued queue[WS_CLIENT_QUEUE_CAP];
+  WsClientStats stats;
+};
+
+static WsClient clients[WS_MAX_CLIENTS];
+static MpscQueue<WsEvent, WS_EVENT_QUEUE_SIZE> events;
+static WsFanoutStats stats;
+static uint8_t logViewers = 0;
+static bool pumpRequested = false;
+static std::atomic<uint32_t> rejectedEvents(0);  // 事件队列满，在生产者一侧计数
+
+void initializeWebSocketFanout() {
+  for (WsClient& client : clients) {
+    while (client.count > 0) {
+      halWebSocketRelease(client.queue[--client.count].buffer);
+    }
+    client.active = false;
+  }
+  WsEvent event;
+  while (events.pop(event)) {
+  }
+  memset(&stats, 0, sizeof(stats));
+  logViewers = 0;
+  pumpRequested = false;
+  rejectedEvents.store(0, std::memory_order_relaxed);
+}
+
+// ==================== 连接事件（任意任务） ====================
+static bool postEvent(uint32_t id, uint8_t type) {
+  bool ok = events.push([&](WsEvent& event) {
+    event.id = id;
+    event.type = type;
+  });
+  halNotifyTask(TASK_NETWORK);
+  return ok;
+}
+
+void wsClientConnected(uint32_t id) {
+  if (!postEvent(id, WS_EVENT_CONNECT)) {
+    rejectedEvents.fetch_add(1, std::memory_order_relaxed);
+    halWebSocketClose(id);
+  }
+}
+
+// 事件队列满时丢失的断开事件不需要补救：下一帧排进队列后交不出去，WS_CLIENT_EVICT_MS 后被回收
+void wsClientDisconnected(uint32_t id) {
+  postEvent(id, WS_EVENT_DISCONNECT);
+}
+
+void wsSetLogView(uint32_t id, bool enabled) {
+  postEvent(id, enabled ? WS_EVENT_LOG_ON : WS_EVENT_LOG_OFF);
+}
+
+// ==================== 客户端队列（网络任务） ====================
+static WsClient* findClient(uint32_t id) {
+  for (WsClient& client : clients) {
+    if (client.active && client.stats.id == id) {
+      return &client;
+    }
+  }
+  return nullptr;
+}
+
+static void removeAt(WsClient& client, uint8_t index) {
+  halWebSocketRelease(client.queue[index].buffer);
+  memmove(&client.queue[index], &client.queue[index + 1],
+          (client.count - index - 1) * sizeof(WsQueued));
+  client.count--;
+}
+
+static void closeClient(WsClient& client) {
+  while (client.count > 0) {
+    removeAt(client, client.count - 1);
+  }
+  if (client.stats.logView) {
+    logViewers--;
+  }
+  client.active = false;
+  stats.clients--;
+}
+
+static void openClient(uint32_t id) {
+  if (findClient(id)) {
+    return;
+  }
+  for (WsClient& client : clients) {
+    if (!client.active) {
+      memset(&client, 0, sizeof(client));
+      client.active = true;
+      client.stats.id = id;
+      stats.clients++;
+      return;
+    }
+  }
+  stats.rejected++;
+  LOG_WARN(LOG_WS_REJECTED, id, (uint32_t)WS_MAX_CLIENTS);
+  halWebSocketClose(id);
+}
+
+static void processEvents() {
+  WsEvent event;
+  while (events.pop(event)) {
+    WsClient* client = findClient(event.id);
+    switch (event.type) {
+      case WS_EVENT_CONNECT:
+        openClient(event.id);
+        break;
+      case WS_EVENT_DISCONNECT:
+        if (client) closeClient(*client);
+        break;
+      case WS_EVENT_LOG_ON:
+      case WS_EVENT_LOG_OFF: {
+        bool enabled = event.type == WS_EVENT_LOG_ON;
+        if (client && client->stats.logView != enabled) {
+          client->stats.logView = enabled;
+          logViewers += enabled ? 1 : -1;
+        }
+        break;
+      }
+    }
+  }
+  stats.rejected += rejectedEvents.exchange(0, std::memory_order_relaxed);
+}
+
+static void enqueue(WsClient& client, HalWsBuffer* buffer, uint16_t length, bool binary,
+                    WsFrameClass frameClass, uint32_t now) {
+  WsQueued entry = {buffer, length, (uint8_t)frameClass, binary};
+  if (frameClass != WS_CLASS_LOG) {
+    for (uint8_t i = 0; i < client.count; i++) {
+      if (client.queue[i].frameClass == frameClass) {
+        halWebSocketRelease(client.queue[i].buffer);
+        halWebSocketRetain(buffer);
+        client.queue[i] = entry;
+        client.stats.replaced++;
+        return;
+      }
+    }
+  }
+  if (client.count == WS_CLIENT_QUEUE_CAP) {
+    // 状态帧、进度帧各最多一帧，满时总有日志帧可丢
+    for (uint8_t i = 0; i < client.count; i++) {
+      if (client.queue[i].frameClass == WS_CLASS_LOG) {
+        removeAt(client, i);
+        client.stats.dropped++;
+        break;
+      }
+    }
+  }
+  if (client.count == 0) {
+    client.behindSince = now;
+  }
+  halWebSocketRetain(buffer);
+  client.queue[client.count++] = entry;
+  if (client.count > client.stats.maxDepth) {
+    client.stats.maxDepth = client.count;
+  }
+}
+
+static void drainClient(WsClient& client) {
+  while (client.count > 0 && halWebSocketCanSend(client.stats.id)) {
+    const WsQueued& head = client.queue[0];
+    if (!halWebSocketSend(client.stats.id, head.buffer, head.binary)) {
+      break;
+    }
+    client.stats.frames++;
+    client.stats.bytes += head.length;
+    removeAt(client, 0);
+  }
+}
+
+bool wsBroadcast(const uint8_t* data, size_t length, bool binary, WsFrameClass frameClass) {
+  processEvents();
+  if (stats.clients == 0 || (frameClass == WS_CLASS_LOG && logViewers == 0)) {
+    return false;
+  }
+  HalWsBuffer* buffer = halWebSocketAllocate(data, length);
+  if (!buffer) {
+    stats.allocFailures++;
+    return false;
+  }
+  stats.broadcasts++;
+  stats.broadcastBytes += length;
+
+  uint32_t now = (uint32_t)halMillis();
+  bool backlog = false;
+  for (WsClient& client : clients) {
+    if (!client.active || (frameClass == WS_CLASS_LOG && !client.stats.logView)) {
+      continue;
+    }
+    enqueue(client, buffer, (uint16_t)length, binary, frameClass, now);
+    drainClient(client);
+    backlog |= client.count > 0;
+  }
+  halWebSocketRelease(buffer);  // 只剩各队列和传输层的引用
+
+  if (backlog && !pumpRequested) {
+    pumpRequested = true;
+    halNotifyTask(TASK_NETWORK);
+  }
+  return true;
+}
+
+bool pumpWebSocket() {
+  processEvents();
+  pumpRequested = false;
+  uint32_t now = (uint32_t)halMillis();
+  bool backlog = false;
+  for (WsClient& client : clients) {
+    if (!client.active) {
+      continue;
+    }
+    drainClient(client);
+    if (client.count == 0) {
+      continue;
+    }
+    uint32_t behind = now - client.behindSince;
+    if (behind >= WS_CLIENT_EVICT_MS) {
+      LOG_WARN(LOG_WS_EVICTED, client.stats.id, behind, (uint32_t)client.count);
+      halWebSocketClose(client.stats.id);
+      closeClient(client);
+      stats.evictions++;
+      continue;
+    }
+    backlog = true;
+  }
+  return backlog;
+}
+
+bool wsFanoutPending() {
+  return pumpRequested || events.size() > 0;
+}
+
+uint8_t wsLogViewers() {
+  processEvents();  // 同一轮里刚打开日志面板的客户端也要收到这批日志
+  return logViewers;
+}
+
+const WsFanoutStats& wsFanoutStats() {
+  return stats;
+}
+
+uint8_t wsClientStats(WsClientStats* out, uint8_t capacity) {
+  uint8_t n = 0;
+  for (const WsClient& client : clients) {
+    if (client.active && n < capacity) {
+      out[n] = client.stats;
+      out[n].depth = client.count;
+      n++;
+    }
+  }
+  return n;
+}
@@ -0,0 +1,55 @@
+#include "ws_protocol.h"
+#include "config.h"
+
+// ==================== 编译期 JSON 键 ====================
+// 每个按钮的 "p13": 在编译期拼好（除第一个外带前导逗号），编码时只拷贝字节，不格式化引脚号
+struct ButtonKeys {
+  char text[BTN_COUNT][8];  // ,"p13": 最长 7 字节
+  uint8_t length[BTN_COUNT];
+};
+
+static constexpr ButtonKeys makeButtonKeys() {
+  ButtonKeys keys{};
+  for (uint8_t i = 0; i < BTN_COUNT; i++) {
+    uint8_t n = 0;
+    if (i) keys.text[i][n++] = ',';
+    keys.text[i][n++] = '"';
+    keys.text[i][n++] = 'p';
+    if (BUTTON_PINS[i] >= 10) keys.text[i][n++] = (char)('0' + BUTTON_PINS[i] / 10);
+    keys.text[i][n++] = (char)('0' + BUTTON_PINS[i] % 10);
+    keys.text[i][n++] = '"';
+    keys.text[i][n++] = ':';
+    keys.length[i] = n;
+  }
+  return keys;
+}
+
+static constexpr ButtonKeys BUTTON_KEYS = makeButtonKeys();
+
+static void putU32(uint8_t* out, uint32_t value) {
+  out[0] = (uint8_t)value;
+  out[1] = (uint8_t)(value >> 8);
+  out[2] = (uint8_t)(value >> 16);
+  out[3] = (uint8_t)(value >> 24);
+}
+
+size_t encodeStateFrame(uint8_t* out, const BallSnapshot& state, uint32_t sequence, uint8_t type) {
+  out[0] = type;
+  out[1] = (uint8_t)(state.pressed & ALL_BUTTONS_MASK);
+  out[2] = state.ledMode;
+  out[3] = state.greenBreathBrightness;
+  putU32(out + 4, sequence);
+  putU32(out + 8, state.updatedMillis);
+  if (BTN_COUNT > 8) {
+    out[12] = (uint8_t)((state.pressed & ALL_BUTTONS_MASK) >> 8);
+  }
+  return WS_STATE_FRAME_SIZE;
+}
+
+void encodeStateJSON(TextWriter& out, const BallSnapshot& state) {
+  out.put('{');
+  for (uint8_t i = 0; i < BTN_COUNT; i++) {
+    out.raw(BUTTON_KEYS.text[i], BUTTON_KEYS.length[i]).boolean(state.pressed & BUTTON_MASK(i));
+  }
+  out.put('}');
+}
@@ -0,0 +1,100 @@
+// ==================== 按钮规则 ====================
+// 规则表（handleButtonLogic()）与旧版 if 链在状态转移和长随机序列上输出相同的灯效和 MQTT 事件，
+// data/rules.json 与内置默认规则编译出同样的表
+#include <unity.h>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include "ball.h"
+#include "button_rules.h"
+#include "sim_scenarios.h"
+
+static LegacyLogic legacy;
+
+static void resetLogic() {
+  legacy = LegacyLogic{false, false, 0, LED_BREATHE_RED, 0};
+  systemStatus.activeRule = RULE_NONE;
+  systemStatus.evaluatedPressed = 0;
+  ledController.mode = LED_BREATHE_RED;
+  ledController.greenBreathBrightness = 0;
+}
+
+void setUp(void) {
+  simReset();
+  initializeSystem();
+  resetLogic();
+}
+
+void tearDown(void) {
+}
+
+// 从初始状态依次进入 from、再到 to：按钮不超过 8 个时覆盖全部掩码（默认 128×128 个转移），
+// 更多按钮时取 256 个随机掩码（含全部松开和全部按下）
+static void test_rules_match_legacy_on_every_transition(void) {
+  std::vector<uint32_t> states;
+  std::mt19937 rng(7);
+  for (uint32_t i = 0; i < 256 && i <= ALL_BUTTONS_MASK; i++) {
+    states.push_back(ALL_BUTTONS_MASK < 256 ? i : i == 255 ? ALL_BUTTONS_MASK : i ? rng() & ALL_BUTTONS_MASK : 0);
+  }
+  for (uint32_t from : states) {
+    for (uint32_t to : states) {
+      resetLogic();
+      const uint32_t path[] = {0, from, to};
+      for (uint32_t pressed : path) {
+        uint32_t expected = legacyEvaluate(legacy, pressed);
+        if (!sameOutput(legacy, expected, ruleEvaluate(pressed))) {
+          char message[64];
+          snprintf(message, sizeof(message), "0 → %04x → %04x，在 %04x 处不一致", from, to, pressed);
+          TEST_FAIL_MESSAGE(message);
+        }
+      }
+    }
+  }
+}
+
+// 长序列中的历史依赖
+static void test_rules_match_legacy_on_random_walk(void) {
+  std::mt19937 rng(7);
+  uint32_t pressed = 0;
+  for (uint32_t step = 0; step < 200000; step++) {
+    pressed ^= BUTTON_MASK(rng() % BTN_COUNT);
+    if (rng() % 8 == 0) pressed = rng() & ALL_BUTTONS_MASK;
+    uint32_t expected = legacyEvaluate(legacy, pressed);
+    TEST_ASSERT_TRUE_MESSAGE(sameOutput(legacy, expected, ruleEvaluate(pressed)), "随机游走不一致");
+  }
+}
+
+static void test_rules_json_compiles_to_builtin_table(void) {
+  if (!defaultButtonPins()) {
+    TEST_IGNORE_MESSAGE("data/rules.json 按默认引脚编写，本构建的引脚不同");
+  }
+  static char text[RULES_JSON_CAPACITY];
+  FILE* file = fopen("data/rules.json", "rb");
+  if (!file) {
+    TEST_IGNORE_MESSAGE("未找到 data/rules.json（请在仓库根目录运行）");
+  }
+  size_t length = fread(text, 1, sizeof(text), file);
+  fclose(file);
+
+  RuleSet fromFile;
+  RuleSet builtIn;
+  char error[64] = "";
+  compileDefaultRules(builtIn);
+  TEST_ASSERT_TRUE_MESSAGE(parseRulesJSON(fromFile, text, length, error, sizeof(error)), error);
+  TEST_ASSERT_EQUAL_MEMORY(builtIn.table, fromFile.table, sizeof(builtIn.table));
+  TEST_ASSERT_EQUAL_MEMORY(builtIn.edges, fromFile.edges, sizeof(builtIn.edges));
+  TEST_ASSERT_EQUAL_UINT8(builtIn.ruleCount, fromFile.ruleCount);
+  for (uint8_t r = 0; r < builtIn.ruleCount; r++) {
+    TEST_ASSERT_EQUAL_UINT8(builtIn.rules[r].action, fromFile.rules[r].action);
+  }
+}
+
+int main(int argc, char** argv) {
+  (void)argc;
+  (void)argv;
+  UNITY_BEGIN();
+  RUN_TEST(test_rules_match_legacy_on_every_transition);
+  RUN_TEST(test_rules_match_legacy_on_random_walk);
+  RUN_TEST(test_rules_json_compiles_to_builtin_table);
+  return UNITY_END();
+}
@@ -0,0 +1,122 @@
+// ==================== 按钮引脚列表 ====================
+// 本构建的按钮引脚列表（-DBUTTON_PIN_LIST）：编译期展开的采样、规则判断、状态编码和录制格式
+// 与逐位/逐条的写法一致
+#include <unity.h>
+#include <string.h>
+#include <vector>
+#include "ball.h"
+#include "button_events.h"
+#include "button_rules.h"
+#include "ws_protocol.h"
+#include "input_trace.h"
+#include "sim_scenarios.h"
+
+void setUp(void) {
+  simReset();
+  initializeSystem();
+}
+
+void tearDown(void) {
+}
+
+static void test_sampling_matches_bit_loop(void) {
+  std::mt19937 rng(22);
+  for (uint32_t n = 0; n < 1000; n++) {
+    for (uint8_t i = 0; i < BTN_COUNT; i++) {
+      simSetPin(BUTTON_PINS[i], (rng() & 1) ? HIGH : LOW);
+    }
+    TEST_ASSERT_EQUAL_UINT32(loopPressedMask(halReadGPIOInputs()), sampleButtonMask());
+  }
+}
+
+static void test_rule_table_matches_sequential_rules(void) {
+  std::mt19937 rng(22);
+  const RuleSet& rules = activeRules();
+  for (uint32_t n = 0; n < 1000; n++) {
+    uint32_t pressed = rng() & ALL_BUTTONS_MASK;
+    RuleOutcome a = ruleOutcome(rules, pressed);
+    RuleOutcome b = evaluateRules(rules.rules, rules.ruleCount, pressed);
+    TEST_ASSERT_EQUAL_MEMORY(&b, &a, sizeof(a));
+  }
+}
+
+static void test_state_json_matches_formatted_pins(void) {
+  std::mt19937 rng(22);
+  for (uint32_t n = 0; n < 1000; n++) {
+    BallSnapshot state = {(uint32_t)(rng() & ALL_BUTTONS_MASK), (uint32_t)rng(), LED_BREATHE_GREEN, 0, 0, 0};
+    FixedTextWriter<STATE_JSON_CAPACITY> json;
+    FixedTextWriter<STATE_JSON_CAPACITY> loopJSON;
+    encodeStateJSON(json, state);
+    loopStateJSON(loopJSON, state);
+    TEST_ASSERT_FALSE(json.overflowed());
+    TEST_ASSERT_EQUAL_STRING(loopJSON.c_str(), json.c_str());
+  }
+}
+
+static void test_state_frame_carries_pressed_mask(void) {
+  std::mt19937 rng(22);
+  for (uint32_t n = 0; n < 1000; n++) {
+    BallSnapshot state = {(uint32_t)(rng() & ALL_BUTTONS_MASK), (uint32_t)rng(), LED_BREATHE_GREEN, 0, 0, 0};
+    uint8_t frame[WS_STATE_FRAME_SIZE];
+    TEST_ASSERT_EQUAL_size_t(WS_STATE_FRAME_SIZE, encodeStateFrame(frame, state, n, WS_FRAME_DELTA));
+    uint32_t mask = frame[1] | (WS_STATE_FRAME_SIZE > 12 ? frame[WS_STATE_FRAME_SIZE - 1] << 8 : 0);
+    TEST_ASSERT_EQUAL_UINT32(state.pressed, mask);
+  }
+}
+
+// 随机边沿和重新同步写出后逐条读回
+static void test_trace_records_round_trip(void) {
+  std::mt19937 rng(22);
+  std::vector<uint8_t> trace(INPUT_TRACE_HEADER_SIZE + 1000 * INPUT_TRACE_MAX_RECORD);
+  uint32_t initial = rng() & ALL_BUTTONS_MASK;
+  size_t at = inputTraceEncodeHeader(trace.data(), initial);
+  std::vector<InputTraceRecord> written;
+  uint64_t offset = 0;
+  for (uint32_t n = 0; n < 1000; n++) {
+    InputTraceRecord r = {};
+    uint32_t delta = rng() % 5000;
+    offset += delta;
+    r.offsetMicros = offset;
+    if (n % 50 == 49) {
+      r.type = TRACE_RECORD_RESYNC;
+      r.pressedMask = rng() & ALL_BUTTONS_MASK;
+      at += inputTraceEncodeRecord(trace.data() + at, delta, INPUT_TRACE_CODE_RESYNC);
+      at += inputTraceEncodeVarint(trace.data() + at, r.pressedMask);
+    } else {
+      r.type = TRACE_RECORD_EDGE;
+      r.index = rng() % BTN_COUNT;
+      r.level = rng() & 1;
+      at += inputTraceEncodeRecord(trace.data() + at, delta, r.index * 2 + r.level);
+    }
+    written.push_back(r);
+  }
+
+  InputTraceReader reader(trace.data(), at);
+  TEST_ASSERT_TRUE(reader.matchesPins());
+  TEST_ASSERT_EQUAL_UINT32(initial, reader.initialPressedMask());
+  InputTraceRecord r;
+  size_t read = 0;
+  while (reader.next(r)) {
+    TEST_ASSERT_TRUE(read < written.size());
+    const InputTraceRecord& w = written[read++];
+    TEST_ASSERT_EQUAL_UINT8(w.type, r.type);
+    TEST_ASSERT_TRUE(w.offsetMicros == r.offsetMicros);
+    TEST_ASSERT_EQUAL_UINT8(w.index, r.index);
+    TEST_ASSERT_EQUAL_UINT8(w.level, r.level);
+    TEST_ASSERT_EQUAL_UINT32(w.pressedMask, r.pressedMask);
+  }
+  TEST_ASSERT_TRUE(reader.ok());
+  TEST_ASSERT_EQUAL_size_t(written.size(), read);
+}
+
+int main(int argc, char** argv) {
+  (void)argc;
+  (void)argv;
+  UNITY_BEGIN();
+  RUN_TEST(test_sampling_matches_bit_loop);
+  RUN_TEST(test_rule_table_matches_sequential_rules);
+  RUN_TEST(test_state_json_matches_formatted_pins);
+  RUN_TEST(test_state_frame_carries_pressed_mask);
+  RUN_TEST(test_trace_records_round_trip);
+  return UNITY_END();
+}
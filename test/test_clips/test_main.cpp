@@ -0,0 +1,343 @@
+// ==================== 动画片段 ====================
+// 编码无损、损坏的数据被拒绝且不越界；经文件映射的分区分块上传（回调里不擦写 flash）、中断、重启、
+// 同时只有一个上传；解码和播放不分配内存；
+// 规则和 MQTT 命令选择片段后逐帧比对
+#include <unity.h>
+#include <string.h>
+#include <unistd.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include "ball.h"
+#include "led_compositor.h"
+#include "effects.h"
+#include "button_rules.h"
+#include "mqtt_commands.h"
+#include "clips.h"
+#include "ota.h"
+#include "power.h"
+#include "tasks.h"
+#include "clip_builder.h"
+#include "sim_scenarios.h"
+
+#define CLIP_TEST_FRAMES 5000
+
+static std::vector<ClipSource> clips;  // rainbow / sparkle / wipe / still
+static std::vector<uint8_t> bundle;
+static std::mt19937 rng(24);
+
+void setUp(void) {
+  if (bundle.empty()) {
+    ClipEncodeStats stats;
+    TEST_ASSERT_TRUE(buildDemoClips(clips, bundle, stats));
+  }
+  unlink(clipPartitionPath().c_str());
+  simReset();
+  TEST_ASSERT_TRUE(simSetPartitionFile(CLIP_PARTITION_LABEL, clipPartitionPath().c_str(), CLIP_TEST_PARTITION_SIZE));
+}
+
+void tearDown(void) {
+  Scheduler::setObserver(nullptr);
+  simSetPartitionFile(CLIP_PARTITION_LABEL, nullptr, 0);
+  initializeClips();
+  unlink(clipPartitionPath().c_str());
+}
+
+// ==================== 编码 ====================
+// 编码后从包里顺序解码，每一帧与原始像素逐字节相同
+static void test_bundle_decodes_losslessly(void) {
+  uint8_t count = 0;
+  const ClipEntry* entries = validateClipBundle(bundle.data(), bundle.size(), true, count);
+  TEST_ASSERT_NOT_NULL(entries);
+  TEST_ASSERT_EQUAL_size_t(clips.size(), count);
+  std::vector<CRGB> out;
+  for (uint8_t i = 0; i < count; i++) {
+    const ClipEntry& e = entries[i];
+    out.assign(e.pixels, CRGB(0, 0, 0));
+    const uint8_t* p = bundle.data() + e.offset;
+    const uint8_t* end = p + e.length;
+    for (uint32_t f = 0; f < e.frames; f++) {
+      size_t used = decodeClipFrame(p, end - p, e.pixels, out.data(), e.pixels);
+      TEST_ASSERT_TRUE_MESSAGE(used != 0, e.name);
+      TEST_ASSERT_EQUAL_MEMORY_MESSAGE(&clips[i].frames[f * e.pixels], out.data(), e.pixels * sizeof(CRGB), e.name);
+      p += used;
+    }
+    TEST_ASSERT_TRUE(p == end);
+  }
+}
+
+// 损坏的帧返回 0；灯带比片段短时不写出 count 之外
+static void test_corrupt_frames_rejected_within_bounds(void) {
+  static const uint8_t CORRUPT[][11] = {
+    {CLIP_FRAME_RAW, 24, 0, 1, 2, 3},                     // 载荷比帧头声明的短
+    {CLIP_FRAME_RLE, 4, 0, 8, 1, 2, 3},                    // 9 个像素的游程超出 8 个像素
+    {CLIP_FRAME_RLE, 4, 0, 6, 1, 2, 3},                    // 只覆盖 7 个像素
+    {CLIP_FRAME_DELTA, 8, 0, 7, 2, 1, 2, 3, 4, 5, 6},      // 第 7、8 个像素超出范围
+    {CLIP_FRAME_DELTA, 5, 0, 0, 2, 1, 2, 3},               // 声明 2 个像素只有 1 个
+    {7, 0, 0},                                             // 未知类型
+  };
+  static const size_t LENGTHS[] = {6, 7, 7, 11, 8, 3};
+  CRGB out[8];
+  for (size_t i = 0; i < sizeof(LENGTHS) / sizeof(LENGTHS[0]); i++) {
+    TEST_ASSERT_EQUAL_size_t(0, decodeClipFrame(CORRUPT[i], LENGTHS[i], 8, out, 8));
+  }
+  const uint8_t rle[] = {CLIP_FRAME_RLE, 4, 0, 7, 9, 9, 9};
+  const uint8_t delta[] = {CLIP_FRAME_DELTA, 5, 0, 5, 1, 1, 2, 3};
+  fill_solid(out, 8, CRGB(0xAA, 0xAA, 0xAA));
+  TEST_ASSERT_EQUAL_size_t(sizeof(rle), decodeClipFrame(rle, sizeof(rle), 8, out, 4));
+  TEST_ASSERT_EQUAL_size_t(sizeof(delta), decodeClipFrame(delta, sizeof(delta), 8, out, 4));
+  TEST_ASSERT_EQUAL_UINT8(9, out[3].r);
+  TEST_ASSERT_EQUAL_UINT8(0xAA, out[4].r);
+  TEST_ASSERT_EQUAL_UINT8(0xAA, out[5].r);
+  TEST_ASSERT_EQUAL_UINT8(0xAA, out[7].r);
+}
+
+static void test_crc_detects_frame_change(void) {
+  std::vector<uint8_t> flipped = bundle;
+  flipped.back() ^= 1;
+  uint8_t count = 0;
+  TEST_ASSERT_NULL(validateClipBundle(flipped.data(), flipped.size(), true, count));
+}
+
+// ==================== 分区 ====================
+static void test_erased_partition_is_empty(void) {
+  initializeClips();
+  TEST_ASSERT_EQUAL_UINT8(CLIP_STORE_EMPTY, clipStoreState());
+}
+
+static void test_bad_uploads_leave_store_empty(void) {
+  initializeClips();
+  uint32_t rejected = clipStats().rejected;
+  std::vector<uint8_t> corrupt = bundle;
+  corrupt[bundle.size() / 2] ^= 0x40;
+  TEST_ASSERT_FALSE_MESSAGE(uploadClips(corrupt, rng, corrupt.size()), "CRC 不符");
+  TEST_ASSERT_EQUAL_UINT8(CLIP_STORE_EMPTY, clipStoreState());
+  std::vector<uint8_t> longer = bundle;
+  longer.push_back(0);
+  TEST_ASSERT_FALSE_MESSAGE(uploadClips(longer, rng, longer.size()), "长度与头部不符");
+  TEST_ASSERT_EQUAL_UINT8(CLIP_STORE_EMPTY, clipStoreState());
+
+  // 中途断开后重启
+  TEST_ASSERT_FALSE(uploadClips(bundle, rng, bundle.size() / 2));
+  TEST_ASSERT_EQUAL_STRING("aborted", clipUploadError());
+  TEST_ASSERT_EQUAL_UINT8(CLIP_STORE_EMPTY, clipStoreState());
+  initializeClips();
+  TEST_ASSERT_EQUAL_UINT8(CLIP_STORE_EMPTY, clipStoreState());
+  TEST_ASSERT_EQUAL_UINT32(3, clipStats().rejected - rejected);
+}
+
+static void test_upload_maps_bundle_and_survives_restart(void) {
+  initializeClips();
+  TEST_ASSERT_TRUE(uploadClips(bundle, rng, bundle.size()));
+  TEST_ASSERT_EQUAL_UINT8(CLIP_STORE_READY, clipStoreState());
+  TEST_ASSERT_TRUE_MESSAGE(clipCallbackFlashBytes() == 0, "上传回调里擦写了 flash");
+  size_t size = 0;
+  const uint8_t* mapped = halPartitionMap(CLIP_PARTITION_LABEL, size);
+  TEST_ASSERT_NOT_NULL(mapped);
+  TEST_ASSERT_EQUAL_MEMORY(bundle.data(), mapped, bundle.size());
+
+  // 超出分区的上传被拒绝，现有的包不受影响
+  TEST_ASSERT_FALSE(clipUploadBegin(CLIP_TEST_PARTITION_SIZE + 1));
+  TEST_ASSERT_EQUAL_UINT8(CLIP_STORE_READY, clipStoreState());
+  initializeClips();
+  TEST_ASSERT_EQUAL_UINT8(CLIP_STORE_READY, clipStoreState());
+
+  FixedTextWriter<1024> json;
+  encodeClipsJSON(json);
+  TEST_ASSERT_FALSE(json.overflowed());
+  TEST_ASSERT_NOT_NULL(strstr(json.c_str(), "\"state\":\"ready\""));
+  TEST_ASSERT_NOT_NULL(strstr(json.c_str(), "{\"name\":\"sparkle\",\"frames\":90,\"fps\":30"));
+}
+
+// 同一时刻只有一个上传：另一个片段上传和固件更新都被拒绝，不影响正在进行的上传
+static void test_second_upload_rejected_while_writing(void) {
+  initializeClips();
+  uint32_t rejected = clipStats().rejected;
+  TEST_ASSERT_TRUE(clipUploadBegin(bundle.size()));
+  TEST_ASSERT_FALSE(clipUploadBegin(bundle.size()));
+  TEST_ASSERT_FALSE(otaBegin("firmware.ota"));
+  TEST_ASSERT_EQUAL_UINT8(CLIP_STORE_WRITING, clipStoreState());
+  TEST_ASSERT_TRUE(clipUploadWrite(bundle.data(), 1000));
+  clipUploadAbort();
+  runFlashTask();
+  TEST_ASSERT_EQUAL_UINT32(2, clipStats().rejected - rejected);
+  TEST_ASSERT_TRUE(uploadClips(bundle, rng, bundle.size()));
+  TEST_ASSERT_EQUAL_UINT8(CLIP_STORE_READY, clipStoreState());
+}
+
+// 直接从映射解码，以及经 renderClipFrame() 按帧周期推进（含查找片段、按时间选帧）
+static void test_decode_and_playback_do_not_allocate(void) {
+  initializeClips();
+  TEST_ASSERT_TRUE(uploadClips(bundle, rng, bundle.size()));
+  size_t size = 0;
+  uint8_t count = 0;
+  const uint8_t* mapped = halPartitionMap(CLIP_PARTITION_LABEL, size);
+  const ClipEntry* entries = validateClipBundle(mapped, size, false, count);
+  TEST_ASSERT_NOT_NULL(entries);
+  uint8_t mode = 0;
+  TEST_ASSERT_TRUE(findClipMode("clip:sparkle", mode));
+
+  std::vector<CRGB> out(NUM_LEDS);
+  uint32_t decoded = 0;
+  uint64_t allocations = heapAllocationCount();
+  for (uint8_t i = 0; i < count; i++) {
+    const ClipEntry& e = entries[i];
+    const uint8_t* end = mapped + e.offset + e.length;
+    const uint8_t* p = end;
+    for (uint32_t k = 0; k < CLIP_TEST_FRAMES / count; k++) {
+      if (p == end) {
+        p = mapped + e.offset;
+      }
+      size_t used = decodeClipFrame(p, end - p, e.pixels, out.data(), NUM_LEDS);
+      decoded += used != 0;
+      p += used ? used : end - p;
+    }
+  }
+  uint32_t decodedBefore = clipStats().framesDecoded;
+  for (uint32_t k = 0; k < CLIP_TEST_FRAMES; k++) {
+    renderClipFrame(mode, out.data(), NUM_LEDS, k * 1000 / 30 + 1);  // 每次恰好前进一帧
+  }
+  TEST_ASSERT_TRUE(heapAllocationCount() == allocations);
+  TEST_ASSERT_EQUAL_UINT32(CLIP_TEST_FRAMES / count * count, decoded);
+  TEST_ASSERT_EQUAL_UINT32(CLIP_TEST_FRAMES, clipStats().framesDecoded - decodedBefore);
+}
+
+// ==================== 端到端 ====================
+// LED 作业每渲染一帧，leds[] 与按时间应显示的帧（或前一帧，渲染时刻早于观察时刻）比较
+static const ClipSource* playbackClip = nullptr;
+static uint32_t playbackFrames = 0;
+static uint32_t playbackMismatches = 0;
+
+static void observeClipFrame(const Job& job, bool finished) {
+  if (!finished || job.run != updateLEDController || !playbackClip) {
+    return;
+  }
+  const ClipSource& clip = *playbackClip;
+  uint32_t frames = (uint32_t)(clip.frames.size() / clip.pixels);
+  uint32_t elapsed = halMillis() - ledController.modeStartMillis;
+  uint32_t expected = (uint32_t)((uint64_t)elapsed * clip.fps / 1000);
+  expected = clip.loop ? expected % frames : std::min(expected, frames - 1);
+  uint32_t previous = expected ? expected - 1 : (clip.loop ? frames - 1 : 0);
+  bool match = false;
+  for (uint32_t f : {expected, previous}) {
+    match |= memcmp(leds, &clip.frames[f * clip.pixels], clip.pixels * sizeof(CRGB)) == 0;
+  }
+  playbackFrames++;
+  playbackMismatches += !match;
+}
+
+static void assertPlays(const ClipSource& clip, uint32_t ms) {
+  playbackClip = &clip;
+  playbackFrames = 0;
+  playbackMismatches = 0;
+  runForMillis(ms);
+  playbackClip = nullptr;
+  TEST_ASSERT_GREATER_THAN_UINT32_MESSAGE(0, playbackFrames, clip.name.c_str());
+  TEST_ASSERT_EQUAL_UINT32_MESSAGE(0, playbackMismatches, clip.name.c_str());
+}
+
+static void assertLEDPeriodFollows(uint8_t mode, uint16_t framePeriodMillis) {
+  TEST_ASSERT_EQUAL_UINT32(framePeriodMillis, clipModeEffect(mode).framePeriodMillis);
+  TEST_ASSERT_EQUAL_UINT32(ledFramePeriodMicros(clipModeEffect(mode)), renderScheduler.job(JOB_LED).periodMicros);
+}
+
+// 分区里已有包时冷启动到 MQTT 就绪，规则空闲时选择 clip:wipe
+static uint8_t bootWithClips() {
+  initializeClips();
+  TEST_ASSERT_TRUE(uploadClips(bundle, rng, bundle.size()));
+  simNVSClear();
+  simReset();
+  simPowerCycle();
+  initializeSystem();
+  runUntil(30000000ULL, true);
+  TEST_ASSERT_EQUAL_UINT8(CLIP_STORE_READY, clipStoreState());
+  Scheduler::setObserver(observeClipFrame);
+
+  static const char RULES[] = "{\"rules\":[{\"name\":\"idle\",\"priority\":0,\"mode\":\"clip:wipe\",\"base\":0}]}";
+  uint8_t wipeMode = 0;
+  TEST_ASSERT_TRUE(submitRulesJSON(RULES, sizeof(RULES) - 1, false));
+  TEST_ASSERT_TRUE(findLEDMode("clip:wipe", wipeMode));
+  runForMillis(100);
+  return wipeMode;
+}
+
+static uint8_t selectSparkle() {
+  deliverCommand(commandTopic(mqttCommandPrefix(), "mode"), "{\"mode\":\"clip:sparkle\"}");
+  runForMillis(50);
+  uint8_t sparkleMode = 0;
+  TEST_ASSERT_TRUE(findLEDMode("clip:sparkle", sparkleMode));
+  return sparkleMode;
+}
+
+static void test_rules_select_clip(void) {
+  uint8_t wipeMode = bootWithClips();
+  TEST_ASSERT_EQUAL_UINT8(wipeMode, ledController.mode);
+  assertLEDPeriodFollows(wipeMode, 1000 / 30);
+  assertPlays(clips[2], 3000);  // 含循环
+}
+
+static void test_mqtt_selects_clip(void) {
+  bootWithClips();
+  uint8_t sparkleMode = selectSparkle();
+  TEST_ASSERT_TRUE(ledController.remote);
+  TEST_ASSERT_EQUAL_UINT8(sparkleMode, ledController.mode);
+  assertPlays(clips[1], 3000);
+}
+
+static void test_missing_clip_renders_black(void) {
+  bootWithClips();
+  deliverCommand(commandTopic(mqttCommandPrefix(), "mode"), "{\"mode\":\"clip:nosuch\"}");
+  runForMillis(100);
+  for (uint16_t i = 0; i < ledCount; i++) {
+    TEST_ASSERT_TRUE(leds[i].r == 0 && leds[i].g == 0 && leds[i].b == 0);
+  }
+}
+
+// 播放中重新上传：从头播放新片段，帧周期跟随
+static void test_reupload_restarts_playback(void) {
+  bootWithClips();
+  uint8_t sparkleMode = selectSparkle();
+  runForMillis(450);
+  std::vector<ClipSource> slower = clips;
+  slower[1].fps = 20;
+  std::vector<uint8_t> slowerBundle;
+  ClipEncodeStats stats;
+  std::string error;
+  uint32_t restarts = clipStats().restarts;
+  TEST_ASSERT_TRUE(buildClipBundle(slower, slowerBundle, stats, error));
+  TEST_ASSERT_TRUE(uploadClips(slowerBundle, rng, slowerBundle.size()));
+  runForMillis(100);
+  TEST_ASSERT_GREATER_THAN_UINT32(restarts, clipStats().restarts);
+  assertLEDPeriodFollows(sparkleMode, 1000 / 20);
+  assertPlays(slower[1], 2000);
+}
+
+static void test_reset_returns_to_rule_clip(void) {
+  uint8_t wipeMode = bootWithClips();
+  selectSparkle();
+  deliverCommand(commandTopic(mqttCommandPrefix(), "reset"), "");
+  runForMillis(50);
+  TEST_ASSERT_FALSE(ledController.remote);
+  TEST_ASSERT_EQUAL_UINT8(wipeMode, ledController.mode);
+  assertPlays(clips[2], 1000);
+}
+
+int main(int argc, char** argv) {
+  (void)argc;
+  (void)argv;
+  UNITY_BEGIN();
+  RUN_TEST(test_bundle_decodes_losslessly);
+  RUN_TEST(test_corrupt_frames_rejected_within_bounds);
+  RUN_TEST(test_crc_detects_frame_change);
+  RUN_TEST(test_erased_partition_is_empty);
+  RUN_TEST(test_bad_uploads_leave_store_empty);
+  RUN_TEST(test_upload_maps_bundle_and_survives_restart);
+  RUN_TEST(test_second_upload_rejected_while_writing);
+  RUN_TEST(test_decode_and_playback_do_not_allocate);
+  RUN_TEST(test_rules_select_clip);
+  RUN_TEST(test_mqtt_selects_clip);
+  RUN_TEST(test_missing_clip_renders_black);
+  RUN_TEST(test_reupload_restarts_playback);
+  RUN_TEST(test_reset_returns_to_rule_clip);
+  return UNITY_END();
+}
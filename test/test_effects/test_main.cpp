@@ -0,0 +1,58 @@
+// ==================== 灯效 ====================
+// 每种灯效在 1000 个像素上的单帧渲染时间不超过 budgetMicros，渲染卡顿后动画按时间推进
+#include <unity.h>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include "ball.h"
+#include "led_compositor.h"
+#include "effects.h"
+#include "sim_scenarios.h"
+
+#define EFFECT_TEST_FRAMES 200
+
+void setUp(void) {
+  simReset();
+  initializeSystem();
+}
+
+void tearDown(void) {
+}
+
+static void test_effects_render_within_budget(void) {
+  static CRGB buffer[1000];
+  for (uint8_t mode = 0; mode < NUM_LED_MODES; mode++) {
+    const Effect& effect = ledModeEffect((LEDMode)mode);
+    // 每帧推进 7 ms，覆盖整个周期内的各个相位
+    uint64_t start = hostNanos();
+    for (uint32_t f = 0; f < EFFECT_TEST_FRAMES; f++) {
+      renderEffect(effect, buffer, 1000, f * 7, 153);
+    }
+    uint64_t nanosPerFrame = (hostNanos() - start) / EFFECT_TEST_FRAMES;
+    char message[64];
+    snprintf(message, sizeof(message), "模式 %u（%s）超出预算", mode, effectName(effect.kind));
+    TEST_ASSERT_LESS_THAN_UINT32_MESSAGE(effect.budgetMicros * 1000u, (uint32_t)nanosPerFrame, message);
+  }
+}
+
+// 渲染任务卡顿 1200 ms 后，下一帧应与按时间直接计算的帧一致（旧实现每帧固定推进一步，动画会整体变慢）
+static void test_animation_follows_time_after_stall(void) {
+  setLEDMode(LED_BREATHE_RED);
+  updateLEDController();
+  simAdvanceMicros(1200 * 1000UL);
+  uint32_t elapsed = halMillis() - ledController.modeStartMillis;  // show() 会推进虚拟时钟，先取时刻
+  updateLEDController();
+  std::vector<CRGB> expected(ledCount);
+  renderEffect(ledModeEffect(LED_BREATHE_RED), expected.data(), ledCount, elapsed, 255);
+  TEST_ASSERT_TRUE(leds[0].r > 0);
+  TEST_ASSERT_EQUAL_MEMORY(expected.data(), leds, ledCount * sizeof(CRGB));
+}
+
+int main(int argc, char** argv) {
+  (void)argc;
+  (void)argv;
+  UNITY_BEGIN();
+  RUN_TEST(test_effects_render_within_budget);
+  RUN_TEST(test_animation_follows_time_after_stall);
+  return UNITY_END();
+}
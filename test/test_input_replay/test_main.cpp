@@ -0,0 +1,106 @@
+// ==================== 输入录制与回放 ====================
+// 在模拟引脚上录制一分钟合成按键（含抖动、一次中断队列溢出和一段 20 分钟的空闲），再回放：
+// 录制完整、输出可重复、MQTT 发布与录制时一致、规则改动被 golden 比对发现、损坏的文件被拒绝
+#include <unity.h>
+#include <string>
+#include <vector>
+#include "ball.h"
+#include "button_rules.h"
+#include "input_trace.h"
+#include "input_replay.h"
+#include "sim_scenarios.h"
+
+#define REPLAY_TEST_SECONDS 60
+
+static TraceRecording recording;
+static ReplayResult first;
+static bool recorded = false;
+static bool replayed = false;
+
+static const TraceRecording& recorded60s() {
+  if (!recorded) {
+    recordSyntheticTrace(REPLAY_TEST_SECONDS, recording);
+    recorded = true;
+  }
+  TEST_ASSERT_TRUE_MESSAGE(recording.fileLength > 0, "无法读取录制文件");
+  return recording;
+}
+
+static const ReplayResult& firstReplay() {
+  const TraceRecording& r = recorded60s();
+  if (!replayed) {
+    replayInputTrace(r.file.data(), r.file.size(), first);
+    replayed = true;
+  }
+  TEST_ASSERT_TRUE_MESSAGE(first.error.empty(), first.error.c_str());
+  return first;
+}
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+  simWriteFile(RULES_FILE_PATH, nullptr);
+}
+
+static void test_recording_is_complete(void) {
+  const TraceRecording& r = recorded60s();
+  TEST_ASSERT_GREATER_THAN_UINT32(0, r.lost);
+  TEST_ASSERT_EQUAL_UINT32(r.driven - r.lost, r.trace.edges);
+  TEST_ASSERT_GREATER_THAN_UINT32(0, r.trace.resyncs);
+  TEST_ASSERT_FALSE(r.trace.truncated);
+  TEST_ASSERT_EQUAL_UINT32(r.trace.bytes, (uint32_t)r.fileLength);
+  TEST_ASSERT_EQUAL_UINT32(r.trace.bytes, r.trace.savedBytes);
+}
+
+static void test_replay_is_repeatable(void) {
+  const TraceRecording& r = recorded60s();
+  const ReplayResult& once = firstReplay();
+  ReplayResult again;
+  TEST_ASSERT_TRUE_MESSAGE(replayInputTrace(r.file.data(), r.file.size(), again), again.error.c_str());
+  TEST_ASSERT_EQUAL_size_t(0, compareReplayLines(again.lines, once.lines));
+  TEST_ASSERT_EQUAL_UINT32(r.trace.edges, once.edges);
+  TEST_ASSERT_EQUAL_UINT32(r.trace.resyncs, once.resyncs);
+  TEST_ASSERT_TRUE(once.traceMicros >= r.micros);
+}
+
+static void test_replay_publishes_recorded_topics(void) {
+  const TraceRecording& r = recorded60s();
+  std::vector<std::string> topics = replayTopics(firstReplay());
+  TEST_ASSERT_FALSE(topics.empty());
+  TEST_ASSERT_EQUAL_size_t(r.topics.size(), topics.size());
+  TEST_ASSERT_TRUE(topics == r.topics);
+}
+
+// 同一份录制，亮度步长不同：golden 比对应在第一次按下绿色按钮后的某一帧发现差异
+static void test_changed_rules_differ_from_golden(void) {
+  const TraceRecording& r = recorded60s();
+  const ReplayResult& golden = firstReplay();
+  simWriteFile(RULES_FILE_PATH, changedStepRules().c_str());
+  ReplayResult changed;
+  replayInputTrace(r.file.data(), r.file.size(), changed);
+  TEST_ASSERT_TRUE(compareReplayLines(changed.lines, golden.lines) != 0);
+}
+
+// 截断在一条记录中间
+static void test_truncated_trace_rejected(void) {
+  const TraceRecording& r = recorded60s();
+  const uint8_t* data = r.file.data();
+  size_t cut = INPUT_TRACE_HEADER_SIZE + 1;
+  while (cut < r.file.size() && !(data[cut - 1] & 0x80)) cut++;
+  ReplayResult broken;
+  TEST_ASSERT_FALSE(replayInputTrace(data, cut, broken));
+  TEST_ASSERT_FALSE(broken.error.empty());
+}
+
+int main(int argc, char** argv) {
+  (void)argc;
+  (void)argv;
+  UNITY_BEGIN();
+  RUN_TEST(test_recording_is_complete);
+  RUN_TEST(test_replay_is_repeatable);
+  RUN_TEST(test_replay_publishes_recorded_topics);
+  RUN_TEST(test_changed_rules_differ_from_golden);
+  RUN_TEST(test_truncated_trace_rejected);
+  return UNITY_END();
+}
@@ -0,0 +1,55 @@
+// ==================== LED 双缓冲 ====================
+// 以快于灯带发送的速度推送：灯带上不出现撕裂或混合帧，来不及发送的帧计入丢弃，推送不阻塞
+#include <unity.h>
+#include "ball.h"
+#include "led_compositor.h"
+#include "hal_sim.h"
+#include "sim_scenarios.h"
+
+#define LED_TEST_FRAMES 2000
+
+static LedPushRun run;
+static bool ran = false;
+
+static const LedPushRun& pushed() {
+  if (!ran) {
+    run = pushFramesFasterThanWire(LED_TEST_FRAMES);
+    ran = true;
+  }
+  return run;
+}
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+static void test_no_torn_or_mixed_frames(void) {
+  pushed();
+  TEST_ASSERT_EQUAL_UINT32(0, simCounters().ledTornFrames);
+  TEST_ASSERT_EQUAL_UINT32(0, simCounters().ledOverlaps);
+  TEST_ASSERT_EQUAL_UINT32(0, pushed().mixedFrames);
+}
+
+static void test_late_frames_are_dropped_and_counted(void) {
+  const LedPushRun& r = pushed();
+  TEST_ASSERT_EQUAL_UINT32(r.frames, r.rendered + r.dropped);
+  TEST_ASSERT_GREATER_THAN_UINT32(0, r.dropped);
+  // 推送前启动时的帧可能仍在发送，按累计值比较
+  TEST_ASSERT_EQUAL_UINT32(compositorStats().framesRendered, compositorStats().framesCompleted);
+}
+
+static void test_present_does_not_block(void) {
+  TEST_ASSERT_TRUE(pushed().presentVirtualMicros == 0);
+}
+
+int main(int argc, char** argv) {
+  (void)argc;
+  (void)argv;
+  UNITY_BEGIN();
+  RUN_TEST(test_no_torn_or_mixed_frames);
+  RUN_TEST(test_late_frames_are_dropped_and_counted);
+  RUN_TEST(test_present_does_not_block);
+  return UNITY_END();
+}
@@ -0,0 +1,72 @@
+// ==================== 灯带布局 ====================
+// 段映射（反向、颜色顺序、镜像）正确；2000 像素分 1/4/8 个通道并行发送不撕裂，8 个通道不低于 60 fps
+#include <unity.h>
+#include "ball.h"
+#include "led_compositor.h"
+#include "hal_sim.h"
+#include "sim_scenarios.h"
+
+void setUp(void) {
+  simReset();
+}
+
+void tearDown(void) {
+  simWriteFile(LED_LAYOUT_FILE_PATH, nullptr);
+}
+
+// 通道 0 为 RGB 的 [0,100)；通道 1 为 GRB，先反向接 [100,200)，再镜像 [0,50)
+static void test_segments_map_to_wire(void) {
+  simWriteFile(LED_LAYOUT_FILE_PATH,
+               "{\"channels\": [{\"pin\": 23}, {\"pin\": 22, \"order\": \"grb\"}],"
+               " \"segments\": [{\"channel\": 0, \"start\": 0, \"count\": 100},"
+               " {\"channel\": 1, \"start\": 100, \"count\": 100, \"reverse\": true},"
+               " {\"channel\": 1, \"start\": 0, \"count\": 50}]}");
+  initializeSystem();
+  waitForFrame();
+  for (uint16_t i = 0; i < ledCount; i++) {
+    leds[i] = CRGB(i, 255 - i, (i * 7) & 0xFF);
+  }
+  compositorPresent();
+  waitForFrame();
+  TEST_ASSERT_EQUAL_UINT16(200, ledCount);
+  for (uint16_t i = 0; i < 100; i++) {
+    TEST_ASSERT_TRUE_MESSAGE(wireMatches(0, i, i, RGB), "通道 0");
+    TEST_ASSERT_TRUE_MESSAGE(wireMatches(1, i, 199 - i, GRB), "通道 1 反向段");
+  }
+  for (uint16_t i = 0; i < 50; i++) {
+    TEST_ASSERT_TRUE_MESSAGE(wireMatches(1, 100 + i, i, GRB), "通道 1 镜像段");
+  }
+}
+
+static void checkSplit(uint8_t channels) {
+  LayoutRun run = runSplitLayout(2000, channels);
+  TEST_ASSERT_EQUAL_UINT16(2000, run.pixels);
+  TEST_ASSERT_EQUAL_UINT32(0, simCounters().ledTornFrames);
+  TEST_ASSERT_EQUAL_UINT32(0, simCounters().ledOverlaps);
+  if (channels == 8) {
+    TEST_ASSERT_TRUE_MESSAGE(run.fps >= 60, "8 个通道低于 60 fps");
+  }
+}
+
+static void test_one_channel(void) {
+  checkSplit(1);
+}
+
+static void test_four_channels(void) {
+  checkSplit(4);
+}
+
+static void test_eight_channels_reach_60_fps(void) {
+  checkSplit(8);
+}
+
+int main(int argc, char** argv) {
+  (void)argc;
+  (void)argv;
+  UNITY_BEGIN();
+  RUN_TEST(test_segments_map_to_wire);
+  RUN_TEST(test_one_channel);
+  RUN_TEST(test_four_channels);
+  RUN_TEST(test_eight_channels_reach_60_fps);
+  return UNITY_END();
+}
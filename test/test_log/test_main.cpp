@@ -0,0 +1,172 @@
+// ==================== 异步日志 ====================
+// 调用点不分配内存、限流只计数；突发时调用方不被串口阻塞，缓冲区满时丢弃计数；
+// 格式化、远程输出（syslog、WebSocket 日志视图）和多生产者队列
+#include <unity.h>
+#include <string.h>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#include "ball.h"
+#include "log.h"
+#include "mpsc_queue.h"
+#include "mqtt_outbox.h"
+#include "ws_fanout.h"
+#include "sim_scenarios.h"
+
+#define LOG_TEST_ITERATIONS 20000
+#define LOG_TEST_BURST 200  // 渲染任务 100 ms 内记录的按钮边沿
+
+void setUp(void) {
+  simReset();
+}
+
+void tearDown(void) {
+  setSyslogServer("", SYSLOG_PORT);
+}
+
+static void test_call_sites_do_not_allocate(void) {
+  LogCallRun run = runLogCallSites(LOG_TEST_ITERATIONS);
+  TEST_ASSERT_TRUE(run.allocations == 0);
+  TEST_ASSERT_EQUAL_UINT32(LOG_TEST_ITERATIONS, run.stats.suppressed);
+  TEST_ASSERT_EQUAL_UINT32(0, run.stats.dropped);
+  TEST_ASSERT_EQUAL_UINT32(run.stats.written, run.stats.emitted);
+}
+
+static uint32_t elidedEvaluations = 0;
+
+[[maybe_unused]] static uint32_t countEvaluation() {
+  return ++elidedEvaluations;
+}
+
+// 编译期裁剪：LOG_LEVEL 为 INFO 时 LOG_DEBUG 的参数不求值
+static void test_debug_arguments_elided_below_level(void) {
+  initializeLog();
+  LOG_DEBUG(LOG_BUTTON_STATUS, countEvaluation());
+  TEST_ASSERT_EQUAL_UINT32(LOG_LEVEL < LOG_LEVEL_DEBUG ? 0 : 1, elidedEvaluations);
+}
+
+static void assertFormatsAs(const LogRecord& record, const char* expected) {
+  FixedTextWriter<LOG_LINE_CAPACITY> line;
+  formatLogRecord(line, record);
+  TEST_ASSERT_EQUAL_STRING(expected, line.c_str());
+}
+
+static void test_records_format_like_printf(void) {
+  assertFormatsAs(LogRecord{1500, LOG_LEVEL_INFO, LOG_BOOT_TIMINGS, 4, 0, 0, {1500, 23042, UINT32_MAX, 5}, {0}},
+                  "[1.500] I 启动耗时: 首次按钮扫描 1.500 ms，首帧 23.042 ms，WiFi -，MQTT就绪 0.005 ms");
+  assertFormatsAs(LogRecord{61234, LOG_LEVEL_WARN, LOG_MQTT_FAILED, 2, 0, 0, {(uintptr_t)(intptr_t)-2, 4000}, {0}},
+                  "[61.234] W MQTT连接失败，状态码: -2，4000 ms 后重试");
+  assertFormatsAs(LogRecord{7, LOG_LEVEL_ERROR, LOG_RULES_INVALID, 0, 3, 0, {0}, {'a', 'b', 'c'}},
+                  "[0.007] E 按钮规则无效：abc");
+  assertFormatsAs(LogRecord{0, LOG_LEVEL_INFO, LOG_MQTT_CONNECTED, 0, 0, 0, {0}, {0}},
+                  "[0.000] I MQTT连接成功（? ms）");
+}
+
+// 串口 115200 波特：同步 Serial.printf 阻塞调用方，异步日志只写发送缓冲区放得下的行
+static void test_burst_does_not_block_caller(void) {
+  TEST_ASSERT_TRUE(runLegacyLogBurst(LOG_TEST_BURST) > 0);
+  LogBurstRun run = runLogBurst(LOG_TEST_BURST);
+  TEST_ASSERT_TRUE(run.blockedMicros == 0);
+  TEST_ASSERT_EQUAL_UINT32(LOG_TEST_BURST, run.stats.written + run.stats.suppressed + run.stats.dropped);
+  TEST_ASSERT_GREATER_THAN_UINT32(0, run.stats.suppressed);
+}
+
+// 超过容量的丢弃计数并输出一行丢弃条数；串口跟不上时日志作业推迟而不是阻塞
+static void test_full_ring_drops_and_reports(void) {
+  LogBurstRun run = runLogRingFull();
+  TEST_ASSERT_EQUAL_UINT32(LOG_RING_SIZE, run.stats.written);
+  TEST_ASSERT_EQUAL_UINT32(run.attempts - LOG_RING_SIZE, run.stats.dropped);
+  TEST_ASSERT_EQUAL_UINT32(run.stats.written + 1, run.stats.emitted);
+  TEST_ASSERT_GREATER_THAN_UINT32(0, run.stats.deferred);
+  TEST_ASSERT_TRUE(run.blockedMicros == 0);
+}
+
+static std::string lastUDP;
+static std::string lastViewFrame;
+
+static void observeUDP(const char* text, size_t length) {
+  lastUDP.assign(text, length);
+}
+
+static void observeViewFrame(const char* text, size_t length) {
+  lastViewFrame.assign(text, length);
+}
+
+// WiFi 连上后 syslog 收到 <PRI>ball: 消息，WebSocket 日志视图收到整行；DEBUG 不发送
+static void test_remote_outputs(void) {
+  initializeSystem();
+  runUntil(30000000ULL, true);
+  simSetUDPHook(observeUDP);
+  simSetWebSocketTextHook(observeViewFrame);
+  setSyslogServer("192.168.1.2", SYSLOG_PORT);
+  uint32_t viewer = simWebSocketConnect(0);
+  wsClientConnected(viewer);
+  wsSetLogView(viewer, true);
+  while (drainLog()) {
+  }
+  uint32_t packets = simCounters().udpPackets;
+  logWrite(LOG_LEVEL_DEBUG, LOG_RULES_UPDATED, 1);
+  LOG_WARN(LOG_MQTT_LOST, 1000u);
+  runUntil(simNowMicros() + 2 * LOG_DRAIN_INTERVAL * 1000ULL, false);
+  wsSetLogView(viewer, false);
+
+  TEST_ASSERT_EQUAL_STRING("<132>ball: MQTT连接断开，1000 ms 后重连", lastUDP.c_str());
+  TEST_ASSERT_EQUAL_UINT32(packets + 1, simCounters().udpPackets);
+  TEST_ASSERT_TRUE(lastViewFrame.find("W MQTT连接断开，1000 ms 后重连") != std::string::npos);
+  TEST_ASSERT_TRUE(lastViewFrame.find("按钮规则已更新") == std::string::npos);
+}
+
+// 多个生产者线程同时写入，消费者逐条核对每个生产者的序号连续、没有丢失或重复
+static void test_mpsc_queue_keeps_producer_order(void) {
+  struct Item {
+    uint32_t producer;
+    uint32_t seq;
+  };
+  static MpscQueue<Item, 64> queue;
+  const uint32_t producers = 4;
+  const uint32_t perProducer = LOG_TEST_ITERATIONS;
+  std::vector<std::thread> threads;
+  for (uint32_t p = 0; p < producers; p++) {
+    threads.emplace_back([p]() {
+      for (uint32_t i = 0; i < perProducer; i++) {
+        while (!queue.push([&](Item& item) { item.producer = p; item.seq = i; })) {
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+  uint32_t next[producers] = {0};
+  uint32_t received = 0;
+  uint32_t errors = 0;
+  while (received < producers * perProducer) {
+    Item item;
+    if (!queue.pop(item)) {
+      std::this_thread::yield();
+      continue;
+    }
+    if (item.producer >= producers || item.seq != next[item.producer]) {
+      errors++;
+    } else {
+      next[item.producer]++;
+    }
+    received++;
+  }
+  for (std::thread& t : threads) t.join();  // 断言失败会跳出用例，先收回线程
+  TEST_ASSERT_EQUAL_UINT32(0, errors);
+  TEST_ASSERT_EQUAL_size_t(0, queue.size());
+}
+
+int main(int argc, char** argv) {
+  (void)argc;
+  (void)argv;
+  UNITY_BEGIN();
+  RUN_TEST(test_call_sites_do_not_allocate);
+  RUN_TEST(test_debug_arguments_elided_below_level);
+  RUN_TEST(test_records_format_like_printf);
+  RUN_TEST(test_burst_does_not_block_caller);
+  RUN_TEST(test_full_ring_drops_and_reports);
+  RUN_TEST(test_remote_outputs);
+  RUN_TEST(test_mpsc_queue_keeps_producer_order);
+  return UNITY_END();
+}
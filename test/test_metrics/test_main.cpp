@@ -0,0 +1,59 @@
+// ==================== 延迟追踪 ====================
+// 追踪点不分配内存；/api/metrics 文本在最坏情况下也放得下
+#include <unity.h>
+#include "ball.h"
+#include "metrics.h"
+#include "power.h"
+#include "text_writer.h"
+#include "sim_scenarios.h"
+
+static char text[METRICS_TEXT_CAPACITY + POWER_TEXT_CAPACITY];  // 与 /api/metrics 相同
+
+void setUp(void) {
+  simReset();
+  initializeMetrics();
+}
+
+void tearDown(void) {
+  initializeMetrics();
+}
+
+static void test_trace_points_do_not_allocate(void) {
+  uint64_t allocations = heapAllocationCount();
+  for (uint32_t i = 0; i < 10000; i++) {
+    uint32_t span = traceBegin();
+    traceEnd(METRIC_BUTTON_LOGIC, span);
+    recordMetric(METRIC_EDGE_TO_PUBLISH, i);
+  }
+  TEST_ASSERT_TRUE(heapAllocationCount() == allocations);
+  TEST_ASSERT_EQUAL_UINT32(10000, metricHistogram(METRIC_BUTTON_LOGIC).count);
+  TEST_ASSERT_EQUAL_UINT32(9999, metricHistogram(METRIC_EDGE_TO_PUBLISH).max);
+}
+
+static void test_metrics_text_fits(void) {
+  for (uint32_t i = 0; i < 10000; i++) {
+    recordMetric(METRIC_EDGE_TO_PUBLISH, i);
+  }
+  TextWriter writer(text, sizeof(text));
+  encodeMetricsText(writer);
+  encodePowerText(writer);
+  TEST_ASSERT_FALSE(writer.overflowed());
+}
+
+static void test_worst_case_metrics_text_fits(void) {
+  saturateMetricHistograms();
+  TextWriter writer(text, sizeof(text));
+  encodeMetricsText(writer);
+  encodePowerText(writer);
+  TEST_ASSERT_FALSE(writer.overflowed());
+}
+
+int main(int argc, char** argv) {
+  (void)argc;
+  (void)argv;
+  UNITY_BEGIN();
+  RUN_TEST(test_trace_points_do_not_allocate);
+  RUN_TEST(test_metrics_text_fits);
+  RUN_TEST(test_worst_case_metrics_text_fits);
+  return UNITY_END();
+}
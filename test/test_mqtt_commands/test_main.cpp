@@ -0,0 +1,370 @@
+// ==================== MQTT 命令 ====================
+// 前缀树与逐个过滤器比对，JSON/二进制载荷解析一致、无效载荷被拒绝，
+// 经模拟服务器端到端应用（灯效、state 回复、交还按钮规则、计数、ball/rules），分发不分配内存
+#include <unity.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include "ball.h"
+#include "led_compositor.h"
+#include "effects.h"
+#include "button_rules.h"
+#include "metrics.h"
+#include "mqtt_commands.h"
+#include "topic_trie.h"
+#include "clips.h"
+#include "sim_scenarios.h"
+
+#define COMMAND_TEST_ITERATIONS 5000
+
+void setUp(void) {
+  simReset();
+  initializeMQTTCommands();
+}
+
+void tearDown(void) {
+  simSetPublishHook(nullptr);
+  simWriteFile(RULES_FILE_PATH, nullptr);
+}
+
+// ==================== 前缀树 ====================
+struct TrieCase {
+  const char* topic;
+  uint8_t expected;
+};
+
+// 优先级：字面值 > '+' > '#'，'#' 匹配零层
+static void test_trie_prefers_literal_then_plus_then_hash(void) {
+  TopicTrie<16, 128> fixed;
+  TEST_ASSERT_TRUE(fixed.insert("ball/+/cmd/mode", 0));
+  TEST_ASSERT_TRUE(fixed.insert("ball/ball1/cmd/#", 1));
+  TEST_ASSERT_TRUE(fixed.insert("ball/#", 2));
+  TEST_ASSERT_TRUE(fixed.insert("ball/all/cmd/mode", 3));
+  TEST_ASSERT_FALSE(fixed.insert("ball/+/cmd/mode", 4));
+  TEST_ASSERT_FALSE(fixed.insert("ball/#/x", 4));
+  TEST_ASSERT_FALSE(fixed.insert("ball/a+", 4));
+  static const TrieCase CASES[] = {
+    {"ball/ball1/cmd/mode", 1}, {"ball/x/cmd/mode", 0}, {"ball/all/cmd/mode", 3}, {"ball/all/cmd/color", 2},
+    {"ball/ball1/cmd", 1}, {"ball", 2}, {"balls", TOPIC_TRIE_NONE}, {"ball/x/cmd/mode/y", 2},
+  };
+  for (const TrieCase& c : CASES) {
+    TEST_ASSERT_EQUAL_UINT8_MESSAGE(c.expected, fixed.match(c.topic, strlen(c.topic)), c.topic);
+  }
+}
+
+// 随机主题的层级；过滤器另外可以用 '+' 和 '#'，空字符串对应 "a//b" 这样的空层级
+static const char* const TOPIC_LEVELS[] = {"ball", "ball1", "all", "cmd", "mode", "", "+", "#"};
+
+static std::string randomTopic(std::mt19937& rng, bool filter) {
+  uint32_t levels = 1 + rng() % 5;
+  std::string text;
+  for (uint32_t l = 0; l < levels; l++) {
+    uint32_t pick = rng() % (filter ? 8 : 6);
+    if (pick == 7 && l + 1 < levels) {
+      pick = 6;  // '#' 只能是最后一层
+    }
+    if (l) {
+      text += '/';
+    }
+    text += TOPIC_LEVELS[pick];
+  }
+  return text;
+}
+
+// 前缀树给出的过滤器必须匹配该主题，没有结果时所有过滤器都不匹配
+static void test_trie_agrees_with_filter_matching(void) {
+  std::mt19937 rng(23);
+  uint32_t matched = 0;
+  for (uint32_t r = 0; r < COMMAND_TEST_ITERATIONS / 32 + 1; r++) {
+    TopicTrie<64, 512> trie;
+    std::vector<std::string> filters;
+    for (int f = 0; f < 12; f++) {
+      std::string filter = randomTopic(rng, true);
+      if (trie.insert(filter.c_str(), (uint8_t)filters.size())) {
+        filters.push_back(filter);
+      }
+    }
+    for (int q = 0; q < 32; q++) {
+      std::string topic = randomTopic(rng, false);
+      uint8_t found = trie.match(topic.data(), topic.size());
+      if (found == TOPIC_TRIE_NONE) {
+        for (const std::string& filter : filters) {
+          TEST_ASSERT_FALSE_MESSAGE(topicMatchesFilter(filter.c_str(), topic.data(), topic.size()), topic.c_str());
+        }
+      } else {
+        TEST_ASSERT_TRUE_MESSAGE(topicMatchesFilter(filters[found].c_str(), topic.data(), topic.size()), topic.c_str());
+        matched++;
+      }
+    }
+  }
+  TEST_ASSERT_GREATER_THAN_UINT32(0, matched);
+}
+
+// ==================== 载荷解析 ====================
+static bool sameCommand(const RemoteCommand& a, const RemoteCommand& b) {
+  return a.op == b.op && a.fields == b.fields && a.mode == b.mode && a.effect == b.effect && a.level == b.level &&
+         a.color.r == b.color.r && a.color.g == b.color.g && a.color.b == b.color.b && a.color2.r == b.color2.r &&
+         a.color2.g == b.color2.g && a.color2.b == b.color2.b && a.periodMillis == b.periodMillis;
+}
+
+static bool parsesAs(const std::string& topic, const std::string& payload, RemoteCommand& command) {
+  uint8_t route = matchMQTTRoute(topic.data(), topic.size());
+  return parseRemoteCommand(route, (const uint8_t*)payload.data(), payload.size(), command);
+}
+
+static void test_json_and_binary_parse_alike(void) {
+  std::mt19937 rng(29);
+  const char* prefix = mqttCommandPrefix();
+  for (uint32_t i = 0; i < COMMAND_TEST_ITERATIONS; i++) {
+    uint8_t v[8];
+    for (uint8_t& b : v) {
+      b = (uint8_t)rng();
+    }
+    char json[160];
+    std::string binary(1, (char)MQTT_COMMAND_BINARY);
+    const char* name;
+    switch (i % 4) {
+      case 0:
+        name = "mode";
+        v[0] %= NUM_LED_MODES;
+        snprintf(json, sizeof(json), "{\"mode\":\"%s\",\"level\":%u}", ledModeName(v[0]), v[1]);
+        binary.append((const char*)v, 2);
+        break;
+      case 1:
+        name = "color";
+        snprintf(json, sizeof(json), "{\"color\":[%u,%u,%u],\"color2\":[%u,%u,%u]}", v[0], v[1], v[2], v[3], v[4], v[5]);
+        binary.append((const char*)v, 6);
+        break;
+      case 2:
+        name = "brightness";
+        snprintf(json, sizeof(json), " { \"level\" : %u , \"note\" : [1, {\"x\": null}] } ", v[0]);
+        binary.append((const char*)v, 1);
+        break;
+      default: {
+        name = "effect";
+        v[0] %= NUM_EFFECT_KINDS;
+        uint16_t period = (uint16_t)(MQTT_COMMAND_MIN_PERIOD + rng() % (MQTT_COMMAND_MAX_PERIOD - MQTT_COMMAND_MIN_PERIOD + 1));
+        snprintf(json, sizeof(json), "{\"period\":%u,\"effect\":\"%s\",\"color\":[%u,%u,%u],\"color2\":[%u,%u,%u]}",
+                 period, effectName((EffectKind)v[0]), v[1], v[2], v[3], v[4], v[5], v[6]);
+        binary.append((const char*)v, 7);
+        binary += (char)(period & 0xFF);
+        binary += (char)(period >> 8);
+        break;
+      }
+    }
+    RemoteCommand fromJSON;
+    RemoteCommand fromBinary;
+    std::string topic = commandTopic(i & 1 ? "ball/all" : prefix, name);
+    TEST_ASSERT_TRUE_MESSAGE(parsesAs(topic, json, fromJSON), json);
+    TEST_ASSERT_TRUE_MESSAGE(parsesAs(topic, binary, fromBinary), topic.c_str());
+    TEST_ASSERT_TRUE_MESSAGE(sameCommand(fromJSON, fromBinary), json);
+  }
+}
+
+// 在 test_clip_mode_parses_in_both_encodings 登记片段模式之前运行：第一个片段模式此时未登记
+static void test_invalid_payloads_rejected(void) {
+  struct InvalidCase {
+    const char* name;
+    std::string payload;
+  };
+  const InvalidCase INVALID[] = {
+    {"mode", "{\"mode\":\"rainbow\"}"},
+    {"mode", "{\"mode\":\"off\",\"effect\":\"solid\"}"},
+    {"mode", std::string("\xB1", 1) + (char)NUM_LED_MODES},            // 未登记的片段模式
+    {"mode", std::string("\xB1", 1) + (char)(LED_CLIP_FIRST + CLIP_MODE_MAX)},
+    {"color", "{\"color\":[1,2]}"},
+    {"color", "{\"color\":[1,2,300]}"},
+    {"color", ""},
+    {"brightness", "{\"level\":256}"},
+    {"brightness", "{\"level\":12"},
+    {"brightness", "{\"color\":[1,2,3]}"},
+    {"effect", "{\"effect\":\"chase\",\"period\":50}"},
+    {"effect", std::string("\xB1\x03\x00\x00\x00\x00\x00\x00\x10\x00", 10)},
+    {"effect", std::string("\xB1\x03", 2)},
+  };
+  for (const InvalidCase& c : INVALID) {
+    RemoteCommand command;
+    TEST_ASSERT_FALSE_MESSAGE(parsesAs(commandTopic(mqttCommandPrefix(), c.name), c.payload, command), c.name);
+  }
+}
+
+// 登记过的片段模式：两种编码都接受且结果相同
+static void test_clip_mode_parses_in_both_encodings(void) {
+  uint8_t clipMode = 0;
+  RemoteCommand fromJSON;
+  RemoteCommand fromBinary;
+  std::string modeTopic = commandTopic(mqttCommandPrefix(), "mode");
+  TEST_ASSERT_TRUE(findLEDMode("clip:cmd", clipMode));
+  TEST_ASSERT_TRUE(parsesAs(modeTopic, "{\"mode\":\"clip:cmd\",\"level\":9}", fromJSON));
+  TEST_ASSERT_TRUE(parsesAs(modeTopic, std::string("\xB1", 1) + (char)clipMode + '\x09', fromBinary));
+  TEST_ASSERT_TRUE(sameCommand(fromJSON, fromBinary));
+  TEST_ASSERT_EQUAL_UINT8(clipMode, fromBinary.mode);
+}
+
+// ==================== 端到端 ====================
+static std::vector<std::string> commandReplies;
+
+static void observeCommandReply(const char* topic, const char* payload, uint64_t) {
+  if (!strcmp(topic, (std::string(mqttCommandPrefix()) + "/state").c_str())) {
+    commandReplies.push_back(payload);
+  }
+}
+
+// 冷启动到 MQTT 就绪，之后经模拟服务器投递命令
+static void bootForCommands() {
+  simNVSClear();
+  simReset();
+  simPowerCycle();
+  initializeSystem();
+  runUntil(30000000ULL, true);
+  commandReplies.clear();
+  simSetPublishHook(observeCommandReply);
+  runForMillis(200);
+}
+
+static void assertFirstPixel(uint8_t r, uint8_t g, uint8_t b) {
+  TEST_ASSERT_EQUAL_UINT8(r, leds[0].r);
+  TEST_ASSERT_EQUAL_UINT8(g, leds[0].g);
+  TEST_ASSERT_EQUAL_UINT8(b, leds[0].b);
+}
+
+static void test_effect_and_binary_brightness_apply(void) {
+  bootForCommands();
+  deliverCommand(commandTopic(mqttCommandPrefix(), "effect"), "{\"effect\":\"solid\",\"color\":[10,20,30]}");
+  runForMillis(50);
+  TEST_ASSERT_TRUE(ledController.remote);
+  TEST_ASSERT_EQUAL_UINT8(EFFECT_SOLID, currentEffect().kind);
+  assertFirstPixel(10, 20, 30);
+
+  deliverCommand(commandTopic("ball/all", "brightness"), std::string("\xB1\x80", 2));
+  runForMillis(50);
+  assertFirstPixel(scale8(10, 128), scale8(20, 128), scale8(30, 128));
+  TEST_ASSERT_GREATER_THAN_UINT32(0, metricHistogram(METRIC_COMMAND_APPLY).count);
+}
+
+static void test_state_command_replies(void) {
+  bootForCommands();
+  deliverCommand(commandTopic(mqttCommandPrefix(), "effect"), "{\"effect\":\"solid\",\"color\":[10,20,30]}");
+  deliverCommand(commandTopic(mqttCommandPrefix(), "state"), "");
+  runForMillis(50);
+  std::string expectedMode = std::string("\"mode\":\"") + ledModeName(ledController.mode) + "\"";
+  TEST_ASSERT_EQUAL_size_t(1, commandReplies.size());
+  TEST_ASSERT_TRUE(commandReplies[0].find(expectedMode) != std::string::npos);
+  TEST_ASSERT_TRUE(commandReplies[0].find("\"remote\":true") != std::string::npos);
+}
+
+static void test_reset_restores_rule_mode(void) {
+  bootForCommands();
+  LEDMode ruleMode = ledController.mode;
+  deliverCommand(commandTopic(mqttCommandPrefix(), "mode"), "{\"mode\":\"flash_yellow\",\"level\":255}");
+  runForMillis(50);
+  TEST_ASSERT_EQUAL_UINT8(LED_FLASH_YELLOW, ledController.mode);
+  TEST_ASSERT_EQUAL_UINT8(ledModeEffect(LED_FLASH_YELLOW).kind, currentEffect().kind);
+  deliverCommand(commandTopic(mqttCommandPrefix(), "reset"), "");
+  runForMillis(50);
+  TEST_ASSERT_FALSE(ledController.remote);
+  TEST_ASSERT_EQUAL_UINT8(ruleMode, ledController.mode);
+}
+
+static void test_button_change_hands_back_to_rules(void) {
+  bootForCommands();
+  deliverCommand(commandTopic("ball/all", "color"), "{\"color\":[1,2,3]}");
+  runForMillis(50);
+  TEST_ASSERT_TRUE(ledController.remote);
+  uint64_t at = simNowMicros() + 1000;
+  simSchedulePin(BUTTON_PINS[FAULT_BUTTON], LOW, at);
+  simSchedulePin(BUTTON_PINS[FAULT_BUTTON], HIGH, at + 300000);
+  runForMillis(600);
+  TEST_ASSERT_FALSE(ledController.remote);
+}
+
+static void test_invalid_and_foreign_topics_counted(void) {
+  bootForCommands();
+  MqttCommandStats before = mqttCommandStats();
+  deliverCommand(commandTopic(mqttCommandPrefix(), "mode"), "{\"mode\":\"rainbow\"}");
+  deliverCommand(commandTopic(mqttCommandPrefix(), "blink"), "{}");
+  char otherTopic[] = "ball/ball2/cmd/mode";
+  uint8_t otherPayload[] = "{\"mode\":\"off\"}";
+  dispatchMQTTMessage(otherTopic, otherPayload, sizeof(otherPayload) - 1);
+  MqttCommandStats after = mqttCommandStats();
+  TEST_ASSERT_EQUAL_UINT32(2, after.invalid - before.invalid);
+  TEST_ASSERT_EQUAL_UINT32(1, after.unmatched - before.unmatched);
+}
+
+static void test_full_queue_drops_and_keeps_order(void) {
+  bootForCommands();
+  deliverCommand(commandTopic(mqttCommandPrefix(), "effect"), "{\"effect\":\"solid\",\"color\":[1,2,3]}");
+  runForMillis(50);
+  MqttCommandStats before = mqttCommandStats();
+  const uint32_t burst = MQTT_COMMAND_QUEUE_SIZE + 4;
+  for (uint32_t i = 0; i < burst; i++) {
+    deliverCommand(commandTopic(mqttCommandPrefix(), "brightness"), std::string("\xB1", 1) + (char)(i + 1));
+  }
+  runForMillis(50);
+  TEST_ASSERT_EQUAL_UINT32(burst - MQTT_COMMAND_QUEUE_SIZE, mqttCommandStats().dropped - before.dropped);
+  assertFirstPixel(scale8(1, MQTT_COMMAND_QUEUE_SIZE), scale8(2, MQTT_COMMAND_QUEUE_SIZE),
+                   scale8(3, MQTT_COMMAND_QUEUE_SIZE));
+}
+
+// ball/rules：回调只复制载荷，解析、写文件和重新读取都在 MQTT 客户端作业里
+static void test_rules_topic_applies_after_callback(void) {
+  static const char RULES[] = "{\"rules\":[{\"name\":\"idle\",\"priority\":0,\"mode\":\"gradient\",\"base\":0}]}";
+  static const char RELOADED[] = "{\"rules\":[{\"name\":\"idle\",\"priority\":0,\"mode\":\"off\",\"base\":0},"
+                                 "{\"name\":\"any\",\"priority\":1,\"mode\":\"gradient\",\"any\":[13]}]}";
+  bootForCommands();
+  deliverCommand(MQTT_TOPIC_RULES, RULES);
+  TEST_ASSERT_TRUE(activeRules().ruleCount != 1);
+  TEST_ASSERT_FALSE(rulesPending());
+  runForMillis(50);
+  char file[RULES_JSON_CAPACITY];
+  int32_t fileLength = halFileRead(RULES_FILE_PATH, file, sizeof(file));
+  TEST_ASSERT_EQUAL_INT32(sizeof(RULES) - 1, fileLength);
+  TEST_ASSERT_EQUAL_MEMORY(RULES, file, sizeof(RULES) - 1);
+  TEST_ASSERT_EQUAL_UINT8(1, activeRules().ruleCount);
+
+  simWriteFile(RULES_FILE_PATH, RELOADED);
+  deliverCommand(MQTT_TOPIC_RULES, "");
+  runForMillis(50);
+  TEST_ASSERT_EQUAL_UINT8(2, activeRules().ruleCount);
+  TEST_ASSERT_EQUAL_UINT32(0, simCounters().fileOpsInMQTTCallback);
+}
+
+// ==================== 分发 ====================
+// 回调收到的是客户端接收缓冲区：前缀树匹配、就地解析、入队，全程不分配
+static void test_dispatch_does_not_allocate(void) {
+  std::string topic = commandTopic(mqttCommandPrefix(), "effect");
+  std::vector<char> topicBuffer(topic.begin(), topic.end());
+  topicBuffer.push_back('\0');
+  uint8_t payload[] = "{\"effect\":\"chase\",\"color\":[255,200,0],\"color2\":[0,0,0],\"period\":1500}";
+  RemoteCommand command;
+  while (takeRemoteCommand(command)) {
+  }
+  uint32_t applied = 0;
+  uint64_t allocations = heapAllocationCount();
+  for (uint32_t i = 0; i < COMMAND_TEST_ITERATIONS; i++) {
+    dispatchMQTTMessage(topicBuffer.data(), payload, sizeof(payload) - 1);
+    applied += takeRemoteCommand(command);
+  }
+  TEST_ASSERT_TRUE(heapAllocationCount() == allocations);
+  TEST_ASSERT_EQUAL_UINT32(COMMAND_TEST_ITERATIONS, applied);
+}
+
+int main(int argc, char** argv) {
+  (void)argc;
+  (void)argv;
+  UNITY_BEGIN();
+  RUN_TEST(test_trie_prefers_literal_then_plus_then_hash);
+  RUN_TEST(test_trie_agrees_with_filter_matching);
+  RUN_TEST(test_json_and_binary_parse_alike);
+  RUN_TEST(test_invalid_payloads_rejected);
+  RUN_TEST(test_clip_mode_parses_in_both_encodings);
+  RUN_TEST(test_effect_and_binary_brightness_apply);
+  RUN_TEST(test_state_command_replies);
+  RUN_TEST(test_reset_restores_rule_mode);
+  RUN_TEST(test_button_change_hands_back_to_rules);
+  RUN_TEST(test_invalid_and_foreign_topics_counted);
+  RUN_TEST(test_full_queue_drops_and_keeps_order);
+  RUN_TEST(test_rules_topic_applies_after_callback);
+  RUN_TEST(test_dispatch_does_not_allocate);
+  return UNITY_END();
+}
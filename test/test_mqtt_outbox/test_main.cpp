@@ -0,0 +1,48 @@
+// ==================== MQTT 待发缓冲区 ====================
+// 服务器中断期间事件留在缓冲区、恢复后按顺序重放；断线时软件复位后保留内存中的事件重放，掉电后清空。
+// 每个用例从掉电冷启动开始
+#include <unity.h>
+#include "ball.h"
+#include "mqtt_outbox.h"
+#include "sim_scenarios.h"
+
+void setUp(void) {
+  runBrokerOutage();
+}
+
+void tearDown(void) {
+}
+
+static void test_outage_replays_in_order(void) {
+  const OutboxStats& o = mqttOutboxStats();
+  TEST_ASSERT_EQUAL_UINT32(0, publishLog().outOfOrder);
+  TEST_ASSERT_EQUAL_UINT32(0, o.depth);
+  // 缓冲区没满时每个事件都发布了（合并的计入 n）
+  if (o.dropped == 0) {
+    TEST_ASSERT_EQUAL_UINT32(o.enqueued, publishLog().events);
+  }
+}
+
+static void test_soft_reset_restores_pending_events(void) {
+  uint16_t pending = runSoftResetWhileOffline();
+  TEST_ASSERT_GREATER_THAN_UINT32(0, pending);
+  TEST_ASSERT_EQUAL_UINT32(pending, mqttOutboxStats().restored);
+  TEST_ASSERT_GREATER_OR_EQUAL_UINT32(pending, mqttOutboxStats().published);
+  TEST_ASSERT_EQUAL_UINT32(0, publishLog().outOfOrder);
+}
+
+// 保留内存内容随机，校验失败后清空
+static void test_power_cycle_discards_retained_events(void) {
+  runPowerCycleWhileOffline();
+  TEST_ASSERT_EQUAL_UINT32(0, mqttOutboxStats().restored);
+}
+
+int main(int argc, char** argv) {
+  (void)argc;
+  (void)argv;
+  UNITY_BEGIN();
+  RUN_TEST(test_outage_replays_in_order);
+  RUN_TEST(test_soft_reset_restores_pending_events);
+  RUN_TEST(test_power_cycle_discards_retained_events);
+  return UNITY_END();
+}
@@ -0,0 +1,261 @@
+// ==================== 固件更新 ====================
+// 摘要与签名的已知答案；签名清单的各种拒绝路径都不切换启动分区；流水线上传在延时后重启一次，
+// 比上传回调里同步写 flash 快
+#include <unity.h>
+#include <string.h>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include "ball.h"
+#include "ota.h"
+#include "sha256.h"
+#include "ed25519.h"
+#include "sim_scenarios.h"
+
+// 测试密钥对：设备只拿到公钥
+static uint8_t seed[ED25519_SEED_SIZE];
+static uint8_t otherSeed[ED25519_SEED_SIZE];
+static uint8_t publicKey[ED25519_PUBLIC_KEY_SIZE];
+static std::vector<uint8_t> image;
+static std::vector<uint8_t> small;
+static std::vector<uint8_t> smallFile;
+static std::mt19937 rng(25);
+
+static void makeKeys() {
+  if (!image.empty()) {
+    return;
+  }
+  for (size_t i = 0; i < ED25519_SEED_SIZE; i++) {
+    seed[i] = (uint8_t)rng();
+    otherSeed[i] = (uint8_t)rng();
+  }
+  ed25519PublicKey(publicKey, seed);
+  image = randomFirmware(rng, 256 * 1024);
+  small = randomFirmware(rng, OTA_TEST_FAILURE_IMAGE);
+  smallFile = buildOTAFile(small, seed);
+}
+
+void setUp(void) {
+  makeKeys();
+  otaSetPublicKey(publicKey);
+  startOTASystem();
+}
+
+void tearDown(void) {
+  simStopTasks();
+  simInjectOTAFault(SIM_OTA_FAULT_NONE, 0);
+  simSetOTATiming(SimOTATiming{0, 0});
+  simSetRealTime(false);
+  otaSetPublicKey(publicKey);
+}
+
+static void test_sha256_known_answers(void) {
+  uint8_t digest[SHA256_DIGEST_SIZE];
+  Sha256 sha;
+  sha.update((const uint8_t*)"abc", 3);
+  sha.finish(digest);
+  std::string hex = hexText(digest, sizeof(digest));
+  TEST_ASSERT_EQUAL_STRING("ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad", hex.c_str());
+  const char* twoBlocks = "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq";
+  sha.reset();
+  for (const char* p = twoBlocks; *p; p++) {
+    sha.update((const uint8_t*)p, 1);  // 逐字节累加与一次给出相同
+  }
+  sha.finish(digest);
+  hex = hexText(digest, sizeof(digest));
+  TEST_ASSERT_EQUAL_STRING("248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1", hex.c_str());
+}
+
+static void test_sha512_known_answer(void) {
+  uint8_t digest[SHA512_DIGEST_SIZE];
+  Sha512 sha;
+  sha.update((const uint8_t*)"abc", 3);
+  sha.finish(digest);
+  std::string hex = hexText(digest, sizeof(digest));
+  TEST_ASSERT_EQUAL_STRING("ddaf35a193617abacc417349ae20413112e6fa4e89a97ea20a9eeee64b55d39a"
+                           "2192992a274fc1a836ba3c23a3feebbd454d4423643ce80e2a9ac94fa54ca49f",
+                           hex.c_str());
+}
+
+// RFC 8032 测试 1（空消息）
+static void test_ed25519_known_answer(void) {
+  uint8_t key[ED25519_SEED_SIZE];
+  uint8_t pub[ED25519_PUBLIC_KEY_SIZE];
+  uint8_t signature[ED25519_SIGNATURE_SIZE];
+  TEST_ASSERT_TRUE(parseHex("9d61b19deffd5a60ba844af492ec2cc44449c5697b326919703bac031cae7f60", key, sizeof(key)));
+  ed25519PublicKey(pub, key);
+  std::string hex = hexText(pub, sizeof(pub));
+  TEST_ASSERT_EQUAL_STRING("d75a980182b10ab7d54bfed3c964073a0ee172f3daa62325af021a68f707511a", hex.c_str());
+  ed25519Sign(signature, nullptr, 0, key);
+  hex = hexText(signature, sizeof(signature));
+  TEST_ASSERT_EQUAL_STRING("e5564300c360ac729086e2cc806e828a84877f1eb8e5d974d873e065224901555"
+                           "fb8821590a33bacc61e39701cf9b46bd25bf5f0595bbe24655141438e7a100b",
+                           hex.c_str());
+  TEST_ASSERT_TRUE(ed25519Verify(signature, nullptr, 0, pub));
+  signature[63] ^= 0x01;
+  TEST_ASSERT_FALSE(ed25519Verify(signature, nullptr, 0, pub));
+}
+
+static void test_signed_manifest_verifies(void) {
+  const OtaManifest* manifest = (const OtaManifest*)smallFile.data();
+  TEST_ASSERT_TRUE(ed25519Verify(manifest->signature, smallFile.data(), OTA_MANIFEST_SIGNED_BYTES, publicKey));
+}
+
+// 上传以 error 失败：启动分区不变、不重启，已打开 flash 的路径放弃 Update，网络任务广播 "failed"
+static void assertOTAFailure(const char* error, bool abortsFlash, const std::vector<uint8_t>& file, size_t length,
+                             OtaUploadEnd end, SimOTAFault fault) {
+  startTasks();
+  const SimCounters& counters = simCounters();
+  uint32_t aborts = counters.otaAborts;
+  simInjectOTAFault(fault, 16 * 1024);
+  uploadOTA(file, length, end);
+  TEST_ASSERT_TRUE_MESSAGE(waitForOTA(5000), "写入任务没有结束");
+  OtaStatus status = otaStatus();
+  TEST_ASSERT_EQUAL_UINT8(OTA_FAILED, status.state);
+  TEST_ASSERT_NOT_NULL(status.error);
+  TEST_ASSERT_EQUAL_STRING(error, status.error);
+  TEST_ASSERT_EQUAL_UINT32(1, status.failures);
+  size_t booted = 0;
+  TEST_ASSERT_NULL(simOTAImage(booted));
+  TEST_ASSERT_EQUAL_UINT32(0, counters.otaBootSwitches);
+  TEST_ASSERT_EQUAL_UINT32(0, counters.restarts);
+  TEST_ASSERT_EQUAL_UINT32(abortsFlash ? aborts + 1 : aborts, counters.otaAborts);
+  for (uint32_t waited = 0; countOTAFrames("failed") == 0 && waited < 200; waited++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  TEST_ASSERT_EQUAL_UINT32(1, countOTAFrames("failed"));
+}
+
+static void test_unsigned_image_rejected(void) {
+  assertOTAFailure("not a signed firmware file", false, small, small.size(), OTA_UPLOAD_COMPLETE,
+                   SIM_OTA_FAULT_NONE);
+}
+
+static void test_missing_public_key_rejects_updates(void) {
+  otaSetPublicKey(nullptr);
+  assertOTAFailure("no signing key provisioned", false, smallFile, smallFile.size(), OTA_UPLOAD_COMPLETE,
+                   SIM_OTA_FAULT_NONE);
+}
+
+static void test_wrong_key_rejected(void) {
+  std::vector<uint8_t> wrongKey = buildOTAFile(small, otherSeed);
+  assertOTAFailure("bad manifest signature", false, wrongKey, wrongKey.size(), OTA_UPLOAD_COMPLETE,
+                   SIM_OTA_FAULT_NONE);
+}
+
+static void test_forged_manifest_rejected(void) {
+  std::vector<uint8_t> forged = smallFile;
+  ((OtaManifest*)forged.data())->imageSize += 1;  // 改动已签名的字段
+  assertOTAFailure("bad manifest signature", false, forged, forged.size(), OTA_UPLOAD_COMPLETE, SIM_OTA_FAULT_NONE);
+}
+
+static void test_tampered_image_fails_digest(void) {
+  std::vector<uint8_t> tampered = smallFile;
+  tampered[sizeof(OtaManifest) + 1000] ^= 0x01;
+  assertOTAFailure("SHA-256 mismatch", true, tampered, tampered.size(), OTA_UPLOAD_COMPLETE, SIM_OTA_FAULT_NONE);
+}
+
+static void test_flash_write_failure(void) {
+  assertOTAFailure("Flash Write Failed", false, smallFile, smallFile.size(), OTA_UPLOAD_COMPLETE,
+                   SIM_OTA_FAULT_WRITE);
+}
+
+static void test_activation_failure(void) {
+  assertOTAFailure("Could Not Activate The Firmware", false, smallFile, smallFile.size(), OTA_UPLOAD_COMPLETE,
+                   SIM_OTA_FAULT_END);
+}
+
+static void test_disconnect_mid_upload(void) {
+  assertOTAFailure("connection closed", true, smallFile, smallFile.size() / 2, OTA_UPLOAD_DISCONNECT,
+                   SIM_OTA_FAULT_NONE);
+}
+
+static void test_truncated_request(void) {
+  assertOTAFailure("upload truncated", true, smallFile, smallFile.size() - 10, OTA_UPLOAD_TRUNCATED,
+                   SIM_OTA_FAULT_NONE);
+}
+
+static void test_image_longer_than_manifest(void) {
+  std::vector<uint8_t> longer = smallFile;
+  longer.insert(longer.end(), 100, 0);
+  assertOTAFailure("image longer than manifest", true, longer, longer.size(), OTA_UPLOAD_COMPLETE,
+                   SIM_OTA_FAULT_NONE);
+}
+
+// 一次擦除超过 OTA_STALL_TIMEOUT：上传回调阻塞在信号上，到上限就失败，不拖到任务看门狗
+static void test_stuck_flash_times_out(void) {
+  simSetOTATiming(SimOTATiming{OTA_STALL_TIMEOUT * 1500UL, 0});
+  assertOTAFailure("flash write timeout", true, smallFile, smallFile.size(), OTA_UPLOAD_COMPLETE,
+                   SIM_OTA_FAULT_NONE);
+  TEST_ASSERT_TRUE(longestOTAReceiveMicros() <= OTA_STALL_TIMEOUT * 1000ULL + 50000);
+}
+
+static void test_pipelined_update_reboots_once(void) {
+  std::vector<uint8_t> nextFile = buildOTAFile(image, seed);
+  startTasks();
+  OtaPipelineRun run = runPipelinedUpload(nextFile);
+  TEST_ASSERT_TRUE_MESSAGE(run.accepted, "上传没有被接受（HTTP 202）");
+  TEST_ASSERT_TRUE_MESSAGE(run.rejectedSecond, "更新进行中接受了第二个上传");
+  TEST_ASSERT_TRUE(run.finished);
+  TEST_ASSERT_EQUAL_UINT8(OTA_REBOOTING, run.status.state);
+  TEST_ASSERT_EQUAL_UINT32(image.size(), run.status.written);
+  TEST_ASSERT_FALSE_MESSAGE(otaBegin("third.ota"), "等待重启期间接受了新的上传");
+  std::this_thread::sleep_for(std::chrono::milliseconds(OTA_REBOOT_DELAY + 200));
+  simStopTasks();
+
+  size_t length = 0;
+  const uint8_t* booted = simOTAImage(length);
+  TEST_ASSERT_NOT_NULL(booted);
+  TEST_ASSERT_EQUAL_size_t(image.size(), length);
+  TEST_ASSERT_EQUAL_MEMORY(image.data(), booted, length);
+  const SimCounters& counters = simCounters();
+  TEST_ASSERT_EQUAL_UINT32(1, counters.restarts);
+  TEST_ASSERT_TRUE_MESSAGE(run.doneNanos < 1000000, "otaReceiveDone() 阻塞了请求");
+  TEST_ASSERT_TRUE(counters.lastRestartMicros >= run.receivedAtMicros + OTA_REBOOT_DELAY * 1000ULL);
+  TEST_ASSERT_GREATER_OR_EQUAL_UINT32(2, run.progressFrames);
+  TEST_ASSERT_EQUAL_UINT32(1, countOTAFrames("rebooting"));
+}
+
+// 对照：写入任务启动前由上传回调直接写 flash
+static void test_pipeline_faster_than_synchronous_write(void) {
+  uint64_t t0 = simNowMicros();
+  TEST_ASSERT_TRUE(uploadSynchronously(image));
+  uint64_t syncMicros = simNowMicros() - t0;
+  size_t length = 0;
+  const uint8_t* booted = simOTAImage(length);
+  TEST_ASSERT_NOT_NULL(booted);
+  TEST_ASSERT_EQUAL_size_t(image.size(), length);
+
+  std::vector<uint8_t> next = randomFirmware(rng, image.size());
+  startTasks();
+  OtaPipelineRun run = runPipelinedUpload(buildOTAFile(next, seed));
+  TEST_ASSERT_TRUE(run.accepted && run.finished);
+  TEST_ASSERT_EQUAL_UINT8(OTA_REBOOTING, run.status.state);
+  // 同样大小的镜像，速率之比就是用时的反比：快 30% 以上
+  TEST_ASSERT_TRUE_MESSAGE(run.micros * 13 < syncMicros * 10, "流水线没有比同步写入快 30%");
+}
+
+int main(int argc, char** argv) {
+  (void)argc;
+  (void)argv;
+  UNITY_BEGIN();
+  RUN_TEST(test_sha256_known_answers);
+  RUN_TEST(test_sha512_known_answer);
+  RUN_TEST(test_ed25519_known_answer);
+  RUN_TEST(test_signed_manifest_verifies);
+  RUN_TEST(test_unsigned_image_rejected);
+  RUN_TEST(test_missing_public_key_rejects_updates);
+  RUN_TEST(test_wrong_key_rejected);
+  RUN_TEST(test_forged_manifest_rejected);
+  RUN_TEST(test_tampered_image_fails_digest);
+  RUN_TEST(test_flash_write_failure);
+  RUN_TEST(test_activation_failure);
+  RUN_TEST(test_disconnect_mid_upload);
+  RUN_TEST(test_truncated_request);
+  RUN_TEST(test_image_longer_than_manifest);
+  RUN_TEST(test_stuck_flash_times_out);
+  RUN_TEST(test_pipelined_update_reboots_once);
+  RUN_TEST(test_pipeline_faster_than_synchronous_write);
+  return UNITY_END();
+}
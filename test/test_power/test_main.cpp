@@ -0,0 +1,130 @@
+// ==================== 低功耗空闲 ====================
+// 睡眠决策表；已连接时同一段按键在关闭/开启省电时的唤醒次数、帧率和 MQTT 发布；
+// AP 不可用时的浅睡眠、唤醒到渲染的延迟，以及 AP 恢复后的重连
+#include <unity.h>
+#include <stdio.h>
+#include <algorithm>
+#include "ball.h"
+#include "power.h"
+#include "metrics.h"
+#include "sim_scenarios.h"
+
+#define POWER_TEST_SECONDS 30
+
+struct PowerCase {
+  const char* name;
+  PowerInputs in;
+  uint8_t blocker;
+  uint32_t sleepMicros;
+};
+
+// 第一行所有条件都允许睡眠，之后每行只改变一个条件
+static const PowerCase POWER_CASES[] = {
+  {"可以睡眠", {true, true, false, false, false, false, false, 40000, 90000}, POWER_SLEEP, 40000 - POWER_WAKE_MARGIN_US},
+  {"未开启", {false, true, false, false, false, false, false, 40000, 90000}, POWER_BLOCK_DISABLED, 0},
+  {"尚未空闲", {true, false, false, false, false, false, false, 40000, 90000}, POWER_BLOCK_ACTIVE, 0},
+  {"按钮未稳定", {true, true, true, false, false, false, false, 40000, 90000}, POWER_BLOCK_INPUT, 0},
+  {"灯带在发送", {true, true, false, true, false, false, false, 40000, 90000}, POWER_BLOCK_LED, 0},
+  {"网络有待发工作", {true, true, false, false, true, false, false, 40000, 90000}, POWER_BLOCK_NETWORK, 0},
+  {"WiFi 已连接", {true, true, false, false, false, true, false, 40000, 90000}, POWER_BLOCK_LINK, 0},
+  {"有 WebSocket 客户端", {true, true, false, false, false, false, true, 40000, 90000}, POWER_BLOCK_VIEWERS, 0},
+  {"网络截止时间更早", {true, true, false, false, false, false, false, 40000, 3000}, POWER_SLEEP, 3000 - POWER_WAKE_MARGIN_US},
+  {"离截止时间太近", {true, true, false, false, false, false, false, 40000, POWER_MIN_SLEEP_US - 1}, POWER_BLOCK_SHORT, 0},
+  {"超过最长睡眠", {true, true, false, false, false, false, false, 5000000, 5000000}, POWER_SLEEP,
+   POWER_MAX_SLEEP * 1000UL - POWER_WAKE_MARGIN_US},
+};
+
+static PowerScenario off;
+static PowerScenario on;
+static PowerScenario outage;
+static PowerStats onStats;
+static PowerStats outageStats;
+static Histogram outageWake;
+static bool ran = false;
+
+// 三段场景依次运行一次；各段的统计在该段结束时读取
+static void runScenarios() {
+  if (ran) return;
+  runPowerScenario(false, false, POWER_TEST_SECONDS, off);
+  runPowerScenario(true, false, POWER_TEST_SECONDS, on);
+  onStats = powerStats();
+  runPowerScenario(true, true, POWER_TEST_SECONDS, outage);
+  outageStats = powerStats();
+  outageWake = metricHistogram(METRIC_WAKE_TO_FRAME);
+  ran = true;
+}
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+static void test_sleep_decisions(void) {
+  for (const PowerCase& c : POWER_CASES) {
+    PowerDecision d = decidePowerSleep(c.in);
+    TEST_ASSERT_EQUAL_UINT8_MESSAGE(c.blocker, d.blocker, c.name);
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(c.sleepMicros, d.sleepMicros, c.name);
+  }
+}
+
+// 已连接：不浅睡眠（射频关闭会漏掉信标被 AP 断开），靠 modem sleep 和降低帧率省电
+static void test_connected_stays_awake_with_modem_sleep(void) {
+  runScenarios();
+  TEST_ASSERT_EQUAL_UINT32(0, on.sleepsAssociated);
+  TEST_ASSERT_TRUE(on.idle.sleptMicros == 0);
+  TEST_ASSERT_TRUE(on.modemSleepIdle);
+  TEST_ASSERT_FALSE(off.modemSleepIdle);
+  TEST_ASSERT_GREATER_THAN_UINT32(0, onStats.decisions[POWER_BLOCK_LINK]);
+  TEST_ASSERT_EQUAL_UINT32(0, onStats.decisions[POWER_SLEEP]);
+  TEST_ASSERT_TRUE(on.idle.wakes < off.idle.wakes);
+  TEST_ASSERT_TRUE(on.idle.frames * 1e6 / on.idle.micros <= 1000.0 / POWER_IDLE_FRAME_INTERVAL + 1);
+  TEST_ASSERT_TRUE(off.idle.sleptMicros == 0);
+}
+
+static void test_power_save_keeps_behaviour(void) {
+  runScenarios();
+  TEST_ASSERT_FALSE(off.topics.empty());
+  TEST_ASSERT_EQUAL_size_t(off.topics.size(), on.topics.size());
+  TEST_ASSERT_TRUE(on.topics == off.topics);
+  TEST_ASSERT_EQUAL_UINT8(off.finalMode, on.finalMode);
+  TEST_ASSERT_EQUAL_UINT32(0, on.wifiDrops);
+}
+
+// AP 不可用：连接尝试（最长 WIFI_CONNECT_TIMEOUT）期间保持清醒，退避等待期间浅睡眠，按键唤醒后及时渲染
+static void test_disconnected_sleeps_and_buttons_wake(void) {
+  runScenarios();
+  TEST_ASSERT_TRUE(outage.idle.sleptMicros * 3 > outage.idle.micros);
+  TEST_ASSERT_TRUE(outage.idle.wakes * 2 < off.idle.wakes);
+  TEST_ASSERT_GREATER_THAN_UINT32(0, outageStats.wakes[POWER_WAKE_BUTTON]);
+  TEST_ASSERT_GREATER_OR_EQUAL_UINT32(2, outageStats.idleEntries);
+  TEST_ASSERT_GREATER_THAN_UINT32(0, outageWake.count);
+  TEST_ASSERT_LESS_OR_EQUAL_UINT32(POWER_WAKE_MARGIN_US + 1000, outageWake.max);
+}
+
+// AP 恢复后重连（连接期间和连上后都不浅睡眠），断线期间的按键结果与一直在线时相同
+static void test_recovers_after_ap_outage(void) {
+  runScenarios();
+  TEST_ASSERT_TRUE(outage.reconnected);
+  TEST_ASSERT_EQUAL_UINT32(0, outage.sleepsConnecting);
+  TEST_ASSERT_EQUAL_UINT32(0, outage.sleepsAssociated);
+  TEST_ASSERT_EQUAL_UINT8(off.finalMode, outage.finalMode);
+  // 断线期间同一主题的连续事件在待发缓冲区里合并，只比较补发的主题和最后一条
+  TEST_ASSERT_FALSE(outage.topics.empty());
+  for (const std::string& topic : outage.topics) {
+    TEST_ASSERT_TRUE(std::find(off.topics.begin(), off.topics.end(), topic) != off.topics.end());
+  }
+  TEST_ASSERT_TRUE(outage.topics.back() == off.topics.back());
+}
+
+int main(int argc, char** argv) {
+  (void)argc;
+  (void)argv;
+  UNITY_BEGIN();
+  RUN_TEST(test_sleep_decisions);
+  RUN_TEST(test_connected_stays_awake_with_modem_sleep);
+  RUN_TEST(test_power_save_keeps_behaviour);
+  RUN_TEST(test_disconnected_sleeps_and_buttons_wake);
+  RUN_TEST(test_recovers_after_ap_outage);
+  return UNITY_END();
+}
@@ -0,0 +1,45 @@
+// ==================== 并发任务 ====================
+// 渲染、网络任务各占一个线程，另一个线程随机翻转按钮引脚，测试线程作为额外的快照读者：
+// 每次读到的快照自洽，投递到 MQTT 待发队列的消息全部发布、合并或计入丢弃
+#include <unity.h>
+#include "ball.h"
+#include "tasks.h"
+#include "mqtt_outbox.h"
+#include "hal_sim.h"
+#include "sim_scenarios.h"
+
+#define STRESS_SECONDS 2
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+static void checkStress(bool wireTiming) {
+  StressRun run = runStressTasks(STRESS_SECONDS, wireTiming);
+  const TaskStats& stats = taskStats();
+  const OutboxStats& outbox = mqttOutboxStats();
+  TEST_ASSERT_TRUE(run.reads > 0);
+  TEST_ASSERT_TRUE_MESSAGE(run.violations == 0, "读到不一致的快照");
+  TEST_ASSERT_EQUAL_UINT32(stats.messagesPosted, outbox.enqueued);
+  TEST_ASSERT_EQUAL_UINT32(outbox.enqueued, outbox.published + outbox.coalesced + outbox.dropped);
+  TEST_ASSERT_EQUAL_UINT32(simCounters().mqttPublishes, outbox.published);
+}
+
+static void test_snapshots_consistent_with_wire_timing(void) {
+  checkStress(true);
+}
+
+static void test_snapshots_consistent_without_wire_timing(void) {
+  checkStress(false);
+}
+
+int main(int argc, char** argv) {
+  (void)argc;
+  (void)argv;
+  UNITY_BEGIN();
+  RUN_TEST(test_snapshots_consistent_with_wire_timing);
+  RUN_TEST(test_snapshots_consistent_without_wire_timing);
+  return UNITY_END();
+}
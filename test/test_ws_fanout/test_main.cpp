@@ -0,0 +1,79 @@
+// ==================== WebSocket 扇出 ====================
+// 32 个不同带宽的客户端：跟得上的不丢帧；突发时落后的丢日志、状态帧被覆盖，之后追上；
+// 长期跟不上的在 WS_CLIENT_EVICT_MS 后被断开；每个广播帧只分配一次共享缓冲，全部断开后没有泄漏
+#include <unity.h>
+#include <stdio.h>
+#include "ball.h"
+#include "ws_fanout.h"
+#include "sim_scenarios.h"
+
+static WsLoadRun run;
+static bool ran = false;
+static bool supported = false;
+
+static const WsLoadRun& loaded() {
+  if (!ran) {
+    supported = runWebSocketLoad(WS_LOAD_MIN_SECONDS, run);
+    ran = true;
+  }
+  if (!supported) {
+    TEST_IGNORE_MESSAGE("WS_MAX_CLIENTS 小于 32（[env:native] 的 build_flags 已设置）");
+  }
+  return run;
+}
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+static void test_groups_behave_as_expected(void) {
+  const WsLoadRun& r = loaded();
+  for (uint8_t g = 0; g < WS_LOAD_GROUP_COUNT; g++) {
+    const WsLoadGroup& group = WS_LOAD_GROUPS[g];
+    const WsLoadGroupResult& result = r.groups[g];
+    char message[64];
+    snprintf(message, sizeof(message), "客户端组 %s", group.name);
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(group.expect == WS_EVICTED ? group.clients : 0u, result.evicted, message);
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32_MESSAGE(WS_CLIENT_QUEUE_CAP, result.maxDepth, message);
+    if (group.expect == WS_KEEPS_UP) {
+      TEST_ASSERT_EQUAL_UINT32_MESSAGE(0, result.dropped, message);
+      TEST_ASSERT_EQUAL_UINT32_MESSAGE(0, result.replaced, message);
+    }
+    if (group.expect == WS_CATCHES_UP) {
+      TEST_ASSERT_GREATER_THAN_UINT32_MESSAGE(0, result.dropped, message);
+      TEST_ASSERT_GREATER_THAN_UINT32_MESSAGE(0, result.replaced, message);
+    }
+  }
+}
+
+static void test_connected_clients_end_on_latest_state(void) {
+  const WsLoadRun& r = loaded();
+  for (uint8_t g = 0; g < WS_LOAD_GROUP_COUNT; g++) {
+    TEST_ASSERT_TRUE_MESSAGE(r.groups[g].latestState, WS_LOAD_GROUPS[g].name);
+  }
+}
+
+static void test_one_shared_buffer_per_broadcast(void) {
+  const WsLoadRun& r = loaded();
+  TEST_ASSERT_EQUAL_UINT32(r.stats.broadcasts, r.buffers);
+  TEST_ASSERT_EQUAL_UINT32(0, r.stats.allocFailures);
+}
+
+static void test_no_buffers_leak_after_disconnect(void) {
+  const WsLoadRun& r = loaded();
+  TEST_ASSERT_EQUAL_UINT32(0, r.buffersLive);
+  TEST_ASSERT_EQUAL_UINT8(0, r.clientsLeft);
+}
+
+int main(int argc, char** argv) {
+  (void)argc;
+  (void)argv;
+  UNITY_BEGIN();
+  RUN_TEST(test_groups_behave_as_expected);
+  RUN_TEST(test_connected_clients_end_on_latest_state);
+  RUN_TEST(test_one_shared_buffer_per_broadcast);
+  RUN_TEST(test_no_buffers_leak_after_disconnect);
+  return UNITY_END();
+}
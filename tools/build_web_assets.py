@@ -0,0 +1,76 @@
+# ==================== Web UI 构建脚本 ====================
+# 把 web/index.html 压缩（去缩进、空行和注释）后 gzip，生成 include/web_ui.h：
+#   WEB_UI_GZ[]      PROGMEM 字节数组，直接作为 Content-Encoding: gzip 的响应体
+#   WEB_UI_GZ_LEN    长度
+#   WEB_UI_ETAG      内容哈希（强 ETag），页面不变时浏览器得到 304
+# 作为 PlatformIO 的 pre 脚本在每次构建前运行；输入未变化时不改写输出，避免无谓的重新编译。
+# 也可以单独运行：python3 tools/build_web_assets.py
+import gzip
+import hashlib
+import os
+import re
+
+try:
+    Import("env")  # noqa: F821  PlatformIO 注入
+    PROJECT_DIR = env["PROJECT_DIR"]  # noqa: F821
+except NameError:
+    PROJECT_DIR = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+SOURCE = os.path.join(PROJECT_DIR, "web", "index.html")
+OUTPUT = os.path.join(PROJECT_DIR, "include", "web_ui.h")
+
+
+def minify(html):
+    html = re.sub(r"<!--.*?-->", "", html, flags=re.S)
+    lines = []
+    for line in html.splitlines():
+        line = line.strip()
+        # 只去掉整行的 // 注释，行内的 // 可能出现在字符串或 URL 中
+        if not line or line.startswith("//"):
+            continue
+        lines.append(line)
+    return "\n".join(lines)
+
+
+def render_header(data, etag):
+    rows = []
+    for i in range(0, len(data), 16):
+        rows.append("  " + ", ".join("0x%02x" % b for b in data[i:i + 16]) + ",")
+    return (
+        "#ifndef WEB_UI_H\n"
+        "#define WEB_UI_H\n"
+        "\n"
+        "// 由 tools/build_web_assets.py 从 web/index.html 生成，请勿手工修改\n"
+        "\n"
+        "#include <stdint.h>\n"
+        "#include <stddef.h>\n"
+        "\n"
+        "#define WEB_UI_ETAG \"\\\"%s\\\"\"\n"
+        "\n"
+        "static const size_t WEB_UI_GZ_LEN = %d;\n"
+        "static const uint8_t WEB_UI_GZ[] PROGMEM = {\n"
+        "%s\n"
+        "};\n"
+        "\n"
+        "#endif // WEB_UI_H\n"
+    ) % (etag, len(data), "\n".join(rows))
+
+
+def build():
+    with open(SOURCE, encoding="utf-8") as f:
+        html = minify(f.read())
+    # mtime=0 使输出只取决于内容，ETag 才能在相同输入下保持不变
+    data = gzip.compress(html.encode("utf-8"), compresslevel=9, mtime=0)
+    etag = hashlib.sha256(data).hexdigest()[:16]
+    header = render_header(data, etag)
+
+    if os.path.exists(OUTPUT):
+        with open(OUTPUT, encoding="utf-8") as f:
+            if f.read() == header:
+                return
+    with open(OUTPUT, "w", encoding="utf-8") as f:
+        f.write(header)
+    print("web_ui.h: %d 字节 -> %d 字节 gzip, ETag %s" % (len(html.encode("utf-8")), len(data), etag))
+
+
+build()